@@ -0,0 +1,304 @@
+/****************************************************************************
+ * examples/chksum/chksum_main.c
+ *
+ *   Copyright (C) 2012 Gregory Nutt. All rights reserved.
+ *   Author: Gregory Nutt <gnutt@nuttx.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name NuttX nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <arpa/inet.h>
+#include <net/uip/uip-arch.h>
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* The number of random buffers that are checked against the reference
+ * implementation and the number of times that each checksum function is
+ * timed over one full-sized TCP segment.
+ */
+
+#ifndef CONFIG_EXAMPLES_CHKSUM_NTESTS
+#  define CONFIG_EXAMPLES_CHKSUM_NTESTS 2000
+#endif
+
+#ifndef CONFIG_EXAMPLES_CHKSUM_NLOOPS
+#  define CONFIG_EXAMPLES_CHKSUM_NLOOPS 20000
+#endif
+
+#define MAX_TESTLEN   1514
+#define BENCH_LEN     1460
+#define BUFFER_SIZE   (MAX_TESTLEN + 8)
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static uint32_t g_src[BUFFER_SIZE / 4];
+static uint32_t g_dest[BUFFER_SIZE / 4];
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/* This is the original, byte-at-a-time uIP checksum algorithm.  It is the
+ * reference that the optimized versions are checked against.
+ */
+
+static uint16_t ref_chksum(uint16_t sum, const uint8_t *data, uint16_t len)
+{
+  const uint8_t *dataptr;
+  const uint8_t *last_byte;
+  uint16_t t;
+
+  if (len == 0)
+    {
+      return sum;
+    }
+
+  dataptr   = data;
+  last_byte = data + len - 1;
+
+  while (dataptr < last_byte)
+    {
+      t = (dataptr[0] << 8) + dataptr[1];
+      sum += t;
+      if (sum < t)
+        {
+          sum++;
+        }
+
+      dataptr += 2;
+    }
+
+  if (dataptr == last_byte)
+    {
+      t = (dataptr[0] << 8) + 0;
+      sum += t;
+      if (sum < t)
+        {
+          sum++;
+        }
+    }
+
+  return sum;
+}
+
+static uint32_t elapsed_usec(FAR const struct timespec *start)
+{
+  struct timespec end;
+
+  (void)clock_gettime(CLOCK_REALTIME, &end);
+  return (uint32_t)(end.tv_sec - start->tv_sec) * 1000000 +
+         (end.tv_nsec - start->tv_nsec) / 1000;
+}
+
+static void fill_buffer(FAR uint8_t *buffer, int len, int pattern)
+{
+  int i;
+
+  /* All ones and all zeros exercise the 0x0000/0xffff corner cases of one's
+   * complement arithmetic.
+   */
+
+  for (i = 0; i < len; i++)
+    {
+      switch (pattern)
+        {
+          case 0:
+            buffer[i] = 0xff;
+            break;
+
+          case 1:
+            buffer[i] = 0;
+            break;
+
+          default:
+            buffer[i] = (uint8_t)rand();
+            break;
+        }
+    }
+}
+
+static int check_chksum(void)
+{
+  FAR uint8_t *src  = (FAR uint8_t *)g_src;
+  FAR uint8_t *dest = (FAR uint8_t *)g_dest;
+  uint16_t expected;
+  uint16_t actual;
+  int srcoffs;
+  int destoffs;
+  int nerrors = 0;
+  int len;
+  int i;
+
+  for (i = 0; i < CONFIG_EXAMPLES_CHKSUM_NTESTS; i++)
+    {
+      srcoffs  = rand() & 3;
+      destoffs = rand() & 3;
+      len      = rand() % (MAX_TESTLEN + 1);
+
+      fill_buffer(&src[srcoffs], len, i % 8);
+      expected = htons(ref_chksum(0, &src[srcoffs], len));
+
+      /* Check uip_chksum() */
+
+      actual = uip_chksum((FAR uint16_t *)&src[srcoffs], len);
+      if (actual != expected)
+        {
+          printf("ERROR uip_chksum: offset %d len %d: %04x, expected %04x\n",
+                 srcoffs, len, actual, expected);
+          nerrors++;
+        }
+
+      /* Check uip_chksumcopy() and the data that it copied */
+
+      memset(dest, 0x5a, BUFFER_SIZE);
+      actual = uip_chksumcopy(&dest[destoffs], &src[srcoffs], len);
+      if (actual != expected)
+        {
+          printf("ERROR uip_chksumcopy: offsets %d/%d len %d: %04x, expected %04x\n",
+                 destoffs, srcoffs, len, actual, expected);
+          nerrors++;
+        }
+      else if (memcmp(&dest[destoffs], &src[srcoffs], len) != 0 ||
+               (destoffs > 0 && dest[destoffs - 1] != 0x5a) ||
+               dest[destoffs + len] != 0x5a)
+        {
+          printf("ERROR uip_chksumcopy: offsets %d/%d len %d: Bad copy\n",
+                 destoffs, srcoffs, len);
+          nerrors++;
+        }
+    }
+
+  printf("Checked %d buffers: %d errors\n",
+         CONFIG_EXAMPLES_CHKSUM_NTESTS, nerrors);
+  return nerrors;
+}
+
+static void report(FAR const char *name, uint32_t usec)
+{
+  uint32_t kbytes = (uint32_t)CONFIG_EXAMPLES_CHKSUM_NLOOPS * BENCH_LEN / 1024;
+
+  printf("  %s: %u usec", name, usec);
+  if (usec > 0)
+    {
+      printf(", %u Kbytes/sec", (uint32_t)((uint64_t)kbytes * 1000000 / usec));
+    }
+
+  printf("\n");
+}
+
+static void bench_chksum(void)
+{
+  FAR uint8_t *src  = (FAR uint8_t *)g_src;
+  FAR uint8_t *dest = (FAR uint8_t *)g_dest;
+  struct timespec start;
+  volatile uint16_t sum;
+  int i;
+
+  fill_buffer(src, BENCH_LEN, 2);
+
+  printf("%d checksums of %d bytes:\n",
+         CONFIG_EXAMPLES_CHKSUM_NLOOPS, BENCH_LEN);
+
+  (void)clock_gettime(CLOCK_REALTIME, &start);
+  for (i = 0; i < CONFIG_EXAMPLES_CHKSUM_NLOOPS; i++)
+    {
+      sum = ref_chksum(0, src, BENCH_LEN);
+    }
+
+  report("Reference", elapsed_usec(&start));
+
+  (void)clock_gettime(CLOCK_REALTIME, &start);
+  for (i = 0; i < CONFIG_EXAMPLES_CHKSUM_NLOOPS; i++)
+    {
+      sum = uip_chksum((FAR uint16_t *)src, BENCH_LEN);
+    }
+
+  report("uip_chksum", elapsed_usec(&start));
+
+  (void)clock_gettime(CLOCK_REALTIME, &start);
+  for (i = 0; i < CONFIG_EXAMPLES_CHKSUM_NLOOPS; i++)
+    {
+      sum = uip_chksum((FAR uint16_t *)&src[1], BENCH_LEN);
+    }
+
+  report("uip_chksum (unaligned)", elapsed_usec(&start));
+
+  (void)clock_gettime(CLOCK_REALTIME, &start);
+  for (i = 0; i < CONFIG_EXAMPLES_CHKSUM_NLOOPS; i++)
+    {
+      memcpy(dest, src, BENCH_LEN);
+      sum = uip_chksum((FAR uint16_t *)dest, BENCH_LEN);
+    }
+
+  report("memcpy + uip_chksum", elapsed_usec(&start));
+
+  (void)clock_gettime(CLOCK_REALTIME, &start);
+  for (i = 0; i < CONFIG_EXAMPLES_CHKSUM_NLOOPS; i++)
+    {
+      sum = uip_chksumcopy(dest, src, BENCH_LEN);
+    }
+
+  report("uip_chksumcopy", elapsed_usec(&start));
+  (void)sum;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: user_start
+ ****************************************************************************/
+
+int user_start(int argc, char *argv[])
+{
+  int nerrors;
+
+  nerrors = check_chksum();
+  bench_chksum();
+
+  printf("TEST COMPLETE\n");
+  return nerrors == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,382 @@
+/****************************************************************************
+ * examples/fatcopy/fatcopy_main.c
+ *
+ *   Copyright (C) 2012 Gregory Nutt. All rights reserved.
+ *   Author: Gregory Nutt <gnutt@nuttx.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name NuttX nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/mount.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+#include <errno.h>
+
+#include <nuttx/ramdisk.h>
+#include <nuttx/mkfatfs.h>
+#include <nuttx/fat.h>
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* Configuration ************************************************************/
+
+#ifndef CONFIG_FS_FAT
+#  error "This example requires CONFIG_FS_FAT"
+#endif
+
+/* If CONFIG_EXAMPLES_FATCOPY_DEVNAME is defined, then the FAT file system
+ * on that existing block device is used (for example, the simulation's
+ * /dev/ram0).  Otherwise, a RAM disk is created and formatted.
+ */
+
+#ifdef CONFIG_EXAMPLES_FATCOPY_DEVNAME
+#  define MOUNT_DEVNAME CONFIG_EXAMPLES_FATCOPY_DEVNAME
+#else
+#  ifndef CONFIG_EXAMPLES_FATCOPY_RAMDEVNO
+#    define CONFIG_EXAMPLES_FATCOPY_RAMDEVNO   1
+#  endif
+#  ifndef CONFIG_EXAMPLES_FATCOPY_SECTORSIZE
+#    define CONFIG_EXAMPLES_FATCOPY_SECTORSIZE 512
+#  endif
+#  ifndef CONFIG_EXAMPLES_FATCOPY_NSECTORS
+#    define CONFIG_EXAMPLES_FATCOPY_NSECTORS   2048
+#  endif
+
+#  define STR_RAMDEVNO(m)     #m
+#  define MKMOUNT_DEVNAME(m)  "/dev/ram" STR_RAMDEVNO(m)
+#  define MOUNT_DEVNAME       MKMOUNT_DEVNAME(CONFIG_EXAMPLES_FATCOPY_RAMDEVNO)
+
+#  define RAMDISK_SIZE \
+     (CONFIG_EXAMPLES_FATCOPY_NSECTORS * CONFIG_EXAMPLES_FATCOPY_SECTORSIZE)
+#endif
+
+#ifndef CONFIG_EXAMPLES_FATCOPY_FILESIZE
+#  define CONFIG_EXAMPLES_FATCOPY_FILESIZE   (128*1024)
+#endif
+
+/* The size of each read() and write().  The default is deliberately not a
+ * multiple of the sector size so that every transfer is a partial sector
+ * access through the FAT sector cache.
+ */
+
+#ifndef CONFIG_EXAMPLES_FATCOPY_IOSIZE
+#  define CONFIG_EXAMPLES_FATCOPY_IOSIZE     100
+#endif
+
+#define MOUNTPT           "/mnt/fatcopy"
+#define SRCFILE           MOUNTPT "/src.dat"
+#define DESTFILE          MOUNTPT "/dest.dat"
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+#ifndef CONFIG_EXAMPLES_FATCOPY_DEVNAME
+static struct fat_format_s g_fmt = FAT_FORMAT_INITIALIZER;
+#endif
+static uint8_t g_iobuffer[CONFIG_EXAMPLES_FATCOPY_IOSIZE];
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+static uint8_t pattern(off_t offset)
+{
+  return (uint8_t)(offset + (offset >> 8));
+}
+
+static uint32_t elapsed_msec(FAR const struct timespec *start)
+{
+  struct timespec end;
+
+  (void)clock_gettime(CLOCK_REALTIME, &end);
+  return (uint32_t)(end.tv_sec - start->tv_sec) * 1000 +
+         (end.tv_nsec - start->tv_nsec) / 1000000;
+}
+
+#ifndef CONFIG_EXAMPLES_FATCOPY_DEVNAME
+static int create_ramdisk(void)
+{
+  FAR uint8_t *pbuffer;
+  int ret;
+
+  /* Allocate a buffer to hold the file system image. */
+
+  pbuffer = (FAR uint8_t *)malloc(RAMDISK_SIZE);
+  if (!pbuffer)
+    {
+      printf("fatcopy: Failed to allocate ramdisk of size %d\n",
+             RAMDISK_SIZE);
+      return -ENOMEM;
+    }
+
+  /* Register a RAMDISK device to manage this RAM image */
+
+  ret = ramdisk_register(CONFIG_EXAMPLES_FATCOPY_RAMDEVNO, pbuffer,
+                         CONFIG_EXAMPLES_FATCOPY_NSECTORS,
+                         CONFIG_EXAMPLES_FATCOPY_SECTORSIZE, true);
+  if (ret < 0)
+    {
+      printf("fatcopy: Failed to register ramdisk at %s: %d\n",
+             MOUNT_DEVNAME, -ret);
+      free(pbuffer);
+      return ret;
+    }
+
+  /* Create a FAT filesystem on the ramdisk */
+
+  ret = mkfatfs(MOUNT_DEVNAME, &g_fmt);
+  if (ret < 0)
+    {
+      printf("fatcopy: mkfatfs failed: %d\n", errno);
+    }
+
+  return ret;
+}
+#endif
+
+static int create_source(void)
+{
+  off_t offset = 0;
+  ssize_t nwritten;
+  size_t nbytes;
+  int fd;
+  int i;
+
+  fd = open(SRCFILE, O_WRONLY|O_CREAT|O_TRUNC, 0666);
+  if (fd < 0)
+    {
+      printf("fatcopy: Failed to create %s: %d\n", SRCFILE, errno);
+      return ERROR;
+    }
+
+  while (offset < CONFIG_EXAMPLES_FATCOPY_FILESIZE)
+    {
+      nbytes = CONFIG_EXAMPLES_FATCOPY_FILESIZE - offset;
+      if (nbytes > CONFIG_EXAMPLES_FATCOPY_IOSIZE)
+        {
+          nbytes = CONFIG_EXAMPLES_FATCOPY_IOSIZE;
+        }
+
+      for (i = 0; i < nbytes; i++)
+        {
+          g_iobuffer[i] = pattern(offset + i);
+        }
+
+      nwritten = write(fd, g_iobuffer, nbytes);
+      if (nwritten != nbytes)
+        {
+          printf("fatcopy: Write to %s failed: %d\n", SRCFILE, errno);
+          close(fd);
+          return ERROR;
+        }
+
+      offset += nwritten;
+    }
+
+  close(fd);
+  return OK;
+}
+
+static int copy_file(void)
+{
+  ssize_t nread;
+  ssize_t nwritten;
+  int srcfd;
+  int destfd;
+  int ret = ERROR;
+
+  srcfd = open(SRCFILE, O_RDONLY);
+  if (srcfd < 0)
+    {
+      printf("fatcopy: Failed to open %s: %d\n", SRCFILE, errno);
+      return ERROR;
+    }
+
+  destfd = open(DESTFILE, O_WRONLY|O_CREAT|O_TRUNC, 0666);
+  if (destfd < 0)
+    {
+      printf("fatcopy: Failed to create %s: %d\n", DESTFILE, errno);
+      goto errout_with_srcfd;
+    }
+
+  for (;;)
+    {
+      nread = read(srcfd, g_iobuffer, CONFIG_EXAMPLES_FATCOPY_IOSIZE);
+      if (nread < 0)
+        {
+          printf("fatcopy: Read from %s failed: %d\n", SRCFILE, errno);
+          goto errout_with_destfd;
+        }
+      else if (nread == 0)
+        {
+          break;
+        }
+
+      nwritten = write(destfd, g_iobuffer, nread);
+      if (nwritten != nread)
+        {
+          printf("fatcopy: Write to %s failed: %d\n", DESTFILE, errno);
+          goto errout_with_destfd;
+        }
+    }
+
+  ret = OK;
+
+errout_with_destfd:
+  close(destfd);
+errout_with_srcfd:
+  close(srcfd);
+  return ret;
+}
+
+static int verify_copy(void)
+{
+  off_t offset = 0;
+  ssize_t nread;
+  int fd;
+  int i;
+
+  fd = open(DESTFILE, O_RDONLY);
+  if (fd < 0)
+    {
+      printf("fatcopy: Failed to open %s: %d\n", DESTFILE, errno);
+      return ERROR;
+    }
+
+  while ((nread = read(fd, g_iobuffer, CONFIG_EXAMPLES_FATCOPY_IOSIZE)) > 0)
+    {
+      for (i = 0; i < nread; i++)
+        {
+          if (g_iobuffer[i] != pattern(offset + i))
+            {
+              printf("fatcopy: Bad data at offset %ld: %02x, expected %02x\n",
+                     (long)(offset + i), g_iobuffer[i], pattern(offset + i));
+              close(fd);
+              return ERROR;
+            }
+        }
+
+      offset += nread;
+    }
+
+  close(fd);
+  if (offset != CONFIG_EXAMPLES_FATCOPY_FILESIZE)
+    {
+      printf("fatcopy: %s has %ld bytes, expected %d\n",
+             DESTFILE, (long)offset, CONFIG_EXAMPLES_FATCOPY_FILESIZE);
+      return ERROR;
+    }
+
+  return OK;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: user_start
+ ****************************************************************************/
+
+int user_start(int argc, char *argv[])
+{
+  struct fat_cachestats_s before;
+  struct fat_cachestats_s after;
+  struct timespec start;
+  uint32_t msec;
+  uint32_t misses;
+  uint32_t writebacks;
+
+#ifndef CONFIG_EXAMPLES_FATCOPY_DEVNAME
+  if (create_ramdisk() < 0)
+    {
+      return EXIT_FAILURE;
+    }
+#endif
+
+  if (mount(MOUNT_DEVNAME, MOUNTPT, "vfat", 0, NULL) < 0)
+    {
+      printf("fatcopy: Failed to mount %s: %d\n", MOUNT_DEVNAME, errno);
+      return EXIT_FAILURE;
+    }
+
+  if (create_source() < 0)
+    {
+      return EXIT_FAILURE;
+    }
+
+  /* Copy the file, timing the copy and measuring sector cache use */
+
+  (void)fat_getcachestats(MOUNTPT, &before);
+  (void)clock_gettime(CLOCK_REALTIME, &start);
+
+  if (copy_file() < 0)
+    {
+      return EXIT_FAILURE;
+    }
+
+  msec = elapsed_msec(&start);
+  (void)fat_getcachestats(MOUNTPT, &after);
+
+  misses     = after.cs_misses - before.cs_misses;
+  writebacks = after.cs_writebacks - before.cs_writebacks;
+
+  printf("Copied %d bytes, %d bytes per transfer: %u msec\n",
+         CONFIG_EXAMPLES_FATCOPY_FILESIZE, CONFIG_EXAMPLES_FATCOPY_IOSIZE,
+         msec);
+  printf("Sector cache: %u sectors of %u bytes\n",
+         after.cs_nsectors, after.cs_sectorsize);
+  printf("  hits %u misses %u writebacks %u\n",
+         after.cs_hits - before.cs_hits, misses, writebacks);
+  printf("  %u cached sector transfers (copied %d sectors)\n",
+         misses + writebacks,
+         CONFIG_EXAMPLES_FATCOPY_FILESIZE / after.cs_sectorsize);
+
+  if (verify_copy() < 0)
+    {
+      return EXIT_FAILURE;
+    }
+
+  printf("TEST COMPLETE\n");
+  return EXIT_SUCCESS;
+}
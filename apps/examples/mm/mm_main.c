@@ -37,9 +37,16 @@
  * Included Files
  ****************************************************************************/
 
+#include <nuttx/config.h>
+
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <pthread.h>
+#include <time.h>
+
+#include <nuttx/mm.h>
 
 /****************************************************************************
  * Pre-processor Definitions
@@ -47,6 +54,27 @@
 
 #define NTEST_ALLOCS 32
 
+/* Many small allocations are used to exercise the small object (slab)
+ * allocator when CONFIG_MM_SLAB is selected.
+ */
+
+#define NSMALL_ALLOCS 256
+#define SMALL_MAXSIZE 120
+
+/* Several threads allocate and free small chunks at the same time to
+ * measure contention for the heap.
+ */
+
+#ifndef CONFIG_EXAMPLES_MM_NTHREADS
+#  define CONFIG_EXAMPLES_MM_NTHREADS 4
+#endif
+
+#ifndef CONFIG_EXAMPLES_MM_NLOOPS
+#  define CONFIG_EXAMPLES_MM_NLOOPS 2000
+#endif
+
+#define NTHREAD_ALLOCS 4
+
 /* #define STOP_ON_ERRORS do{}while(0) */
 #define STOP_ON_ERRORS exit(1)
 
@@ -116,6 +144,7 @@ static const int alignment[NTEST_ALLOCS/2] =
 };
 
 static void        *allocs[NTEST_ALLOCS];
+static void        *small_allocs[NSMALL_ALLOCS];
 static struct       mallinfo alloc_info;
 
 /****************************************************************************
@@ -262,6 +291,189 @@ static void do_frees(void **mem, const int *size, const int *seq, int n)
     }
 }
 
+static int small_size(int i)
+{
+  return (i * 37) % SMALL_MAXSIZE + 1;
+}
+
+static int small_check(int i, int size)
+{
+  unsigned char *ptr = (unsigned char *)small_allocs[i];
+  int j;
+
+  for (j = 0; j < size; j++)
+    {
+      if (ptr[j] != (unsigned char)i)
+        {
+          fprintf(stderr, "ERROR small allocation %d corrupted at offset %d\n",
+                  i, j);
+          return -1;
+        }
+    }
+
+  return 0;
+}
+
+static void do_smallallocs(void)
+{
+  struct mallinfo before;
+  int size;
+  int i;
+
+#ifdef CONFIG_MM_TASKCACHE
+  mm_cacheflush();
+#endif
+
+  before = mallinfo();
+  printf("Allocating %d small objects\n", NSMALL_ALLOCS);
+
+  /* Allocate many small objects of different sizes and fill each with
+   * its own pattern.
+   */
+
+  for (i = 0; i < NSMALL_ALLOCS; i++)
+    {
+      size = small_size(i);
+      small_allocs[i] = malloc(size);
+      if (small_allocs[i] == NULL)
+        {
+          fprintf(stderr, "ERROR malloc of %d bytes failed\n", size);
+          STOP_ON_ERRORS;
+        }
+      else
+        {
+          memset(small_allocs[i], (unsigned char)i, size);
+        }
+    }
+
+  /* Free every other object, then grow the others so that some of them
+   * move out of their size class.
+   */
+
+  for (i = 0; i < NSMALL_ALLOCS; i += 2)
+    {
+      free(small_allocs[i]);
+      small_allocs[i] = NULL;
+    }
+
+  for (i = 1; i < NSMALL_ALLOCS; i += 2)
+    {
+      size = small_size(i);
+      if (small_check(i, size) < 0)
+        {
+          STOP_ON_ERRORS;
+        }
+
+      small_allocs[i] = realloc(small_allocs[i], size + 24);
+      if (small_allocs[i] == NULL)
+        {
+          fprintf(stderr, "ERROR realloc to %d bytes failed\n", size + 24);
+          STOP_ON_ERRORS;
+        }
+      else if (small_check(i, size) < 0)
+        {
+          STOP_ON_ERRORS;
+        }
+    }
+
+  /* Release everything.  All of the memory should be returned once the
+   * chunks held in the cache of this task are flushed.
+   */
+
+  for (i = 1; i < NSMALL_ALLOCS; i += 2)
+    {
+      free(small_allocs[i]);
+      small_allocs[i] = NULL;
+    }
+
+#ifdef CONFIG_MM_TASKCACHE
+  mm_cacheflush();
+#endif
+
+  mm_showmallinfo();
+  if (alloc_info.uordblks != before.uordblks)
+    {
+      fprintf(stderr, "ERROR %d bytes still allocated, expected %d\n",
+              alloc_info.uordblks, before.uordblks);
+      STOP_ON_ERRORS;
+    }
+}
+
+#ifndef CONFIG_DISABLE_PTHREAD
+static void *contention_thread(void *arg)
+{
+  void *mem[NTHREAD_ALLOCS];
+  int i;
+  int j;
+
+  for (i = 0; i < CONFIG_EXAMPLES_MM_NLOOPS; i++)
+    {
+      for (j = 0; j < NTHREAD_ALLOCS; j++)
+        {
+          mem[j] = malloc(8 + 24 * j);
+          if (mem[j] == NULL)
+            {
+              fprintf(stderr, "ERROR malloc of %d bytes failed\n", 8 + 24 * j);
+              return (void*)1;
+            }
+        }
+
+      for (j = 0; j < NTHREAD_ALLOCS; j++)
+        {
+          free(mem[j]);
+        }
+    }
+
+  return NULL;
+}
+
+static void do_contention(void)
+{
+  pthread_t threads[CONFIG_EXAMPLES_MM_NTHREADS];
+  struct timespec start;
+  struct timespec end;
+  uint32_t takes[2];
+  uint32_t waits[2];
+  uint32_t elapsed;
+  void *value;
+  int nthreads;
+  int i;
+
+  printf("Contention: %d threads, %d malloc/free loops each\n",
+         CONFIG_EXAMPLES_MM_NTHREADS, CONFIG_EXAMPLES_MM_NLOOPS);
+
+  mm_semstats(&takes[0], &waits[0]);
+  (void)clock_gettime(CLOCK_REALTIME, &start);
+
+  for (nthreads = 0; nthreads < CONFIG_EXAMPLES_MM_NTHREADS; nthreads++)
+    {
+      if (pthread_create(&threads[nthreads], NULL, contention_thread, NULL) != 0)
+        {
+          fprintf(stderr, "ERROR pthread_create failed\n");
+          break;
+        }
+    }
+
+  for (i = 0; i < nthreads; i++)
+    {
+      (void)pthread_join(threads[i], &value);
+      if (value != NULL)
+        {
+          STOP_ON_ERRORS;
+        }
+    }
+
+  (void)clock_gettime(CLOCK_REALTIME, &end);
+  mm_semstats(&takes[1], &waits[1]);
+
+  elapsed = (uint32_t)(end.tv_sec - start.tv_sec) * 1000000 +
+            (end.tv_nsec - start.tv_nsec) / 1000;
+
+  printf("Contention: %u usec, heap semaphore taken %u times, %u waits\n",
+         elapsed, takes[1] - takes[0], waits[1] - waits[0]);
+}
+#endif
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -295,6 +507,16 @@ int user_start(int argc, char *argv[])
 
   do_frees(allocs, alloc_sizes, random1, NTEST_ALLOCS);
 
+  /* Allocate, re-allocate, and release many small objects */
+
+  do_smallallocs();
+
+  /* Measure contention for the heap */
+
+#ifndef CONFIG_DISABLE_PTHREAD
+  do_contention();
+#endif
+
   printf("TEST COMPLETE\n");
   return 0;
 }
@@ -38,6 +38,7 @@
  ****************************************************************************/
 
 #include <sys/socket.h>
+#include <sys/time.h>
 #include <netinet/in.h>
 
 #include <stdio.h>
@@ -58,6 +59,12 @@ void send_client(void)
   char *outbuf;
 #ifndef CONFIG_EXAMPLE_NETTEST_PERFORMANCE
   char *inbuf;
+#endif
+#ifdef CONFIG_EXAMPLE_NETTEST_PERFORMANCE
+  struct timeval start;
+  struct timeval now;
+  unsigned long totalbytessent;
+  unsigned long msec;
 #endif
   int sockfd;
   int nbytessent;
@@ -122,7 +129,12 @@ void send_client(void)
     }
 
 #ifdef CONFIG_EXAMPLE_NETTEST_PERFORMANCE
-  /* Then send messages forever */
+  /* Then send messages forever, reporting the throughput about once each
+   * second.
+   */
+
+  gettimeofday(&start, NULL);
+  totalbytessent = 0;
 
   for (;;)
     {
@@ -138,7 +150,19 @@ void send_client(void)
                   nbytessent, SENDSIZE);
           goto errout_with_socket;
         }
-      message("Sent %d bytes\n", nbytessent);
+
+      totalbytessent += nbytessent;
+      gettimeofday(&now, NULL);
+      msec = (now.tv_sec - start.tv_sec) * 1000 +
+             (now.tv_usec - start.tv_usec) / 1000;
+
+      if (msec >= 1000)
+        {
+          message("Sent %lu bytes in %lu msec: %lu Kbytes/sec\n",
+                  totalbytessent, msec, totalbytessent / msec);
+          start          = now;
+          totalbytessent = 0;
+        }
     }
 #else
   /* Then send and receive one message */
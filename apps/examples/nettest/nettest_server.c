@@ -39,6 +39,7 @@
 
 #include <sys/types.h>
 #include <sys/socket.h>
+#include <sys/time.h>
 #include <netinet/in.h>
 
 #include <stdio.h>
@@ -63,7 +64,12 @@ void recv_server(void)
   int acceptsd;
   socklen_t addrlen;
   int nbytesread;
-#ifndef CONFIG_EXAMPLE_NETTEST_PERFORMANCE
+#ifdef CONFIG_EXAMPLE_NETTEST_PERFORMANCE
+  struct timeval start;
+  struct timeval now;
+  unsigned long totalbytesread;
+  unsigned long msec;
+#else
   int totalbytesread;
   int nbytessent;
   int ch;
@@ -144,7 +150,12 @@ void recv_server(void)
 #endif
 
 #ifdef CONFIG_EXAMPLE_NETTEST_PERFORMANCE
-  /* Then receive data forever */
+  /* Then receive data forever, reporting the throughput about once each
+   * second.
+   */
+
+  gettimeofday(&start, NULL);
+  totalbytesread = 0;
 
   for (;;)
     {
@@ -154,7 +165,19 @@ void recv_server(void)
           message("server: recv failed: %d\n", errno);
           goto errout_with_acceptsd;
         }
-      message("Received %d bytes\n", nbytesread);
+
+      totalbytesread += nbytesread;
+      gettimeofday(&now, NULL);
+      msec = (now.tv_sec - start.tv_sec) * 1000 +
+             (now.tv_usec - start.tv_usec) / 1000;
+
+      if (msec >= 1000)
+        {
+          message("Received %lu bytes in %lu msec: %lu Kbytes/sec\n",
+                  totalbytesread, msec, totalbytesread / msec);
+          start          = now;
+          totalbytesread = 0;
+        }
     }
 #else
   /* Receive canned message */
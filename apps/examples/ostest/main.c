@@ -377,6 +377,14 @@ static int user_main(int argc, char *argv[])
       check_test_memory_usage();
 #endif
 
+#if !defined(CONFIG_DISABLE_SIGNALS) && !defined(CONFIG_DISABLE_CLOCK)
+      /* Verify watchdog timers and measure the cost of restarting them */
+
+      printf("\nuser_main: watchdog timer test\n");
+      wdog_test();
+      check_test_memory_usage();
+#endif
+
 #if !defined(CONFIG_DISABLE_PTHREAD) && CONFIG_RR_INTERVAL > 0
       /* Verify round robin scheduling */
 
@@ -147,6 +147,10 @@ extern void sighand_test(void);
 
 extern void timer_test(void);
 
+/* wdog.c *******************************************************************/
+
+extern void wdog_test(void);
+
 /* roundrobin.c *************************************************************/
 
 extern void rr_test(void);
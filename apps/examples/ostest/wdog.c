@@ -0,0 +1,264 @@
+/***********************************************************************
+ * examples/ostest/wdog.c
+ *
+ *   Copyright (C) 2012 Gregory Nutt. All rights reserved.
+ *   Author: Gregory Nutt <gnutt@nuttx.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name NuttX nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ***********************************************************************/
+
+/**************************************************************************
+ * Included Files
+ **************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <wdog.h>
+
+#include <nuttx/clock.h>
+
+#include "ostest.h"
+
+/**************************************************************************
+ * Private Definitions
+ **************************************************************************/
+
+/* The maximum number of watchdogs used by the test.  Fewer will be used
+ * if wd_create() fails.  CONFIG_PREALLOC_WDOGS must be increased in order
+ * to run the benchmark with many active watchdogs.
+ */
+
+#ifndef CONFIG_EXAMPLES_OSTEST_NWDOGS
+#  define CONFIG_EXAMPLES_OSTEST_NWDOGS 16
+#endif
+
+/* The number of times that each watchdog is restarted in the benchmark */
+
+#ifndef CONFIG_EXAMPLES_OSTEST_WDOGLOOPS
+#  define CONFIG_EXAMPLES_OSTEST_WDOGLOOPS 1000
+#endif
+
+/* Delays in the expiration test are spread over this many ticks.  This
+ * is more than the 64 ticks of level 0 of the timing wheel.
+ */
+
+#define WDOG_MAXDELAY   130
+
+/* Delays in the benchmark are long enough that no watchdog expires */
+
+#define WDOG_LONGDELAY  10000
+
+#ifdef CONFIG_WDOG_TIMERWHEEL
+#  define WDOG_BACKEND "timing wheel"
+#else
+#  define WDOG_BACKEND "sorted list"
+#endif
+
+/**************************************************************************
+ * Private Data
+ **************************************************************************/
+
+static WDOG_ID           g_wdogs[CONFIG_EXAMPLES_OSTEST_NWDOGS];
+static uint32_t          g_expected[CONFIG_EXAMPLES_OSTEST_NWDOGS];
+static volatile uint32_t g_fired[CONFIG_EXAMPLES_OSTEST_NWDOGS];
+static volatile int      g_nfired;
+static uint32_t          g_seed;
+
+/**************************************************************************
+ * Private Functions
+ **************************************************************************/
+
+static int wdog_random(int range)
+{
+  g_seed = g_seed * 1103515245 + 12345;
+  return (int)((g_seed >> 16) % range);
+}
+
+static void wdog_expiration(int argc, uint32_t arg1, ...)
+{
+  /* This runs in the context of the timer interrupt handler */
+
+  g_fired[arg1] = clock_systimer();
+  g_nfired++;
+}
+
+/**************************************************************************
+ * Public Functions
+ **************************************************************************/
+
+void wdog_test(void)
+{
+  uint32_t        start;
+  uint32_t        elapsed;
+  int             nwdogs;
+  int             nstarted;
+  int             delay;
+  int             remaining;
+  int             i;
+  int             j;
+
+  /* Get as many watchdogs as we can */
+
+  for (nwdogs = 0; nwdogs < CONFIG_EXAMPLES_OSTEST_NWDOGS; nwdogs++)
+    {
+      g_wdogs[nwdogs] = wd_create();
+      if (!g_wdogs[nwdogs])
+        {
+          break;
+        }
+    }
+
+  printf("wdog_test: Using %d watchdogs (%s)\n", nwdogs, WDOG_BACKEND);
+  if (nwdogs < 2)
+    {
+      printf("wdog_test: ERROR not enough watchdogs\n");
+      goto errout;
+    }
+
+  /* Start every watchdog with a random delay, then cancel every third
+   * one.  The others should expire no earlier than their delay.
+   */
+
+  g_seed   = 1;
+  g_nfired = 0;
+  nstarted = 0;
+
+  for (i = 0; i < nwdogs; i++)
+    {
+      delay         = wdog_random(WDOG_MAXDELAY) + 1;
+      g_fired[i]    = 0;
+      g_expected[i] = clock_systimer() + delay;
+
+      if (wd_start(g_wdogs[i], delay, (wdentry_t)wdog_expiration, 1,
+                   (uint32_t)i) != OK)
+        {
+          printf("wdog_test: ERROR wd_start failed\n");
+        }
+
+      remaining = wd_gettime(g_wdogs[i]);
+      if (remaining <= 0 || remaining > delay + 1)
+        {
+          printf("wdog_test: ERROR wd_gettime=%d delay=%d\n",
+                 remaining, delay);
+        }
+    }
+
+  for (i = 0; i < nwdogs; i++)
+    {
+      if (i % 3 == 0)
+        {
+          if (wd_cancel(g_wdogs[i]) != OK)
+            {
+              printf("wdog_test: ERROR wd_cancel failed\n");
+            }
+        }
+      else
+        {
+          nstarted++;
+        }
+    }
+
+  /* Wait for the watchdogs to expire */
+
+  for (i = 0; i < WDOG_MAXDELAY + 10 && g_nfired < nstarted; i++)
+    {
+      usleep(USEC_PER_TICK);
+    }
+
+  usleep(2*USEC_PER_TICK);
+  if (g_nfired != nstarted)
+    {
+      printf("wdog_test: ERROR %d watchdogs expired, expected %d\n",
+             g_nfired, nstarted);
+    }
+
+  for (i = 0; i < nwdogs; i++)
+    {
+      if (i % 3 == 0)
+        {
+          if (g_fired[i] != 0)
+            {
+              printf("wdog_test: ERROR cancelled watchdog %d expired\n", i);
+            }
+        }
+      else if (g_fired[i] == 0 || (int32_t)(g_fired[i] - g_expected[i]) < 0)
+        {
+          printf("wdog_test: ERROR watchdog %d expired at %d, expected %d\n",
+                 i, g_fired[i], g_expected[i]);
+        }
+    }
+
+  /* Now restart each watchdog many times while all of the others are
+   * active.  Restarting an active watchdog cancels it and then inserts it
+   * again.  The elapsed time is only available in system clock ticks, so
+   * it is meaningful only if the timer interrupt runs during the loop and
+   * the loop lasts for many ticks (it does not advance at all in the
+   * simulation, for example).
+   */
+
+  for (i = 0; i < nwdogs; i++)
+    {
+      wd_start(g_wdogs[i], WDOG_LONGDELAY + wdog_random(WDOG_LONGDELAY),
+               (wdentry_t)wdog_expiration, 1, (uint32_t)i);
+    }
+
+  start = clock_systimer();
+  for (j = 0; j < CONFIG_EXAMPLES_OSTEST_WDOGLOOPS; j++)
+    {
+      for (i = 0; i < nwdogs; i++)
+        {
+          wd_start(g_wdogs[i], WDOG_LONGDELAY + wdog_random(WDOG_LONGDELAY),
+                   (wdentry_t)wdog_expiration, 1, (uint32_t)i);
+        }
+    }
+  elapsed = clock_systimer() - start;
+
+  printf("wdog_test: %d restarts with %d active watchdogs: %u ticks "
+         "(%d msec per tick)\n",
+         CONFIG_EXAMPLES_OSTEST_WDOGLOOPS * nwdogs, nwdogs, elapsed,
+         MSEC_PER_TICK);
+
+  for (i = 0; i < nwdogs; i++)
+    {
+      (void)wd_cancel(g_wdogs[i]);
+    }
+
+errout:
+  for (i = 0; i < nwdogs; i++)
+    {
+      wd_delete(g_wdogs[i]);
+    }
+
+  printf("wdog_test: done\n" );
+  FFLUSH();
+}
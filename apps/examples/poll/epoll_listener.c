@@ -0,0 +1,210 @@
+/****************************************************************************
+ * examples/poll/epoll_listener.c
+ *
+ *   Copyright (C) 2012 Gregory Nutt. All rights reserved.
+ *   Author: Gregory Nutt <gnutt@nuttx.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name NuttX nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/epoll.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <string.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <debug.h>
+
+#include "poll_internal.h"
+
+/****************************************************************************
+ * Definitions
+ ****************************************************************************/
+
+#if defined(CONFIG_DEV_CONSOLE) && !defined(CONFIG_DEV_LOWCONSOLE)
+#   define HAVE_CONSOLE
+#   define NEPOLLFDS 2
+#else
+#   undef  HAVE_CONSOLE
+#   define NEPOLLFDS 1
+#endif
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: epoll_listener
+ ****************************************************************************/
+
+void *epoll_listener(pthread_addr_t pvarg)
+{
+  struct epoll_event events[NEPOLLFDS];
+  struct epoll_event ev;
+  char buffer[64];
+  ssize_t nbytes;
+  int epfd;
+  int fd;
+  int ret;
+  int i;
+
+  /* Open the FIFO for non-blocking read */
+
+  message("epoll_listener: Opening %s for non-blocking read\n", FIFO_PATH3);
+  fd = open(FIFO_PATH3, O_RDONLY|O_NONBLOCK);
+  if (fd < 0)
+    {
+      message("epoll_listener: ERROR Failed to open FIFO %s: %d\n",
+              FIFO_PATH3, errno);
+      return (void*)-1;
+    }
+
+  /* Register the descriptors once.  They stay registered for all of the
+   * calls to epoll_wait() below.
+   */
+
+  epfd = epoll_create(NEPOLLFDS);
+  if (epfd < 0)
+    {
+      message("epoll_listener: ERROR epoll_create failed: %d\n", errno);
+      (void)close(fd);
+      return (void*)-1;
+    }
+
+#ifdef HAVE_CONSOLE
+  ev.events  = EPOLLIN;
+  ev.data.fd = 0;
+  ret = epoll_ctl(epfd, EPOLL_CTL_ADD, 0, &ev);
+  if (ret < 0)
+    {
+      message("epoll_listener: ERROR epoll_ctl(console) failed: %d\n", errno);
+    }
+#endif
+
+  ev.events  = EPOLLIN;
+  ev.data.fd = fd;
+  ret = epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev);
+  if (ret < 0)
+    {
+      message("epoll_listener: ERROR epoll_ctl(FIFO) failed: %d\n", errno);
+      goto errout;
+    }
+
+  /* Loop forever */
+
+  for (;;)
+    {
+      message("epoll_listener: Calling epoll_wait()\n");
+
+      ret = epoll_wait(epfd, events, NEPOLLFDS, EPOLL_LISTENER_DELAY);
+
+      message("\nepoll_listener: epoll_wait returned: %d\n", ret);
+      if (ret < 0)
+        {
+          message("epoll_listener: ERROR epoll_wait failed: %d\n", errno);
+          break;
+        }
+      else if (ret == 0)
+        {
+          message("epoll_listener: Timeout\n");
+        }
+      else if (ret > NEPOLLFDS)
+        {
+          message("epoll_listener: ERROR epoll_wait reported: %d\n", ret);
+        }
+
+      /* Read until the pipe/serial is empty.  The events are level
+       * triggered, so any data left behind would be reported again by the
+       * next epoll_wait().
+       */
+
+      for (i = 0; i < ret && i < NEPOLLFDS; i++)
+        {
+          message("epoll_listener: events[%d]=%02x fd=%d\n",
+                  i, events[i].events, events[i].data.fd);
+
+          if (events[i].events != EPOLLIN)
+            {
+              message("epoll_listener: ERROR unexpected events[%d]=%02x\n",
+                      i, events[i].events);
+            }
+
+          do
+            {
+#ifdef HAVE_CONSOLE
+              /* Hack to work around the fact that the console driver on the
+               * simulator is always non-blocking.
+               */
+
+              if (events[i].data.fd == 0)
+                {
+                  buffer[0] = getchar();
+                  nbytes = 1;
+                  break;
+                }
+#endif
+              nbytes = read(events[i].data.fd, buffer, 63);
+              if (nbytes <= 0)
+                {
+                  if (nbytes < 0 && errno != EAGAIN && errno != EINTR)
+                    {
+                      message("epoll_listener: read failed: %d\n", errno);
+                    }
+                }
+              else
+                {
+                  buffer[nbytes] = '\0';
+                  message("epoll_listener: Read '%s' (%d bytes)\n",
+                          buffer, nbytes);
+                }
+            }
+          while (nbytes > 0);
+        }
+
+      /* Make sure that everything is displayed */
+
+      msgflush();
+    }
+
+errout:
+  (void)epoll_close(epfd);
+  (void)close(fd);
+  return NULL;
+}
@@ -98,9 +98,11 @@
 
 #define FIFO_PATH1 "/dev/fifo0"
 #define FIFO_PATH2 "/dev/fifo1"
+#define FIFO_PATH3 "/dev/fifo2"
 
 #define POLL_LISTENER_DELAY   2000   /* 2 seconds */
 #define SELECT_LISTENER_DELAY 4      /* 4 seconds */
+#define EPOLL_LISTENER_DELAY  5000   /* 5 seconds */
 #define NET_LISTENER_DELAY    3      /* 3 seconds */
 #define WRITER_DELAY          6      /* 6 seconds */
 
@@ -120,6 +122,7 @@
 
 extern void *poll_listener(pthread_addr_t pvarg);
 extern void *select_listener(pthread_addr_t pvarg);
+extern void *epoll_listener(pthread_addr_t pvarg);
 
 #ifdef HAVE_NETPOLL
 extern void *net_listener(pthread_addr_t pvarg);
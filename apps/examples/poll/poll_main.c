@@ -83,12 +83,14 @@ int user_start(int argc, char *argv[])
   ssize_t nbytes;
   pthread_t tid1;
   pthread_t tid2;
+  pthread_t tid4;
 #ifdef HAVE_NETPOLL
   pthread_t tid3;
 #endif
   int count;
   int fd1 = -1;
   int fd2 = -1;
+  int fd3 = -1;
   int ret;
   int exitcode = 0;
 
@@ -112,6 +114,15 @@ int user_start(int argc, char *argv[])
       goto errout;
     }
 
+  message("\nuser_start: Creating FIFO %s\n", FIFO_PATH3);
+  ret = mkfifo(FIFO_PATH3, 0666);
+  if (ret < 0)
+    {
+      message("user_start: mkfifo failed: %d\n", errno);
+      exitcode = 9;
+      goto errout;
+    }
+
   /* Open the FIFOs for blocking, write */
 
   fd1 = open(FIFO_PATH1, O_WRONLY);
@@ -132,6 +143,15 @@ int user_start(int argc, char *argv[])
       goto errout;
     }
 
+  fd3 = open(FIFO_PATH3, O_WRONLY);
+  if (fd3 < 0)
+    {
+      message("user_start: Failed to open FIFO %s for writing, errno=%d\n",
+              FIFO_PATH3, errno);
+      exitcode = 10;
+      goto errout;
+    }
+
   /* Start the listeners */
 
   message("user_start: Starting poll_listener thread\n");
@@ -154,6 +174,16 @@ int user_start(int argc, char *argv[])
       goto errout;
     }
 
+  message("user_start: Starting epoll_listener thread\n");
+
+  ret = pthread_create(&tid4, NULL, epoll_listener, NULL);
+  if (ret != 0)
+    {
+      message("user_start: Failed to create epoll_listener thread: %d\n", ret);
+      exitcode = 11;
+      goto errout;
+    }
+
 #ifdef HAVE_NETPOLL
 #ifdef CONFIG_NET_TCPBACKLOG
   message("user_start: Starting net_listener thread\n");
@@ -195,6 +225,14 @@ int user_start(int argc, char *argv[])
           goto errout;
         }
 
+      nbytes = write(fd3, buffer, strlen(buffer));
+      if (nbytes < 0)
+        {
+          message("user_start: Write fd3 failed: %d\n", errno);
+          exitcode = 12;
+          goto errout;
+        }
+
       message("\nuser_start: Sent '%s' (%d bytes)\n", buffer, nbytes);
       msgflush();
 
@@ -216,6 +254,11 @@ errout:
       close(fd2);
     }
 
+  if (fd3 >= 0)
+    {
+      close(fd3);
+    }
+
   fflush(stdout);
   return exitcode;
 }
@@ -0,0 +1,424 @@
+/****************************************************************************
+ * examples/sdbench/sdbench_main.c
+ *
+ *   Copyright (C) 2012 Gregory Nutt. All rights reserved.
+ *   Author: Gregory Nutt <gnutt@nuttx.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name NuttX nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/types.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+
+#include <nuttx/fs.h>
+#include <nuttx/ioctl.h>
+#include <nuttx/mmcsd.h>
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* Configuration ************************************************************/
+
+#ifdef CONFIG_DISABLE_MOUNTPOINT
+#  error "This example requires mountpoint support (for block drivers)"
+#endif
+
+#ifndef CONFIG_FS_WRITABLE
+#  error "This example requires CONFIG_FS_WRITABLE"
+#endif
+
+#ifndef CONFIG_EXAMPLES_SDBENCH_DEVNAME
+#  define CONFIG_EXAMPLES_SDBENCH_DEVNAME    "/dev/mmcsd0"
+#endif
+
+/* The number of sectors written and read in each pass */
+
+#ifndef CONFIG_EXAMPLES_SDBENCH_NSECTORS
+#  define CONFIG_EXAMPLES_SDBENCH_NSECTORS   256
+#endif
+
+/* The number of sectors in each request */
+
+#ifndef CONFIG_EXAMPLES_SDBENCH_XFRSECTORS
+#  define CONFIG_EXAMPLES_SDBENCH_XFRSECTORS 16
+#endif
+
+/* The number of memory segments in each scatter/gather request */
+
+#ifndef CONFIG_EXAMPLES_SDBENCH_NSG
+#  define CONFIG_EXAMPLES_SDBENCH_NSG        4
+#endif
+
+#define NREQUESTS \
+  ((CONFIG_EXAMPLES_SDBENCH_NSECTORS + CONFIG_EXAMPLES_SDBENCH_XFRSECTORS - 1) / \
+   CONFIG_EXAMPLES_SDBENCH_XFRSECTORS)
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static FAR struct inode *g_inode;
+static FAR uint8_t *g_buffer;
+static struct geometry g_geo;
+
+#ifdef CONFIG_MMCSD_SGREQUESTS
+static struct block_sgreq_s g_req[NREQUESTS];
+static struct block_sg_s g_sg[NREQUESTS][CONFIG_EXAMPLES_SDBENCH_NSG];
+#endif
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+static uint8_t pattern(size_t sector, size_t offset, int pass)
+{
+  return (uint8_t)(sector + (sector >> 8) + offset + pass);
+}
+
+static void fill_buffer(int pass)
+{
+  size_t sector;
+  size_t i;
+
+  for (sector = 0; sector < CONFIG_EXAMPLES_SDBENCH_NSECTORS; sector++)
+    {
+      for (i = 0; i < g_geo.geo_sectorsize; i++)
+        {
+          g_buffer[sector * g_geo.geo_sectorsize + i] = pattern(sector, i, pass);
+        }
+    }
+}
+
+static int verify_buffer(int pass)
+{
+  size_t sector;
+  size_t i;
+
+  for (sector = 0; sector < CONFIG_EXAMPLES_SDBENCH_NSECTORS; sector++)
+    {
+      for (i = 0; i < g_geo.geo_sectorsize; i++)
+        {
+          uint8_t expected = pattern(sector, i, pass);
+          if (g_buffer[sector * g_geo.geo_sectorsize + i] != expected)
+            {
+              printf("sdbench: Bad data in sector %u offset %u: %02x, "
+                     "expected %02x\n", (unsigned)sector, (unsigned)i,
+                     g_buffer[sector * g_geo.geo_sectorsize + i], expected);
+              return ERROR;
+            }
+        }
+    }
+
+  return OK;
+}
+
+static uint32_t elapsed_msec(FAR const struct timespec *start)
+{
+  struct timespec end;
+
+  (void)clock_gettime(CLOCK_REALTIME, &end);
+  return (uint32_t)(end.tv_sec - start->tv_sec) * 1000 +
+         (end.tv_nsec - start->tv_nsec) / 1000000;
+}
+
+/* Transfer all sectors, one request of XFRSECTORS sectors at a time */
+
+static int xfr_simple(bool write)
+{
+  size_t sector;
+  size_t nsectors;
+  ssize_t nxfrd;
+
+  for (sector = 0;
+       sector < CONFIG_EXAMPLES_SDBENCH_NSECTORS;
+       sector += CONFIG_EXAMPLES_SDBENCH_XFRSECTORS)
+    {
+      nsectors = CONFIG_EXAMPLES_SDBENCH_NSECTORS - sector;
+      if (nsectors > CONFIG_EXAMPLES_SDBENCH_XFRSECTORS)
+        {
+          nsectors = CONFIG_EXAMPLES_SDBENCH_XFRSECTORS;
+        }
+
+      if (write)
+        {
+          nxfrd = g_inode->u.i_bops->write(g_inode,
+                    &g_buffer[sector * g_geo.geo_sectorsize], sector,
+                    nsectors);
+        }
+      else
+        {
+          nxfrd = g_inode->u.i_bops->read(g_inode,
+                    &g_buffer[sector * g_geo.geo_sectorsize], sector,
+                    nsectors);
+        }
+
+      if (nxfrd != nsectors)
+        {
+          printf("sdbench: %s of sector %u failed: %d\n",
+                 write ? "Write" : "Read", (unsigned)sector, (int)nxfrd);
+          return ERROR;
+        }
+    }
+
+  return OK;
+}
+
+/* Transfer all sectors with one chain of scatter/gather requests.  Each
+ * request of XFRSECTORS sectors is split into NSG memory segments.
+ */
+
+#ifdef CONFIG_MMCSD_SGREQUESTS
+static int xfr_sg(bool write)
+{
+  FAR struct block_sgreq_s *req;
+  size_t sector = 0;
+  size_t nsectors;
+  size_t segsectors;
+  int ret;
+  int i;
+  int j;
+
+  for (i = 0; i < NREQUESTS; i++)
+    {
+      req = &g_req[i];
+      req->flink       = (i + 1 < NREQUESTS) ? &g_req[i + 1] : NULL;
+      req->sg          = g_sg[i];
+      req->startsector = sector;
+      req->nsg         = 0;
+
+      nsectors = CONFIG_EXAMPLES_SDBENCH_NSECTORS - sector;
+      if (nsectors > CONFIG_EXAMPLES_SDBENCH_XFRSECTORS)
+        {
+          nsectors = CONFIG_EXAMPLES_SDBENCH_XFRSECTORS;
+        }
+
+      segsectors = (nsectors + CONFIG_EXAMPLES_SDBENCH_NSG - 1) /
+                   CONFIG_EXAMPLES_SDBENCH_NSG;
+
+      for (j = 0; j < CONFIG_EXAMPLES_SDBENCH_NSG && nsectors > 0; j++)
+        {
+          g_sg[i][j].buffer   = &g_buffer[sector * g_geo.geo_sectorsize];
+          g_sg[i][j].nsectors = segsectors < nsectors ? segsectors : nsectors;
+          sector             += g_sg[i][j].nsectors;
+          nsectors           -= g_sg[i][j].nsectors;
+          req->nsg++;
+        }
+    }
+
+  ret = g_inode->u.i_bops->ioctl(g_inode, write ? BIOC_WRITESG : BIOC_READSG,
+                                 (unsigned long)((uintptr_t)g_req));
+  if (ret < 0)
+    {
+      printf("sdbench: %s failed: %d\n",
+             write ? "BIOC_WRITESG" : "BIOC_READSG", ret);
+      return ERROR;
+    }
+
+  return OK;
+}
+#endif
+
+/* Run one timed pass and report the rate seen by the caller and the rate
+ * of the card transfers (from BIOC_MMCSDSTATS).
+ */
+
+static int run_pass(FAR const char *name, int (*xfr)(bool write), bool write)
+{
+  struct mmcsd_stats_s before;
+  struct mmcsd_stats_s after;
+  struct timespec start;
+  uint32_t msec;
+  uint32_t blocks;
+  uint32_t ticks;
+  uint32_t kbytes;
+  int ret;
+
+  ret = g_inode->u.i_bops->ioctl(g_inode, BIOC_MMCSDSTATS,
+                                 (unsigned long)((uintptr_t)&before));
+  if (ret < 0)
+    {
+      printf("sdbench: BIOC_MMCSDSTATS failed: %d\n", ret);
+      return ERROR;
+    }
+
+  (void)clock_gettime(CLOCK_REALTIME, &start);
+  ret = xfr(write);
+  msec = elapsed_msec(&start);
+  if (ret < 0)
+    {
+      return ERROR;
+    }
+
+  (void)g_inode->u.i_bops->ioctl(g_inode, BIOC_MMCSDSTATS,
+                                 (unsigned long)((uintptr_t)&after));
+
+  if (write)
+    {
+      blocks = after.wrblocks - before.wrblocks;
+      ticks  = after.wrticks  - before.wrticks;
+    }
+  else
+    {
+      blocks = after.rdblocks - before.rdblocks;
+      ticks  = after.rdticks  - before.rdticks;
+    }
+
+  kbytes = (CONFIG_EXAMPLES_SDBENCH_NSECTORS * g_geo.geo_sectorsize) / 1024;
+  printf("%-14s %s %u KB: %u msec", name, write ? "write" : "read ",
+         kbytes, msec);
+  if (msec > 0)
+    {
+      printf(" (%u KB/s)", kbytes * 1000 / msec);
+    }
+
+  kbytes = (blocks * after.blocksize) / 1024;
+  printf(", card %u KB in %u ticks", kbytes, ticks);
+  if (ticks > 0)
+    {
+      printf(" (%u KB/s)", kbytes * CLK_TCK / ticks);
+    }
+
+  printf("\n");
+  return OK;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: user_start
+ ****************************************************************************/
+
+int user_start(int argc, char *argv[])
+{
+  struct mmcsd_stats_s stats;
+  int ret;
+
+  ret = open_blockdriver(CONFIG_EXAMPLES_SDBENCH_DEVNAME, 0, &g_inode);
+  if (ret < 0)
+    {
+      printf("sdbench: Failed to open %s: %d\n",
+             CONFIG_EXAMPLES_SDBENCH_DEVNAME, ret);
+      return EXIT_FAILURE;
+    }
+
+  ret = g_inode->u.i_bops->geometry(g_inode, &g_geo);
+  if (ret < 0 || !g_geo.geo_available)
+    {
+      printf("sdbench: No media in %s\n", CONFIG_EXAMPLES_SDBENCH_DEVNAME);
+      goto errout_with_driver;
+    }
+
+  if (g_geo.geo_nsectors < CONFIG_EXAMPLES_SDBENCH_NSECTORS)
+    {
+      printf("sdbench: %s has only %u sectors\n",
+             CONFIG_EXAMPLES_SDBENCH_DEVNAME, (unsigned)g_geo.geo_nsectors);
+      goto errout_with_driver;
+    }
+
+  g_buffer = (FAR uint8_t *)malloc(CONFIG_EXAMPLES_SDBENCH_NSECTORS *
+                                   g_geo.geo_sectorsize);
+  if (!g_buffer)
+    {
+      printf("sdbench: Failed to allocate the buffer\n");
+      goto errout_with_driver;
+    }
+
+  printf("%s: %u sectors of %u bytes, %d sectors per request\n",
+         CONFIG_EXAMPLES_SDBENCH_DEVNAME, (unsigned)g_geo.geo_nsectors,
+         (unsigned)g_geo.geo_sectorsize, CONFIG_EXAMPLES_SDBENCH_XFRSECTORS);
+
+  /* Write and read back the sectors with the block driver read and write
+   * methods.
+   */
+
+  fill_buffer(0);
+  if (run_pass("read/write", xfr_simple, true) < 0)
+    {
+      goto errout_with_buffer;
+    }
+
+  memset(g_buffer, 0, CONFIG_EXAMPLES_SDBENCH_NSECTORS * g_geo.geo_sectorsize);
+  if (run_pass("read/write", xfr_simple, false) < 0 || verify_buffer(0) < 0)
+    {
+      goto errout_with_buffer;
+    }
+
+  /* Then again with one chain of scatter/gather requests */
+
+#ifdef CONFIG_MMCSD_SGREQUESTS
+  fill_buffer(1);
+  if (run_pass("scatter/gather", xfr_sg, true) < 0)
+    {
+      goto errout_with_buffer;
+    }
+
+  memset(g_buffer, 0, CONFIG_EXAMPLES_SDBENCH_NSECTORS * g_geo.geo_sectorsize);
+  if (run_pass("scatter/gather", xfr_sg, false) < 0 || verify_buffer(1) < 0)
+    {
+      goto errout_with_buffer;
+    }
+#endif
+
+  /* Show the totals since the card was inserted */
+
+  if (g_inode->u.i_bops->ioctl(g_inode, BIOC_MMCSDSTATS,
+                               (unsigned long)((uintptr_t)&stats)) == OK)
+    {
+      printf("Totals: %u reads (%u blocks, %u KB/s), "
+             "%u writes (%u blocks, %u KB/s)\n",
+             stats.nreads, stats.rdblocks, stats.rdkbps,
+             stats.nwrites, stats.wrblocks, stats.wrkbps);
+    }
+
+  free(g_buffer);
+  (void)close_blockdriver(g_inode);
+  printf("TEST COMPLETE\n");
+  return EXIT_SUCCESS;
+
+errout_with_buffer:
+  free(g_buffer);
+errout_with_driver:
+  (void)close_blockdriver(g_inode);
+  return EXIT_FAILURE;
+}
@@ -367,6 +367,12 @@ extern void nsh_dumpbuffer(FAR struct nsh_vtbl_s *vtbl, const char *msg,
 #ifndef CONFIG_NSH_DISABLE_FREE
   extern int cmd_free(FAR struct nsh_vtbl_s *vtbl, int argc, char **argv);
 #endif
+#if defined(CONFIG_MM_TRACE) && !defined(CONFIG_NSH_DISABLE_HEAP)
+  extern int cmd_heap(FAR struct nsh_vtbl_s *vtbl, int argc, char **argv);
+#endif
+#ifndef CONFIG_NSH_DISABLE_MEMPOOL
+  extern int cmd_mempool(FAR struct nsh_vtbl_s *vtbl, int argc, char **argv);
+#endif
 #ifndef CONFIG_NSH_DISABLE_PS
   extern int cmd_ps(FAR struct nsh_vtbl_s *vtbl, int argc, char **argv);
 #endif
@@ -51,6 +51,10 @@
 #include <errno.h>
 
 #include <nuttx/fs.h>
+#ifdef CONFIG_NSH_CMDOPT_DD_STATS
+#  include <nuttx/clock.h>
+#endif
+
 #include "nsh.h"
 
 #if CONFIG_NFILE_DESCRIPTORS > 0 && !defined(CONFIG_NSH_DISABLE_DD)
@@ -127,8 +131,8 @@ struct dd_s
   uint32_t sector;     /* The current sector number */
   uint32_t skip;       /* The number of sectors skipped on input */
   bool     eof;        /* true:  The of the input or output file has been hit */
-  uint16_t sectsize;   /* Size of one sector */
-  uint16_t nbytes;     /* Number of valid bytes in the buffer */
+  uint32_t sectsize;   /* Size of one sector */
+  uint32_t nbytes;     /* Number of valid bytes in the buffer */
   uint8_t *buffer;     /* Buffer of data to write to the output file */
 
   /* Function pointers to handle differences between block and character devices */
@@ -242,7 +246,7 @@ static int dd_writeblk(struct dd_s *dd)
 static int dd_writech(struct dd_s *dd)
 {
   uint8_t *buffer = dd->buffer;
-  uint16_t written ;
+  uint32_t written;
   ssize_t nbytes;
 
   /* Is the out buffer full (or is this the last one)? */
@@ -475,6 +479,11 @@ int cmd_dd(FAR struct nsh_vtbl_s *vtbl, int argc, char **argv)
   struct dd_s dd;
   char *infile = NULL;
   char *outfile = NULL;
+#ifdef CONFIG_NSH_CMDOPT_DD_STATS
+  uint32_t start;
+  uint32_t elapsed;
+  uint32_t total;
+#endif
   int ret = ERROR;
   int i;
 
@@ -575,6 +584,11 @@ int cmd_dd(FAR struct nsh_vtbl_s *vtbl, int argc, char **argv)
 
   /* Then perform the data transfer */
 
+#ifdef CONFIG_NSH_CMDOPT_DD_STATS
+  start = clock_systimer();
+  total = 0;
+#endif
+
   dd.sector = 0;
   while (!dd.eof && dd.nsectors > 0)
     {
@@ -610,6 +624,9 @@ int cmd_dd(FAR struct nsh_vtbl_s *vtbl, int argc, char **argv)
               /* Decrement to show that a sector was written */
 
               dd.nsectors--;
+#ifdef CONFIG_NSH_CMDOPT_DD_STATS
+              total += dd.sectsize;
+#endif
             }
 
           /* Increment the sector number */
@@ -617,6 +634,17 @@ int cmd_dd(FAR struct nsh_vtbl_s *vtbl, int argc, char **argv)
           dd.sector++;
         }
     }
+
+#ifdef CONFIG_NSH_CMDOPT_DD_STATS
+  /* Report the amount of data copied and the throughput.  Bytes per
+   * millisecond is the same as (decimal) kilobytes per second.
+   */
+
+  elapsed = TICK2MSEC(clock_systimer() - start);
+  nsh_output(vtbl, "%u bytes copied, %u msec, %u KB/s\n",
+             total, elapsed, elapsed > 0 ? total / elapsed : 0);
+#endif
+
   ret = OK;
 
 errout_with_outf:
@@ -40,6 +40,10 @@
 #include <nuttx/config.h>
 
 #include <stdlib.h>
+#include <string.h>
+
+#include <nuttx/mm.h>
+#include <nuttx/mempool.h>
 
 #include "nsh.h"
 
@@ -47,10 +51,52 @@
  * Definitions
  ****************************************************************************/
 
+#if defined(CONFIG_MM_TRACE) && !defined(CONFIG_NSH_DISABLE_HEAP)
+/* The number of tasks for which the heap command keeps totals.  Memory
+ * owned by any other task is counted in one extra entry.
+ */
+
+#  define NSH_HEAP_NTASKS CONFIG_MAX_TASKS
+
+/* The number of allocations that 'heap -a' collects in each walk of the
+ * heap before it prints them.
+ */
+
+#  define NSH_HEAP_NDUMP  32
+#endif
+
 /****************************************************************************
  * Private Types
  ****************************************************************************/
 
+#if defined(CONFIG_MM_TRACE) && !defined(CONFIG_NSH_DISABLE_HEAP)
+/* Heap usage of one task */
+
+struct heap_task_s
+{
+  pid_t    pid;
+  uint32_t nchunks;
+  size_t   nbytes;
+};
+
+/* Heap usage of all tasks */
+
+struct heap_usage_s
+{
+  int ntasks;
+  struct heap_task_s task[NSH_HEAP_NTASKS + 1];
+};
+
+/* One batch of allocations collected by 'heap -a' */
+
+struct heap_dump_s
+{
+  uint32_t skip;    /* Number of allocations to skip before collecting */
+  int      nrecs;   /* Number of allocations collected */
+  struct mm_traceinfo_s rec[NSH_HEAP_NDUMP];
+};
+#endif
+
 /****************************************************************************
  * Private Function Prototypes
  ****************************************************************************/
@@ -67,6 +113,89 @@
  * Private Functions
  ****************************************************************************/
 
+/****************************************************************************
+ * Name: mempool_callback
+ ****************************************************************************/
+
+#ifndef CONFIG_NSH_DISABLE_MEMPOOL
+static int mempool_callback(FAR struct mempool_s *pool, FAR void *arg)
+{
+  FAR struct nsh_vtbl_s *vtbl = (FAR struct nsh_vtbl_s*)arg;
+  struct mempoolinfo_s info;
+
+  mempool_stat(pool, &info);
+  nsh_output(vtbl, "%-12s%7d%7d%7d%7d%7d%8d\n",
+             info.name, (int)info.blocksize, info.nblocks,
+             info.nblocks - info.nfree, info.nblocks - info.nminfree,
+             info.nreserved, (int)info.nfailed);
+  return 0;
+}
+#endif
+
+/****************************************************************************
+ * Name: heap_dump_callback
+ ****************************************************************************/
+
+#if defined(CONFIG_MM_TRACE) && !defined(CONFIG_NSH_DISABLE_HEAP)
+static int heap_dump_callback(FAR const struct mm_traceinfo_s *info,
+                              FAR void *arg)
+{
+  FAR struct heap_dump_s *dump = (FAR struct heap_dump_s *)arg;
+
+  /* Skip the allocations that were printed from an earlier walk */
+
+  if (dump->skip > 0)
+    {
+      dump->skip--;
+      return 0;
+    }
+
+  /* Save this one and stop the walk when the batch is full */
+
+  dump->rec[dump->nrecs++] = *info;
+  return dump->nrecs >= NSH_HEAP_NDUMP;
+}
+#endif
+
+/****************************************************************************
+ * Name: heap_usage_callback
+ ****************************************************************************/
+
+#if defined(CONFIG_MM_TRACE) && !defined(CONFIG_NSH_DISABLE_HEAP)
+static int heap_usage_callback(FAR const struct mm_traceinfo_s *info,
+                               FAR void *arg)
+{
+  FAR struct heap_usage_s *usage = (FAR struct heap_usage_s *)arg;
+  FAR struct heap_task_s *task;
+  int i;
+
+  /* Find the entry for the task that owns the allocation, adding a new
+   * entry if necessary.  The extra entry at the end collects everything
+   * that does not fit.
+   */
+
+  for (i = 0; i < usage->ntasks && usage->task[i].pid != info->pid; i++);
+
+  if (i == usage->ntasks)
+    {
+      if (i < NSH_HEAP_NTASKS)
+        {
+          usage->ntasks++;
+          usage->task[i].pid = info->pid;
+        }
+      else
+        {
+          i = NSH_HEAP_NTASKS;
+        }
+    }
+
+  task = &usage->task[i];
+  task->nchunks++;
+  task->nbytes += info->size;
+  return 0;
+}
+#endif
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -93,3 +222,120 @@ int cmd_free(FAR struct nsh_vtbl_s *vtbl, int argc, char **argv)
   return OK;
 }
 #endif
+
+/****************************************************************************
+ * Name: cmd_mempool
+ ****************************************************************************/
+
+#ifndef CONFIG_NSH_DISABLE_MEMPOOL
+int cmd_mempool(FAR struct nsh_vtbl_s *vtbl, int argc, char **argv)
+{
+  nsh_output(vtbl, "Pool          Size  Total   Used   Peak  Rsrvd  Failed\n");
+  (void)mempool_foreach(mempool_callback, vtbl);
+  return OK;
+}
+#endif
+
+/****************************************************************************
+ * Name: cmd_heap
+ ****************************************************************************/
+
+#if defined(CONFIG_MM_TRACE) && !defined(CONFIG_NSH_DISABLE_HEAP)
+int cmd_heap(FAR struct nsh_vtbl_s *vtbl, int argc, char **argv)
+{
+  FAR struct heap_usage_s *usage;
+  FAR struct heap_dump_s *dump;
+  struct mm_freebin_s bins[MM_MAXBINS];
+  uint32_t ndumped;
+  int nbins;
+  int i;
+
+  /* 'heap -a' lists every allocation */
+
+  if (argc > 1)
+    {
+      if (strcmp(argv[1], "-a") != 0)
+        {
+          nsh_output(vtbl, g_fmtarginvalid, argv[0]);
+          return ERROR;
+        }
+
+      /* The walk holds the heap, so nothing can be printed from the
+       * callback.  Instead, collect the allocations in batches and print
+       * each batch after its walk has completed.
+       */
+
+      dump = (FAR struct heap_dump_s *)malloc(sizeof(struct heap_dump_s));
+      if (!dump)
+        {
+          nsh_output(vtbl, g_fmtcmdoutofmemory, argv[0]);
+          return ERROR;
+        }
+
+      nsh_output(vtbl, "  PID  Address        Size  Caller\n");
+      ndumped = 0;
+      do
+        {
+          dump->skip  = ndumped;
+          dump->nrecs = 0;
+          (void)mm_tracewalk(heap_dump_callback, dump);
+
+          for (i = 0; i < dump->nrecs; i++)
+            {
+              nsh_output(vtbl, "%5d  %p %8d  %p\n",
+                         dump->rec[i].pid, dump->rec[i].mem,
+                         (int)dump->rec[i].size, dump->rec[i].caller);
+            }
+
+          ndumped += dump->nrecs;
+        }
+      while (dump->nrecs >= NSH_HEAP_NDUMP);
+
+      free(dump);
+      return OK;
+    }
+
+  /* Otherwise, show the totals for each task and the free chunks.  The
+   * totals are collected before anything is printed because the walk
+   * holds the heap.
+   */
+
+  usage = (FAR struct heap_usage_s *)zalloc(sizeof(struct heap_usage_s));
+  if (!usage)
+    {
+      nsh_output(vtbl, g_fmtcmdoutofmemory, argv[0]);
+      return ERROR;
+    }
+
+  (void)mm_tracewalk(heap_usage_callback, usage);
+  nbins = mm_freebins(bins, MM_MAXBINS);
+
+  nsh_output(vtbl, "  PID   Chunks      Bytes\n");
+  for (i = 0; i < usage->ntasks; i++)
+    {
+      nsh_output(vtbl, "%5d %8d %10d\n", usage->task[i].pid,
+                 (int)usage->task[i].nchunks, (int)usage->task[i].nbytes);
+    }
+
+  if (usage->task[NSH_HEAP_NTASKS].nchunks > 0)
+    {
+      nsh_output(vtbl, "Other %8d %10d\n",
+                 (int)usage->task[NSH_HEAP_NTASKS].nchunks,
+                 (int)usage->task[NSH_HEAP_NTASKS].nbytes);
+    }
+
+  nsh_output(vtbl, "\nFree chunks:\n");
+  nsh_output(vtbl, "     Size   Chunks      Bytes\n");
+  for (i = 0; i < nbins; i++)
+    {
+      if (bins[i].nchunks > 0)
+        {
+          nsh_output(vtbl, "%8d+ %8d %10d\n", (int)bins[i].minsize,
+                     (int)bins[i].nchunks, (int)bins[i].nbytes);
+        }
+    }
+
+  free(usage);
+  return OK;
+}
+#endif
@@ -246,6 +246,16 @@ static inline void uip_statistics(FAR struct nsh_vtbl_s *vtbl)
 #endif
   nsh_output(vtbl, "\n");
 #endif
+
+  /* Lock contention:  The number of times that the uIP, device, and
+   * connection locks had to be waited for.
+   */
+
+#ifdef CONFIG_NET_NOINTS
+  nsh_output(vtbl, "\nLock waits  uIP  Dev  Conn\n");
+  nsh_output(vtbl, "            %04x %04x %04x\n",
+             uip_stat.lock.stack, uip_stat.lock.device, uip_stat.lock.conn);
+#endif
   nsh_output(vtbl, "\n");
 }
 #else
@@ -621,12 +631,12 @@ int cmd_ping(FAR struct nsh_vtbl_s *vtbl, int argc, char **argv)
   /* Loop for the specified count */
 
   nsh_output(vtbl, "PING %s %d bytes of data\n", staddr, DEFAULT_PING_DATALEN);
-  start = g_system_timer;
+  start = clock_systimer();
   for (i = 1; i <= count; i++)
     {
       /* Send the ECHO request and wait for the response */
 
-      next  = g_system_timer;
+      next  = clock_systimer();
       seqno = uip_ping(ipaddr, id, i, DEFAULT_PING_DATALEN, dsec);
 
       /* Was any response returned? We can tell if a non-negative sequence
@@ -640,7 +650,7 @@ int cmd_ping(FAR struct nsh_vtbl_s *vtbl, int argc, char **argv)
            * to an earlier request, then fudge the elpased time.
            */
 
-          elapsed = TICK2MSEC(g_system_timer - next);
+          elapsed = TICK2MSEC(clock_systimer() - next);
           if (seqno < i)
             {
               elapsed += 100*dsec*(i - seqno);
@@ -658,7 +668,7 @@ int cmd_ping(FAR struct nsh_vtbl_s *vtbl, int argc, char **argv)
        * to the current request!
        */
 
-      elapsed = TICK2DSEC(g_system_timer - next);
+      elapsed = TICK2DSEC(clock_systimer() - next);
       if (elapsed < dsec)
         {
           usleep(100000*dsec);
@@ -667,7 +677,7 @@ int cmd_ping(FAR struct nsh_vtbl_s *vtbl, int argc, char **argv)
 
   /* Get the total elapsed time */
 
-  elapsed = TICK2MSEC(g_system_timer - start);
+  elapsed = TICK2MSEC(clock_systimer() - start);
 
   /* Calculate the percentage of lost packets */
 
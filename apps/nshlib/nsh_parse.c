@@ -193,6 +193,12 @@ static const struct cmdmap_s g_cmdmap[] =
 # endif
 #endif
 
+#ifdef CONFIG_MM_TRACE
+# ifndef CONFIG_NSH_DISABLE_HEAP
+  { "heap",     cmd_heap,     1, 2, "[-a]" },
+# endif
+#endif
+
 #ifndef CONFIG_NSH_DISABLE_HELP
   { "help",     cmd_help,     1, 1, NULL },
 #endif
@@ -225,6 +231,10 @@ static const struct cmdmap_s g_cmdmap[] =
   { "mb",       cmd_mb,       2, 3, "<hex-address>[=<hex-value>][ <hex-byte-count>]" },
 #endif
 
+#ifndef CONFIG_NSH_DISABLE_MEMPOOL
+  { "mempool",  cmd_mempool,  1, 1, NULL },
+#endif
+
 #if !defined(CONFIG_DISABLE_MOUNTPOINT) && CONFIG_NFILE_DESCRIPTORS > 0 && defined(CONFIG_FS_WRITABLE)
 # ifndef CONFIG_NSH_DISABLE_MKDIR
   { "mkdir",    cmd_mkdir,    2, 2, "<path>" },
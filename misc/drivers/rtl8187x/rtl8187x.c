@@ -1466,7 +1466,7 @@ static int rtl8187x_disconnected(struct usbhost_class_s *class)
 
       ullvdbg("Queuing destruction: worker %p->%p\n", priv->wkdisconn.worker, rtl8187x_destroy);
       DEBUGASSERT(priv->wkdisconn.worker == NULL);
-      (void)work_queue(&priv->wkdisconn, rtl8187x_destroy, priv, 0);
+      (void)work_queue(LPWORK, &priv->wkdisconn, rtl8187x_destroy, priv, 0);
     }
 
   irqrestore(flags);  
@@ -2008,7 +2008,7 @@ static void rtl8187x_txpollwork(FAR void *arg)
 
       /* Estimate the elapsed time in hsecs since the last poll */
 
-      now            = g_system_timer;
+      now            = clock_systimer();
       hsecs          = (priv->lastpoll - now + CLK_TCK / 4) / (CLK_TCK / 2);
       priv->lastpoll = now;
 
@@ -2064,7 +2064,7 @@ static void rtl8187x_txpolltimer(int argc, uint32_t arg, ...)
         }
       else
         {
-          (void)work_queue(&priv->wktxpoll, rtl8187x_txpollwork, priv, 0);
+          (void)work_queue(HPWORK, &priv->wktxpoll, rtl8187x_txpollwork, priv, 0);
         }
     }
 
@@ -2388,7 +2388,7 @@ static void rtl8187x_rxpolltimer(int argc, uint32_t arg, ...)
         }
       else
         {
-          (void)work_queue(&priv->wkrxpoll, rtl8187x_rxpollwork, priv, 0);
+          (void)work_queue(HPWORK, &priv->wkrxpoll, rtl8187x_rxpollwork, priv, 0);
         }
     }
 
@@ -2431,7 +2431,7 @@ static int rtl8187x_ifup(struct uip_driver_s *dev)
       /* Set up and activate TX timer processes */
 
       (void)wd_start(priv->wdtxpoll, RTL8187X_TXDELAY, rtl8187x_txpolltimer, 1, (uint32_t)priv);
-      priv->lastpoll = g_system_timer;
+      priv->lastpoll = clock_systimer();
 
       /* Set up and activate RX timer processes */
 
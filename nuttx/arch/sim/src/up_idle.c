@@ -62,12 +62,9 @@ static int g_x11refresh = 0;
  * Public Function Prototypes
  ****************************************************************************/
 
-#if defined(CONFIG_SIM_WALLTIME) || defined(CONFIG_SIM_X11FB)
-extern int up_hostusleep(unsigned int usec);
 #ifdef CONFIG_SIM_X11FB
 extern void up_x11update(void);
 #endif
-#endif
 
 /****************************************************************************
  * Private Functions
@@ -95,10 +92,15 @@ extern void up_x11update(void);
 void up_idle(void)
 {
   /* If the system is idle, then process "fake" timer interrupts.
-   * Hopefully, something will wake up.
+   * Hopefully, something will wake up.  In the tickless mode, there is
+   * only the simulated interval timer to check.
    */
 
+#ifdef CONFIG_SCHED_TICKLESS
+  up_timer_update();
+#else
   sched_process_timer();
+#endif
 
   /* Run the network if enabled */
 
@@ -129,7 +131,9 @@ void up_idle(void)
    */
 
 #if defined(CONFIG_SIM_WALLTIME) || defined(CONFIG_SIM_X11FB)
+#if !defined(CONFIG_SCHED_TICKLESS) || !defined(CONFIG_SIM_WALLTIME)
   (void)up_hostusleep(1000000 / CLK_TCK);
+#endif
 
   /* Handle X11-related events */
 
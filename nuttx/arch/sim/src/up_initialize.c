@@ -103,6 +103,10 @@ void up_initialize(void)
   up_registerblockdevice(); /* Our FAT ramdisk at /dev/ram0 */
 #endif
 
+#ifdef CONFIG_SIM_SDIO
+  up_sdioinitialize();      /* Our simulated SD card at /dev/mmcsd0 */
+#endif
+
 #ifdef CONFIG_NET
   uipdriver_init();         /* Our "real" netwok driver */
 #endif
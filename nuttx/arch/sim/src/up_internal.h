@@ -141,11 +141,33 @@ extern void up_registerblockdevice(void);
 
 extern char *up_deviceimage(void);
 
+/* up_sdio.c **************************************************************/
+
+#ifdef CONFIG_SIM_SDIO
+extern int up_sdioinitialize(void);
+#endif
+
 /* up_stdio.c *************************************************************/
 
 extern size_t up_hostread(void *buffer, size_t len);
 extern size_t up_hostwrite(const void *buffer, size_t len);
 
+/* up_hostusleep.c ********************************************************/
+
+extern int up_hostusleep(unsigned int usec);
+
+/* up_hosttime.c **********************************************************/
+
+#ifdef CONFIG_SCHED_TICKLESS
+extern unsigned long long up_hosttime(void);
+#endif
+
+/* up_tickless.c **********************************************************/
+
+#ifdef CONFIG_SCHED_TICKLESS
+extern void up_timer_update(void);
+#endif
+
 /* up_netdev.c ************************************************************/
 
 #ifdef CONFIG_NET
@@ -183,10 +205,14 @@ extern int up_buttonevent(int x, int y, int buttons);
 extern void tapdev_init(void);
 extern unsigned int tapdev_read(unsigned char *buf, unsigned int buflen);
 extern void tapdev_send(unsigned char *buf, unsigned int buflen);
+extern void tapdev_sendv(unsigned char *hdr, unsigned int hdrlen,
+                         const unsigned char *data, unsigned int datalen);
 
 #define netdev_init()           tapdev_init()
 #define netdev_read(buf,buflen) tapdev_read(buf,buflen)
 #define netdev_send(buf,buflen) tapdev_send(buf,buflen)
+#define netdev_sendv(hdr,hdrlen,data,datalen) \
+  tapdev_sendv(hdr,hdrlen,data,datalen)
 #endif
 
 /* up_wpcap.c *************************************************************/
@@ -0,0 +1,1107 @@
+/****************************************************************************
+ * arch/sim/src/up_sdio.c
+ *
+ *   Copyright (C) 2012 Gregory Nutt. All rights reserved.
+ *   Author: Gregory Nutt <spudmonkey@racsa.co.cr>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name NuttX nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/types.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <debug.h>
+
+#include <nuttx/kmalloc.h>
+#include <nuttx/sdio.h>
+#include <nuttx/mmcsd.h>
+
+#include "up_internal.h"
+
+#ifdef CONFIG_SIM_SDIO
+
+/****************************************************************************
+ * Private Definitions
+ ****************************************************************************/
+
+/* Configuration ************************************************************/
+/* CONFIG_SIM_SDIO_NBLOCKS - Size of the simulated SD card in 512 byte
+ *   blocks.  Rounded up to a multiple of 1024 blocks (512KB).  Default:
+ *   4096 (2MB).
+ * CONFIG_SIM_SDIO_KBPS - If non-zero, each data transfer takes as long as
+ *   it would on a bus with this rate (in KB/s) so that transfer rates can
+ *   be observed with CONFIG_SCHED_TICKLESS and CONFIG_SIM_WALLTIME.
+ *   Default: 0 (no delay).
+ * CONFIG_SIM_SDIO_NSG - The maximum number of memory segments in one
+ *   scatter/gather DMA.  Default: 16
+ */
+
+#ifndef CONFIG_SIM_SDIO_NBLOCKS
+#  define CONFIG_SIM_SDIO_NBLOCKS 4096
+#endif
+
+#ifndef CONFIG_SIM_SDIO_KBPS
+#  define CONFIG_SIM_SDIO_KBPS 0
+#endif
+
+#ifndef CONFIG_SIM_SDIO_NSG
+#  define CONFIG_SIM_SDIO_NSG 16
+#endif
+
+#ifdef CONFIG_SDIO_DMASG
+#  define SIM_NSG CONFIG_SIM_SDIO_NSG
+#else
+#  define SIM_NSG 1
+#endif
+
+/* The simulated card is an SD version 2.x card with block addressing */
+
+#define SIM_BLOCKSHIFT        9
+#define SIM_BLOCKSIZE         (1 << SIM_BLOCKSHIFT)
+#define SIM_NBLOCKS           ((CONFIG_SIM_SDIO_NBLOCKS + 1023) & ~1023)
+#define SIM_RCA               0x1234
+
+/* Number of CMD13 status requests for which the card remains busy after
+ * a write.
+ */
+
+#define SIM_PRGPOLLS          2
+
+/* R1 card status */
+
+#define SIM_R1_OUTOFRANGE     ((uint32_t)1 << 31)
+#define SIM_R1_ILLEGALCOMMAND ((uint32_t)1 << 22)
+#define SIM_R1_STATE_SHIFT    9
+#define SIM_R1_READYFORDATA   ((uint32_t)1 << 8)
+#define SIM_R1_APPCMD         ((uint32_t)1 << 5)
+
+/* Card states */
+
+#define SIM_STATE_IDLE        0
+#define SIM_STATE_READY       1
+#define SIM_STATE_IDENT       2
+#define SIM_STATE_STBY        3
+#define SIM_STATE_TRAN        4
+#define SIM_STATE_DATA        5
+#define SIM_STATE_RCV         6
+#define SIM_STATE_PRG         7
+
+/* OCR */
+
+#define SIM_OCR_VOLTAGES      ((uint32_t)0x00ff8000)  /* 2.7-3.6V */
+#define SIM_OCR_CCS           ((uint32_t)1 << 30)     /* Card capacity status */
+#define SIM_OCR_POWERUP       ((uint32_t)1 << 31)     /* Power-up complete */
+#define SIM_ACMD41_HCS        ((uint32_t)1 << 30)     /* Host capacity support */
+
+/* Pending data transfers */
+
+#define SIM_XFR_NONE          0
+#define SIM_XFR_READ          1                       /* CMD17 or CMD18 */
+#define SIM_XFR_WRITE         2                       /* CMD24 or CMD25 */
+#define SIM_XFR_SCR           3                       /* ACMD51 */
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+/* This structure holds the state of the simulated SDIO interface and of the
+ * SD card in the slot.
+ */
+
+struct sim_sdio_s
+{
+  struct sdio_dev_s dev;           /* Standard SDIO interface (must be first) */
+
+  /* Card state */
+
+  FAR uint8_t *image;              /* The contents of the card */
+  uint8_t  state;                  /* Current card state (SIM_STATE_*) */
+  uint8_t  prgpolls;               /* Status requests until programming ends */
+  bool     appcmd;                 /* The next command is an ACMD */
+  bool     hcs;                    /* The host supports high capacity */
+  uint16_t rca;                    /* Relative card address */
+  uint16_t blocklen;               /* Block length selected by CMD16 */
+  uint32_t errors;                 /* Error bits for the next R1 status */
+
+  /* Command/response */
+
+  int      rsperr;                 /* Error for the last command (or OK) */
+  uint32_t response[4];            /* Response to the last command */
+
+  /* Data transfer */
+
+  uint8_t  xfrtype;                /* Pending data transfer (SIM_XFR_*) */
+  bool     multiple;               /* CMD18 or CMD25 */
+  bool     bufready;               /* The memory for the transfer is set up */
+  uint32_t xfrblock;               /* Next block of the transfer */
+  uint8_t  nsg;                    /* Number of memory segments */
+  struct sdio_sg_s sg[SIM_NSG];    /* Memory segments */
+  sdio_eventset_t waitevents;      /* Enabled wait events */
+
+  /* Scatter/gather DMA list prepared by sim_dmaprepare */
+
+#ifdef CONFIG_SDIO_DMASG
+  FAR const struct sdio_sg_s *prepared;
+#endif
+
+  /* Media change callback */
+
+  worker_t callback;               /* Registered callback function */
+  FAR void *cbarg;                 /* Argument to pass to the callback */
+  sdio_eventset_t cbevents;        /* Enabled callback events */
+};
+
+/****************************************************************************
+ * Private Function Prototypes
+ ****************************************************************************/
+
+/* Initialization/setup */
+
+static void sim_reset(FAR struct sdio_dev_s *dev);
+static uint8_t sim_status(FAR struct sdio_dev_s *dev);
+static void sim_widebus(FAR struct sdio_dev_s *dev, bool enable);
+static void sim_clock(FAR struct sdio_dev_s *dev, enum sdio_clock_e rate);
+static int  sim_attach(FAR struct sdio_dev_s *dev);
+
+/* Command/Status/Data Transfer */
+
+static int  sim_sendcmd(FAR struct sdio_dev_s *dev, uint32_t cmd,
+              uint32_t arg);
+#ifdef CONFIG_SDIO_BLOCKSETUP
+static void sim_blocksetup(FAR struct sdio_dev_s *dev, unsigned int blocklen,
+              unsigned int nblocks);
+#endif
+static int  sim_recvsetup(FAR struct sdio_dev_s *dev, FAR uint8_t *buffer,
+              size_t nbytes);
+static int  sim_sendsetup(FAR struct sdio_dev_s *dev,
+              FAR const uint8_t *buffer, size_t nbytes);
+static int  sim_cancel(FAR struct sdio_dev_s *dev);
+static int  sim_waitresponse(FAR struct sdio_dev_s *dev, uint32_t cmd);
+static int  sim_recvshort(FAR struct sdio_dev_s *dev, uint32_t cmd,
+              FAR uint32_t *rshort);
+static int  sim_recvlong(FAR struct sdio_dev_s *dev, uint32_t cmd,
+              uint32_t rlong[4]);
+
+/* Event/Callback support */
+
+static void sim_waitenable(FAR struct sdio_dev_s *dev,
+              sdio_eventset_t eventset);
+static sdio_eventset_t sim_eventwait(FAR struct sdio_dev_s *dev,
+              uint32_t timeout);
+static void sim_callbackenable(FAR struct sdio_dev_s *dev,
+              sdio_eventset_t eventset);
+static int  sim_registercallback(FAR struct sdio_dev_s *dev,
+              worker_t callback, void *arg);
+
+/* DMA */
+
+#ifdef CONFIG_SDIO_DMA
+static bool sim_dmasupported(FAR struct sdio_dev_s *dev);
+static int  sim_dmarecvsetup(FAR struct sdio_dev_s *dev,
+              FAR uint8_t *buffer, size_t buflen);
+static int  sim_dmasendsetup(FAR struct sdio_dev_s *dev,
+              FAR const uint8_t *buffer, size_t buflen);
+#endif
+#ifdef CONFIG_SDIO_DMASG
+static int  sim_dmaprepare(FAR struct sdio_dev_s *dev,
+              FAR const struct sdio_sg_s *sg, int nsg, bool write);
+static int  sim_dmarecvsgsetup(FAR struct sdio_dev_s *dev,
+              FAR const struct sdio_sg_s *sg, int nsg);
+static int  sim_dmasendsgsetup(FAR struct sdio_dev_s *dev,
+              FAR const struct sdio_sg_s *sg, int nsg);
+#endif
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static struct sim_sdio_s g_simsdio =
+{
+  .dev =
+  {
+#ifdef CONFIG_SDIO_MUXBUS
+    .lock             = NULL,
+#endif
+    .reset            = sim_reset,
+    .status           = sim_status,
+    .widebus          = sim_widebus,
+    .clock            = sim_clock,
+    .attach           = sim_attach,
+    .sendcmd          = sim_sendcmd,
+#ifdef CONFIG_SDIO_BLOCKSETUP
+    .blocksetup       = sim_blocksetup,
+#endif
+    .recvsetup        = sim_recvsetup,
+    .sendsetup        = sim_sendsetup,
+    .cancel           = sim_cancel,
+    .waitresponse     = sim_waitresponse,
+    .recvR1           = sim_recvshort,
+    .recvR2           = sim_recvlong,
+    .recvR3           = sim_recvshort,
+    .recvR4           = sim_recvshort,
+    .recvR5           = sim_recvshort,
+    .recvR6           = sim_recvshort,
+    .recvR7           = sim_recvshort,
+    .waitenable       = sim_waitenable,
+    .eventwait        = sim_eventwait,
+    .callbackenable   = sim_callbackenable,
+    .registercallback = sim_registercallback,
+#ifdef CONFIG_SDIO_DMA
+    .dmasupported     = sim_dmasupported,
+    .dmarecvsetup     = sim_dmarecvsetup,
+    .dmasendsetup     = sim_dmasendsetup,
+#endif
+#ifdef CONFIG_SDIO_DMASG
+    .dmaprepare       = sim_dmaprepare,
+    .dmarecvsgsetup   = sim_dmarecvsgsetup,
+    .dmasendsgsetup   = sim_dmasendsgsetup,
+#endif
+  },
+};
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: sim_r1
+ *
+ * Description:
+ *   Return the R1 card status.  R1 reports the state of the card when the
+ *   command was received, so this must be called before the state changes.
+ *   Error bits are reported once.
+ *
+ ****************************************************************************/
+
+static uint32_t sim_r1(FAR struct sim_sdio_s *priv)
+{
+  uint32_t r1 = priv->errors | ((uint32_t)priv->state << SIM_R1_STATE_SHIFT);
+
+  if (priv->state == SIM_STATE_TRAN)
+    {
+      r1 |= SIM_R1_READYFORDATA;
+    }
+
+  if (priv->appcmd)
+    {
+      r1 |= SIM_R1_APPCMD;
+    }
+
+  priv->errors = 0;
+  return r1;
+}
+
+/****************************************************************************
+ * Name: sim_setsg
+ *
+ * Description:
+ *   Set up the memory for the pending data transfer.
+ *
+ ****************************************************************************/
+
+static int sim_setsg(FAR struct sim_sdio_s *priv,
+                     FAR const struct sdio_sg_s *sg, int nsg)
+{
+  if (nsg < 1 || nsg > SIM_NSG)
+    {
+      return -EINVAL;
+    }
+
+  memcpy(priv->sg, sg, nsg * sizeof(struct sdio_sg_s));
+  priv->nsg      = nsg;
+  priv->bufready = true;
+  return OK;
+}
+
+/****************************************************************************
+ * Name: sim_datacmd
+ *
+ * Description:
+ *   Accept a read or write command.
+ *
+ ****************************************************************************/
+
+static void sim_datacmd(FAR struct sim_sdio_s *priv, uint8_t xfrtype,
+                        bool multiple, uint32_t arg)
+{
+  if (priv->state != SIM_STATE_TRAN || priv->blocklen != SIM_BLOCKSIZE)
+    {
+      priv->errors |= SIM_R1_ILLEGALCOMMAND;
+      priv->response[0] = sim_r1(priv);
+      return;
+    }
+
+  /* The card is block addressed */
+
+  if (arg >= SIM_NBLOCKS)
+    {
+      priv->errors |= SIM_R1_OUTOFRANGE;
+      priv->response[0] = sim_r1(priv);
+      return;
+    }
+
+  priv->response[0] = sim_r1(priv);
+  priv->xfrtype     = xfrtype;
+  priv->multiple    = multiple;
+  priv->xfrblock    = arg;
+  priv->state       = xfrtype == SIM_XFR_READ ? SIM_STATE_DATA : SIM_STATE_RCV;
+}
+
+/****************************************************************************
+ * Name: sim_xfrdata
+ *
+ * Description:
+ *   Perform the pending data transfer between the card and memory.
+ *
+ * Returned Value:
+ *   The wait event that ends the transfer
+ *
+ ****************************************************************************/
+
+static sdio_eventset_t sim_xfrdata(FAR struct sim_sdio_s *priv)
+{
+  FAR uint8_t *card;
+  size_t nbytes = 0;
+  int i;
+
+  /* The SCR is eight bytes sent in big-endian order:  SCR version 1.0, SD
+   * physical layer version 2.0, and 1- and 4-bit buses supported.
+   */
+
+  if (priv->xfrtype == SIM_XFR_SCR)
+    {
+      static const uint8_t scr[8] = { 0x02, 0x05, 0, 0, 0, 0, 0, 0 };
+
+      memcpy(priv->sg[0].buffer, scr,
+             priv->sg[0].buflen < 8 ? priv->sg[0].buflen : 8);
+      priv->state   = SIM_STATE_TRAN;
+      priv->xfrtype = SIM_XFR_NONE;
+      return SDIOWAIT_TRANSFERDONE;
+    }
+
+  for (i = 0; i < priv->nsg; i++)
+    {
+      nbytes += priv->sg[i].buflen;
+    }
+
+  if ((nbytes & (SIM_BLOCKSIZE - 1)) != 0 ||
+      priv->xfrblock + (nbytes >> SIM_BLOCKSHIFT) > SIM_NBLOCKS ||
+      (!priv->multiple && nbytes != SIM_BLOCKSIZE))
+    {
+      fdbg("ERROR: Bad transfer: block %d nbytes %d\n",
+           priv->xfrblock, nbytes);
+      priv->xfrtype = SIM_XFR_NONE;
+      priv->state   = SIM_STATE_TRAN;
+      return SDIOWAIT_ERROR;
+    }
+
+  /* Move the data */
+
+  card = &priv->image[priv->xfrblock << SIM_BLOCKSHIFT];
+  for (i = 0; i < priv->nsg; i++)
+    {
+      if (priv->xfrtype == SIM_XFR_READ)
+        {
+          memcpy(priv->sg[i].buffer, card, priv->sg[i].buflen);
+        }
+      else
+        {
+          memcpy(card, priv->sg[i].buffer, priv->sg[i].buflen);
+        }
+
+      card += priv->sg[i].buflen;
+    }
+
+  priv->xfrblock += nbytes >> SIM_BLOCKSHIFT;
+
+  /* Take as long as the data would take on the bus */
+
+#if CONFIG_SIM_SDIO_KBPS > 0
+  up_hostusleep((unsigned int)(((uint64_t)nbytes * 1000000) /
+                               ((uint64_t)CONFIG_SIM_SDIO_KBPS * 1024)));
+#endif
+
+  /* A single block transfer ends by itself; a multiple block transfer ends
+   * with CMD12.
+   */
+
+  if (!priv->multiple)
+    {
+      priv->xfrtype  = SIM_XFR_NONE;
+      if (priv->state == SIM_STATE_RCV)
+        {
+          priv->state    = SIM_STATE_PRG;
+          priv->prgpolls = SIM_PRGPOLLS;
+        }
+      else
+        {
+          priv->state    = SIM_STATE_TRAN;
+        }
+    }
+
+  return SDIOWAIT_TRANSFERDONE;
+}
+
+/****************************************************************************
+ * Initialization/setup
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: sim_reset
+ *
+ * Description:
+ *   Reset the SDIO controller.  Undo all setup.
+ *
+ ****************************************************************************/
+
+static void sim_reset(FAR struct sdio_dev_s *dev)
+{
+  FAR struct sim_sdio_s *priv = (FAR struct sim_sdio_s *)dev;
+
+  priv->xfrtype    = SIM_XFR_NONE;
+  priv->bufready   = false;
+  priv->waitevents = 0;
+  priv->cbevents   = 0;
+}
+
+/****************************************************************************
+ * Name: sim_status
+ *
+ * Description:
+ *   Get SDIO status.  The simulated card is always present and never write
+ *   protected.
+ *
+ ****************************************************************************/
+
+static uint8_t sim_status(FAR struct sdio_dev_s *dev)
+{
+  return SDIO_STATUS_PRESENT;
+}
+
+/****************************************************************************
+ * Name: sim_widebus
+ *
+ * Description:
+ *   Called after change in Bus width has been selected (via ACMD6).  There
+ *   is nothing to do in the simulation.
+ *
+ ****************************************************************************/
+
+static void sim_widebus(FAR struct sdio_dev_s *dev, bool enable)
+{
+}
+
+/****************************************************************************
+ * Name: sim_clock
+ *
+ * Description:
+ *   Enable/disable SDIO clocking.  There is nothing to do in the
+ *   simulation.
+ *
+ ****************************************************************************/
+
+static void sim_clock(FAR struct sdio_dev_s *dev, enum sdio_clock_e rate)
+{
+}
+
+/****************************************************************************
+ * Name: sim_attach
+ *
+ * Description:
+ *   Attach and prepare interrupts.  There are no interrupts in the
+ *   simulation.
+ *
+ ****************************************************************************/
+
+static int sim_attach(FAR struct sdio_dev_s *dev)
+{
+  return OK;
+}
+
+/****************************************************************************
+ * Command/Status/Data Transfer
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: sim_sendcmd
+ *
+ * Description:
+ *   Send the SDIO command to the simulated card.  The card processes the
+ *   command immediately and the response is kept until it is received.
+ *
+ ****************************************************************************/
+
+static int sim_sendcmd(FAR struct sdio_dev_s *dev, uint32_t cmd, uint32_t arg)
+{
+  FAR struct sim_sdio_s *priv = (FAR struct sim_sdio_s *)dev;
+  uint32_t cmdidx = (cmd & MMCSD_CMDIDX_MASK) >> MMCSD_CMDIDX_SHIFT;
+  bool appcmd = priv->appcmd;
+
+  priv->rsperr = OK;
+  memset(priv->response, 0, sizeof(priv->response));
+
+  /* Application specific commands */
+
+  if (appcmd)
+    {
+      switch (cmdidx)
+        {
+        case SD_ACMDIDX6:   /* SET_BUS_WIDTH */
+        case SD_ACMDIDX23:  /* SET_WR_BLK_ERASE_COUNT */
+        case SD_ACMDIDX42:  /* SET_CLR_CARD_DETECT */
+          priv->response[0] = sim_r1(priv);
+          break;
+
+        case SD_ACMDIDX41:  /* SD_SEND_OP_COND */
+          priv->hcs         = (arg & SIM_ACMD41_HCS) != 0;
+          priv->response[0] = SIM_OCR_POWERUP | SIM_OCR_VOLTAGES |
+                              (priv->hcs ? SIM_OCR_CCS : 0);
+          priv->state       = SIM_STATE_READY;
+          break;
+
+        case SD_ACMDIDX51:  /* SEND_SCR */
+          priv->response[0] = sim_r1(priv);
+          priv->xfrtype     = SIM_XFR_SCR;
+          priv->state       = SIM_STATE_DATA;
+          break;
+
+        default:
+          priv->rsperr = -ETIMEDOUT;
+          break;
+        }
+
+      priv->appcmd = false;
+      return OK;
+    }
+
+  /* Standard commands */
+
+  switch (cmdidx)
+    {
+    case MMCSD_CMDIDX0:     /* GO_IDLE_STATE */
+      priv->state   = SIM_STATE_IDLE;
+      priv->rca     = 0;
+      priv->xfrtype = SIM_XFR_NONE;
+      break;
+
+    case MMCSD_CMDIDX2:     /* ALL_SEND_CID */
+      if (priv->state != SIM_STATE_READY)
+        {
+          priv->rsperr = -ETIMEDOUT;
+          break;
+        }
+
+      /* Manufacturer 0x00, OEM "NX", product "SIMSD", revision 1.0 */
+
+      priv->response[0] = 0x004e5853;
+      priv->response[1] = 0x494d5344;
+      priv->response[2] = 0x10000000;
+      priv->response[3] = 0x0000c001;
+      priv->state       = SIM_STATE_IDENT;
+      break;
+
+    case SD_CMDIDX3:        /* SEND_RELATIVE_ADDR */
+      if (priv->state != SIM_STATE_IDENT)
+        {
+          priv->rsperr = -ETIMEDOUT;
+          break;
+        }
+
+      priv->rca         = SIM_RCA;
+      priv->response[0] = ((uint32_t)priv->rca << 16) |
+                          ((uint32_t)priv->state << SIM_R1_STATE_SHIFT);
+      priv->state       = SIM_STATE_STBY;
+      break;
+
+    case MMCSD_CMDIDX7:     /* SELECT/DESELECT_CARD */
+      priv->response[0] = sim_r1(priv);
+      if ((arg >> 16) == priv->rca && priv->state == SIM_STATE_STBY)
+        {
+          priv->state = SIM_STATE_TRAN;
+        }
+      else if ((arg >> 16) != priv->rca && priv->state == SIM_STATE_TRAN)
+        {
+          priv->state = SIM_STATE_STBY;
+        }
+      break;
+
+    case SD_CMDIDX8:        /* SEND_IF_COND */
+      if (priv->state != SIM_STATE_IDLE)
+        {
+          priv->rsperr = -ETIMEDOUT;
+          break;
+        }
+
+      priv->response[0] = arg & 0x0fff;
+      break;
+
+    case MMCSD_CMDIDX9:     /* SEND_CSD */
+      if (priv->state != SIM_STATE_STBY || (arg >> 16) != priv->rca)
+        {
+          priv->rsperr = -ETIMEDOUT;
+          break;
+        }
+
+      /* CSD version 2.0:  TAAC 1ms, 25MHz, command classes 0x5b5, 512 byte
+       * blocks and C_SIZE = capacity / 512KB - 1.
+       */
+
+      priv->response[0] = 0x400e0032;
+      priv->response[1] = 0x5b590000 | (((SIM_NBLOCKS >> 10) - 1) >> 16);
+      priv->response[2] = ((((SIM_NBLOCKS >> 10) - 1) & 0xffff) << 16) |
+                          0x7f80;
+      priv->response[3] = 0x0a400000;
+      break;
+
+    case MMCSD_CMDIDX12:    /* STOP_TRANSMISSION */
+      priv->response[0] = sim_r1(priv);
+      if (priv->state == SIM_STATE_DATA)
+        {
+          priv->state    = SIM_STATE_TRAN;
+        }
+      else if (priv->state == SIM_STATE_RCV)
+        {
+          priv->state    = SIM_STATE_PRG;
+          priv->prgpolls = SIM_PRGPOLLS;
+        }
+
+      priv->xfrtype  = SIM_XFR_NONE;
+      priv->bufready = false;
+      break;
+
+    case MMCSD_CMDIDX13:    /* SEND_STATUS */
+      if ((arg >> 16) != priv->rca)
+        {
+          priv->rsperr = -ETIMEDOUT;
+          break;
+        }
+
+      priv->response[0] = sim_r1(priv);
+      if (priv->state == SIM_STATE_PRG && --priv->prgpolls == 0)
+        {
+          priv->state = SIM_STATE_TRAN;
+        }
+      break;
+
+    case MMCSD_CMDIDX16:    /* SET_BLOCKLEN */
+      priv->response[0] = sim_r1(priv);
+      priv->blocklen    = arg;
+      break;
+
+    case MMCSD_CMDIDX17:    /* READ_SINGLE_BLOCK */
+    case MMCSD_CMDIDX18:    /* READ_MULTIPLE_BLOCK */
+      sim_datacmd(priv, SIM_XFR_READ, cmdidx == MMCSD_CMDIDX18, arg);
+      break;
+
+    case MMCSD_CMDIDX24:    /* WRITE_BLOCK */
+    case MMCSD_CMDIDX25:    /* WRITE_MULTIPLE_BLOCK */
+      sim_datacmd(priv, SIM_XFR_WRITE, cmdidx == MMCSD_CMDIDX25, arg);
+      break;
+
+    case SD_CMDIDX55:       /* APP_CMD */
+      if ((arg >> 16) != priv->rca)
+        {
+          priv->rsperr = -ETIMEDOUT;
+          break;
+        }
+
+      priv->appcmd      = true;
+      priv->response[0] = sim_r1(priv);
+      break;
+
+    default:                /* Not supported by SD memory cards (e.g., CMD1) */
+      priv->rsperr = -ETIMEDOUT;
+      break;
+    }
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: sim_blocksetup
+ *
+ * Description:
+ *   Configure block size and the number of blocks for next transfer.  The
+ *   simulation gets this from the size of the memory.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_SDIO_BLOCKSETUP
+static void sim_blocksetup(FAR struct sdio_dev_s *dev, unsigned int blocklen,
+                           unsigned int nblocks)
+{
+}
+#endif
+
+/****************************************************************************
+ * Name: sim_recvsetup
+ *
+ * Description:
+ *   Setup hardware in preparation for data transfer from the card.
+ *
+ ****************************************************************************/
+
+static int sim_recvsetup(FAR struct sdio_dev_s *dev, FAR uint8_t *buffer,
+                         size_t nbytes)
+{
+  struct sdio_sg_s sg;
+
+  sg.buffer = buffer;
+  sg.buflen = nbytes;
+  return sim_setsg((FAR struct sim_sdio_s *)dev, &sg, 1);
+}
+
+/****************************************************************************
+ * Name: sim_sendsetup
+ *
+ * Description:
+ *   Setup hardware in preparation for data transfer to the card.
+ *
+ ****************************************************************************/
+
+static int sim_sendsetup(FAR struct sdio_dev_s *dev, FAR const uint8_t *buffer,
+                         size_t nbytes)
+{
+  struct sdio_sg_s sg;
+
+  sg.buffer = (FAR uint8_t *)buffer;
+  sg.buflen = nbytes;
+  return sim_setsg((FAR struct sim_sdio_s *)dev, &sg, 1);
+}
+
+/****************************************************************************
+ * Name: sim_cancel
+ *
+ * Description:
+ *   Cancel the data transfer setup of SDIO_RECVSETUP, SDIO_SENDSETUP,
+ *   SDIO_DMARECVSETUP or SDIO_DMASENDSETUP.
+ *
+ ****************************************************************************/
+
+static int sim_cancel(FAR struct sdio_dev_s *dev)
+{
+  FAR struct sim_sdio_s *priv = (FAR struct sim_sdio_s *)dev;
+
+  priv->bufready   = false;
+  priv->waitevents = 0;
+  return OK;
+}
+
+/****************************************************************************
+ * Name: sim_waitresponse
+ *
+ * Description:
+ *   Poll-wait for the response to the last command to be ready.
+ *
+ ****************************************************************************/
+
+static int sim_waitresponse(FAR struct sdio_dev_s *dev, uint32_t cmd)
+{
+  FAR struct sim_sdio_s *priv = (FAR struct sim_sdio_s *)dev;
+
+  if ((cmd & MMCSD_RESPONSE_MASK) == MMCSD_NO_RESPONSE)
+    {
+      return OK;
+    }
+
+  return priv->rsperr;
+}
+
+/****************************************************************************
+ * Name: sim_recvshort and sim_recvlong
+ *
+ * Description:
+ *   Receive the response to the last command
+ *
+ ****************************************************************************/
+
+static int sim_recvshort(FAR struct sdio_dev_s *dev, uint32_t cmd,
+                         FAR uint32_t *rshort)
+{
+  FAR struct sim_sdio_s *priv = (FAR struct sim_sdio_s *)dev;
+
+  if (priv->rsperr == OK && rshort)
+    {
+      *rshort = priv->response[0];
+    }
+
+  return priv->rsperr;
+}
+
+static int sim_recvlong(FAR struct sdio_dev_s *dev, uint32_t cmd,
+                        uint32_t rlong[4])
+{
+  FAR struct sim_sdio_s *priv = (FAR struct sim_sdio_s *)dev;
+
+  if (priv->rsperr == OK && rlong)
+    {
+      memcpy(rlong, priv->response, 4 * sizeof(uint32_t));
+    }
+
+  return priv->rsperr;
+}
+
+/****************************************************************************
+ * Event/Callback support
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: sim_waitenable
+ *
+ * Description:
+ *   Enable/disable of a set of SDIO wait events.
+ *
+ ****************************************************************************/
+
+static void sim_waitenable(FAR struct sdio_dev_s *dev,
+                           sdio_eventset_t eventset)
+{
+  FAR struct sim_sdio_s *priv = (FAR struct sim_sdio_s *)dev;
+  priv->waitevents = eventset;
+}
+
+/****************************************************************************
+ * Name: sim_eventwait
+ *
+ * Description:
+ *   Wait for one of the enabled events to occur (or a timeout).  The data
+ *   of the pending transfer is moved now.
+ *
+ ****************************************************************************/
+
+static sdio_eventset_t sim_eventwait(FAR struct sdio_dev_s *dev,
+                                     uint32_t timeout)
+{
+  FAR struct sim_sdio_s *priv = (FAR struct sim_sdio_s *)dev;
+  sdio_eventset_t events = SDIOWAIT_TIMEOUT;
+
+  if (priv->xfrtype != SIM_XFR_NONE && priv->bufready)
+    {
+      events         = sim_xfrdata(priv);
+      priv->bufready = false;
+    }
+
+  events          &= (priv->waitevents | SDIOWAIT_TIMEOUT);
+  priv->waitevents = 0;
+  return events ? events : SDIOWAIT_TIMEOUT;
+}
+
+/****************************************************************************
+ * Name: sim_callbackenable
+ *
+ * Description:
+ *   Enable/disable of a set of SDIO callback events.  The simulated card is
+ *   never inserted or removed so no callbacks are ever made.
+ *
+ ****************************************************************************/
+
+static void sim_callbackenable(FAR struct sdio_dev_s *dev,
+                               sdio_eventset_t eventset)
+{
+  FAR struct sim_sdio_s *priv = (FAR struct sim_sdio_s *)dev;
+  priv->cbevents = eventset;
+}
+
+/****************************************************************************
+ * Name: sim_registercallback
+ *
+ * Description:
+ *   Register a callback that that will be invoked on any media status
+ *   change.
+ *
+ ****************************************************************************/
+
+static int sim_registercallback(FAR struct sdio_dev_s *dev,
+                                worker_t callback, void *arg)
+{
+  FAR struct sim_sdio_s *priv = (FAR struct sim_sdio_s *)dev;
+
+  priv->cbevents = 0;
+  priv->cbarg    = arg;
+  priv->callback = callback;
+  return OK;
+}
+
+/****************************************************************************
+ * DMA
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: sim_dmasupported
+ *
+ * Description:
+ *   Return true if the hardware can support DMA
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_SDIO_DMA
+static bool sim_dmasupported(FAR struct sdio_dev_s *dev)
+{
+  return true;
+}
+#endif
+
+/****************************************************************************
+ * Name: sim_dmarecvsetup and sim_dmasendsetup
+ *
+ * Description:
+ *   Setup to perform a read or write DMA.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_SDIO_DMA
+static int sim_dmarecvsetup(FAR struct sdio_dev_s *dev, FAR uint8_t *buffer,
+                            size_t buflen)
+{
+  return sim_recvsetup(dev, buffer, buflen);
+}
+
+static int sim_dmasendsetup(FAR struct sdio_dev_s *dev,
+                            FAR const uint8_t *buffer, size_t buflen)
+{
+  return sim_sendsetup(dev, buffer, buflen);
+}
+#endif
+
+/****************************************************************************
+ * Name: sim_dmaprepare
+ *
+ * Description:
+ *   Prepare a scatter/gather list for a following DMA.  Real hardware would
+ *   build its descriptor chain and perform cache maintenance here.  The
+ *   simulation only checks the list and remembers it.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_SDIO_DMASG
+static int sim_dmaprepare(FAR struct sdio_dev_s *dev,
+                          FAR const struct sdio_sg_s *sg, int nsg,
+                          bool write)
+{
+  FAR struct sim_sdio_s *priv = (FAR struct sim_sdio_s *)dev;
+  int i;
+
+  if (nsg < 1 || nsg > SIM_NSG)
+    {
+      return -EINVAL;
+    }
+
+  for (i = 0; i < nsg; i++)
+    {
+      if (sg[i].buffer == NULL || (sg[i].buflen & (SIM_BLOCKSIZE - 1)) != 0)
+        {
+          return -EINVAL;
+        }
+    }
+
+  priv->prepared = sg;
+  return OK;
+}
+
+/****************************************************************************
+ * Name: sim_dmarecvsgsetup and sim_dmasendsgsetup
+ *
+ * Description:
+ *   Setup to perform a scatter/gather read or write DMA.
+ *
+ ****************************************************************************/
+
+static int sim_dmarecvsgsetup(FAR struct sdio_dev_s *dev,
+                              FAR const struct sdio_sg_s *sg, int nsg)
+{
+  FAR struct sim_sdio_s *priv = (FAR struct sim_sdio_s *)dev;
+  int ret = OK;
+
+  if (priv->prepared != sg)
+    {
+      ret = sim_dmaprepare(dev, sg, nsg, false);
+    }
+
+  priv->prepared = NULL;
+  return ret == OK ? sim_setsg(priv, sg, nsg) : ret;
+}
+
+static int sim_dmasendsgsetup(FAR struct sdio_dev_s *dev,
+                              FAR const struct sdio_sg_s *sg, int nsg)
+{
+  FAR struct sim_sdio_s *priv = (FAR struct sim_sdio_s *)dev;
+  int ret = OK;
+
+  if (priv->prepared != sg)
+    {
+      ret = sim_dmaprepare(dev, sg, nsg, true);
+    }
+
+  priv->prepared = NULL;
+  return ret == OK ? sim_setsg(priv, sg, nsg) : ret;
+}
+#endif
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: up_sdioinitialize
+ *
+ * Description:
+ *   Create the simulated SD card and register it as /dev/mmcsd0 through the
+ *   SDIO-based MMC/SD driver.
+ *
+ ****************************************************************************/
+
+int up_sdioinitialize(void)
+{
+  FAR struct sim_sdio_s *priv = &g_simsdio;
+  int ret;
+
+  priv->image = (FAR uint8_t *)kzalloc(SIM_NBLOCKS << SIM_BLOCKSHIFT);
+  if (!priv->image)
+    {
+      return -ENOMEM;
+    }
+
+  ret = mmcsd_slotinitialize(0, &priv->dev);
+  if (ret < 0)
+    {
+      fdbg("ERROR: Failed to bind the simulated SD card: %d\n", ret);
+    }
+
+  return ret;
+}
+
+#endif /* CONFIG_SIM_SDIO */
@@ -266,6 +266,39 @@ void tapdev_send(unsigned char *buf, unsigned int buflen)
   dump_ethhdr("write", buf, buflen);
 }
 
+void tapdev_sendv(unsigned char *hdr, unsigned int hdrlen,
+                  const unsigned char *data, unsigned int datalen)
+{
+  struct iovec iov[2];
+  int ret;
+
+#ifdef TAPDEV_DEBUG
+  lib_rawprintf("tapdev_sendv: sending %d+%d bytes\n", hdrlen, datalen);
+
+  gdrop++;
+  if(gdrop % 8 == 7)
+    {
+      lib_rawprintf("Dropped a packet!\n");
+      return;
+    }
+#endif
+
+  /* Send the headers and the data as one packet without copying them */
+
+  iov[0].iov_base = hdr;
+  iov[0].iov_len  = hdrlen;
+  iov[1].iov_base = (void *)data;
+  iov[1].iov_len  = datalen;
+
+  ret = writev(gtapdevfd, iov, 2);
+  if (ret < 0)
+    {
+      lib_rawprintf("TAPDEV: writev failed: %d", -ret);
+      exit(1);
+    }
+  dump_ethhdr("writev", hdr, hdrlen + datalen);
+}
+
 #endif /* !__CYGWIN__ */
 
 
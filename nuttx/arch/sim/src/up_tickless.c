@@ -0,0 +1,230 @@
+/****************************************************************************
+ * arch/sim/src/up_tickless.c
+ *
+ *   Copyright (C) 2012 Gregory Nutt. All rights reserved.
+ *   Author: Gregory Nutt <gnutt@nuttx.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name NuttX nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+
+#include <nuttx/arch.h>
+#include <nuttx/clock.h>
+
+#include "up_internal.h"
+
+#ifdef CONFIG_SCHED_TICKLESS
+
+/****************************************************************************
+ * Private Definitions
+ ****************************************************************************/
+
+/* With CONFIG_SIM_WALLTIME, the IDLE loop sleeps on the host until the
+ * interval timer expires.  If the network or the X11 display must also be
+ * serviced from the IDLE loop, then the sleep is limited to one tick.
+ */
+
+#if defined(CONFIG_NET) || defined(CONFIG_SIM_X11FB)
+#  define SIM_MAXSLEEP_NSEC NSEC_PER_TICK
+#else
+#  define SIM_MAXSLEEP_NSEC NSEC_PER_SEC
+#endif
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static uint64_t g_simtime;   /* Current time (nanoseconds since boot) */
+static uint64_t g_deadline;  /* Time when the interval timer expires */
+static bool     g_armed;     /* True: the interval timer is running */
+
+#ifdef CONFIG_SIM_WALLTIME
+static uint64_t g_hostbase;  /* Host time when the time base was started */
+#endif
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: up_timer_now
+ *
+ * Description:
+ *   Return the current time in nanoseconds.  With CONFIG_SIM_WALLTIME, this
+ *   follows the host's monotonic clock.  Otherwise, time is simulated and
+ *   advances only when the IDLE loop reaches an interval timer deadline.
+ *
+ ****************************************************************************/
+
+static inline uint64_t up_timer_now(void)
+{
+#ifdef CONFIG_SIM_WALLTIME
+  g_simtime = up_hosttime() - g_hostbase;
+#endif
+  return g_simtime;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: up_timer_initialize
+ *
+ * Description:
+ *   Initialize the simulated time base and interval timer.
+ *
+ ****************************************************************************/
+
+void up_timer_initialize(void)
+{
+#ifdef CONFIG_SIM_WALLTIME
+  g_hostbase = up_hosttime();
+#endif
+  g_simtime  = 0;
+  g_armed    = false;
+}
+
+/****************************************************************************
+ * Name: up_timer_gettime
+ *
+ * Description:
+ *   Return the elapsed time since the time base was initialized.
+ *
+ ****************************************************************************/
+
+int up_timer_gettime(FAR struct timespec *ts)
+{
+  uint64_t now = up_timer_now();
+
+  ts->tv_sec  = (time_t)(now / NSEC_PER_SEC);
+  ts->tv_nsec = (long)(now % NSEC_PER_SEC);
+  return OK;
+}
+
+/****************************************************************************
+ * Name: up_timer_cancel
+ *
+ * Description:
+ *   Stop the interval timer and return the time remaining.
+ *
+ ****************************************************************************/
+
+int up_timer_cancel(FAR struct timespec *ts)
+{
+  uint64_t now = up_timer_now();
+  uint64_t remaining = 0;
+
+  if (g_armed && g_deadline > now)
+    {
+      remaining = g_deadline - now;
+    }
+
+  g_armed = false;
+
+  if (ts)
+    {
+      ts->tv_sec  = (time_t)(remaining / NSEC_PER_SEC);
+      ts->tv_nsec = (long)(remaining % NSEC_PER_SEC);
+    }
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: up_timer_start
+ *
+ * Description:
+ *   Start the interval timer.  Expiration is detected by up_timer_update()
+ *   in the IDLE loop.
+ *
+ ****************************************************************************/
+
+int up_timer_start(FAR const struct timespec *ts)
+{
+  g_deadline = up_timer_now() + (uint64_t)ts->tv_sec * NSEC_PER_SEC +
+               ts->tv_nsec;
+  g_armed    = true;
+  return OK;
+}
+
+/****************************************************************************
+ * Name: up_timer_update
+ *
+ * Description:
+ *   Called from the IDLE loop to simulate the interval timer interrupt.
+ *   Since the system is idle, nothing can happen before the interval
+ *   timer expires:  With CONFIG_SIM_WALLTIME, the host sleeps until then;
+ *   otherwise, the simulated time simply jumps forward to the deadline.
+ *
+ ****************************************************************************/
+
+void up_timer_update(void)
+{
+  uint64_t now = up_timer_now();
+
+#ifdef CONFIG_SIM_WALLTIME
+  uint64_t sleep = SIM_MAXSLEEP_NSEC;
+
+  if (g_armed && g_deadline > now && g_deadline - now < sleep)
+    {
+      sleep = g_deadline - now;
+    }
+
+  if (!g_armed || g_deadline > now)
+    {
+      (void)up_hostusleep((unsigned int)(sleep / NSEC_PER_USEC));
+      now = up_timer_now();
+    }
+#else
+  if (g_armed && g_deadline > now)
+    {
+      g_simtime = g_deadline;
+      now = g_deadline;
+    }
+#endif
+
+  if (g_armed && g_deadline <= now)
+    {
+      g_armed = false;
+      sched_timer_expiration();
+    }
+}
+
+#endif /* CONFIG_SCHED_TICKLESS */
@@ -85,6 +85,7 @@ struct timer
 
 static struct timer g_periodic_timer;
 static struct uip_driver_s g_sim_dev;
+static volatile bool g_txavail;
 
 /****************************************************************************
  * Private Functions
@@ -115,6 +116,38 @@ static inline int up_comparemac(uint8_t *paddr1, struct ether_addr *paddr2)
 }
 #endif
 
+/****************************************************************************
+ * Function: sim_send
+ *
+ * Description:
+ *   Send the outgoing packet in g_sim_dev.  With CONFIG_NET_SGSEND, the
+ *   TCP data of the packet may be in a separate buffer.  If the host
+ *   network interface cannot gather the two parts, then the data is copied
+ *   into d_buf after the headers.
+ *
+ ****************************************************************************/
+
+static void sim_send(void)
+{
+#ifdef CONFIG_NET_SGSEND
+  if (g_sim_dev.d_sgdata)
+    {
+      unsigned int hdrlen = g_sim_dev.d_len - g_sim_dev.d_sndlen;
+
+#ifdef netdev_sendv
+      netdev_sendv(g_sim_dev.d_buf, hdrlen, g_sim_dev.d_sgdata,
+                   g_sim_dev.d_sndlen);
+      return;
+#else
+      memcpy(&g_sim_dev.d_buf[hdrlen], g_sim_dev.d_sgdata,
+             g_sim_dev.d_sndlen);
+#endif
+    }
+#endif
+
+  netdev_send(g_sim_dev.d_buf, g_sim_dev.d_len);
+}
+
 static int sim_uiptxpoll(struct uip_driver_s *dev)
 {
   /* If the polling resulted in data that should be sent out on the network,
@@ -124,7 +157,7 @@ static int sim_uiptxpoll(struct uip_driver_s *dev)
   if (g_sim_dev.d_len > 0)
     {
       uip_arp_out(&g_sim_dev);
-      netdev_send(g_sim_dev.d_buf, g_sim_dev.d_len);
+      sim_send();
     }
 
   /* If zero is returned, the polling will continue until all connections have
@@ -134,12 +167,33 @@ static int sim_uiptxpoll(struct uip_driver_s *dev)
   return 0;
 }
 
+static int sim_txavail(struct uip_driver_s *dev)
+{
+  /* Poll for the new TX data the next time that uipdriver_loop() runs */
+
+  g_txavail = true;
+  return OK;
+}
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
 
 void uipdriver_loop(void)
 {
+#ifdef CONFIG_NET_NOINTS
+  /* This logic runs on the IDLE thread which must never wait.  If uIP is
+   * busy, then try again on the next pass through the IDLE loop.  Holding
+   * the lock here also makes the uip_lock() calls in uip_input() and the
+   * others succeed without waiting.
+   */
+
+  if (uip_trylock() != OK)
+    {
+      return;
+    }
+#endif
+
   /* netdev_read will return 0 on a timeout event and >0 on a data received event */
 
   g_sim_dev.d_len = netdev_read((unsigned char*)g_sim_dev.d_buf, CONFIG_NET_BUFSIZE);
@@ -177,8 +231,16 @@ void uipdriver_loop(void)
               if (g_sim_dev.d_len > 0)
                 {
                   uip_arp_out(&g_sim_dev);
-                  netdev_send(g_sim_dev.d_buf, g_sim_dev.d_len);
+                  sim_send();
                 }
+
+              /* The host interface is ready for more packets.  Poll for
+               * more TX data as a real driver does when a transmission
+               * completes.  An incoming ACK may have opened the way for
+               * more data.
+               */
+
+              uip_poll(&g_sim_dev, sim_uiptxpoll);
             }
           else if (BUF->ether_type == htons(UIP_ETHTYPE_ARP))
             {
@@ -204,7 +266,19 @@ void uipdriver_loop(void)
       timer_reset(&g_periodic_timer);
       uip_timer(&g_sim_dev, sim_uiptxpoll, 1);
     }
+
+  /* Or new TX data may be available */
+
+  else if (g_txavail)
+    {
+      g_txavail = false;
+      uip_poll(&g_sim_dev, sim_uiptxpoll);
+    }
   sched_unlock();
+
+#ifdef CONFIG_NET_NOINTS
+  uip_unlock(0);
+#endif
 }
 
 int uipdriver_init(void)
@@ -214,6 +288,8 @@ int uipdriver_init(void)
   timer_set(&g_periodic_timer, 500);
   netdev_init();
 
+  g_sim_dev.d_txavail = sim_txavail;
+
   /* Register the device with the OS so that socket IOCTLs can be performed */
 
   (void)netdev_register(&g_sim_dev);
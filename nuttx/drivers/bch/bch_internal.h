@@ -52,9 +52,32 @@
  * Pre-processor Definitions
  ****************************************************************************/
 
+/* Configuration ************************************************************/
+/* CONFIG_BCH_NCACHESECTORS - The number of sectors in the sector cache.
+ *   The cache holds a run of consecutive sectors so that sequential
+ *   accesses can be read ahead and dirty sectors can be written back with
+ *   one block driver transfer.  Default: 4
+ */
+
+#ifndef CONFIG_BCH_NCACHESECTORS
+#  define CONFIG_BCH_NCACHESECTORS 4
+#endif
+
+#if CONFIG_BCH_NCACHESECTORS < 1
+#  undef  CONFIG_BCH_NCACHESECTORS
+#  define CONFIG_BCH_NCACHESECTORS 1
+#endif
+
 #define bchlib_semgive(d) sem_post(&(d)->sem)  /* To match bchlib_semtake */
 #define MAX_OPENCNT     (255)                  /* Limit of uint8_t */
 
+/* Return the address of a sector in the cache.  The sector must have been
+ * brought into the cache with bchlib_readsector().
+ */
+
+#define bchlib_cachedsector(d,s) \
+  (&(d)->buffer[((s) - (d)->sector) * (d)->sectsize])
+
 /****************************************************************************
  * Public Types
  ****************************************************************************/
@@ -64,12 +87,16 @@ struct bchlib_s
   struct inode *inode; /* I-node of the block driver */
   sem_t    sem;        /* For atomic accesses to this structure */
   size_t   nsectors;   /* Number of sectors supported by the device */
-  size_t   sector;     /* The current sector in the buffer */
+  size_t   sector;     /* The first sector in the cache */
   uint16_t sectsize;   /* The size of one sector on the device */
+  uint16_t ncached;    /* Number of valid sectors in the cache */
+  uint16_t dirtyfirst; /* First dirty sector (relative to sector) */
+  uint16_t dirtylast;  /* Last dirty sector (relative to sector) */
   uint8_t  refs;       /* Number of references */
-  bool  dirty;         /* Data has been written to the buffer */
+  bool  dirty;         /* Data has been written to the cache */
   bool  readonly;      /* true:  Only read operations are supported */
-  FAR uint8_t *buffer; /* One sector buffer */
+  FAR uint8_t *buffer; /* CONFIG_BCH_NCACHESECTORS sector cache */
+  struct bch_stats_s stats; /* Cache and transfer statistics */
 };
 
 /****************************************************************************
@@ -91,8 +118,19 @@ EXTERN const struct file_operations bch_fops;
  ****************************************************************************/
 
 EXTERN void bchlib_semtake(FAR struct bchlib_s *bch);
-EXTERN int  bchlib_flushsector(FAR struct bchlib_s *bch);
+EXTERN ssize_t bchlib_devread(FAR struct bchlib_s *bch, FAR uint8_t *buffer,
+                              size_t sector, size_t nsectors);
+EXTERN ssize_t bchlib_devwrite(FAR struct bchlib_s *bch,
+                               FAR const uint8_t *buffer, size_t sector,
+                               size_t nsectors);
+EXTERN int  bchlib_flushcache(FAR struct bchlib_s *bch);
 EXTERN int  bchlib_readsector(FAR struct bchlib_s *bch, size_t sector);
+EXTERN void bchlib_markdirty(FAR struct bchlib_s *bch, size_t sector);
+EXTERN void bchlib_cacheread(FAR struct bchlib_s *bch, FAR uint8_t *buffer,
+                             size_t sector, size_t nsectors);
+EXTERN void bchlib_cachewrite(FAR struct bchlib_s *bch,
+                              FAR const uint8_t *buffer, size_t sector,
+                              size_t nsectors);
 
 #undef EXTERN
 #if defined(__cplusplus)
@@ -137,15 +137,17 @@ static int bch_close(FAR struct file *filp)
 {
   FAR struct inode *inode = filp->f_inode;
   FAR struct bchlib_s *bch;
-  int ret = OK;
+  int ret;
 
   DEBUGASSERT(inode && inode->i_private);
   bch = (FAR struct bchlib_s *)inode->i_private;
 
-  /* Flush any dirty pages remaining in the cache */
+  /* Flush any dirty pages remaining in the cache.  The file is closed even
+   * if the flush fails, but the error is reported.
+   */
 
   bchlib_semtake(bch);
-  (void)bchlib_flushsector(bch);
+  ret = bchlib_flushcache(bch);
 
   /* Decrement the reference count (I don't use bchlib_decref() because I
    * want the entire close operation to be atomic wrt other driver operations.
@@ -181,7 +183,7 @@ static ssize_t bch_read(FAR struct file *filp, FAR char *buffer, size_t len)
   ret = bchlib_read(bch, buffer, filp->f_pos, len);
   if (ret > 0)
     {
-      filp->f_pos += len;
+      filp->f_pos += ret;
     }
   bchlib_semgive(bch);
   return ret;
@@ -206,7 +208,7 @@ static ssize_t bch_write(FAR struct file *filp, FAR const char *buffer, size_t l
       ret = bchlib_write(bch, buffer, filp->f_pos, len);
       if (ret > 0)
         {
-          filp->f_pos += len;
+          filp->f_pos += ret;
         }
       bchlib_semgive(bch);
     }
@@ -217,7 +219,8 @@ static ssize_t bch_write(FAR struct file *filp, FAR const char *buffer, size_t l
 /****************************************************************************
  * Name: bch_ioctl
  *
- * Description: Return device geometry
+ * Description: Return a reference to the BCH state structure or the
+ *   sector cache statistics
  *
  ****************************************************************************/
 
@@ -246,6 +249,24 @@ static int bch_ioctl(FAR struct file *filp, int cmd, unsigned long arg)
         }
       bchlib_semgive(bch);
     }
+  else if (cmd == DIOC_BCHSTATS)
+    {
+      FAR struct bch_stats_s *stats = (FAR struct bch_stats_s *)((uintptr_t)arg);
+
+      if (!stats)
+        {
+          ret = -EINVAL;
+        }
+      else
+        {
+          bchlib_semtake(bch);
+          memcpy(stats, &bch->stats, sizeof(struct bch_stats_s));
+          stats->bs_nsectors   = CONFIG_BCH_NCACHESECTORS;
+          stats->bs_sectorsize = bch->sectsize;
+          bchlib_semgive(bch);
+          ret = OK;
+        }
+    }
 
   return ret;
 }
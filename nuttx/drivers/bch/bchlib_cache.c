@@ -40,7 +40,9 @@
 #include <nuttx/config.h>
 
 #include <sys/types.h>
+#include <stdint.h>
 #include <stdbool.h>
+#include <string.h>
 #include <errno.h>
 #include <assert.h>
 #include <debug.h>
@@ -65,36 +67,100 @@
  * Private Functions
  ****************************************************************************/
 
+/****************************************************************************
+ * Name: bchlib_invalidate
+ *
+ * Description:
+ *   Discard the contents of the cache (which must not be dirty)
+ *
+ ****************************************************************************/
+
+static inline void bchlib_invalidate(FAR struct bchlib_s *bch)
+{
+  bch->sector  = (size_t)-1;
+  bch->ncached = 0;
+}
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
 
 /****************************************************************************
- * Name: bchlib_flushsector
+ * Name: bchlib_devread and bchlib_devwrite
+ *
+ * Description:
+ *   Read or write sectors with the block driver.  All transfers to and
+ *   from the device go through here so that they are counted.
+ *
+ ****************************************************************************/
+
+ssize_t bchlib_devread(FAR struct bchlib_s *bch, FAR uint8_t *buffer,
+                       size_t sector, size_t nsectors)
+{
+  FAR struct inode *inode = bch->inode;
+  ssize_t ret;
+
+  ret = inode->u.i_bops->read(inode, buffer, sector, nsectors);
+  bch->stats.bs_nreads++;
+  if (ret > 0)
+    {
+      bch->stats.bs_rdsectors += ret;
+    }
+
+  return ret;
+}
+
+ssize_t bchlib_devwrite(FAR struct bchlib_s *bch, FAR const uint8_t *buffer,
+                        size_t sector, size_t nsectors)
+{
+  FAR struct inode *inode = bch->inode;
+  ssize_t ret;
+
+  ret = inode->u.i_bops->write(inode, buffer, sector, nsectors);
+  bch->stats.bs_nwrites++;
+  if (ret > 0)
+    {
+      bch->stats.bs_wrsectors += ret;
+    }
+
+  return ret;
+}
+
+/****************************************************************************
+ * Name: bchlib_flushcache
  *
  * Description:
- *   Flush the current contents of the sector buffer (if dirty)
+ *   Write the dirty sectors in the cache back to the device.  All of the
+ *   sectors from the first to the last dirty sector are written with one
+ *   transfer; clean sectors in between are simply written again.  If the
+ *   write fails, the sectors stay dirty so that the flush can be retried.
  *
  * Assumptions:
  *   Caller must assume mutual exclusion
  *
  ****************************************************************************/
 
-int bchlib_flushsector(FAR struct bchlib_s *bch)
+int bchlib_flushcache(FAR struct bchlib_s *bch)
 {
-  FAR struct inode *inode;
+  size_t nsectors;
   ssize_t ret = OK;
 
   if (bch->dirty)
     {
-      inode = bch->inode;
-      ret = inode->u.i_bops->write(inode, bch->buffer, bch->sector, 1);
+      nsectors = bch->dirtylast - bch->dirtyfirst + 1;
+      ret = bchlib_devwrite(bch, &bch->buffer[bch->dirtyfirst * bch->sectsize],
+                            bch->sector + bch->dirtyfirst, nsectors);
       if (ret < 0)
         {
-          fdbg("Write failed: %d\n");
+          fdbg("Write failed: %d\n", ret);
+        }
+      else
+        {
+          bch->dirty = false;
+          ret = OK;
         }
-      bch->dirty = false;
     }
+
   return (int)ret;
 }
 
@@ -102,7 +168,13 @@ int bchlib_flushsector(FAR struct bchlib_s *bch)
  * Name: bchlib_readsector
  *
  * Description:
- *   Flush the current contents of the sector buffer (if dirty)
+ *   Make sure that the sector is in the cache.  A sector at or just after
+ *   the end of the cached sectors is a sequential access:  The cache is
+ *   filled with that sector and as many of the following sectors as fit
+ *   with one transfer.  Any other sector replaces the contents of the cache
+ *   with just that sector so that random accesses do not read data that is
+ *   not needed.  When sequential access continues after the cache has been
+ *   filled, the cache is re-filled starting with the next sector.
  *
  * Assumptions:
  *   Caller must assume mutual exclusion
@@ -111,23 +183,200 @@ int bchlib_flushsector(FAR struct bchlib_s *bch)
 
 int bchlib_readsector(FAR struct bchlib_s *bch, size_t sector)
 {
-  FAR struct inode *inode;
-  ssize_t ret = OK;
+  size_t first;
+  size_t nsectors;
+  size_t end;
+  ssize_t ret;
+
+  /* Is the sector already in the cache? */
+
+  end = bch->sector + bch->ncached;
+  if (bch->ncached > 0 && sector >= bch->sector && sector < end)
+    {
+      bch->stats.bs_hits++;
+      return OK;
+    }
+
+  bch->stats.bs_misses++;
 
-  if (bch->sector != sector)
+  if (bch->ncached > 0 && sector >= end &&
+      sector < bch->sector + CONFIG_BCH_NCACHESECTORS)
     {
-      inode = bch->inode;
+      /* The sector follows the cached sectors and there is room for it:
+       * Extend the cache, reading ahead to the end of the cache.  Dirty
+       * sectors are not affected.
+       */
 
-      (void)bchlib_flushsector(bch);
-      bch->sector = (size_t)-1;
+      first    = end;
+      nsectors = bch->sector + CONFIG_BCH_NCACHESECTORS - first;
+    }
+  else
+    {
+      /* Replace the contents of the cache.  Read ahead only if this
+       * continues a sequential access that filled the cache.
+       */
 
-      ret = inode->u.i_bops->read(inode, bch->buffer, sector, 1);
+      ret = bchlib_flushcache(bch);
       if (ret < 0)
         {
-          fdbg("Read failed: %d\n");
+          /* Keep the cache and its dirty sectors */
+
+          return (int)ret;
         }
+
+      nsectors = (bch->ncached > 0 && sector == end) ?
+                 CONFIG_BCH_NCACHESECTORS : 1;
+
+      bchlib_invalidate(bch);
       bch->sector = sector;
+      first       = sector;
     }
-  return (int)ret;
+
+  if (first + nsectors > bch->nsectors)
+    {
+      nsectors = bch->nsectors - first;
+    }
+
+  /* The sectors before the missed sector in the transfer are those that
+   * were skipped over; those after it are read ahead.
+   */
+
+  bch->stats.bs_readahead += first + nsectors - sector - 1;
+
+  ret = bchlib_devread(bch, bchlib_cachedsector(bch, first), first, nsectors);
+  if (ret < 0 || (size_t)ret < sector - first + 1)
+    {
+      fdbg("Read failed: %d\n", ret);
+
+      /* A failed read-ahead does not affect the sectors already cached */
+
+      if (bch->ncached == 0)
+        {
+          bchlib_invalidate(bch);
+        }
+
+      return ret < 0 ? (int)ret : -EIO;
+    }
+
+  bch->ncached = first + ret - bch->sector;
+  return OK;
 }
 
+/****************************************************************************
+ * Name: bchlib_markdirty
+ *
+ * Description:
+ *   Mark a cached sector as modified
+ *
+ * Assumptions:
+ *   Caller must assume mutual exclusion.  The sector is in the cache.
+ *
+ ****************************************************************************/
+
+void bchlib_markdirty(FAR struct bchlib_s *bch, size_t sector)
+{
+  uint16_t index = sector - bch->sector;
+
+  DEBUGASSERT(sector >= bch->sector && index < bch->ncached);
+
+  if (!bch->dirty)
+    {
+      bch->dirtyfirst = index;
+      bch->dirtylast  = index;
+      bch->dirty      = true;
+    }
+  else if (index < bch->dirtyfirst)
+    {
+      bch->dirtyfirst = index;
+    }
+  else if (index > bch->dirtylast)
+    {
+      bch->dirtylast = index;
+    }
+}
+
+/****************************************************************************
+ * Name: bchlib_cacheread
+ *
+ * Description:
+ *   Whole sectors are read directly from the device into the user buffer.
+ *   If any of those sectors are dirty in the cache, then the device holds
+ *   old data:  Copy the newer, cached data into the user buffer.
+ *
+ * Assumptions:
+ *   Caller must assume mutual exclusion
+ *
+ ****************************************************************************/
+
+void bchlib_cacheread(FAR struct bchlib_s *bch, FAR uint8_t *buffer,
+                      size_t sector, size_t nsectors)
+{
+  size_t first;
+  size_t last;
+
+  if (bch->dirty)
+    {
+      first = bch->sector + bch->dirtyfirst;
+      last  = bch->sector + bch->dirtylast;
+
+      if (first < sector)
+        {
+          first = sector;
+        }
+
+      if (last > sector + nsectors - 1)
+        {
+          last = sector + nsectors - 1;
+        }
+
+      if (first <= last)
+        {
+          memcpy(&buffer[(first - sector) * bch->sectsize],
+                 bchlib_cachedsector(bch, first),
+                 (last - first + 1) * bch->sectsize);
+        }
+    }
+}
+
+/****************************************************************************
+ * Name: bchlib_cachewrite
+ *
+ * Description:
+ *   Whole sectors are written directly from the user buffer to the device.
+ *   Update any copies of those sectors in the cache so that the cache does
+ *   not hold (or later write back) old data.
+ *
+ * Assumptions:
+ *   Caller must assume mutual exclusion
+ *
+ ****************************************************************************/
+
+void bchlib_cachewrite(FAR struct bchlib_s *bch, FAR const uint8_t *buffer,
+                       size_t sector, size_t nsectors)
+{
+  size_t first;
+  size_t last;
+
+  if (bch->ncached > 0)
+    {
+      first = bch->sector;
+      last  = bch->sector + bch->ncached - 1;
+
+      if (first < sector)
+        {
+          first = sector;
+        }
+
+      if (last > sector + nsectors - 1)
+        {
+          last = sector + nsectors - 1;
+        }
+
+      if (first <= last)
+        {
+          memcpy(bchlib_cachedsector(bch, first),
+                 &buffer[(first - sector) * bch->sectsize],
+                 (last - first + 1) * bch->sectsize);
+        }
+    }
+}
@@ -73,14 +73,15 @@
  * Name: bchlib_teardown
  *
  * Description:
- *   Setup so that the block driver referenced by 'blkdev' can be accessed
- *   similar to a character device.
+ *   Flush the cache, close the block driver and free the state set up by
+ *   bchlib_setup().  Returns the result of the flush.
  *
  ****************************************************************************/
 
 int bchlib_teardown(FAR void *handle)
 {
   FAR struct bchlib_s *bch = (FAR struct bchlib_s *)handle;
+  int ret;
 
   DEBUGASSERT(handle);
 
@@ -91,9 +92,11 @@ int bchlib_teardown(FAR void *handle)
       return -EBUSY;
     }
 
-  /* Flush any pending data to the block driver */
+  /* Flush any pending data to the block driver.  The driver is torn down
+   * even if the flush fails, but the error is reported.
+   */
 
-  bchlib_flushsector(bch);
+  ret = bchlib_flushcache(bch);
 
   /* Close the block driver */
 
@@ -108,6 +111,6 @@ int bchlib_teardown(FAR void *handle)
 
   sem_destroy(&bch->sem);
   kfree(bch);
-  return OK;
+  return ret;
 }
 
@@ -112,9 +112,13 @@ ssize_t bchlib_write(FAR void *handle, FAR const char *buffer, size_t offset, si
   byteswritten = 0;
   if (sectoffset > 0)
     {
-      /* Read the full sector into the sector buffer */
+      /* Read the full sector into the sector cache */
 
-      bchlib_readsector(bch, sector);
+      ret = bchlib_readsector(bch, sector);
+      if (ret < 0)
+        {
+          return ret;
+        }
 
       /* Copy the tail end of the sector from the user buffer */
 
@@ -127,8 +131,8 @@ ssize_t bchlib_write(FAR void *handle, FAR const char *buffer, size_t offset, si
           nbytes = len;
         }
 
-      memcpy(&bch->buffer[sectoffset], buffer, nbytes);
-      bch->dirty = true;
+      memcpy(bchlib_cachedsector(bch, sector) + sectoffset, buffer, nbytes);
+      bchlib_markdirty(bch, sector);
 
       /* Adjust pointers and counts */
 
@@ -157,16 +161,17 @@ ssize_t bchlib_write(FAR void *handle, FAR const char *buffer, size_t offset, si
           nsectors = bch->nsectors - sector;
         }
 
-      /* Write the contiguous sectors */
+      /* Write the contiguous sectors and update any cached copies */
 
-      ret = bch->inode->u.i_bops->write(bch->inode, (FAR uint8_t *)buffer,
-                                        sector, nsectors);
+      ret = bchlib_devwrite(bch, (FAR const uint8_t *)buffer, sector, nsectors);
       if (ret < 0)
         {
           fdbg("Write failed: %d\n", ret);
-          return ret;
+          return byteswritten > 0 ? byteswritten : ret;
         }
 
+      bchlib_cachewrite(bch, (FAR const uint8_t *)buffer, sector, nsectors);
+
       /* Adjust pointers and counts */
 
       sectoffset    = 0;
@@ -188,29 +193,29 @@ ssize_t bchlib_write(FAR void *handle, FAR const char *buffer, size_t offset, si
 
   if (len > 0)
     {
-      /* Read the sector into the sector buffer */
+      /* Read the sector into the sector cache */
 
-      bchlib_readsector(bch, sector);
+      ret = bchlib_readsector(bch, sector);
+      if (ret < 0)
+        {
+          return byteswritten > 0 ? byteswritten : ret;
+        }
 
       /* Copy the head end of the sector from the user buffer */
 
-      memcpy(bch->buffer, buffer, len);
-      bch->dirty = true;
+      memcpy(bchlib_cachedsector(bch, sector), buffer, len);
+      bchlib_markdirty(bch, sector);
 
       /* Adjust counts */
 
       byteswritten += len;
     }
 
-  /* Finally, flush any cached writes to the device as well */
-
-  ret = bchlib_flushsector(bch);
-  if (ret < 0)
-    {
-      fdbg("Flush failed: %d\n", ret);
-      return ret;
-    }
+  /* Partial sector writes remain in the cache.  They are written back when
+   * the cache is re-filled with other sectors, when the character driver
+   * is closed, or when bchlib_teardown() is called.  This lets a sequence
+   * of small writes share one write to the device.
+   */
 
   return byteswritten;
 }
-
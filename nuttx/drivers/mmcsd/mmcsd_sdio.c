@@ -96,10 +96,56 @@
 
 #define IS_EMPTY(priv) (priv->type == MMCSD_CARDTYPE_UNKNOWN)
 
+/* The maximum number of memory segments in one data transfer.  Without
+ * scatter/gather DMA support in the SDIO driver, each memory segment of a
+ * scatter/gather request is transferred with a separate command.
+ */
+
+#ifndef CONFIG_MMCSD_NSG
+#  define CONFIG_MMCSD_NSG 8
+#endif
+
+#ifdef CONFIG_SDIO_DMASG
+#  define MMCSD_NSG CONFIG_MMCSD_NSG
+#else
+#  define MMCSD_NSG 1
+#endif
+
+/* Read-ahead and write buffering.  The buffers are set up when a card is
+ * identified and are sized in blocks of that card.
+ */
+
+#if defined(CONFIG_FS_READAHEAD) || (defined(CONFIG_FS_WRITABLE) && defined(CONFIG_FS_WRITEBUFFER))
+#  define CONFIG_MMCSD_RWBUFFER 1
+#endif
+
+#ifndef CONFIG_MMCSD_RHMAXBLOCKS
+#  define CONFIG_MMCSD_RHMAXBLOCKS 8
+#endif
+
+#ifndef CONFIG_MMCSD_WRMAXBLOCKS
+#  define CONFIG_MMCSD_WRMAXBLOCKS 8
+#endif
+
 /****************************************************************************
  * Private Types
  ****************************************************************************/
 
+/* This structure describes one data transfer command:  A range of
+ * contiguous blocks on the card and the memory segments that they are
+ * transferred to or from.
+ */
+
+struct mmcsd_xfr_s
+{
+  FAR struct block_sgreq_s *req;   /* Scatter/gather request (or NULL) */
+  off_t    startblock;             /* First block on the card */
+  size_t   nblocks;                /* Number of blocks */
+  uint8_t  nsg;                    /* Number of memory segments */
+  bool     write;                  /* true: Transfer to the card */
+  struct sdio_sg_s sg[MMCSD_NSG];  /* Memory segments */
+};
+
 /* This structure is contains the unique state of the MMC/SD block driver */
 
 struct mmcsd_state_s
@@ -117,6 +163,9 @@ struct mmcsd_state_s
   uint8_t wrprotect:1;             /* true: Card is write protected (from CSD) */
   uint8_t locked:1;                /* true: Media is locked (from R1) */
   uint8_t dsrimp:1;                /* true: card supports CMD4/DSR setting (from CSD) */
+#ifdef CONFIG_MMCSD_RWBUFFER
+  uint8_t rwbinit:1;               /* true: rwbuffer is set up for the card */
+#endif
 #ifdef CONFIG_SDIO_DMA
   uint8_t dma:1;                   /* true: hardware supports DMA */
 #endif
@@ -140,9 +189,13 @@ struct mmcsd_state_s
 #endif
   /* Read-ahead and write buffering support */
 
-#if defined(CONFIG_FS_WRITEBUFFER) || defined(CONFIG_FS_READAHEAD)
+#ifdef CONFIG_MMCSD_RWBUFFER
   struct rwbuffer_s rwbuffer;
 #endif
+
+  /* Transfer statistics (see BIOC_MMCSDSTATS) */
+
+  struct mmcsd_stats_s stats;
 };
 
 /****************************************************************************
@@ -191,24 +244,36 @@ static int     mmcsd_transferready(FAR struct mmcsd_state_s *priv);
 static int     mmcsd_stoptransmission(FAR struct mmcsd_state_s *priv);
 static int     mmcsd_setblocklen(FAR struct mmcsd_state_s *priv,
                  uint32_t blocklen);
-static ssize_t mmcsd_readsingle(FAR struct mmcsd_state_s *priv,
-                 FAR uint8_t *buffer, off_t startblock);
-static ssize_t mmcsd_readmultiple(FAR struct mmcsd_state_s *priv,
-                 FAR uint8_t *buffer, off_t startblock, size_t nblocks);
-#ifdef CONFIG_FS_READAHEAD
+static int     mmcsd_xfrstart(FAR struct mmcsd_state_s *priv,
+                 FAR struct mmcsd_xfr_s *xfr);
+static ssize_t mmcsd_xfrfinish(FAR struct mmcsd_state_s *priv,
+                 FAR struct mmcsd_xfr_s *xfr);
+static void    mmcsd_addticks(FAR struct mmcsd_state_s *priv, bool write,
+                 uint32_t start);
+static uint32_t mmcsd_kbps(FAR struct mmcsd_state_s *priv,
+                 uint32_t nblocks, uint32_t ticks);
+static ssize_t mmcsd_transfer(FAR struct mmcsd_state_s *priv,
+                 FAR uint8_t *buffer, off_t startblock, size_t nblocks,
+                 bool write);
+#ifdef CONFIG_MMCSD_SGREQUESTS
+static bool    mmcsd_sgnext(FAR struct mmcsd_state_s *priv,
+                 FAR struct block_sgreq_s **preq, FAR uint16_t *pseg,
+                 FAR struct mmcsd_xfr_s *xfr, bool write);
+static int     mmcsd_sgtransfer(FAR struct mmcsd_state_s *priv,
+                 FAR struct block_sgreq_s *reqlist, bool write);
+#ifdef CONFIG_MMCSD_RWBUFFER
+static void    mmcsd_sginvalidate(FAR struct mmcsd_state_s *priv,
+                 FAR struct block_sgreq_s *reqlist);
+#endif
+#endif
+#ifdef CONFIG_MMCSD_RWBUFFER
 static ssize_t mmcsd_reload(FAR void *dev, FAR uint8_t *buffer,
                  off_t startblock, size_t nblocks);
 #endif
-#ifdef CONFIG_FS_WRITABLE
-static ssize_t mmcsd_writesingle(FAR struct mmcsd_state_s *priv,
-                 FAR const uint8_t *buffer, off_t startblock);
-static ssize_t mmcsd_writemultiple(FAR struct mmcsd_state_s *priv,
-                 FAR const uint8_t *buffer, off_t startblock, size_t nblocks);
-#ifdef CONFIG_FS_WRITEBUFFER
+#if defined(CONFIG_MMCSD_RWBUFFER) && defined(CONFIG_FS_WRITABLE)
 static ssize_t mmcsd_flush(FAR void *dev, FAR const uint8_t *buffer,
                  off_t startblock, size_t nblocks);
 #endif
-#endif
 
 /* Block driver methods *****************************************************/
 
@@ -237,6 +302,9 @@ static int     mmcsd_sdinitialize(FAR struct mmcsd_state_s *priv);
 static int     mmcsd_cardidentify(FAR struct mmcsd_state_s *priv);
 static int     mmcsd_probe(FAR struct mmcsd_state_s *priv);
 static int     mmcsd_removed(FAR struct mmcsd_state_s *priv);
+#ifdef CONFIG_MMCSD_RWBUFFER
+static void    mmcsd_rwbinitialize(FAR struct mmcsd_state_s *priv);
+#endif
 static int     mmcsd_hwinitialize(FAR struct mmcsd_state_s *priv);
 static void    mmcsd_hwuninitialize(FAR struct mmcsd_state_s *priv);
 
@@ -1242,29 +1310,46 @@ static int mmcsd_setblocklen(FAR struct mmcsd_state_s *priv, uint32_t blocklen)
 }
 
 /****************************************************************************
- * Name: mmcsd_readsingle
+ * Name: mmcsd_xfrstart
  *
  * Description:
- *   Read a single block of data.
+ *   Start one read or write data transfer:  Wait until the card is ready,
+ *   set up the SDIO hardware and the DMA, and send the read or write
+ *   command.  The transfer is then in progress and must be completed with
+ *   mmcsd_xfrfinish().
  *
  ****************************************************************************/
 
-static ssize_t mmcsd_readsingle(FAR struct mmcsd_state_s *priv,
-                                FAR uint8_t *buffer, off_t startblock)
+static int mmcsd_xfrstart(FAR struct mmcsd_state_s *priv,
+                          FAR struct mmcsd_xfr_s *xfr)
 {
-  off_t offset;
-  int ret;
+  size_t nbytes;
+  off_t  offset;
+  int    ret;
 
-  fvdbg("startblock=%d\n", startblock);
-  DEBUGASSERT(priv != NULL && buffer != NULL);
+  fvdbg("startblock=%d nblocks=%d nsg=%d write=%d\n",
+        xfr->startblock, xfr->nblocks, xfr->nsg, xfr->write);
+  DEBUGASSERT(priv != NULL && xfr->nblocks > 0 && xfr->nsg > 0);
+
+#ifdef CONFIG_FS_WRITABLE
+  /* Check if the card is locked or write protected (either via software or
+   * via the mechanical write protect on the card)
+   */
+
+  if (xfr->write && mmcsd_wrprotected(priv))
+    {
+      fdbg("ERROR: Card is locked or write protected\n");
+      return -EPERM;
+    }
+#endif
 
   /* Check if the card is locked */
 
   if (priv->locked)
-  {
-    fdbg("ERROR: Card is locked\n");
-    return -EPERM;
-  }
+    {
+      fdbg("ERROR: Card is locked\n");
+      return -EPERM;
+    }
 
   /* Verify that the card is ready for the transfer.  The card may still be
    * busy from the preceding write transfer.  It would be simpler to check
@@ -1280,483 +1365,637 @@ static ssize_t mmcsd_readsingle(FAR struct mmcsd_state_s *priv,
       return ret;
     }
 
-  /* If this is a byte addressed SD card, then convert sector start sector
-   * number to a byte offset
+  /* If this is a byte addressed SD card, then convert both the total transfer
+   * size to bytes and the sector start sector number to a byte offset
    */
 
+  nbytes = xfr->nblocks << priv->blockshift;
   if (IS_BLOCK(priv->type))
     {
-      offset = startblock;
+      offset = xfr->startblock;
     }
   else
     {
-      offset = startblock << priv->blockshift;
+      offset = xfr->startblock << priv->blockshift;
     }
-  fvdbg("offset=%d\n", offset);
+  fvdbg("nbytes=%d byte offset=%d\n", nbytes, offset);
 
   /* Select the block size for the card */
 
   ret = mmcsd_setblocklen(priv, priv->blocksize);
   if (ret != OK)
-  {
-    fdbg("ERROR: mmcsd_setblocklen failed: %d\n", ret);
-    return ret;
-  }
+    {
+      fdbg("ERROR: mmcsd_setblocklen failed: %d\n", ret);
+      return ret;
+    }
 
-  /* Configure SDIO controller hardware for the read transfer */
+#ifdef CONFIG_FS_WRITABLE
+  if (xfr->write)
+    {
+      uint32_t cmd = xfr->nblocks > 1 ? MMCSD_CMD25 : MMCSD_CMD24;
+
+      /* If this is an SD card, then send ACMD23 (SET_WR_BLK_COUNT) just
+       * before sending CMD25 (WRITE_MULTIPLE_BLOCK).  This sets the number
+       * of write blocks to be pre-erased and might make the following
+       * multiple block write command faster.
+       */
+
+      if (xfr->nblocks > 1 && IS_SD(priv->type))
+        {
+          /* Send CMD55, APP_CMD, a verify that good R1 status is retured */
 
-  SDIO_BLOCKSETUP(priv->dev, priv->blocksize, 1);
-  SDIO_WAITENABLE(priv->dev, SDIOWAIT_TRANSFERDONE|SDIOWAIT_TIMEOUT|SDIOWAIT_ERROR);
+          mmcsd_sendcmdpoll(priv, SD_CMD55, (uint32_t)priv->rca << 16);
+          ret = mmcsd_recvR1(priv, SD_CMD55);
+          if (ret != OK)
+            {
+              fdbg("ERROR: mmcsd_recvR1 for CMD55 (ACMD23) failed: %d\n", ret);
+              return ret;
+            }
+
+          /* Send CMD23, SET_WR_BLK_COUNT, and verify that good R1 status is
+           * returned
+           */
+
+          mmcsd_sendcmdpoll(priv, SD_ACMD23, xfr->nblocks);
+          ret = mmcsd_recvR1(priv, SD_ACMD23);
+          if (ret != OK)
+            {
+              fdbg("ERROR: mmcsd_recvR1 for ACMD23 failed: %d\n", ret);
+              return ret;
+            }
+        }
+
+      /* Send CMD24, WRITE_BLOCK, or CMD25, WRITE_MULTIPLE_BLOCK, and verify
+       * that good R1 status is returned
+       */
+
+      mmcsd_sendcmdpoll(priv, cmd, offset);
+      ret = mmcsd_recvR1(priv, cmd);
+      if (ret != OK)
+        {
+          fdbg("ERROR: mmcsd_recvR1 for CMD%d failed: %d\n",
+               cmd & MMCSD_CMDIDX_MASK, ret);
+          return ret;
+        }
+
+      /* Configure SDIO controller hardware for the write transfer */
+
+      SDIO_BLOCKSETUP(priv->dev, priv->blocksize, xfr->nblocks);
+      SDIO_WAITENABLE(priv->dev, SDIOWAIT_TRANSFERDONE|SDIOWAIT_TIMEOUT|SDIOWAIT_ERROR);
 #ifdef CONFIG_SDIO_DMA
-  if (priv->dma)
-    {
-      SDIO_DMARECVSETUP(priv->dev, buffer, priv->blocksize);
+      if (priv->dma)
+        {
+#ifdef CONFIG_SDIO_DMASG
+          if (xfr->nsg > 1)
+            {
+              ret = SDIO_DMASENDSGSETUP(priv->dev, xfr->sg, xfr->nsg);
+            }
+          else
+#endif
+            {
+              ret = SDIO_DMASENDSETUP(priv->dev, xfr->sg[0].buffer, nbytes);
+            }
+        }
+      else
+#endif
+        {
+          ret = SDIO_SENDSETUP(priv->dev, xfr->sg[0].buffer, nbytes);
+        }
+
+      /* Flag that a write transfer is pending that we will have to check for
+       * write complete at the beginning of the next transfer.
+       */
+
+      priv->wrbusy = true;
+
+      if (ret != OK)
+        {
+          /* The card is waiting for data that will never come */
+
+          fdbg("ERROR: Send setup failed: %d\n", ret);
+          SDIO_CANCEL(priv->dev);
+          if (xfr->nblocks > 1)
+            {
+              (void)mmcsd_stoptransmission(priv);
+            }
+          return ret;
+        }
+
+      priv->stats.nwrites++;
     }
   else
 #endif
     {
-      SDIO_RECVSETUP(priv->dev, buffer, priv->blocksize);
-    }
+      uint32_t cmd = xfr->nblocks > 1 ? MMCSD_CMD18 : MMCSD_CMD17;
 
-  /* Send CMD17, READ_SINGLE_BLOCK: Read a block of the size selected
-   * by the mmcsd_setblocklen() and verify that good R1 status is
-   * returned.  The card state should change from Transfer to Sending-Data
-   * state.
-   */
+      /* Configure SDIO controller hardware for the read transfer */
 
-  mmcsd_sendcmdpoll(priv, MMCSD_CMD17, offset);
-  ret = mmcsd_recvR1(priv, MMCSD_CMD17);
-  if (ret != OK)
-    {
-      fdbg("ERROR: mmcsd_recvR1 for CMD17 failed: %d\n", ret);
-      SDIO_CANCEL(priv->dev);
-      return ret;
-    }
+      SDIO_BLOCKSETUP(priv->dev, priv->blocksize, xfr->nblocks);
+      SDIO_WAITENABLE(priv->dev, SDIOWAIT_TRANSFERDONE|SDIOWAIT_TIMEOUT|SDIOWAIT_ERROR);
+#ifdef CONFIG_SDIO_DMA
+      if (priv->dma)
+        {
+#ifdef CONFIG_SDIO_DMASG
+          if (xfr->nsg > 1)
+            {
+              ret = SDIO_DMARECVSGSETUP(priv->dev, xfr->sg, xfr->nsg);
+            }
+          else
+#endif
+            {
+              ret = SDIO_DMARECVSETUP(priv->dev, xfr->sg[0].buffer, nbytes);
+            }
+        }
+      else
+#endif
+        {
+          ret = SDIO_RECVSETUP(priv->dev, xfr->sg[0].buffer, nbytes);
+        }
 
-  /* Then wait for the data transfer to complete */
+      if (ret != OK)
+        {
+          fdbg("ERROR: Receive setup failed: %d\n", ret);
+          SDIO_CANCEL(priv->dev);
+          return ret;
+        }
 
-  ret = mmcsd_eventwait(priv, SDIOWAIT_TIMEOUT|SDIOWAIT_ERROR, MMCSD_BLOCK_DATADELAY);
-  if (ret != OK)
-    {
-      fdbg("ERROR: CMD17 transfer failed: %d\n", ret);
-      return ret;
-    }
+      /* Send CMD17, READ_SINGLE_BLOCK, or CMD18, READ_MULT_BLOCK:  Read
+       * blocks of the size selected by the mmcsd_setblocklen() and verify
+       * that good R1 status is returned.  The card state should change from
+       * Transfer to Sending-Data state.
+       */
+
+      mmcsd_sendcmdpoll(priv, cmd, offset);
+      ret = mmcsd_recvR1(priv, cmd);
+      if (ret != OK)
+        {
+          fdbg("ERROR: mmcsd_recvR1 for CMD%d failed: %d\n",
+               cmd & MMCSD_CMDIDX_MASK, ret);
+          SDIO_CANCEL(priv->dev);
+          return ret;
+        }
 
-  /* Return value:  One sector read */
+      priv->stats.nreads++;
+    }
 
-  return 1;
+  return OK;
 }
 
 /****************************************************************************
- * Name: mmcsd_readmultiple
+ * Name: mmcsd_xfrfinish
  *
  * Description:
- *   Read multiple, contiguous blocks of data from the physical device.
+ *   Wait for a data transfer started by mmcsd_xfrstart() to complete and
+ *   end a multiple block transfer with STOP_TRANSMISSION.
+ *
+ * Returned Value:
+ *   The number of blocks transferred on success; a negated errno on
+ *   failure.
  *
  ****************************************************************************/
 
-static ssize_t mmcsd_readmultiple(FAR struct mmcsd_state_s *priv,
-                                  FAR uint8_t *buffer, off_t startblock,
-                                  size_t nblocks)
+static ssize_t mmcsd_xfrfinish(FAR struct mmcsd_state_s *priv,
+                               FAR struct mmcsd_xfr_s *xfr)
 {
-  size_t nbytes;
-  off_t  offset;
   int ret;
 
-  fvdbg("startblock=%d nblocks=%d\n", startblock, nblocks);
-  DEBUGASSERT(priv != NULL && buffer != NULL && nblocks > 1);
-
-  /* Check if the card is locked */
-
-  if (priv->locked)
-  {
-    fdbg("ERROR: Card is locked\n");
-    return -EPERM;
-  }
-
-  /* Verify that the card is ready for the transfer.  The card may still be
-   * busy from the preceding write transfer.  It would be simpler to check
-   * for write busy at the end of each write, rather than at the beginning of
-   * each read AND write, but putting the busy-wait at the beginning of the
-   * transfer allows for more overlap and, hopefully, better performance
-   */
+  /* Wait for the transfer to complete */
 
-  ret = mmcsd_transferready(priv);
+  ret = mmcsd_eventwait(priv, SDIOWAIT_TIMEOUT|SDIOWAIT_ERROR,
+                        xfr->nblocks * MMCSD_BLOCK_DATADELAY);
   if (ret != OK)
     {
-      fdbg("ERROR: Card not ready: %d\n", ret);
+      fdbg("ERROR: %s transfer failed: %d\n",
+           xfr->write ? "Write" : "Read", ret);
       return ret;
     }
 
-  /* If this is a byte addressed SD card, then convert both the total transfer
-   * size to bytes and the sector start sector number to a byte offset
-   */
+  /* Send STOP_TRANSMISSION to end a multiple block transfer */
 
-  nbytes = nblocks << priv->blockshift;
-  if (IS_BLOCK(priv->type))
+  if (xfr->nblocks > 1)
     {
-      offset = startblock;
+      ret = mmcsd_stoptransmission(priv);
+      if (ret != OK)
+        {
+          fdbg("ERROR: mmcsd_stoptransmission failed: %d\n", ret);
+
+          /* All of the data was received, so only a failure to stop a write
+           * is reported.
+           */
+
+          if (xfr->write)
+            {
+              return ret;
+            }
+        }
+    }
+
+  /* On success, return the number of blocks transferred */
+
+  if (xfr->write)
+    {
+      priv->stats.wrblocks += xfr->nblocks;
     }
   else
     {
-      offset = startblock << priv->blockshift;
+      priv->stats.rdblocks += xfr->nblocks;
     }
-  fvdbg("nbytes=%d byte offset=%d\n", nbytes, offset);
 
-  /* Select the block size for the card */
+  return xfr->nblocks;
+}
 
-  ret = mmcsd_setblocklen(priv, priv->blocksize);
-  if (ret != OK)
-  {
-    fdbg("ERROR: mmcsd_setblocklen failed: %d\n", ret);
-    return ret;
-  }
+/****************************************************************************
+ * Name: mmcsd_addticks
+ *
+ * Description:
+ *   Add the time since 'start' to the read or write time statistics.
+ *
+ ****************************************************************************/
 
-  /* Configure SDIO controller hardware for the read transfer */
+static void mmcsd_addticks(FAR struct mmcsd_state_s *priv, bool write,
+                           uint32_t start)
+{
+  uint32_t elapsed = clock_systimer() - start;
 
-  SDIO_BLOCKSETUP(priv->dev, priv->blocksize, nblocks);
-  SDIO_WAITENABLE(priv->dev, SDIOWAIT_TRANSFERDONE|SDIOWAIT_TIMEOUT|SDIOWAIT_ERROR);
-#ifdef CONFIG_SDIO_DMA
-  if (priv->dma)
+  if (write)
     {
-      SDIO_DMARECVSETUP(priv->dev, buffer, nbytes);
+      priv->stats.wrticks += elapsed;
     }
   else
-#endif
     {
-      SDIO_RECVSETUP(priv->dev, buffer, nbytes);
+      priv->stats.rdticks += elapsed;
     }
+}
 
-  /* Send CMD18, READ_MULT_BLOCK: Read a block of the size selected by
-   * the mmcsd_setblocklen() and verify that good R1 status is returned
-   */
-
-  mmcsd_sendcmdpoll(priv, MMCSD_CMD18, offset);
-  ret = mmcsd_recvR1(priv, MMCSD_CMD18);
-  if (ret != OK)
-    {
-      fdbg("ERROR: mmcsd_recvR1 for CMD18 failed: %d\n", ret);
-      SDIO_CANCEL(priv->dev);
-      return ret;
-    }
+/****************************************************************************
+ * Name: mmcsd_kbps
+ *
+ * Description:
+ *   Return the transfer rate in KB/s for 'nblocks' transferred in 'ticks'
+ *   system ticks.
+ *
+ ****************************************************************************/
 
-  /* Wait for the transfer to complete */
+static uint32_t mmcsd_kbps(FAR struct mmcsd_state_s *priv, uint32_t nblocks,
+                           uint32_t ticks)
+{
+  uint32_t msec = ticks * MSEC_PER_TICK;
+  uint32_t kb   = nblocks >> (10 - priv->blockshift);
 
-  ret = mmcsd_eventwait(priv, SDIOWAIT_TIMEOUT|SDIOWAIT_ERROR, nblocks * MMCSD_BLOCK_DATADELAY);
-  if (ret != OK)
+  if (msec == 0)
     {
-      fdbg("ERROR: CMD18 transfer failed: %d\n", ret);
-      return ret;
+      return 0;
     }
 
-  /* Send STOP_TRANSMISSION */
+  /* Avoid overflow with very large amounts of data */
 
-  ret = mmcsd_stoptransmission(priv);
-  if (ret != OK)
+  if (kb < 0xffffffff / 1000)
     {
-      fdbg("ERROR: mmcsd_stoptransmission failed: %d\n", ret);
+      return kb * 1000 / msec;
     }
 
-  /* On success, return the number of blocks read */
-
-  return nblocks;
+  return kb / (msec < 1000 ? 1 : msec / 1000);
 }
 
 /****************************************************************************
- * Name: mmcsd_reload
+ * Name: mmcsd_transfer
  *
  * Description:
- *   Reload the specified number of sectors from the physical device into the
- *   read-ahead buffer.
+ *   Read or write contiguous blocks of data from or to one buffer.
  *
  ****************************************************************************/
 
-#ifdef CONFIG_FS_READAHEAD
-static ssize_t mmcsd_reload(FAR void *dev, FAR uint8_t *buffer,
-                            off_t startblock, size_t nblocks)
+static ssize_t mmcsd_transfer(FAR struct mmcsd_state_s *priv,
+                              FAR uint8_t *buffer, off_t startblock,
+                              size_t nblocks, bool write)
 {
-  FAR struct mmcsd_state_s *priv = (FAR struct mmcsd_state_s *)dev;
+  struct mmcsd_xfr_s xfr;
+  uint32_t start;
   ssize_t ret;
 
-  DEBUGASSERT(priv != NULL && buffer != NULL && nblocks > 0)
+  DEBUGASSERT(priv != NULL && buffer != NULL && nblocks > 0);
 
-  if (nblocks == 1)
-    {
-      ret = mmcsd_readsingle(priv, buffer, startblock);
-    }
-  else
+  xfr.req           = NULL;
+  xfr.startblock    = startblock;
+  xfr.nblocks       = nblocks;
+  xfr.nsg           = 1;
+  xfr.write         = write;
+  xfr.sg[0].buffer  = buffer;
+  xfr.sg[0].buflen  = nblocks << priv->blockshift;
+
+  start = clock_systimer();
+  ret   = mmcsd_xfrstart(priv, &xfr);
+  if (ret == OK)
     {
-      ret = mmcsd_readmultiple(priv, buffer, startblock, nblocks);
+      ret = mmcsd_xfrfinish(priv, &xfr);
     }
 
-  /* On success, return the number of blocks read */
-
+  mmcsd_addticks(priv, write, start);
   return ret;
 }
-#endif
 
 /****************************************************************************
- * Name: mmcsd_writesingle
+ * Name: mmcsd_sgnext
  *
  * Description:
- *   Write a single block of data to the physical device.
+ *   Build the next data transfer of a chain of scatter/gather requests.
+ *   One transfer covers as many of the following memory segments of the
+ *   current request as the SDIO driver can handle in one DMA.  The
+ *   position in the chain (*preq and *pseg) is advanced past the segments
+ *   that were used.
+ *
+ * Returned Value:
+ *   true if a transfer was built; false at the end of the chain.
  *
  ****************************************************************************/
 
-#ifdef CONFIG_FS_WRITABLE
-static ssize_t mmcsd_writesingle(FAR struct mmcsd_state_s *priv,
-                                 FAR const uint8_t *buffer, off_t startblock)
+#ifdef CONFIG_MMCSD_SGREQUESTS
+static bool mmcsd_sgnext(FAR struct mmcsd_state_s *priv,
+                         FAR struct block_sgreq_s **preq,
+                         FAR uint16_t *pseg, FAR struct mmcsd_xfr_s *xfr,
+                         bool write)
 {
-  off_t offset;
-  int ret;
-
-  fvdbg("startblock=%d\n", startblock);
-  DEBUGASSERT(priv != NULL && buffer != NULL);
+  FAR struct block_sgreq_s *req = *preq;
+  FAR const struct block_sg_s *sg;
+  uint16_t seg = *pseg;
+  int maxsg;
+  int i;
 
-  /* Check if the card is locked or write protected (either via software or
-   * via the mechanical write protect on the card)
-   */
-
-  if (mmcsd_wrprotected(priv))
-  {
-    fdbg("ERROR: Card is locked or write protected\n");
-    return -EPERM;
-  }
-
-  /* Verify that the card is ready for the transfer.  The card may still be
-   * busy from the preceding write transfer.  It would be simpler to check
-   * for write busy at the end of each write, rather than at the beginning of
-   * each read AND write, but putting the busy-wait at the beginning of the
-   * transfer allows for more overlap and, hopefully, better performance
-   */
+  /* Skip over empty requests and requests that have been consumed */
 
-  ret = mmcsd_transferready(priv);
-  if (ret != OK)
+  while (req != NULL && seg >= req->nsg)
     {
-      fdbg("ERROR: Card not ready: %d\n", ret);
-      return ret;
+      req = req->flink;
+      seg = 0;
     }
 
-  /* If this is a byte addressed SD card, then convert sector start sector
-   * number to a byte offset
-   */
-
-  if (IS_BLOCK(priv->type))
+  if (req == NULL)
     {
-      offset = startblock;
+      *preq = NULL;
+      return false;
     }
-  else
-    {
-      offset = startblock << priv->blockshift;
-    }
-  fvdbg("offset=%d\n", offset);
 
-  /* Select the block size for the card */
+  /* Without DMA, the SDIO driver can only handle one buffer */
 
-  ret = mmcsd_setblocklen(priv, priv->blocksize);
-  if (ret != OK)
-    {
-      fdbg("ERROR: mmcsd_setblocklen failed: %d\n", ret);
-      return ret;
-    }
+#ifdef CONFIG_SDIO_DMA
+  maxsg = priv->dma ? MMCSD_NSG : 1;
+#else
+  maxsg = 1;
+#endif
 
-  /* Send CMD24, WRITE_BLOCK, and verify that good R1 status is returned */
+  /* The transfer begins after all of the segments already used */
 
-  mmcsd_sendcmdpoll(priv, MMCSD_CMD24, offset);
-  ret = mmcsd_recvR1(priv, MMCSD_CMD24);
-  if (ret != OK)
+  xfr->req        = req;
+  xfr->startblock = req->startsector;
+  xfr->nblocks    = 0;
+  xfr->nsg        = 0;
+  xfr->write      = write;
+
+  for (i = 0; i < seg; i++)
     {
-      fdbg("ERROR: mmcsd_recvR1 for CMD24 failed: %d\n", ret);
-      return ret;
+      xfr->startblock += req->sg[i].nsectors;
     }
 
-  /* Configure SDIO controller hardware for the write transfer */
+  /* Add segments until the limit is reached */
 
-  SDIO_BLOCKSETUP(priv->dev, priv->blocksize, 1);
-  SDIO_WAITENABLE(priv->dev, SDIOWAIT_TRANSFERDONE|SDIOWAIT_TIMEOUT|SDIOWAIT_ERROR);
-#ifdef CONFIG_SDIO_DMA
-  if (priv->dma)
-    {
-      SDIO_DMASENDSETUP(priv->dev, buffer, priv->blocksize);
-    }
-  else
-#endif
+  for (; seg < req->nsg && xfr->nsg < maxsg; seg++)
     {
-      SDIO_SENDSETUP(priv->dev, buffer, priv->blocksize);
+      sg = &req->sg[seg];
+      if (sg->nsectors > 0)
+        {
+          xfr->sg[xfr->nsg].buffer = sg->buffer;
+          xfr->sg[xfr->nsg].buflen = sg->nsectors << priv->blockshift;
+          xfr->nblocks            += sg->nsectors;
+          xfr->nsg++;
+        }
     }
 
-  /* Flag that a write transfer is pending that we will have to check for
-   * write complete at the beginning of the next transfer.
-   */
-
-  priv->wrbusy = true;
+  *preq = req;
+  *pseg = seg;
 
-  /* Wait for the transfer to complete */
+  /* A request that ends with empty segments might not have added any */
 
-  ret = mmcsd_eventwait(priv, SDIOWAIT_TIMEOUT|SDIOWAIT_ERROR, MMCSD_BLOCK_DATADELAY);
-  if (ret != OK)
+  if (xfr->nsg == 0)
     {
-      fdbg("ERROR: CMD24 transfer failed: %d\n", ret);
-      return ret;
+      return mmcsd_sgnext(priv, preq, pseg, xfr, write);
     }
 
-  /* On success, return the number of blocks written */
-
-  return 1;
+  return true;
 }
 #endif
 
 /****************************************************************************
- * Name: mmcsd_writemultiple
+ * Name: mmcsd_dmaprepare
  *
  * Description:
- *   Write multiple, contiguous blocks of data to the physical device.
+ *   Let the SDIO driver prepare the memory of a transfer that will be
+ *   started later.
  *
  ****************************************************************************/
 
-#ifdef CONFIG_FS_WRITABLE
-static ssize_t mmcsd_writemultiple(FAR struct mmcsd_state_s *priv,
-                                   FAR const uint8_t *buffer, off_t startblock,
-                                   size_t nblocks)
+#ifdef CONFIG_MMCSD_SGREQUESTS
+static inline int mmcsd_dmaprepare(FAR struct mmcsd_state_s *priv,
+                                   FAR struct mmcsd_xfr_s *xfr)
 {
-  off_t  offset;
-  size_t nbytes;
-  int ret;
+#ifdef CONFIG_SDIO_DMASG
+  if (priv->dma)
+    {
+      return SDIO_DMAPREPARE(priv->dev, xfr->sg, xfr->nsg, xfr->write);
+    }
+#endif
 
-  fvdbg("startblockr=%d nblocks=%d\n", startblock, nblocks);
-  DEBUGASSERT(priv != NULL && buffer != NULL && nblocks > 1);
+  return OK;
+}
+#endif
 
-  /* Check if the card is locked or write protected (either via software or
-   * via the mechanical write protect on the card)
-   */
+/****************************************************************************
+ * Name: mmcsd_sgtransfer
+ *
+ * Description:
+ *   Perform a chain of scatter/gather requests (BIOC_READSG and
+ *   BIOC_WRITESG).  The transfers are pipelined:  While the DMA of one
+ *   transfer is in progress, the next transfer is built and its memory is
+ *   prepared by the SDIO driver so that it can be started as soon as the
+ *   current one completes.
+ *
+ * Returned Value:
+ *   OK if all requests succeeded; the negated errno of the first failure
+ *   otherwise.  The result of each request is returned in the request.
+ *
+ ****************************************************************************/
 
-  if (mmcsd_wrprotected(priv))
-  {
-    fdbg("ERROR: Card is locked or write protected\n");
-    return -EPERM;
-  }
+#ifdef CONFIG_MMCSD_SGREQUESTS
+static int mmcsd_sgtransfer(FAR struct mmcsd_state_s *priv,
+                            FAR struct block_sgreq_s *reqlist, bool write)
+{
+  struct mmcsd_xfr_s xfr[2];
+  FAR struct mmcsd_xfr_s *curr = &xfr[0];
+  FAR struct mmcsd_xfr_s *next = &xfr[1];
+  FAR struct mmcsd_xfr_s *tmp;
+  FAR struct block_sgreq_s *req;
+  uint16_t seg = 0;
+  uint32_t start;
+  bool more;
+  ssize_t nxfrd;
+  int preperr;
+  int ret = OK;
 
-  /* Verify that the card is ready for the transfer.  The card may still be
-   * busy from the preceding write transfer.  It would be simpler to check
-   * for write busy at the end of each write, rather than at the beginning of
-   * each read AND write, but putting the busy-wait at the beginning of the
-   * transfer allows for more overlap and, hopefully, better performance
-   */
+  /* Validate the requests and clear the results */
 
-  ret = mmcsd_transferready(priv);
-  if (ret != OK)
+  for (req = reqlist; req != NULL; req = req->flink)
     {
-      fdbg("ERROR: Card not ready: %d\n", ret);
-      return ret;
+      size_t nsectors = 0;
+      int i;
+
+      for (i = 0; i < req->nsg; i++)
+        {
+          if (req->sg[i].buffer == NULL && req->sg[i].nsectors > 0)
+            {
+              return -EINVAL;
+            }
+
+          nsectors += req->sg[i].nsectors;
+        }
+
+      if (req->startsector + nsectors > priv->nblocks)
+        {
+          return -EINVAL;
+        }
+
+      req->result = 0;
     }
 
-  /* If this is a byte addressed SD card, then convert both the total transfer
-   * size to bytes and the sector start sector number to a byte offset
-   */
+  /* Build and start the first transfer */
 
-  nbytes = nblocks << priv->blockshift;
-  if (IS_BLOCK(priv->type))
+  req  = reqlist;
+  more = mmcsd_sgnext(priv, &req, &seg, curr, write);
+  if (!more)
     {
-      offset = startblock;
+      return OK;
     }
-  else
+
+  start = clock_systimer();
+  ret   = mmcsd_dmaprepare(priv, curr);
+  if (ret == OK)
     {
-      offset = startblock << priv->blockshift;
+      ret = mmcsd_xfrstart(priv, curr);
     }
-  fvdbg("nbytes=%d byte offset=%d\n", nbytes, offset);
 
-  /* Select the block size for the card */
+  while (ret == OK)
+    {
+      /* Set up the next transfer while this one is in progress */
 
-  ret = mmcsd_setblocklen(priv, priv->blocksize);
-  if (ret != OK)
-  {
-    fdbg("ERROR: mmcsd_setblocklen failed: %d\n", ret);
-    return ret;
-  }
+      more    = mmcsd_sgnext(priv, &req, &seg, next, write);
+      preperr = OK;
+      if (more)
+        {
+          preperr = mmcsd_dmaprepare(priv, next);
+          if (preperr != OK)
+            {
+              fdbg("ERROR: DMA prepare failed: %d\n", preperr);
+            }
+        }
 
-  /* If this is an SD card, then send ACMD23 (SET_WR_BLK_COUNT) just before
-   * sending CMD25 (WRITE_MULTIPLE_BLOCK).  This sets the number of write
-   * blocks to be pre-erased and might make the following multiple block write
-   * command faster.
-   */
+      /* Wait for the current transfer to complete */
 
-  if (IS_SD(priv->type))
-    {
-      /* Send CMD55, APP_CMD, a verify that good R1 status is retured */
+      nxfrd = mmcsd_xfrfinish(priv, curr);
+      if (nxfrd < 0)
+        {
+          ret = (int)nxfrd;
+          break;
+        }
 
-      mmcsd_sendcmdpoll(priv, SD_CMD55, 0);
-      ret = mmcsd_recvR1(priv, SD_CMD55);
-      if (ret != OK)
+      curr->req->result += nxfrd;
+
+      /* Then start the next one */
+
+      if (!more)
         {
-          fdbg("ERROR: mmcsd_recvR1 for CMD55 (ACMD23) failed: %d\n", ret);
-          return ret;
+          break;
         }
 
-      /* Send CMD23, SET_WR_BLK_COUNT, and verify that good R1 status is returned */
+      tmp  = curr;
+      curr = next;
+      next = tmp;
 
-      mmcsd_sendcmdpoll(priv, SD_ACMD23, 0);
-      ret = mmcsd_recvR1(priv, SD_ACMD23);
-      if (ret != OK)
+      ret = preperr;
+      if (ret == OK)
         {
-          fdbg("ERROR: mmcsd_recvR1 for ACMD23 failed: %d\n", ret);
-          return ret;
+          ret = mmcsd_xfrstart(priv, curr);
         }
     }
 
-  /* Send CMD25, WRITE_MULTIPLE_BLOCK, and verify that good R1 status
-   * is returned
+  /* On a failure, curr is the transfer that failed.  Its request and all
+   * of the following requests report the error, including a request whose
+   * earlier segments were transferred.
    */
 
-  mmcsd_sendcmdpoll(priv, MMCSD_CMD25, offset);
-  ret = mmcsd_recvR1(priv, MMCSD_CMD25);
   if (ret != OK)
     {
-      fdbg("ERROR: mmcsd_recvR1 for CMD24 failed: %d\n", ret);
-      return ret;
+      for (req = curr->req; req != NULL; req = req->flink)
+        {
+          req->result = ret;
+        }
     }
 
-  /* Configure SDIO controller hardware for the write transfer */
-
-  SDIO_BLOCKSETUP(priv->dev, priv->blocksize, nblocks);
-  SDIO_WAITENABLE(priv->dev, SDIOWAIT_TRANSFERDONE|SDIOWAIT_TIMEOUT|SDIOWAIT_ERROR);
-#ifdef CONFIG_SDIO_DMA
-  if (priv->dma)
-    {
-      SDIO_DMASENDSETUP(priv->dev, buffer, nbytes);
-    }
-  else
+  mmcsd_addticks(priv, write, start);
+  return ret;
+}
 #endif
-    {
-      SDIO_SENDSETUP(priv->dev, buffer, nbytes);
-    }
-
-  /* Flag that a write transfer is pending that we will have to check for
-   * write complete at the beginning of the next transfer.
-   */
 
-  priv->wrbusy = true;
+/****************************************************************************
+ * Name: mmcsd_sginvalidate
+ *
+ * Description:
+ *   Discard the buffered copies of the sectors of a chain of scatter/gather
+ *   write requests.
+ *
+ ****************************************************************************/
 
-  /* Wait for the transfer to complete */
+#if defined(CONFIG_MMCSD_SGREQUESTS) && defined(CONFIG_MMCSD_RWBUFFER)
+static void mmcsd_sginvalidate(FAR struct mmcsd_state_s *priv,
+                               FAR struct block_sgreq_s *reqlist)
+{
+  FAR struct block_sgreq_s *req;
+  size_t nsectors;
+  int i;
 
-  ret = mmcsd_eventwait(priv, SDIOWAIT_TIMEOUT|SDIOWAIT_ERROR, nblocks * MMCSD_BLOCK_DATADELAY);
-  if (ret != OK)
+  for (req = reqlist; req != NULL; req = req->flink)
     {
-      fdbg("ERROR: CMD18 transfer failed: %d\n", ret);
-      return ret;
+      nsectors = 0;
+      for (i = 0; i < req->nsg; i++)
+        {
+          nsectors += req->sg[i].nsectors;
+        }
+
+      if (nsectors > 0)
+        {
+          (void)rwb_invalidate(&priv->rwbuffer, req->startsector, nsectors);
+        }
     }
+}
+#endif
 
-  /* Send STOP_TRANSMISSION */
+/****************************************************************************
+ * Name: mmcsd_reload
+ *
+ * Description:
+ *   Reload the specified number of sectors from the physical device into the
+ *   read-ahead buffer.
+ *
+ ****************************************************************************/
 
-  ret = mmcsd_stoptransmission(priv);
-  if (ret != OK)
-    {
-      fdbg("ERROR: mmcsd_stoptransmission failed: %d\n", ret);
-      return ret;
-    }
+#ifdef CONFIG_MMCSD_RWBUFFER
+static ssize_t mmcsd_reload(FAR void *dev, FAR uint8_t *buffer,
+                            off_t startblock, size_t nblocks)
+{
+  FAR struct mmcsd_state_s *priv = (FAR struct mmcsd_state_s *)dev;
+
+  DEBUGASSERT(priv != NULL && buffer != NULL && nblocks > 0);
 
   /* On success, return the number of blocks read */
 
-  return nblocks;
+  return mmcsd_transfer(priv, buffer, startblock, nblocks, false);
 }
 #endif
 
@@ -1768,27 +2007,18 @@ static ssize_t mmcsd_writemultiple(FAR struct mmcsd_state_s *priv,
  *
  ****************************************************************************/
 
-#if defined(CONFIG_FS_WRITABLE) && defined(CONFIG_FS_WRITEBUFFER)
+#if defined(CONFIG_MMCSD_RWBUFFER) && defined(CONFIG_FS_WRITABLE)
 static ssize_t mmcsd_flush(FAR void *dev, FAR const uint8_t *buffer,
                            off_t startblock, size_t nblocks)
 {
   FAR struct mmcsd_state_s *priv = (FAR struct mmcsd_state_s *)dev;
-  ssize_t ret;
-
-  DEBUGASSERT(priv != NULL && buffer != NULL && nblocks > 0)
 
-  if (nblocks == 1)
-    {
-      ret = mmcsd_writesingle(priv, buffer, startblock);
-    }
-  else
-    {
-      ret = mmcsd_writemultiple(priv, buffer, startblock, nblocks);
-    }
+  DEBUGASSERT(priv != NULL && buffer != NULL && nblocks > 0);
 
   /* On success, return the number of blocks written */
 
-  return ret;
+  return mmcsd_transfer(priv, (FAR uint8_t *)buffer, startblock, nblocks,
+                        true);
 }
 #endif
 
@@ -1829,6 +2059,7 @@ static int mmcsd_open(FAR struct inode *inode)
 static int mmcsd_close(FAR struct inode *inode)
 {
   FAR struct mmcsd_state_s *priv;
+  int ret = OK;
 
   fvdbg("Entry\n");
   DEBUGASSERT(inode && inode->i_private);
@@ -1839,8 +2070,18 @@ static int mmcsd_close(FAR struct inode *inode)
   DEBUGASSERT(priv->crefs > 0);
   mmcsd_takesem(priv);
   priv->crefs--;
+
+  /* Write any buffered sectors to the card */
+
+#if defined(CONFIG_MMCSD_RWBUFFER) && defined(CONFIG_FS_WRITEBUFFER)
+  if (priv->rwbinit)
+    {
+      ret = rwb_flush(&priv->rwbuffer);
+    }
+#endif
+
   mmcsd_givesem(priv);
-  return OK;
+  return ret;
 }
 
 /****************************************************************************
@@ -1866,18 +2107,16 @@ static ssize_t mmcsd_read(FAR struct inode *inode, unsigned char *buffer,
   if (nsectors > 0)
     {
       mmcsd_takesem(priv);
-#ifdef CONFIG_FS_READAHEAD
-      ret = rwb_read(&priv->rwbuffer, startsector, nsectors, buffer);
-#else
-      if (nsectors == 1)
+#ifdef CONFIG_MMCSD_RWBUFFER
+      if (priv->rwbinit)
         {
-          ret = mmcsd_readsingle(priv, buffer, startsector);
+          ret = rwb_read(&priv->rwbuffer, startsector, nsectors, buffer);
         }
       else
+#endif
         {
-          ret = mmcsd_readmultiple(priv, buffer, startsector, nsectors);
+          ret = mmcsd_transfer(priv, buffer, startsector, nsectors, false);
         }
-#endif
       mmcsd_givesem(priv);
     }
 
@@ -1907,18 +2146,27 @@ static ssize_t mmcsd_write(FAR struct inode *inode, const unsigned char *buffer,
   priv = (FAR struct mmcsd_state_s *)inode->i_private;
 
   mmcsd_takesem(priv);
-#ifdef CONFIG_FS_WRITEBUFFER
-  ret = rwb_write(&priv->rwbuffer, startsector, nsectors, buffer);
-#else
-  if (nsectors == 1)
+#ifdef CONFIG_MMCSD_RWBUFFER
+  if (priv->rwbinit)
     {
-      ret = mmcsd_writesingle(priv, buffer, startsector);
+      /* A buffered write would only fail when it is flushed */
+
+      if (mmcsd_wrprotected(priv))
+        {
+          fdbg("ERROR: Card is locked or write protected\n");
+          ret = -EPERM;
+        }
+      else
+        {
+          ret = rwb_write(&priv->rwbuffer, startsector, nsectors, buffer);
+        }
     }
   else
+#endif
     {
-      ret = mmcsd_writemultiple(priv, buffer, startsector, nsectors);
+      ret = mmcsd_transfer(priv, (FAR uint8_t *)buffer, startsector,
+                           nsectors, true);
     }
-#endif
   mmcsd_givesem(priv);
 
   /* On success, return the number of blocks written */
@@ -2037,6 +2285,79 @@ static int mmcsd_ioctl(FAR struct inode *inode, int cmd, unsigned long arg)
       }
       break;
 
+#ifdef CONFIG_MMCSD_SGREQUESTS
+    case BIOC_READSG:  /* Scatter/gather read */
+#ifdef CONFIG_FS_WRITABLE
+    case BIOC_WRITESG: /* Scatter/gather write */
+#endif
+      {
+        FAR struct block_sgreq_s *req = (FAR struct block_sgreq_s *)((uintptr_t)arg);
+
+        fvdbg("BIOC_%sSG\n", cmd == BIOC_READSG ? "READ" : "WRITE");
+
+        if (IS_EMPTY(priv))
+          {
+            ret = -ENODEV;
+          }
+        else if (!req)
+          {
+            ret = -EINVAL;
+          }
+        else
+          {
+            ret = OK;
+
+#ifdef CONFIG_MMCSD_RWBUFFER
+            /* The transfer bypasses the read-ahead and write buffers.
+             * Write back the buffered data first so that a read sees it
+             * and so that it is not written over the new data later.
+             */
+
+            if (priv->rwbinit)
+              {
+                ret = rwb_flush(&priv->rwbuffer);
+              }
+#endif
+
+            if (ret == OK)
+              {
+                ret = mmcsd_sgtransfer(priv, req, cmd != BIOC_READSG);
+              }
+
+#ifdef CONFIG_MMCSD_RWBUFFER
+            /* Then discard any buffered copies of the sectors written */
+
+            if (priv->rwbinit && cmd != BIOC_READSG)
+              {
+                mmcsd_sginvalidate(priv, req);
+              }
+#endif
+          }
+      }
+      break;
+#endif
+
+    case BIOC_MMCSDSTATS: /* Return transfer statistics */
+      {
+        FAR struct mmcsd_stats_s *stats = (FAR struct mmcsd_stats_s *)((uintptr_t)arg);
+
+        fvdbg("BIOC_MMCSDSTATS\n");
+
+        if (!stats)
+          {
+            ret = -EINVAL;
+          }
+        else
+          {
+            memcpy(stats, &priv->stats, sizeof(struct mmcsd_stats_s));
+            stats->blocksize = priv->blocksize;
+            stats->rdkbps    = mmcsd_kbps(priv, stats->rdblocks, stats->rdticks);
+            stats->wrkbps    = mmcsd_kbps(priv, stats->wrblocks, stats->wrticks);
+            ret = OK;
+          }
+      }
+      break;
+
     default:
       ret = -ENOTTY;
       break;
@@ -2481,7 +2802,8 @@ static int mmcsd_cardidentify(FAR struct mmcsd_state_s *priv)
    * operating condition. CMD 8 is reserved on SD version 1.0 and MMC.
    *
    * CMD8 Argument:
-   *    [31:12]: Reserved (shall be set to '0')   *    [11:8]: Supply Voltage (VHS) 0x1 (Range: 2.7-3.6 V)
+   *    [31:12]: Reserved (shall be set to '0')
+   *    [11:8]: Supply Voltage (VHS) 0x1 (Range: 2.7-3.6 V)
    *    [7:0]: Check Pattern (recommended 0xaa)
    * CMD8 Response: R7
    */
@@ -2772,6 +3094,12 @@ static int mmcsd_probe(FAR struct mmcsd_state_s *priv)
                 fvdbg("Capacity: %lu Kbytes\n", (unsigned long)(priv->capacity / 1024));
                 priv->mediachanged = true;
 
+                /* Buffer the card now that its geometry is known */
+
+#ifdef CONFIG_MMCSD_RWBUFFER
+                mmcsd_rwbinitialize(priv);
+#endif
+
                 /* Set up to receive asynchronous, media removal events */
 
                 SDIO_CALLBACKENABLE(priv->dev, SDIOMEDIA_EJECTED);
@@ -2810,6 +3138,23 @@ static int mmcsd_removed(FAR struct mmcsd_state_s *priv)
 {
   fvdbg("type: %d present: %d\n", priv->type, SDIO_PRESENT(priv->dev));
 
+  /* Release the buffers.  Buffered writes are written back if the card is
+   * still there (it is being re-probed) and discarded otherwise.
+   */
+
+#ifdef CONFIG_MMCSD_RWBUFFER
+  if (priv->rwbinit)
+    {
+      if (!SDIO_PRESENT(priv->dev))
+        {
+          (void)rwb_mediaremoved(&priv->rwbuffer);
+        }
+
+      rwb_uninitialize(&priv->rwbuffer);
+      priv->rwbinit = false;
+    }
+#endif
+
   /* Forget the card geometry, pretend the slot is empty (it might not
    * be), and that the card has never been initialized.
    */
@@ -2833,6 +3178,53 @@ static int mmcsd_removed(FAR struct mmcsd_state_s *priv)
   return OK;
 }
 
+/****************************************************************************
+ * Name: mmcsd_rwbinitialize
+ *
+ * Description:
+ *   Set up read-ahead and write buffering for a newly identified card.  If
+ *   the buffers cannot be allocated, the card is used without buffering.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_MMCSD_RWBUFFER
+static void mmcsd_rwbinitialize(FAR struct mmcsd_state_s *priv)
+{
+  int ret;
+
+  priv->rwbuffer.blocksize   = priv->blocksize;
+  priv->rwbuffer.nblocks     = priv->nblocks;
+  priv->rwbuffer.dev         = (FAR void *)priv;
+  priv->rwbuffer.rhreload    = mmcsd_reload;
+#ifdef CONFIG_FS_WRITABLE
+  priv->rwbuffer.wrflush     = mmcsd_flush;
+#else
+  priv->rwbuffer.wrflush     = NULL;
+#endif
+
+#ifdef CONFIG_FS_WRITEBUFFER
+#ifdef CONFIG_FS_WRITABLE
+  priv->rwbuffer.wrmaxblocks = CONFIG_MMCSD_WRMAXBLOCKS;
+#else
+  priv->rwbuffer.wrmaxblocks = 0;
+#endif
+#endif
+
+#ifdef CONFIG_FS_READAHEAD
+  priv->rwbuffer.rhmaxblocks = CONFIG_MMCSD_RHMAXBLOCKS;
+#endif
+
+  ret = rwb_initialize(&priv->rwbuffer);
+  if (ret < 0)
+    {
+      fdbg("ERROR: Buffer setup failed: %d\n", ret);
+      return;
+    }
+
+  priv->rwbinit = true;
+}
+#endif
+
 /****************************************************************************
  * Name: mmcsd_hwinitialize
  *
@@ -3023,18 +3415,6 @@ int mmcsd_slotinitialize(int minor, FAR struct sdio_dev_s *dev)
             }
         }
 
-      /* Initialize buffering */
-
-#if defined(CONFIG_FS_WRITEBUFFER) || defined(CONFIG_FS_READAHEAD)
-
-      ret = rwb_initialize(&priv->rwbuffer);
-      if (ret < 0)
-        {
-          fdbg("ERROR: Buffer setup failed: %d\n", ret);
-          goto errout_with_hwinit;
-        }
-#endif
-
       /* Create a MMCSD device name */
 
       snprintf(devname, 16, "/dev/mmcsd%d", minor);
@@ -3045,17 +3425,15 @@ int mmcsd_slotinitialize(int minor, FAR struct sdio_dev_s *dev)
       if (ret < 0)
         {
           fdbg("ERROR: register_blockdriver failed: %d\n", ret);
-          goto errout_with_buffers;
+          goto errout_with_hwinit;
         }
     }
   return OK;
 
-errout_with_buffers:
-#if defined(CONFIG_FS_WRITEBUFFER) || defined(CONFIG_FS_READAHEAD)
-  rwb_uninitialize(&priv->rwbuffer);
 errout_with_hwinit:
-#endif
   mmcsd_hwuninitialize(priv);
+  return ret;
+
 errout_with_alloc:
   kfree(priv);
   return ret;
@@ -55,12 +55,14 @@
 #include <nuttx/mtd.h>
 #include <nuttx/rwbuffer.h>
 
+#include "ftl_log.h"
+
 /****************************************************************************
  * Private Definitions
  ****************************************************************************/
 
 #if defined(CONFIG_FS_READAHEAD) || (defined(CONFIG_FS_WRITABLE) && defined(CONFIG_FS_WRITEBUFFER))
-#  defined CONFIG_FTL_RWBUFFER 1
+#  define CONFIG_FTL_RWBUFFER 1
 #endif
 
 /****************************************************************************
@@ -75,8 +77,13 @@ struct ftl_struct_s
   struct rwbuffer_s     rwb;     /* Read-ahead/write buffer support */
 #endif
   uint16_t              blkper;  /* R/W blocks per erase block */
-#ifdef CONFIG_FS_WRITABLE
+#ifdef CONFIG_FTL_LOGSTRUCT
+  struct ftl_log_s      log;     /* Log-structured sector mapping */
+#elif defined(CONFIG_FS_WRITABLE)
   FAR uint8_t          *eblock;  /* One, in-memory erase block */
+  uint32_t              hostwrites;  /* Sectors written */
+  uint32_t              flashwrites; /* Sectors programmed into FLASH */
+  uint32_t              nerases;     /* Erase block erasures */
 #endif
 };
 
@@ -143,8 +150,20 @@ static int ftl_open(FAR struct inode *inode)
 
 static int ftl_close(FAR struct inode *inode)
 {
+#if defined(CONFIG_FS_WRITABLE) && defined(CONFIG_FS_WRITEBUFFER)
+  struct ftl_struct_s *dev;
+
+  fvdbg("Entry\n");
+
+  /* Write any buffered sectors to FLASH */
+
+  DEBUGASSERT(inode && inode->i_private);
+  dev = (struct ftl_struct_s *)inode->i_private;
+  return rwb_flush(&dev->rwb);
+#else
   fvdbg("Entry\n");
   return OK;
+#endif
 }
 
 /****************************************************************************
@@ -160,9 +179,15 @@ static ssize_t ftl_reload(FAR void *priv, FAR uint8_t *buffer,
   struct ftl_struct_s *dev = (struct ftl_struct_s *)priv;
   ssize_t nread;
 
+#ifdef CONFIG_FTL_LOGSTRUCT
+  /* Logical sectors are mapped to wherever they were last written */
+
+  nread   = ftl_log_read(&dev->log, buffer, startblock, nblocks);
+#else
   /* Read the full erase block into the buffer */
 
   nread   = MTD_BREAD(dev->mtd, startblock, nblocks, buffer);
+#endif
   if (nread != nblocks)
     {
       fdbg("Read %d blocks starting at block %d failed: %d\n",
@@ -187,7 +212,7 @@ static ssize_t ftl_read(FAR struct inode *inode, unsigned char *buffer,
 
   DEBUGASSERT(inode && inode->i_private);
   dev = (struct ftl_struct_s *)inode->i_private;
-#ifdef CONFIG_FS_READAHEAD
+#ifdef CONFIG_FTL_RWBUFFER
   return rwb_read(&dev->rwb, start_sector, nsectors, buffer);
 #else
   return ftl_reload(dev, buffer, start_sector, nsectors);
@@ -201,7 +226,17 @@ static ssize_t ftl_read(FAR struct inode *inode, unsigned char *buffer,
  *
  ****************************************************************************/
 
-#ifdef CONFIG_FS_WRITABLE
+#if defined(CONFIG_FS_WRITABLE) && defined(CONFIG_FTL_LOGSTRUCT)
+static ssize_t ftl_flush(FAR void *priv, FAR const uint8_t *buffer,
+                         off_t startblock, size_t nblocks)
+{
+  struct ftl_struct_s *dev = (struct ftl_struct_s *)priv;
+
+  /* Sectors are written out-of-place; no erase block is re-written */
+
+  return ftl_log_write(&dev->log, buffer, startblock, nblocks);
+}
+#elif defined(CONFIG_FS_WRITABLE)
 static ssize_t ftl_flush(FAR void *priv, FAR const uint8_t *buffer,
                          off_t startblock, size_t nblocks)
 {
@@ -213,6 +248,7 @@ static ssize_t ftl_flush(FAR void *priv, FAR const uint8_t *buffer,
   off_t  offset;
   size_t remaining;
   size_t nxfrd;
+  size_t nsect;
   int    nbytes;
   int    ret;
  
@@ -227,6 +263,7 @@ static ssize_t ftl_flush(FAR void *priv, FAR const uint8_t *buffer,
   /* Handle partial erase blocks before the first unaligned block */
 
   remaining = nblocks;
+  dev->hostwrites += nblocks;
   if (alignedblock > startblock)
     {
       /* Read the full erase block into the buffer */
@@ -249,10 +286,20 @@ static ssize_t ftl_flush(FAR void *priv, FAR const uint8_t *buffer,
           return ret;
         }
 
-      /* Copy the user data at the end of the buffered erase block */
+      dev->nerases++;
+
+      /* Copy the user data at the end of the buffered erase block (the
+       * write may also end before the end of the erase block).
+       */
+
+      nsect  = dev->blkper - (startblock & mask);
+      if (nsect > remaining)
+        {
+          nsect = remaining;
+        }
 
       offset = (startblock & mask) * dev->geo.blocksize;
-      nbytes = dev->geo.erasesize - offset;
+      nbytes = nsect * dev->geo.blocksize;
       fvdbg("Copy %d bytes into erase block=%d at offset=%d\n",
              nbytes, eraseblock, offset);
       memcpy(dev->eblock + offset, buffer, nbytes);
@@ -268,8 +315,9 @@ static ssize_t ftl_flush(FAR void *priv, FAR const uint8_t *buffer,
 
       /* Then update for amount written */
 
-      remaining -= dev->blkper - (startblock & mask);
-      buffer    += nbytes;
+      dev->flashwrites += dev->blkper;
+      remaining        -= nsect;
+      buffer           += nbytes;
     }
 
   /* How handle full erase pages in the middle */
@@ -286,6 +334,8 @@ static ssize_t ftl_flush(FAR void *priv, FAR const uint8_t *buffer,
           return ret;
         }
 
+      dev->nerases++;
+
       /* Write a full erase back to flash */
 
       fvdbg("Write %d bytes into erase block=%d at offset=0\n",
@@ -299,9 +349,10 @@ static ssize_t ftl_flush(FAR void *priv, FAR const uint8_t *buffer,
 
       /* Then update for amount written */
 
-      alignedblock += dev->blkper;
-      remaining    -= dev->blkper;
-      buffer       += dev->geo.erasesize;
+      dev->flashwrites += dev->blkper;
+      alignedblock     += dev->blkper;
+      remaining        -= dev->blkper;
+      buffer           += dev->geo.erasesize;
     }
 
   /* Finally, handler any partial blocks after the last full erase block */
@@ -327,6 +378,8 @@ static ssize_t ftl_flush(FAR void *priv, FAR const uint8_t *buffer,
           return ret;
         }
 
+      dev->nerases++;
+
       /* Copy the user data at the beginning the buffered erase block */
 
       nbytes = remaining * dev->geo.blocksize;
@@ -342,6 +395,8 @@ static ssize_t ftl_flush(FAR void *priv, FAR const uint8_t *buffer,
           fdbg("Write erase block %d failed: %d\n", alignedblock, nxfrd);
           return -EIO;
         }
+
+      dev->flashwrites += dev->blkper;
     }
 
   return nblocks;
@@ -365,7 +420,7 @@ static ssize_t ftl_write(FAR struct inode *inode, const unsigned char *buffer,
 
   DEBUGASSERT(inode && inode->i_private);
   dev = (struct ftl_struct_s *)inode->i_private;
-#ifdef CONFIG_FS_WRITEBUFFER
+#ifdef CONFIG_FTL_RWBUFFER
   return rwb_write(&dev->rwb, start_sector, nsectors, buffer);
 #else
   return ftl_flush(dev, buffer, start_sector, nsectors);
@@ -397,7 +452,11 @@ static int ftl_geometry(FAR struct inode *inode, struct geometry *geometry)
 #else
       geometry->geo_writeenabled  = false;
 #endif
+#ifdef CONFIG_FTL_LOGSTRUCT
+      geometry->geo_nsectors      = dev->log.nsectors;
+#else
       geometry->geo_nsectors      = dev->geo.neraseblocks * dev->blkper;
+#endif
       geometry->geo_sectorsize    = dev->geo.blocksize;
 
       fvdbg("available: true mediachanged: false writeenabled: %s\n",
@@ -424,9 +483,54 @@ static int ftl_ioctl(FAR struct inode *inode, int cmd, unsigned long arg)
 
   fvdbg("Entry\n");
   DEBUGASSERT(inode && inode->i_private);
+  dev = (struct ftl_struct_s *)inode->i_private;
+
+  /* The BIOC_FTLSTATS command is handled by this driver */
+
+  if (cmd == BIOC_FTLSTATS)
+    {
+      FAR struct ftl_stats_s *stats =
+        (FAR struct ftl_stats_s *)((uintptr_t)arg);
+
+      if (stats == NULL)
+        {
+          return -EINVAL;
+        }
 
-  /* Only one block driver ioctl command is supported by this driver (and
-   * that command is just passed on to the MTD driver in a slightly
+#ifdef CONFIG_FTL_LOGSTRUCT
+      ftl_log_getstats(&dev->log, stats);
+#else
+      memset(stats, 0, sizeof(struct ftl_stats_s));
+      stats->nsectors    = dev->geo.neraseblocks * dev->blkper;
+#ifdef CONFIG_FS_WRITABLE
+      stats->hostwrites  = dev->hostwrites;
+      stats->flashwrites = dev->flashwrites;
+      stats->nerases     = dev->nerases;
+#endif
+#endif
+      return OK;
+    }
+
+#ifdef CONFIG_FTL_RWBUFFER
+  /* So is the BIOC_RWBSTATS command */
+
+  if (cmd == BIOC_RWBSTATS)
+    {
+      FAR struct rwb_stats_s *stats =
+        (FAR struct rwb_stats_s *)((uintptr_t)arg);
+
+      if (stats == NULL)
+        {
+          return -EINVAL;
+        }
+
+      rwb_getstats(&dev->rwb, stats);
+      return OK;
+    }
+#endif
+
+  /* Only one other block driver ioctl command is supported by this driver
+   * (and that command is just passed on to the MTD driver in a slightly
    * different form).
    */
 
@@ -455,7 +559,6 @@ static int ftl_ioctl(FAR struct inode *inode, int cmd, unsigned long arg)
    * to the MTD driver (unchanged).
    */
 
-  dev = (struct ftl_struct_s *)inode->i_private;
   ret = MTD_IOCTL(dev->mtd, cmd, arg);
   if (ret < 0)
     {
@@ -519,9 +622,20 @@ int ftl_initialize(int minor, FAR struct mtd_dev_s *mtd)
           return ret;
         }
 
+#ifdef CONFIG_FTL_LOGSTRUCT
+      /* Rebuild the logical to physical sector map from FLASH */
+
+      ret = ftl_log_initialize(&dev->log, mtd, &dev->geo);
+      if (ret < 0)
+        {
+          fdbg("ftl_log_initialize failed: %d\n", ret);
+          kfree(dev);
+          return ret;
+        }
+
+#elif defined(CONFIG_FS_WRITABLE)
       /* Allocate one, in-memory erase block buffer */
 
-#ifdef CONFIG_FS_WRITABLE
       dev->eblock  = (FAR uint8_t *)kmalloc(dev->geo.erasesize);
       if (!dev->eblock)
         {
@@ -529,6 +643,10 @@ int ftl_initialize(int minor, FAR struct mtd_dev_s *mtd)
           kfree(dev);
           return -ENOMEM;
         }
+
+      dev->hostwrites  = 0;
+      dev->flashwrites = 0;
+      dev->nerases     = 0;
 #endif
 
       /* Get the number of R/W blocks per erase block */
@@ -540,22 +658,37 @@ int ftl_initialize(int minor, FAR struct mtd_dev_s *mtd)
 
 #ifdef CONFIG_FTL_RWBUFFER
       dev->rwb.blocksize   = dev->geo.blocksize;
+#ifdef CONFIG_FTL_LOGSTRUCT
+      dev->rwb.nblocks     = dev->log.nsectors;
+#else
       dev->rwb.nblocks     = dev->geo.neraseblocks * dev->blkper;
+#endif
       dev->rwb.dev         = (FAR void *)dev;
+      dev->rwb.rhreload    = ftl_reload;
+#ifdef CONFIG_FS_WRITABLE
+      dev->rwb.wrflush     = ftl_flush;
+#else
+      dev->rwb.wrflush     = NULL;
+#endif
 
-#if defined(CONFIG_FS_WRITABLE) && defined(CONFIG_FS_WRITEBUFFER)
+#ifdef CONFIG_FS_WRITEBUFFER
+#ifdef CONFIG_FS_WRITABLE
       dev->rwb.wrmaxblocks = dev->blkper;
-      dev->rwb.wrflush     = ftl_flush;
+#else
+      dev->rwb.wrmaxblocks = 0;
+#endif
 #endif
 
 #ifdef CONFIG_FS_READAHEAD
       dev->rwb.rhmaxblocks = dev->blkper;
-      dev->rwb.rhreload    = ftl_reload;
 #endif
       ret = rwb_initialize(&dev->rwb);
       if (ret < 0)
         {
           fdbg("rwb_initialize failed: %d\n", ret);
+#ifdef CONFIG_FTL_LOGSTRUCT
+          ftl_log_uninitialize(&dev->log);
+#endif
           kfree(dev);
           return ret;
         }
@@ -571,6 +704,9 @@ int ftl_initialize(int minor, FAR struct mtd_dev_s *mtd)
       if (ret < 0)
         {
           fdbg("register_blockdriver failed: %d\n", -ret);
+#ifdef CONFIG_FTL_LOGSTRUCT
+          ftl_log_uninitialize(&dev->log);
+#endif
           kfree(dev);
         }
     }
@@ -0,0 +1,1098 @@
+/****************************************************************************
+ * drivers/mtd/ftl_log.c
+ * Log-structured, wear-leveling sector mapping for the FTL
+ *
+ *   Copyright (C) 2012 Gregory Nutt. All rights reserved.
+ *   Author: Gregory Nutt <spudmonkey@racsa.co.cr>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name NuttX nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/types.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <assert.h>
+#include <debug.h>
+#include <errno.h>
+
+#include <nuttx/kmalloc.h>
+#include <nuttx/mtd.h>
+
+#include "ftl_log.h"
+
+#ifdef CONFIG_FTL_LOGSTRUCT
+
+/****************************************************************************
+ * Private Definitions
+ ****************************************************************************/
+
+/* Configuration ************************************************************/
+/* CONFIG_FTL_LOGRESERVE - The number of erase blocks that are not counted
+ *   in the logical size of the device.  This space is what garbage
+ *   collection works with:  More reserved blocks mean fewer relocations
+ *   per sector written when the device is full.  At least two are needed.
+ *   Default: 1/16th of the erase blocks.
+ * CONFIG_FTL_WEARTHRESH - When the erase count of the least worn erase block
+ *   that holds data falls this far behind the most worn erase block, the
+ *   data is moved so that the block is returned to use.  Default: 16.
+ */
+
+#ifndef CONFIG_FTL_WEARTHRESH
+#  define CONFIG_FTL_WEARTHRESH 16
+#endif
+
+/* Physical sector numbers are data slot indices:  The erase block times the
+ * number of data slots per erase block plus the slot.  These macros convert
+ * to and from the R/W block number on the MTD device.
+ */
+
+#define FTL_LOG_PSN(l,e,s)    ((uint32_t)(e) * (l)->dpb + (s))
+#define FTL_LOG_PSNBLOCK(l,p) ((p) / (l)->dpb)
+#define FTL_LOG_PSNSLOT(l,p)  ((p) % (l)->dpb)
+#define FTL_LOG_RWBLOCK(l,p) \
+  ((off_t)FTL_LOG_PSNBLOCK(l,p) * (l)->blkper + (l)->nhdr + FTL_LOG_PSNSLOT(l,p))
+
+#define FTL_LOG_NOBLOCK       ((off_t)-1)
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+/****************************************************************************
+ * Private Function Prototypes
+ ****************************************************************************/
+
+static int ftl_log_collect(FAR struct ftl_log_s *log, off_t victim);
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: ftl_log_rdhdr
+ *
+ * Description:
+ *   Read the header of an erase block into a buffer
+ *
+ ****************************************************************************/
+
+static int ftl_log_rdhdr(FAR struct ftl_log_s *log, off_t eblock,
+                         FAR uint8_t *buffer)
+{
+  ssize_t nxfrd;
+
+  nxfrd = MTD_BREAD(log->mtd, eblock * log->blkper, log->nhdr, buffer);
+  if (nxfrd != log->nhdr)
+    {
+      fdbg("Read header of erase block %d failed: %d\n", eblock, nxfrd);
+      return -EIO;
+    }
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: ftl_log_wrhdr
+ *
+ * Description:
+ *   Write the header of an erase block.  Only fields that are still erased
+ *   in FLASH may differ from the FLASH contents.
+ *
+ ****************************************************************************/
+
+static int ftl_log_wrhdr(FAR struct ftl_log_s *log, off_t eblock,
+                         FAR const uint8_t *buffer)
+{
+  ssize_t nxfrd;
+
+  nxfrd = MTD_BWRITE(log->mtd, eblock * log->blkper, log->nhdr, buffer);
+  if (nxfrd != log->nhdr)
+    {
+      fdbg("Write header of erase block %d failed: %d\n", eblock, nxfrd);
+      return -EIO;
+    }
+
+  log->hdrwrites++;
+  return OK;
+}
+
+/****************************************************************************
+ * Name: ftl_log_flushhdr
+ *
+ * Description:
+ *   Commit the logical sector numbers of the data written to the write
+ *   block by writing its header to FLASH.
+ *
+ ****************************************************************************/
+
+static int ftl_log_flushhdr(FAR struct ftl_log_s *log)
+{
+  int ret = OK;
+
+  if (log->hdrdirty)
+    {
+      ret = ftl_log_wrhdr(log, log->wrblock, log->wrhdr);
+      if (ret == OK)
+        {
+          log->hdrdirty = false;
+        }
+    }
+
+  return ret;
+}
+
+/****************************************************************************
+ * Name: ftl_log_erase
+ *
+ * Description:
+ *   Erase one erase block and write the header of a free block with the new
+ *   erase count.
+ *
+ ****************************************************************************/
+
+static int ftl_log_erase(FAR struct ftl_log_s *log, off_t eblock)
+{
+  FAR struct ftl_logblock_s *blk = &log->blocks[eblock];
+  FAR struct ftl_loghdr_s *hdr;
+  int ret;
+
+  ret = MTD_ERASE(log->mtd, eblock, 1);
+  if (ret < 0)
+    {
+      fdbg("Erase block=%d failed: %d\n", eblock, ret);
+      return ret;
+    }
+
+  log->nerases++;
+  blk->erasecount++;
+  blk->seq    = FTL_LOG_ERASED32;
+  blk->nvalid = 0;
+
+  /* Write the header of a free block */
+
+  memset(log->rdhdr, FTL_LOG_ERASEDSTATE, log->nhdr * log->geo.blocksize);
+  hdr = (FAR struct ftl_loghdr_s *)log->rdhdr;
+  memcpy(hdr->magic, FTL_LOG_MAGIC, FTL_LOG_MAGICSIZE);
+  hdr->erasecount = blk->erasecount;
+
+  ret = ftl_log_wrhdr(log, eblock, log->rdhdr);
+  if (ret < 0)
+    {
+      /* It will be erased again when the FTL is next initialized */
+
+      blk->state = FTL_LOGBLK_ERASE;
+      return ret;
+    }
+
+  blk->state = FTL_LOGBLK_FREE;
+  log->nfree++;
+  return OK;
+}
+
+/****************************************************************************
+ * Name: ftl_log_openblock
+ *
+ * Description:
+ *   Make the least worn free erase block the new write block.
+ *
+ ****************************************************************************/
+
+static int ftl_log_openblock(FAR struct ftl_log_s *log)
+{
+  FAR struct ftl_logblock_s *blk;
+  FAR struct ftl_loghdr_s *hdr;
+  off_t eblock = FTL_LOG_NOBLOCK;
+  off_t i;
+  int ret;
+
+  for (i = 0; i < log->geo.neraseblocks; i++)
+    {
+      blk = &log->blocks[i];
+      if (blk->state == FTL_LOGBLK_FREE &&
+          (eblock == FTL_LOG_NOBLOCK ||
+           blk->erasecount < log->blocks[eblock].erasecount))
+        {
+          eblock = i;
+        }
+    }
+
+  if (eblock == FTL_LOG_NOBLOCK)
+    {
+      fdbg("No free erase blocks\n");
+      return -ENOSPC;
+    }
+
+  /* Assign the next sequence number to the block */
+
+  blk = &log->blocks[eblock];
+  memset(log->wrhdr, FTL_LOG_ERASEDSTATE, log->nhdr * log->geo.blocksize);
+  hdr = (FAR struct ftl_loghdr_s *)log->wrhdr;
+  memcpy(hdr->magic, FTL_LOG_MAGIC, FTL_LOG_MAGICSIZE);
+  hdr->erasecount = blk->erasecount;
+  hdr->seq        = log->nextseq;
+
+  ret = ftl_log_wrhdr(log, eblock, log->wrhdr);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  blk->seq     = log->nextseq++;
+  blk->state   = FTL_LOGBLK_USED;
+  log->nfree--;
+  log->wrblock = eblock;
+  log->wrslot  = 0;
+  return OK;
+}
+
+/****************************************************************************
+ * Name: ftl_log_victim
+ *
+ * Description:
+ *   Select the erase block to be reclaimed:  If 'cold' is true, this is the
+ *   least worn block holding data.  Otherwise, it is the block with the
+ *   fewest valid sectors (the least worn of those if there is a tie).
+ *
+ ****************************************************************************/
+
+static off_t ftl_log_victim(FAR struct ftl_log_s *log, bool cold)
+{
+  FAR struct ftl_logblock_s *blk;
+  FAR struct ftl_logblock_s *best = NULL;
+  off_t victim = FTL_LOG_NOBLOCK;
+  off_t i;
+
+  for (i = 0; i < log->geo.neraseblocks; i++)
+    {
+      blk = &log->blocks[i];
+      if (blk->state != FTL_LOGBLK_USED || i == log->wrblock)
+        {
+          continue;
+        }
+
+      if (best == NULL ||
+          (cold && blk->erasecount < best->erasecount) ||
+          (!cold && (blk->nvalid < best->nvalid ||
+                     (blk->nvalid == best->nvalid &&
+                      blk->erasecount < best->erasecount))))
+        {
+          best   = blk;
+          victim = i;
+        }
+    }
+
+  return victim;
+}
+
+/****************************************************************************
+ * Name: ftl_log_wearcheck
+ *
+ * Description:
+ *   Return the least worn block holding data if it has fallen more than
+ *   CONFIG_FTL_WEARTHRESH erase cycles behind the most worn block.
+ *
+ ****************************************************************************/
+
+static off_t ftl_log_wearcheck(FAR struct ftl_log_s *log)
+{
+  uint32_t maxerase = 0;
+  off_t victim;
+  off_t i;
+
+  victim = ftl_log_victim(log, true);
+  if (victim != FTL_LOG_NOBLOCK)
+    {
+      for (i = 0; i < log->geo.neraseblocks; i++)
+        {
+          if (log->blocks[i].erasecount > maxerase)
+            {
+              maxerase = log->blocks[i].erasecount;
+            }
+        }
+
+      if (maxerase - log->blocks[victim].erasecount <= CONFIG_FTL_WEARTHRESH)
+        {
+          victim = FTL_LOG_NOBLOCK;
+        }
+    }
+
+  return victim;
+}
+
+/****************************************************************************
+ * Name: ftl_log_getslot
+ *
+ * Description:
+ *   Make sure that the write block has at least one free slot.  When a new
+ *   write block is needed, garbage is first collected until at least two
+ *   free erase blocks are available (one to become the new write block and
+ *   one to receive the sectors relocated by the next collection).  Once
+ *   for each new write block, a cold block is also relocated if wear
+ *   leveling requires it.
+ *
+ *   When called during garbage collection ('gc' true), only a free block
+ *   is taken.
+ *
+ ****************************************************************************/
+
+static int ftl_log_getslot(FAR struct ftl_log_s *log, bool gc)
+{
+  bool wearchecked = false;
+  off_t victim;
+  int ret;
+
+  while (log->wrblock == FTL_LOG_NOBLOCK || log->wrslot >= log->dpb)
+    {
+      /* Commit the full write block before moving on */
+
+      if (log->wrblock != FTL_LOG_NOBLOCK)
+        {
+          ret = ftl_log_flushhdr(log);
+          if (ret < 0)
+            {
+              return ret;
+            }
+        }
+
+      if (!gc)
+        {
+          if (log->nfree < 2)
+            {
+              victim = ftl_log_victim(log, false);
+              if (victim == FTL_LOG_NOBLOCK ||
+                  log->blocks[victim].nvalid >= log->dpb)
+                {
+                  fdbg("No garbage to collect\n");
+                  return -ENOSPC;
+                }
+
+              ret = ftl_log_collect(log, victim);
+              if (ret < 0)
+                {
+                  return ret;
+                }
+
+              continue;
+            }
+
+          if (!wearchecked)
+            {
+              wearchecked = true;
+              victim      = ftl_log_wearcheck(log);
+              if (victim != FTL_LOG_NOBLOCK)
+                {
+                  fvdbg("Relocating cold erase block %d\n", victim);
+                  ret = ftl_log_collect(log, victim);
+                  if (ret < 0)
+                    {
+                      return ret;
+                    }
+
+                  continue;
+                }
+            }
+        }
+
+      ret = ftl_log_openblock(log);
+      if (ret < 0)
+        {
+          return ret;
+        }
+    }
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: ftl_log_remap
+ *
+ * Description:
+ *   Record that the newest copy of a logical sector is now in the write
+ *   block at 'slot'.
+ *
+ ****************************************************************************/
+
+static void ftl_log_remap(FAR struct ftl_log_s *log, uint32_t lsn,
+                          uint16_t slot)
+{
+  FAR struct ftl_loghdr_s *hdr = (FAR struct ftl_loghdr_s *)log->wrhdr;
+  uint32_t psn = log->map[lsn];
+
+  if (psn != FTL_LOG_UNMAPPED)
+    {
+      log->blocks[FTL_LOG_PSNBLOCK(log, psn)].nvalid--;
+    }
+
+  hdr->lsn[slot]  = lsn;
+  log->hdrdirty   = true;
+  log->map[lsn]   = FTL_LOG_PSN(log, log->wrblock, slot);
+  log->blocks[log->wrblock].nvalid++;
+}
+
+/****************************************************************************
+ * Name: ftl_log_collect
+ *
+ * Description:
+ *   Copy the valid sectors of an erase block to the write block, commit
+ *   them, and erase the block.
+ *
+ ****************************************************************************/
+
+static int ftl_log_collect(FAR struct ftl_log_s *log, off_t victim)
+{
+  FAR struct ftl_loghdr_s *hdr = (FAR struct ftl_loghdr_s *)log->rdhdr;
+  uint32_t lsn;
+  uint32_t psn;
+  ssize_t nxfrd;
+  uint16_t slot;
+  int ret;
+
+  fvdbg("Collecting erase block %d: %d valid\n",
+        victim, log->blocks[victim].nvalid);
+
+  /* Get the logical sector number of each slot of the victim */
+
+  if (log->blocks[victim].nvalid > 0)
+    {
+      ret = ftl_log_rdhdr(log, victim, log->rdhdr);
+      if (ret < 0)
+        {
+          return ret;
+        }
+    }
+
+  for (slot = 0; slot < log->dpb && log->blocks[victim].nvalid > 0; slot++)
+    {
+      /* Is this slot the newest copy of its sector? */
+
+      lsn = hdr->lsn[slot];
+      psn = FTL_LOG_PSN(log, victim, slot);
+      if (lsn >= log->nsectors || log->map[lsn] != psn)
+        {
+          continue;
+        }
+
+      /* Yes.. copy it to the write block */
+
+      nxfrd = MTD_BREAD(log->mtd, FTL_LOG_RWBLOCK(log, psn), 1, log->sector);
+      if (nxfrd != 1)
+        {
+          fdbg("Read sector %d failed: %d\n", psn, nxfrd);
+          return -EIO;
+        }
+
+      ret = ftl_log_getslot(log, true);
+      if (ret < 0)
+        {
+          return ret;
+        }
+
+      psn   = FTL_LOG_PSN(log, log->wrblock, log->wrslot);
+      nxfrd = MTD_BWRITE(log->mtd, FTL_LOG_RWBLOCK(log, psn), 1, log->sector);
+      if (nxfrd != 1)
+        {
+          fdbg("Write sector %d failed: %d\n", psn, nxfrd);
+          return -EIO;
+        }
+
+      log->flashwrites++;
+      ftl_log_remap(log, lsn, log->wrslot);
+      log->wrslot++;
+    }
+
+  /* The relocated sectors must be committed before the only other copy is
+   * erased.
+   */
+
+  ret = ftl_log_flushhdr(log);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  DEBUGASSERT(log->blocks[victim].nvalid == 0);
+  return ftl_log_erase(log, victim);
+}
+
+/****************************************************************************
+ * Name: ftl_log_isblank
+ *
+ * Description:
+ *   Return true if a data slot is still in the erased state
+ *
+ ****************************************************************************/
+
+static bool ftl_log_isblank(FAR struct ftl_log_s *log, uint32_t psn)
+{
+  ssize_t nxfrd;
+  int i;
+
+  nxfrd = MTD_BREAD(log->mtd, FTL_LOG_RWBLOCK(log, psn), 1, log->sector);
+  if (nxfrd != 1)
+    {
+      return false;
+    }
+
+  for (i = 0; i < log->geo.blocksize; i++)
+    {
+      if (log->sector[i] != FTL_LOG_ERASEDSTATE)
+        {
+          return false;
+        }
+    }
+
+  return true;
+}
+
+/****************************************************************************
+ * Name: ftl_log_mount
+ *
+ * Description:
+ *   Rebuild the logical to physical sector map, the per-erase block state
+ *   and the write position from the erase block headers in FLASH.
+ *
+ ****************************************************************************/
+
+static int ftl_log_mount(FAR struct ftl_log_s *log)
+{
+  FAR struct ftl_loghdr_s *hdr = (FAR struct ftl_loghdr_s *)log->rdhdr;
+  FAR struct ftl_logblock_s *blk;
+  uint32_t totalerase = 0;
+  uint32_t nknown = 0;
+  uint32_t maxseq = 0;
+  uint32_t lsn;
+  uint32_t psn;
+  uint32_t old;
+  off_t eblock;
+  uint16_t slot;
+  int ret;
+
+  for (lsn = 0; lsn < log->nsectors; lsn++)
+    {
+      log->map[lsn] = FTL_LOG_UNMAPPED;
+    }
+
+  log->wrblock = FTL_LOG_NOBLOCK;
+  log->nfree   = 0;
+
+  /* Examine the header of each erase block */
+
+  for (eblock = 0; eblock < log->geo.neraseblocks; eblock++)
+    {
+      blk         = &log->blocks[eblock];
+      blk->nvalid = 0;
+
+      ret = ftl_log_rdhdr(log, eblock, log->rdhdr);
+      if (ret < 0 || memcmp(hdr->magic, FTL_LOG_MAGIC, FTL_LOG_MAGICSIZE) != 0 ||
+          hdr->erasecount == FTL_LOG_ERASED32)
+        {
+          /* Not formatted (or an erase was interrupted) */
+
+          blk->state      = FTL_LOGBLK_ERASE;
+          blk->erasecount = FTL_LOG_ERASED32;
+          blk->seq        = FTL_LOG_ERASED32;
+          continue;
+        }
+
+      blk->erasecount = hdr->erasecount;
+      blk->seq        = hdr->seq;
+      totalerase     += hdr->erasecount;
+      nknown++;
+
+      if (hdr->seq == FTL_LOG_ERASED32)
+        {
+          blk->state = FTL_LOGBLK_FREE;
+          log->nfree++;
+          continue;
+        }
+
+      blk->state = FTL_LOGBLK_USED;
+      if (log->wrblock == FTL_LOG_NOBLOCK || hdr->seq > maxseq)
+        {
+          maxseq       = hdr->seq;
+          log->wrblock = eblock;
+        }
+
+      /* A later slot of the same block or a block with a larger sequence
+       * number holds the newer copy of a sector.
+       */
+
+      for (slot = 0; slot < log->dpb; slot++)
+        {
+          lsn = hdr->lsn[slot];
+          if (lsn >= log->nsectors)
+            {
+              continue;
+            }
+
+          old = log->map[lsn];
+          if (old == FTL_LOG_UNMAPPED ||
+              FTL_LOG_PSNBLOCK(log, old) == eblock ||
+              log->blocks[FTL_LOG_PSNBLOCK(log, old)].seq < hdr->seq)
+            {
+              log->map[lsn] = FTL_LOG_PSN(log, eblock, slot);
+            }
+        }
+    }
+
+  /* Count the valid sectors in each erase block */
+
+  for (lsn = 0; lsn < log->nsectors; lsn++)
+    {
+      psn = log->map[lsn];
+      if (psn != FTL_LOG_UNMAPPED)
+        {
+          log->blocks[FTL_LOG_PSNBLOCK(log, psn)].nvalid++;
+        }
+    }
+
+  /* Erase blocks that hold no valid sectors.  If power was lost during
+   * garbage collection, there may be no free block left; this recovers one
+   * (either the collected block or the new write block that never had its
+   * copies committed).
+   */
+
+  for (eblock = 0; eblock < log->geo.neraseblocks; eblock++)
+    {
+      blk = &log->blocks[eblock];
+      if (blk->state == FTL_LOGBLK_USED && blk->nvalid == 0)
+        {
+          blk->state = FTL_LOGBLK_ERASE;
+          if (eblock == log->wrblock)
+            {
+              log->wrblock = FTL_LOG_NOBLOCK;
+            }
+        }
+    }
+
+  /* Then erase them along with blocks that have no valid header.  The erase
+   * count of a block without a header is not known; use the average of the
+   * others.
+   */
+
+  for (eblock = 0; eblock < log->geo.neraseblocks; eblock++)
+    {
+      blk = &log->blocks[eblock];
+      if (blk->state == FTL_LOGBLK_ERASE)
+        {
+          if (blk->erasecount == FTL_LOG_ERASED32)
+            {
+              blk->erasecount = nknown > 0 ? totalerase / nknown : 0;
+            }
+
+          ret = ftl_log_erase(log, eblock);
+          if (ret < 0)
+            {
+              return ret;
+            }
+        }
+    }
+
+  /* Resume writing in the block with the largest sequence number, after
+   * the last committed slot and after any data that was written but never
+   * committed.
+   */
+
+  log->nextseq  = maxseq + 1;
+  log->hdrdirty = false;
+  log->wrslot   = 0;
+
+  if (log->wrblock != FTL_LOG_NOBLOCK)
+    {
+      ret = ftl_log_rdhdr(log, log->wrblock, log->wrhdr);
+      if (ret < 0)
+        {
+          return ret;
+        }
+
+      hdr = (FAR struct ftl_loghdr_s *)log->wrhdr;
+      for (slot = 0; slot < log->dpb; slot++)
+        {
+          if (hdr->lsn[slot] != FTL_LOG_ERASED32 ||
+              !ftl_log_isblank(log, FTL_LOG_PSN(log, log->wrblock, slot)))
+            {
+              log->wrslot = slot + 1;
+            }
+        }
+    }
+
+  fvdbg("nsectors: %d nfree: %d wrblock: %d wrslot: %d\n",
+        log->nsectors, log->nfree, log->wrblock, log->wrslot);
+  return OK;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: ftl_log_initialize
+ *
+ * Description:
+ *   Initialize the log-structured FTL state for an MTD device.  The logical
+ *   to physical sector map is rebuilt from the erase block headers in FLASH.
+ *   Erase blocks without a valid header are erased (so the first
+ *   initialization of a blank or foreign device formats it).
+ *
+ * Input Parameters:
+ *   log - The FTL state to be initialized
+ *   mtd - The MTD device that supports the FLASH interface.
+ *   geo - The geometry of the MTD device
+ *
+ * Returned Value:
+ *   Zero on success; a negated errno value on failure.
+ *
+ ****************************************************************************/
+
+int ftl_log_initialize(FAR struct ftl_log_s *log, FAR struct mtd_dev_s *mtd,
+                       FAR const struct mtd_geometry_s *geo)
+{
+  size_t hdrsize;
+  size_t nreserve;
+  int ret;
+
+  memset(log, 0, sizeof(struct ftl_log_s));
+  log->mtd = mtd;
+  memcpy(&log->geo, geo, sizeof(struct mtd_geometry_s));
+
+  /* Get the size of the erase block header and the number of data slots
+   * that remain in each erase block.
+   */
+
+  log->blkper = geo->erasesize / geo->blocksize;
+  hdrsize     = SIZEOF_FTL_LOGHDR_S(log->blkper);
+  log->nhdr   = (hdrsize + geo->blocksize - 1) / geo->blocksize;
+  if (log->nhdr >= log->blkper)
+    {
+      fdbg("Erase block too small: %d R/W blocks\n", log->blkper);
+      return -EINVAL;
+    }
+
+  log->dpb = log->blkper - log->nhdr;
+
+  /* Get the number of logical sectors */
+
+#ifdef CONFIG_FTL_LOGRESERVE
+  nreserve = CONFIG_FTL_LOGRESERVE;
+#else
+  nreserve = geo->neraseblocks / 16;
+#endif
+  if (nreserve < 2)
+    {
+      nreserve = 2;
+    }
+
+  if (geo->neraseblocks <= nreserve)
+    {
+      fdbg("Too few erase blocks: %d\n", geo->neraseblocks);
+      return -EINVAL;
+    }
+
+  log->nsectors = (geo->neraseblocks - nreserve) * log->dpb;
+
+  /* Allocate the map, the erase block state and the buffers */
+
+  log->map    = (FAR uint32_t *)kmalloc(log->nsectors * sizeof(uint32_t));
+  log->blocks = (FAR struct ftl_logblock_s *)
+    kmalloc(geo->neraseblocks * sizeof(struct ftl_logblock_s));
+  log->wrhdr  = (FAR uint8_t *)kmalloc(log->nhdr * geo->blocksize);
+  log->rdhdr  = (FAR uint8_t *)kmalloc(log->nhdr * geo->blocksize);
+  log->sector = (FAR uint8_t *)kmalloc(geo->blocksize);
+
+  if (!log->map || !log->blocks || !log->wrhdr || !log->rdhdr || !log->sector)
+    {
+      fdbg("Failed to allocate the sector map\n");
+      ret = -ENOMEM;
+      goto errout;
+    }
+
+  /* Then rebuild the map from FLASH */
+
+  ret = ftl_log_mount(log);
+  if (ret < 0)
+    {
+      goto errout;
+    }
+
+  return OK;
+
+errout:
+  ftl_log_uninitialize(log);
+  return ret;
+}
+
+/****************************************************************************
+ * Name: ftl_log_uninitialize
+ *
+ * Description:
+ *   Free all resources held by the log-structured FTL.
+ *
+ ****************************************************************************/
+
+void ftl_log_uninitialize(FAR struct ftl_log_s *log)
+{
+  if (log->map)
+    {
+      kfree(log->map);
+      log->map = NULL;
+    }
+
+  if (log->blocks)
+    {
+      kfree(log->blocks);
+      log->blocks = NULL;
+    }
+
+  if (log->wrhdr)
+    {
+      kfree(log->wrhdr);
+      log->wrhdr = NULL;
+    }
+
+  if (log->rdhdr)
+    {
+      kfree(log->rdhdr);
+      log->rdhdr = NULL;
+    }
+
+  if (log->sector)
+    {
+      kfree(log->sector);
+      log->sector = NULL;
+    }
+}
+
+/****************************************************************************
+ * Name: ftl_log_read
+ *
+ * Description:
+ *   Read logical sectors.  Sectors that have never been written read back
+ *   in the erased state.
+ *
+ * Returned Value:
+ *   The number of sectors read on success; a negated errno value on failure.
+ *
+ ****************************************************************************/
+
+ssize_t ftl_log_read(FAR struct ftl_log_s *log, FAR uint8_t *buffer,
+                     off_t startsector, size_t nsectors)
+{
+  uint32_t psn;
+  size_t remaining;
+  size_t nrun;
+  ssize_t nxfrd;
+
+  if (startsector >= log->nsectors)
+    {
+      return -EINVAL;
+    }
+
+  if (startsector + nsectors > log->nsectors)
+    {
+      nsectors = log->nsectors - startsector;
+    }
+
+  remaining = nsectors;
+  while (remaining > 0)
+    {
+      psn = log->map[startsector];
+      if (psn == FTL_LOG_UNMAPPED)
+        {
+          memset(buffer, FTL_LOG_ERASEDSTATE, log->geo.blocksize);
+          nrun = 1;
+        }
+      else
+        {
+          /* Read the whole run of sectors that are in consecutive slots
+           * of the same erase block with one transfer.
+           */
+
+          nrun = 1;
+          while (nrun < remaining &&
+                 FTL_LOG_PSNSLOT(log, psn) + nrun < log->dpb &&
+                 log->map[startsector + nrun] == psn + nrun)
+            {
+              nrun++;
+            }
+
+          nxfrd = MTD_BREAD(log->mtd, FTL_LOG_RWBLOCK(log, psn), nrun, buffer);
+          if (nxfrd != nrun)
+            {
+              fdbg("Read %d sectors at %d failed: %d\n", nrun, psn, nxfrd);
+              return -EIO;
+            }
+        }
+
+      startsector += nrun;
+      remaining   -= nrun;
+      buffer      += nrun * log->geo.blocksize;
+    }
+
+  return nsectors;
+}
+
+/****************************************************************************
+ * Name: ftl_log_write
+ *
+ * Description:
+ *   Write logical sectors.  The data is written to the next free slots of
+ *   the write block; the previous copies of the sectors become garbage.
+ *
+ * Returned Value:
+ *   The number of sectors written on success; a negated errno value on
+ *   failure.
+ *
+ ****************************************************************************/
+
+ssize_t ftl_log_write(FAR struct ftl_log_s *log, FAR const uint8_t *buffer,
+                      off_t startsector, size_t nsectors)
+{
+  uint32_t psn;
+  size_t remaining;
+  size_t nrun;
+  ssize_t nxfrd;
+  int ret;
+  int i;
+
+  if (startsector >= log->nsectors)
+    {
+      return -EINVAL;
+    }
+
+  if (startsector + nsectors > log->nsectors)
+    {
+      nsectors = log->nsectors - startsector;
+    }
+
+  remaining = nsectors;
+  while (remaining > 0)
+    {
+      /* Get space in the write block (collecting garbage if necessary) */
+
+      ret = ftl_log_getslot(log, false);
+      if (ret < 0)
+        {
+          return ret;
+        }
+
+      /* Write as many sectors as will fit into the write block */
+
+      nrun = log->dpb - log->wrslot;
+      if (nrun > remaining)
+        {
+          nrun = remaining;
+        }
+
+      psn   = FTL_LOG_PSN(log, log->wrblock, log->wrslot);
+      nxfrd = MTD_BWRITE(log->mtd, FTL_LOG_RWBLOCK(log, psn), nrun, buffer);
+      if (nxfrd != nrun)
+        {
+          fdbg("Write %d sectors at %d failed: %d\n", nrun, psn, nxfrd);
+          return -EIO;
+        }
+
+      /* Then commit them */
+
+      for (i = 0; i < nrun; i++)
+        {
+          ftl_log_remap(log, startsector + i, log->wrslot + i);
+        }
+
+      log->wrslot += nrun;
+      ret = ftl_log_flushhdr(log);
+      if (ret < 0)
+        {
+          return ret;
+        }
+
+      log->hostwrites  += nrun;
+      log->flashwrites += nrun;
+      startsector      += nrun;
+      remaining        -= nrun;
+      buffer           += nrun * log->geo.blocksize;
+    }
+
+  return nsectors;
+}
+
+/****************************************************************************
+ * Name: ftl_log_getstats
+ *
+ * Description:
+ *   Report write amplification and erase count statistics.
+ *
+ ****************************************************************************/
+
+void ftl_log_getstats(FAR struct ftl_log_s *log,
+                      FAR struct ftl_stats_s *stats)
+{
+  uint32_t erasecount;
+  uint32_t totalerase = 0;
+  off_t i;
+
+  stats->nsectors    = log->nsectors;
+  stats->nfree       = log->nfree;
+  stats->hostwrites  = log->hostwrites;
+  stats->flashwrites = log->flashwrites;
+  stats->hdrwrites   = log->hdrwrites;
+  stats->nerases     = log->nerases;
+  stats->minerase    = FTL_LOG_ERASED32;
+  stats->maxerase    = 0;
+
+  for (i = 0; i < log->geo.neraseblocks; i++)
+    {
+      erasecount  = log->blocks[i].erasecount;
+      totalerase += erasecount;
+
+      if (erasecount < stats->minerase)
+        {
+          stats->minerase = erasecount;
+        }
+
+      if (erasecount > stats->maxerase)
+        {
+          stats->maxerase = erasecount;
+        }
+    }
+
+  stats->avgerase = totalerase / log->geo.neraseblocks;
+}
+
+#endif /* CONFIG_FTL_LOGSTRUCT */
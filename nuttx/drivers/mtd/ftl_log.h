@@ -0,0 +1,248 @@
+/****************************************************************************
+ * drivers/mtd/ftl_log.h
+ *
+ *   Copyright (C) 2012 Gregory Nutt. All rights reserved.
+ *   Author: Gregory Nutt <spudmonkey@racsa.co.cr>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name NuttX nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+#ifndef __DRIVERS_MTD_FTL_LOG_H
+#define __DRIVERS_MTD_FTL_LOG_H
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/types.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <nuttx/mtd.h>
+
+#ifdef CONFIG_FTL_LOGSTRUCT
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+/* Log-structured FTL organization.  The following example assumes 8 R/W
+ * blocks per FLASH erase block and a one block header.  The actual
+ * relationship is determined by the FLASH geometry reported by the MTD
+ * driver.
+ *
+ * ERASE R/W
+ * BLOCK BLOCK       CONTENTS
+ *   n   8*n     --+--------------+
+ *                 |HHHHHHHHHHHHHH| Erase block header:  Magic, erase count,
+ *                 |HHHHHHHHHHHHHH| sequence number and the logical sector
+ *                 |HHHHHHHHHHHHHH| number held in each data slot.
+ *       8*n+1   --+--------------+
+ *                 |DDDDDDDDDDDDDD| Data slot 0
+ *       8*n+2   --+--------------+
+ *                 |DDDDDDDDDDDDDD| Data slot 1
+ *                 ~              ~
+ *       8*n+7   --+--------------+
+ *                 |DDDDDDDDDDDDDD| Data slot 6
+ *   n+1 8*(n+1) --+--------------+
+ *
+ * The header is programmed in stages.  Each stage only changes fields that
+ * are still in the erased state so the header never needs to be erased
+ * separately:
+ *
+ * 1. After the erase block is erased, the magic number and the new erase
+ *    count are written.  The block is now free.
+ * 2. When the block becomes the write block, the sequence number is written.
+ * 3. After data is written to a slot, the logical sector number of that slot
+ *    is written.  This commits the data.
+ *
+ * Sectors are never re-written in place.  The newest copy of a logical
+ * sector is the one in the block with the largest sequence number (or, in
+ * the same block, the one in the highest slot).  Older copies are garbage
+ * that is reclaimed by copying the remaining valid sectors of an erase block
+ * to the write block and then erasing it.
+ */
+
+#define FTL_LOG_MAGIC       "FtlL"
+#define FTL_LOG_MAGICSIZE   4
+#define FTL_LOG_ERASED32    0xffffffff
+#define FTL_LOG_ERASEDSTATE 0xff
+
+/* Size of the fixed part of the erase block header (magic, erase count
+ * and sequence number) and of the whole header with 'n' data slots.
+ */
+
+#define SIZEOF_FTL_LOGHDR_S(n) (12 + 4 * (n))
+
+/* Values of the per-erase block state */
+
+#define FTL_LOGBLK_FREE     0   /* Erased with a header, not yet written */
+#define FTL_LOGBLK_USED     1   /* Holds (or held) data */
+#define FTL_LOGBLK_ERASE    2   /* No valid header; must be erased */
+
+/* Special physical sector number used for unmapped logical sectors */
+
+#define FTL_LOG_UNMAPPED    0xffffffff
+
+/****************************************************************************
+ * Public Types
+ ****************************************************************************/
+
+/* This is the form of the erase block header as it appears in FLASH.  The
+ * header is always read into a word-aligned buffer.
+ */
+
+struct ftl_loghdr_s
+{
+  uint8_t  magic[4];    /* 0-3:   FTL_LOG_MAGIC */
+  uint32_t erasecount;  /* 4-7:   Number of times the block has been erased */
+  uint32_t seq;         /* 8-11:  Sequence number (erased if free) */
+  uint32_t lsn[1];      /* 12-:   Logical sector number in each data slot */
+};
+
+/* This is the in-memory state of one erase block */
+
+struct ftl_logblock_s
+{
+  uint32_t erasecount;  /* Number of times the block has been erased */
+  uint32_t seq;         /* Sequence number from the header */
+  uint16_t nvalid;      /* Number of slots holding the newest copy of a sector */
+  uint8_t  state;       /* See FTL_LOGBLK_* definitions */
+};
+
+/* This structure describes the state of the log-structured FTL */
+
+struct ftl_log_s
+{
+  FAR struct mtd_dev_s *mtd;     /* Contained MTD interface */
+  struct mtd_geometry_s geo;     /* Device geometry */
+  uint16_t blkper;               /* R/W blocks per erase block */
+  uint16_t nhdr;                 /* R/W blocks in each erase block header */
+  uint16_t dpb;                  /* Data slots per erase block */
+  uint16_t wrslot;               /* Next free data slot in the write block */
+  off_t    wrblock;              /* The erase block being written */
+  bool     hdrdirty;             /* The write block header must be written */
+  uint32_t nsectors;             /* Number of logical sectors */
+  uint32_t nfree;                /* Number of free erase blocks */
+  uint32_t nextseq;              /* Next sequence number to assign */
+  FAR uint32_t *map;             /* Logical to physical sector map */
+  FAR struct ftl_logblock_s *blocks; /* State of each erase block */
+  FAR uint8_t *wrhdr;            /* Header of the write block */
+  FAR uint8_t *rdhdr;            /* Header of any other erase block */
+  FAR uint8_t *sector;           /* One sector buffer used for relocation */
+
+  /* Statistics since the FTL was initialized */
+
+  uint32_t hostwrites;           /* Sectors written by the file system */
+  uint32_t flashwrites;          /* Sectors programmed, including relocations */
+  uint32_t hdrwrites;            /* Header programming operations */
+  uint32_t nerases;              /* Erase operations */
+};
+
+/****************************************************************************
+ * Public Function Prototypes
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: ftl_log_initialize
+ *
+ * Description:
+ *   Initialize the log-structured FTL state for an MTD device.  The logical
+ *   to physical sector map is rebuilt from the erase block headers in FLASH.
+ *   Erase blocks without a valid header are erased (so the first
+ *   initialization of a blank or foreign device formats it).
+ *
+ * Input Parameters:
+ *   log - The FTL state to be initialized
+ *   mtd - The MTD device that supports the FLASH interface.
+ *   geo - The geometry of the MTD device
+ *
+ * Returned Value:
+ *   Zero on success; a negated errno value on failure.
+ *
+ ****************************************************************************/
+
+int ftl_log_initialize(FAR struct ftl_log_s *log, FAR struct mtd_dev_s *mtd,
+                       FAR const struct mtd_geometry_s *geo);
+
+/****************************************************************************
+ * Name: ftl_log_uninitialize
+ *
+ * Description:
+ *   Free all resources held by the log-structured FTL.
+ *
+ ****************************************************************************/
+
+void ftl_log_uninitialize(FAR struct ftl_log_s *log);
+
+/****************************************************************************
+ * Name: ftl_log_read
+ *
+ * Description:
+ *   Read logical sectors.  Sectors that have never been written read back
+ *   in the erased state.
+ *
+ * Returned Value:
+ *   The number of sectors read on success; a negated errno value on failure.
+ *
+ ****************************************************************************/
+
+ssize_t ftl_log_read(FAR struct ftl_log_s *log, FAR uint8_t *buffer,
+                     off_t startsector, size_t nsectors);
+
+/****************************************************************************
+ * Name: ftl_log_write
+ *
+ * Description:
+ *   Write logical sectors.  The data is written to the next free slots of
+ *   the write block; the previous copies of the sectors become garbage.
+ *
+ * Returned Value:
+ *   The number of sectors written on success; a negated errno value on
+ *   failure.
+ *
+ ****************************************************************************/
+
+ssize_t ftl_log_write(FAR struct ftl_log_s *log, FAR const uint8_t *buffer,
+                      off_t startsector, size_t nsectors);
+
+/****************************************************************************
+ * Name: ftl_log_getstats
+ *
+ * Description:
+ *   Report write amplification and erase count statistics.
+ *
+ ****************************************************************************/
+
+void ftl_log_getstats(FAR struct ftl_log_s *log,
+                      FAR struct ftl_stats_s *stats);
+
+#endif /* CONFIG_FTL_LOGSTRUCT */
+#endif /* __DRIVERS_MTD_FTL_LOG_H */
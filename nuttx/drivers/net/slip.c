@@ -165,7 +165,7 @@ struct slip_driver_s
   int           fd;         /* TTY file descriptor */
   pid_t         rxpid;      /* Receiver thread ID */
   pid_t         txpid;      /* Transmitter thread ID */
-  sem_t         waitsem;    /* Mutually exclusive access to uIP */
+  sem_t         waitsem;    /* Used to wait for the RX and TX tasks to start */
   uint16_t      rxlen;      /* The number of bytes in rxbuf */
 
   /* Driver statistics */
@@ -415,7 +415,8 @@ static int slip_transmit(FAR struct slip_driver_s *priv)
  *   OK on success; a negated errno on failure
  *
  * Assumptions:
- *   The initiator of the poll holds the priv->waitsem;
+ *   The initiator of the poll holds the device lock.  uip_poll() also holds
+ *   uIP locked while it calls back here.
  *
  ****************************************************************************/
 
@@ -481,11 +482,12 @@ static void slip_txtask(int argc, char *argv[])
 
       if (priv->bifup)
         {
-          /* Get exclusive access to uIP (if it it is already being used
-           * slip_rxtask, then we have to wait).
+          /* Get exclusive access to the device (if it it is already being
+           * used slip_rxtask, then we have to wait).  uip_timer() will lock
+           * uIP itself.
            */
 
-          slip_semtake(priv);
+          flags = uip_devlock(&priv->dev);
 
           /* Poll uIP for new XMIT data. BUG:  We really need to calculate
            * the number of hsecs!  When we are awakened by slip_txavail, the
@@ -493,11 +495,9 @@ static void slip_txtask(int argc, char *argv[])
            * (above), it may be larger.
            */
 
-          flags = uip_lock();
           priv->dev.d_buf = priv->txbuf;
           (void)uip_timer(&priv->dev, slip_uiptxpoll, SLIP_POLLHSEC);
-          uip_unlock(flags);
-          slip_semgive(priv);
+          uip_devunlock(&priv->dev, flags);
         }
     }
 }
@@ -711,13 +711,16 @@ static int slip_rxtask(int argc, char *argv[])
 
       if (priv->rxlen >= UIP_IPH_LEN)
         {
-          /* Handle the IP input.  Get exclusive access to uIP. */
+          /* Handle the IP input.  Get exclusive access to the device.
+           * uip_input() locks uIP only while it processes the packet so
+           * that other interfaces and sockets are not held off while the
+           * reply is written to the serial port.
+           */
 
-          slip_semtake(priv);
+          flags = uip_devlock(&priv->dev);
           priv->dev.d_buf = priv->rxbuf;
           priv->dev.d_len = priv->rxlen;
 
-          flags = uip_lock();
           uip_input(&priv->dev);
 
           /* If the above function invocation resulted in data that should
@@ -729,8 +732,7 @@ static int slip_rxtask(int argc, char *argv[])
             {
               slip_transmit(priv); 
             }
-          uip_unlock(flags);
-          slip_semgive(priv);
+          uip_devunlock(&priv->dev, flags);
         }
       else
         {
@@ -944,9 +946,10 @@ int slip_initialize(int intf, const char *devname)
       return -errno;
     }
 
-  /* Initialize the wait semaphore */
+  /* Initialize the wait semaphore and the device lock */
 
   sem_init(&priv->waitsem, 0, 0);
+  uip_devlockinit(&priv->dev);
 
   /* Put the interface in the down state.  This usually amounts to resetting
    * the device and/or calling slip_ifdown().
@@ -996,10 +999,6 @@ int slip_initialize(int intf, const char *devname)
 
   slip_semtake(priv);
 
-  /* Bump the semaphore count so that it can now be used as a mutex */
-
-  slip_semgive(priv);
-
   /* Register the device with the OS so that socket IOCTLs can be performed */
 
   (void)netdev_register(&priv->dev);
@@ -117,21 +117,7 @@ static void pipecommon_semtake(sem_t *sem)
 #ifndef CONFIG_DISABLE_POLL
 static void pipecommon_pollnotify(FAR struct pipe_dev_s *dev, pollevent_t eventset)
 {
-  int i;
-
-  for (i = 0; i < CONFIG_DEV_PIPE_NPOLLWAITERS; i++)
-    {
-      struct pollfd *fds = dev->d_fds[i];
-      if (fds)
-        {
-          fds->revents |= (fds->events & eventset);
-          if (fds->revents != 0)
-            {
-              fvdbg("Report events: %02x\n", fds->revents);
-              sem_post(fds->sem);
-            }
-        }
-    }
+  poll_notify(dev->d_fds, CONFIG_DEV_PIPE_NPOLLWAITERS, eventset);
 }
 #else
 #  define pipecommon_pollnotify(dev,event)
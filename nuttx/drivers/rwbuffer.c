@@ -51,6 +51,7 @@
 #include <debug.h>
 
 #include <nuttx/kmalloc.h>
+#include <nuttx/clock.h>
 #include <nuttx/wqueue.h>
 #include <nuttx/rwbuffer.h>
 
@@ -62,7 +63,7 @@
 
 /* Configuration ************************************************************/
 
-#ifndef CONFIG_SCHED_WORKQUEUE
+#if defined(CONFIG_FS_WRITEBUFFER) && !defined(CONFIG_SCHED_WORKQUEUE)
 #  error "Worker thread support is required (CONFIG_SCHED_WORKQUEUE)"
 #endif
 
@@ -70,6 +71,20 @@
 #  define CONFIG_FS_WRDELAY 350
 #endif
 
+/* The read-ahead window of a newly detected sequential reader.  The window
+ * doubles each time that the reader runs off the end of the read-ahead
+ * buffer, up to rhmaxblocks.
+ */
+
+#ifndef CONFIG_FS_RHMINBLOCKS
+#  define CONFIG_FS_RHMINBLOCKS 2
+#endif
+
+#if CONFIG_FS_RHMINBLOCKS < 1
+#  undef  CONFIG_FS_RHMINBLOCKS
+#  define CONFIG_FS_RHMINBLOCKS 1
+#endif
+
 /****************************************************************************
  * Private Types
  ****************************************************************************/
@@ -114,6 +129,7 @@ static void rwb_semtake(sem_t *sem)
  * Name: rwb_overlap
  ****************************************************************************/
 
+#ifdef CONFIG_FS_READAHEAD
 static inline bool rwb_overlap(off_t blockstart1, size_t nblocks1,
                                off_t blockstart2, size_t nblocks2)
 {
@@ -122,8 +138,8 @@ static inline bool rwb_overlap(off_t blockstart1, size_t nblocks1,
 
   /* If the buffer 1 is wholly outside of buffer 2, return false */
 
-  if ((blockend1   < blockstart2) || /* Wholly "below" */
-      (blockstart1 > blockend2))     /* Wholly "above" */
+  if ((blockend1   <= blockstart2) || /* Wholly "below" */
+      (blockstart1 >= blockend2))     /* Wholly "above" */
     {
       return false;
     }
@@ -132,6 +148,63 @@ static inline bool rwb_overlap(off_t blockstart1, size_t nblocks1,
       return true;
     }
 }
+#endif
+
+/****************************************************************************
+ * Name: rwb_devread
+ *
+ * Description:
+ *   Read blocks from the device into the caller's buffer.  Anything other
+ *   than the number of blocks requested is an error.
+ *
+ ****************************************************************************/
+
+static ssize_t rwb_devread(FAR struct rwbuffer_s *rwb, FAR uint8_t *buffer,
+                           off_t startblock, size_t nblocks)
+{
+  ssize_t ret;
+
+  ret = rwb->rhreload(rwb->dev, buffer, startblock, nblocks);
+  rwb->stats.rs_nreads++;
+
+  if (ret != nblocks)
+    {
+      fdbg("ERROR: Read of %d blocks at %ld failed: %d\n",
+           nblocks, (long)startblock, ret);
+      return ret < 0 ? ret : -EIO;
+    }
+
+  return ret;
+}
+
+/****************************************************************************
+ * Name: rwb_devwrite
+ *
+ * Description:
+ *   Write blocks to the device.  Anything other than the number of blocks
+ *   requested is an error.
+ *
+ ****************************************************************************/
+
+static ssize_t rwb_devwrite(FAR struct rwbuffer_s *rwb,
+                            FAR const uint8_t *buffer, off_t startblock,
+                            size_t nblocks)
+{
+  ssize_t ret;
+
+  ret = rwb->wrflush(rwb->dev, buffer, startblock, nblocks);
+  rwb->stats.rs_nwrites++;
+  rwb->stats.rs_flblocks += nblocks;
+
+  if (ret != nblocks)
+    {
+      fdbg("ERROR: Write of %d blocks at %ld failed: %d\n",
+           nblocks, (long)startblock, ret);
+      return ret < 0 ? ret : -EIO;
+    }
+
+  return ret;
+}
 
 /****************************************************************************
  * Name: rwb_resetwrbuffer
@@ -142,44 +215,107 @@ static inline void rwb_resetwrbuffer(struct rwbuffer_s *rwb)
 {
   /* We assume that the caller holds the wrsem */
 
-  rwb->wrnblocks       = 0;
-  rwb->wrblockstart    = (off_t)-1;
-  rwb->wrexpectedblock = (off_t)-1;
+  rwb->wrnblocks = 0;
+}
+#endif
+
+/****************************************************************************
+ * Name: rwb_wrfind
+ *
+ * Description:
+ *   Return the index of the first buffered block with a block number that
+ *   is greater than or equal to 'block' (wrnblocks if there is none).
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_FS_WRITEBUFFER
+static uint16_t rwb_wrfind(FAR struct rwbuffer_s *rwb, off_t block)
+{
+  uint16_t low  = 0;
+  uint16_t high = rwb->wrnblocks;
+
+  /* The common cases are appending to the end of the buffer and the
+   * buffer being empty.
+   */
+
+  if (high == 0 || rwb->wrblocks[high - 1] < block)
+    {
+      return high;
+    }
+
+  /* Otherwise, do a binary search of the sorted block numbers */
+
+  while (low < high)
+    {
+      uint16_t mid = (low + high) >> 1;
+      if (rwb->wrblocks[mid] < block)
+        {
+          low = mid + 1;
+        }
+      else
+        {
+          high = mid;
+        }
+    }
+
+  return low;
 }
 #endif
 
 /****************************************************************************
  * Name: rwb_wrflush
+ *
+ * Description:
+ *   Write all of the buffered blocks to the device.  Each run of
+ *   consecutive blocks is written with one call to the wrflush callout.
+ *   The caller must hold the wrsem.
+ *
  ****************************************************************************/
 
 #ifdef CONFIG_FS_WRITEBUFFER
-static void rwb_wrflush(struct rwbuffer_s *rwb)
+static int rwb_wrflush(struct rwbuffer_s *rwb)
 {
-  int ret;
+  uint16_t index = 0;
+  int ret = OK;
 
-  fvdbg("Timeout!\n");
-  
-  rwb_semtake(&rwb->wrsem);
-  if (rwb->wrnblocks)
+  if (rwb->wrnblocks > 0)
+    {
+      rwb->stats.rs_nflushes++;
+    }
+
+  while (index < rwb->wrnblocks)
     {
-      fvdbg("Flushing: blockstart=0x%08lx nblocks=%d from buffer=%p\n",
-      (long)rwb->wrblockstart, rwb->wrnblocks, rwb->wrbuffer);
+      off_t    startblock = rwb->wrblocks[index];
+      uint16_t nblocks    = 1;
+      ssize_t  nwritten;
+
+      /* Find the end of this run of consecutive blocks */
+
+      while (index + nblocks < rwb->wrnblocks &&
+             rwb->wrblocks[index + nblocks] == startblock + nblocks)
+        {
+          nblocks++;
+        }
+
+      fvdbg("Flushing: blockstart=0x%08lx nblocks=%d\n",
+            (long)startblock, nblocks);
 
-      /* Flush cache.  On success, the flush method will return the number
-       * of blocks written.  Anything other than the number requested is
-       * an error.
+      /* Write the run.  On failure, keep going so that as much data as
+       * possible reaches the media, but report the first error.
        */
 
-      ret = rwb->wrflush(rwb->dev, rwb->wrbuffer, rwb->wrblockstart, rwb->wrnblocks);
-      if (ret != rwb->wrnblocks)
+      nwritten = rwb_devwrite(rwb, &rwb->wrbuffer[index * rwb->blocksize],
+                              startblock, nblocks);
+      if (nwritten < 0 && ret == OK)
         {
-          fdbg("ERROR: Error flushing write buffer: %d\n", ret);
+          ret = nwritten;
         }
-      
-      rwb_resetwrbuffer(rwb);
+
+      index += nblocks;
     }
 
-  rwb_semgive(&rwb->wrsem);
+  rwb_resetwrbuffer(rwb);
+  return ret;
 }
 #endif
 
@@ -187,6 +323,7 @@ static void rwb_wrflush(struct rwbuffer_s *rwb)
  * Name: rwb_wrtimeout
  ****************************************************************************/
 
+#ifdef CONFIG_FS_WRITEBUFFER
 static void rwb_wrtimeout(FAR void *arg)
 {
   /* The following assumes that the size of a pointer is 4-bytes or less */
@@ -199,34 +336,78 @@ static void rwb_wrtimeout(FAR void *arg)
    * worker thread.
    */
 
-  rwb_wrflush(rwb);
+  fvdbg("Timeout!\n");
+
+  rwb_semtake(&rwb->wrsem);
+  (void)rwb_wrflush(rwb);
+  rwb_semgive(&rwb->wrsem);
 }
+#endif
 
 /****************************************************************************
  * Name: rwb_wrstarttimeout
  ****************************************************************************/
 
+#ifdef CONFIG_FS_WRITEBUFFER
 static void rwb_wrstarttimeout(FAR struct rwbuffer_s *rwb)
 {
-  /* CONFIG_FS_WRDELAY provides the delay period in milliseconds. CLK_TCK
-   * provides the clock tick of the system (frequency in Hz).
-   */
+  /* CONFIG_FS_WRDELAY provides the delay period in milliseconds */
 
-  int ticks = (CONFIG_FS_WRDELAY + CLK_TCK/2) / CLK_TCK;
-  (void)work_queue(&rwb->work, rwb_wrtimeout, (FAR void *)rwb, ticks);
+  (void)work_queue(LPWORK, &rwb->work, rwb_wrtimeout, (FAR void *)rwb,
+                   MSEC2TICK(CONFIG_FS_WRDELAY));
 }
+#endif
 
 /****************************************************************************
  * Name: rwb_wrcanceltimeout
  ****************************************************************************/
 
+#ifdef CONFIG_FS_WRITEBUFFER
 static inline void rwb_wrcanceltimeout(struct rwbuffer_s *rwb)
 {
-  (void)work_cancel(&rwb->work);
+  (void)work_cancel(LPWORK, &rwb->work);
 }
+#endif
+
+/****************************************************************************
+ * Name: rwb_wrdiscard
+ *
+ * Description:
+ *   Remove any buffered blocks in the range startblock through
+ *   startblock+nblocks-1 from the write buffer.  This is done when the
+ *   range is written directly to the device so that older data is not
+ *   flushed on top of it later.  The caller must hold the wrsem.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_FS_WRITEBUFFER
+static void rwb_wrdiscard(FAR struct rwbuffer_s *rwb, off_t startblock,
+                          size_t nblocks)
+{
+  uint16_t first = rwb_wrfind(rwb, startblock);
+  uint16_t last  = rwb_wrfind(rwb, startblock + nblocks);
+  uint16_t ntail = rwb->wrnblocks - last;
+
+  if (last > first)
+    {
+      memmove(&rwb->wrblocks[first], &rwb->wrblocks[last],
+              ntail * sizeof(off_t));
+      memmove(&rwb->wrbuffer[first * rwb->blocksize],
+              &rwb->wrbuffer[last * rwb->blocksize],
+              ntail * rwb->blocksize);
+      rwb->wrnblocks -= last - first;
+    }
+}
+#endif
 
 /****************************************************************************
  * Name: rwb_writebuffer
+ *
+ * Description:
+ *   Add blocks to the write buffer.  A block that is already buffered is
+ *   simply replaced.  If a new block does not fit, all buffered blocks are
+ *   flushed first.  The caller must hold the wrsem.
+ *
  ****************************************************************************/
 
 #ifdef CONFIG_FS_WRITEBUFFER
@@ -234,54 +415,62 @@ static ssize_t rwb_writebuffer(FAR struct rwbuffer_s *rwb,
                                off_t startblock, uint32_t nblocks,
                                FAR const uint8_t *wrbuffer)
 {
-  int ret;
-
-  /* Write writebuffer Logic */
-
-  rwb_wrcanceltimeout(rwb);
-  
-  /* First: Should we flush out our cache? We would do that if (1) we already
-   * buffering blocks and the next block writing is not in the same sequence,
-   * or (2) the number of blocks would exceed our allocated buffer capacity
-   */
+  uint32_t remaining;
+  uint16_t index;
+  uint16_t ntail;
+  int      ret;
 
-  if (((startblock != rwb->wrexpectedblock) && (rwb->wrnblocks)) ||
-      ((rwb->wrnblocks + nblocks) > rwb->wrmaxblocks))
+  for (remaining = nblocks; remaining > 0; remaining--)
     {
-      fvdbg("writebuffer miss, expected: %08x, given: %08x\n",
-            rwb->wrexpectedblock, startblock);
-    
-      /* Flush the write buffer */
+      index = rwb_wrfind(rwb, startblock);
+      if (index < rwb->wrnblocks && rwb->wrblocks[index] == startblock)
+        {
+          /* The block is already buffered.  Just replace the data */
 
-      ret = rwb->wrflush(rwb, rwb->wrbuffer, rwb->wrblockstart, rwb->wrnblocks);
-      if (ret < 0)
+          rwb->stats.rs_wrmerged++;
+        }
+      else
         {
-          fdbg("ERROR: Error writing multiple from cache: %d\n", -ret);
-          return ret;
+          /* Make room for one more block, flushing the buffer if it is
+           * full.
+           */
+
+          if (rwb->wrnblocks >= rwb->wrmaxblocks)
+            {
+              fvdbg("Write buffer full, flushing\n");
+
+              ret = rwb_wrflush(rwb);
+              if (ret < 0)
+                {
+                  return ret;
+                }
+
+              index = 0;
+            }
+
+          /* Insert the block, keeping the buffer sorted by block number */
+
+          ntail = rwb->wrnblocks - index;
+          if (ntail > 0)
+            {
+              memmove(&rwb->wrblocks[index + 1], &rwb->wrblocks[index],
+                      ntail * sizeof(off_t));
+              memmove(&rwb->wrbuffer[(index + 1) * rwb->blocksize],
+                      &rwb->wrbuffer[index * rwb->blocksize],
+                      ntail * rwb->blocksize);
+            }
+
+          rwb->wrblocks[index] = startblock;
+          rwb->wrnblocks++;
         }
 
-      rwb_resetwrbuffer(rwb);
-    }
-  
-  /* writebuffer is empty? Then initialize it */
+      memcpy(&rwb->wrbuffer[index * rwb->blocksize], wrbuffer,
+             rwb->blocksize);
 
-  if (!rwb->wrnblocks)
-    {
-      fvdbg("Fresh cache starting at block: 0x%08x\n", startblock);
-      rwb->wrblockstart = startblock;
+      startblock++;
+      wrbuffer += rwb->blocksize;
     }
-  
-  /* Add data to cache */
-
-  fvdbg("writebuffer: copying %d bytes from %p to %p\n",
-        nblocks * wrb->blocksize, wrbuffer,
-        &rwb->wrbuffer[rwb->wrnblocks * rwb->blocksize]);
-  memcpy(&rwb->wrbuffer[rwb->wrnblocks * rwb->blocksize],
-         wrbuffer, nblocks * rwb->blocksize);
-
-  rwb->wrnblocks      += nblocks;
-  rwb->wrexpectedblock = rwb->wrblockstart + rwb->wrnblocks;
-  rwb_wrstarttimeout(rwb);
+
   return nblocks;
 }
 #endif
@@ -293,7 +482,7 @@ static ssize_t rwb_writebuffer(FAR struct rwbuffer_s *rwb,
 #ifdef CONFIG_FS_READAHEAD
 static inline void rwb_resetrhbuffer(struct rwbuffer_s *rwb)
 {
-  /* We assume that the caller holds the readAheadBufferSemphore */
+  /* We assume that the caller holds the rhsem */
 
   rwb->rhnblocks    = 0;
   rwb->rhblockstart = (off_t)-1;
@@ -301,82 +490,215 @@ static inline void rwb_resetrhbuffer(struct rwbuffer_s *rwb)
 #endif
 
 /****************************************************************************
- * Name: rwb_bufferread
+ * Name: rwb_rhreload
+ *
+ * Description:
+ *   Load nblocks blocks starting at startblock into the read-ahead buffer.
+ *   The caller must hold the rhsem (and the wrsem, if there is a write
+ *   buffer).
+ *
  ****************************************************************************/
 
 #ifdef CONFIG_FS_READAHEAD
-static inline void
-rwb_bufferread(struct rwbuffer_s *rwb,  off_t startblock,
-               size_t nblocks, uint8_t **rdbuffer)
+static int rwb_rhreload(struct rwbuffer_s *rwb, off_t startblock,
+                        size_t nblocks)
 {
-  /* We assume that (1) the caller holds the readAheadBufferSemphore, and (2)
-   * that the caller already knows that all of the blocks are in the
-   * read-ahead buffer.
-   */
+  ssize_t ret;
+#ifdef CONFIG_FS_WRITEBUFFER
+  uint16_t index;
+#endif
 
-  /* Convert the units from blocks to bytes */
+  /* Reset the read buffer */
 
-  off_t  blockoffset = startblock - rwb->rhblockstart;
-  off_t  byteoffset  = rwb->blocksize * blockoffset;
-  size_t nbytes      = rwb->blocksize * nblocks;
+  rwb_resetrhbuffer(rwb);
 
-  /* Get the byte address in the read-ahead buffer */
+  /* Now perform the read */
 
-  uint8_t *rhbuffer    = rwb->rhbuffer + byteoffset;
+  ret = rwb_devread(rwb, rwb->rhbuffer, startblock, nblocks);
+  if (ret < 0)
+    {
+      return ret;
+    }
 
-  /* Copy the data from the read-ahead buffer into the IO buffer */
+#ifdef CONFIG_FS_WRITEBUFFER
+  /* Blocks in the write buffer are newer than the blocks on the device.
+   * Copy them into the read-ahead buffer so that it is still correct after
+   * the write buffer is flushed.
+   */
 
-  memcpy(*rdbuffer, rhbuffer, nbytes);
+  for (index = rwb_wrfind(rwb, startblock);
+       index < rwb->wrnblocks && rwb->wrblocks[index] < startblock + nblocks;
+       index++)
+    {
+      memcpy(&rwb->rhbuffer[(rwb->wrblocks[index] - startblock) * rwb->blocksize],
+             &rwb->wrbuffer[index * rwb->blocksize], rwb->blocksize);
+    }
+#endif
 
-  /* Update the caller's copy for the next address */
+  /* Update information about what is in the read-ahead buffer */
 
-  *rdbuffer += nbytes;
+  rwb->rhnblocks    = nblocks;
+  rwb->rhblockstart = startblock;
+  return OK;
 }
 #endif
 
 /****************************************************************************
- * Name: rwb_rhreload
+ * Name: rwb_rhupdate
+ *
+ * Description:
+ *   Copy newly written blocks into the read-ahead buffer, if they are
+ *   buffered there.  The caller must hold the rhsem.
+ *
  ****************************************************************************/
 
 #ifdef CONFIG_FS_READAHEAD
-static int rwb_rhreload(struct rwbuffer_s *rwb, off_t startblock)
+static void rwb_rhupdate(FAR struct rwbuffer_s *rwb, off_t startblock,
+                         size_t nblocks, FAR const uint8_t *wrbuffer)
 {
-  /* Get the block number +1 of the last block that will fit in the
-   * read-ahead buffer
-   */
+  off_t first;
+  off_t last;
 
-  off_t  endblock  = startblock + rwb->rhmaxblocks;
-  size_t nblocks;
-  int    ret;
+  if (rwb_overlap(rwb->rhblockstart, rwb->rhnblocks, startblock, nblocks))
+    {
+      first = startblock > rwb->rhblockstart ? startblock : rwb->rhblockstart;
+      last  = startblock + nblocks;
+      if (last > rwb->rhblockstart + rwb->rhnblocks)
+        {
+          last = rwb->rhblockstart + rwb->rhnblocks;
+        }
 
-  /* Reset the read buffer */
+      memcpy(&rwb->rhbuffer[(first - rwb->rhblockstart) * rwb->blocksize],
+             &wrbuffer[(first - startblock) * rwb->blocksize],
+             (last - first) * rwb->blocksize);
+    }
+}
+#endif
 
-  rwb_resetrhbuffer(rwb);
+/****************************************************************************
+ * Name: rwb_rhread
+ *
+ * Description:
+ *   Read blocks that are not in the write buffer, using the read-ahead
+ *   buffer.
+ *
+ *   A reader is sequential if it starts where the last read ended or if it
+ *   runs off of the end of the read-ahead buffer.  A new sequential reader
+ *   reads CONFIG_FS_RHMINBLOCKS blocks ahead, and the window is doubled
+ *   each time that the reader reaches the end of the read-ahead buffer, up
+ *   to the size of the buffer.  Any other miss is a random access:  The
+ *   blocks are read directly into the caller's buffer without any read-
+ *   ahead and without disturbing the read-ahead buffer.  Requests that are
+ *   at least as large as the read-ahead buffer are also read directly.
+ *
+ *   The caller must hold the rhsem (and the wrsem, if there is a write
+ *   buffer).
+ *
+ ****************************************************************************/
 
-  /* Make sure that we don't read past the end of the device */
+#ifdef CONFIG_FS_READAHEAD
+static ssize_t rwb_rhread(FAR struct rwbuffer_s *rwb, off_t startblock,
+                          size_t nblocks, FAR uint8_t *rdbuffer)
+{
+  off_t  bufferend;
+  size_t nbufblocks;
+  size_t nload;
+  bool   sequential;
+  int    ret;
 
-  if (endblock > rwb->nblocks)
+  while (nblocks > 0)
     {
-      endblock = rwb->nblocks;
-    }
-  nblocks = endblock - startblock;
+      /* Are the next blocks in the read-ahead buffer? */
 
-  /* Now perform the read */
+      bufferend = rwb->rhblockstart + rwb->rhnblocks;
+      if (rwb->rhnblocks > 0 && startblock >= rwb->rhblockstart &&
+          startblock < bufferend)
+        {
+          nbufblocks = bufferend - startblock;
+          if (nbufblocks > nblocks)
+            {
+              nbufblocks = nblocks;
+            }
 
-  ret = rwb->rhreload(rwb->dev, rwb->rhbuffer, startblock, nblocks);
-  if (ret == nblocks)
-    {
-      /* Update information about what is in the read-ahead buffer */
+          memcpy(rdbuffer,
+                 &rwb->rhbuffer[(startblock - rwb->rhblockstart) * rwb->blocksize],
+                 nbufblocks * rwb->blocksize);
+
+          rwb->stats.rs_rdhits += nbufblocks;
+          startblock           += nbufblocks;
+          nblocks              -= nbufblocks;
+          rdbuffer             += nbufblocks * rwb->blocksize;
+          continue;
+        }
+
+      /* A miss.  Decide how far to read ahead */
+
+      sequential = true;
+      if (rwb->rhnblocks > 0 && startblock == bufferend)
+        {
+          /* The reader ran off of the end of the read-ahead buffer */
+
+          rwb->rhwindow <<= 1;
+          if (rwb->rhwindow < CONFIG_FS_RHMINBLOCKS)
+            {
+              rwb->rhwindow = CONFIG_FS_RHMINBLOCKS;
+            }
+        }
+      else if (startblock == rwb->rhexpected)
+        {
+          /* The reader continues where the last read ended */
+
+          rwb->rhwindow = CONFIG_FS_RHMINBLOCKS;
+        }
+      else
+        {
+          sequential = false;
+        }
+
+      if (rwb->rhwindow > rwb->rhmaxblocks)
+        {
+          rwb->rhwindow = rwb->rhmaxblocks;
+        }
+
+      if (!sequential || nblocks >= rwb->rhmaxblocks)
+        {
+          /* Read directly into the caller's buffer */
+
+          ret = rwb_devread(rwb, rdbuffer, startblock, nblocks);
+          if (ret < 0)
+            {
+              return ret;
+            }
+
+          rwb->stats.rs_rdmisses += nblocks;
+          return OK;
+        }
 
-      rwb->rhnblocks    = nblocks;
-      rwb->rhblockstart = startblock;
+      /* Reload the read-ahead buffer with the requested blocks and the
+       * blocks that follow them.  Make sure that we don't read past the end
+       * of the device.
+       */
 
-      /* The return value is not the number of blocks we asked to be loaded. */
+      nload = nblocks > rwb->rhwindow ? nblocks : rwb->rhwindow;
+      if (startblock + nload > rwb->nblocks)
+        {
+          nload = rwb->nblocks - startblock;
+        }
 
-      return nblocks;
+      ret = rwb_rhreload(rwb, startblock, nload);
+      if (ret < 0)
+        {
+          fdbg("ERROR: Failed to fill the read-ahead buffer: %d\n", -ret);
+          return ret;
+        }
+
+      memcpy(rdbuffer, rwb->rhbuffer, nblocks * rwb->blocksize);
+      rwb->stats.rs_rdmisses += nblocks;
+      rwb->stats.rs_rdahead  += nload - nblocks;
+      return OK;
     }
 
-  return -EIO;
+  return OK;
 }
 #endif
 
@@ -397,60 +719,52 @@ int rwb_initialize(FAR struct rwbuffer_s *rwb)
   DEBUGASSERT(rwb->blocksize > 0);
   DEBUGASSERT(rwb->nblocks > 0);
   DEBUGASSERT(rwb->dev != NULL);
+  DEBUGASSERT(rwb->rhreload != NULL);
+
+  memset(&rwb->stats, 0, sizeof(struct rwb_stats_s));
 
   /* Setup so that rwb_uninitialize can handle a failure */
 
 #ifdef CONFIG_FS_WRITEBUFFER
-  DEBUGASSERT(rwb->wrflush!= NULL);
+  DEBUGASSERT(rwb->wrmaxblocks == 0 || rwb->wrflush != NULL);
+
+  sem_init(&rwb->wrsem, 0, 1);
+  memset(&rwb->work, 0, sizeof(struct work_s));
   rwb->wrbuffer = NULL;
+  rwb->wrblocks = NULL;
+  rwb_resetwrbuffer(rwb);
 #endif
+
 #ifdef CONFIG_FS_READAHEAD
-  DEBUGASSERT(rwb->rhreload != NULL);
-  rwb->rhbuffer = NULL;
+  sem_init(&rwb->rhsem, 0, 1);
+  rwb->rhbuffer   = NULL;
+  rwb->rhwindow   = 0;
+  rwb->rhexpected = (off_t)-1;
+  rwb_resetrhbuffer(rwb);
 #endif
 
 #ifdef CONFIG_FS_WRITEBUFFER
-  fvdbg("Initialize the write buffer\n");
-
-  /* Initialize the write buffer access semaphore */
-
-  sem_init(&rwb->wrsem, 0, 1);
-
-  /* Initialize write buffer parameters */
-
-  rwb_resetwrbuffer(rwb);
-
-  /* Allocate the write buffer */
+  /* Allocate the write buffer and the table of buffered block numbers */
 
-  rwb->wrbuffer = NULL;
   if (rwb->wrmaxblocks > 0)
     {
       allocsize     = rwb->wrmaxblocks * rwb->blocksize;
       rwb->wrbuffer = kmalloc(allocsize);
-      if (!rwb->wrbuffer)
+      rwb->wrblocks = (FAR off_t *)kmalloc(rwb->wrmaxblocks * sizeof(off_t));
+      if (!rwb->wrbuffer || !rwb->wrblocks)
         {
-          fdbg("Write buffer kmalloc(%d) failed\n", allocsizee);
+          fdbg("Write buffer kmalloc(%d) failed\n", allocsize);
+          rwb_uninitialize(rwb);
           return -ENOMEM;
         }
+
+      fvdbg("Write buffer size: %d bytes\n", allocsize);
     }
-  
-  fvdbg("Write buffer size: %d bytes\n", allocsize);
 #endif /* CONFIG_FS_WRITEBUFFER */
 
 #ifdef CONFIG_FS_READAHEAD
-  fvdbg("Initialize the read-ahead buffer\n");
-
-  /* Initialize the read-ahead buffer access semaphore */
-
-  sem_init(&rwb->rhsem, 0, 1);
-
-  /* Initialize read-ahead buffer parameters */
-
-  rwb_resetrhbuffer(rwb);
-
   /* Allocate the read-ahead buffer */
 
-  rwb->rhbuffer = NULL;
   if (rwb->rhmaxblocks > 0)
     {
       allocsize     = rwb->rhmaxblocks * rwb->blocksize;
@@ -458,27 +772,45 @@ int rwb_initialize(FAR struct rwbuffer_s *rwb)
       if (!rwb->rhbuffer)
         {
           fdbg("Read-ahead buffer kmalloc(%d) failed\n", allocsize);
+          rwb_uninitialize(rwb);
           return -ENOMEM;
         }
+
+      fvdbg("Read-ahead buffer size: %d bytes\n", allocsize);
     }
-  
-  fvdbg("Read-ahead buffer size: %d bytes\n", allocsize);
 #endif /* CONFIG_FS_READAHEAD */
-  return 0;
+
+  return OK;
 }
 
 /****************************************************************************
  * Name: rwb_uninitialize
+ *
+ * Description:
+ *   Flush any buffered write data and free the buffers.
+ *
  ****************************************************************************/
 
 void rwb_uninitialize(FAR struct rwbuffer_s *rwb)
 {
 #ifdef CONFIG_FS_WRITEBUFFER
   rwb_wrcanceltimeout(rwb);
+  if (rwb->wrbuffer && rwb->wrblocks)
+    {
+      (void)rwb_wrflush(rwb);
+    }
+
   sem_destroy(&rwb->wrsem);
   if (rwb->wrbuffer)
     {
       kfree(rwb->wrbuffer);
+      rwb->wrbuffer = NULL;
+    }
+
+  if (rwb->wrblocks)
+    {
+      kfree(rwb->wrblocks);
+      rwb->wrblocks = NULL;
     }
 #endif
 
@@ -487,170 +819,263 @@ void rwb_uninitialize(FAR struct rwbuffer_s *rwb)
   if (rwb->rhbuffer)
     {
       kfree(rwb->rhbuffer);
+      rwb->rhbuffer = NULL;
     }
 #endif
 }
 
 /****************************************************************************
  * Name: rwb_read
+ *
+ * Description:
+ *   Read blocks.  Blocks that are in the write buffer are returned from
+ *   the write buffer (without flushing it); the remaining blocks are
+ *   returned from the read-ahead buffer or read from the device.
+ *
  ****************************************************************************/
 
-int rwb_read(FAR struct rwbuffer_s *rwb, off_t startblock, uint32_t nblocks,
-             FAR uint8_t *rdbuffer)
+ssize_t rwb_read(FAR struct rwbuffer_s *rwb, off_t startblock,
+                 size_t nblocks, FAR uint8_t *rdbuffer)
 {
-  uint32_t remaining;
- 
+  size_t  remaining = nblocks;
+  size_t  nrun;
+  ssize_t ret = OK;
+#ifdef CONFIG_FS_WRITEBUFFER
+  uint16_t index;
+#endif
+
   fvdbg("startblock=%ld nblocks=%ld rdbuffer=%p\n",
         (long)startblock, (long)nblocks, rdbuffer);
 
 #ifdef CONFIG_FS_WRITEBUFFER
-  /* If the new read data overlaps any part of the write buffer, then
-   * flush the write data onto the physical media before reading.  We
-   * could attempt some more exotic handling -- but this simple logic
-   * is well-suited for simple streaming applications.
-   */
-
-  if (rwb->wrmaxblocks > 0)
-    {
-      /* If the write buffer overlaps the block(s) requested, then flush the
-       * write buffer.
-       */
-
-      rwb_semtake(&rwb->wrsem);
-      if (rwb_overlap(rwb->wrblockstart, rwb->wrnblocks, startblock, nblocks))
-        {
-          rwb_wrflush(rwb);
-        }
-      rwb_semgive(&rwb->wrsem);
-    }
+  rwb_semtake(&rwb->wrsem);
 #endif
-
 #ifdef CONFIG_FS_READAHEAD
-  /* Loop until we have read all of the requested blocks */
-
   rwb_semtake(&rwb->rhsem);
-  for (remaining = nblocks; remaining > 0;)
+#endif
+
+  while (remaining > 0)
     {
-      /* Is there anything in the read-ahead buffer? */
+      nrun = remaining;
 
-      if (rwb->rhnblocks > 0)
-        {
-          off_t  startblock = startblock;
-          size_t nbufblocks = 0;
-          off_t  bufferend;
+#ifdef CONFIG_FS_WRITEBUFFER
+      /* Is the next block in the write buffer? */
 
-          /* Loop for each block we find in the read-head buffer.  Count the
-           * number of buffers that we can read from read-ahead buffer.
+      index = rwb_wrfind(rwb, startblock);
+      if (index < rwb->wrnblocks && rwb->wrblocks[index] == startblock)
+        {
+          /* Yes.. return it and any following blocks that are also in the
+           * write buffer.
            */
 
-          bufferend = rwb->rhblockstart + rwb->rhnblocks;
-
-          while ((startblock >= rwb->rhblockstart) &&
-                 (startblock < bufferend) &&
-                 (remaining > 0))
+          nrun = 1;
+          while (nrun < remaining && index + nrun < rwb->wrnblocks &&
+                 rwb->wrblocks[index + nrun] == startblock + nrun)
             {
-              /* This is one more that we will read from the read ahead buffer */
-
-              nbufblocks++;
-
-              /* And one less that we will read from the media */
-
-              startblock++;
-              remaining--;
+              nrun++;
             }
 
-          /* Then read the data from the read-ahead buffer */
-
-          rwb_bufferread(rwb, startblock, nbufblocks, &rdbuffer);
+          memcpy(rdbuffer, &rwb->wrbuffer[index * rwb->blocksize],
+                 nrun * rwb->blocksize);
+          rwb->stats.rs_wrhits += nrun;
         }
+      else
+#endif
+        {
+#ifdef CONFIG_FS_WRITEBUFFER
+          /* No.. read up to the next block that is in the write buffer */
 
-      /* If we did not get all of the data from the buffer, then we have to refill
-       * the buffer and try again.
-       */
+          if (index < rwb->wrnblocks &&
+              rwb->wrblocks[index] - startblock < nrun)
+            {
+              nrun = rwb->wrblocks[index] - startblock;
+            }
+#endif
+
+#ifdef CONFIG_FS_READAHEAD
+          if (rwb->rhmaxblocks > 0)
+            {
+              ret = rwb_rhread(rwb, startblock, nrun, rdbuffer);
+            }
+          else
+#endif
+            {
+              ret = rwb_devread(rwb, rdbuffer, startblock, nrun);
+              rwb->stats.rs_rdmisses += nrun;
+            }
 
-      if (remaining > 0)
-        {
-          int ret = rwb_rhreload(rwb, startblock);
           if (ret < 0)
             {
-              fdbg("ERROR: Failed to fill the read-ahead buffer: %d\n", -ret);
-              return ret;
+              break;
             }
         }
+
+      startblock += nrun;
+      remaining  -= nrun;
+      rdbuffer   += nrun * rwb->blocksize;
     }
 
+#ifdef CONFIG_FS_READAHEAD
+  rwb->rhexpected = startblock;
+  rwb_semgive(&rwb->rhsem);
+#endif
+#ifdef CONFIG_FS_WRITEBUFFER
+  rwb_semgive(&rwb->wrsem);
+#endif
+
   /* On success, return the number of blocks that we were requested to read.
    * This is for compatibility with the normal return of a block driver read
    * method
    */
 
-  rwb_semgive(&rwb->rhsem);
-  return 0;
-#else
-  return rwb->rhreload(rwb->dev, startblock, nblocks, rdbuffer);
-#endif
+  return ret < 0 ? ret : (ssize_t)nblocks;
 }
 
 /****************************************************************************
  * Name: rwb_write
+ *
+ * Description:
+ *   Write blocks.  Requests that fit in the write buffer are buffered and
+ *   written to the device when the buffer fills, when no write has
+ *   occurred for CONFIG_FS_WRDELAY milliseconds, or when rwb_flush() is
+ *   called.  Larger requests are written directly to the device.
+ *
  ****************************************************************************/
 
-int rwb_write(FAR struct rwbuffer_s *rwb, off_t startblock,
-              size_t nblocks, FAR const uint8_t *wrbuffer)
+ssize_t rwb_write(FAR struct rwbuffer_s *rwb, off_t startblock,
+                  size_t nblocks, FAR const uint8_t *wrbuffer)
 {
-  int ret;
+  ssize_t ret;
+
+  fvdbg("startblock=%ld nblocks=%ld wrbuffer=%p\n",
+        (long)startblock, (long)nblocks, wrbuffer);
+
+#ifdef CONFIG_FS_WRITEBUFFER
+  rwb_semtake(&rwb->wrsem);
+#endif
 
 #ifdef CONFIG_FS_READAHEAD
-  /* If the new write data overlaps any part of the read buffer, then
-   * flush the data from the read buffer.  We could attempt some more
-   * exotic handling -- but this simple logic is well-suited for simple
-   * streaming applications.
+  /* If the new write data overlaps any part of the read-ahead buffer, then
+   * update the read-ahead buffer with the new data.
    */
 
   rwb_semtake(&rwb->rhsem);
-  if (rwb_overlap(rwb->rhblockstart, rwb->rhnblocks, startblock, nblocks))
-    {
-      rwb_resetrhbuffer(rwb);
-    }
-  rwb_give(&rwb->rhsem);
+  rwb_rhupdate(rwb, startblock, nblocks, wrbuffer);
+  rwb_semgive(&rwb->rhsem);
 #endif
 
-#ifdef CONFIG_FS_WRITEBUFFER
-  fvdbg("startblock=%d wrbuffer=%p\n", startblock, wrbuffer);
+  rwb->stats.rs_wrblocks += nblocks;
 
-  /* Use the block cache unless the buffer size is bigger than block cache */   
-     
-  if (nblocks > rwb->wrmaxblocks)
+#ifdef CONFIG_FS_WRITEBUFFER
+  if (rwb->wrmaxblocks > 0)
     {
-      /* First flush the cache */
+      rwb_wrcanceltimeout(rwb);
+
+      /* Use the write buffer unless the request is bigger than the write
+       * buffer.
+       */
+
+      if (nblocks > rwb->wrmaxblocks)
+        {
+          /* Any buffered copies of these blocks are now stale.  Then
+           * transfer the data directly to the media.
+           */
 
-      rwb_semtake(&rwb->wrsem);
-      rwb_wrflush(rwb);
-      rwb_semgive(&rwb->wrsem);
+          rwb_wrdiscard(rwb, startblock, nblocks);
+          ret = rwb_devwrite(rwb, wrbuffer, startblock, nblocks);
+        }
+      else
+        {
+          /* Buffer the data in the write buffer */
+
+          ret = rwb_writebuffer(rwb, startblock, nblocks, wrbuffer);
+        }
 
-      /* Then transfer the data directly to the media */
+      /* Flush whatever remains buffered if there is no more write
+       * activity.
+       */
 
-      ret = rwb->wrflush(rwb->dev, startblock, nblocks, wrbuffer);
+      if (rwb->wrnblocks > 0)
+        {
+          rwb_wrstarttimeout(rwb);
+        }
     }
   else
+#endif
     {
-      /* Buffer the data in the write buffer */
-
-      ret = rwb_writebuffer(rwb, startblock, nblocks, wrbuffer);
+      ret = rwb_devwrite(rwb, wrbuffer, startblock, nblocks);
     }
 
+#ifdef CONFIG_FS_WRITEBUFFER
+  rwb_semgive(&rwb->wrsem);
+#endif
+
   /* On success, return the number of blocks that we were requested to write.
    * This is for compatibility with the normal return of a block driver write
    * method
    */
 
   return ret;
+}
 
-#else
+/****************************************************************************
+ * Name: rwb_flush
+ *
+ * Description:
+ *   Write any buffered write data to the device now.
+ *
+ ****************************************************************************/
 
-  return rwb->wrflush(rwb->dev, startblock, nblocks, wrbuffer);
+int rwb_flush(FAR struct rwbuffer_s *rwb)
+{
+  int ret = OK;
 
+#ifdef CONFIG_FS_WRITEBUFFER
+  rwb_semtake(&rwb->wrsem);
+  rwb_wrcanceltimeout(rwb);
+  ret = rwb_wrflush(rwb);
+  rwb_semgive(&rwb->wrsem);
 #endif
+
+  return ret;
+}
+
+/****************************************************************************
+ * Name: rwb_invalidate
+ *
+ * Description:
+ *   Discard any buffered copies of the blocks startblock through
+ *   startblock+nblocks-1.  A driver calls this when it writes these blocks
+ *   to the device without going through rwb_write().
+ *
+ ****************************************************************************/
+
+int rwb_invalidate(FAR struct rwbuffer_s *rwb, off_t startblock,
+                   size_t nblocks)
+{
+#ifdef CONFIG_FS_WRITEBUFFER
+  rwb_semtake(&rwb->wrsem);
+  if (rwb->wrmaxblocks > 0)
+    {
+      rwb_wrdiscard(rwb, startblock, nblocks);
+      if (rwb->wrnblocks == 0)
+        {
+          rwb_wrcanceltimeout(rwb);
+        }
+    }
+  rwb_semgive(&rwb->wrsem);
+#endif
+
+#ifdef CONFIG_FS_READAHEAD
+  rwb_semtake(&rwb->rhsem);
+  if (rwb_overlap(rwb->rhblockstart, rwb->rhnblocks, startblock, nblocks))
+    {
+      rwb_resetrhbuffer(rwb);
+    }
+  rwb_semgive(&rwb->rhsem);
+#endif
+
+  return OK;
 }
 
 /****************************************************************************
@@ -663,6 +1088,7 @@ int rwb_mediaremoved(FAR struct rwbuffer_s *rwb)
 {
 #ifdef CONFIG_FS_WRITEBUFFER
   rwb_semtake(&rwb->wrsem);
+  rwb_wrcanceltimeout(rwb);
   rwb_resetwrbuffer(rwb);
   rwb_semgive(&rwb->wrsem);
 #endif
@@ -670,10 +1096,41 @@ int rwb_mediaremoved(FAR struct rwbuffer_s *rwb)
 #ifdef CONFIG_FS_READAHEAD
   rwb_semtake(&rwb->rhsem);
   rwb_resetrhbuffer(rwb);
+  rwb->rhwindow   = 0;
+  rwb->rhexpected = (off_t)-1;
   rwb_semgive(&rwb->rhsem);
 #endif
-  return 0;
+  return OK;
 }
 
-#endif /* CONFIG_FS_WRITEBUFFER || CONFIG_FS_READAHEAD */
+/****************************************************************************
+ * Name: rwb_getstats
+ *
+ * Description:
+ *   Return the buffering statistics.
+ *
+ ****************************************************************************/
+
+void rwb_getstats(FAR struct rwbuffer_s *rwb, FAR struct rwb_stats_s *stats)
+{
+#ifdef CONFIG_FS_WRITEBUFFER
+  rwb_semtake(&rwb->wrsem);
+#endif
+#ifdef CONFIG_FS_READAHEAD
+  rwb_semtake(&rwb->rhsem);
+#endif
 
+  memcpy(stats, &rwb->stats, sizeof(struct rwb_stats_s));
+#ifdef CONFIG_FS_READAHEAD
+  stats->rs_rhwindow = rwb->rhwindow;
+#endif
+
+#ifdef CONFIG_FS_READAHEAD
+  rwb_semgive(&rwb->rhsem);
+#endif
+#ifdef CONFIG_FS_WRITEBUFFER
+  rwb_semgive(&rwb->wrsem);
+#endif
+}
+
+#endif /* CONFIG_FS_WRITEBUFFER || CONFIG_FS_READAHEAD */
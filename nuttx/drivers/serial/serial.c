@@ -137,21 +137,7 @@ static void uart_takesem(FAR sem_t *sem)
 #ifndef CONFIG_DISABLE_POLL
 static void uart_pollnotify(FAR uart_dev_t *dev, pollevent_t eventset)
 {
-  int i;
-
-  for (i = 0; i < CONFIG_DEV_CONSOLE_NPOLLWAITERS; i++)
-    {
-      struct pollfd *fds = dev->fds[i];
-      if (fds)
-        {
-          fds->revents |= (fds->events & eventset);
-          if (fds->revents != 0)
-            {
-              fvdbg("Report events: %02x\n", fds->revents);
-              sem_post(fds->sem);
-            }
-        }
-    }
+  poll_notify(dev->fds, CONFIG_DEV_CONSOLE_NPOLLWAITERS, eventset);
 }
 #else
 #  define uart_pollnotify(dev,event)
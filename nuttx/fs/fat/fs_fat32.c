@@ -78,6 +78,12 @@
  * Private Function Prototypes
  ****************************************************************************/
 
+static int     fat_runsectors(struct fat_mountpt_s *fs,
+                              struct fat_file_s *ff, unsigned int nsectors,
+                              bool extend);
+static void    fat_advancesectors(struct fat_mountpt_s *fs,
+                                  struct fat_file_s *ff,
+                                  unsigned int nsectors);
 static int     fat_open(FAR struct file *filep, const char *relpath,
                         int oflags, mode_t mode);
 static int     fat_close(FAR struct file *filep);
@@ -149,6 +155,92 @@ const struct mountpt_operations fat_operations =
  * Private Functions
  ****************************************************************************/
 
+/****************************************************************************
+ * Name: fat_runsectors
+ *
+ * Description: Return the number of sectors, up to 'nsectors', that are
+ *   contiguous on the device starting at the current sector of the file.
+ *   This is the rest of the current cluster plus the following clusters in
+ *   the chain that are numbered consecutively.  If 'extend' is true, then
+ *   the chain is extended as necessary (when writing).
+ *
+ *   The file position is not changed.
+ *
+ ****************************************************************************/
+
+static int fat_runsectors(struct fat_mountpt_s *fs, struct fat_file_s *ff,
+                          unsigned int nsectors, bool extend)
+{
+  unsigned int nrun;
+  int32_t      cluster;
+  int32_t      next;
+
+  nrun    = ff->ff_sectorsincluster;
+  cluster = ff->ff_currentcluster;
+
+  while (nrun < nsectors)
+    {
+      /* Get (or allocate) the next cluster in the chain */
+
+      if (extend)
+        {
+          next = fat_extendchain(fs, cluster);
+        }
+      else
+        {
+          next = fat_getcluster(fs, cluster);
+        }
+
+      /* Stop at the end of the chain, on any error, or when the next cluster
+       * does not follow this one.  Errors will be reported when the caller
+       * moves to the next cluster.
+       */
+
+      if (next != cluster + 1 || next >= fs->fs_nclusters)
+        {
+          break;
+        }
+
+      cluster = next;
+      nrun   += fs->fs_fatsecperclus;
+    }
+
+  return nrun < nsectors ? nrun : nsectors;
+}
+
+/****************************************************************************
+ * Name: fat_advancesectors
+ *
+ * Description: Move the current sector of the file forward by 'nsectors'
+ *   sectors that were found by fat_runsectors().  If the transfer ends at
+ *   the end of a cluster, the current cluster is left as that cluster with
+ *   no sectors remaining so that the caller will follow the chain to the
+ *   next cluster.
+ *
+ ****************************************************************************/
+
+static void fat_advancesectors(struct fat_mountpt_s *fs,
+                               struct fat_file_s *ff, unsigned int nsectors)
+{
+  unsigned int nclusters;
+
+  ff->ff_currentsector += nsectors;
+  if (nsectors > ff->ff_sectorsincluster)
+    {
+      /* The transfer continued into the following cluster(s) */
+
+      nsectors               -= ff->ff_sectorsincluster;
+      nclusters               = (nsectors + fs->fs_fatsecperclus - 1) /
+                                fs->fs_fatsecperclus;
+      ff->ff_currentcluster  += nclusters;
+      ff->ff_sectorsincluster = nclusters * fs->fs_fatsecperclus - nsectors;
+    }
+  else
+    {
+      ff->ff_sectorsincluster -= nsectors;
+    }
+}
+
 /****************************************************************************
  * Name: fat_open
  ****************************************************************************/
@@ -300,15 +392,6 @@ static int fat_open(FAR struct file *filep, const char *relpath,
       goto errout_with_semaphore;
     }
 
-  /* Create a file buffer to support partial sector accesses */
-
-  ff->ff_buffer = (uint8_t*)kmalloc(fs->fs_hwsectorsize);
-  if (!ff->ff_buffer)
-    {
-      ret = -ENOMEM;
-      goto errout_with_struct;
-    }
-
   /* Initialize the file private data (only need to initialize non-zero elements) */
 
   ff->ff_open             = true;
@@ -362,9 +445,6 @@ static int fat_open(FAR struct file *filep, const char *relpath,
    * handling a lot simpler.
    */
 
-errout_with_struct:
-  kfree(ff);
-
 errout_with_semaphore:
   fat_semgive(fs);
   return ret;
@@ -401,19 +481,10 @@ static int fat_close(FAR struct file *filep)
 
   ret = fat_sync(filep);
 
-  /* Then deallocate the memory structures created when the open method
-   * was called.
-   *
-   * Free the sector buffer that was used to manage partial sector accesses.
+  /* Then deallocate the file structure created when the open method was
+   * called.
    */
 
-  if (ff->ff_buffer)
-    {
-      kfree(ff->ff_buffer);
-    }
-
-  /* Then free the file structure itself. */
-
   kfree(ff);
   filep->f_priv = NULL;
   return ret;
@@ -515,23 +586,24 @@ static ssize_t fat_read(FAR struct file *filep, char *buffer, size_t buflen)
       if (nsectors > 0 && sectorindex == 0)
         {
           /* Read maximum contiguous sectors directly to the user's
-           * buffer without using our tiny read buffer.
+           * buffer without using the sector cache.
            *
            * Limit the number of sectors that we read on this time
-           * through the loop to the remaining contiguous sectors
-           * in this cluster
+           * through the loop to the remaining sectors in this cluster
+           * and in any following clusters that are contiguous with it.
            */
 
-          if (nsectors > ff->ff_sectorsincluster)
-            {
-              nsectors = ff->ff_sectorsincluster;
-            }
+          nsectors = fat_runsectors(fs, ff, nsectors, false);
 
-          /* We are not sure of the state of the file buffer so
-           * the safest thing to do is just invalidate it
+          /* Any of the sectors may have been modified in the sector
+           * cache.  Write those back before reading from the device.
            */
 
-          (void)fat_ffcacheinvalidate(fs, ff);
+          ret = fat_fscachesync(fs, ff->ff_currentsector, nsectors);
+          if (ret < 0)
+            {
+              goto errout_with_semaphore;
+            }
 
           /* Read all of the sectors directly into user memory */
 
@@ -541,18 +613,17 @@ static ssize_t fat_read(FAR struct file *filep, char *buffer, size_t buflen)
               goto errout_with_semaphore;
             }
 
-          ff->ff_sectorsincluster -= nsectors;
-          ff->ff_currentsector    += nsectors;
-          bytesread                = nsectors * fs->fs_hwsectorsize;
+          fat_advancesectors(fs, ff, nsectors);
+          bytesread = nsectors * fs->fs_hwsectorsize;
         }
       else
         {
           /* We are reading a partial sector.  First, read the whole sector
-           * into the file data buffer.  This is a caching buffer so if
-           * it is already there then all is well.
+           * into the sector cache.  If it is already there then all is
+           * well.
            */
 
-          ret = fat_ffcacheread(fs, ff, ff->ff_currentsector);
+          ret = fat_fscacheread(fs, ff->ff_currentsector);
           if (ret < 0)
             {
               goto errout_with_semaphore;
@@ -575,7 +646,7 @@ static ssize_t fat_read(FAR struct file *filep, char *buffer, size_t buflen)
               ff->ff_currentsector++;
             }
 
-          memcpy(userbuffer, &ff->ff_buffer[sectorindex], bytesread);
+          memcpy(userbuffer, &fs->fs_buffer[sectorindex], bytesread);
         }
 
       /* Set up for the next sector read */
@@ -716,24 +787,21 @@ static ssize_t fat_write(FAR struct file *filep, const char *buffer,
       if (nsectors > 0 && sectorindex == 0)
         {
           /* Write maximum contiguous sectors directly from the user's
-           * buffer without using our tiny read buffer.
+           * buffer without using the sector cache.
            *
            * Limit the number of sectors that we write on this time
-           * through the loop to the remaining contiguous sectors
-           * in this cluster
+           * through the loop to the remaining sectors in this cluster
+           * and in any following clusters that are (or can be allocated)
+           * contiguous with it.
            */
 
-          if (nsectors > ff->ff_sectorsincluster)
-            {
-              nsectors = ff->ff_sectorsincluster;
-            }
+          nsectors = fat_runsectors(fs, ff, nsectors, true);
 
-          /* We are not sure of the state of the sector cache so the
-           * safest thing to do is write back any dirty, cached sector
-           * and invalidate the current cache content.
+          /* Any cached copies of these sectors are about to be
+           * overwritten.  Discard them.
            */
 
-          (void)fat_ffcacheinvalidate(fs, ff);
+          fat_fscachediscard(fs, ff->ff_currentsector, nsectors);
 
           /* Write all of the sectors directly from user memory */
 
@@ -743,9 +811,8 @@ static ssize_t fat_write(FAR struct file *filep, const char *buffer,
               goto errout_with_semaphore;
             }
 
-          ff->ff_sectorsincluster -= nsectors;
-          ff->ff_currentsector    += nsectors;
-          writesize                = nsectors * fs->fs_hwsectorsize;
+          fat_advancesectors(fs, ff, nsectors);
+          writesize = nsectors * fs->fs_hwsectorsize;
           ff->ff_bflags           |= FFBUFF_MODIFIED;
         }
       else
@@ -763,29 +830,24 @@ static ssize_t fat_write(FAR struct file *filep, const char *buffer,
 
           if (filep->f_pos < ff->ff_size || sectorindex != 0)
             {
-              /* Read the current sector into memory (perhaps first flushing
-               * the old, dirty sector to disk).
+              /* Read the current sector into the sector cache (perhaps
+               * first writing back the least recently used, dirty sector).
                */
 
-              ret = fat_ffcacheread(fs, ff, ff->ff_currentsector);
-              if (ret < 0)
-                {
-                  goto errout_with_semaphore;
-                }
+              ret = fat_fscacheread(fs, ff->ff_currentsector);
             }
           else
             {
-               /* Flush unwritten data in the sector cache. */
-
-               ret = fat_ffcacheflush(fs, ff);
-               if (ret < 0)
-                 {
-                   goto errout_with_semaphore;
-                 }
+              /* Just claim a sector cache buffer for the current sector.
+               * Nothing beyond the end of the file needs to be preserved.
+               */
 
-              /* Now mark the clean cache buffer as the current sector. */
+              ret = fat_fscachenew(fs, ff->ff_currentsector);
+            }
 
-              ff->ff_cachesector = ff->ff_currentsector;
+          if (ret < 0)
+            {
+              goto errout_with_semaphore;
             }
 
           /* Copy the partial sector from the user buffer */
@@ -813,8 +875,9 @@ static ssize_t fat_write(FAR struct file *filep, const char *buffer,
            * cached sector is marked "dirty"
            */
 
-          memcpy(&ff->ff_buffer[sectorindex], userbuffer, writesize);
-          ff->ff_bflags |= (FFBUFF_DIRTY|FFBUFF_VALID|FFBUFF_MODIFIED);
+          memcpy(&fs->fs_buffer[sectorindex], userbuffer, writesize);
+          fs->fs_dirty   = true;
+          ff->ff_bflags |= FFBUFF_MODIFIED;
         }
 
       /* Set up for the next write */
@@ -931,14 +994,6 @@ static off_t fat_seek(FAR struct file *filep, off_t offset, int whence)
       goto errout_with_semaphore;
     }
 
-  /* Check if there is unwritten data in the file buffer */
-
-  ret = fat_ffcacheflush(fs, ff);
-  if (ret < 0)
-    {
-      goto errout_with_semaphore;
-    }
-
   /* Attempts to set the position beyound the end of file will
    * work if the file is open for write access.
    */
@@ -1075,7 +1130,7 @@ static off_t fat_seek(FAR struct file *filep, off_t offset, int whence)
 
       if ((position & SEC_NDXMASK(fs)) != 0)
         {
-          ret = fat_ffcacheread(fs, ff, ff->ff_currentsector);
+          ret = fat_fscacheread(fs, ff->ff_currentsector);
           if (ret < 0)
             {
               goto errout_with_semaphore;
@@ -1180,16 +1235,8 @@ static int fat_sync(FAR struct file *filep)
 
   if ((ff->ff_bflags & FFBUFF_MODIFIED) != 0)
     {
-      /* Flush any unwritten data in the file buffer */
-
-      ret = fat_ffcacheflush(fs, ff);
-      if (ret < 0)
-        {
-          goto errout_with_semaphore;
-        }
-
       /* Update the directory entry.  First read the directory
-       * entry into the fs_buffer (preserving the ff_buffer)
+       * entry into the sector cache.
        */
 
       ret = fat_fscacheread(fs, ff->ff_dirsector);
@@ -1223,8 +1270,8 @@ static int fat_sync(FAR struct file *filep)
 
       ff->ff_bflags &= ~FFBUFF_MODIFIED;
 
-      /* Flush these change to disk and update FSINFO (if
-       * appropriate.
+      /* Flush these change (and any unwritten file data) to disk and
+       * update FSINFO (if appropriate).
        */
 
       fs->fs_dirty = true;
@@ -1628,13 +1675,17 @@ static int fat_unbind(void *handle, FAR struct inode **blkdriver)
     }
   else
     {
-       /* Unmount ... close the block driver */
+       /* Unmount ... write back anything left in the sector cache and the
+        * FSINFO sector and close the block driver
+        */
 
       if (fs->fs_blkdriver)
         {
           struct inode *inode = fs->fs_blkdriver;
           if (inode)
             {
+              (void)fat_updatefsinfo(fs);
+
               if (inode->u.i_bops && inode->u.i_bops->close)
                 {
                   (void)inode->u.i_bops->close(inode);
@@ -1655,10 +1706,10 @@ static int fat_unbind(void *handle, FAR struct inode **blkdriver)
 
       /* Release the mountpoint private data */
 
-      if (fs->fs_buffer)
-        {
-          kfree(fs->fs_buffer);
-        }
+      fat_cacheuninitialize(fs);
+#ifdef CONFIG_FAT_FREEMAP
+      fat_freemapuninitialize(fs);
+#endif
       kfree(fs);
     }
 
@@ -1707,7 +1758,12 @@ static int fat_statfs(struct inode *mountpt, struct statfs *buf)
   /* Everything else follows in units of clusters */
 
   buf->f_blocks  = fs->fs_nclusters;                        /* Total data blocks in the file system */
-  buf->f_bfree   = fat_nfreeclusters(fs, &buf->f_bfree);    /* Free blocks in the file system */
+  ret            = fat_nfreeclusters(fs, &buf->f_bfree);    /* Free blocks in the file system */
+  if (ret < 0)
+    {
+      goto errout_with_semaphore;
+    }
+
   buf->f_bavail  = buf->f_bfree;                            /* Free blocks avail to non-superuser */
   buf->f_namelen = (8+1+3);                                 /* Maximum length of filenames */
 
@@ -1859,11 +1915,13 @@ static int fat_mkdir(struct inode *mountpt, const char *relpath, mode_t mode)
       goto errout_with_semaphore;
     }
 
-  /* Flush any existing, dirty data in fs_buffer (because we need 
-   * it to create the directory entries.
+  /* Any cached copies of sectors in the new directory cluster are stale.
+   * Discard them, then claim a sector cache buffer for the first sector
+   * (there is no need to read it).
    */
 
-  ret = fat_fscacheflush(fs);
+  fat_fscachediscard(fs, dirsector, fs->fs_fatsecperclus);
+  ret = fat_fscachenew(fs, dirsector);
   if (ret < 0)
     {
       goto errout_with_semaphore;
@@ -1875,7 +1933,6 @@ static int fat_mkdir(struct inode *mountpt, const char *relpath, mode_t mode)
 
   /* Now erase the contents of fs_buffer */
 
-  fs->fs_currentsector = dirsector;
   memset(direntry, 0, fs->fs_hwsectorsize);
 
   /* Now clear all sectors in the new directory cluster (except for the first) */
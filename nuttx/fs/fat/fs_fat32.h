@@ -54,6 +54,39 @@
  * Definitions
  ****************************************************************************/
 
+/* Configuration ************************************************************/
+/* CONFIG_FAT_NCACHESECTORS - The number of sectors held in the mountpoint
+ *   sector cache.  The cache is shared by FAT table, directory, and partial
+ *   file data sector accesses and is managed as least-recently-used.
+ */
+
+#ifndef CONFIG_FAT_NCACHESECTORS
+#  define CONFIG_FAT_NCACHESECTORS 4
+#endif
+
+#if CONFIG_FAT_NCACHESECTORS < 1
+#  undef  CONFIG_FAT_NCACHESECTORS
+#  define CONFIG_FAT_NCACHESECTORS 1
+#endif
+
+/* CONFIG_FAT_FREEMAP - Keep an in-memory bitmap with one bit per cluster
+ *   that records which clusters are free.  The bitmap is built from the FAT
+ *   the first time that a free cluster or the free cluster count is needed.
+ *   If it cannot be allocated, the FAT is searched as before.
+ * CONFIG_FAT_ALLOCRUN - With CONFIG_FAT_FREEMAP, a new cluster chain is
+ *   started at a run of at least this many free clusters (if there is one)
+ *   so that the file can grow contiguously.
+ */
+
+#ifndef CONFIG_FAT_ALLOCRUN
+#  define CONFIG_FAT_ALLOCRUN 8
+#endif
+
+#if CONFIG_FAT_ALLOCRUN < 1
+#  undef  CONFIG_FAT_ALLOCRUN
+#  define CONFIG_FAT_ALLOCRUN 1
+#endif
+
 /****************************************************************************
  * These offsets describes the master boot record.
  *
@@ -272,9 +305,7 @@
 
 /* File buffer flags */
 
-#define FFBUFF_VALID        1
-#define FFBUFF_DIRTY        2
-#define FFBUFF_MODIFIED     4
+#define FFBUFF_MODIFIED     1
 
 /****************************************************************************
  * These offset describe the FSINFO sector
@@ -680,9 +711,23 @@
  * Public Types
  ****************************************************************************/
 
+/* This structure describes one sector in the mountpoint sector cache */
+
+struct fat_cache_s
+{
+  off_t    fc_sector;              /* The sector held in fc_buffer (-1: none) */
+  uint32_t fc_age;                 /* Value of fs_cacheage when last accessed */
+  bool     fc_dirty;               /* true: fc_buffer must be written back */
+  uint8_t *fc_buffer;              /* Holds one sector from the device */
+};
+
 /* This structure represents the overall mountpoint state.  An instance of this
  * structure is retained as inode private data on each mountpoint that is
  * mounted with a fat32 filesystem.
+ *
+ * fs_buffer, fs_currentsector, and fs_dirty always describe the most
+ * recently accessed entry in the sector cache (fs_current).  The remaining
+ * entries in fs_cache[] retain other recently used sectors.
  */
 
 struct fat_file_s;
@@ -699,6 +744,10 @@ struct fat_mountpt_s
   off_t    fs_database;            /* Logical block of start data sectors */
   off_t    fs_fsinfo;              /* MBR: Sector number of FSINFO sector */
   off_t    fs_currentsector;       /* The sector number buffered in fs_buffer */
+  uint32_t fs_cacheage;            /* Incremented on each sector cache access */
+  uint32_t fs_cachehits;           /* Sector cache accesses found in the cache */
+  uint32_t fs_cachemisses;         /* Sector cache accesses read from the device */
+  uint32_t fs_cachewrites;         /* Dirty sectors written back from the cache */
   uint32_t fs_nclusters;           /* Maximum number of data clusters */
   uint32_t fs_nfatsects;           /* MBR: Count of sectors occupied by one fat */
   uint32_t fs_fattotsec;           /* MBR: Total count of sectors on the volume */
@@ -712,8 +761,12 @@ struct fat_mountpt_s
   uint8_t  fs_type;                /* FSTYPE_FAT12, FSTYPE_FAT16, or FSTYPE_FAT32 */
   uint8_t  fs_fatnumfats;          /* MBR: Number of FATs (probably 2) */
   uint8_t  fs_fatsecperclus;       /* MBR: Sectors per allocation unit: 2**n, n=0..7 */
-  uint8_t *fs_buffer;              /* This is an allocated buffer to hold one sector
-                                    * from the device */
+  uint8_t *fs_buffer;              /* Buffer of the current sector cache entry */
+  struct fat_cache_s *fs_current;  /* The sector cache entry that is current */
+  struct fat_cache_s fs_cache[CONFIG_FAT_NCACHESECTORS];
+#ifdef CONFIG_FAT_FREEMAP
+  uint8_t *fs_freemap;             /* Bitmap of free clusters (1=free) or NULL */
+#endif
 };
 
 /* This structure represents on open file under the mountpoint.  An instance
@@ -734,8 +787,6 @@ struct fat_file_s
   off_t    ff_size;                /* Size of the file in bytes */
   off_t    ff_startcluster;        /* Start cluster of file on media */
   off_t    ff_currentsector;       /* Current sector being operated on */
-  off_t    ff_cachesector;         /* Current sector in the file buffer */
-  uint8_t *ff_buffer;              /* File buffer (for partial sector accesses) */
 };
 
 /* This structure holds the sequency of directory entries used by one
@@ -867,6 +918,9 @@ EXTERN int    fat_putcluster(struct fat_mountpt_s *fs, uint32_t clusterno,
                              off_t startsector);
 EXTERN int    fat_removechain(struct fat_mountpt_s *fs, uint32_t cluster);
 EXTERN int32_t fat_extendchain(struct fat_mountpt_s *fs, uint32_t cluster);
+#ifdef CONFIG_FAT_FREEMAP
+EXTERN void   fat_freemapuninitialize(struct fat_mountpt_s *fs);
+#endif
 
 #define fat_createchain(fs) fat_extendchain(fs, 0)
 
@@ -888,13 +942,17 @@ EXTERN int    fat_dirtruncate(struct fat_mountpt_s *fs, struct fat_dirinfo_s *di
 EXTERN int    fat_dircreate(struct fat_mountpt_s *fs, struct fat_dirinfo_s *dirinfo);
 EXTERN int    fat_remove(struct fat_mountpt_s *fs, const char *relpath, bool directory);
 
-/* Mountpoint and file buffer cache (for partial sector accesses) */
+/* Mountpoint sector cache (FAT, directory, and partial sector accesses) */
 
+EXTERN int    fat_cacheinitialize(struct fat_mountpt_s *fs);
+EXTERN void   fat_cacheuninitialize(struct fat_mountpt_s *fs);
 EXTERN int    fat_fscacheflush(struct fat_mountpt_s *fs);
 EXTERN int    fat_fscacheread(struct fat_mountpt_s *fs, off_t sector);
-EXTERN int    fat_ffcacheflush(struct fat_mountpt_s *fs, struct fat_file_s *ff);
-EXTERN int    fat_ffcacheread(struct fat_mountpt_s *fs, struct fat_file_s *ff, off_t sector);
-EXTERN int    fat_ffcacheinvalidate(struct fat_mountpt_s *fs, struct fat_file_s *ff);
+EXTERN int    fat_fscachenew(struct fat_mountpt_s *fs, off_t sector);
+EXTERN int    fat_fscachesync(struct fat_mountpt_s *fs, off_t sector,
+                              unsigned int nsectors);
+EXTERN void   fat_fscachediscard(struct fat_mountpt_s *fs, off_t sector,
+                                 unsigned int nsectors);
 
 /* FSINFO sector support */
 
@@ -187,3 +187,65 @@ int fat_setattrib(const char *path, fat_attrib_t setbits, fat_attrib_t clearbits
   return fat_attrib(path, NULL, setbits, clearbits);
 }
 
+/****************************************************************************
+ * Name: fat_getcachestats
+ ****************************************************************************/
+
+int fat_getcachestats(const char *path, struct fat_cachestats_s *stats)
+{
+  struct fat_mountpt_s *fs;
+  FAR struct inode     *inode;
+  const char           *relpath = NULL;
+  int                   ret;
+
+  /* Get the inode of the mountpoint that contains this path */
+
+  inode = inode_find(path, &relpath);
+  if (!inode)
+    {
+      ret = ENOENT;
+      goto errout;
+    }
+
+  /* Verify that the inode is a valid mountpoint. */
+
+  if (!INODE_IS_MOUNTPT(inode) || !inode->u.i_mops || !inode->i_private)
+    {
+      ret = ENXIO;
+      goto errout_with_inode;
+    }
+
+  /* Get the mountpoint private data from the inode structure */
+
+  fs = inode->i_private;
+
+  /* Check if the mount is still healthy */
+
+  fat_semtake(fs);
+  ret = fat_checkmount(fs);
+  if (ret != OK)
+    {
+      ret = -ret;
+      goto errout_with_semaphore;
+    }
+
+  /* Return a snapshot of the statistics */
+
+  stats->cs_nsectors   = CONFIG_FAT_NCACHESECTORS;
+  stats->cs_sectorsize = fs->fs_hwsectorsize;
+  stats->cs_hits       = fs->fs_cachehits;
+  stats->cs_misses     = fs->fs_cachemisses;
+  stats->cs_writebacks = fs->fs_cachewrites;
+
+  fat_semgive(fs);
+  inode_release(inode);
+  return OK;
+
+errout_with_semaphore:
+  fat_semgive(fs);
+errout_with_inode:
+  inode_release(inode);
+errout:
+  *get_errno_ptr() = ret;
+  return ERROR;
+}
@@ -2490,11 +2490,14 @@ int fat_allocatedirentry(struct fat_mountpt_s *fs, struct fat_dirinfo_s *dirinfo
           return cluster;
         }
 
-     /* Flush out any cached data in fs_buffer.. we are going to use
-      * it to initialize the new directory cluster.
-      */
+      /* Discard any stale, cached copies of sectors in the new directory
+       * cluster and claim a sector cache buffer for the first sector.  We
+       * are going to use it to initialize the new directory cluster.
+       */
 
-      ret = fat_fscacheflush(fs);
+      sector = fat_cluster2sector(fs, cluster);
+      fat_fscachediscard(fs, sector, fs->fs_fatsecperclus);
+      ret = fat_fscachenew(fs, sector);
       if (ret < 0)
         {
           return ret;
@@ -2502,10 +2505,7 @@ int fat_allocatedirentry(struct fat_mountpt_s *fs, struct fat_dirinfo_s *dirinfo
 
       /* Clear all sectors comprising the new directory cluster */
 
-      fs->fs_currentsector = fat_cluster2sector(fs, cluster);
       memset(fs->fs_buffer, 0, fs->fs_hwsectorsize);
-
-      sector = fs->fs_currentsector;
       for (i = fs->fs_fatsecperclus; i; i--)
         {
           ret = fat_hwwrite(fs, fs->fs_buffer, sector, 1);
@@ -67,6 +67,12 @@
  * Definitions
  ****************************************************************************/
 
+/* The number of FAT sectors read at a time when the free cluster bitmap is
+ * built.
+ */
+
+#define FAT_MAPREADSECTORS 8
+
 /****************************************************************************
  * Private Types
  ****************************************************************************/
@@ -106,8 +112,8 @@ static int fat_checkfsinfo(struct fat_mountpt_s *fs)
           FSI_GETSTRUCTSIG(fs->fs_buffer) == 0x61417272 &&
           FSI_GETTRAILSIG(fs->fs_buffer) == BOOT_SIGNATURE32)
         {
-          fs->fs_fsinextfree  = FSI_GETFREECOUNT(fs->fs_buffer);
-          fs->fs_fsifreecount = FSI_GETNXTFREE(fs->fs_buffer);
+          fs->fs_fsinextfree  = FSI_GETNXTFREE(fs->fs_buffer);
+          fs->fs_fsifreecount = FSI_GETFREECOUNT(fs->fs_buffer);
           return OK;
         }
     }
@@ -283,6 +289,335 @@ static int fat_checkbootrecord(struct fat_mountpt_s *fs)
   return OK;
 }
 
+#ifdef CONFIG_FAT_FREEMAP
+/****************************************************************************
+ * Name: fat_mapisfree and fat_mapmark
+ *
+ * Desciption: Test or set the state of one cluster in the free cluster
+ *   bitmap.
+ *
+ ****************************************************************************/
+
+static inline bool fat_mapisfree(struct fat_mountpt_s *fs, uint32_t cluster)
+{
+  return (fs->fs_freemap[cluster >> 3] & (1 << (cluster & 7))) != 0;
+}
+
+static inline void fat_mapmark(struct fat_mountpt_s *fs, uint32_t cluster,
+                               bool free)
+{
+  if (free)
+    {
+      fs->fs_freemap[cluster >> 3] |= (1 << (cluster & 7));
+    }
+  else
+    {
+      fs->fs_freemap[cluster >> 3] &= ~(1 << (cluster & 7));
+    }
+}
+
+/****************************************************************************
+ * Name: fat_freemapbuild
+ *
+ * Desciption: Create the free cluster bitmap if it does not already exist.
+ *   The FAT16 and FAT32 tables are read FAT_MAPREADSECTORS sectors at a
+ *   time, bypassing the sector cache.  The free cluster count found in the
+ *   FAT replaces the FSINFO free cluster count.
+ *
+ ****************************************************************************/
+
+static int fat_freemapbuild(struct fat_mountpt_s *fs)
+{
+  uint8_t *buffer;
+  uint32_t nfreeclusters;
+  uint32_t cluster;
+  off_t    sector;
+  off_t    endsector;
+  unsigned int nsectors;
+  unsigned int offset;
+  unsigned int entrysize;
+  int      ret;
+
+  if (fs->fs_freemap)
+    {
+      return OK;
+    }
+
+  fs->fs_freemap = (uint8_t*)kzalloc((fs->fs_nclusters + 7) >> 3);
+  if (!fs->fs_freemap)
+    {
+      return -ENOMEM;
+    }
+
+  nfreeclusters = 0;
+  if (fs->fs_type == FSTYPE_FAT12)
+    {
+      /* FAT12 entries may straddle sectors, but the FAT is small.  Just
+       * examine every cluster through the sector cache.
+       */
+
+      for (cluster = 2; cluster < fs->fs_nclusters; cluster++)
+        {
+          off_t next = fat_getcluster(fs, cluster);
+          if (next < 0)
+            {
+              ret = next;
+              goto errout_with_map;
+            }
+          else if (next == 0)
+            {
+              fat_mapmark(fs, cluster, true);
+              nfreeclusters++;
+            }
+        }
+    }
+  else
+    {
+      /* Any FAT sectors that have been modified in the sector cache must be
+       * written back before the FAT is read directly from the device.
+       */
+
+      ret = fat_fscachesync(fs, fs->fs_fatbase, fs->fs_nfatsects);
+      if (ret < 0)
+        {
+          goto errout_with_map;
+        }
+
+      buffer = (uint8_t*)kmalloc(FAT_MAPREADSECTORS * fs->fs_hwsectorsize);
+      if (!buffer)
+        {
+          ret = -ENOMEM;
+          goto errout_with_map;
+        }
+
+      entrysize = (fs->fs_type == FSTYPE_FAT16) ? 2 : 4;
+      sector    = fs->fs_fatbase;
+      endsector = fs->fs_fatbase + fs->fs_nfatsects;
+      cluster   = 0;
+
+      while (cluster < fs->fs_nclusters && sector < endsector)
+        {
+          nsectors = FAT_MAPREADSECTORS;
+          if (nsectors > endsector - sector)
+            {
+              nsectors = endsector - sector;
+            }
+
+          ret = fat_hwread(fs, buffer, sector, nsectors);
+          if (ret < 0)
+            {
+              kfree(buffer);
+              goto errout_with_map;
+            }
+
+          /* Examine each FAT entry in the sectors just read.  Entries 0 and
+           * 1 are reserved.
+           */
+
+          for (offset = 0;
+               offset < nsectors * fs->fs_hwsectorsize &&
+               cluster < fs->fs_nclusters;
+               offset += entrysize, cluster++)
+            {
+              uint32_t next;
+
+              if (entrysize == 2)
+                {
+                  next = FAT_GETFAT16(buffer, offset);
+                }
+              else
+                {
+                  next = FAT_GETFAT32(buffer, offset) & 0x0fffffff;
+                }
+
+              if (next == 0 && cluster >= 2)
+                {
+                  fat_mapmark(fs, cluster, true);
+                  nfreeclusters++;
+                }
+            }
+
+          sector += nsectors;
+        }
+
+      kfree(buffer);
+    }
+
+  /* The count from the FAT is exact.  Update the FSINFO count if it was
+   * wrong.
+   */
+
+  if (fs->fs_fsifreecount != nfreeclusters)
+    {
+      fs->fs_fsifreecount = nfreeclusters;
+      if (fs->fs_type == FSTYPE_FAT32)
+        {
+          fs->fs_fsidirty = true;
+        }
+    }
+
+  return OK;
+
+errout_with_map:
+  fat_freemapuninitialize(fs);
+  return ret;
+}
+
+/****************************************************************************
+ * Name: fat_freemaprun
+ *
+ * Desciption: Search the free cluster bitmap for the first run of 'nrun'
+ *   free clusters that begins at or after 'cluster' and ends before 'end'.
+ *
+ * Return: The first cluster of the run or zero if there is no such run.
+ *
+ ****************************************************************************/
+
+static uint32_t fat_freemaprun(struct fat_mountpt_s *fs, uint32_t cluster,
+                               uint32_t end, uint32_t nrun)
+{
+  uint32_t run = 0;
+
+  while (cluster < end)
+    {
+      /* Skip quickly over bytes of the bitmap where every cluster is in use */
+
+      if ((cluster & 7) == 0 && fs->fs_freemap[cluster >> 3] == 0)
+        {
+          run      = 0;
+          cluster += 8;
+          continue;
+        }
+
+      if (!fat_mapisfree(fs, cluster))
+        {
+          run = 0;
+        }
+      else if (++run >= nrun)
+        {
+          return cluster - nrun + 1;
+        }
+
+      cluster++;
+    }
+
+  return 0;
+}
+
+/****************************************************************************
+ * Name: fat_freemapfind
+ *
+ * Desciption: Search the free cluster bitmap for a run of 'nrun' free
+ *   clusters, beginning at 'start' and wrapping back to the first cluster.
+ *
+ * Return: The first cluster of the run or zero if there is no such run.
+ *
+ ****************************************************************************/
+
+static uint32_t fat_freemapfind(struct fat_mountpt_s *fs, uint32_t start,
+                                uint32_t nrun)
+{
+  uint32_t cluster;
+  uint32_t end;
+
+  if (start < 2 || start >= fs->fs_nclusters)
+    {
+      start = 2;
+    }
+
+  cluster = fat_freemaprun(fs, start, fs->fs_nclusters, nrun);
+  if (cluster == 0 && start > 2)
+    {
+      /* Wrap around.  Allow the run to extend a little past the start */
+
+      end = start + nrun - 1;
+      if (end > fs->fs_nclusters)
+        {
+          end = fs->fs_nclusters;
+        }
+
+      cluster = fat_freemaprun(fs, 2, end, nrun);
+    }
+
+  return cluster;
+}
+#endif /* CONFIG_FAT_FREEMAP */
+
+/****************************************************************************
+ * Name: fat_findfreecluster
+ *
+ * Desciption: Search the FAT for the first free cluster after
+ *   'startcluster', wrapping back to the first cluster.
+ *
+ * Return: <0:error, 0: no free cluster, >=2: free cluster number
+ *
+ ****************************************************************************/
+
+static int32_t fat_findfreecluster(struct fat_mountpt_s *fs,
+                                   uint32_t startcluster)
+{
+  off_t    startsector;
+  uint32_t newcluster;
+
+  /* Loop until (1) we discover that there are not free clusters
+   * (return 0), an errors occurs (return -errno), or (3) we find
+   * the next cluster (return the new cluster number).
+   */
+
+  newcluster = startcluster;
+  for (;;)
+    {
+      /* Examine the next cluster in the FAT */
+
+      newcluster++;
+      if (newcluster >= fs->fs_nclusters)
+        {
+          /* If we hit the end of the available clusters, then
+           * wrap back to the beginning because we might have
+           * started at a non-optimal place.  But don't continue
+           * past the start cluster.
+           */
+
+          newcluster = 2;
+          if (newcluster > startcluster)
+            {
+              /* We are back past the starting cluster, then there
+               * is no free cluster.
+               */
+
+              return 0;
+            }
+        }
+
+      /* We have a candidate cluster.  Check if the cluster number is
+       * mapped to a group of sectors.
+       */
+
+      startsector = fat_getcluster(fs, newcluster);
+      if (startsector == 0)
+        {
+          /* Found have found a free cluster */
+
+          return newcluster;
+        }
+      else if (startsector < 0)
+        {
+          /* Some error occurred, return the error number */
+
+          return startsector;
+        }
+
+      /* We wrap all the back to the starting cluster?  If so, then
+       * there are no free clusters.
+       */
+
+      if (newcluster == startcluster)
+        {
+          return 0;
+        }
+    }
+}
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -539,12 +874,13 @@ int fat_mount(struct fat_mountpt_s *fs, bool writeable)
   fs->fs_hwsectorsize = geo.geo_sectorsize;
   fs->fs_hwnsectors   = geo.geo_nsectors;
 
-  /* Allocate a buffer to hold one hardware sector */
+  /* Allocate the sector cache.  Until the boot record has been found,
+   * fs_buffer is used as a simple, uncached sector buffer.
+   */
 
-  fs->fs_buffer = (uint8_t*)kmalloc(fs->fs_hwsectorsize);
-  if (!fs->fs_buffer)
+  ret = fat_cacheinitialize(fs);
+  if (ret < 0)
     {
-      ret = -ENOMEM;
       goto errout;
     }
 
@@ -667,8 +1003,7 @@ int fat_mount(struct fat_mountpt_s *fs, bool writeable)
   return OK;
 
  errout_with_buffer:
-  kfree(fs->fs_buffer);
-  fs->fs_buffer = 0;
+  fat_cacheuninitialize(fs);
  errout:
   fs->fs_mounted = false;
   return ret;
@@ -1077,9 +1412,19 @@ int fat_putcluster(struct fat_mountpt_s *fs, uint32_t clusterno, off_t nextclust
               return -EINVAL;
         }
 
-      /* Mark the modified sector as "dirty" and return success */
+      /* Mark the modified sector as "dirty" */
 
       fs->fs_dirty = true;
+
+#ifdef CONFIG_FAT_FREEMAP
+      /* Keep the free cluster bitmap in agreement with the FAT */
+
+      if (fs->fs_freemap && clusterno >= 2)
+        {
+          fat_mapmark(fs, clusterno, nextcluster == 0);
+        }
+#endif
+
       return OK;
     }
 
@@ -1150,6 +1495,9 @@ int32_t fat_extendchain(struct fat_mountpt_s *fs, uint32_t cluster)
   off_t    startsector;
   uint32_t newcluster;
   uint32_t startcluster;
+#ifdef CONFIG_FAT_FREEMAP
+  bool     newrun = false;
+#endif
   int      ret;
 
   /* The special value 0 is used when the new chain should start */
@@ -1198,63 +1546,52 @@ int32_t fat_extendchain(struct fat_mountpt_s *fs, uint32_t cluster)
       startcluster = cluster;
     }
 
-  /* Loop until (1) we discover that there are not free clusters
-   * (return 0), an errors occurs (return -errno), or (3) we find
-   * the next cluster (return the new cluster number).
-   */
+#ifdef CONFIG_FAT_FREEMAP
+  /* Use the free cluster bitmap to find a cluster, if we can */
 
-  newcluster = startcluster;
-  for (;;)
+  if (fat_freemapbuild(fs) == OK)
     {
-      /* Examine the next cluster in the FAT */
+      /* Extend the chain with the following cluster if it is free.
+       * Otherwise, start the new chain (or the new fragment of the chain)
+       * at a run of free clusters following the last run that was started.
+       */
 
-      newcluster++;
-      if (newcluster >= fs->fs_nclusters)
+      newcluster = startcluster + 1;
+      if (cluster == 0 || newcluster >= fs->fs_nclusters ||
+          !fat_mapisfree(fs, newcluster))
         {
-          /* If we hit the end of the available clusters, then
-           * wrap back to the beginning because we might have
-           * started at a non-optimal place.  But don't continue
-           * past the start cluster.
-           */
-
-          newcluster = 2;
-          if (newcluster > startcluster)
+          newcluster = fat_freemapfind(fs, fs->fs_fsinextfree + 1,
+                                       CONFIG_FAT_ALLOCRUN);
+          if (newcluster == 0)
             {
-              /* We are back past the starting cluster, then there
-               * is no free cluster.
-               */
-
-              return 0;
+              newcluster = fat_freemapfind(fs, fs->fs_fsinextfree + 1, 1);
             }
-        }
-
-      /* We have a candidate cluster.  Check if the cluster number is
-       * mapped to a group of sectors.
-       */
 
-      startsector = fat_getcluster(fs, newcluster);
-      if (startsector == 0)
-        {
-          /* Found have found a free cluster break out*/
-          break;
+          newrun = true;
         }
-      else if (startsector < 0)
+    }
+  else
+#endif
+    {
+      /* Search the FAT for the next free cluster */
+
+      ret = fat_findfreecluster(fs, startcluster);
+      if (ret < 0)
         {
-          /* Some error occurred, return the error number */
-          return startsector;
+          return ret;
         }
 
-      /* We wrap all the back to the starting cluster?  If so, then
-       * there are no free clusters.
-       */
+      newcluster = ret;
+    }
 
-      if (newcluster == startcluster)
-        {
-          return 0;
-        }
+  if (newcluster == 0)
+    {
+      /* There are no free clusters */
+
+      return 0;
     }
 
-  /* We get here only if we break out with an available cluster
+  /* We get here only if we have found an available cluster
    * number in 'newcluster'  Now mark that cluster as in-use.
    */
 
@@ -1280,7 +1617,35 @@ int32_t fat_extendchain(struct fat_mountpt_s *fs, uint32_t cluster)
 
   /* And update the FINSINFO for the next time we have to search */
 
-  fs->fs_fsinextfree = newcluster;
+#ifdef CONFIG_FAT_FREEMAP
+  if (fs->fs_freemap)
+    {
+      /* Start the next search after the run reserved for a new chain or
+       * fragment, and don't move the search back when a chain is extended
+       * in place.  This keeps files that are written at the same time
+       * apart.
+       */
+
+      if (newrun)
+        {
+          fs->fs_fsinextfree = newcluster + CONFIG_FAT_ALLOCRUN - 1;
+          if (fs->fs_fsinextfree >= fs->fs_nclusters)
+            {
+              fs->fs_fsinextfree = newcluster;
+            }
+        }
+      else if (newcluster > fs->fs_fsinextfree ||
+               fs->fs_fsinextfree >= fs->fs_nclusters)
+        {
+          fs->fs_fsinextfree = newcluster;
+        }
+    }
+  else
+#endif
+    {
+      fs->fs_fsinextfree = newcluster;
+    }
+
   if (fs->fs_fsifreecount != 0xffffffff)
     {
       fs->fs_fsifreecount--;
@@ -1292,6 +1657,24 @@ int32_t fat_extendchain(struct fat_mountpt_s *fs, uint32_t cluster)
   return newcluster;
 }
 
+/****************************************************************************
+ * Name: fat_freemapuninitialize
+ *
+ * Desciption: Free the free cluster bitmap (if it was ever built)
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_FAT_FREEMAP
+void fat_freemapuninitialize(struct fat_mountpt_s *fs)
+{
+  if (fs->fs_freemap)
+    {
+      kfree(fs->fs_freemap);
+      fs->fs_freemap = NULL;
+    }
+}
+#endif
+
 /****************************************************************************
  * Name: fat_nextdirentry
  *
@@ -1451,25 +1834,116 @@ int  fat_dirtruncate(struct fat_mountpt_s *fs, struct fat_dirinfo_s *dirinfo)
 }
 
 /****************************************************************************
- * Name: fat_fscacheflush
+ * Name: fat_cacheinitialize
  *
- * Desciption: Flush any dirty sector if fs_buffer as necessary
+ * Desciption: Allocate the sector buffers of the mountpoint sector cache
+ *   and mark every cache entry as empty.
  *
  ****************************************************************************/
 
-int fat_fscacheflush(struct fat_mountpt_s *fs)
+int fat_cacheinitialize(struct fat_mountpt_s *fs)
 {
-  int ret;
+  struct fat_cache_s *cache;
+  uint8_t            *buffer;
+  int                 i;
 
-  /* Check if the fs_buffer is dirty.  In this case, we will write back the
-   * contents of fs_buffer.
-   */
+  /* Allocate one buffer to hold all of the cached hardware sectors */
+
+  buffer = (uint8_t*)kmalloc(CONFIG_FAT_NCACHESECTORS * fs->fs_hwsectorsize);
+  if (!buffer)
+    {
+      return -ENOMEM;
+    }
+
+  for (i = 0; i < CONFIG_FAT_NCACHESECTORS; i++)
+    {
+      cache            = &fs->fs_cache[i];
+      cache->fc_sector = -1;
+      cache->fc_age    = 0;
+      cache->fc_dirty  = false;
+      cache->fc_buffer = buffer;
+      buffer          += fs->fs_hwsectorsize;
+    }
+
+  /* The first (empty) entry is the current entry */
+
+  fs->fs_current       = &fs->fs_cache[0];
+  fs->fs_buffer        = fs->fs_current->fc_buffer;
+  fs->fs_currentsector = -1;
+  fs->fs_dirty         = false;
+  fs->fs_cacheage      = 0;
+  fs->fs_cachehits     = 0;
+  fs->fs_cachemisses   = 0;
+  fs->fs_cachewrites   = 0;
+  return OK;
+}
+
+/****************************************************************************
+ * Name: fat_cacheuninitialize
+ *
+ * Desciption: Free the sector buffers of the mountpoint sector cache.  Any
+ *   dirty sectors are discarded.
+ *
+ ****************************************************************************/
+
+void fat_cacheuninitialize(struct fat_mountpt_s *fs)
+{
+  if (fs->fs_cache[0].fc_buffer)
+    {
+      kfree(fs->fs_cache[0].fc_buffer);
+      memset(fs->fs_cache, 0, sizeof(fs->fs_cache));
+    }
+
+  fs->fs_current = NULL;
+  fs->fs_buffer  = NULL;
+}
+
+/****************************************************************************
+ * Name: fat_cachesave and fat_cacheselect
+ *
+ * Desciption: fs_currentsector and fs_dirty describe the current sector
+ *   cache entry and may be changed by any logic that modifies fs_buffer.
+ *   fat_cachesave() copies the dirty state back into the current entry;
+ *   fat_cacheselect() makes an entry current.
+ *
+ ****************************************************************************/
 
-  if (fs->fs_dirty)
+static inline void fat_cachesave(struct fat_mountpt_s *fs)
+{
+  fs->fs_current->fc_dirty = fs->fs_dirty;
+}
+
+static inline void fat_cacheselect(struct fat_mountpt_s *fs,
+                                   struct fat_cache_s *cache)
+{
+  fs->fs_current       = cache;
+  fs->fs_buffer        = cache->fc_buffer;
+  fs->fs_currentsector = cache->fc_sector;
+  fs->fs_dirty         = cache->fc_dirty;
+}
+
+/****************************************************************************
+ * Name: fat_cachewriteback
+ *
+ * Desciption: Write back one sector cache entry if it is dirty.  If the
+ *   sector lies in the FAT region, then the change is made in each copy of
+ *   the FAT as well.
+ *
+ ****************************************************************************/
+
+static int fat_cachewriteback(struct fat_mountpt_s *fs,
+                              struct fat_cache_s *cache)
+{
+  off_t sector;
+  int   ret;
+  int   i;
+
+  if (cache->fc_dirty)
     {
       /* Write the dirty sector */
 
-      ret = fat_hwwrite(fs, fs->fs_buffer, fs->fs_currentsector, 1);
+      sector = cache->fc_sector;
+      ret    = fat_hwwrite(fs, cache->fc_buffer, sector, 1);
       if (ret < 0)
         {
           return ret;
@@ -1477,16 +1951,15 @@ int fat_fscacheflush(struct fat_mountpt_s *fs)
 
       /* Does the sector lie in the FAT region? */
 
-      if (fs->fs_currentsector >= fs->fs_fatbase &&
-          fs->fs_currentsector < fs->fs_fatbase + fs->fs_nfatsects)
+      if (sector >= fs->fs_fatbase &&
+          sector < fs->fs_fatbase + fs->fs_nfatsects)
         {
           /* Yes, then make the change in the FAT copy as well */
-          int i;
 
           for (i = fs->fs_fatnumfats; i >= 2; i--)
-            { 
-              fs->fs_currentsector += fs->fs_nfatsects;
-              ret = fat_hwwrite(fs, fs->fs_buffer, fs->fs_currentsector, 1);
+            {
+              sector += fs->fs_nfatsects;
+              ret = fat_hwwrite(fs, cache->fc_buffer, sector, 1);
               if (ret < 0)
                 {
                   return ret;
@@ -1496,164 +1969,205 @@ int fat_fscacheflush(struct fat_mountpt_s *fs)
 
       /* No longer dirty */
 
-      fs->fs_dirty = false;
+      cache->fc_dirty = false;
+      fs->fs_cachewrites++;
     }
+
   return OK;
 }
 
 /****************************************************************************
- * Name: fat_fscacheread
+ * Name: fat_cachelookup
  *
- * Desciption: Read the specified sector into the sector cache, flushing any
- *   existing dirty sectors as necessary.
+ * Desciption: Make the specified sector the current sector cache entry.  If
+ *   the sector is not already in the cache, then the least recently used
+ *   entry is written back (if dirty) and re-used.  The sector is read from
+ *   the device only if 'read' is true.
  *
  ****************************************************************************/
 
-int fat_fscacheread(struct fat_mountpt_s *fs, off_t sector)
+static int fat_cachelookup(struct fat_mountpt_s *fs, off_t sector, bool read)
 {
-  int ret;
+  struct fat_cache_s *cache;
+  struct fat_cache_s *victim;
+  int                 ret;
+  int                 i;
 
-  /* fs->fs_currentsector holds the current sector that is buffered in
-   * fs->fs_buffer. If the requested sector is the same as this sector, then
-   * we do nothing. Otherwise, we will have to read the new sector.
-   */
-
-    if (fs->fs_currentsector != sector)
-      {
-        /* We will need to read the new sector.  First, flush the cached
-         * sector if it is dirty.
-         */
+  /* Most accesses are to the current sector */
 
-        ret = fat_fscacheflush(fs);
-        if (ret < 0)
-          {
-              return ret;
-          }
+  if (fs->fs_currentsector == sector)
+    {
+      fs->fs_current->fc_age = ++fs->fs_cacheage;
+      fs->fs_cachehits++;
+      return OK;
+    }
 
-        /* Then read the specified sector into the cache */
+  /* Search the rest of the cache, remembering the least recently used
+   * entry.  Empty entries have an age of zero and so are used first.
+   */
 
-        ret = fat_hwread(fs, fs->fs_buffer, sector, 1);
-        if (ret < 0)
-          {
-            return ret;
-          }
+  fat_cachesave(fs);
 
-        /* Update the cached sector number */
+  victim = &fs->fs_cache[0];
+  for (i = 0; i < CONFIG_FAT_NCACHESECTORS; i++)
+    {
+      cache = &fs->fs_cache[i];
+      if (cache->fc_sector == sector)
+        {
+          fs->fs_cachehits++;
+          goto found;
+        }
 
-        fs->fs_currentsector = sector;
+      if (cache->fc_age < victim->fc_age)
+        {
+          victim = cache;
+        }
     }
 
-    return OK;
-}
-
-/****************************************************************************
- * Name: fat_ffcacheflush
- *
- * Desciption: Flush any dirty sectors as necessary
- *
- ****************************************************************************/
-
-int fat_ffcacheflush(struct fat_mountpt_s *fs, struct fat_file_s *ff)
-{
-  int ret;
-
-  /* Check if the ff_buffer is dirty.  In this case, we will write back the
-   * contents of ff_buffer.
+  /* Not in the cache.  Write back the least recently used sector if it
+   * is dirty.
    */
 
-  if (ff->ff_cachesector &&
-      ff->ff_bflags && (FFBUFF_DIRTY|FFBUFF_VALID) == (FFBUFF_DIRTY|FFBUFF_VALID))
+  ret = fat_cachewriteback(fs, victim);
+  if (ret < 0)
     {
-      /* Write the dirty sector */
+      return ret;
+    }
+
+  /* Then read the specified sector into the cache */
 
-      ret = fat_hwwrite(fs, ff->ff_buffer, ff->ff_cachesector, 1);
+  if (read)
+    {
+      ret = fat_hwread(fs, victim->fc_buffer, sector, 1);
       if (ret < 0)
         {
+          /* The entry no longer holds valid data */
+
+          victim->fc_sector = -1;
+          victim->fc_age    = 0;
+          fat_cacheselect(fs, victim);
           return ret;
         }
 
-      /* No longer dirty, but still valid */
-
-      ff->ff_bflags &= ~FFBUFF_DIRTY;
+      fs->fs_cachemisses++;
     }
 
+  cache            = victim;
+  cache->fc_sector = sector;
+
+found:
+  cache->fc_age = ++fs->fs_cacheage;
+  fat_cacheselect(fs, cache);
   return OK;
 }
 
 /****************************************************************************
- * Name: fat_ffcacheread
+ * Name: fat_fscacheflush
  *
- * Desciption: Read the specified sector into the sector cache, flushing any
- *   existing dirty sectors as necessary.
+ * Desciption: Write back every dirty sector in the sector cache
  *
  ****************************************************************************/
 
-int fat_ffcacheread(struct fat_mountpt_s *fs, struct fat_file_s *ff, off_t sector)
+int fat_fscacheflush(struct fat_mountpt_s *fs)
 {
-  int ret;
+  int ret = OK;
+  int i;
 
-  /* ff->ff_cachesector holds the current sector that is buffered in
-   * ff->ff_buffer. If the requested sector is the same as this sector, then
-   * we do nothing. Otherwise, we will have to read the new sector.
-   */
-
-  if (ff->ff_cachesector != sector || (ff->ff_bflags & FFBUFF_VALID) == 0)
-      {
-        /* We will need to read the new sector.  First, flush the cached
-         * sector if it is dirty.
-         */
+  fat_cachesave(fs);
+  for (i = 0; i < CONFIG_FAT_NCACHESECTORS && ret == OK; i++)
+    {
+      ret = fat_cachewriteback(fs, &fs->fs_cache[i]);
+    }
 
-        ret = fat_ffcacheflush(fs, ff);
-        if (ret < 0)
-          {
-              return ret;
-          }
+  fat_cacheselect(fs, fs->fs_current);
+  return ret;
+}
 
-        /* Then read the specified sector into the cache */
+/****************************************************************************
+ * Name: fat_fscacheread
+ *
+ * Desciption: Read the specified sector into the sector cache, writing
+ *   back the least recently used sector as necessary.  On return, the
+ *   sector is in fs_buffer.
+ *
+ ****************************************************************************/
 
-        ret = fat_hwread(fs, ff->ff_buffer, sector, 1);
-        if (ret < 0)
-          {
-            return ret;
-          }
+int fat_fscacheread(struct fat_mountpt_s *fs, off_t sector)
+{
+  return fat_cachelookup(fs, sector, true);
+}
 
-        /* Update the cached sector number */
+/****************************************************************************
+ * Name: fat_fscachenew
+ *
+ * Desciption: Like fat_fscacheread() except that the sector is not read
+ *   from the device if it is not already in the cache.  The caller must
+ *   initialize the entire content of fs_buffer.
+ *
+ ****************************************************************************/
 
-        ff->ff_cachesector = sector;
-        ff->ff_bflags |= FFBUFF_VALID;
-    }
-    return OK;
+int fat_fscachenew(struct fat_mountpt_s *fs, off_t sector)
+{
+  return fat_cachelookup(fs, sector, false);
 }
 
 /****************************************************************************
- * Name: fat_ffcacheread
+ * Name: fat_fscachesync
  *
- * Desciption: Invalidate the current file buffer contents
+ * Desciption: Write back any dirty, cached sectors in the specified range.
+ *   This must be done before the sectors are read directly from the device.
  *
  ****************************************************************************/
 
-int fat_ffcacheinvalidate(struct fat_mountpt_s *fs, struct fat_file_s *ff)
+int fat_fscachesync(struct fat_mountpt_s *fs, off_t sector,
+                    unsigned int nsectors)
 {
-  int ret;
+  struct fat_cache_s *cache;
+  int ret = OK;
+  int i;
 
-  /* Is there anything valid in the buffer now? */
+  fat_cachesave(fs);
+  for (i = 0; i < CONFIG_FAT_NCACHESECTORS && ret == OK; i++)
+    {
+      cache = &fs->fs_cache[i];
+      if (cache->fc_sector >= sector && cache->fc_sector < sector + nsectors)
+        {
+          ret = fat_cachewriteback(fs, cache);
+        }
+    }
 
-  if ((ff->ff_bflags & FFBUFF_VALID) != 0)
-      {
-        /* We will invalidate the buffered sector */
+  fat_cacheselect(fs, fs->fs_current);
+  return ret;
+}
 
-        ret = fat_ffcacheflush(fs, ff);
-        if (ret < 0)
-          {
-              return ret;
-          }
+/****************************************************************************
+ * Name: fat_fscachediscard
+ *
+ * Desciption: Discard any cached sectors in the specified range without
+ *   writing them back.  This must be done before the sectors are written
+ *   directly to the device.
+ *
+ ****************************************************************************/
 
-        /* Then discard the current cache contents */
+void fat_fscachediscard(struct fat_mountpt_s *fs, off_t sector,
+                        unsigned int nsectors)
+{
+  struct fat_cache_s *cache;
+  int i;
 
-        ff->ff_bflags     &= ~FFBUFF_VALID;
-        ff->ff_cachesector = 0;
+  fat_cachesave(fs);
+  for (i = 0; i < CONFIG_FAT_NCACHESECTORS; i++)
+    {
+      cache = &fs->fs_cache[i];
+      if (cache->fc_sector >= sector && cache->fc_sector < sector + nsectors)
+        {
+          cache->fc_sector = -1;
+          cache->fc_age    = 0;
+          cache->fc_dirty  = false;
+        }
     }
-    return OK;
+
+  fat_cacheselect(fs, fs->fs_current);
 }
 
 /****************************************************************************
@@ -1668,7 +2182,7 @@ int fat_updatefsinfo(struct fat_mountpt_s *fs)
 {
   int ret;
 
-  /* Flush the fs_buffer if it is dirty */
+  /* Flush the sector cache if it is dirty */
 
   ret = fat_fscacheflush(fs);
   if (ret == OK)
@@ -1681,7 +2195,13 @@ int fat_updatefsinfo(struct fat_mountpt_s *fs)
 
       if (fs->fs_type == FSTYPE_FAT32 && fs->fs_fsidirty)
         {
-          /* Create an image of the FSINFO sector in the fs_buffer */
+          /* Create an image of the FSINFO sector in the sector cache */
+
+          ret = fat_fscachenew(fs, fs->fs_fsinfo);
+          if (ret < 0)
+            {
+              return ret;
+            }
 
           memset(fs->fs_buffer, 0, fs->fs_hwsectorsize);
           FSI_PUTLEADSIG(fs->fs_buffer, 0x41615252);
@@ -1692,9 +2212,8 @@ int fat_updatefsinfo(struct fat_mountpt_s *fs)
 
           /* Then flush this to disk */
 
-          fs->fs_currentsector = fs->fs_fsinfo;
-          fs->fs_dirty         = true;
-          ret                  = fat_fscacheflush(fs);
+          fs->fs_dirty = true;
+          ret          = fat_fscacheflush(fs);
 
           /* No longer dirty */
 
@@ -1723,6 +2242,16 @@ int fat_nfreeclusters(struct fat_mountpt_s *fs, off_t *pfreeclusters)
       return OK;
     }
 
+#ifdef CONFIG_FAT_FREEMAP
+  /* Building the free cluster bitmap also counts the free clusters */
+
+  if (fat_freemapbuild(fs) == OK)
+    {
+      *pfreeclusters = fs->fs_fsifreecount;
+      return OK;
+    }
+#endif
+
   /* Otherwise, we will have to count the number of free clusters */
 
   nfreeclusters = 0;
@@ -1761,7 +2290,7 @@ int fat_nfreeclusters(struct fat_mountpt_s *fs, off_t *pfreeclusters)
 
           if (offset >= fs->fs_hwsectorsize)
             {
-              ret = fat_fscacheread(fs, fatsector++);
+              ret = fat_fscacheread(fs, fatsector);
               if (ret < 0)
                 {
                   return ret;
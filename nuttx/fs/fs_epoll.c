@@ -0,0 +1,829 @@
+/****************************************************************************
+ * fs/fs_epoll.c
+ *
+ *   Copyright (C) 2012 Gregory Nutt. All rights reserved.
+ *   Author: Gregory Nutt <gnutt@nuttx.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name NuttX nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/epoll.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <poll.h>
+#include <wdog.h>
+#include <errno.h>
+#include <assert.h>
+#include <debug.h>
+
+#include <arch/irq.h>
+#include <nuttx/fs.h>
+#include <nuttx/kmalloc.h>
+#include <nuttx/clock.h>
+
+#include "fs_internal.h"
+
+#if !defined(CONFIG_DISABLE_POLL) && CONFIG_NFILE_DESCRIPTORS > 0
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* Configuration ************************************************************/
+/* The maximum number of epoll instances that may exist at the same time */
+
+#ifndef CONFIG_FS_NEPOLL
+#  define CONFIG_FS_NEPOLL 4
+#endif
+
+/* The poll events that may be requested of the drivers */
+
+#define EPOLL_PEVENTS (POLLIN|POLLOUT|POLLERR|POLLHUP)
+
+/* Convert the epoll_wait() timeout in milliseconds to system clock ticks,
+ * rounding up so that a short timeout does not become zero ticks.
+ */
+
+#define EPOLL_MSEC2TICK(msec) (((msec) + MSEC_PER_TICK - 1) / MSEC_PER_TICK)
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+/* One registered descriptor.  The poll stays set up for as long as the
+ * descriptor is registered; the driver reports events through the callback
+ * in ei_pfd which puts the registration in the ready list.
+ */
+
+struct epoll_head_s;
+struct epoll_item_s
+{
+  struct pollfd            ei_pfd;    /* Must be first: see epoll_callback */
+  FAR struct epoll_item_s *ei_flink;  /* Next registered descriptor */
+  FAR struct epoll_item_s *ei_rflink; /* Next descriptor in the ready list */
+  FAR struct epoll_item_s *ei_aflink; /* Next descriptor in the re-arm list */
+  FAR struct epoll_head_s *ei_head;   /* The epoll instance */
+  uint32_t                 ei_events; /* Requested events (EPOLL*) */
+  epoll_data_t             ei_data;   /* Returned with the events */
+  volatile bool            ei_ready;  /* In the ready list */
+  bool                     ei_rearm;  /* In the re-arm list */
+};
+
+/* The state of one epoll instance.  The ready list is modified by the
+ * driver callbacks, possibly from interrupt handlers, and so is accessed
+ * only with interrupts disabled.  Everything else is protected by
+ * ep_exclsem.
+ */
+
+struct epoll_head_s
+{
+  sem_t                    ep_sem;      /* Posted when an event is reported */
+  sem_t                    ep_exclsem;  /* Mutually exclusive access */
+  FAR struct epoll_item_s *ep_items;    /* All registered descriptors */
+  FAR struct epoll_item_s *ep_rhead;    /* Descriptors with events to report */
+  FAR struct epoll_item_s *ep_rtail;
+  FAR struct epoll_item_s *ep_rearm;    /* Level triggered descriptors that
+                                         * must be polled again */
+  volatile bool            ep_timedout; /* The wait timed out */
+};
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+/* The epoll instances.  An epoll handle is an index into this table. */
+
+static FAR struct epoll_head_s *g_epoll[CONFIG_FS_NEPOLL];
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: epoll_semtake
+ ****************************************************************************/
+
+static void epoll_semtake(FAR sem_t *sem)
+{
+  /* Take the semaphore (perhaps waiting) */
+
+  while (sem_wait(sem) != 0)
+    {
+      /* The only case that an error should occur here is if
+       * the wait was awakened by a signal.
+       */
+
+      ASSERT(errno == EINTR);
+    }
+}
+
+#define epoll_semgive(sem) sem_post(sem)
+
+/****************************************************************************
+ * Name: epoll_instance
+ *
+ * Description:
+ *   Return the epoll instance for a handle, or NULL (with errno set to
+ *   EBADF) if the handle is not valid.
+ *
+ ****************************************************************************/
+
+static FAR struct epoll_head_s *epoll_instance(int epfd)
+{
+  FAR struct epoll_head_s *ep = NULL;
+
+  if (epfd >= 0 && epfd < CONFIG_FS_NEPOLL)
+    {
+      ep = g_epoll[epfd];
+    }
+
+  if (!ep)
+    {
+      errno = EBADF;
+    }
+
+  return ep;
+}
+
+/****************************************************************************
+ * Name: epoll_addready
+ *
+ * Description:
+ *   Add the descriptor to the end of the ready list if it is not already
+ *   there.
+ *
+ * Assumptions:
+ *   Interrupts are disabled
+ *
+ ****************************************************************************/
+
+static void epoll_addready(FAR struct epoll_head_s *ep,
+                           FAR struct epoll_item_s *item)
+{
+  if (!item->ei_ready)
+    {
+      item->ei_ready  = true;
+      item->ei_rflink = NULL;
+      if (ep->ep_rtail)
+        {
+          ep->ep_rtail->ei_rflink = item;
+        }
+      else
+        {
+          ep->ep_rhead = item;
+        }
+
+      ep->ep_rtail = item;
+    }
+}
+
+/****************************************************************************
+ * Name: epoll_callback
+ *
+ * Description:
+ *   Called by the driver (via poll_notify()) when events are reported on
+ *   a registered descriptor.  This may run in an interrupt handler.
+ *
+ ****************************************************************************/
+
+static void epoll_callback(FAR struct pollfd *fds)
+{
+  FAR struct epoll_item_s *item = (FAR struct epoll_item_s *)fds;
+  FAR struct epoll_head_s *ep   = item->ei_head;
+  irqstate_t flags;
+
+  flags = irqsave();
+  epoll_addready(ep, item);
+  irqrestore(flags);
+
+  epoll_semgive(&ep->ep_sem);
+}
+
+/****************************************************************************
+ * Name: epoll_timeout
+ *
+ * Description:
+ *   The wdog expired before any events were reported.  The argument is
+ *   the epoll handle.
+ *
+ ****************************************************************************/
+
+static void epoll_timeout(int argc, uint32_t epfd, ...)
+{
+  FAR struct epoll_head_s *ep = g_epoll[epfd];
+
+  ep->ep_timedout = true;
+  epoll_semgive(&ep->ep_sem);
+}
+
+/****************************************************************************
+ * Name: epoll_find
+ *
+ * Description:
+ *   Find the registration for this descriptor.
+ *
+ ****************************************************************************/
+
+static FAR struct epoll_item_s *epoll_find(FAR struct epoll_head_s *ep,
+                                           int fd)
+{
+  FAR struct epoll_item_s *item;
+
+  for (item = ep->ep_items; item; item = item->ei_flink)
+    {
+      if (item->ei_pfd.fd == fd)
+        {
+          break;
+        }
+    }
+
+  return item;
+}
+
+/****************************************************************************
+ * Name: epoll_forget
+ *
+ * Description:
+ *   Remove the descriptor from the ready and re-arm lists.
+ *
+ ****************************************************************************/
+
+static void epoll_forget(FAR struct epoll_item_s *item)
+{
+  FAR struct epoll_head_s *ep = item->ei_head;
+  FAR struct epoll_item_s *prev;
+  FAR struct epoll_item_s **pprev;
+  irqstate_t flags;
+
+  flags = irqsave();
+  if (item->ei_ready)
+    {
+      for (prev = NULL, pprev = &ep->ep_rhead;
+           *pprev != item;
+           prev = *pprev, pprev = &(*pprev)->ei_rflink);
+
+      *pprev = item->ei_rflink;
+      if (ep->ep_rtail == item)
+        {
+          ep->ep_rtail = prev;
+        }
+
+      item->ei_ready = false;
+    }
+
+  item->ei_pfd.revents = 0;
+  irqrestore(flags);
+
+  if (item->ei_rearm)
+    {
+      for (pprev = &ep->ep_rearm;
+           *pprev != item;
+           pprev = &(*pprev)->ei_aflink);
+
+      *pprev = item->ei_aflink;
+      item->ei_rearm = false;
+    }
+}
+
+/****************************************************************************
+ * Name: epoll_setup
+ *
+ * Description:
+ *   Set up the poll on the descriptor.  The driver will report any events
+ *   that are already pending.
+ *
+ ****************************************************************************/
+
+static int epoll_setup(FAR struct epoll_item_s *item)
+{
+  item->ei_pfd.events  = (pollevent_t)(item->ei_events & EPOLL_PEVENTS);
+  item->ei_pfd.revents = 0;
+  item->ei_pfd.priv    = NULL;
+  return poll_fdsetup(item->ei_pfd.fd, &item->ei_pfd, true);
+}
+
+/****************************************************************************
+ * Name: epoll_teardown
+ *
+ * Description:
+ *   Tear down the poll on the descriptor and forget any events that it
+ *   reported.
+ *
+ ****************************************************************************/
+
+static int epoll_teardown(FAR struct epoll_item_s *item)
+{
+  int ret = poll_fdsetup(item->ei_pfd.fd, &item->ei_pfd, false);
+  epoll_forget(item);
+  return ret;
+}
+
+/****************************************************************************
+ * Name: epoll_rearm
+ *
+ * Description:
+ *   Poll the level triggered descriptors that were reported by the last
+ *   wait again.  Those whose condition persists go back into the ready list.
+ *   Only the descriptors that were reported are visited.
+ *
+ ****************************************************************************/
+
+static void epoll_rearm(FAR struct epoll_head_s *ep)
+{
+  FAR struct epoll_item_s *item;
+
+  while ((item = ep->ep_rearm) != NULL)
+    {
+      (void)epoll_teardown(item);
+      (void)epoll_setup(item);
+    }
+}
+
+/****************************************************************************
+ * Name: epoll_collect
+ *
+ * Description:
+ *   Remove up to maxevents descriptors from the ready list and return their
+ *   events.
+ *
+ ****************************************************************************/
+
+static int epoll_collect(FAR struct epoll_head_s *ep,
+                         FAR struct epoll_event *events, int maxevents)
+{
+  FAR struct epoll_item_s *item;
+  irqstate_t flags;
+  int nevents = 0;
+
+  flags = irqsave();
+  while (nevents < maxevents && (item = ep->ep_rhead) != NULL)
+    {
+      ep->ep_rhead = item->ei_rflink;
+      if (!ep->ep_rhead)
+        {
+          ep->ep_rtail = NULL;
+        }
+
+      item->ei_ready = false;
+
+      events[nevents].events = item->ei_pfd.revents;
+      events[nevents].data   = item->ei_data;
+      nevents++;
+
+      if ((item->ei_events & EPOLLET) != 0)
+        {
+          /* Edge triggered:  Report only new events next time */
+
+          item->ei_pfd.revents = 0;
+        }
+      else if (!item->ei_rearm)
+        {
+          /* Level triggered:  Check the condition again at the next wait */
+
+          item->ei_rearm  = true;
+          item->ei_aflink = ep->ep_rearm;
+          ep->ep_rearm    = item;
+        }
+    }
+  irqrestore(flags);
+
+  return nevents;
+}
+
+/****************************************************************************
+ * Name: epoll_scan
+ *
+ * Description:
+ *   Some drivers post the semaphore directly rather than using
+ *   poll_notify().  Their events do not reach the ready list so, if the
+ *   semaphore was posted but nothing is ready, look for them.
+ *
+ ****************************************************************************/
+
+static void epoll_scan(FAR struct epoll_head_s *ep)
+{
+  FAR struct epoll_item_s *item;
+  irqstate_t flags;
+
+  flags = irqsave();
+  for (item = ep->ep_items; item; item = item->ei_flink)
+    {
+      if (item->ei_pfd.revents != 0 && !item->ei_rearm)
+        {
+          epoll_addready(ep, item);
+        }
+    }
+  irqrestore(flags);
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: epoll_create
+ *
+ * Description:
+ *   Create an epoll instance.  Descriptors are registered with the instance
+ *   by epoll_ctl() and stay registered across calls to epoll_wait(), so
+ *   the drivers are set up only once for each descriptor and the cost of
+ *   epoll_wait() depends only on the number of descriptors that are ready.
+ *
+ *   NOTE:  The returned value is a handle that may only be used with the
+ *   epoll functions; it must be released with epoll_close(), not close().
+ *
+ * Inputs:
+ *   size - Ignored, but must be greater than zero.
+ *
+ * Return:
+ *   The epoll handle on success; -1 (ERROR) on failure with errno set:
+ *
+ *   EINVAL - size is not positive.
+ *   EMFILE - CONFIG_FS_NEPOLL epoll instances already exist.
+ *   ENOMEM - There was no memory for the epoll instance.
+ *
+ ****************************************************************************/
+
+int epoll_create(int size)
+{
+  FAR struct epoll_head_s *ep;
+  irqstate_t flags;
+  int epfd;
+
+  if (size <= 0)
+    {
+      errno = EINVAL;
+      return ERROR;
+    }
+
+  ep = (FAR struct epoll_head_s *)kzalloc(sizeof(struct epoll_head_s));
+  if (!ep)
+    {
+      errno = ENOMEM;
+      return ERROR;
+    }
+
+  sem_init(&ep->ep_sem, 0, 0);
+  sem_init(&ep->ep_exclsem, 0, 1);
+
+  /* Allocate a handle */
+
+  flags = irqsave();
+  for (epfd = 0; epfd < CONFIG_FS_NEPOLL; epfd++)
+    {
+      if (!g_epoll[epfd])
+        {
+          g_epoll[epfd] = ep;
+          break;
+        }
+    }
+  irqrestore(flags);
+
+  if (epfd >= CONFIG_FS_NEPOLL)
+    {
+      sem_destroy(&ep->ep_sem);
+      sem_destroy(&ep->ep_exclsem);
+      kfree(ep);
+      errno = EMFILE;
+      return ERROR;
+    }
+
+  return epfd;
+}
+
+/****************************************************************************
+ * Name: epoll_close
+ *
+ * Description:
+ *   Remove all registrations and release the epoll instance.
+ *
+ ****************************************************************************/
+
+int epoll_close(int epfd)
+{
+  FAR struct epoll_head_s *ep;
+  FAR struct epoll_item_s *item;
+  irqstate_t flags;
+
+  ep = epoll_instance(epfd);
+  if (!ep)
+    {
+      return ERROR;
+    }
+
+  epoll_semtake(&ep->ep_exclsem);
+
+  /* Release the handle */
+
+  flags = irqsave();
+  g_epoll[epfd] = NULL;
+  irqrestore(flags);
+
+  while ((item = ep->ep_items) != NULL)
+    {
+      ep->ep_items = item->ei_flink;
+      (void)epoll_teardown(item);
+      kfree(item);
+    }
+
+  sem_destroy(&ep->ep_sem);
+  sem_destroy(&ep->ep_exclsem);
+  kfree(ep);
+  return OK;
+}
+
+/****************************************************************************
+ * Name: epoll_ctl
+ *
+ * Description:
+ *   Add, modify, or remove the registration of a descriptor.  A descriptor
+ *   must be removed before it is closed.
+ *
+ * Inputs:
+ *   epfd - The handle returned by epoll_create()
+ *   op   - EPOLL_CTL_ADD, EPOLL_CTL_MOD, or EPOLL_CTL_DEL
+ *   fd   - The file or socket descriptor
+ *   ev   - The events of interest and the data to return with them (not
+ *          used by EPOLL_CTL_DEL)
+ *
+ * Return:
+ *   0 (OK) on success; -1 (ERROR) on failure with errno set:
+ *
+ *   EBADF  - epfd is not valid
+ *   EEXIST - EPOLL_CTL_ADD and fd is already registered
+ *   ENOENT - EPOLL_CTL_MOD or EPOLL_CTL_DEL and fd is not registered
+ *   EINVAL - op is not valid
+ *   ENOMEM - There was no memory for the registration
+ *   Any error returned by the driver poll method
+ *
+ ****************************************************************************/
+
+int epoll_ctl(int epfd, int op, int fd, FAR struct epoll_event *ev)
+{
+  FAR struct epoll_head_s *ep;
+  FAR struct epoll_item_s *item;
+  FAR struct epoll_item_s **pprev;
+  int ret = OK;
+
+  ep = epoll_instance(epfd);
+  if (!ep)
+    {
+      return ERROR;
+    }
+
+  if (op != EPOLL_CTL_DEL && !ev)
+    {
+      errno = EINVAL;
+      return ERROR;
+    }
+
+  epoll_semtake(&ep->ep_exclsem);
+  item = epoll_find(ep, fd);
+
+  switch (op)
+    {
+      case EPOLL_CTL_ADD:
+        {
+          if (item)
+            {
+              ret = -EEXIST;
+              break;
+            }
+
+          item = (FAR struct epoll_item_s *)kzalloc(sizeof(struct epoll_item_s));
+          if (!item)
+            {
+              ret = -ENOMEM;
+              break;
+            }
+
+          item->ei_pfd.fd  = fd;
+          item->ei_pfd.sem = &ep->ep_sem;
+          item->ei_pfd.cb  = epoll_callback;
+          item->ei_head    = ep;
+          item->ei_events  = ev->events;
+          item->ei_data    = ev->data;
+
+          ret = epoll_setup(item);
+          if (ret < 0)
+            {
+              epoll_forget(item);
+              kfree(item);
+              break;
+            }
+
+          item->ei_flink = ep->ep_items;
+          ep->ep_items   = item;
+        }
+        break;
+
+      case EPOLL_CTL_MOD:
+        {
+          if (!item)
+            {
+              ret = -ENOENT;
+              break;
+            }
+
+          (void)epoll_teardown(item);
+          item->ei_events = ev->events;
+          item->ei_data   = ev->data;
+
+          ret = epoll_setup(item);
+          if (ret < 0)
+            {
+              /* The descriptor could not be set up again.  Remove it. */
+
+              epoll_forget(item);
+              for (pprev = &ep->ep_items; *pprev != item; pprev = &(*pprev)->ei_flink);
+              *pprev = item->ei_flink;
+              kfree(item);
+            }
+        }
+        break;
+
+      case EPOLL_CTL_DEL:
+        {
+          if (!item)
+            {
+              ret = -ENOENT;
+              break;
+            }
+
+          for (pprev = &ep->ep_items; *pprev != item; pprev = &(*pprev)->ei_flink);
+          *pprev = item->ei_flink;
+
+          ret = epoll_teardown(item);
+          kfree(item);
+        }
+        break;
+
+      default:
+        ret = -EINVAL;
+        break;
+    }
+
+  epoll_semgive(&ep->ep_exclsem);
+
+  if (ret < 0)
+    {
+      errno = -ret;
+      return ERROR;
+    }
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: epoll_wait
+ *
+ * Description:
+ *   Wait for events on the registered descriptors.
+ *
+ * Inputs:
+ *   epfd      - The handle returned by epoll_create()
+ *   events    - The events that occurred are returned here
+ *   maxevents - The maximum number of events to return
+ *   timeout   - Specifies an upper limit on the time for which epoll_wait()
+ *     will block in milliseconds.  A negative value of timeout means an
+ *     infinite timeout.
+ *
+ * Return:
+ *   The number of events returned in the events array.  A value of 0
+ *   indicates that the call timed out.  On error, -1 is returned, and
+ *   errno is set appropriately:
+ *
+ *   EBADF  - epfd is not valid.
+ *   EINVAL - maxevents is not positive or events is NULL.
+ *   EINTR  - The wait was interrupted by a signal.
+ *   ENOMEM - No watchdog timer was available for the timeout.
+ *
+ ****************************************************************************/
+
+int epoll_wait(int epfd, FAR struct epoll_event *events, int maxevents,
+               int timeout)
+{
+  FAR struct epoll_head_s *ep;
+  WDOG_ID wdog = NULL;
+  int nevents;
+  int errcode = OK;
+
+  ep = epoll_instance(epfd);
+  if (!ep)
+    {
+      return ERROR;
+    }
+
+  if (!events || maxevents <= 0)
+    {
+      errno = EINVAL;
+      return ERROR;
+    }
+
+  /* Level triggered conditions that were reported last time are checked
+   * again now that the caller has had a chance to handle them.
+   */
+
+  epoll_semtake(&ep->ep_exclsem);
+  epoll_rearm(ep);
+  ep->ep_timedout = false;
+
+  for (;;)
+    {
+      nevents = epoll_collect(ep, events, maxevents);
+      if (nevents > 0 || timeout == 0 || ep->ep_timedout)
+        {
+          break;
+        }
+
+      /* Nothing is ready.  Wait for a driver to report an event.  Note that
+       * the millisecond timeout has to be converted to system clock ticks
+       * for wd_start.
+       */
+
+      if (timeout > 0 && !wdog)
+        {
+          wdog = wd_create();
+          if (!wdog)
+            {
+              errcode = ENOMEM;
+              break;
+            }
+
+          wd_start(wdog, EPOLL_MSEC2TICK(timeout), epoll_timeout, 1,
+                   (uint32_t)epfd);
+        }
+
+      /* A signal interrupts the wait */
+
+      epoll_semgive(&ep->ep_exclsem);
+      if (sem_wait(&ep->ep_sem) != 0)
+        {
+          errcode = errno;
+          DEBUGASSERT(errcode == EINTR);
+          epoll_semtake(&ep->ep_exclsem);
+          break;
+        }
+
+      epoll_semtake(&ep->ep_exclsem);
+
+      /* The semaphore counts every event so this may be a stale wakeup;
+       * or the event may be from a driver that does not use the callback.
+       */
+
+      if (!ep->ep_rhead)
+        {
+          epoll_scan(ep);
+        }
+    }
+
+  epoll_semgive(&ep->ep_exclsem);
+
+  if (wdog)
+    {
+      wd_delete(wdog);
+    }
+
+  if (errcode != OK)
+    {
+      errno = errcode;
+      return ERROR;
+    }
+
+  return nevents;
+}
+
+#endif /* !CONFIG_DISABLE_POLL && CONFIG_NFILE_DESCRIPTORS > 0 */
@@ -145,6 +145,12 @@ EXTERN void files_release(int filedes);
 EXTERN int find_blockdriver(FAR const char *pathname, int mountflags,
                             FAR struct inode **ppinode);
 
+/* fs_poll.c *****************************************************************/
+
+#if !defined(CONFIG_DISABLE_POLL) && CONFIG_NFILE_DESCRIPTORS > 0
+EXTERN int poll_fdsetup(int fd, FAR struct pollfd *fds, bool setup);
+#endif
+
 #undef EXTERN
 #if defined(__cplusplus)
 }
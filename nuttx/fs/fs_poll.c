@@ -83,67 +83,6 @@ static void poll_semtake(FAR sem_t *sem)
     }
 }
 
-/****************************************************************************
- * Name: poll_fdsetup
- *
- * Description:
- *   Configure (or unconfigure) one file/socket descriptor for the poll
- *   operation.  If fds and sem are non-null, then the poll is being setup.
- *   if fds and sem are NULL, then the poll is being torn down.
- *
- ****************************************************************************/
-
-#if CONFIG_NFILE_DESCRIPTORS > 0
-static int poll_fdsetup(int fd, FAR struct pollfd *fds, bool setup)
-{
-  FAR struct filelist *list;
-  FAR struct file     *this_file;
-  FAR struct inode    *inode;
-  int                  ret = -ENOSYS;
-
-  /* Check for a valid file descriptor */
-
-  if ((unsigned int)fd >= CONFIG_NFILE_DESCRIPTORS)
-    {
-      /* Perform the socket ioctl */
-
-#if defined(CONFIG_NET) && CONFIG_NSOCKET_DESCRIPTORS > 0
-      if ((unsigned int)fd < (CONFIG_NFILE_DESCRIPTORS+CONFIG_NSOCKET_DESCRIPTORS))
-        {
-          return net_poll(fd, fds, setup);
-        }
-      else
-#endif
-        {
-          return -EBADF;
-        }
-    }
-
-  /* Get the thread-specific file list */
-
-  list = sched_getfiles();
-  if (!list)
-    {
-      return -EMFILE;
-    }
-
-  /* Is a driver registered? Does it support the poll method?
-   * If not, return -ENOSYS
-   */
-
-  this_file = &list->fl_files[fd];
-  inode     = this_file->f_inode;
-
-  if (inode && inode->u.i_ops && inode->u.i_ops->poll)
-    {
-      /* Yes, then setup the poll */
-
-      ret = (int)inode->u.i_ops->poll(this_file, fds, setup);
-    }
-  return ret;
-}
-#endif
-
 /****************************************************************************
  * Name: poll_setup
  *
@@ -167,6 +106,7 @@ static inline int poll_setup(FAR struct pollfd *fds, nfds_t nfds, sem_t *sem)
       fds[i].sem     = sem;
       fds[i].revents = 0;
       fds[i].priv    = NULL;
+      fds[i].cb      = NULL;
 
       /* Set up the poll */
 
@@ -244,6 +184,108 @@ static void poll_timeout(int argc, uint32_t isem, ...)
  * Public Functions
  ****************************************************************************/
 
+/****************************************************************************
+ * Name: poll_fdsetup
+ *
+ * Description:
+ *   Configure (or unconfigure) one file/socket descriptor for the poll
+ *   operation.  If setup is true, then the poll is being setup.  Otherwise,
+ *   the poll is being torn down.  This is also used by epoll, which keeps
+ *   the poll set up for as long as the descriptor is registered.
+ *
+ ****************************************************************************/
+
+#if CONFIG_NFILE_DESCRIPTORS > 0
+int poll_fdsetup(int fd, FAR struct pollfd *fds, bool setup)
+{
+  FAR struct filelist *list;
+  FAR struct file     *this_file;
+  FAR struct inode    *inode;
+  int                  ret = -ENOSYS;
+
+  /* Check for a valid file descriptor */
+
+  if ((unsigned int)fd >= CONFIG_NFILE_DESCRIPTORS)
+    {
+      /* Perform the socket ioctl */
+
+#if defined(CONFIG_NET) && CONFIG_NSOCKET_DESCRIPTORS > 0
+      if ((unsigned int)fd < (CONFIG_NFILE_DESCRIPTORS+CONFIG_NSOCKET_DESCRIPTORS))
+        {
+          return net_poll(fd, fds, setup);
+        }
+      else
+#endif
+        {
+          return -EBADF;
+        }
+    }
+
+  /* Get the thread-specific file list */
+
+  list = sched_getfiles();
+  if (!list)
+    {
+      return -EMFILE;
+    }
+
+  /* Is a driver registered? Does it support the poll method?
+   * If not, return -ENOSYS
+   */
+
+  this_file = &list->fl_files[fd];
+  inode     = this_file->f_inode;
+
+  if (inode && inode->u.i_ops && inode->u.i_ops->poll)
+    {
+      /* Yes, then setup the poll */
+
+      ret = (int)inode->u.i_ops->poll(this_file, fds, setup);
+    }
+  return ret;
+}
+#endif
+
+/****************************************************************************
+ * Name: poll_notify
+ *
+ * Description:
+ *   Report events to each of the pollfd structures held by a driver.  The
+ *   events are added to revents if they were requested (POLLERR and POLLHUP
+ *   are always reported) and then the waiter is awakened, either by posting
+ *   its semaphore or, for epoll, by calling its callback.
+ *
+ *   This may be called from interrupt handlers.
+ *
+ ****************************************************************************/
+
+void poll_notify(FAR struct pollfd **afds, int nfds, pollevent_t eventset)
+{
+  FAR struct pollfd *fds;
+  int i;
+
+  for (i = 0; i < nfds; i++)
+    {
+      fds = afds[i];
+      if (fds)
+        {
+          fds->revents |= ((fds->events | POLLERR | POLLHUP) & eventset);
+          if (fds->revents != 0)
+            {
+              fvdbg("Report events: %02x\n", fds->revents);
+              if (fds->cb)
+                {
+                  fds->cb(fds);
+                }
+              else
+                {
+                  sem_post(fds->sem);
+                }
+            }
+        }
+    }
+}
+
 /****************************************************************************
  * Name: poll
  *
@@ -94,11 +94,14 @@
  *   written, allocations  proceed to toward the end of the FLASH -- thus,
  *   supporting wear leveling by using all FLASH blocks equally.
  *
- *   When the FLASH becomes full (no more space at the end of the FLASH), a
- *   re-packing operation must be performed:  All inodes marked deleted are
- *   finally removed and the remaining inodes are packed at the beginning of
- *   the FLASH.  Allocations then continue at the freed FLASH memory at the
- *   end of the FLASH.
+ *   When the FLASH becomes nearly full (little space left at the end of the
+ *   FLASH), a re-packing operation must be performed:  All inodes marked
+ *   deleted are finally removed and the remaining inodes are packed at the
+ *   beginning of the FLASH.  Allocations then continue at the freed FLASH
+ *   memory at the end of the FLASH.  Packing is performed incrementally, a
+ *   few erase blocks at a time, as new data blocks are allocated.  FLASH
+ *   freed at the end of the volume is erased only when allocations reach
+ *   it.
  *
  * BLOCK HEADER:
  *   The block header is used to determine if the block has every been
@@ -109,8 +112,12 @@
  *   the name of the inode, the offset to the first data block, and the
  *   length of the inode data.
  *
- *   At present, the only kind of inode support is a file.  So for now, the
- *   term file and inode are interchangeable.
+ *   At present, the only kind of inode support is a file.  A file may,
+ *   however, consist of several inodes:  The first inode (the "head") holds
+ *   the beginning of the file data; subsequent "extent" inodes of the same
+ *   name hold data that was appended to the file later.  Extents always lie
+ *   after the head and after earlier extents in FLASH; the file data is the
+ *   concatenation of the data of each inode in FLASH order.
  *
  * INODE DATA HEADER:
  *   Inode data is enclosed in a data header.  For a given inode, there
@@ -119,20 +126,22 @@
  *   in multiple data blocks, one per logical block.
  *
  * NXFFS Limitations:
- * 1. Since the files are contiguous in FLASH and since allocations always
- *    proceed toward the end of the FLASH, there can only be one file opened
- *    for writing at a time.  Multiple files may be opened for reading.
- * 2. Files may not be increased in size after they have been closed.  The
- *    O_APPEND open flag is not supported.
+ * 1. Since allocations always proceed toward the end of the FLASH, only one
+ *    of the files opened for writing can be extending FLASH at any time.
+ *    When another writer needs the end of FLASH, the current one is
+ *    suspended:  Its data is finalized in an inode and it continues later
+ *    with a new extent.  Many interleaved writes thus fragment files.
+ * 2. Files may be increased in size after they have been closed only by
+ *    opening them with O_APPEND.  Each append adds at least one extent.
  * 3. Files are always written sequential.  Seeking within a file opened for
  *    writing will not work.
  * 4. There are no directories, however, '/' may be used within a file name
  *    string providing some illusion of directories.
  * 5. Files may be opened for reading or for writing, but not both: The O_RDWR
  *    open flag is not supported.
- * 6. The re-packing process occurs only during a write when the free FLASH
- *    memory at the end of the FLASH is exhausted.  Thus, occasionally, file
- *    writing may take a long time.
+ * 6. The re-packing process occurs during writes when the free FLASH memory
+ *    at the end of the FLASH is low.  Each write then packs a bounded amount
+ *    of data, but a full pack is still needed if that does not keep up.
  * 7. Another limitation is that there can be only a single NXFFS volume
  *    mounted at any time.  This has to do with the fact that we bind to
  *    an MTD driver (instead of a block driver) and bypass all of the normal
@@ -156,6 +165,8 @@
 /* Values for NXFFS inode state.  Similar there are 2 (maybe 3) inode states:
  *
  * INODE_STATE_FILE    - The inode is a valid usuable, file
+ * INODE_STATE_EXTENT  - The inode holds data appended to the file of the same
+ *                       name
  * INODE_STATE_DELETED - The inode has been deleted.
  * Other values        - The inode is bad and has an invalid state.
  *
@@ -164,6 +175,7 @@
  */
 
 #define INODE_STATE_FILE          (CONFIG_NXFFS_ERASEDSTATE ^ 0x22)
+#define INODE_STATE_EXTENT        (CONFIG_NXFFS_ERASEDSTATE ^ 0x88)
 #define INODE_STATE_DELETED       (CONFIG_NXFFS_ERASEDSTATE ^ 0xaa)
 
 /* Number of bytes in an the NXFFS magic sequences */
@@ -244,6 +256,7 @@ struct nxffs_entry_s
   FAR char                 *name;      /* inode name */
   uint32_t                  utc;       /* Time stamp */
   uint32_t                  datlen;    /* Length of inode data */
+  uint8_t                   state;     /* Inode state: See INODE_STATE_* */
 };
 
 /* This structure describes int in-memory representation of the data block */
@@ -278,9 +291,11 @@ struct nxffs_wrfile_s
   /* The following fields are required to support the write operation */
 
   bool                      truncate;   /* Delete a file of the same name */
+  bool                      extend;     /* File exists: New inodes are extents */
   uint16_t                  datlen;     /* Number of bytes written in data block */
   off_t                     doffset;    /* FLASH offset to the current data header */
   uint32_t                  crc;        /* Accumulated data block CRC */
+  uint32_t                  filelen;    /* File length before the current inode */
 };
 
 /* This structure represents the overall state of on NXFFS instance. */
@@ -289,16 +304,20 @@ struct nxffs_volume_s
 {
   FAR struct mtd_dev_s     *mtd;       /* Supports FLASH access */
   sem_t                     exclsem;   /* Used to assure thread-safe access */
-  sem_t                     wrsem;     /* Enforces single writer restriction */
   struct mtd_geometry_s     geo;       /* Device geometry */
   uint8_t                   blkper;    /* R/W blocks per erase block */
   uint16_t                  iooffset;  /* Next offset in read/write access (in ioblock) */
   off_t                     inoffset;  /* Offset to the first valid inode header */
   off_t                     froffset;  /* Offset to the first free byte */
+  off_t                     pkoffset;  /* Inodes before this offset are packed */
+  off_t                     rpoffset;  /* Where the next packing pass begins (or 0) */
+  off_t                     dirtyblk;  /* First erase block to erase before re-use */
+  off_t                     cleanblk;  /* First erase block after the dirty blocks */
   off_t                     nblocks;   /* Number of R/W blocks on volume */
   off_t                     ioblock;   /* Current block number being accessed */
   off_t                     cblock;    /* Starting block number in cache */
   FAR struct nxffs_ofile_s *ofiles;    /* A singly-linked list of open files */
+  FAR struct nxffs_wrfile_s *wrfile;   /* The writer extending the FLASH region */
   FAR uint8_t              *cache;     /* On cached erase block for general I/O */
   FAR uint8_t              *pack;      /* A full erase block to support packing */
 };
@@ -620,7 +639,8 @@ extern int nxffs_nextentry(FAR struct nxffs_volume_s *volume, off_t offset,
  * Description:
  *   Search for an inode with the provided name starting with the first
  *   valid inode and proceeding to the end FLASH or until the matching
- *   inode is found.
+ *   inode is found.  Only the head inode of a file is returned; extents
+ *   are skipped.
  *
  * Input Parameters:
  *   volume - Describes the NXFFS volume
@@ -639,6 +659,58 @@ extern int nxffs_findinode(FAR struct nxffs_volume_s *volume,
                            FAR const char *name,
                            FAR struct nxffs_entry_s *entry);
 
+/****************************************************************************
+ * Name: nxffs_findextent
+ *
+ * Description:
+ *   Search for the next extent inode with the provided name starting at
+ *   the provided FLASH offset and proceeding to the end FLASH or until the
+ *   matching inode is found.
+ *
+ * Input Parameters:
+ *   volume - Describes the NXFFS volume
+ *   offset - The FLASH memory offset to begin searching (normally the end
+ *     of the previous inode of the file).
+ *   name   - The name of the file
+ *   entry  - The location to return information about the extent.
+ *
+ * Returned Value:
+ *   Zero is returned on success. Otherwise, a negated errno is returned
+ *   that indicates the nature of the failure.  -ENOENT (or -ENOSPC if the
+ *   end of FLASH was reached) means that there are no further extents.
+ *
+ * Defined in nxffs_inode.c
+ *
+ ****************************************************************************/
+
+extern int nxffs_findextent(FAR struct nxffs_volume_s *volume, off_t offset,
+                            FAR const char *name,
+                            FAR struct nxffs_entry_s *entry);
+
+/****************************************************************************
+ * Name: nxffs_filelen
+ *
+ * Description:
+ *   Return the length of a file:  The sum of the data lengths of the head
+ *   inode and of each of its extents.
+ *
+ * Input Parameters:
+ *   volume  - Describes the NXFFS volume
+ *   entry   - Describes the head inode of the file
+ *   filelen - The location to return the file length
+ *
+ * Returned Value:
+ *   Zero is returned on success. Otherwise, a negated errno is returned
+ *   that indicates the nature of the failure.
+ *
+ * Defined in nxffs_inode.c
+ *
+ ****************************************************************************/
+
+extern int nxffs_filelen(FAR struct nxffs_volume_s *volume,
+                         FAR struct nxffs_entry_s *entry,
+                         FAR uint32_t *filelen);
+
 /****************************************************************************
  * Name: nxffs_inodeend
  *
@@ -798,6 +870,51 @@ extern FAR struct nxffs_ofile_s *nxffs_findofile(FAR struct nxffs_volume_s *volu
 
 extern FAR struct nxffs_wrfile_s *nxffs_findwriter(FAR struct nxffs_volume_s *volume);
 
+/****************************************************************************
+ * Name: nxffs_wrbegin
+ *
+ * Description:
+ *   Make this writer the one that is extending the FLASH region:  Suspend
+ *   any other writer, then allocate FLASH for a new inode header and write
+ *   the inode name.  The new inode will be the head of the file or, if the
+ *   file already has data in FLASH, an extent.
+ *
+ * Input parameters
+ *   volume - Describes the NXFFS volume
+ *   wrfile - Describes the state of the open file
+ *
+ * Returned Value:
+ *   Zero is returned on success; Otherwise, a negated errno value is returned
+ *   indicating the nature of the failure.
+ *
+ * Defined in nxffs_open.c
+ *
+ ****************************************************************************/
+
+extern int nxffs_wrbegin(FAR struct nxffs_volume_s *volume,
+                         FAR struct nxffs_wrfile_s *wrfile);
+
+/****************************************************************************
+ * Name: nxffs_wrsuspend
+ *
+ * Description:
+ *   Suspend the writer that is extending the FLASH region (if any):  Flush
+ *   its final data block and write its inode header.  Writing continues
+ *   later in a new extent.
+ *
+ * Input parameters
+ *   volume - Describes the NXFFS volume
+ *
+ * Returned Value:
+ *   Zero is returned on success; Otherwise, a negated errno value is returned
+ *   indicating the nature of the failure.
+ *
+ * Defined in nxffs_open.c
+ *
+ ****************************************************************************/
+
+extern int nxffs_wrsuspend(FAR struct nxffs_volume_s *volume);
+
 /****************************************************************************
  * Name: nxffs_wrinode
  *
@@ -1016,6 +1133,27 @@ extern int nxffs_rdblkhdr(FAR struct nxffs_volume_s *volume, off_t offset,
 
 extern int nxffs_rminode(FAR struct nxffs_volume_s *volume, FAR const char *name);
 
+/****************************************************************************
+ * Name: nxffs_delinode
+ *
+ * Description:
+ *   Mark the head inode and all of the extents of a file as deleted.
+ *   Unlike nxffs_rminode(), this does not check if the file is open; it is
+ *   used to remove the old version of a file that is being truncated.
+ *
+ * Input Parameters:
+ *   volume - Describes the NXFFS volume.
+ *   name - the name of the file to be deleted.
+ *
+ * Returned Value:
+ *   Zero is returned if the file is successfully deleted.  Otherwise, a
+ *   negated errno value is returned indicating the nature of the failure.
+ *
+ ****************************************************************************/
+
+extern int nxffs_delinode(FAR struct nxffs_volume_s *volume,
+                          FAR const char *name);
+
 /****************************************************************************
  * Name: nxffs_pack
  *
@@ -1034,6 +1172,69 @@ extern int nxffs_rminode(FAR struct nxffs_volume_s *volume, FAR const char *name
 
 extern int nxffs_pack(FAR struct nxffs_volume_s *volume);
 
+/****************************************************************************
+ * Name: nxffs_packstep
+ *
+ * Description:
+ *   Perform one bounded step of packing:  Move the inodes following
+ *   volume->pkoffset until at least CONFIG_NXFFS_PACKSTEP erase blocks
+ *   have been re-written.  When the last inode has been moved, the free
+ *   FLASH region is moved back to the end of the packed inodes.
+ *
+ * Input Parameters:
+ *   volume - The volume to be packed.
+ *
+ * Returned Values:
+ *   Zero on success; Otherwise, a negated errno value is returned to
+ *   indicate the nature of the failure.
+ *
+ ****************************************************************************/
+
+extern int nxffs_packstep(FAR struct nxffs_volume_s *volume);
+
+/****************************************************************************
+ * Name: nxffs_packclean
+ *
+ * Description:
+ *   Packing does not erase the FLASH that it frees at the end of the
+ *   volume.  Instead, those erase blocks are remembered as dirty and each
+ *   is erased (if necessary) by this function when it is first re-used.
+ *   Everything from the provided offset to the end of its erase block is
+ *   free; memory before that offset in the erase block is preserved.
+ *
+ * Input Parameters:
+ *   volume - Describes the NXFFS volume
+ *   offset - The FLASH offset that is about to be used.
+ *
+ * Returned Values:
+ *   Zero on success; Otherwise, a negated errno value is returned to
+ *   indicate the nature of the failure.
+ *
+ ****************************************************************************/
+
+extern int nxffs_packclean(FAR struct nxffs_volume_s *volume, off_t offset);
+
+/****************************************************************************
+ * Name: nxffs_packfreed
+ *
+ * Description:
+ *   The inode at the provided FLASH offset has been deleted (or abandoned)
+ *   and its FLASH can be recovered by packing.  If the inode lies in the
+ *   part of the volume that the current packing pass has already packed,
+ *   then it will be recovered by the next pass.  Restarting the current
+ *   pass would move all of the inodes that it has already moved again.
+ *
+ * Input Parameters:
+ *   volume - Describes the NXFFS volume
+ *   offset - The FLASH offset to the deleted inode header.
+ *
+ * Returned Values:
+ *   None
+ *
+ ****************************************************************************/
+
+extern void nxffs_packfreed(FAR struct nxffs_volume_s *volume, off_t offset);
+
 /****************************************************************************
  * Standard mountpoint operation methods
  *
@@ -215,6 +215,16 @@ int nxffs_getc(FAR struct nxffs_volume_s *volume, uint16_t reserve)
 
   do
     {
+      /* The position may already be at the end of FLASH (for example, if
+       * the last inode ends exactly at the end of FLASH).
+       */
+
+      if (volume->ioblock >= volume->nblocks)
+        {
+          fvdbg("End of FLASH encountered\n");
+          return -ENOSPC;
+        }
+
       /* Check if we have the reserve amount at the end of the current block */
 
       if (volume->iooffset + reserve > volume->geo.blocksize)
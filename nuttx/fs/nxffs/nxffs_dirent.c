@@ -148,10 +148,17 @@ int nxffs_readdir(FAR struct inode *mountpt, FAR struct fs_dirent_s *dir)
       goto errout;
     }
 
-  /* Read the next inode header from the offset */
+  /* Read the next inode header from the offset.  Extents hold appended
+   * data of a file that was already reported; skip over them.
+   */
 
   offset = dir->u.nxffs.nx_offset;
-  ret = nxffs_nextentry(volume, offset, &entry);
+  while ((ret = nxffs_nextentry(volume, offset, &entry)) == OK &&
+         entry.state == INODE_STATE_EXTENT)
+    {
+      offset = nxffs_inodeend(volume, &entry);
+      nxffs_freeentry(&entry);
+    }
 
   /* If the read was successful, then handle the reported inode.  Note
    * that when the last inode has been reported, the value -ENOENT will
@@ -211,6 +211,13 @@ static inline ssize_t nxffs_analyzeinode(FAR struct nxffs_blkinfo_s *blkinfo,
           fdbg(g_format, blkinfo->block, offset, "INODE", "OK     ", datlen);
         }
     }
+  else if (state == INODE_STATE_EXTENT)
+    {
+      if (blkinfo->verbose)
+        {
+          fdbg(g_format, blkinfo->block, offset, "INODE", "EXTENT ", datlen);
+        }
+    }
   else if (state == INODE_STATE_DELETED)
     {
       if (blkinfo->verbose)
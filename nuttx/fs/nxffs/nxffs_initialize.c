@@ -132,6 +132,73 @@ struct nxffs_volume_s g_volume;
  * Private Functions
  ****************************************************************************/
 
+/****************************************************************************
+ * Name: nxffs_lastend
+ *
+ * Description:
+ *   Return the FLASH offset to the first byte after the last inode on
+ *   FLASH.  nxffs_inodeend() only provides an estimate of this offset; that
+ *   is not sufficient here because the data at the end of the last data
+ *   block may itself look like erased FLASH.  So the data blocks of the
+ *   last inode are followed to find the exact end of the inode.
+ *
+ * Input Parameters:
+ *   volume - Identifies the NXFFS volume
+ *   hoffset - The FLASH offset to the last inode header.
+ *
+ * Returned Value:
+ *   The FLASH offset to the end of the inode.  If the inode cannot be
+ *   followed, the nxffs_inodeend() estimate is returned.
+ *
+ ****************************************************************************/
+
+static off_t nxffs_lastend(FAR struct nxffs_volume_s *volume, off_t hoffset)
+{
+  struct nxffs_entry_s entry;
+  struct nxffs_blkentry_s blkentry;
+  off_t blkoffset;
+  off_t offset;
+  off_t datlen;
+  int ret;
+
+  ret = nxffs_nextentry(volume, hoffset, &entry);
+  if (ret < 0)
+    {
+      return hoffset;
+    }
+
+  /* Start with the estimate.  A zero length file has no data blocks. */
+
+  offset = nxffs_inodeend(volume, &entry);
+  if (entry.doffset)
+    {
+      /* Follow each data block until all of the inode data is accounted
+       * for.
+       */
+
+      blkoffset = entry.doffset;
+      for (datlen = 0; datlen < entry.datlen; datlen += blkentry.datlen)
+        {
+          ret = nxffs_nextblock(volume, blkoffset, &blkentry);
+          if (ret < 0)
+            {
+              break;
+            }
+
+          blkoffset = blkentry.hoffset + SIZEOF_NXFFS_DATA_HDR +
+                      blkentry.datlen;
+        }
+
+      if (datlen >= entry.datlen)
+        {
+          offset = blkoffset;
+        }
+    }
+
+  nxffs_freeentry(&entry);
+  return offset;
+}
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -184,7 +251,6 @@ int nxffs_initialize(FAR struct mtd_dev_s *mtd)
   volume->mtd    = mtd;
   volume->cblock = (off_t)-1;
   sem_init(&volume->exclsem, 0, 1);
-  sem_init(&volume->wrsem, 0, 1);
 
   /* Get the volume geometry. (casting to uintptr_t first eliminates
    * complaints on some architectures where the sizeof long is different
@@ -302,6 +368,10 @@ errout_with_volume:
  *   data is written, or (2) recalculated as part of the file system packing
  *   operation.
  *
+ *   The packing state is also reset:  Packing will restart at the beginning
+ *   of FLASH and all erase blocks after the free FLASH offset are checked
+ *   before they are re-used.
+ *
  * Input Parameters:
  *   volume - Identifies the NXFFS volume
  *
@@ -316,6 +386,7 @@ int nxffs_limits(FAR struct nxffs_volume_s *volume)
   FAR struct nxffs_entry_s entry;
   off_t block;
   off_t offset;
+  off_t hoffset;
   bool noinodes = false;
   int nerased;
   int ret;
@@ -330,9 +401,14 @@ int nxffs_limits(FAR struct nxffs_volume_s *volume)
       return ret;
     }
 
-  /* Then find the first valid inode in or beyond the first valid block */
+  /* Nothing is known to be packed yet */
 
   offset = block * volume->geo.blocksize;
+  volume->pkoffset = offset + SIZEOF_NXFFS_BLOCK_HDR;
+  volume->rpoffset = 0;
+
+  /* Then find the first valid inode in or beyond the first valid block */
+
   ret = nxffs_nextentry(volume, offset, &entry);
   if (ret < 0)
     {
@@ -373,13 +449,19 @@ int nxffs_limits(FAR struct nxffs_volume_s *volume)
 
   if (!noinodes)
     {
+      hoffset = volume->inoffset;
       while ((ret = nxffs_nextentry(volume, offset, &entry)) == OK)
         {
           /* Discard the entry and guess the next offset. */
 
-          offset = nxffs_inodeend(volume, &entry);
+          hoffset = entry.hoffset;
+          offset  = nxffs_inodeend(volume, &entry);
           nxffs_freeentry(&entry);    
         }
+
+      /* Get the exact end of the last inode */
+
+      offset = nxffs_lastend(volume, hoffset);
       fvdbg("Last inode before offset %d\n", offset);
     }
 
@@ -398,12 +480,13 @@ int nxffs_limits(FAR struct nxffs_volume_s *volume)
            * is full?
            */
 
-          if (volume->ioblock + 1 >= volume->nblocks &&
-              volume->iooffset + 1 >= volume->geo.blocksize)
+          if (ch == -ENOSPC)
             {
               /* Yes.. the FLASH is full.  Force the offsets to the end of FLASH */
 
               volume->froffset = volume->nblocks * volume->geo.blocksize;
+              volume->dirtyblk = volume->geo.neraseblocks;
+              volume->cleanblk = volume->geo.neraseblocks;
               fvdbg("Assume no free FLASH, froffset: %d\n", volume->froffset);
               if (noinodes)
                 {
@@ -437,6 +520,14 @@ int nxffs_limits(FAR struct nxffs_volume_s *volume)
 
               volume->froffset = offset;
               fvdbg("Free FLASH region begins at offset: %d\n", volume->froffset);
+
+              /* Packing may have left un-erased FLASH after the free FLASH
+               * offset.  Which erase blocks are affected is not recorded
+               * on FLASH, so check each erase block before it is re-used.
+               */
+
+              volume->dirtyblk = offset / volume->geo.erasesize;
+              volume->cleanblk = volume->geo.neraseblocks;
               if (noinodes)
                 {
                   volume->inoffset = offset;
@@ -445,9 +536,14 @@ int nxffs_limits(FAR struct nxffs_volume_s *volume)
               return OK;
             }
         }
+      /* Otherwise, the free FLASH region must begin after this byte.  Use
+       * the actual FLASH position:  Counting bytes would not account for
+       * the block headers that were skipped.
+       */
+
       else
         {
-          offset += nerased + 1;
+          offset  = nxffs_iotell(volume);
           nerased = 0;
         }
     }
@@ -110,7 +110,8 @@ static int nxffs_rdentry(FAR struct nxffs_volume_s *volume, off_t offset,
   /* Check if the file state is recognized. */
 
   state = inode.state;
-  if (state != INODE_STATE_FILE && state != INODE_STATE_DELETED)
+  if (state != INODE_STATE_FILE && state != INODE_STATE_EXTENT &&
+      state != INODE_STATE_DELETED)
     {
       /* This can't be a valid inode.. don't bother with the rest */
 
@@ -125,6 +126,7 @@ static int nxffs_rdentry(FAR struct nxffs_volume_s *volume, off_t offset,
   entry->doffset = nxffs_rdle32(inode.doffs);
   entry->utc     = nxffs_rdle32(inode.utc);
   entry->datlen  = nxffs_rdle32(inode.datlen);
+  entry->state   = state;
 
   /* Modify the packed header and perform the (partial) CRC calculation */
 
@@ -178,7 +180,7 @@ static int nxffs_rdentry(FAR struct nxffs_volume_s *volume, off_t offset,
    * Check the file state.
    */
 
-  if (state != INODE_STATE_FILE)
+  if (state == INODE_STATE_DELETED)
     {
       /* It is a deleted file.  But still, the data offset and the
        * start size are good so we can use this information to advance
@@ -414,9 +416,12 @@ int nxffs_findinode(FAR struct nxffs_volume_s *volume, FAR const char *name,
           return ret;
         }
 
-      /* Is this the NXFFS inode we are looking for? */
+      /* Is this the NXFFS inode we are looking for?  Extents are never
+       * returned; they have the same name as the head of the file.
+       */
 
-      else if (strcmp(name, entry->name) == 0)
+      else if (entry->state == INODE_STATE_FILE &&
+               strcmp(name, entry->name) == 0)
         {
           /* Yes, return success with the entry data in 'entry' */
 
@@ -441,6 +446,119 @@ int nxffs_findinode(FAR struct nxffs_volume_s *volume, FAR const char *name,
   return -ENOENT;
 }
 
+/****************************************************************************
+ * Name: nxffs_findextent
+ *
+ * Description:
+ *   Search for the next extent inode with the provided name starting at
+ *   the provided FLASH offset and proceeding to the end FLASH or until the
+ *   matching inode is found.
+ *
+ * Input Parameters:
+ *   volume - Describes the NXFFS volume
+ *   offset - The FLASH memory offset to begin searching (normally the end
+ *     of the previous inode of the file).
+ *   name   - The name of the file
+ *   entry  - The location to return information about the extent.
+ *
+ * Returned Value:
+ *   Zero is returned on success. Otherwise, a negated errno is returned
+ *   that indicates the nature of the failure.  -ENOENT (or -ENOSPC if the
+ *   end of FLASH was reached) means that there are no further extents.
+ *
+ ****************************************************************************/
+
+int nxffs_findextent(FAR struct nxffs_volume_s *volume, off_t offset,
+                     FAR const char *name, FAR struct nxffs_entry_s *entry)
+{
+  int ret;
+
+  /* Loop, checking each NXFFS inode until either: (1) we find the next
+   * extent with the matching name, or (2) we reach the end of data written
+   * on the media.
+   */
+
+  for (;;)
+   {
+      /* Get the next, valid NXFFS inode entry */
+
+      ret = nxffs_nextentry(volume, offset, entry);
+      if (ret < 0)
+        {
+          return ret;
+        }
+
+      /* Is this an extent of the file? */
+
+      else if (entry->state == INODE_STATE_EXTENT &&
+               strcmp(name, entry->name) == 0)
+        {
+          return OK;
+        }
+
+      /* Discard this entry and try the next one. */
+
+      offset = nxffs_inodeend(volume, entry);
+      nxffs_freeentry(entry);
+    }
+
+  /* We won't get here, but for some compilers: */
+
+  return -ENOENT;
+}
+
+/****************************************************************************
+ * Name: nxffs_filelen
+ *
+ * Description:
+ *   Return the length of a file:  The sum of the data lengths of the head
+ *   inode and of each of its extents.
+ *
+ * Input Parameters:
+ *   volume  - Describes the NXFFS volume
+ *   entry   - Describes the head inode of the file
+ *   filelen - The location to return the file length
+ *
+ * Returned Value:
+ *   Zero is returned on success. Otherwise, a negated errno is returned
+ *   that indicates the nature of the failure.
+ *
+ ****************************************************************************/
+
+int nxffs_filelen(FAR struct nxffs_volume_s *volume,
+                  FAR struct nxffs_entry_s *entry, FAR uint32_t *filelen)
+{
+  struct nxffs_entry_s extent;
+  uint32_t datlen;
+  off_t offset;
+  int ret;
+
+  /* Start with the data in the head inode, then add the data in each
+   * extent that follows it.
+   */
+
+  datlen = entry->datlen;
+  offset = nxffs_inodeend(volume, entry);
+
+  while ((ret = nxffs_findextent(volume, offset, entry->name, &extent)) == OK)
+    {
+      datlen += extent.datlen;
+      offset  = nxffs_inodeend(volume, &extent);
+      nxffs_freeentry(&extent);
+    }
+
+  /* -ENOENT and -ENOSPC just mean that there are no further extents */
+
+  if (ret != -ENOENT && ret != -ENOSPC)
+    {
+      fdbg("Failed to find extent: %d\n", -ret);
+      return ret;
+    }
+
+  *filelen = datlen;
+  return OK;
+}
+
 /****************************************************************************
  * Name: nxffs_inodeend
  *
@@ -126,15 +126,28 @@ int nxffs_ioctl(FAR struct file *filep, int cmd, unsigned long arg)
       /* Re-format the volume -- all is lost */
 
       ret = nxffs_reformat(volume);
+      if (ret == OK)
+        {
+          /* Re-establish the FLASH limits of the empty volume */
+
+          volume->cblock = (off_t)-1;
+          ret = nxffs_limits(volume);
+        }
     }
 
   else if (cmd == FIOC_OPTIMIZE)
     {
       fvdbg("Optimize command\n");
 
-      /* Pack the volume */
+      /* Finish the inode of any file being written, then pack the volume.
+       * The writer will continue in a new extent.
+       */
 
-      ret = nxffs_pack(volume);
+      ret = nxffs_wrsuspend(volume);
+      if (ret == OK)
+        {
+          ret = nxffs_pack(volume);
+        }
     }
   else
     {
@@ -67,14 +67,6 @@
  * Private Data
  ****************************************************************************/
 
-/* Since we are limited to a single file opened for writing, it makes sense
- * to pre-allocate the write state structure.
- */
-
-#ifdef CONFIG_NXFSS_PREALLOCATED
-static struct nxffs_wrfile_s g_wrfile;
-#endif
-
 /****************************************************************************
  * Public Data
  ****************************************************************************/
@@ -376,8 +368,10 @@ static inline int nxffs_wrname(FAR struct nxffs_volume_s *volume,
  * Name: nxffs_wropen
  *
  * Description:
- *   Handle opening for writing.  Only a single writer is permitted and only
- *   file creation is supported.
+ *   Handle opening for writing.  Any number of files may be open for
+ *   writing, but only one writer may have a given file open.  Existing
+ *   files may be truncated (O_TRUNC) or extended (O_APPEND).  No FLASH is
+ *   set aside for the file until the first write (or until it is closed).
  *
  ****************************************************************************/
 
@@ -387,17 +381,17 @@ static inline int nxffs_wropen(FAR struct nxffs_volume_s *volume,
 {
   FAR struct nxffs_wrfile_s *wrfile;
   FAR struct nxffs_entry_s entry;
-  bool packed;
   bool truncate = false;
+  bool extend = false;
+  uint32_t filelen = 0;
   int namlen;
   int ret;
 
-  /* Limitation: Only a single writer is permitted.  Writing may involve
-   * extension of the file system in FLASH.  Since files are contiguous
-   * in FLASH, only a single file may be extending the FLASH region.
+  /* Get exclusive access to the volume.  Note that the volume exclsem
+   * protects the open file list.
    */
 
-  ret = sem_wait(&volume->wrsem);
+  ret = sem_wait(&volume->exclsem);
   if (ret != OK)
     {
       fdbg("sem_wait failed: %d\n", ret);
@@ -405,17 +399,16 @@ static inline int nxffs_wropen(FAR struct nxffs_volume_s *volume,
       goto errout;
     }
 
-  /* Get exclusive access to the volume.  Note that the volume exclsem
-   * protects the open file list.  Note that exclsem is ALWAYS taken
-   * after wrsem to avoid deadlocks.
+  /* Is the file already open (whether or not it exists on FLASH yet)?
+   * Limitation:  Files cannot be open both for reading and writing and
+   * a file can be opened by only one writer at a time.
    */
 
-  ret = sem_wait(&volume->exclsem);
-  if (ret != OK)
+  if (nxffs_findofile(volume, name))
     {
-      fdbg("sem_wait failed: %d\n", ret);
-      ret = -errno;
-      goto errout_with_wrsem;
+      fdbg("File is already open\n");
+      ret = -ENOSYS;
+      goto errout_with_exclsem;
     }
 
   /* Check if the file exists */
@@ -423,36 +416,19 @@ static inline int nxffs_wropen(FAR struct nxffs_volume_s *volume,
   ret = nxffs_findinode(volume, name, &entry);
   if (ret == OK)
     {
-      FAR struct nxffs_ofile_s *ofile;
-
-      /* It exists.  Is the file already open for reading? */
-
-      ofile = nxffs_findofile(volume, name);
-      if (ofile)
-        {
-          /* The file is already open.
-           * Limitation:  Files cannot be open both for reading and writing.
-           */
-
-          fdbg("File is open for reading\n");
-          ret = -ENOSYS;
-          goto errout_with_exclsem;
-        }
-
       /* It would be an error if we are asked to create the file
        * exclusively.
        */
 
-      else if ((oflags & (O_CREAT|O_EXCL)) == (O_CREAT|O_EXCL))
+      if ((oflags & (O_CREAT|O_EXCL)) == (O_CREAT|O_EXCL))
         {
           fdbg("File exists, can't create O_EXCL\n");
           ret = -EEXIST;
-          goto errout_with_exclsem;
         }
 
       /* Were we asked to truncate the file?  NOTE: Don't truncate the
-       * file if we were not also asked to created it.  See below...
-       * we will not re-create the file unless O_CREAT is also specified.
+       * file if we were not also asked to created it.  We will not
+       * re-create the file unless O_CREAT is also specified.
        */
 
       else if ((oflags & (O_CREAT|O_TRUNC)) == (O_CREAT|O_TRUNC))
@@ -462,26 +438,39 @@ static inline int nxffs_wropen(FAR struct nxffs_volume_s *volume,
            * until the new file is successfully written.
            */
 
-          truncate = true;          
+          truncate = true;
+        }
+
+      /* Were we asked to append to the file?  Then new data will be written
+       * to extents that follow the existing inodes of the file.
+       */
+
+      else if ((oflags & O_APPEND) != 0)
+        {
+          extend = true;
+          ret    = nxffs_filelen(volume, &entry, &filelen);
         }
 
-      /* The file exists and we were not asked to truncate (and recreate) it.
-       * Limitation: Cannot write to existing files.
+      /* The file exists and we were not asked to truncate (and recreate) it
+       * or to append to it.  Limitation: Cannot overwrite existing files.
        */
 
       else
         {
-          fdbg("File %s exists and we were not asked to truncate it\n");
+          fdbg("File %s exists and we were not asked to truncate it\n", name);
           ret = -ENOSYS;
+        }
+
+      nxffs_freeentry(&entry);
+      if (ret < 0)
+        {
           goto errout_with_exclsem;
         }
     }
 
-  /* Okay, the file is not open and does not exists (maybe because we deleted
-   * it).  Now, make sure that we were asked to created it.
-   */
+  /* The file does not exist.  Make sure that we were asked to created it. */
 
-  if ((oflags & O_CREAT) == 0)
+  else if ((oflags & O_CREAT) == 0)
     {
       fdbg("Not asked to create the file\n");
       ret = -ENOENT;
@@ -503,17 +492,12 @@ static inline int nxffs_wropen(FAR struct nxffs_volume_s *volume,
    * that includes additional information to support the write operation.
    */
 
-#ifdef CONFIG_NXFSS_PREALLOCATED
-  wrfile = &g_wrfile;
-  memset(wrfile, 0, sizeof(struct nxffs_wrfile_s));
-#else
   wrfile = (FAR struct nxffs_wrfile_s *)kzalloc(sizeof(struct nxffs_wrfile_s));
   if (!wrfile)
     {
       ret = -ENOMEM;
       goto errout_with_exclsem;
     }
-#endif
 
   /* Initialize the open file state structure */
 
@@ -521,6 +505,8 @@ static inline int nxffs_wropen(FAR struct nxffs_volume_s *volume,
   wrfile->ofile.oflags    = oflags;
   wrfile->ofile.entry.utc = time(NULL);
   wrfile->truncate        = truncate;
+  wrfile->extend          = extend;
+  wrfile->filelen         = filelen;
 
   /* Save a copy of the inode name. */
 
@@ -531,156 +517,26 @@ static inline int nxffs_wropen(FAR struct nxffs_volume_s *volume,
       goto errout_with_ofile;
     }
 
-  /* Allocate FLASH memory for the file and set up for the write.
-   *
-   * Loop until the inode header is configured or until a failure occurs.
-   * Note that nothing is written to FLASH.  The inode header is not
-   * written until the file is closed.
+  /* Add the open file structure to the head of the list of open files.
+   * Nothing is written to FLASH yet:  FLASH is set aside for the new
+   * inode by nxffs_wrbegin() when the file is first written (or closed).
    */
 
-  packed = false;
-  for (;;)
-    {
-      /* File a valid location to position the inode header.  Start with the
-       * first byte in the free FLASH region.
-       */
-
-      ret = nxffs_hdrpos(volume, wrfile);
-      if (ret == OK)
-        {
-          /* Find a region of memory in the block that is fully erased */
-
-          ret = nxffs_hdrerased(volume, wrfile);
-          if (ret == OK)
-            {
-              /* Valid memory for the inode header was found.  Break out of
-               * the loop.
-               */
-
-              break;
-            }
-        }
-
-      /* If no valid memory is found searching to the end of the volume,
-       * then -ENOSPC will be returned.  Other errors are not handled.
-       */
-
-      if (ret != -ENOSPC || packed)
-        {
-          fdbg("Failed to find inode header memory: %d\n", -ret);
-          goto errout_with_name;
-        }
-
-      /* -ENOSPC is a special case..  It means that the volume is full.
-       * Try to pack the volume in order to free up some space.
-       */
-
-      ret = nxffs_pack(volume);
-      if (ret < 0)
-        {
-          fdbg("Failed to pack the volume: %d\n", -ret);
-          goto errout_with_name;
-        }
-              
-      /* After packing the volume, froffset will be updated to point to the
-       * new free flash region.  Try again.
-       */
-               
-      packed = true;
-    }
-
-  /* Loop until the inode name is configured or until a failure occurs.
-   * Note that nothing is written to FLASH. 
-   */
-
-  for (;;)
-    {
-      /* File a valid location to position the inode name.  Start with the
-       * first byte in the free FLASH region.
-       */
-
-      ret = nxffs_nampos(volume, wrfile, namlen);
-      if (ret == OK)
-        {
-          /* Find a region of memory in the block that is fully erased */
-
-          ret = nxffs_namerased(volume, wrfile, namlen);
-          if (ret == OK)
-            {
-              /* Valid memory for the inode header was found.  Write the
-               * inode name to this location.
-               */
-
-              ret = nxffs_wrname(volume, &wrfile->ofile.entry, namlen);
-              if (ret < 0)
-                {
-                  fdbg("Failed to write the inode name: %d\n", -ret);
-                  goto errout_with_name;
-                }
-
-              /* Then just break out of the loop reporting success.  Note
-               * that the alllocated inode name string is retained; it
-               * will be needed later to calculate the inode CRC.
-               */
-
-              break;
-            }
-        }
-
-      /* If no valid memory is found searching to the end of the volume,
-       * then -ENOSPC will be returned.  Other errors are not handled.
-       */
-
-      if (ret != -ENOSPC || packed)
-        {
-          fdbg("Failed to find inode name memory: %d\n", -ret);
-          goto errout_with_name;
-        }
-
-      /* -ENOSPC is a special case..  It means that the volume is full.
-       * Try to pack the volume in order to free up some space.
-       */
-
-      ret = nxffs_pack(volume);
-      if (ret < 0)
-        {
-          fdbg("Failed to pack the volume: %d\n", -ret);
-          goto errout_with_name;
-        }
-              
-      /* After packing the volume, froffset will be updated to point to the
-       * new free flash region.  Try again.
-       */
-               
-      packed = true;
-    }
-
-  /* Add the open file structure to the head of the list of open files */
-
   wrfile->ofile.flink = volume->ofiles;
   volume->ofiles      = &wrfile->ofile;
 
-  /* Indicate that the volume is open for writing and return the open file
-   * instance.  Releasing exclsem allows other readers while the write is
-   * in progress.  But wrsem is still held for this open file, preventing
-   * any further writers until this inode is closed.s
+  /* Return the open file instance.  Other readers and writers may proceed
+   * while this file is open for writing.
    */
 
   *ppofile = &wrfile->ofile;
   sem_post(&volume->exclsem);
   return OK;
 
-errout_with_name:
-  kfree(wrfile->ofile.entry.name);
 errout_with_ofile:
-#ifndef CONFIG_NXFSS_PREALLOCATED
   kfree(wrfile);
-#endif
-
 errout_with_exclsem:
   sem_post(&volume->exclsem);
-errout_with_wrsem:
-  sem_post(&volume->wrsem);
 errout:
   return ret;
 }
@@ -765,6 +621,18 @@ static inline int nxffs_rdopen(FAR struct nxffs_volume_s *volume,
           goto errout_with_ofile;
         }
 
+      /* The file data may continue in extents.  For the open file, datlen
+       * will hold the length of the whole file.
+       */
+
+      ret = nxffs_filelen(volume, &ofile->entry, &ofile->entry.datlen);
+      if (ret != OK)
+        {
+          fdbg("Failed to get the length of '%s': %d\n", name, -ret);
+          nxffs_freeentry(&ofile->entry);
+          goto errout_with_ofile;
+        }
+
       /* Add the open file structure to the head of the list of open files */
 
       ofile->flink   = volume->ofiles;
@@ -841,27 +709,18 @@ static inline void nxffs_freeofile(FAR struct nxffs_volume_s *volume,
 
   nxffs_freeentry(&ofile->entry);
  
-  /* Then free the open file container (unless this the pre-alloated
-   * write-only open file container)
-   */
+  /* Then free the open file container */
 
-#ifdef CONFIG_NXFSS_PREALLOCATED
-  if ((FAR struct nxffs_wrfile_s*)ofile != &g_wrfile)
-#endif
-    {
-      kfree(ofile);
-    }
+  kfree(ofile);
 }
 
 /****************************************************************************
  * Name: nxffs_wrclose
  *
  * Description:
- *   Perform special operations when a file is closed:
- *   1. Write the file block header
- *   2. Remove any file with the same name that was discovered when the
- *      file was open for writing, and finally,
- *   3. Write the new file inode.
+ *   Perform special operations when a file is closed:  Make sure that
+ *   the file has an inode on FLASH (even if nothing was written to it),
+ *   then finalize the last inode of the file with nxffs_wrsuspend().
  *
  * Input parameters
  *   volume - Describes the NXFFS volume
@@ -874,48 +733,28 @@ static inline int nxffs_wrclose(FAR struct nxffs_volume_s *volume,
 {
   int ret;
 
-  /* Is there an unfinalized write data? */
+  /* Has anything been written to FLASH for this file?  If not and if the
+   * file does not exist yet, then we still need to create an empty inode.
+   */
 
-  if (wrfile->datlen > 0)
+  if (volume->wrfile != wrfile && !wrfile->extend)
     {
-      /* Yes.. Write the final file block header */
-
-      ret = nxffs_wrblkhdr(volume, wrfile);
+      ret = nxffs_wrbegin(volume, wrfile);
       if (ret < 0)
         {
-          fdbg("Failed to write the final block of the file: %d\n", -ret);
-          goto errout;
+          fdbg("Failed to allocate the inode: %d\n", -ret);
+          return ret;
         }
     }
 
-  /* Truncation is implemented by writing the new file, then deleting the
-   * older version of the file.  Note that we removed the entry from the
-   * open file list earlier in the close sequence; this will prevent the
-   * open file check from failing when we remove the old version of the
-   * file.
-   */
+  /* Write the final data block and the inode header to FLASH */
 
-  if (wrfile->truncate && wrfile->ofile.entry.name)
+  if (volume->wrfile == wrfile)
     {
-      fvdbg("Removing old file: %s\n", wrfile->ofile.entry.name);
-
-      ret = nxffs_rminode(volume, wrfile->ofile.entry.name);
-      if (ret < 0)
-        {
-          fdbg("nxffs_rminode failed: %d\n", -ret);
-          goto errout;
-        }
+      return nxffs_wrsuspend(volume);
     }
 
-  /* Write the inode header to FLASH */
-
-  ret = nxffs_wrinode(volume, &wrfile->ofile.entry);
-
-  /* The volume is now available for other writers */
-
-errout:
-  sem_post(&volume->wrsem);
-  return ret;
+  return OK;
 }
 
 /****************************************************************************
@@ -965,8 +804,8 @@ FAR struct nxffs_ofile_s *nxffs_findofile(FAR struct nxffs_volume_s *volume,
  * Name: nxffs_findwriter
  *
  * Description:
- *   Search the list of already opened files and return the open file
- *   instance for the write.
+ *   Return the open file instance of the writer that is currently
+ *   extending the FLASH region.
  *
  * Input Parameters:
  *   volume - Describes the NXFFS volume.
@@ -979,15 +818,266 @@ FAR struct nxffs_ofile_s *nxffs_findofile(FAR struct nxffs_volume_s *volume,
 
 FAR struct nxffs_wrfile_s *nxffs_findwriter(FAR struct nxffs_volume_s *volume)
 {
-  /* We can tell if the write is in-use because it will have an allocated
-   * name attached.
+  /* Only the writer that is currently extending the FLASH region is of
+   * interest.  Suspended writers have nothing in FLASH but complete inodes.
    */
 
-#ifdef CONFIG_NXFSS_PREALLOCATED
-  return g_wrfile.ofile.entry.name != NULL ? &g_wrfile : NULL;
-#else
-#  error "Missing implementation"
-#endif
+  return volume->wrfile;
+}
+
+/****************************************************************************
+ * Name: nxffs_wrbegin
+ *
+ * Description:
+ *   Make this writer the one that is extending the FLASH region:  Suspend
+ *   any other writer, then allocate FLASH for a new inode header and write
+ *   the inode name.  The new inode will be the head of the file or, if the
+ *   file already has data in FLASH, an extent.
+ *
+ * Input parameters
+ *   volume - Describes the NXFFS volume
+ *   wrfile - Describes the state of the open file
+ *
+ * Returned Value:
+ *   Zero is returned on success; Otherwise, a negated errno value is returned
+ *   indicating the nature of the failure.
+ *
+ ****************************************************************************/
+
+int nxffs_wrbegin(FAR struct nxffs_volume_s *volume,
+                  FAR struct nxffs_wrfile_s *wrfile)
+{
+  bool packed;
+  int namlen;
+  int ret;
+
+  /* Is this writer already extending the FLASH region? */
+
+  if (volume->wrfile == wrfile)
+    {
+      return OK;
+    }
+
+  /* No.. Since allocations always proceed toward the end of FLASH, only a
+   * single file may be extending the FLASH region.  Finish the inode of
+   * the current writer (if any); it will continue later in a new extent.
+   */
+
+  ret = nxffs_wrsuspend(volume);
+  if (ret < 0)
+    {
+      fdbg("Failed to suspend the current writer: %d\n", -ret);
+      return ret;
+    }
+
+  /* The new inode is the head of the file unless the file already has
+   * inodes on FLASH.
+   */
+
+  namlen = strlen(wrfile->ofile.entry.name);
+  wrfile->ofile.entry.state = wrfile->extend ? INODE_STATE_EXTENT : INODE_STATE_FILE;
+
+  /* Allocate FLASH memory for the inode and set up for the write.
+   *
+   * Loop until the inode header and name are configured or until a failure
+   * occurs.  Note that only the name is written to FLASH.  The inode header
+   * is not written until the inode is finished.
+   */
+
+  packed = false;
+  for (;;)
+    {
+      /* File a valid location to position the inode header and name.  Start
+       * with the first byte in the free FLASH region.
+       */
+
+      ret = nxffs_hdrpos(volume, wrfile);
+      if (ret == OK)
+        {
+          /* Find a region of memory in the block that is fully erased */
+
+          ret = nxffs_hdrerased(volume, wrfile);
+          if (ret == OK)
+            {
+              /* Now do the same for the inode name */
+
+              ret = nxffs_nampos(volume, wrfile, namlen);
+              if (ret == OK)
+                {
+                  ret = nxffs_namerased(volume, wrfile, namlen);
+                  if (ret == OK)
+                    {
+                      /* Valid memory for the inode header and name was
+                       * found.  Break out of the loop.
+                       */
+
+                      break;
+                    }
+                }
+            }
+        }
+
+      /* If no valid memory is found searching to the end of the volume,
+       * then -ENOSPC will be returned.  Other errors are not handled.
+       */
+
+      if (ret != -ENOSPC || packed)
+        {
+          fdbg("Failed to find inode memory: %d\n", -ret);
+          goto errout;
+        }
+
+      /* -ENOSPC is a special case..  It means that the volume is full.
+       * Abandon any partial reservation and try to pack the volume in
+       * order to free up some space.
+       */
+
+      wrfile->ofile.entry.hoffset = 0;
+      wrfile->ofile.entry.noffset = 0;
+
+      ret = nxffs_pack(volume);
+      if (ret < 0)
+        {
+          fdbg("Failed to pack the volume: %d\n", -ret);
+          goto errout;
+        }
+
+      /* After packing the volume, froffset will be updated to point to the
+       * new free flash region.  Try again.
+       */
+
+      packed = true;
+    }
+
+  /* Write the inode name to the location that was found.  Note that the
+   * alllocated inode name string is retained; it will be needed later to
+   * calculate the inode CRC.
+   */
+
+  ret = nxffs_wrname(volume, &wrfile->ofile.entry, namlen);
+  if (ret < 0)
+    {
+      fdbg("Failed to write the inode name: %d\n", -ret);
+      goto errout;
+    }
+
+  /* This writer now owns the end of the FLASH region */
+
+  volume->wrfile = wrfile;
+  return OK;
+
+errout:
+  wrfile->ofile.entry.hoffset = 0;
+  wrfile->ofile.entry.noffset = 0;
+  return ret;
+}
+
+/****************************************************************************
+ * Name: nxffs_wrsuspend
+ *
+ * Description:
+ *   Suspend the writer that is extending the FLASH region (if any):  Flush
+ *   its final data block and write its inode header.  Writing continues
+ *   later in a new extent.
+ *
+ *   If a file with the same name is being replaced (O_TRUNC), the old file
+ *   is removed just before the first inode of the new file is written.
+ *
+ * Input parameters
+ *   volume - Describes the NXFFS volume
+ *
+ * Returned Value:
+ *   Zero is returned on success; Otherwise, a negated errno value is returned
+ *   indicating the nature of the failure.
+ *
+ ****************************************************************************/
+
+int nxffs_wrsuspend(FAR struct nxffs_volume_s *volume)
+{
+  FAR struct nxffs_wrfile_s *wrfile = volume->wrfile;
+  int ret = OK;
+
+  /* Is there a writer extending the FLASH region? */
+
+  if (!wrfile)
+    {
+      return OK;
+    }
+
+  /* Is there an unfinalized write data? */
+
+  if (wrfile->datlen > 0)
+    {
+      /* Yes.. Write the final file block header */
+
+      ret = nxffs_wrblkhdr(volume, wrfile);
+      if (ret < 0)
+        {
+          fdbg("Failed to write the final block of the file: %d\n", -ret);
+          goto errout;
+        }
+    }
+
+  /* Write the inode if it holds any data.  The first inode of a file is
+   * always written, even if it is empty, so that the file is created.
+   */
+
+  if (wrfile->ofile.entry.datlen > 0 || !wrfile->extend)
+    {
+      /* Truncation is implemented by writing the new file, then deleting
+       * the older version of the file.  The open file check will not fail
+       * because nxffs_delinode() does not check for open files.
+       */
+
+      if (wrfile->truncate)
+        {
+          fvdbg("Removing old file: %s\n", wrfile->ofile.entry.name);
+
+          ret = nxffs_delinode(volume, wrfile->ofile.entry.name);
+          if (ret < 0)
+            {
+              fdbg("nxffs_delinode failed: %d\n", -ret);
+              goto errout;
+            }
+
+          wrfile->truncate = false;
+        }
+
+      /* Write the inode header to FLASH */
+
+      ret = nxffs_wrinode(volume, &wrfile->ofile.entry);
+      if (ret < 0)
+        {
+          fdbg("Failed to write the inode header: %d\n", -ret);
+          goto errout;
+        }
+
+      /* Any further data will be written to extents of this file */
+
+      wrfile->filelen += wrfile->ofile.entry.datlen;
+      wrfile->extend   = true;
+    }
+  else
+    {
+      /* Nothing was written to this extent.  Just abandon the FLASH that
+       * was reserved for it; packing will recover it.
+       */
+
+      nxffs_packfreed(volume, wrfile->ofile.entry.hoffset);
+    }
+
+  /* Reset the write state.  The volume is now available for other writers */
+
+errout:
+  wrfile->ofile.entry.hoffset = 0;
+  wrfile->ofile.entry.noffset = 0;
+  wrfile->ofile.entry.doffset = 0;
+  wrfile->ofile.entry.datlen  = 0;
+  wrfile->doffset             = 0;
+  wrfile->datlen              = 0;
+  wrfile->crc                 = 0;
+  volume->wrfile              = NULL;
+  return ret;
 }
 
 /****************************************************************************
@@ -1023,10 +1113,8 @@ int nxffs_open(FAR struct file *filep, FAR const char *relpath,
 #endif
 
   /* Limitation:  A file must be opened for reading or writing, but not both.
-   * There is no general for extending the size of of a file.  Extending the
-   * file size of possible if the file to be extended is the last in the
-   * sequence on FLASH, but since that case is not the general case, no file
-   * extension is supported.
+   * A file may be extended only by opening it with O_APPEND; the appended
+   * data is then written to new extent inodes at the end of FLASH.
    */
 
    switch (oflags & (O_WROK|O_RDOK))
@@ -1054,6 +1142,13 @@ int nxffs_open(FAR struct file *filep, FAR const char *relpath,
   if (ret == OK)
     {
       filep->f_priv = ofile;
+
+      /* Writing always proceeds at the end of the file */
+
+      if ((oflags & O_WROK) != 0)
+        {
+          filep->f_pos = ((FAR struct nxffs_wrfile_s *)ofile)->filelen;
+        }
     }
   return ret;
 }
@@ -1206,7 +1301,7 @@ int nxffs_wrinode(FAR struct nxffs_volume_s *volume,
 
   /* Finish the inode header */
 
-  inode->state = INODE_STATE_FILE;
+  inode->state = entry->state;
   nxffs_wrle32(inode->crc, crc);
 
   /* Write the block with the inode header */
@@ -1216,12 +1311,17 @@ int nxffs_wrinode(FAR struct nxffs_volume_s *volume,
     {
       fdbg("Failed to write inode header block %d: %d\n",
            volume->ioblock, -ret);
+      goto errout;
     }
 
-  /* The volume is now available for other writers */
+  /* Packing may place inodes before the previous first inode */
+
+  if (entry->hoffset < volume->inoffset)
+    {
+      volume->inoffset = entry->hoffset;
+    }
 
 errout:
-  sem_post(&volume->wrsem);
   return ret;
 }
 
@@ -1247,10 +1347,14 @@ int nxffs_updateinode(FAR struct nxffs_volume_s *volume,
 {
   FAR struct nxffs_ofile_s *ofile;
 
-  /* Find the open inode structure matching this name */
+  /* Find the open inode structure matching this name.  Only readers are
+   * of interest: They refer to the head inode of the file.  The open file
+   * structure of a writer describes only the inode currently being written.
+   */
 
   ofile = nxffs_findofile(volume, entry->name);
-  if (ofile)
+  if (ofile && (ofile->oflags & O_WROK) == 0 &&
+      entry->state == INODE_STATE_FILE)
     {
       /* Yes.. the file is open.  Update the FLASH offsets to inode headers */
 
@@ -86,6 +86,12 @@ struct nxffs_pack_s
   off_t                ioblock;    /* I/O block number */
   off_t                block0;     /* First I/O block number in the erase block */
   uint16_t             iooffset;   /* I/O block offset */
+
+  /* Don't start moving an inode that would extend past this FLASH offset
+   * (zero means no limit).  This bounds the work done by one packing step.
+   */
+
+  off_t                stopoffset;
 };
 
 /****************************************************************************
@@ -159,25 +165,52 @@ static off_t nxffs_packtell(FAR struct nxffs_volume_s *volume,
   return pack->ioblock * volume->geo.blocksize + pack->iooffset;
 }
 
+/****************************************************************************
+ * Name: nxffs_packsize
+ *
+ * Description:
+ *   Estimate the amount of FLASH that an inode will occupy after it has
+ *   been packed.
+ *
+ * Input Parameters:
+ *   volume - Describes the NXFFS volume
+ *   entry  - Describes the inode
+ *
+ * Returned Value:
+ *   The estimated size of the inode in FLASH (a slight over-estimate).
+ *
+ ****************************************************************************/
+
+static off_t nxffs_packsize(FAR struct nxffs_volume_s *volume,
+                            FAR struct nxffs_entry_s *entry)
+{
+  uint16_t maxsize = volume->geo.blocksize - SIZEOF_NXFFS_BLOCK_HDR -
+                     SIZEOF_NXFFS_DATA_HDR;
+  off_t    nblocks = entry->datlen / maxsize + 1;
+
+  return SIZEOF_NXFFS_INODE_HDR + strlen(entry->name) + entry->datlen +
+         nblocks * (SIZEOF_NXFFS_DATA_HDR + SIZEOF_NXFFS_BLOCK_HDR);
+}
+
 /****************************************************************************
  * Name: nxffs_packvalid
  *
  * Description:
- *   Check if the current destination block is valid.
+ *   Check if an I/O block in the pack buffer is valid.
  *
  * Input Parameters:
- *   pack   - The volume packing state structure.
+ *   iobuffer - The I/O block in the pack buffer.
  *
  * Returned Values:
  *   None
  *
  ****************************************************************************/
 
-static inline bool nxffs_packvalid(FAR struct nxffs_pack_s *pack)
+static inline bool nxffs_packvalid(FAR uint8_t *iobuffer)
 {
   FAR struct nxffs_block_s *blkhdr;
 
-  blkhdr = (FAR struct nxffs_block_s *)pack->iobuffer;
+  blkhdr = (FAR struct nxffs_block_s *)iobuffer;
   return (memcmp(blkhdr->magic, g_blockmagic, NXFFS_MAGICSIZE) == 0 &&
           blkhdr->state == BLOCK_STATE_GOOD);
 }
@@ -306,6 +339,7 @@ static inline int nxffs_startpos(FAR struct nxffs_volume_s *volume,
           pack->dest.entry.name    = pack->src.entry.name;
           pack->dest.entry.utc     = pack->src.entry.utc;
           pack->dest.entry.datlen  = pack->src.entry.datlen;
+          pack->dest.entry.state   = pack->src.entry.state;
 
           /* The destination entry now "owns" the name string */
 
@@ -317,17 +351,23 @@ static inline int nxffs_startpos(FAR struct nxffs_volume_s *volume,
           return OK;
         }
 
-      /* Free the allocated memory in the entry */
-
-      nxffs_freeentry(&pack->src.entry);
-
       /* Update the offset to the first byte at the end of the last data
-       * block.
+       * block.  Zero length files have no data blocks; the inode ends
+       * with its name.
        */
 
       nbytes = 0;
       offset = pack->src.entry.doffset;
 
+      if (offset == 0)
+        {
+          offset = nxffs_inodeend(volume, &pack->src.entry);
+        }
+
+      /* Free the allocated memory in the entry */
+
+      nxffs_freeentry(&pack->src.entry);
+
       while (nbytes < pack->src.entry.datlen)
         {
           /* Read the next data block header */
@@ -699,17 +739,29 @@ static int nxffs_wrinodehdr(FAR struct nxffs_volume_s *volume,
 
       /* Finish the inode header */
 
-      inode->state = INODE_STATE_FILE;
+      inode->state = pack->dest.entry.state;
       nxffs_wrle32(inode->crc, crc);
 
-      /* If any open files reference this inode, then update the open file
-       * state.
-       */
+      /* Packing may place inodes before the previous first inode */
+
+      if (pack->dest.entry.hoffset < volume->inoffset)
+        {
+          volume->inoffset = pack->dest.entry.hoffset;
+        }
+
+      ret = OK;
+    }
 
+  /* If any open files reference this inode, then update the open file
+   * state.
+   */
+
+  if (ret == OK)
+    {
       ret = nxffs_updateinode(volume, &pack->dest.entry);
       if (ret < 0)
         {
-          fdbg("Failed to update inode info: %s\n", -ret);
+          fdbg("Failed to update inode info: %d\n", -ret);
         }
     }
 
@@ -947,6 +999,19 @@ static inline int nxffs_packblock(FAR struct nxffs_volume_s *volume,
 
       if (pack->src.fpos >= pack->src.entry.datlen)
         {
+          /* Get the offset to the end of the source inode.  Zero length
+           * files have no data blocks; the inode ends with its name.
+           */
+
+          if (pack->src.blkoffset > 0)
+            {
+              offset = pack->src.blkoffset + pack->src.blklen;
+            }
+          else
+            {
+              offset = pack->src.entry.noffset + strlen(pack->dest.entry.name);
+            }
+
           /* Write the final destination data block header and inode
            * headers.
            */
@@ -956,7 +1021,6 @@ static inline int nxffs_packblock(FAR struct nxffs_volume_s *volume,
 
           /* Find the next valid source inode */
 
-          offset = pack->src.blkoffset + pack->src.blklen;
           memset(&pack->src, 0, sizeof(struct nxffs_packstream_s));
 
           ret = nxffs_nextentry(volume, offset, &pack->src.entry);
@@ -969,6 +1033,18 @@ static inline int nxffs_packblock(FAR struct nxffs_volume_s *volume,
               return -ENOSPC;
             }
 
+          /* Would moving this inode exceed the amount of packing permitted
+           * for this step?  Then stop here; packing will resume with this
+           * inode on the next step.
+           */
+
+          if (pack->stopoffset > 0 &&
+              nxffs_packtell(volume, pack) +
+              nxffs_packsize(volume, &pack->src.entry) > pack->stopoffset)
+            {
+              return -EAGAIN;
+            }
+
           /* Setup the new source stream */
 
           ret = nxffs_srcsetup(volume, pack, pack->src.entry.doffset);
@@ -983,6 +1059,7 @@ static inline int nxffs_packblock(FAR struct nxffs_volume_s *volume,
           pack->dest.entry.name   = pack->src.entry.name;
           pack->dest.entry.utc    = pack->src.entry.utc;
           pack->dest.entry.datlen = pack->src.entry.datlen;
+          pack->dest.entry.state  = pack->src.entry.state;
           pack->src.entry.name    = NULL;
 
           /* Is there sufficient space at the end of the I/O block to hold
@@ -1088,6 +1165,8 @@ nxffs_setupwriter(FAR struct nxffs_volume_s *volume,
        *   doffset == 0: The write failed after writing the inode name, bue
        *     before any data blocks were written to FLASH.
        *
+       * The writer never has a partially written data block here.
+       *
        * If no FLASH has been set aside for the write, then we don't need to
        * do anything here.
        */
@@ -1100,6 +1179,7 @@ nxffs_setupwriter(FAR struct nxffs_volume_s *volume,
            pack->dest.entry.name   = strdup(wrfile->ofile.entry.name);
            pack->dest.entry.utc    = wrfile->ofile.entry.utc;
            pack->dest.entry.datlen = wrfile->ofile.entry.datlen;
+           pack->dest.entry.state  = wrfile->ofile.entry.state;
 
            memset(&pack->src, 0, sizeof(struct nxffs_packstream_s));
            memcpy(&pack->src.entry, &wrfile->ofile.entry, sizeof(struct nxffs_entry_s));
@@ -1247,18 +1327,70 @@ static inline int nxffs_packwriter(FAR struct nxffs_volume_s *volume,
 }
 
 /****************************************************************************
- * Public Functions
+ * Name: nxffs_packfill
+ *
+ * Description:
+ *   Packing stopped before reaching the next inode to be moved.  Fill the
+ *   unused memory in the pack buffer, from the current destination
+ *   position up to that inode (or the end of the erase block), with
+ *   non-erased values.  This destroys any old copies of inodes that have
+ *   already been moved and it assures that searches for inodes do not stop
+ *   at the gap, mistaking it for the free FLASH region.
+ *
+ * Input Parameters:
+ *   volume - The volume to be packed
+ *   pack   - The volume packing state structure.
+ *   offset - The FLASH offset to the next inode to be moved.
+ *
+ * Returned Values:
+ *   None.
+ *
  ****************************************************************************/
 
+static void nxffs_packfill(FAR struct nxffs_volume_s *volume,
+                           FAR struct nxffs_pack_s *pack, off_t offset)
+{
+  FAR uint8_t *iobuffer;
+  off_t destoffset;
+  off_t start;
+  off_t end;
+  off_t block;
+  int i;
+
+  destoffset = nxffs_packtell(volume, pack);
+
+  for (i = 0, block = pack->block0, iobuffer = volume->pack;
+       i < volume->blkper;
+       i++, block++, iobuffer += volume->geo.blocksize)
+    {
+      /* Never modify bad blocks or block headers */
+
+      if (nxffs_packvalid(iobuffer))
+        {
+          start = MAX(destoffset - block * volume->geo.blocksize,
+                      SIZEOF_NXFFS_BLOCK_HDR);
+          end   = MIN(offset - block * volume->geo.blocksize,
+                      volume->geo.blocksize);
+
+          if (start < end)
+            {
+              memset(&iobuffer[start], ~CONFIG_NXFFS_ERASEDSTATE & 0xff,
+                     end - start);
+            }
+        }
+    }
+}
+
 /****************************************************************************
- * Name: nxffs_pack
+ * Name: nxffs_packwrite
  *
  * Description:
- *   Pack and re-write the filesystem in order to free up memory at the end
- *   of FLASH.
+ *   Erase the erase block that is in the pack buffer and write the new
+ *   contents of the pack buffer to FLASH.
  *
  * Input Parameters:
- *   volume - The volume to be packed.
+ *   volume - The volume to be packed
+ *   pack   - The volume packing state structure.
  *
  * Returned Values:
  *   Zero on success; Otherwise, a negated errno value is returned to
@@ -1266,145 +1398,236 @@ static inline int nxffs_packwriter(FAR struct nxffs_volume_s *volume,
  *
  ****************************************************************************/
 
-int nxffs_pack(FAR struct nxffs_volume_s *volume)
+static int nxffs_packwrite(FAR struct nxffs_volume_s *volume,
+                           FAR struct nxffs_pack_s *pack)
 {
-  struct nxffs_pack_s pack;
-  FAR struct nxffs_wrfile_s *wrfile;
-  off_t iooffset;
-  off_t eblock;
-  off_t block;
-  bool packed;
-  int i;
+  off_t eblock = pack->block0 / volume->blkper;
   int ret;
 
-  /* Get the offset to the first valid inode entry */
+  /* We now have an in-memory image of how we want this erase block to
+   * appear. Now it is safe to erase the block.
+   */
 
-  wrfile = NULL;
-  packed = false;
+  ret = MTD_ERASE(volume->mtd, eblock, 1);
+  if (ret < 0)
+    {
+      fdbg("Failed to erase block %d [%d]: %d\n",
+           eblock, pack->block0, -ret);
+      return ret;
+    }
 
-  iooffset = nxffs_mediacheck(volume, &pack);
-  if (iooffset == 0)
+  /* Write the packed I/O block to FLASH */
+
+  ret = MTD_BWRITE(volume->mtd, pack->block0, volume->blkper, volume->pack);
+  if (ret < 0)
     {
-      /* Offset zero is only returned if no valid blocks were found on the
-       * FLASH media or if there are no valid inode entries on the FLASH after
-       * the first valid block.  There are two possibilities:  (1) there 
-       * really is nothing on the FLASH, or (2) there is a file being written
-       * to the FLASH now.
-       */
+      fdbg("Failed to write erase block %d [%d]: %d\n",
+           eblock, pack->block0, -ret);
+      return ret;
+    }
+
+  /* The volume cache may now hold an old copy of one of these blocks */
+
+  volume->cblock = (off_t)-1;
+  return OK;
+}
+
+/****************************************************************************
+ * Name: nxffs_packdelete
+ *
+ * Description:
+ *   Inodes that have been moved still have their old copies in FLASH.  Mark
+ *   every valid inode in a range of FLASH as deleted.
+ *
+ * Input Parameters:
+ *   volume    - The volume to be packed
+ *   offset    - The beginning of the FLASH range
+ *   endoffset - The end of the FLASH range.  Only inode headers that begin
+ *               before this offset are deleted.
+ *
+ * Returned Values:
+ *   Zero on success; Otherwise, a negated errno value is returned to
+ *   indicate the nature of the failure.
+ *
+ ****************************************************************************/
+
+static int nxffs_packdelete(FAR struct nxffs_volume_s *volume, off_t offset,
+                            off_t endoffset)
+{
+  struct nxffs_entry_s entry;
+  FAR struct nxffs_inode_s *inode;
+  int ret;
 
-      /* Is there a writer? */
+  while (offset < endoffset)
+    {
+      /* Get the next valid inode.  Runs of erased FLASH may remain from
+       * before the inodes were moved; just keep searching after them.
+       */
 
-      wrfile = nxffs_setupwriter(volume, &pack);
-      if (wrfile)
+      ret = nxffs_nextentry(volume, offset, &entry);
+      if (ret == -ENOENT)
         {
-          /* If there is a write, just set ioffset to the offset of data in
-           * first block. Setting 'packed' to true will supress normal inode
-           * packing operation.  Then we can start compacting the FLASH.
-           */
+          offset = nxffs_iotell(volume);
+          continue;
+        }
+      else if (ret < 0)
+        {
+          /* The end of FLASH was reached */
 
-          iooffset = SIZEOF_NXFFS_BLOCK_HDR;
-          packed   = true;
-          goto start_pack;
+          break;
         }
-      else
+
+      offset = nxffs_inodeend(volume, &entry);
+      nxffs_freeentry(&entry);
+
+      if (entry.hoffset >= endoffset)
         {
-          /* No, there is no write in progress.  We just have an empty flash
-           * full of deleted files.  In this case, the media needs to be re-
-           * formatted.
-            */
+          break;
+        }
 
-          ret = nxffs_reformat(volume);
-          if (ret == OK)
-            {
-              /* The free flash offset will be in the first valid block of
-               * the FLASH.
-               */
+      /* Change the inode state to deleted */
 
-              block = 0;
-              ret = nxffs_validblock(volume, &block);
-              if (ret == OK)
-                {
-                  /* Set to the offset past the block header in the first
-                   * valid block
-                   */
+      nxffs_ioseek(volume, entry.hoffset);
+      ret = nxffs_rdcache(volume, volume->ioblock);
+      if (ret < 0)
+        {
+          fdbg("Failed to read block %d: %d\n", volume->ioblock, -ret);
+          return ret;
+        }
 
-                  volume->froffset =
-                    block * volume->geo.blocksize + SIZEOF_NXFFS_BLOCK_HDR;
-                }
-            }
+      inode = (FAR struct nxffs_inode_s *)&volume->cache[volume->iooffset];
+      inode->state = INODE_STATE_DELETED;
 
+      ret = nxffs_wrcache(volume);
+      if (ret < 0)
+        {
+          fdbg("Failed to write block %d: %d\n", volume->ioblock, -ret);
           return ret;
         }
     }
 
-  /* There is a valid format and valid inodes on the media.. setup up to
-   * begin the packing operation.
-   */
+  return OK;
+}
 
-  ret = nxffs_startpos(volume, &pack, &iooffset);
-  if (ret < 0)
-    {
-      /* This is a normal situation if the volume is full */
+/****************************************************************************
+ * Name: nxffs_packtail
+ *
+ * Description:
+ *   There are no more gaps between valid inodes to be packed.  There may,
+ *   however, be deleted inodes at the end of FLASH.  In that case, we
+ *   don't have to pack any files, we simply have to free the FLASH at the
+ *   end.  But don't do this unless there is some particularly big FLASH
+ *   savings (otherwise, we risk wearing out these final blocks).
+ *
+ * Input Parameters:
+ *   volume   - The volume to be packed
+ *   iooffset - The FLASH offset to the end of the last valid inode.
+ *
+ * Returned Values:
+ *   True if the end of FLASH should be freed.
+ *
+ ****************************************************************************/
 
-      if (ret == -ENOSPC)
-        {
-          /* In the case where the volume is full, nxffs_startpos() will
-           * recalculate the free FLASH offset and store it in iooffset.  There
-           * may be deleted files at the end of FLASH.  In this case, we don't
-           * have to pack any files, we simply have to erase FLASH at the end.
-           * But don't do this unless there is some particularly big FLASH
-           * savings (otherwise, we risk wearing out these final blocks).
-           */
+static bool nxffs_packtail(FAR struct nxffs_volume_s *volume, off_t iooffset)
+{
+  FAR struct nxffs_wrfile_s *wrfile;
+  off_t tail;
 
-          if (iooffset + CONFIG_NXFFS_TAILTHRESHOLD < volume->froffset)
-            {
-               /* Setting 'packed' to true will supress normal inode packing
-                * operation.
-                */
+  /* If there is a writer, the FLASH used by the writer is not free */
+
+  wrfile = nxffs_findwriter(volume);
+  if (wrfile && wrfile->ofile.entry.hoffset > 0)
+    {
+      tail = wrfile->ofile.entry.hoffset;
+    }
+  else
+    {
+      tail = volume->froffset;
+    }
 
-               packed = true;
+  return iooffset + CONFIG_NXFFS_TAILTHRESHOLD < tail;
+}
 
-               /* Writing is performed at the end of the free FLASH region.
-                * If we are not packing files, we could still need to pack
-                * the partially written file at the end of FLASH.
-                */
+/****************************************************************************
+ * Name: nxffs_packrun
+ *
+ * Description:
+ *   Perform the packing operation, starting at the provided FLASH offset.
+ *   Erase blocks are re-written one at a time until either (1) all inodes
+ *   and the partially written file (if any) have been moved, or (2) the
+ *   next inode would extend past pack->stopoffset.
+ *
+ *   In the first case, the free FLASH region begins after the last inode
+ *   moved.  The old copies of the inodes that remain after the final erase
+ *   block are marked deleted and their erase blocks are erased only when
+ *   they are re-used (see nxffs_packclean()).
+ *
+ *   In the second case, the free FLASH region is unchanged and packing
+ *   resumes at volume->pkoffset the next time.
+ *
+ * Input Parameters:
+ *   volume   - The volume to be packed
+ *   pack     - The volume packing state structure.
+ *   iooffset - The FLASH offset where the first inode will be moved to.
+ *   packed   - True: There are no further inodes to be packed.
+ *
+ * Returned Values:
+ *   Zero on success; Otherwise, a negated errno value is returned to
+ *   indicate the nature of the failure.
+ *
+ ****************************************************************************/
 
-               wrfile = nxffs_setupwriter(volume, &pack);
-             }
+static int nxffs_packrun(FAR struct nxffs_volume_s *volume,
+                         FAR struct nxffs_pack_s *pack, off_t iooffset,
+                         bool packed)
+{
+  FAR struct nxffs_wrfile_s *wrfile = NULL;
+  off_t froffset;
+  off_t erasesize;
+  off_t stop;
+  off_t eblock;
+  off_t block;
+  bool stopped = false;
+  int i;
+  int ret;
 
-          /* Otherwise return OK.. meaning that there is nothing more we can
-           * do to recover FLASH space.
-           */
+  /* Writing is performed at the end of the free FLASH region.  If we are
+   * not packing files, we could still need to pack the partially written
+   * file at the end of FLASH.
+   */
 
-          else
-            {
-              return OK;
-            }
-        }
-      else
-        {
-          fvdbg("Failed to find a packing position: %d\n", -ret);
-          return ret;
-        }
+  if (packed)
+    {
+      wrfile = nxffs_setupwriter(volume, pack);
     }
 
-  /* Otherwise, begin pack at this src/dest block combination.  Initialize
-   * ioblock and iooffset with the position of the first inode header.  In
-   * this case, the FLASH offset to the first inode header is return in 
-   * iooffset.
+  /* Begin pack at this src/dest block combination.  Initialize ioblock
+   * and iooffset with the position of the first inode header.
+   */
+
+  erasesize        = volume->geo.erasesize;
+  froffset         = volume->froffset;
+  pack->ioblock    = nxffs_getblock(volume, iooffset);
+  pack->iooffset   = nxffs_getoffset(volume, iooffset, pack->ioblock);
+
+  /* A previous packing step may have stopped exactly at the end of a
+   * block.  Never pack over the block header.
    */
 
-start_pack:
+  if (pack->iooffset < SIZEOF_NXFFS_BLOCK_HDR)
+    {
+      pack->iooffset = SIZEOF_NXFFS_BLOCK_HDR;
+      iooffset       = pack->ioblock * volume->geo.blocksize +
+                       SIZEOF_NXFFS_BLOCK_HDR;
+    }
 
-  pack.ioblock     = nxffs_getblock(volume, iooffset);
-  pack.iooffset    = nxffs_getoffset(volume, iooffset, pack.ioblock);
   volume->froffset = iooffset;
 
-  /* Then pack all erase blocks starting with the erase block that contains
-   * the ioblock and through the final erase block on the FLASH.
+  /* Then pack erase blocks starting with the erase block that contains
+   * the ioblock.
    */
 
-  for (eblock = pack.ioblock / volume->blkper;
+  for (eblock = pack->ioblock / volume->blkper;
        eblock < volume->geo.neraseblocks;
        eblock++)
     {
@@ -1413,33 +1636,33 @@ start_pack:
        * previously marked bad blocks.
        */
 
-      pack.block0 = eblock * volume->blkper;
-      ret = MTD_BREAD(volume->mtd, pack.block0, volume->blkper, volume->pack);
+      pack->block0 = eblock * volume->blkper;
+      ret = MTD_BREAD(volume->mtd, pack->block0, volume->blkper, volume->pack);
       if (ret < 0)
         {
           fdbg("Failed to read erase block %d: %d\n", eblock, -ret);
-          goto errout_with_pack;
+          return ret;
         }
 
       /* Pack each I/O block */
 
-      for (i = 0, block = pack.block0, pack.iobuffer = volume->pack;
+      for (i = 0, block = pack->block0, pack->iobuffer = volume->pack;
            i < volume->blkper;
-           i++, block++, pack.iobuffer += volume->geo.blocksize)
+           i++, block++, pack->iobuffer += volume->geo.blocksize)
         {
            /* The first time here, the ioblock may point to an offset into
             * the erase block.  We just need to skip over those cases.
             */
 
-           if (block >= pack.ioblock)
+           if (block >= pack->ioblock)
               {
                 /* Set the I/O position.  Note on the first time we get
-                 * pack.iooffset will hold the offset in the first I/O block
+                 * pack->iooffset will hold the offset in the first I/O block
                  * to the first inode header.  After that, it will always
                  * refer to the first byte after the block header.
                  */
 
-                pack.ioblock = block;
+                pack->ioblock = block;
 
                 /* If this is not a valid block or if we have already
                  * finished packing the valid inode entries, then just fall
@@ -1449,7 +1672,7 @@ start_pack:
                  * already verified that).
                  */
 
-                if (nxffs_packvalid(&pack))
+                if (nxffs_packvalid(pack->iobuffer))
                   {
                     /* Have we finished packing inodes? */
 
@@ -1459,34 +1682,41 @@ start_pack:
 
                          /* Pack inode data into this block */
 
-                         ret = nxffs_packblock(volume, &pack);
-                         if (ret < 0)
+                         ret = nxffs_packblock(volume, pack);
+                         if (ret == -EAGAIN)
                            {
-                             /* The error -ENOSPC is a special value that simply
-                              * means that there is nothing further to be packed.
+                             /* The error -EAGAIN means that packing must stop
+                              * for now before the next inode is moved.
                               */
 
-                             if (ret == -ENOSPC)
-                               {
-                                 packed = true;
+                             stopped = true;
+                             break;
+                           }
+                         else if (ret == -ENOSPC)
+                           {
+                             /* The error -ENOSPC is a special value that
+                              * simply means that there is nothing further to
+                              * be packed.
+                              */
 
-                                 /* Writing is performed at the end of the free
-                                  * FLASH region and this implemenation is restricted
-                                  * to a single writer.  The new inode is not
-                                  * written to FLASH until the the writer is closed
-                                  * and so will not be found by nxffs_packblock().
-                                  */
+                             packed = true;
 
-                                 wrfile = nxffs_setupwriter(volume, &pack);
-                               }
-                             else
-                               {
-                                 /* Otherwise, something really bad happened */
+                             /* Writing is performed at the end of the free
+                              * FLASH region.  The new inode is not written to
+                              * FLASH until the the writer is suspended or
+                              * closed and so will not be found by
+                              * nxffs_packblock().
+                              */
 
-                                 fdbg("Failed to pack into block %d: %d\n",
-                                      block, ret);
-                                 goto errout_with_pack;
-                               }
+                             wrfile = nxffs_setupwriter(volume, pack);
+                           }
+                         else if (ret < 0)
+                           {
+                             /* Otherwise, something really bad happened */
+
+                             fdbg("Failed to pack into block %d: %d\n",
+                                  block, ret);
+                             return ret;
                            }
                        }
 
@@ -1500,7 +1730,7 @@ start_pack:
 
                          /* Pack write data into this block */
 
-                         ret = nxffs_packwriter(volume, &pack, wrfile);
+                         ret = nxffs_packwriter(volume, pack, wrfile);
                          if (ret < 0)
                            {
                              /* The error -ENOSPC is a special value that simply
@@ -1517,7 +1747,7 @@ start_pack:
 
                                  fdbg("Failed to pack into block %d: %d\n",
                                       block, ret);
-                                 goto errout_with_pack;
+                                 return ret;
                                }
                            }
                        }
@@ -1527,46 +1757,479 @@ start_pack:
                   * erased state.
                   */
 
-                 if (pack.iooffset < volume->geo.blocksize)
+                 if (pack->iooffset < volume->geo.blocksize)
                    {
-                     memset(&pack.iobuffer[pack.iooffset],
+                     memset(&pack->iobuffer[pack->iooffset],
                             CONFIG_NXFFS_ERASEDSTATE,
-                            volume->geo.blocksize - pack.iooffset);
+                            volume->geo.blocksize - pack->iooffset);
                    }
 
-                 /* Next time through the loop, pack.iooffset will point to the
+                 /* Next time through the loop, pack->iooffset will point to the
                   * first byte after the block header.
                   */
 
-                 pack.iooffset = SIZEOF_NXFFS_BLOCK_HDR;
+                 pack->iooffset = SIZEOF_NXFFS_BLOCK_HDR;
               }
          }
 
-      /* We now have an in-memory image of how we want this erase block to
-       * appear. Now it is safe to erase the block.
+      /* Did packing stop before the next inode? */
+
+      if (stopped)
+        {
+          /* Yes.. The memory between the last inode moved and the next
+           * inode to be moved is now unused.
+           */
+
+          stop = pack->src.entry.hoffset;
+          volume->pkoffset = nxffs_packtell(volume, pack);
+          nxffs_packfill(volume, pack, stop);
+
+          ret = nxffs_packwrite(volume, pack);
+          if (ret < 0)
+            {
+              return ret;
+            }
+
+          /* Delete the old copies of the inodes that were moved and that
+           * lie after this erase block.  The free FLASH region is not
+           * changed.
+           */
+
+          ret = nxffs_packdelete(volume, (eblock + 1) * erasesize, stop);
+          volume->froffset = froffset;
+          return ret;
+        }
+
+      /* Write the packed erase block to FLASH */
+
+      ret = nxffs_packwrite(volume, pack);
+      if (ret < 0)
+        {
+          return ret;
+        }
+
+      /* Has everything been packed? */
+
+      if (packed && !wrfile)
+        {
+          break;
+        }
+    }
+
+  /* The free FLASH region now begins just after the last inode that was
+   * moved.  Delete the old copies of inodes that remain after the final
+   * packed erase block.
+   */
+
+  volume->pkoffset = volume->froffset;
+
+  /* The inode header of the writer (if any) is not written until the writer
+   * is suspended or closed.  Packing must not resume after that header or
+   * the data written in the meantime would be mistaken for free FLASH.
+   */
+
+  wrfile = nxffs_findwriter(volume);
+  if (wrfile && wrfile->ofile.entry.hoffset > 0 &&
+      wrfile->ofile.entry.hoffset < volume->pkoffset)
+    {
+      volume->pkoffset = wrfile->ofile.entry.hoffset;
+    }
+
+  /* This packing pass is complete.  The next pass begins at the first inode
+   * that was deleted behind this one.
+   */
+
+  if (volume->rpoffset > 0 && volume->rpoffset < volume->pkoffset)
+    {
+      volume->pkoffset = volume->rpoffset;
+    }
+
+  volume->rpoffset = 0;
+
+  ret = nxffs_packdelete(volume, (eblock + 1) * erasesize, froffset);
+
+  /* The FLASH after the packed erase block (and up to the old free FLASH
+   * offset) is not erased now; each erase block will be erased if and when
+   * it is needed again.
+   */
+
+  volume->dirtyblk = eblock + 1;
+  volume->cleanblk = MAX(volume->cleanblk,
+                         (froffset + erasesize - 1) / erasesize);
+  return ret;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: nxffs_pack
+ *
+ * Description:
+ *   Pack and re-write the filesystem in order to free up memory at the end
+ *   of FLASH.
+ *
+ * Input Parameters:
+ *   volume - The volume to be packed.
+ *
+ * Returned Values:
+ *   Zero on success; Otherwise, a negated errno value is returned to
+ *   indicate the nature of the failure.
+ *
+ ****************************************************************************/
+
+int nxffs_pack(FAR struct nxffs_volume_s *volume)
+{
+  struct nxffs_pack_s pack;
+  off_t iooffset;
+  off_t block;
+  bool packed;
+  int ret;
+
+  /* Get the offset to the first valid inode entry.  The whole volume is
+   * packed, so any later packing pass can start after this one.
+   */
+
+  packed = false;
+  volume->rpoffset = 0;
+
+  iooffset = nxffs_mediacheck(volume, &pack);
+  if (iooffset == 0)
+    {
+      /* Offset zero is only returned if no valid blocks were found on the
+       * FLASH media or if there are no valid inode entries on the FLASH after
+       * the first valid block.  In the latter case, there is either nothing
+       * at all on the FLASH or a file being written to the FLASH now.
        */
 
-      ret = MTD_ERASE(volume->mtd, eblock, 1);
+      block = 0;
+      ret = nxffs_validblock(volume, &block);
+      if (ret == OK)
+        {
+          /* Just set ioffset to the offset of data in first block. Setting
+           * 'packed' to true will supress normal inode packing operation.
+           * Then we can start compacting the FLASH.
+           */
+
+          iooffset = block * volume->geo.blocksize + SIZEOF_NXFFS_BLOCK_HDR;
+          packed   = true;
+        }
+      else
+        {
+          /* No valid blocks at all.  In this case, the media needs to be
+           * re-formatted.
+           */
+
+          ret = nxffs_reformat(volume);
+          if (ret == OK)
+            {
+              /* Re-establish the offsets to the free FLASH region */
+
+              volume->cblock = (off_t)-1;
+              ret = nxffs_limits(volume);
+            }
+
+          return ret;
+        }
+    }
+
+  /* There is a valid format and valid inodes on the media.. setup up to
+   * begin the packing operation.
+   */
+
+  else
+    {
+      ret = nxffs_startpos(volume, &pack, &iooffset);
       if (ret < 0)
         {
-          fdbg("Failed to erase block %d [%d]: %d\n",
-               eblock, pack.block0, -ret);
+          /* This is a normal situation if the volume is full */
+
+          if (ret != -ENOSPC)
+            {
+              fvdbg("Failed to find a packing position: %d\n", -ret);
+              goto errout_with_pack;
+            }
+
+          /* In the case where the volume is full, nxffs_startpos() will
+           * recalculate the free FLASH offset and store it in iooffset.
+           */
+
+          if (!nxffs_packtail(volume, iooffset))
+            {
+              /* There is nothing more we can do to recover FLASH space. */
+
+              volume->pkoffset = iooffset;
+              ret = OK;
+              goto errout_with_pack;
+            }
+
+          /* Setting 'packed' to true will supress normal inode packing
+           * operation.
+           */
+
+          packed = true;
+        }
+    }
+
+  /* Pack the whole volume */
+
+  ret = nxffs_packrun(volume, &pack, iooffset, packed);
+
+errout_with_pack:
+  nxffs_freeentry(&pack.src.entry);
+  nxffs_freeentry(&pack.dest.entry);
+  return ret;
+}
+
+/****************************************************************************
+ * Name: nxffs_packstep
+ *
+ * Description:
+ *   Perform one bounded step of packing:  Move the inodes following
+ *   volume->pkoffset until at least CONFIG_NXFFS_PACKSTEP erase blocks
+ *   have been re-written.  When the last inode has been moved, the free
+ *   FLASH region is moved back to the end of the packed inodes.
+ *
+ * Input Parameters:
+ *   volume - The volume to be packed.
+ *
+ * Returned Values:
+ *   Zero on success; Otherwise, a negated errno value is returned to
+ *   indicate the nature of the failure.
+ *
+ ****************************************************************************/
+
+int nxffs_packstep(FAR struct nxffs_volume_s *volume)
+{
+  struct nxffs_pack_s pack;
+  off_t iooffset;
+  off_t eblock;
+  off_t neblocks;
+  off_t nsteps;
+  bool packed;
+  int ret;
+
+  memset(&pack, 0, sizeof(struct nxffs_pack_s));
+  packed = false;
+
+  for (;;)
+    {
+      /* Find the first valid inode after the packed part of the volume */
+
+      iooffset = volume->pkoffset;
+      ret = nxffs_nextentry(volume, iooffset, &pack.src.entry);
+      if (ret == OK)
+        {
+          /* Find the first gap after the packed inodes */
+
+          ret = nxffs_startpos(volume, &pack, &iooffset);
+        }
+      else if (ret == -ENOENT)
+        {
+          /* There are no valid inodes after the packed inodes */
+
+          ret = -ENOSPC;
+        }
+
+      /* If the current packing pass is complete, then begin the next pass
+       * at the first inode that was deleted behind it (if any).
+       */
+
+      if (ret != -ENOSPC || volume->rpoffset == 0)
+        {
+          break;
+        }
+
+      nxffs_freeentry(&pack.src.entry);
+      nxffs_freeentry(&pack.dest.entry);
+      memset(&pack, 0, sizeof(struct nxffs_pack_s));
+
+      volume->pkoffset = volume->rpoffset;
+      volume->rpoffset = 0;
+    }
+
+  if (ret < 0)
+    {
+      if (ret != -ENOSPC)
+        {
+          fvdbg("Failed to find a packing position: %d\n", -ret);
           goto errout_with_pack;
         }
 
-      /* Write the packed I/O block to FLASH */
+      /* There is nothing more to pack.  Is there a lot of deleted FLASH
+       * at the end of FLASH that is worth recovering?
+       */
 
-      ret = MTD_BWRITE(volume->mtd, pack.block0, volume->blkper, volume->pack);
-      if (ret < 0)
+      if (!nxffs_packtail(volume, iooffset))
         {
-          fdbg("Failed to write erase block %d [%]: %d\n",
-               eblock, pack.block0, -ret);
+          volume->pkoffset = iooffset;
+          ret = OK;
           goto errout_with_pack;
         }
+
+      packed = true;
+    }
+  else
+    {
+      /* Each step must move enough to finish packing before the free FLASH
+       * region is used up.  There are about 'free / blocksize' data block
+       * allocations (and, hence, packing steps) left.  Divide the FLASH
+       * that remains to be packed among those steps, but never pack less
+       * than CONFIG_NXFFS_PACKSTEP erase blocks per step.
+       */
+
+      nsteps = (volume->nblocks * volume->geo.blocksize - volume->froffset) /
+               volume->geo.blocksize;
+      if (nsteps < 1)
+        {
+          nsteps = 1;
+        }
+
+      neblocks = ((volume->froffset - iooffset) / nsteps +
+                  volume->geo.erasesize - 1) / volume->geo.erasesize;
+      if (neblocks < CONFIG_NXFFS_PACKSTEP)
+        {
+          neblocks = CONFIG_NXFFS_PACKSTEP;
+        }
+
+      /* Stop before moving an inode that would extend beyond the last erase
+       * block permitted for this step.
+       */
+
+      eblock          = nxffs_getblock(volume, iooffset) / volume->blkper;
+      pack.stopoffset = (eblock + neblocks) * volume->geo.erasesize;
     }
 
+  ret = nxffs_packrun(volume, &pack, iooffset, packed);
+
 errout_with_pack:
   nxffs_freeentry(&pack.src.entry);
   nxffs_freeentry(&pack.dest.entry);
   return ret;
 }
+
+/****************************************************************************
+ * Name: nxffs_packclean
+ *
+ * Description:
+ *   Packing does not erase the FLASH that it frees at the end of the
+ *   volume.  Instead, those erase blocks are remembered as dirty and each
+ *   is erased (if necessary) by this function when it is first re-used.
+ *   Everything from the provided offset to the end of its erase block is
+ *   free; memory before that offset in the erase block is preserved.
+ *
+ * Input Parameters:
+ *   volume - Describes the NXFFS volume
+ *   offset - The FLASH offset that is about to be used.
+ *
+ * Returned Values:
+ *   Zero on success; Otherwise, a negated errno value is returned to
+ *   indicate the nature of the failure.
+ *
+ ****************************************************************************/
+
+int nxffs_packclean(FAR struct nxffs_volume_s *volume, off_t offset)
+{
+  FAR uint8_t *iobuffer;
+  off_t eblock;
+  off_t block0;
+  off_t start;
+  bool dirty;
+  int i;
+  int ret;
+
+  /* Is the erase block containing this offset dirty? */
+
+  eblock = nxffs_getblock(volume, offset) / volume->blkper;
+  if (eblock < volume->dirtyblk || eblock >= volume->cleanblk)
+    {
+      return OK;
+    }
+
+  /* Read the erase block into the pack buffer */
+
+  block0 = eblock * volume->blkper;
+  ret = MTD_BREAD(volume->mtd, block0, volume->blkper, volume->pack);
+  if (ret < 0)
+    {
+      fdbg("Failed to read erase block %d: %d\n", eblock, -ret);
+      return ret;
+    }
+
+  /* Reset the free part of each valid I/O block to the erased state */
+
+  dirty = false;
+  for (i = 0, iobuffer = volume->pack;
+       i < volume->blkper;
+       i++, iobuffer += volume->geo.blocksize)
+    {
+      if (nxffs_packvalid(iobuffer))
+        {
+          start = offset - (block0 + i) * volume->geo.blocksize;
+          start = MAX(start, SIZEOF_NXFFS_BLOCK_HDR);
+          if (start < volume->geo.blocksize &&
+              nxffs_erased(&iobuffer[start], volume->geo.blocksize - start) <
+              volume->geo.blocksize - start)
+            {
+              memset(&iobuffer[start], CONFIG_NXFFS_ERASEDSTATE,
+                     volume->geo.blocksize - start);
+              dirty = true;
+            }
+        }
+    }
+
+  /* Erase and re-write the block only if something was not erased */
+
+  if (dirty)
+    {
+      ret = MTD_ERASE(volume->mtd, eblock, 1);
+      if (ret < 0)
+        {
+          fdbg("Failed to erase block %d: %d\n", eblock, -ret);
+          return ret;
+        }
+
+      ret = MTD_BWRITE(volume->mtd, block0, volume->blkper, volume->pack);
+      if (ret < 0)
+        {
+          fdbg("Failed to write erase block %d: %d\n", eblock, -ret);
+          return ret;
+        }
+
+      volume->cblock = (off_t)-1;
+    }
+
+  /* This erase block (and any before it) is now clean */
+
+  volume->dirtyblk = eblock + 1;
+  return OK;
+}
+
+/****************************************************************************
+ * Name: nxffs_packfreed
+ *
+ * Description:
+ *   The inode at the provided FLASH offset has been deleted (or abandoned)
+ *   and its FLASH can be recovered by packing.  If the inode lies in the
+ *   part of the volume that the current packing pass has already packed,
+ *   then it will be recovered by the next pass.  Restarting the current
+ *   pass would move all of the inodes that it has already moved again.
+ *
+ * Input Parameters:
+ *   volume - Describes the NXFFS volume
+ *   offset - The FLASH offset to the deleted inode header.
+ *
+ * Returned Values:
+ *   None
+ *
+ ****************************************************************************/
+
+void nxffs_packfreed(FAR struct nxffs_volume_s *volume, off_t offset)
+{
+  if (offset < volume->pkoffset &&
+      (volume->rpoffset == 0 || offset < volume->rpoffset))
+    {
+      volume->rpoffset = offset;
+    }
+}
@@ -76,7 +76,8 @@
  *   Seek to the file position before read or write access.  Note that the
  *   simplier nxffs_ioseek() cannot be used for this purpose.  File offsets
  *   are not easily mapped to FLASH offsets due to intervening block and
- *   data headers.
+ *   data headers.  Nor are they easily mapped to inodes: data appended to
+ *   a file lies in extent inodes that follow the head inode.
  *
  * Input Parameters:
  *   volume   - Describes the current volume
@@ -91,16 +92,47 @@ static ssize_t nxffs_rdseek(FAR struct nxffs_volume_s *volume,
                             off_t fpos,
                             FAR struct nxffs_blkentry_s *blkentry)
 {
+  struct nxffs_entry_s inode;
   size_t datstart;
   size_t datend;
   off_t offset;
   int ret;
 
+  /* Re-read the head inode.  For an open file, entry->datlen holds the
+   * length of the whole file, not just the length of the data in the head.
+   */
+
+  ret = nxffs_nextentry(volume, entry->hoffset, &inode);
+  if (ret < 0)
+    {
+      fdbg("Failed to read the inode header: %d\n", -ret);
+      return ret;
+    }
+
+  /* Find the inode (the head or an extent) that holds the desired position */
+
+  datend = 0;
+  while (fpos >= datend + inode.datlen)
+    {
+      datend += inode.datlen;
+      offset  = nxffs_inodeend(volume, &inode);
+      nxffs_freeentry(&inode);
+
+      ret = nxffs_findextent(volume, offset, entry->name, &inode);
+      if (ret < 0)
+        {
+          fdbg("Failed to find the extent: %d\n", -ret);
+          return ret;
+        }
+    }
+
   /* The initial FLASH offset will be the offset to first data block of
    * the inode
    */
 
-  offset = entry->doffset;
+  offset = inode.doffset;
+  nxffs_freeentry(&inode);
+
   if (offset == 0)
     {
       /* Zero length files will have no data blocks */
@@ -110,7 +142,6 @@ static ssize_t nxffs_rdseek(FAR struct nxffs_volume_s *volume,
 
   /* Loop until we read the data block containing the desired position */
 
-  datend = 0;
   do
     {
       /* Check if the next data block contains the sought after file position */
@@ -128,6 +128,7 @@ int nxffs_stat(FAR struct inode *mountpt, FAR const char *relpath,
 {
   FAR struct nxffs_volume_s *volume;
   struct nxffs_entry_s entry;
+  uint32_t filelen;
   int ret;
 
   fvdbg("Entry\n");
@@ -149,7 +150,6 @@ int nxffs_stat(FAR struct inode *mountpt, FAR const char *relpath,
 
   memset(buf, 0, sizeof(struct stat));
   buf->st_blksize = volume->geo.blocksize;
-  buf->st_blocks  = entry.datlen / (volume->geo.blocksize - SIZEOF_NXFFS_BLOCK_HDR);
 
   /* The requested directory must be the volume-relative "root" directory */
 
@@ -164,8 +164,19 @@ int nxffs_stat(FAR struct inode *mountpt, FAR const char *relpath,
           goto errout_with_semaphore;
         }
 
+      /* The file data may continue in extents that follow the head inode */
+
+      ret = nxffs_filelen(volume, &entry, &filelen);
+      nxffs_freeentry(&entry);
+      if (ret < 0)
+        {
+          fdbg("Failed to get the length of '%s': %d\n", relpath, -ret);
+          goto errout_with_semaphore;
+        }
+
       buf->st_mode    = S_IFREG|S_IXOTH|S_IXGRP|S_IXUSR;
-      buf->st_size    = entry.datlen;
+      buf->st_size    = filelen;
+      buf->st_blocks  = filelen / (volume->geo.blocksize - SIZEOF_NXFFS_BLOCK_HDR);
       buf->st_atime   = entry.utc;
       buf->st_mtime   = entry.utc;
       buf->st_ctime   = entry.utc;
@@ -68,19 +68,14 @@
  ****************************************************************************/
 
 /****************************************************************************
- * Public Functions
- ****************************************************************************/
-
-/****************************************************************************
- * Name: nxffs_rminode
+ * Name: nxffs_markdeleted
  *
  * Description:
- *   Remove an inode from FLASH.  This is the internal implementation of
- *   the file system unlinke operation.
+ *   Change the state of one inode header in FLASH to deleted.
  *
  * Input Parameters:
  *   volume - Describes the NXFFS volume.
- *   name - the name of the inode to be deleted.
+ *   entry - Describes the inode to be deleted.
  *
  * Returned Value:
  *   Zero is returned if the inode is successfully deleted.  Otherwise, a
@@ -88,39 +83,17 @@
  *
  ****************************************************************************/
 
-int nxffs_rminode(FAR struct nxffs_volume_s *volume, FAR const char *name)
+static int nxffs_markdeleted(FAR struct nxffs_volume_s *volume,
+                             FAR struct nxffs_entry_s *entry)
 {
-  FAR struct nxffs_ofile_s *ofile;
   FAR struct nxffs_inode_s *inode;
-  struct nxffs_entry_s entry;
   int ret;
 
-  /* Check if the file is open */
-
-  ofile = nxffs_findofile(volume, name);
-  if (ofile)
-    {
-      /* We can't remove the inode if it is open */
-
-      fdbg("Inode '%s' is open\n", name);
-      ret = -EBUSY;
-      goto errout;
-    }
-
-  /* Find the NXFFS inode */
-
-  ret = nxffs_findinode(volume, name, &entry);
-  if (ret < 0)
-    {
-      fdbg("Inode '%s' not found\n", name);
-      goto errout;
-    }
-
   /* Set the position to the FLASH offset of the file header (nxffs_findinode
    * should have left the block in the cache).
    */
 
-  nxffs_ioseek(volume, entry.hoffset);
+  nxffs_ioseek(volume, entry->hoffset);
 
   /* Make sure the the block is in the cache */
 
@@ -128,7 +101,7 @@ int nxffs_rminode(FAR struct nxffs_volume_s *volume, FAR const char *name)
   if (ret < 0)
     {
       fdbg("Failed to read data into cache: %d\n", ret);
-      goto errout_with_entry;
+      return ret;
     }
 
   /* Change the file status... it is no longer valid */
@@ -142,12 +115,107 @@ int nxffs_rminode(FAR struct nxffs_volume_s *volume, FAR const char *name)
   if (ret < 0)
     {
       fdbg("Failed to read data into cache: %d\n", ret);
+      return ret;
     }
 
-errout_with_entry:
-  nxffs_freeentry(&entry);
-errout:
-  return ret;
+  /* The FLASH occupied by the inode can now be reclaimed by packing */
+
+  nxffs_packfreed(volume, entry->hoffset);
+  return OK;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: nxffs_delinode
+ *
+ * Description:
+ *   Mark the head inode and all of the extents of a file as deleted.
+ *   Unlike nxffs_rminode(), this does not check if the file is open; it is
+ *   used to remove the old version of a file that is being truncated.
+ *
+ * Input Parameters:
+ *   volume - Describes the NXFFS volume.
+ *   name - the name of the file to be deleted.
+ *
+ * Returned Value:
+ *   Zero is returned if the file is successfully deleted.  Otherwise, a
+ *   negated errno value is returned indicating the nature of the failure.
+ *
+ ****************************************************************************/
+
+int nxffs_delinode(FAR struct nxffs_volume_s *volume, FAR const char *name)
+{
+  struct nxffs_entry_s entry;
+  off_t offset;
+  int ret;
+
+  /* Find the NXFFS inode */
+
+  ret = nxffs_findinode(volume, name, &entry);
+  if (ret < 0)
+    {
+      fdbg("Inode '%s' not found\n", name);
+      return ret;
+    }
+
+  /* Delete the head inode, then each extent that follows it */
+
+  do
+    {
+      ret = nxffs_markdeleted(volume, &entry);
+      offset = nxffs_inodeend(volume, &entry);
+      nxffs_freeentry(&entry);
+
+      if (ret < 0)
+        {
+          return ret;
+        }
+    }
+  while ((ret = nxffs_findextent(volume, offset, name, &entry)) == OK);
+
+  /* -ENOENT and -ENOSPC just mean that there are no further extents */
+
+  return (ret == -ENOENT || ret == -ENOSPC) ? OK : ret;
+}
+
+/****************************************************************************
+ * Name: nxffs_rminode
+ *
+ * Description:
+ *   Remove an inode from FLASH.  This is the internal implementation of
+ *   the file system unlinke operation.
+ *
+ * Input Parameters:
+ *   volume - Describes the NXFFS volume.
+ *   name - the name of the inode to be deleted.
+ *
+ * Returned Value:
+ *   Zero is returned if the inode is successfully deleted.  Otherwise, a
+ *   negated errno value is returned indicating the nature of the failure.
+ *
+ ****************************************************************************/
+
+int nxffs_rminode(FAR struct nxffs_volume_s *volume, FAR const char *name)
+{
+  FAR struct nxffs_ofile_s *ofile;
+
+  /* Check if the file is open */
+
+  ofile = nxffs_findofile(volume, name);
+  if (ofile)
+    {
+      /* We can't remove the inode if it is open */
+
+      fdbg("Inode '%s' is open\n", name);
+      return -EBUSY;
+    }
+
+  /* Then delete the file and all of its extents */
+
+  return nxffs_delinode(volume, name);
 }
 
 /****************************************************************************
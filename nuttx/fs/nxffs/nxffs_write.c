@@ -224,6 +224,21 @@ static inline int nxffs_wralloc(FAR struct nxffs_volume_s *volume,
    * region is fully populated.
    */
 
+  /* If the free FLASH region is getting small, pack a little of the volume
+   * now rather than all of it when it is finally exhausted.
+   */
+
+  if (volume->froffset + CONFIG_NXFFS_PACKSTART >
+      volume->nblocks * volume->geo.blocksize)
+    {
+      ret = nxffs_packstep(volume);
+      if (ret < 0)
+        {
+          fdbg("Failed to pack the volume: %d\n", -ret);
+          return ret;
+        }
+    }
+
   packed = false;
   for (;;)
     {
@@ -485,6 +500,17 @@ ssize_t nxffs_write(FAR struct file *filep, FAR const char *buffer, size_t bufle
       goto errout_with_semaphore;
     }
 
+  /* Only one writer at a time can extend the FLASH region.  Take over the
+   * end of FLASH from any other writer.
+   */
+
+  ret = nxffs_wrbegin(volume, wrfile);
+  if (ret < 0)
+    {
+      fdbg("Failed to begin the write: %d\n", -ret);
+      goto errout_with_semaphore;
+    }
+
   /* Loop until we successfully appended all of the data to the file (or an
    * error occurs)
    */
@@ -504,13 +530,31 @@ ssize_t nxffs_write(FAR struct file *filep, FAR const char *buffer, size_t bufle
           if (ret < 0)
             {
               fdbg("Failed to allocate a data block: %d\n", -ret);
+
+              /* If some data was already written, then return the partial
+               * write (the next write will report the error).
+               */
+
+              if (total > 0)
+                {
+                  break;
+                }
+
               goto errout_with_semaphore;
             }
         }
 
-      /* Seek to the FLASH block containing the data block */
+      /* Seek to the FLASH block containing the data block and make sure
+       * that it is in the cache.
+       */
 
       nxffs_ioseek(volume, wrfile->doffset);
+      ret = nxffs_rdcache(volume, volume->ioblock);
+      if (ret < 0)
+        {
+          fdbg("Failed to read data into cache: %d\n", -ret);
+          goto errout_with_semaphore;
+        }
 
       /* Verify that the FLASH data that was previously written is still intact */
 
@@ -540,7 +584,7 @@ ssize_t nxffs_write(FAR struct file *filep, FAR const char *buffer, size_t bufle
   /* Success.. return the number of bytes written */
 
   ret           = total;
-  filep->f_pos  = wrfile->datlen;
+  filep->f_pos  = wrfile->filelen + wrfile->ofile.entry.datlen + wrfile->datlen;
 
 errout_with_semaphore:
   sem_post(&volume->exclsem);
@@ -697,6 +741,15 @@ int nxffs_wrverify(FAR struct nxffs_volume_s *volume, size_t size)
 
   while (volume->ioblock < volume->nblocks)
     {
+      /* Erase the block first if it was freed by packing but not yet erased */
+
+      ret = nxffs_packclean(volume, nxffs_iotell(volume));
+      if (ret < 0)
+        {
+          fdbg("Failed to clean block %d: %d\n", volume->ioblock, -ret);
+          return ret;
+        }
+
       /* Make sure that the block is in memory */
  
       ret = nxffs_rdcache(volume, volume->ioblock);
@@ -794,9 +847,19 @@ int nxffs_wrblkhdr(FAR struct nxffs_volume_s *volume,
   FAR struct nxffs_data_s *dathdr;
   int ret;
 
-  /* Write the data block header to memory */
+  /* Write the data block header to memory.  Make sure that the data block
+   * is in the cache; other operations may have used the cache since the
+   * data was last written.
+   */
 
   nxffs_ioseek(volume, wrfile->doffset);
+  ret = nxffs_rdcache(volume, volume->ioblock);
+  if (ret < 0)
+    {
+      fdbg("Failed to read data into cache: %d\n", -ret);
+      goto errout;
+    }
+
   dathdr = (FAR struct nxffs_data_s *)&volume->cache[volume->iooffset];
   memcpy(dathdr->magic, g_datamagic, NXFFS_MAGICSIZE);
   nxffs_wrle32(dathdr->crc, 0);
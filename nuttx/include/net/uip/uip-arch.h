@@ -46,6 +46,7 @@
 
 #include <sys/ioctl.h>
 #include <stdint.h>
+#include <stdbool.h>
 #include <net/if.h>
 
 #include <net/uip/uip.h>
@@ -64,6 +65,56 @@
  * Pre-processor Definitions
  ****************************************************************************/
 
+/* With CONFIG_NET_SGSEND, every network driver must send d_sgdata after
+ * the headers in d_buf.  Only drivers that do so may be used with it.  The
+ * board configuration selects CONFIG_ARCH_HAVE_NET_SGSEND when its network
+ * driver supports this (currently only the simulation's driver).
+ */
+
+#if defined(CONFIG_NET_SGSEND) && !defined(CONFIG_ARCH_HAVE_NET_SGSEND)
+#  error "CONFIG_NET_SGSEND requires a driver that supports it (CONFIG_ARCH_HAVE_NET_SGSEND)"
+#endif
+
+/* Forget any scatter/gather TCP data and any checksum of the outgoing
+ * application data before building a new outgoing packet in d_buf.
+ */
+
+#ifdef CONFIG_NET_SGSEND
+#  define uip_sndclear(dev) \
+  do { (dev)->d_sgdata = NULL; (dev)->d_sndsumvalid = false; } while (0)
+#else
+#  define uip_sndclear(dev) do { (dev)->d_sndsumvalid = false; } while (0)
+#endif
+
+/* Device locking.  With CONFIG_NET_NOINTS, a driver that is not called from
+ * the interrupt level serializes its own use of the device (d_buf and the
+ * hardware) with the device lock and holds only this lock when it calls
+ * uip_input(), uip_poll() or uip_timer():  uIP takes the global network lock
+ * (uip_lock()) itself.  uip_input() releases it before it returns, so the
+ * driver sends the reply to a received packet without holding uIP.
+ * uip_poll() and uip_timer(), however, call back into the driver for each
+ * packet with uip_lock() held, so a packet sent from the poll callback is
+ * still sent with uIP locked.
+ *
+ * uip_devlockinit() -- Initialize the device lock.  This must be done
+ *                      before the driver first uses the lock.
+ * uip_devlock()     -- Take the device lock.  The lock is re-entrant.
+ * uip_devunlock()   -- Release the device lock.
+ *
+ * Without CONFIG_NET_NOINTS, drivers are called from interrupt handlers and
+ * these just disable interrupts.
+ */
+
+#ifdef CONFIG_NET_NOINTS
+#  define uip_devlockinit(dev)    uip_mutexinit(&(dev)->d_lock, UIP_LOCKSTAT(device))
+#  define uip_devlock(dev)        uip_mutexlock(&(dev)->d_lock)
+#  define uip_devunlock(dev,f)    uip_mutexunlock(&(dev)->d_lock, f)
+#else
+#  define uip_devlockinit(dev)
+#  define uip_devlock(dev)        irqsave()
+#  define uip_devunlock(dev,f)    irqrestore(f)
+#endif
+
 /****************************************************************************
  * Public Types
  ****************************************************************************/
@@ -165,6 +216,26 @@ struct uip_driver_s
 
   uint16_t d_sndlen;
 
+#ifdef CONFIG_NET_SGSEND
+  /* If d_sgdata is non-NULL, then the d_sndlen bytes of application data
+   * of an outgoing TCP packet were not copied into d_buf.  Then d_buf holds
+   * only the first (d_len - d_sndlen) bytes of the packet (the link level,
+   * IP and TCP headers) and the driver must send the data at d_sgdata
+   * after them.  The data remains valid until it is acknowledged.
+   */
+
+  FAR const uint8_t *d_sgdata;
+#endif
+
+  /* If d_sndsumvalid is true, then d_sndsum holds the Internet checksum of
+   * the d_sndlen bytes of application data at d_snddata (as returned by
+   * uip_chksumcopy()).  uip_send() computes it while copying the data so
+   * that the data need not be read again for the TCP or UDP checksum.
+   */
+
+  bool d_sndsumvalid;
+  uint16_t d_sndsum;
+
   /* IGMP group list */
 
 #ifdef CONFIG_NET_IGMP
@@ -181,6 +252,12 @@ struct uip_driver_s
   int (*d_rmmac)(struct uip_driver_s *dev, FAR const uint8_t *mac);
 #endif
 
+  /* The device lock (see uip_devlock()) */
+
+#ifdef CONFIG_NET_NOINTS
+  struct uip_mutex_s d_lock;
+#endif
+
   /* Drivers may attached device-specific, private information */
 
   void *d_private;
@@ -243,6 +320,9 @@ struct uip_driver_s
  *           devicedriver_send();
  *         }
  *       }
+ *
+ * uip_input() takes the network lock while it processes the packet.  It is
+ * not held when the function returns.
  */
 
 extern void uip_input(struct uip_driver_s *dev);
@@ -294,7 +374,9 @@ extern void uip_input(struct uip_driver_s *dev);
  *         return 1; <-- Terminates polling if necessary
  *       }
  *     return 0;
- *   }
+ *   } *
+ * The callback function is called with the network lock (uip_lock()) held
+ * so it should only start the transmission of the packet, not wait for it.
  */
 
 typedef int (*uip_poll_callback_t)(struct uip_driver_s *dev);
@@ -337,6 +419,41 @@ extern void uip_incr32(uint8_t *op32, uint16_t op16);
 
 extern uint16_t uip_chksum(uint16_t *buf, uint16_t len);
 
+/* Copy a buffer and calculate the Internet checksum of the data.
+ *
+ * This does the same as memcpy() followed by uip_chksum() on the copied
+ * data, but the data is read only once.  The buffers need not be aligned.
+ *
+ * dest A pointer to the buffer that receives the data.
+ *
+ * src A pointer to the data to be copied.
+ *
+ * len The number of bytes to copy.
+ *
+ * Return:  The Internet checksum of the data.
+ */
+
+extern uint16_t uip_chksumcopy(FAR void *dest, FAR const void *src,
+                               uint16_t len);
+
+/* Architecture-specific checksum support.
+ *
+ * If CONFIG_ARCH_CHKSUM is selected, then the architecture provides an
+ * optimized (typically assembly language) up_chksum() that is used for all
+ * of the IP, ICMP, TCP, and UDP checksums.
+ *
+ * up_chksum() adds the 16-bit one's complement sum of 'len' bytes of data
+ * to 'sum' and returns the result.  The data is treated as a sequence of
+ * big endian 16-bit words; if 'len' is odd, the last byte is padded with
+ * zero.  'data' may have any alignment.  Both 'sum' and the returned sum
+ * are in host byte order.
+ */
+
+#ifdef CONFIG_ARCH_CHKSUM
+extern uint16_t up_chksum(uint16_t sum, FAR const uint8_t *data,
+                          uint16_t len);
+#endif
+
 /* Calculate the IP header checksum of the packet header in d_buf.
  *
  * The IP header checksum is the Internet checksum of the 20 bytes of
@@ -49,6 +49,7 @@
 #include <nuttx/compiler.h>
 
 #include <stdint.h>
+#include <queue.h>
 
 #include <net/ethernet.h>
 #include <net/uip/uipopt.h>
@@ -80,15 +81,29 @@ struct uip_eth_hdr
   uint16_t type;    /* Type code (2 bytes) */
 };
 
-/* One entry in the ARP table (volatile!) */
+/* One entry in the ARP table (volatile!).  Entries are found through a hash
+ * table keyed on the IP address.  Each entry in use is also kept in one of
+ * two lists, oldest first:  The entries with a known hardware address and
+ * the entries that are waiting for an ARP reply.  Then only the entries at
+ * the head of the lists need to be checked for expiration.
+ */
 
 struct arp_entry
 {
+  dq_entry_t        at_node;     /* Supports a doubly linked list */
+  FAR struct arp_entry *at_flink; /* Next entry in the hash chain */
   in_addr_t         at_ipaddr;   /* IP address */
   struct ether_addr at_ethaddr;  /* Hardware address */
-  uint8_t           at_time;
+  uint32_t          at_time;     /* Time of the last update */
+  uint8_t           at_flags;    /* See ARP_FLAG_* definitions */
+#if CONFIG_NET_ARP_NPENDING > 0
+  uint8_t           at_npending; /* Number of packets in at_pending */
+  sq_queue_t        at_pending;  /* Packets waiting for the ARP reply */
+#endif
 };
 
+#define ARP_FLAG_PENDING (1 << 0) /* Waiting for an ARP reply */
+
 /****************************************************************************
  * Public Data
  ****************************************************************************/
@@ -160,9 +175,11 @@ EXTERN void uip_arp_arpin(struct uip_driver_s *dev);
  *   address filled in if an ARP table entry for the destination IP
  *   address (or the IP address of the default router) is present. If no
  *   such table entry is found, the IP packet is overwritten with an ARP
- *   request and we rely on TCP to retransmit the packet that was
- *   overwritten. In any case, the d_len field holds the length of
- *   the Ethernet frame that should be transmitted.
+ *   request.  A copy of the IP packet is held until the ARP reply is
+ *   received (see CONFIG_NET_ARP_NPENDING); otherwise we rely on TCP to
+ *   retransmit the packet that was overwritten. In any case, the d_len
+ *   field holds the length of the Ethernet frame that should be
+ *   transmitted.
  *
  ****************************************************************************/
 
@@ -174,8 +191,8 @@ EXTERN void uip_arp_out(struct uip_driver_s *dev);
  * Description:
  *   This function performs periodic timer processing in the ARP module
  *   and should be called at regular intervals. The recommended interval
- *   is 10 seconds between the calls.  It is responsible for flushing old
- *   entries in the ARP table.
+ *   is 10 seconds between the calls.  It only advances the ARP time; old
+ *   entries are flushed from the ARP table when the table is next used.
  *
  ****************************************************************************/
 
@@ -203,7 +220,8 @@ EXTERN void uip_arp_update(uint16_t *pipaddr, uint8_t *ethaddr);
  * Name: uip_arp_find
  *
  * Description:
- *   Find the ARP entry corresponding to this IP address.
+ *   Find the ARP entry corresponding to this IP address.  Entries that are
+ *   still waiting for an ARP reply are not returned.
  *
  * Input parameters:
  *   ipaddr - Refers to an IP address in network order
@@ -230,14 +248,7 @@ EXTERN struct arp_entry *uip_arp_find(in_addr_t ipaddr);
  *
  ****************************************************************************/
 
-#define uip_arp_delete(ipaddr) \
-{ \
-  struct arp_entry *tabptr = uip_arp_find(ipaddr); \
-  if (tabptr) \
-    { \
-      tabptr->at_ipaddr = 0; \
-    } \
-}
+EXTERN void uip_arp_delete(in_addr_t ipaddr);
 
 #else /* CONFIG_NET_ARP */
 
@@ -0,0 +1,185 @@
+/****************************************************************************
+ * include/net/uip/uip-iob.h
+ * I/O buffer chains for the uIP stack.
+ *
+ *   Copyright (C) 2012 Gregory Nutt. All rights reserved.
+ *   Author: Gregory Nutt <gnutt@nuttx.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name NuttX nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+#ifndef __NET_UIP_UIP_IOB_H
+#define __NET_UIP_UIP_IOB_H
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <stdint.h>
+#include <queue.h>
+
+#include <net/uip/uipopt.h>
+
+#if CONFIG_NET_NIOBS > 0
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Public Type Definitions
+ ****************************************************************************/
+
+/* One I/O buffer.  A packet (or any other stream of bytes) is held in a
+ * chain of I/O buffers linked by io_flink.  Only the first buffer of the
+ * chain holds the total length of the chain and only the first buffer is
+ * used to queue the chain (for example, in a list of received datagrams).
+ *
+ * The valid data in each buffer begins io_offset bytes into io_data[].
+ * Trimming data from the beginning of a chain just advances io_offset so
+ * no data is ever moved.
+ */
+
+struct uip_iob_s
+{
+  sq_entry_t io_link;             /* Supports a queue of I/O buffer chains */
+  FAR struct uip_iob_s *io_flink; /* Next I/O buffer in this chain */
+  uint16_t io_len;                /* Length of the data in this buffer */
+  uint16_t io_offset;             /* Offset to the beginning of the data */
+  uint16_t io_pktlen;             /* Total length of the chain (first only) */
+  uint8_t  io_data[CONFIG_NET_IOB_BUFSIZE];
+};
+
+/****************************************************************************
+ * Public Function Prototypes
+ ****************************************************************************/
+
+#undef EXTERN
+#if defined(__cplusplus)
+#define EXTERN extern "C"
+extern "C" {
+#else
+#define EXTERN extern
+#endif
+
+/****************************************************************************
+ * Function: uip_ioballoc
+ *
+ * Description:
+ *   Take one empty I/O buffer from the pool.  This does not wait and may be
+ *   called from interrupt level.
+ *
+ * Returned Value:
+ *   The I/O buffer or NULL if the pool is empty.
+ *
+ ****************************************************************************/
+
+EXTERN FAR struct uip_iob_s *uip_ioballoc(void);
+
+/****************************************************************************
+ * Function: uip_iobfree
+ *
+ * Description:
+ *   Return one I/O buffer to the pool.
+ *
+ * Returned Value:
+ *   The next I/O buffer in the chain (if any).
+ *
+ ****************************************************************************/
+
+EXTERN FAR struct uip_iob_s *uip_iobfree(FAR struct uip_iob_s *iob);
+
+/****************************************************************************
+ * Function: uip_iobfreechain
+ *
+ * Description:
+ *   Return every I/O buffer of a chain to the pool.
+ *
+ ****************************************************************************/
+
+EXTERN void uip_iobfreechain(FAR struct uip_iob_s *iob);
+
+/****************************************************************************
+ * Function: uip_iobcopyin
+ *
+ * Description:
+ *   Copy 'len' bytes of data into the chain beginning at 'offset' bytes
+ *   from the start of the chain.  'offset' may not be beyond the end of the
+ *   data already in the chain.  More I/O buffers are added to the end of
+ *   the chain as necessary.
+ *
+ * Returned Value:
+ *   Zero on success; -ENOMEM if the pool ran out of I/O buffers (the data
+ *   that did fit is kept in the chain).
+ *
+ ****************************************************************************/
+
+EXTERN int uip_iobcopyin(FAR struct uip_iob_s *iob, FAR const uint8_t *src,
+                         unsigned int len, unsigned int offset);
+
+/****************************************************************************
+ * Function: uip_iobcopyout
+ *
+ * Description:
+ *   Copy up to 'len' bytes of data from the chain, beginning 'offset' bytes
+ *   from the start of the chain, into a linear buffer.
+ *
+ * Returned Value:
+ *   The number of bytes copied.
+ *
+ ****************************************************************************/
+
+EXTERN unsigned int uip_iobcopyout(FAR uint8_t *dest,
+                                   FAR const struct uip_iob_s *iob,
+                                   unsigned int len, unsigned int offset);
+
+/****************************************************************************
+ * Function: uip_iobtrimhead
+ *
+ * Description:
+ *   Remove 'trimlen' bytes from the beginning of the chain.  I/O buffers
+ *   that become empty are returned to the pool.
+ *
+ * Returned Value:
+ *   The new head of the chain or NULL if the whole chain was freed.
+ *
+ ****************************************************************************/
+
+EXTERN FAR struct uip_iob_s *uip_iobtrimhead(FAR struct uip_iob_s *iob,
+                                             unsigned int trimlen);
+
+#undef EXTERN
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* CONFIG_NET_NIOBS > 0 */
+#endif /* __NET_UIP_UIP_IOB_H */
@@ -73,8 +73,10 @@
 #define TCP_OPT_END     0   /* End of TCP options list */
 #define TCP_OPT_NOOP    1   /* "No-operation" TCP option */
 #define TCP_OPT_MSS     2   /* Maximum segment size TCP option */
+#define TCP_OPT_WS      3   /* Window scale TCP option */
 
 #define TCP_OPT_MSS_LEN 4   /* Length of TCP MSS option. */
+#define TCP_OPT_WS_LEN  3   /* Length of TCP window scale option. */
 
 /* The TCP states used in the struct uip_conn tcpstateflags field */
 
@@ -92,6 +94,12 @@
 #define UIP_STOPPED     0x10 /* Bit 4: stopped */
                              /* Bit 5-7: Unused, but not available */
 
+/* Bits used in the struct uip_conn ackflags field */
+
+#define UIP_ACKNOW      0x01 /* Send an ACK (window update) at the next poll */
+#define UIP_WSOPT       0x02 /* The peer sent the window scale option */
+#define UIP_RCVWAIT     0x04 /* A recv() is waiting for data */
+
 /* Flag bits in 16-bit flags+ipoffset IPv4 TCP header field */
 
 #define UIP_TCPFLAG_RESERVED  0x8000
@@ -108,6 +116,16 @@
  * Public Type Definitions
  ****************************************************************************/
 
+/* A TCP window size.  With window scaling, windows may be larger than the
+ * 16-bit window field of the TCP header.
+ */
+
+#ifdef CONFIG_NET_TCP_WINDOW_SCALE
+typedef uint32_t uip_tcpwnd_t;
+#else
+typedef uint16_t uip_tcpwnd_t;
+#endif
+
 /* Representation of a uIP TCP connection.
  *
  * The uip_conn structure is used for identifying a connection. All
@@ -120,6 +138,7 @@
 struct uip_driver_s;      /* Forward reference */
 struct uip_callback_s;    /* Forward reference */
 struct uip_backlog_s;     /* Forward reference */
+struct uip_iob_s;         /* Forward reference */
 
 struct uip_conn
 {
@@ -129,8 +148,16 @@ struct uip_conn
   uint16_t rport;         /* The remoteTCP port, in network byte order */
   uint8_t  rcvseq[4];     /* The sequence number that we expect to
                            * receive next */
-  uint8_t  sndseq[4];     /* The sequence number that was last sent by us */
+  uint8_t  sndseq[4];     /* The oldest sequence number not yet ACKed by
+                           * the peer */
+  uint8_t  rttseq[4];     /* The sequence number whose ACK completes the
+                           * current round-trip time measurement */
   uint16_t unacked;       /* Number bytes sent but not yet ACKed */
+  uint16_t sent;          /* Number of data bytes after sndseq that have
+                           * been sent since the last retransmission.  New
+                           * data is sent at sndseq + sent */
+  uip_tcpwnd_t sndwnd;    /* The receive window advertised by the peer */
+  uip_tcpwnd_t rcvwnd;    /* The receive window that we last advertised */
   uint16_t mss;           /* Current maximum segment size for the
                            * connection */
   uint16_t initialmss;    /* Initial maximum segment size for the
@@ -145,6 +172,38 @@ struct uip_conn
   uint8_t  timer;         /* The retransmission timer (units: half-seconds) */
   uint8_t  nrtx;          /* The number of retransmissions for the last
                            * segment sent */
+  uint8_t  rtt;           /* Round-trip time measurement in progress (units:
+                           * half-seconds plus one; zero if none) */
+  uint8_t  dupacks;       /* Number of consecutive duplicate ACKs */
+  uint8_t  ackflags;      /* See UIP_ACKNOW, UIP_WSOPT, UIP_RCVWAIT */
+#ifdef CONFIG_NET_TCP_WINDOW_SCALE
+  uint8_t  sndscale;      /* Scale (shift) of the windows sent by the peer */
+  uint8_t  rcvscale;      /* Scale (shift) of the windows that we send */
+#endif
+#ifdef CONFIG_NET_TCP_DELAYED_ACK
+  uint16_t rcvunacked;    /* Number of bytes received but not yet ACKed */
+  uint32_t acktime;       /* Time (system ticks) when the delayed ACK is due */
+#endif
+
+  /* With CONFIG_NET_NOINTS, the send queue and the read-ahead buffers below
+   * are protected by this lock instead of by uip_lock() so that send() and
+   * recv() can copy data without holding up the rest of the network.
+   */
+
+#ifdef CONFIG_NET_NOINTS
+  struct uip_mutex_s lock;
+#endif
+
+  /* Send queue.
+   *
+   * sndq - A chain of I/O buffers holding the data that send() has queued
+   *   but that the peer has not yet acknowledged.  The first byte of the
+   *   chain is at sequence number sndseq.
+   */
+
+#if CONFIG_NET_TCP_SENDQSIZE > 0
+  FAR struct uip_iob_s *sndq;
+#endif
 
   /* Read-ahead buffering.
    *
@@ -171,6 +230,21 @@ struct uip_conn
   struct uip_backlog_s *backlog;
 #endif
 
+  /* Hash table support.  Each chain links connections whose keys have the
+   * same hash value.
+   *
+   *   hflink - The next active connection in the chain of the hash of the
+   *     local port, the remote port and the remote address.
+   *   pflink - The next connection in the chain of the hash of the local
+   *     port.  Every connection that holds a local port is in this table.
+   *   lflink - The next listening connection in the chain of the hash of
+   *     the local port.
+   */
+
+  struct uip_conn      *hflink;
+  struct uip_conn      *pflink;
+  struct uip_conn      *lflink;
+
   /* Application callbacks:
    *
    * Data transfer events are retained in 'list'.  Event handlers in 'list'
@@ -309,7 +383,7 @@ struct uip_tcpip_hdr
   uint8_t  wnd[2];
   uint16_t tcpchksum;
   uint8_t  urgp[2];
-  uint8_t  optdata[4];
+  uint8_t  optdata[8];
 };
 
 /****************************************************************************
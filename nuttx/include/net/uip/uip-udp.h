@@ -52,6 +52,8 @@
 #include <nuttx/config.h>
 
 #include <stdint.h>
+#include <stdbool.h>
+#include <queue.h>
 #include <net/uip/uipopt.h>
 
 /****************************************************************************
@@ -79,11 +81,54 @@ struct uip_udp_conn
   uint16_t rport;         /* The remote port number in network byte order */
   uint8_t  ttl;           /* Default time-to-live */
   uint8_t  crefs;         /* Reference counts on this instance */
+  bool     active;        /* True: In the list of active connections */
+
+  /* Every connection that holds a local port is kept in a hash table keyed
+   * on the local port.  hflink links the connections in one chain of that
+   * table.
+   */
+
+  struct uip_udp_conn *hflink;
 
   /* Defines the list of UDP callbacks */
 
   struct uip_callback_s *list;
+
+  /* With CONFIG_NET_NOINTS, the read-ahead queue below is protected by this
+   * lock instead of by uip_lock() so that recvfrom() can copy a datagram
+   * without holding up the rest of the network.
+   */
+
+#ifdef CONFIG_NET_NOINTS
+  struct uip_mutex_s lock;
+#endif
+
+  /* Read-ahead buffering.
+   *
+   *   readahead  - A queue of I/O buffer chains (struct uip_iob_s), one for
+   *     each received datagram that has not yet been read.  Each datagram
+   *     begins with a struct uip_udprahdr_s that identifies the sender.
+   *   nreadahead - The number of datagrams in the readahead queue.
+   *
+   * With read-ahead buffering, a connection stays active from the first
+   * uip_udpenable() until it is freed.
+   */
+
+#if CONFIG_NET_UDP_NREADAHEAD > 0
+  sq_queue_t readahead;   /* Read-ahead buffering */
+  uint8_t  nreadahead;    /* Number of datagrams in the readahead queue */
+#endif
+};
+
+/* Each datagram in the UDP read-ahead queue begins with this header */
+
+#if CONFIG_NET_UDP_NREADAHEAD > 0
+struct uip_udprahdr_s
+{
+  uip_ipaddr_t ripaddr;   /* The IP address of the sender */
+  uint16_t rport;         /* The port of the sender in network byte order */
 };
+#endif
 
 /* The UDP and IP headers */
 
@@ -55,6 +55,7 @@
 #include <queue.h>
 
 #ifdef CONFIG_NET_NOINTS
+#  include <sys/types.h>
 #  include <semaphore.h>
 #endif
 
@@ -225,6 +226,27 @@ struct uip_callback_s
   uint16_t flags;
 };
 
+/* Describes a re-entrant uIP lock.  With CONFIG_NET_NOINTS, the global
+ * network lock, the lock of each device and the lock of each connection are
+ * all of this type.
+ *
+ *   um_sem    - The underlying semaphore
+ *   um_holder - The ID of the thread that holds the lock (or -1)
+ *   um_count  - The number of times that the holder has taken the lock
+ *   um_waits  - The contention counter to increment each time that a
+ *               thread must wait for the lock (may be NULL)
+ */
+
+#ifdef CONFIG_NET_NOINTS
+struct uip_mutex_s
+{
+  sem_t    um_sem;
+  pid_t    um_holder;
+  uint16_t um_count;
+  FAR uip_stats_t *um_waits;
+};
+#endif
+
 /* Protocol-specific support */
 
 #ifdef CONFIG_NET_TCP
@@ -264,6 +286,19 @@ struct uip_ip_stats_s
                              were neither ICMP, UDP nor TCP */
 };
 
+/* Lock contention statistics.  Each counts the number of times that a
+ * thread had to wait for a lock held by another thread.
+ */
+
+#ifdef CONFIG_NET_NOINTS
+struct uip_lock_stats_s
+{
+  uip_stats_t stack;      /* Waits for the global network lock */
+  uip_stats_t device;     /* Waits for a device lock */
+  uip_stats_t conn;       /* Waits for a connection lock */
+};
+#endif
+
 struct uip_stats
 {
   struct uip_ip_stats_s   ip;   /* IP statistics */
@@ -283,6 +318,10 @@ struct uip_stats
 #ifdef CONFIG_NET_UDP
   struct uip_udp_stats_s  udp;  /* UDP statistics */
 #endif
+
+#ifdef CONFIG_NET_NOINTS
+  struct uip_lock_stats_s lock; /* Lock contention statistics */
+#endif
 };
 #endif /* CONFIG_NET_STATISTICS */
 
@@ -328,18 +367,53 @@ extern void uip_setipid(uint16_t id);
  * uip_lock_t       -- Not used.  Only for compatibility
  * uip_lockinit()   -- Initializes an underlying semaphore/mutex
  * uip_lock()       -- Takes the semaphore().  Implements a re-entrant mutex.
+ * uip_trylock()    -- Takes the semaphore() only if that can be done
+ *                     without waiting.  Returns OK if it was taken.
  * uip_unlock()     -- Gives the semaphore().
  * uip_lockedwait() -- Like pthread_cond_wait(); releases the semaphore
  *                     momemtarily to wait on another semaphore()
+ *
+ * uip_lock() protects the protocol state:  the connection tables, the TCP
+ * state machines, the callback lists, ARP and IGMP.  uip_input(), uip_poll()
+ * and uip_timer() take it themselves, so a driver need only hold the lock
+ * of its own device (see uip-arch.h).  The data buffered in a connection
+ * (read-ahead and send queues) is protected by a lock in the connection so
+ * that recv() and send() can copy data without holding uip_lock():
+ *
+ * uip_mutexinit()  -- Initialize a lock, giving the contention counter to
+ *                     increment when a thread has to wait for it.
+ * uip_mutexlock()  -- Take a lock.  Locks are re-entrant.
+ * uip_mutexunlock()-- Release a lock.
+ * uip_connlock()   -- Take the lock of a TCP or UDP connection.
+ * uip_connunlock() -- Release the lock of a TCP or UDP connection.
+ *
+ * Locks are always taken in the order device, uip_lock(), connection.  The
+ * connection lock may be taken alone but uip_lock() must not be taken while
+ * holding it.  uip_lockedwait() may not be called with a connection lock
+ * held.
  */
 
 typedef uint8_t uip_lock_t; /* Not really used */
 
+#ifdef CONFIG_NET_STATISTICS
+#  define UIP_LOCKSTAT(n)     (&uip_stat.lock.n)
+#else
+#  define UIP_LOCKSTAT(n)     NULL
+#endif
+
 extern void uip_lockinit(void);
 extern uip_lock_t uip_lock(void);
+extern int uip_trylock(void);
 extern void uip_unlock(uip_lock_t flags);
 extern int uip_lockedwait(sem_t *sem);
 
+extern void uip_mutexinit(FAR struct uip_mutex_s *mutex, FAR uip_stats_t *waits);
+extern uip_lock_t uip_mutexlock(FAR struct uip_mutex_s *mutex);
+extern void uip_mutexunlock(FAR struct uip_mutex_s *mutex, uip_lock_t flags);
+
+#  define uip_connlock(c)     uip_mutexlock(&(c)->lock)
+#  define uip_connunlock(c,f) uip_mutexunlock(&(c)->lock, f)
+
 #else
 
 /* Enable/disable locking for interrupt based logic:
@@ -349,13 +423,17 @@ extern int uip_lockedwait(sem_t *sem);
  * uip_lock()       -- Disables interrupts.
  * uip_unlock()     -- Conditionally restores interrupts.
  * uip_lockedwait() -- Just wait for the semaphore.
+ * uip_connlock()   -- Disables interrupts.
+ * uip_connunlock() -- Conditionally restores interrupts.
  */
 
-#  define uip_lock_t        irqstate_t
+#  define uip_lock_t          irqstate_t
 #  define uip_lockinit()
-#  define uip_lock()        irqsave()
-#  define uip_unlock(f)     irqrestore(f)
-#  define uip_lockedwait(s) sem_wait(s)
+#  define uip_lock()          irqsave()
+#  define uip_unlock(f)       irqrestore(f)
+#  define uip_lockedwait(s)   sem_wait(s)
+#  define uip_connlock(c)     irqsave()
+#  define uip_connunlock(c,f) irqrestore(f)
 
 #endif
 
@@ -390,6 +468,19 @@ extern int uip_lockedwait(sem_t *sem);
 
 extern void uip_send(struct uip_driver_s *dev, const void *buf, int len);
 
+/* Send a segment of TCP data without copying it into the packet buffer.
+ *
+ * This is like uip_send() except that the data is only referenced.  The
+ * network driver sends it from 'buf' after the headers in d_buf.  The
+ * caller must keep the data unchanged until it is acknowledged by the
+ * peer because retransmissions are sent from the same buffer.  Only
+ * available with CONFIG_NET_SGSEND.
+ */
+
+#ifdef CONFIG_NET_SGSEND
+extern void uip_sgsend(struct uip_driver_s *dev, FAR const void *buf, int len);
+#endif
+
 /* uIP convenience and converting functions.
  *
  * These functions can be used for converting between different data
@@ -170,6 +170,27 @@
 
 #define UIP_UDP_MSS (CONFIG_NET_BUFSIZE - UIP_LLH_LEN - UIP_IPUDPH_LEN)
 
+/* The maximum number of received datagrams that may be queued in I/O
+ * buffers for a UDP connection while no recvfrom() is waiting.  Zero
+ * disables UDP read-ahead (requires CONFIG_NET_NIOBS > 0).
+ */
+
+#ifndef CONFIG_NET_UDP_NREADAHEAD
+# define CONFIG_NET_UDP_NREADAHEAD 0
+#endif
+
+/* The number of buckets in the hash table used to find the UDP connection
+ * for a received datagram.  Must be a power of two.
+ */
+
+#ifndef CONFIG_NET_UDP_NHASH
+# define CONFIG_NET_UDP_NHASH 8
+#endif
+
+#if (CONFIG_NET_UDP_NHASH & (CONFIG_NET_UDP_NHASH - 1)) != 0
+#  error "CONFIG_NET_UDP_NHASH must be a power of two"
+#endif
+
 /* TCP configuration options */
 
 /* The maximum number of simultaneously open TCP connections.
@@ -196,6 +217,19 @@
 # define CONFIG_NET_MAX_LISTENPORTS 20
 #endif
 
+/* The number of buckets in the hash tables used to find the TCP connection
+ * for a received segment and the listener on a local port.  Must be a power
+ * of two.
+ */
+
+#ifndef CONFIG_NET_TCP_NHASH
+# define CONFIG_NET_TCP_NHASH 16
+#endif
+
+#if (CONFIG_NET_TCP_NHASH & (CONFIG_NET_TCP_NHASH - 1)) != 0
+#  error "CONFIG_NET_TCP_NHASH must be a power of two"
+#endif
+
 /* Define the maximum number of concurrently active UDP and TCP
  * ports.  This number must be greater than the number of open
  * sockets in order to support multi-threaded read/write operations.
@@ -205,12 +239,25 @@
 # define CONFIG_NET_NACTIVESOCKETS (CONFIG_NET_TCP_CONNS + CONFIG_NET_UDP_CONNS)
 #endif
 
-/* The initial retransmission timeout counted in timer pulses.
+/* The initial retransmission timeout counted in timer pulses.  After the
+ * first round-trip time measurement, each connection uses its own estimate
+ * of the retransmission timeout, kept between UIP_RTO_MIN and UIP_RTO_MAX.
  *
  * This should not be changed.
  */
 
-#define UIP_RTO 3
+#define UIP_RTO     3
+#define UIP_RTO_MIN 2
+#define UIP_RTO_MAX 120
+
+/* The number of duplicate ACKs that cause the first unacknowledged segment
+ * to be retransmitted without waiting for the retransmission timeout
+ * (fast retransmit).
+ *
+ * This should not need to be changed.
+ */
+
+#define UIP_FASTREXMIT_NDUPACKS 3
 
 /* The maximum number of times a segment should be retransmitted
  * before the connection should be aborted.
@@ -246,6 +293,58 @@
 # define CONFIG_NET_RECEIVE_WINDOW UIP_TCP_MSS
 #endif
 
+/* Window scaling (RFC 1323).  A receive window larger than 65535 bytes can
+ * only be advertised if CONFIG_NET_TCP_WINDOW_SCALE is selected and the
+ * peer agrees to use the window scale option.  UIP_RCVWND_SHIFT is the
+ * scale factor that we offer: The smallest shift that makes the receive
+ * window fit into the 16-bit window field.
+ */
+
+#ifdef CONFIG_NET_TCP_WINDOW_SCALE
+# if CONFIG_NET_RECEIVE_WINDOW <= 0xffff
+#   define UIP_RCVWND_SHIFT 0
+# elif CONFIG_NET_RECEIVE_WINDOW <= 0x1fffe
+#   define UIP_RCVWND_SHIFT 1
+# elif CONFIG_NET_RECEIVE_WINDOW <= 0x3fffc
+#   define UIP_RCVWND_SHIFT 2
+# elif CONFIG_NET_RECEIVE_WINDOW <= 0x7fff8
+#   define UIP_RCVWND_SHIFT 3
+# elif CONFIG_NET_RECEIVE_WINDOW <= 0xffff0
+#   define UIP_RCVWND_SHIFT 4
+# elif CONFIG_NET_RECEIVE_WINDOW <= 0x1fffe0
+#   define UIP_RCVWND_SHIFT 5
+# elif CONFIG_NET_RECEIVE_WINDOW <= 0x3fffc0
+#   define UIP_RCVWND_SHIFT 6
+# elif CONFIG_NET_RECEIVE_WINDOW <= 0x7fff80
+#   define UIP_RCVWND_SHIFT 7
+# else
+#   error "CONFIG_NET_RECEIVE_WINDOW is too large"
+# endif
+#elif CONFIG_NET_RECEIVE_WINDOW > 0xffff
+# error "CONFIG_NET_RECEIVE_WINDOW > 65535 requires CONFIG_NET_TCP_WINDOW_SCALE"
+#endif
+
+/* Delayed ACK.  If CONFIG_NET_TCP_DELAYED_ACK is selected, received data is
+ * not acknowledged segment by segment.  The ACK is sent with the next
+ * outgoing segment, after every second full-sized segment, or else by the
+ * first poll after CONFIG_NET_TCP_DELACK_MSEC milliseconds have elapsed.
+ */
+
+#ifndef CONFIG_NET_TCP_DELACK_MSEC
+# define CONFIG_NET_TCP_DELACK_MSEC 200
+#endif
+
+/* The maximum number of data segments that one TCP connection may send
+ * each time that it is polled by the network driver.  With a value of one,
+ * a sending connection has at most one new segment in flight per poll.
+ * Larger values let send() keep more segments in flight on fast links.
+ * The data in flight is always limited by the peer's receive window.
+ */
+
+#ifndef CONFIG_NET_TCP_SNDBURST
+# define CONFIG_NET_TCP_SNDBURST 1
+#endif
+
 /* How long a connection should stay in the TIME_WAIT state.
  *
  * This configiration option has no real implication, and it should be
@@ -274,6 +373,35 @@
 
 #define UIP_ARP_MAXAGE 120
 
+/* The maximum age of an ARP table entry whose address has not yet been
+ * resolved, in units of the ARP timer (10 seconds).
+ */
+
+#define UIP_ARP_MAXPENDING 2
+
+/* The number of buckets in the hash table used to find the ARP table entry
+ * for an IP address.  Must be a power of two.
+ */
+
+#ifndef CONFIG_NET_ARP_NHASH
+# define CONFIG_NET_ARP_NHASH 16
+#endif
+
+#if (CONFIG_NET_ARP_NHASH & (CONFIG_NET_ARP_NHASH - 1)) != 0
+#  error "CONFIG_NET_ARP_NHASH must be a power of two"
+#endif
+
+/* The maximum number of outgoing packets that are held in I/O buffers for
+ * each destination while its hardware address is being resolved.  They are
+ * sent when the ARP reply is received.  With zero, the packet that caused
+ * the ARP request is lost and must be retransmitted by the higher level
+ * protocol (requires CONFIG_NET_NIOBS > 0).
+ */
+
+#ifndef CONFIG_NET_ARP_NPENDING
+# define CONFIG_NET_ARP_NPENDING 2
+#endif
+
 /* General configuration options */
 
 /* The size of the uIP packet buffer.
@@ -287,6 +415,54 @@
 # define CONFIG_NET_BUFSIZE 400
 #endif
 
+/* I/O buffers.  These are small buffers that may be chained together to
+ * hold packets and packet data outside of the device packet buffer.  All
+ * users share one pool of CONFIG_NET_NIOBS buffers (may be zero).
+ */
+
+#ifndef CONFIG_NET_NIOBS
+# define CONFIG_NET_NIOBS 0
+#endif
+
+#ifndef CONFIG_NET_IOB_BUFSIZE
+# define CONFIG_NET_IOB_BUFSIZE 196
+#endif
+
+#if CONFIG_NET_NIOBS == 0 || !defined(CONFIG_NET_UDP)
+#  undef  CONFIG_NET_UDP_NREADAHEAD
+#  define CONFIG_NET_UDP_NREADAHEAD 0
+#endif
+
+#if CONFIG_NET_NIOBS == 0 || !defined(CONFIG_NET_ARP)
+#  undef  CONFIG_NET_ARP_NPENDING
+#  define CONFIG_NET_ARP_NPENDING 0
+#endif
+
+/* The maximum number of bytes that send() may queue in I/O buffers for one
+ * TCP connection.  Queued data is sent as the peer's window allows and is
+ * kept until it is acknowledged so that the network can retransmit it
+ * without the help of the application.  Zero (the default) disables the
+ * send queue:  send() then waits until all of its data has been
+ * acknowledged.  Requires CONFIG_NET_NIOBS > 0.
+ */
+
+#ifndef CONFIG_NET_TCP_SENDQSIZE
+# define CONFIG_NET_TCP_SENDQSIZE 0
+#endif
+
+#if CONFIG_NET_NIOBS == 0 || !defined(CONFIG_NET_TCP)
+#  undef  CONFIG_NET_TCP_SENDQSIZE
+#  define CONFIG_NET_TCP_SENDQSIZE 0
+#endif
+
+/* The number of queued bytes is tracked in the 16-bit sent and unacked
+ * fields of struct uip_conn.
+ */
+
+#if CONFIG_NET_TCP_SENDQSIZE > 65535
+#  error "CONFIG_NET_TCP_SENDQSIZE must not exceed 65535"
+#endif
+
 /* Number of TCP read-ahead buffers (may be zero) */
 
 #ifndef CONFIG_NET_NTCP_READAHEAD_BUFFERS
@@ -46,6 +46,7 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include <sched.h>
+#include <time.h>
 #include <arch/arch.h>
 
 /****************************************************************************
@@ -500,6 +501,39 @@ EXTERN char up_romgetc(FAR const char *ptr);
 EXTERN void up_mdelay(unsigned int milliseconds);
 EXTERN void up_udelay(useconds_t microseconds);
 
+/****************************************************************************
+ * Tickless mode interval timer interfaces
+ *
+ * Description:
+ *   If CONFIG_SCHED_TICKLESS is selected, then there is no periodic timer
+ *   interrupt and sched_process_timer() is not used.  Instead, the
+ *   platform-specific logic must provide a free-running time base and a
+ *   one-shot interval timer:
+ *
+ *   up_timer_initialize() - Initialize the time base and the interval
+ *     timer.  This is called by the OS from clock_initialize().
+ *   up_timer_gettime() - Return the elapsed time since the time base was
+ *     initialized.
+ *   up_timer_cancel() - Stop the interval timer (if it is running) and
+ *     return the time that remained before it would have expired (zero if
+ *     it was not running).
+ *   up_timer_start() - Start the interval timer so that it expires after
+ *     the provided interval.  A zero interval should expire as soon as
+ *     possible.  On expiration, the platform-specific logic must call
+ *     sched_timer_expiration().
+ *
+ *   All but up_timer_initialize() may be called from interrupt handlers and
+ *   with interrupts disabled.
+ *
+ ***************************************************************************/
+
+#ifdef CONFIG_SCHED_TICKLESS
+EXTERN void up_timer_initialize(void);
+EXTERN int up_timer_gettime(FAR struct timespec *ts);
+EXTERN int up_timer_cancel(FAR struct timespec *ts);
+EXTERN int up_timer_start(FAR const struct timespec *ts);
+#endif
+
 /****************************************************************************
  * These are standard interfaces that are exported by the OS
  * for use by the architecture specific logic
@@ -517,7 +551,23 @@ EXTERN void up_udelay(useconds_t microseconds);
  *
  ****************************************************************************/
 
+#ifndef CONFIG_SCHED_TICKLESS
 EXTERN void sched_process_timer(void);
+#endif
+
+/****************************************************************************
+ * Name: sched_timer_expiration
+ *
+ * Description:
+ *   If CONFIG_SCHED_TICKLESS is selected, this function must be called by
+ *   the architecture-specific logic when the interval timer started by
+ *   up_timer_start() expires.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_SCHED_TICKLESS
+EXTERN void sched_timer_expiration(void);
+#endif
 
 /****************************************************************************
  * Name: irq_dispatch
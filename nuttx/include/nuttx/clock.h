@@ -131,10 +131,12 @@
 /* Direct access to the system timer/counter is supported only if (1) the
  * system timer counter is available (i.e., we are not configured to use
  * a hardware periodic timer), and (2) the execution environment has direct
- * access to kernel global data
+ * access to kernel global data.  In the tickless mode (CONFIG_SCHED_TICKLESS)
+ * there is no periodic timer interrupt to increment a counter;  the system
+ * time must always be obtained from the hardware via clock_systimer().
  */
 
-#if __HAVE_KERNEL_GLOBALS
+#if __HAVE_KERNEL_GLOBALS && !defined(CONFIG_SCHED_TICKLESS)
 #  ifdef CONFIG_SYSTEM_TIME64
 
 extern volatile uint64_t g_system_timer;
@@ -179,7 +181,7 @@ extern "C" {
  *
  ****************************************************************************/
 
-#if !__HAVE_KERNEL_GLOBALS
+#if !__HAVE_KERNEL_GLOBALS || defined(CONFIG_SCHED_TICKLESS)
 #  ifdef CONFIG_SYSTEM_TIME64
 #    define clock_systimer()  (uint32_t)(clock_systimer64() & 0x00000000ffffffff)
 #  else
@@ -206,7 +208,8 @@ EXTERN uint32_t clock_systimer(void);
  *
  ****************************************************************************/
 
-#if !__HAVE_KERNEL_GLOBALS && defined(CONFIG_SYSTEM_TIME64)
+#if (!__HAVE_KERNEL_GLOBALS || defined(CONFIG_SCHED_TICKLESS)) && \
+     defined(CONFIG_SYSTEM_TIME64)
 EXTERN uint64_t clock_systimer64(void);
 #endif
 
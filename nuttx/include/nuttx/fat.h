@@ -64,6 +64,19 @@
 
 typedef uint8_t fat_attrib_t;
 
+/* Statistics for the sector cache of one FAT mountpoint.  These are
+ * returned by fat_getcachestats().
+ */
+
+struct fat_cachestats_s
+{
+  uint16_t cs_nsectors;            /* Number of sectors in the cache */
+  uint16_t cs_sectorsize;          /* Size of one cached sector in bytes */
+  uint32_t cs_hits;                /* Accesses that found the sector cached */
+  uint32_t cs_misses;              /* Accesses that read the sector from media */
+  uint32_t cs_writebacks;          /* Dirty sectors written back to media */
+};
+
 /****************************************************************************
  * Public Function Prototypes
  ****************************************************************************/
@@ -80,6 +93,12 @@ extern "C" {
 EXTERN int fat_getattrib(const char *path, fat_attrib_t *attrib);
 EXTERN int fat_setattrib(const char *path, fat_attrib_t setbits, fat_attrib_t clearbits);
 
+/* Non-standard function to get the sector cache statistics of the FAT
+ * mountpoint that contains 'path'
+ */
+
+EXTERN int fat_getcachestats(const char *path, struct fat_cachestats_s *stats);
+
 #undef EXTERN
 #ifdef __cplusplus
 }
@@ -47,6 +47,7 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include <semaphore.h>
+#include <poll.h>
 
 /****************************************************************************
  * Definitions
@@ -98,6 +99,46 @@ struct geometry
   size_t geo_sectorsize;   /* Size of one sector */
 };
 
+/* These structures describe scatter/gather block transfers (see the
+ * BIOC_READSG and BIOC_WRITESG ioctl commands).  Each request transfers a
+ * range of contiguous sectors on the device to or from one or more memory
+ * segments.  Requests may be linked into a chain so that the driver can
+ * set up the next transfer while the current one is still in progress.
+ */
+
+struct block_sg_s
+{
+  FAR uint8_t *buffer;     /* Memory for this segment */
+  size_t nsectors;         /* Number of sectors in this segment */
+};
+
+struct block_sgreq_s
+{
+  FAR struct block_sgreq_s *flink;   /* Next request in the chain (or NULL) */
+  FAR const struct block_sg_s *sg;   /* Memory segments of this request */
+  size_t   startsector;    /* First sector on the device */
+  uint16_t nsg;            /* Number of memory segments */
+  ssize_t  result;         /* Returned: Sectors transferred or negated errno */
+};
+
+/* Statistics for the sector cache of a BCH character driver (see
+ * bchdev_register()).  These are returned by the DIOC_BCHSTATS ioctl
+ * command.
+ */
+
+struct bch_stats_s
+{
+  uint16_t bs_nsectors;    /* Number of sectors in the cache */
+  uint16_t bs_sectorsize;  /* Size of one sector in bytes */
+  uint32_t bs_hits;        /* Partial sector accesses that found the sector cached */
+  uint32_t bs_misses;      /* Partial sector accesses that read from the device */
+  uint32_t bs_readahead;   /* Sectors read ahead of the sector that missed */
+  uint32_t bs_nreads;      /* Read requests to the block driver */
+  uint32_t bs_rdsectors;   /* Sectors read from the block driver */
+  uint32_t bs_nwrites;     /* Write requests to the block driver */
+  uint32_t bs_wrsectors;   /* Sectors written to the block driver */
+};
+
 /* This structure is provided by block devices when they register with the
  * system.  It is used by file systems to perform filesystem transfers.  It
  * differs from the normal driver vtable in several ways -- most notably in
@@ -374,6 +415,17 @@ EXTERN int open_blockdriver(FAR const char *pathname, int mountflags,
 EXTERN int close_blockdriver(FAR struct inode *inode);
 #endif
 
+/* fs_poll.c ****************************************************************/
+
+/* Used by drivers to report events to each of the pollfd structures that
+ * they are holding (NULL entries are ignored).
+ */
+
+#ifndef CONFIG_DISABLE_POLL
+EXTERN void poll_notify(FAR struct pollfd **afds, int nfds,
+                        pollevent_t eventset);
+#endif
+
 /* fs_fdopen.c **************************************************************/
 
 /* Used by the OS to clone stdin, stdout, stderr */
@@ -120,6 +120,13 @@
                                            * OUT: None, reference obtained by
                                            *      FIOC_GETPRIV released.
                                            */
+#define DIOC_BCHSTATS   _DIOC(0x0004)     /* Get BCH sector cache statistics
+                                           * IN:  Pointer to write-able struct
+                                           *      bch_stats_s (see
+                                           *      include/nuttx/fs.h)
+                                           * OUT: Statistics are returned in
+                                           *      the struct
+                                           */
 
 /* NuttX block driver ioctl definitions *************************************/
 
@@ -141,6 +148,38 @@
                                            * IN:  None
                                            * OUT: None (ioctl return value provides
                                            *      success/failure indication). */
+#define BIOC_FTLSTATS   _BIOC(0x0004)     /* Get FTL write and erase statistics
+                                           * IN:  Pointer to write-able struct
+                                           *      ftl_stats_s (see
+                                           *      include/nuttx/mtd.h)
+                                           * OUT: Statistics are returned in
+                                           *      the struct */
+#define BIOC_READSG     _BIOC(0x0005)     /* Scatter/gather read
+                                           * IN:  Pointer to the first struct
+                                           *      block_sgreq_s of a chain of
+                                           *      requests (see
+                                           *      include/nuttx/fs.h)
+                                           * OUT: The result of each request
+                                           *      is returned in the struct */
+#define BIOC_WRITESG    _BIOC(0x0006)     /* Scatter/gather write
+                                           * IN:  Pointer to the first struct
+                                           *      block_sgreq_s of a chain of
+                                           *      requests
+                                           * OUT: The result of each request
+                                           *      is returned in the struct */
+#define BIOC_MMCSDSTATS _BIOC(0x0007)     /* Get MMC/SD transfer statistics
+                                           * IN:  Pointer to write-able struct
+                                           *      mmcsd_stats_s (see
+                                           *      include/nuttx/mmcsd.h)
+                                           * OUT: Statistics are returned in
+                                           *      the struct */
+#define BIOC_RWBSTATS   _BIOC(0x0008)     /* Get read-ahead/write buffer
+                                           * statistics
+                                           * IN:  Pointer to write-able struct
+                                           *      rwb_stats_s (see
+                                           *      include/nuttx/rwbuffer.h)
+                                           * OUT: Statistics are returned in
+                                           *      the struct */
 
 /* NuttX MTD driver ioctl definitions ***************************************/
 
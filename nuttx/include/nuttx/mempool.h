@@ -0,0 +1,222 @@
+/****************************************************************************
+ * include/nuttx/mempool.h
+ *
+ *   Copyright (C) 2012 Gregory Nutt. All rights reserved.
+ *   Author: Gregory Nutt <gnutt@nuttx.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name NuttX nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+#ifndef __INCLUDE_NUTTX_MEMPOOL_H
+#define __INCLUDE_NUTTX_MEMPOOL_H
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/types.h>
+#include <stdint.h>
+#include <queue.h>
+
+/****************************************************************************
+ * Pre-Processor Definitions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Public Types
+ ****************************************************************************/
+
+#ifndef __ASSEMBLY__
+
+/* This describes one pool of fixed-size blocks.  The user only needs this
+ * structure in order to declare instances of the pool.  All fields are
+ * managed by the mempool APIs.
+ *
+ * While a block is free, its first bytes hold the link to the next free
+ * block.  So a block is at least the size of a pointer and the caller's
+ * data in those bytes is lost when the block is freed.
+ */
+
+struct mempool_s
+{
+  FAR struct mempool_s *flink; /* Supports a list of all pools */
+  FAR const char *name;        /* Name of the pool (for inspection) */
+  FAR uint8_t *start;          /* Start of the block storage */
+  sq_queue_t free;             /* List of free blocks */
+  size_t   blocksize;          /* Size of one block */
+  uint16_t nblocks;            /* Total number of blocks in the pool */
+  uint16_t nreserved;          /* Blocks reserved for interrupt handlers */
+  uint16_t nfree;              /* Number of free blocks */
+  uint16_t nminfree;           /* Smallest number of free blocks seen */
+  uint32_t nfailed;            /* Number of failed allocations */
+};
+
+/* This describes the state of a pool as returned by mempool_stat() */
+
+struct mempoolinfo_s
+{
+  FAR const char *name;        /* Name of the pool */
+  size_t   blocksize;          /* Size of one block */
+  uint16_t nblocks;            /* Total number of blocks in the pool */
+  uint16_t nreserved;          /* Blocks reserved for interrupt handlers */
+  uint16_t nfree;              /* Number of free blocks */
+  uint16_t nminfree;           /* Smallest number of free blocks seen */
+  uint32_t nfailed;            /* Number of failed allocations */
+};
+
+/* This is the type of the callback used with mempool_foreach() */
+
+typedef int (*mempool_handler_t)(FAR struct mempool_s *pool, FAR void *arg);
+
+/****************************************************************************
+ * Public Data
+ ****************************************************************************/
+
+#ifdef __cplusplus
+#define EXTERN extern "C"
+extern "C" {
+#else
+#define EXTERN extern
+#endif
+
+/****************************************************************************
+ * Public Function Prototypes
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: mempool_create
+ *
+ * Description:
+ *   Initialize a pool of 'nblocks' blocks of 'blocksize' bytes each and
+ *   add it to the list of pools that can be inspected.  The pools are never
+ *   destroyed.
+ *
+ * Input parameters:
+ *   pool      - The pool structure to initialize
+ *   name      - The name of the pool.  The string is not copied.
+ *   storage   - Memory for all of the blocks (usually a static array of
+ *               the object type).  If NULL, the memory is allocated from
+ *               the heap.
+ *   blocksize - The size of one block.  This should be the sizeof() the
+ *               object type so that every block is properly aligned.
+ *   nblocks   - The number of blocks in the pool
+ *   nreserved - The number of blocks that may only be allocated by
+ *               interrupt handlers.
+ *
+ * Returned Value:
+ *   Zero on success, a negated errno on failure
+ *
+ ****************************************************************************/
+
+EXTERN int mempool_create(FAR struct mempool_s *pool, FAR const char *name,
+                          FAR void *storage, size_t blocksize,
+                          unsigned int nblocks, unsigned int nreserved);
+
+/****************************************************************************
+ * Name: mempool_alloc
+ *
+ * Description:
+ *   Take a block from the pool in constant time.  This does not wait and
+ *   does not use any semaphore so it may be called from interrupt
+ *   handlers.  Only interrupt handlers can take the reserved blocks.
+ *
+ * Input parameters:
+ *   pool - The pool to allocate from
+ *
+ * Returned Value:
+ *   The allocated block or NULL if the pool is empty.
+ *
+ ****************************************************************************/
+
+EXTERN FAR void *mempool_alloc(FAR struct mempool_s *pool);
+
+/****************************************************************************
+ * Name: mempool_free
+ *
+ * Description:
+ *   Return a block to the pool in constant time.  This may be called from
+ *   interrupt handlers.
+ *
+ * Input parameters:
+ *   pool - The pool that the block was allocated from
+ *   blk  - The block to free
+ *
+ * Returned Value:
+ *   None
+ *
+ ****************************************************************************/
+
+EXTERN void mempool_free(FAR struct mempool_s *pool, FAR void *blk);
+
+/****************************************************************************
+ * Name: mempool_stat
+ *
+ * Description:
+ *   Return the current state of the pool.
+ *
+ * Input parameters:
+ *   pool - The pool to inspect
+ *   info - The location to return the state of the pool
+ *
+ * Returned Value:
+ *   None
+ *
+ ****************************************************************************/
+
+EXTERN void mempool_stat(FAR struct mempool_s *pool,
+                         FAR struct mempoolinfo_s *info);
+
+/****************************************************************************
+ * Name: mempool_foreach
+ *
+ * Description:
+ *   Call 'handler' for every pool that has been created, in the order of
+ *   creation, until a handler returns a non-zero value.
+ *
+ * Input parameters:
+ *   handler - The function to call for each pool
+ *   arg     - An argument that is passed to each call of the handler
+ *
+ * Returned Value:
+ *   The non-zero value returned by the handler or zero if the handler
+ *   was called for every pool.
+ *
+ ****************************************************************************/
+
+EXTERN int mempool_foreach(mempool_handler_t handler, FAR void *arg);
+
+#undef EXTERN
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __ASSEMBLY__ */
+#endif /* __INCLUDE_NUTTX_MEMPOOL_H */
@@ -42,11 +42,79 @@
 
 #include <nuttx/config.h>
 #include <sys/types.h>
+#include <stdint.h>
+#include <stdbool.h>
 
 /****************************************************************************
  * Pre-Processor Definitions
  ****************************************************************************/
 
+/* The largest number of bins that mm_freebins() will report */
+
+#define MM_MAXBINS 32
+
+/* Per-task allocation cache.  If CONFIG_MM_TASKCACHE is selected, then
+ * each task keeps a small cache of the chunks that it has recently freed.
+ * There is one list of chunks for each of the CONFIG_MM_TASKCACHE_NCLASSES
+ * smallest chunk sizes and each list holds up to CONFIG_MM_TASKCACHE_DEPTH
+ * chunks.
+ */
+
+#ifdef CONFIG_MM_TASKCACHE
+#  ifndef CONFIG_MM_TASKCACHE_NCLASSES
+#    define CONFIG_MM_TASKCACHE_NCLASSES 8
+#  endif
+#  ifndef CONFIG_MM_TASKCACHE_DEPTH
+#    define CONFIG_MM_TASKCACHE_DEPTH 8
+#  endif
+#  if CONFIG_MM_TASKCACHE_DEPTH > 255
+#    error "CONFIG_MM_TASKCACHE_DEPTH must be less than 256"
+#  endif
+#endif
+
+/****************************************************************************
+ * Public Types
+ ****************************************************************************/
+
+#ifdef CONFIG_MM_TASKCACHE
+/* The allocation cache of one task.  This is a part of the TCB. */
+
+struct mm_taskcache_s
+{
+  FAR void *head[CONFIG_MM_TASKCACHE_NCLASSES];  /* Cached chunks of each size */
+  uint8_t   count[CONFIG_MM_TASKCACHE_NCLASSES]; /* Number of cached chunks */
+  bool      disabled;                            /* The task is exiting */
+};
+#endif
+
+#ifdef CONFIG_MM_TRACE
+/* Describes one allocation for mm_tracewalk() */
+
+struct mm_traceinfo_s
+{
+  FAR void *mem;    /* The allocated memory */
+  size_t    size;   /* Size of the chunk, including the chunk header */
+  pid_t     pid;    /* ID of the task that made the allocation */
+  FAR void *caller; /* Address that the allocation was made from */
+};
+
+/* Called by mm_tracewalk() for each allocation.  A non-zero return value
+ * stops the walk.
+ */
+
+typedef int (*mm_tracehandler_t)(FAR const struct mm_traceinfo_s *info,
+                                 FAR void *arg);
+
+/* Describes the free chunks of one size range for mm_freebins() */
+
+struct mm_freebin_s
+{
+  size_t   minsize; /* Free chunks in this bin are at least this size */
+  uint32_t nchunks; /* Number of free chunks in the bin */
+  size_t   nbytes;  /* Total size of the free chunks in the bin */
+};
+#endif
+
 /****************************************************************************
  * Global Data
  ****************************************************************************/
@@ -75,6 +143,21 @@ EXTERN void   mm_addregion(FAR void *heapstart, size_t heapsize);
 
 EXTERN int mm_trysemaphore(void);
 EXTERN void mm_givesemaphore(void);
+EXTERN void mm_semstats(FAR uint32_t *ntakes, FAR uint32_t *nwaits);
+
+/* Functions contained in mm_taskcache.c ************************************/
+
+#ifdef CONFIG_MM_TASKCACHE
+EXTERN FAR void *mm_cachedrain(FAR struct mm_taskcache_s *cache);
+EXTERN void mm_cacheflush(void);
+#endif
+
+/* Functions contained in mm_trace.c ****************************************/
+
+#ifdef CONFIG_MM_TRACE
+EXTERN int mm_tracewalk(mm_tracehandler_t handler, FAR void *arg);
+EXTERN int mm_freebins(FAR struct mm_freebin_s *bins, int nbins);
+#endif
 
 #undef EXTERN
 #ifdef __cplusplus
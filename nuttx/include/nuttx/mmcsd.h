@@ -41,6 +41,7 @@
  ****************************************************************************/
 
 #include <nuttx/config.h>
+#include <stdint.h>
 
 /****************************************************************************
  * Pre-Processor Definitions
@@ -50,6 +51,25 @@
  * Public Types
  ****************************************************************************/
 
+/* Transfer statistics returned by the BIOC_MMCSDSTATS ioctl command.  The
+ * time is the time that the card was busy with data transfers, so the
+ * sustained transfer rate is blocks * blocksize / (ticks * MSEC_PER_TICK).
+ * The rates in KB/s are calculated this way when the statistics are read.
+ */
+
+struct mmcsd_stats_s
+{
+  uint16_t blocksize;      /* Size of one block in bytes */
+  uint32_t nreads;         /* Number of read commands (CMD17/CMD18) */
+  uint32_t nwrites;        /* Number of write commands (CMD24/CMD25) */
+  uint32_t rdblocks;       /* Number of blocks read */
+  uint32_t wrblocks;       /* Number of blocks written */
+  uint32_t rdticks;        /* System ticks spent reading */
+  uint32_t wrticks;        /* System ticks spent writing */
+  uint32_t rdkbps;         /* Sustained read rate in KB/s */
+  uint32_t wrkbps;         /* Sustained write rate in KB/s */
+};
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
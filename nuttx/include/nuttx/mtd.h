@@ -115,6 +115,26 @@ struct mtd_dev_s
   int (*ioctl)(FAR struct mtd_dev_s *dev, int cmd, unsigned long arg);
 };
 
+/* Statistics returned by the FTL block driver in response to the
+ * BIOC_FTLSTATS ioctl command.  The write amplification is flashwrites /
+ * hostwrites.  Erase counts of individual erase blocks (minerase, maxerase,
+ * and avgerase) are only tracked with CONFIG_FTL_LOGSTRUCT; without it, every
+ * write that is not a whole erase block costs an erase.
+ */
+
+struct ftl_stats_s
+{
+  uint32_t nsectors;    /* Number of logical sectors */
+  uint32_t nfree;       /* Number of free erase blocks */
+  uint32_t hostwrites;  /* Sectors written by the user of the block driver */
+  uint32_t flashwrites; /* Sectors programmed into FLASH */
+  uint32_t hdrwrites;   /* Erase block header (metadata) writes */
+  uint32_t nerases;     /* Erase block erasures */
+  uint32_t minerase;    /* Smallest erase count of any erase block */
+  uint32_t maxerase;    /* Largest erase count of any erase block */
+  uint32_t avgerase;    /* Average erase count of all erase blocks */
+};
+
 /****************************************************************************
  * Public Data
  ****************************************************************************/
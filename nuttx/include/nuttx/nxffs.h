@@ -85,6 +85,27 @@
 #  define CONFIG_NXFFS_TAILTHRESHOLD (8*1024)
 #endif
 
+/* Rather than waiting until the FLASH is completely full and then packing
+ * the entire volume in one long operation, NXFFS packs the volume a little
+ * at a time.  When fewer than CONFIG_NXFFS_PACKSTART bytes of free FLASH
+ * remain at the end of the volume, each new data block allocation first
+ * packs at least CONFIG_NXFFS_PACKSTEP erase blocks worth of inodes (more
+ * if that is needed to finish before the free FLASH is exhausted).  A full
+ * pack is still performed as a last resort.
+ */
+
+#ifndef CONFIG_NXFFS_PACKSTART
+#  define CONFIG_NXFFS_PACKSTART (32*1024)
+#endif
+
+#ifndef CONFIG_NXFFS_PACKSTEP
+#  define CONFIG_NXFFS_PACKSTEP 1
+#endif
+
+#if CONFIG_NXFFS_PACKSTEP < 1
+#  error "CONFIG_NXFFS_PACKSTEP must be at least one erase block"
+#endif
+
 /* At present, only a single pre-allocated NXFFS volume is supported.  This
  * is because here can be only a single NXFFS volume mounted at any time.
  * This has to do with the fact that we bind to an MTD driver (instead of a
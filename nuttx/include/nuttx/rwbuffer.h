@@ -51,16 +51,31 @@
 #include <semaphore.h>
 #include <nuttx/wqueue.h>
 
-#if defined(CONFIG_FS_WRITEBUFFER) || defined(CONFIG_FS_READAHEAD)
-
-/**********************************************************************
- * Pre-processor Definitions
- **********************************************************************/
-
 /**********************************************************************
  * Public Types
  **********************************************************************/
 
+/* Buffering statistics returned by rwb_getstats() (and by the
+ * BIOC_RWBSTATS ioctl of block drivers that use these buffers).
+ */
+
+struct rwb_stats_s
+{
+  uint16_t      rs_rhwindow;     /* Current read-ahead window (blocks) */
+  uint32_t      rs_rdhits;       /* Blocks read from the read-ahead buffer */
+  uint32_t      rs_wrhits;       /* Blocks read from the write buffer */
+  uint32_t      rs_rdmisses;     /* Blocks read from the device on a miss */
+  uint32_t      rs_rdahead;      /* Blocks read ahead of the reader */
+  uint32_t      rs_nreads;       /* Number of device reads */
+  uint32_t      rs_wrblocks;     /* Blocks passed to rwb_write() */
+  uint32_t      rs_wrmerged;     /* Buffered blocks re-written before flush */
+  uint32_t      rs_nflushes;     /* Number of write buffer flushes */
+  uint32_t      rs_nwrites;      /* Number of device writes */
+  uint32_t      rs_flblocks;     /* Blocks written to the device */
+};
+
+#if defined(CONFIG_FS_WRITEBUFFER) || defined(CONFIG_FS_READAHEAD)
+
 /* Data transfer callouts.  These must be provided by the block driver
  * logic in order to flush the write buffer when appropriate or to
  * reload the read-ahead buffer, when appropriate.
@@ -94,6 +109,11 @@ typedef ssize_t (*rwbflush_t)(FAR void *dev, FAR const uint8_t *buffer,
  *  ... [Setup blocksize, nblocks, dev, wrmaxblocks, wrflush,
  *       rhmaxblocks, rhreload] ...
  *  ret = rwb_initialize(&priv->rwbuffer);
+ *
+ * All reads and writes of the device must then go through rwb_read() and
+ * rwb_write() so that the buffered data stays coherent with the device.
+ * A driver that must transfer data some other way calls rwb_flush() first
+ * and, after writing, rwb_invalidate() for the blocks that it wrote.
  */
 
 struct rwbuffer_s
@@ -109,48 +129,61 @@ struct rwbuffer_s
   size_t        nblocks;         /* The total number blocks supported */
   FAR void     *dev;             /* Device state passed to callout functions */
 
+  /* Data transfer callouts.  rhreload is used by rwb_read() to read blocks
+   * that are not buffered; wrflush is used by rwb_write() and to flush the
+   * write buffer.  wrflush may be NULL if rwb_write() is never called.
+   */
+
+  rwbreload_t   rhreload;        /* Callout to read blocks from the device */
+  rwbflush_t    wrflush;         /* Callout to write blocks to the device */
+
   /* Write buffer setup.  If CONFIG_FS_WRITEBUFFER is defined, but you
-   * want read-ahead-only operation, (1) set wrmaxblocks to zero and do
-   * not use rwb_write().
+   * want read-ahead-only operation, then set wrmaxblocks to zero.  Writes
+   * then go directly to the device.
    */
 
 #ifdef CONFIG_FS_WRITEBUFFER
   uint16_t      wrmaxblocks;     /* The number of blocks to buffer in memory */
-  rwbflush_t    wrflush;         /* Callout to flush the write buffer */
 #endif
 
   /* Read-ahead buffer setup.  If CONFIG_FS_READAHEAD is defined but you
-   * want write-buffer-only operation, then (1) set rhmaxblocks to zero and
-   * do not use rwb_read().
+   * want write-buffer-only operation, then set rhmaxblocks to zero.  Reads
+   * are then served from the write buffer or directly from the device.
    */
 
 #ifdef CONFIG_FS_READAHEAD
   uint16_t      rhmaxblocks;     /* The number of blocks to buffer in memory */
-  rwbreload_t   rhreload;        /* Callout to reload the read-ahead buffer */
 #endif
 
   /********************************************************************/
   /* The user should never modify any of the remaing fields */
 
-  /* This is the state of the write buffer */
+  /* This is the state of the write buffer.  The buffer holds up to
+   * wrmaxblocks blocks in any order of the device.  They are kept sorted
+   * by block number so that each run of consecutive blocks is contiguous
+   * in memory and is written to the device with one transfer.
+   */
 
 #ifdef CONFIG_FS_WRITEBUFFER
   sem_t         wrsem;           /* Enforces exclusive access to the write buffer */
   struct work_s work;            /* Delayed work to flush buffer after adelay with no activity */
   uint8_t      *wrbuffer;        /* Allocated write buffer */
+  off_t        *wrblocks;        /* Block number of each buffered block (sorted) */
   uint16_t      wrnblocks;       /* Number of blocks in write buffer */
-  off_t         wrblockstart;    /* First block in write buffer */
-  off_t         wrexpectedblock; /* Next block expected */
 #endif
 
   /* This is the state of the read-ahead buffer */
 
 #ifdef CONFIG_FS_READAHEAD
-  sem_t         rhsem;           /* Enforces exclusive access to the write buffer */
+  sem_t         rhsem;           /* Enforces exclusive access to the read-ahead buffer */
   uint8_t      *rhbuffer;        /* Allocated read-ahead buffer */
   uint16_t      rhnblocks;       /* Number of blocks in read-ahead buffer */
+  uint16_t      rhwindow;        /* Blocks to read ahead for a sequential reader */
   off_t         rhblockstart;    /* First block in read-ahead buffer */
+  off_t         rhexpected;      /* Block following the last block read */
 #endif
+
+  struct rwb_stats_s stats;      /* Buffering statistics */
 };
 
 /**********************************************************************
@@ -181,12 +214,20 @@ EXTERN ssize_t rwb_read(FAR struct rwbuffer_s *rwb, off_t startblock,
 EXTERN ssize_t rwb_write(FAR struct rwbuffer_s *rwb,
                          off_t startblock, size_t blockcount,
                          FAR const uint8_t *wrbuffer);
+EXTERN int rwb_flush(FAR struct rwbuffer_s *rwb);
+EXTERN int rwb_invalidate(FAR struct rwbuffer_s *rwb, off_t startblock,
+                          size_t nblocks);
 EXTERN int rwb_mediaremoved(FAR struct rwbuffer_s *rwb);
 
+/* Statistics */
+
+EXTERN void rwb_getstats(FAR struct rwbuffer_s *rwb,
+                         FAR struct rwb_stats_s *stats);
+
 #undef EXTERN
 #if defined(__cplusplus)
 }
 #endif
 
-#endif /* CONFIG_FS_WRITEBUFFER || CONFIG_READAHEAD_BUFFER */
+#endif /* CONFIG_FS_WRITEBUFFER || CONFIG_FS_READAHEAD */
 #endif /* __INCLUDE_NUTTX_RWBUFFER_H */
@@ -52,6 +52,7 @@
 #include <time.h>
 
 #include <nuttx/irq.h>
+#include <nuttx/mm.h>
 #include <nuttx/net.h>
 
 /********************************************************************************
@@ -268,6 +269,12 @@ struct _TCB
 
   int        pterrno;                    /* Current per-thread errno            */
 
+  /* Memory management **********************************************************/
+
+#ifdef CONFIG_MM_TASKCACHE
+  struct mm_taskcache_s mmcache;         /* Recently freed small chunks         */
+#endif
+
   /* File system support ********************************************************/
 
 #if CONFIG_NFILE_DESCRIPTORS > 0
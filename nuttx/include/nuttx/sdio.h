@@ -51,6 +51,13 @@
  * Pre-Processor Definitions
  ****************************************************************************/
 
+/* Configuration ************************************************************/
+/* Scatter/gather DMA is an extension of DMA support */
+
+#ifndef CONFIG_SDIO_DMA
+#  undef CONFIG_SDIO_DMASG
+#endif
+
 /* SDIO events needed by the driver
  *
  * Wait events are used for event-waiting by SDIO_WAITENABLE and SDIO_EVENTWAIT
@@ -742,6 +749,86 @@
 #  define SDIO_DMASENDSETUP(dev,buffer,len) (-ENOSYS)
 #endif
 
+/****************************************************************************
+ * Name: SDIO_DMAPREPARE
+ *
+ * Description:
+ *   Prepare the memory of a following scatter/gather DMA transfer.  This
+ *   does all of the work of SDIO_DMARECVSGSETUP or SDIO_DMASENDSGSETUP that
+ *   does not involve the SDIO hardware (such as cache maintenance and
+ *   building of a DMA descriptor chain) so that it can be done while a
+ *   different transfer is still in progress.  The following setup call with
+ *   the same scatter list then only has to start the DMA.  This method is
+ *   optional and may be NULL.
+ *
+ * Input Parameters:
+ *   dev   - An instance of the SDIO device interface
+ *   sg    - The list of memory segments
+ *   nsg   - The number of memory segments in the list
+ *   write - true: The memory will be sent to the card
+ *
+ * Returned Value:
+ *   OK on success; a negated errno on failure
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_SDIO_DMASG
+#  define SDIO_DMAPREPARE(dev,sg,nsg,write) \
+     ((dev)->dmaprepare ? (dev)->dmaprepare(dev,sg,nsg,write) : OK)
+#else
+#  define SDIO_DMAPREPARE(dev,sg,nsg,write) (OK)
+#endif
+
+/****************************************************************************
+ * Name: SDIO_DMARECVSGSETUP
+ *
+ * Description:
+ *   Setup to perform a read DMA into a list of memory segments.  This is
+ *   the same as SDIO_DMARECVSETUP, except that the data received from the
+ *   card is scattered to several memory segments in order.  Upon return,
+ *   DMA is enabled and waiting.
+ *
+ * Input Parameters:
+ *   dev - An instance of the SDIO device interface
+ *   sg  - The list of memory segments to DMA into
+ *   nsg - The number of memory segments in the list
+ *
+ * Returned Value:
+ *   OK on success; a negated errno on failure
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_SDIO_DMASG
+#  define SDIO_DMARECVSGSETUP(dev,sg,nsg) ((dev)->dmarecvsgsetup(dev,sg,nsg))
+#else
+#  define SDIO_DMARECVSGSETUP(dev,sg,nsg) (-ENOSYS)
+#endif
+
+/****************************************************************************
+ * Name: SDIO_DMASENDSGSETUP
+ *
+ * Description:
+ *   Setup to perform a write DMA from a list of memory segments.  This is
+ *   the same as SDIO_DMASENDSETUP, except that the data sent to the card is
+ *   gathered from several memory segments in order.  Upon return, DMA is
+ *   enabled and waiting.
+ *
+ * Input Parameters:
+ *   dev - An instance of the SDIO device interface
+ *   sg  - The list of memory segments to DMA from
+ *   nsg - The number of memory segments in the list
+ *
+ * Returned Value:
+ *   OK on success; a negated errno on failure
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_SDIO_DMASG
+#  define SDIO_DMASENDSGSETUP(dev,sg,nsg) ((dev)->dmasendsgsetup(dev,sg,nsg))
+#else
+#  define SDIO_DMASENDSGSETUP(dev,sg,nsg) (-ENOSYS)
+#endif
+
 /****************************************************************************
  * Public Types
  ****************************************************************************/
@@ -763,6 +850,14 @@ enum sdio_clock_e
 
 typedef uint8_t sdio_eventset_t;
 
+/* One memory segment of a scatter/gather DMA transfer */
+
+struct sdio_sg_s
+{
+  FAR uint8_t *buffer;     /* Start of the memory segment */
+  size_t buflen;           /* Size of the memory segment in bytes */
+};
+
 /* This structure defines the interface between the NuttX SDIO
  * driver and the chip- or board-specific SDIO interface.  This
  * interface is only used in architectures that support SDIO
@@ -834,6 +929,20 @@ struct sdio_dev_s
   int   (*dmasendsetup)(FAR struct sdio_dev_s *dev, FAR const uint8_t *buffer,
           size_t buflen);
 #endif
+
+  /* Scatter/gather DMA.  CONFIG_SDIO_DMASG should be set if the driver
+   * supports DMA to and from a list of memory segments.  This requires
+   * CONFIG_SDIO_DMA.
+   */
+
+#ifdef CONFIG_SDIO_DMASG
+  int   (*dmaprepare)(FAR struct sdio_dev_s *dev,
+          FAR const struct sdio_sg_s *sg, int nsg, bool write);
+  int   (*dmarecvsgsetup)(FAR struct sdio_dev_s *dev,
+          FAR const struct sdio_sg_s *sg, int nsg);
+  int   (*dmasendsgsetup)(FAR struct sdio_dev_s *dev,
+          FAR const struct sdio_sg_s *sg, int nsg);
+#endif
 };
 
 /****************************************************************************
@@ -51,6 +51,28 @@
  * Pre-Processor Definitions
  ****************************************************************************/
 
+/* Work queue IDs:
+ *
+ * HPWORK - The high priority work queue.  This queue is serviced by the
+ *   "work" thread at CONFIG_SCHED_WORKPRIORITY and is intended to serve
+ *   as the "bottom half" of device drivers.
+ * LPWORK - The low priority work queue.  If CONFIG_SCHED_LPWORK is
+ *   selected, this queue is serviced by a separate "lpwork" thread at
+ *   CONFIG_SCHED_LPWORKPRIORITY.  It is intended for less critical,
+ *   housekeeping activities (such as garbage collection) that should not
+ *   delay the driver bottom halves.  If CONFIG_SCHED_LPWORK is not
+ *   selected, then LPWORK is a synonym for HPWORK.
+ */
+
+#define HPWORK       0
+#ifdef CONFIG_SCHED_LPWORK
+#  define LPWORK     1
+#  define NWORKERS   2
+#else
+#  define LPWORK     HPWORK
+#  define NWORKERS   1
+#endif
+
 /****************************************************************************
  * Public Types
  ****************************************************************************/
@@ -75,6 +97,34 @@ struct work_s
   uint32_t  delay;      /* Delay until work performed */
 };
 
+/* Queue latency statistics.  Latency is measured in clock ticks from the
+ * time that the work became ready to run (i.e., when its delay expired)
+ * until the time that the worker callback was invoked.
+ */
+
+#ifdef CONFIG_SCHED_WORKSTATS
+struct work_stats_s
+{
+  uint32_t nworks;      /* Number of work items performed */
+  uint32_t totlatency;  /* Sum of the latency of all work performed */
+  uint32_t maxlatency;  /* Largest latency observed */
+};
+#endif
+
+/* This structure describes one work queue and the thread that services it.
+ * The list of pending work is kept in order of increasing deadline so that
+ * the worker thread only has to examine the head of the list.
+ */
+
+struct wqueue_s
+{
+  pid_t             pid; /* The task ID of the worker thread */
+  struct dq_queue_s q;   /* The queue of pending work */
+#ifdef CONFIG_SCHED_WORKSTATS
+  struct work_stats_s stats; /* Queue latency statistics */
+#endif
+};
+
 /****************************************************************************
  * Public Data
  ****************************************************************************/
@@ -86,9 +136,9 @@ extern "C" {
 #define EXTERN extern
 #endif
 
-/* The task ID of the worker thread */
+/* The state of each work queue */
 
-EXTERN pid_t g_worker;
+EXTERN struct wqueue_s g_work[NWORKERS];
 
 /****************************************************************************
  * Public Function Prototypes
@@ -108,7 +158,12 @@ EXTERN pid_t g_worker;
  *   from the queue, or (2) work_cancel() has been called to cancel the work
  *   and remove it from the work queue.
  *
+ *   Work is kept in order of its deadline:  Work with a zero delay will be
+ *   performed as soon as the worker thread runs; the worker thread sleeps
+ *   only until the deadline of the earliest delayed work.
+ *
  * Input parameters:
+ *   qid    - The work queue ID (HPWORK or LPWORK)
  *   work   - The work structure to queue
  *   worker - The worker callback to be invoked.  The callback will invoked
  *            on the worker thread of execution.
@@ -122,7 +177,8 @@ EXTERN pid_t g_worker;
  *
  ****************************************************************************/
 
-EXTERN int work_queue(struct work_s *work, worker_t worker, FAR void *arg, uint32_t delay);
+EXTERN int work_queue(int qid, FAR struct work_s *work, worker_t worker,
+                      FAR void *arg, uint32_t delay);
 
 /****************************************************************************
  * Name: work_cancel
@@ -133,6 +189,7 @@ EXTERN int work_queue(struct work_s *work, worker_t worker, FAR void *arg, uint3
  *   again.
  *
  * Input parameters:
+ *   qid    - The work queue ID (must be the same as passed to work_queue())
  *   work   - The previously queue work structure to cancel
  *
  * Returned Value:
@@ -140,7 +197,7 @@ EXTERN int work_queue(struct work_s *work, worker_t worker, FAR void *arg, uint3
  *
  ****************************************************************************/
 
-EXTERN int work_cancel(struct work_s *work);
+EXTERN int work_cancel(int qid, FAR struct work_s *work);
 
 /****************************************************************************
  * Name: work_signal
@@ -151,14 +208,14 @@ EXTERN int work_cancel(struct work_s *work);
  *   user to force an immediate re-assessment of pending work.
  *
  * Input parameters:
- *   None
+ *   qid    - The work queue ID
  *
  * Returned Value:
  *   Zero on success, a negated errno on failure
  *
  ****************************************************************************/
 
-#define work_signal() kill(g_worker, SIGWORK)
+#define work_signal(qid) kill(g_work[qid].pid, SIGWORK)
 
 #undef EXTERN
 #ifdef __cplusplus
@@ -101,6 +101,14 @@ typedef unsigned int nfds_t;
 
 typedef uint8_t pollevent_t;
 
+/* If the callback in the pollfd structure is non-NULL, it is called to
+ * report events instead of posting the semaphore.  This is used by epoll
+ * to maintain a list of ready descriptors.
+ */
+
+struct pollfd;
+typedef void (*pollcb_t)(FAR struct pollfd *fds);
+
 /* This is the Nuttx variant of the standard pollfd structure. */
 
 struct pollfd
@@ -110,6 +118,7 @@ struct pollfd
   pollevent_t events;   /* The input event flags */
   pollevent_t revents;  /* The output event flags */
   FAR void   *priv;     /* For use by drivers */
+  pollcb_t    cb;       /* Event callback (see above) */
 };
 
 /****************************************************************************
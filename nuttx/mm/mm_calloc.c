@@ -62,6 +62,7 @@ FAR void *calloc(size_t n, size_t elem_size)
   if (n > 0 && elem_size > 0)
     {
       ret = zalloc(n * elem_size);
+      MM_TRACE(ret);
     }
 
   return ret;
@@ -54,15 +54,22 @@
  ************************************************************************/
 
 /************************************************************************
- * free
+ * free (or mm_heapfree)
  *
  * Description:
  *   Returns a chunk of memory into the list of free nodes,
  *   merging with adjacent free chunks if possible.
  *
+ *   If CONFIG_MM_SLAB or CONFIG_MM_TASKCACHE is selected, this is
+ *   mm_heapfree() and free() first tries the front ends.
+ *
  ************************************************************************/
 
+#ifdef MM_HAVE_FRONTEND
+void mm_heapfree(FAR void *mem)
+#else
 void free(FAR void *mem)
+#endif
 {
   FAR struct mm_freenode_s *node;
   FAR struct mm_freenode_s *prev;
@@ -150,3 +157,42 @@ void free(FAR void *mem)
   mm_addfreechunk(node);
   mm_givesemaphore();
 }
+
+/************************************************************************
+ * free
+ *
+ * Description:
+ *   Keep a small chunk in the calling task's cache or return the memory
+ *   to the slab or to the heap, depending upon where it came from.
+ *
+ ************************************************************************/
+
+#ifdef MM_HAVE_FRONTEND
+void free(FAR void *mem)
+{
+#ifdef CONFIG_MM_SLAB
+  FAR struct mm_allocnode_s *node;
+#endif
+
+  if (mem)
+    {
+#ifdef CONFIG_MM_TASKCACHE
+      if (mm_cacheput(mem))
+        {
+          return;
+        }
+#endif
+
+#ifdef CONFIG_MM_SLAB
+      node = (FAR struct mm_allocnode_s *)((char*)mem - SIZEOF_MM_ALLOCNODE);
+      if ((node->size & MM_SLAB_BIT) != 0)
+        {
+          mm_slabfree(mem);
+          return;
+        }
+#endif
+
+      mm_heapfree(mem);
+    }
+}
+#endif
@@ -86,6 +86,15 @@
 # define MM_MAX_SHIFT     22  /*  4 Mb */
 #endif
 
+/* Allocation tracing adds fields to the chunk header so that a free
+ * node no longer fits in 16 bytes.
+ */
+
+#ifdef CONFIG_MM_TRACE
+# undef  MM_MIN_SHIFT
+# define MM_MIN_SHIFT      5  /* 32 bytes */
+#endif
+
 /* All other definitions derive from these two */
 
 #define MM_MIN_CHUNK     (1 << MM_MIN_SHIFT)
@@ -109,6 +118,86 @@
 #define MM_IS_ALLOCATED(n) \
   ((int)((struct mm_allocnode_s*)(n)->preceding) < 0))
 
+/* Small object (slab) front end.  If CONFIG_MM_SLAB is selected, then
+ * requests of up to CONFIG_MM_SLAB_MAXSIZE bytes are served from slabs.
+ * Each slab is an ordinary heap chunk of CONFIG_MM_SLAB_SIZE bytes that
+ * is carved into objects of a single size class.  The size classes are
+ * the chunk sizes MM_MIN_CHUNK, 2*MM_MIN_CHUNK, ... so that the class
+ * of a request is simply its chunk size divided by MM_MIN_CHUNK, minus
+ * one.
+ *
+ * Each object begins with a struct mm_allocnode_s header just like a
+ * heap chunk.  Chunk sizes are always a multiple of MM_MIN_CHUNK so bit 0
+ * of the 'size' field is used to mark the object as part of a slab.  The
+ * 'preceding' field of an object holds the offset back to the beginning
+ * of its slab.
+ */
+
+#ifdef CONFIG_MM_SLAB
+#  ifndef CONFIG_MM_SLAB_MAXSIZE
+#    define CONFIG_MM_SLAB_MAXSIZE 120
+#  endif
+#  ifndef CONFIG_MM_SLAB_SIZE
+#    define CONFIG_MM_SLAB_SIZE 1024
+#  endif
+#  if CONFIG_MM_SLAB_MAXSIZE <= 0
+#    error "CONFIG_MM_SLAB_MAXSIZE must be positive"
+#  endif
+#  if defined(CONFIG_MM_SMALL) && CONFIG_MM_SLAB_SIZE >= MM_ALLOC_BIT
+#    error "CONFIG_MM_SLAB_SIZE is too large for CONFIG_MM_SMALL"
+#  endif
+
+#  define MM_SLAB_BIT         1
+#  define MM_SLAB_MAXCHUNK    MM_ALIGN_UP(CONFIG_MM_SLAB_MAXSIZE + SIZEOF_MM_ALLOCNODE)
+#  define MM_SLAB_NCLASSES    (MM_SLAB_MAXCHUNK >> MM_MIN_SHIFT)
+#  define MM_SLAB_NDX(c)      (((c) >> MM_MIN_SHIFT) - 1)
+#endif
+
+/* Per-task allocation cache.  If CONFIG_MM_TASKCACHE is selected, then
+ * free() puts small chunks in a cache in the TCB of the calling task and
+ * malloc() takes chunks from that cache without taking the MM semaphore.
+ * The cached chunks remain marked as allocated in the heap.  The link to
+ * the next cached chunk of the same size is kept in the first bytes of
+ * the chunk's data.
+ */
+
+#ifdef CONFIG_MM_TASKCACHE
+#  define MM_CACHE_MAXCHUNK   (CONFIG_MM_TASKCACHE_NCLASSES << MM_MIN_SHIFT)
+#  define MM_CACHE_NDX(c)     (((c) >> MM_MIN_SHIFT) - 1)
+#endif
+
+/* If either front end is selected, then malloc() and free() try the front
+ * end first and the heap allocator is called mm_heapmalloc() and
+ * mm_heapfree().
+ */
+
+#if defined(CONFIG_MM_SLAB) || defined(CONFIG_MM_TASKCACHE)
+#  define MM_HAVE_FRONTEND 1
+#endif
+
+/* Allocation tracing.  If CONFIG_MM_TRACE is selected, then each chunk
+ * header also records the ID of the task that allocated the chunk and
+ * the address that the allocation function was called from.  Slab
+ * objects are traced in the same way;  the heap chunk that holds a slab
+ * is marked with MM_TRACE_SLABPID and free slab objects are marked with
+ * MM_TRACE_NOPID.
+ */
+
+#ifdef CONFIG_MM_TRACE
+#  define MM_TRACE_NOPID      (-1)
+#  define MM_TRACE_SLABPID    (-2)
+
+#  ifdef __GNUC__
+#    define MM_RETADDR()      __builtin_return_address(0)
+#  else
+#    define MM_RETADDR()      NULL
+#  endif
+
+#  define MM_TRACE(m)         mm_settrace(m, MM_RETADDR())
+#else
+#  define MM_TRACE(m)
+#endif
+
 /************************************************************************
  * Public Types
  ************************************************************************/
@@ -132,14 +221,30 @@ struct mm_allocnode_s
 {
   mmsize_t size;           /* Size of this chunk */
   mmsize_t preceding;      /* Size of the preceding chunk */
+#ifdef CONFIG_MM_TRACE
+  int16_t  pid;            /* ID of the task that allocated the chunk */
+  FAR void *caller;        /* Where the chunk was allocated from */
+#endif
 };
 
 /* What is the size of the allocnode? */
 
-#ifdef CONFIG_MM_SMALL
-# define SIZEOF_MM_ALLOCNODE   4
+#ifdef CONFIG_MM_TRACE
+#  ifdef CONFIG_MM_SMALL
+#    ifdef CONFIG_SMALL_MEMORY
+#      define SIZEOF_MM_ALLOCNODE 8
+#    else
+#      define SIZEOF_MM_ALLOCNODE 12
+#    endif
+#  else
+#    define SIZEOF_MM_ALLOCNODE   16
+#  endif
 #else
-# define SIZEOF_MM_ALLOCNODE   8
+#  ifdef CONFIG_MM_SMALL
+#    define SIZEOF_MM_ALLOCNODE   4
+#  else
+#    define SIZEOF_MM_ALLOCNODE   8
+#  endif
 #endif
 
 #define CHECK_ALLOCNODE_SIZE \
@@ -151,6 +256,10 @@ struct mm_freenode_s
 {
   mmsize_t size;                   /* Size of this chunk */
   mmsize_t preceding;              /* Size of the preceding chunk */
+#ifdef CONFIG_MM_TRACE
+  int16_t  pid;                    /* Unused in a free chunk */
+  FAR void *caller;
+#endif
   FAR struct mm_freenode_s *flink; /* Supports a doubly linked list */
   FAR struct mm_freenode_s *blink;
 };
@@ -159,17 +268,39 @@ struct mm_freenode_s
 
 #ifdef CONFIG_MM_SMALL
 #  ifdef CONFIG_SMALL_MEMORY
-#     define SIZEOF_MM_FREENODE 8
+#     define SIZEOF_MM_FREENODE (SIZEOF_MM_ALLOCNODE + 4)
 #  else
-#     define SIZEOF_MM_FREENODE 12
+#     define SIZEOF_MM_FREENODE (SIZEOF_MM_ALLOCNODE + 8)
 #  endif
 #else
-# define SIZEOF_MM_FREENODE     16
+# define SIZEOF_MM_FREENODE     (SIZEOF_MM_ALLOCNODE + 8)
 #endif
 
 #define CHECK_FREENODE_SIZE \
   DEBUGASSERT(sizeof(struct mm_freenode_s) == SIZEOF_MM_FREENODE)
 
+/* This describes one slab of small objects.  Slabs that have free objects
+ * are kept in a doubly linked list for each size class.  The objects
+ * follow this header (rounded up to MM_MIN_CHUNK) in the slab.  The link
+ * to the next free object is kept in the first bytes of the free object's
+ * data.
+ */
+
+#ifdef CONFIG_MM_SLAB
+struct mm_slab_s
+{
+  FAR struct mm_slab_s *flink;     /* Supports a doubly linked list */
+  FAR struct mm_slab_s *blink;
+  FAR struct mm_allocnode_s *free; /* List of free objects in the slab */
+  uint16_t nobjects;               /* Number of objects in the slab */
+  uint16_t nfree;                  /* Number of free objects in the slab */
+};
+#endif
+
+/* The first object of a slab follows the slab header */
+
+#define MM_SLAB_HDRSIZE  MM_ALIGN_UP(sizeof(struct mm_slab_s))
+
 /* Normally defined in stdlib.h */
 
 #ifdef MM_TEST
@@ -212,6 +343,18 @@ extern int g_nregions;
 
 extern FAR struct mm_freenode_s g_nodelist[MM_NNODES];
 
+#ifdef CONFIG_MM_SLAB
+/* The number of bytes held in free slab objects */
+
+extern size_t g_slabfree;
+#endif
+
+#ifdef CONFIG_MM_TASKCACHE
+/* The number of bytes held in all of the per-task caches */
+
+extern size_t g_cachebytes;
+#endif
+
 /************************************************************************
  * Public Function Prototypes
  ************************************************************************/
@@ -232,6 +375,33 @@ extern FAR struct mm_freenode_s g_nodelist[MM_NNODES];
 #endif
 #endif
 
+/* When a front end (the slab allocator or the per-task cache) is
+ * enabled, the heap allocator is still available to the front ends (and
+ * to memalign) under these names.
+ */
+
+#ifdef MM_HAVE_FRONTEND
+extern FAR void  *mm_heapmalloc(size_t size);
+extern void       mm_heapfree(FAR void *mem);
+#else
+#  define mm_heapmalloc(s) malloc(s)
+#  define mm_heapfree(m)   free(m)
+#endif
+
+#ifdef CONFIG_MM_SLAB
+extern FAR void  *mm_slaballoc(size_t size);
+extern void       mm_slabfree(FAR void *mem);
+#endif
+
+#ifdef CONFIG_MM_TASKCACHE
+extern FAR void  *mm_cacheget(size_t size);
+extern bool       mm_cacheput(FAR void *mem);
+#endif
+
+#ifdef CONFIG_MM_TRACE
+extern void       mm_settrace(FAR void *mem, FAR void *caller);
+#endif
+
 extern void       mm_shrinkchunk(FAR struct mm_allocnode_s *node,
                                  size_t size);
 extern void       mm_addfreechunk(FAR struct mm_freenode_s *node);
@@ -127,6 +127,24 @@ int mallinfo(struct mallinfo *info)
 
   DEBUGASSERT(uordblks + fordblks == g_heapsize);
 
+#ifdef CONFIG_MM_SLAB
+  /* The slabs themselves are allocated heap chunks.  Report the unused
+   * objects in the slabs as free memory.
+   */
+
+  uordblks -= g_slabfree;
+  fordblks += g_slabfree;
+#endif
+
+#ifdef CONFIG_MM_TASKCACHE
+  /* Chunks in the per-task caches are also free as far as the user is
+   * concerned.
+   */
+
+  uordblks -= g_cachebytes;
+  fordblks += g_cachebytes;
+#endif
+
 #ifdef CONFIG_CAN_PASS_STRUCTS
   info.arena    = g_heapsize;
   info.ordblks  = ordblks;
@@ -74,7 +74,7 @@
  ************************************************************/
 
 /************************************************************
- * malloc
+ * malloc (or mm_heapmalloc)
  *
  * Description:
  *  Find the smallest chunk that satisfies the request.
@@ -83,9 +83,17 @@
  *
  *  8-byte alignment of the allocated data is assured.
  *
+ *  If CONFIG_MM_SLAB or CONFIG_MM_TASKCACHE is selected,
+ *  this is mm_heapmalloc() and malloc() first tries the
+ *  front ends.
+ *
  ************************************************************/
 
+#ifdef MM_HAVE_FRONTEND
+FAR void *mm_heapmalloc(size_t size)
+#else
 FAR void *malloc(size_t size)
+#endif
 {
   FAR struct mm_freenode_s *node;
   void *ret = NULL;
@@ -199,6 +207,50 @@ FAR void *malloc(size_t size)
     }
 
   mm_givesemaphore();
+  MM_TRACE(ret);
   mvdbg("Allocated %p, size %d\n", ret, size);
   return ret;
 }
+
+/************************************************************
+ * malloc
+ *
+ * Description:
+ *  Small requests are served from the calling task's cache
+ *  of freed chunks or from the slab of their size class.
+ *  Everything else (or a small request that cannot get a
+ *  new slab) is taken from the heap.
+ *
+ ************************************************************/
+
+#ifdef MM_HAVE_FRONTEND
+FAR void *malloc(size_t size)
+{
+  FAR void *ret;
+
+#ifdef CONFIG_MM_TASKCACHE
+  ret = mm_cacheget(size);
+  if (ret)
+    {
+      MM_TRACE(ret);
+      return ret;
+    }
+#endif
+
+#ifdef CONFIG_MM_SLAB
+  if (size > 0 && size <= CONFIG_MM_SLAB_MAXSIZE)
+    {
+      ret = mm_slaballoc(size);
+      if (ret)
+        {
+          MM_TRACE(ret);
+          return ret;
+        }
+    }
+#endif
+
+  ret = mm_heapmalloc(size);
+  MM_TRACE(ret);
+  return ret;
+}
+#endif
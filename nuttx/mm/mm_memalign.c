@@ -78,7 +78,9 @@ FAR void *memalign(size_t alignment, size_t size)
 
   if (alignment <= MM_MIN_CHUNK)
     {
-      return malloc(size);
+      FAR void *mem = malloc(size);
+      MM_TRACE(mem);
+      return mem;
     }
 
   /* Adjust the size to account for (1) the size of the allocated
@@ -97,9 +99,11 @@ FAR void *memalign(size_t alignment, size_t size)
   size      = MM_ALIGN_UP(size);   /* Make multiples of our granule size */
   allocsize = size + 2*alignment;  /* Add double full alignment size */
 
-  /* Then malloc that size */
+  /* Then malloc that size.  This must be a heap chunk that can be split
+   * (and not a slab object).
+   */
 
-  rawchunk = (size_t)malloc(allocsize);
+  rawchunk = (size_t)mm_heapmalloc(allocsize);
   if (rawchunk == 0)
     {
       return NULL;
@@ -206,5 +210,6 @@ FAR void *memalign(size_t alignment, size_t size)
     }
 
   mm_givesemaphore();
+  MM_TRACE((FAR void*)alignedchunk);
   return (FAR void*)alignedchunk;
 }
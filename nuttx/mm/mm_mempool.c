@@ -0,0 +1,236 @@
+/****************************************************************************
+ * mm/mm_mempool.c
+ *
+ *   Copyright (C) 2012 Gregory Nutt. All rights reserved.
+ *   Author: Gregory Nutt <gnutt@nuttx.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name NuttX nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <queue.h>
+#include <errno.h>
+#include <assert.h>
+#include <debug.h>
+
+#include <arch/irq.h>
+#include <nuttx/arch.h>
+#include <nuttx/kmalloc.h>
+#include <nuttx/mempool.h>
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+/* This is the list of all pools (for mempool_foreach).  Pools are never
+ * removed from this list.
+ */
+
+static sq_queue_t g_mempools;
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: mempool_create
+ *
+ * Description:
+ *   Initialize a pool of 'nblocks' blocks of 'blocksize' bytes each and
+ *   add it to the list of pools that can be inspected.
+ *
+ ****************************************************************************/
+
+int mempool_create(FAR struct mempool_s *pool, FAR const char *name,
+                   FAR void *storage, size_t blocksize,
+                   unsigned int nblocks, unsigned int nreserved)
+{
+  FAR uint8_t *blk;
+  irqstate_t flags;
+  unsigned int i;
+
+  DEBUGASSERT(pool && blocksize >= sizeof(sq_entry_t) &&
+              nblocks <= UINT16_MAX && nreserved <= nblocks);
+
+  /* Allocate memory for the blocks if the caller did not provide it */
+
+  if (!storage)
+    {
+      storage = kmalloc(blocksize * nblocks);
+      if (!storage)
+        {
+          mdbg("Failed to allocate pool %s\n", name);
+          return -ENOMEM;
+        }
+    }
+
+  /* Put every block in the free list */
+
+  sq_init(&pool->free);
+  for (i = 0, blk = (FAR uint8_t*)storage; i < nblocks; i++, blk += blocksize)
+    {
+      sq_addlast((FAR sq_entry_t*)blk, &pool->free);
+    }
+
+  pool->name      = name;
+  pool->start     = (FAR uint8_t*)storage;
+  pool->blocksize = blocksize;
+  pool->nblocks   = nblocks;
+  pool->nreserved = nreserved;
+  pool->nfree     = nblocks;
+  pool->nminfree  = nblocks;
+  pool->nfailed   = 0;
+
+  /* Then add the pool to the list of all pools */
+
+  flags = irqsave();
+  sq_addlast((FAR sq_entry_t*)pool, &g_mempools);
+  irqrestore(flags);
+  return OK;
+}
+
+/****************************************************************************
+ * Name: mempool_alloc
+ *
+ * Description:
+ *   Take a block from the pool in constant time.  Interrupts are disabled
+ *   only while the free list is modified.  Only interrupt handlers can
+ *   take the reserved blocks.
+ *
+ ****************************************************************************/
+
+FAR void *mempool_alloc(FAR struct mempool_s *pool)
+{
+  FAR void *blk = NULL;
+  irqstate_t flags;
+
+  flags = irqsave();
+  if (pool->nfree > pool->nreserved ||
+      (pool->nfree > 0 && up_interrupt_context()))
+    {
+      blk = (FAR void*)sq_remfirst(&pool->free);
+      if (--pool->nfree < pool->nminfree)
+        {
+          pool->nminfree = pool->nfree;
+        }
+    }
+  else
+    {
+      pool->nfailed++;
+    }
+
+  irqrestore(flags);
+  return blk;
+}
+
+/****************************************************************************
+ * Name: mempool_free
+ *
+ * Description:
+ *   Return a block to the pool in constant time.  The most recently freed
+ *   block is the next one allocated.
+ *
+ ****************************************************************************/
+
+void mempool_free(FAR struct mempool_s *pool, FAR void *blk)
+{
+  irqstate_t flags;
+
+  DEBUGASSERT((FAR uint8_t*)blk >= pool->start &&
+              (FAR uint8_t*)blk < pool->start + pool->nblocks * pool->blocksize &&
+              pool->nfree < pool->nblocks);
+
+  flags = irqsave();
+  sq_addfirst((FAR sq_entry_t*)blk, &pool->free);
+  pool->nfree++;
+  irqrestore(flags);
+}
+
+/****************************************************************************
+ * Name: mempool_stat
+ *
+ * Description:
+ *   Return the current state of the pool.
+ *
+ ****************************************************************************/
+
+void mempool_stat(FAR struct mempool_s *pool, FAR struct mempoolinfo_s *info)
+{
+  irqstate_t flags;
+
+  flags = irqsave();
+  info->name      = pool->name;
+  info->blocksize = pool->blocksize;
+  info->nblocks   = pool->nblocks;
+  info->nreserved = pool->nreserved;
+  info->nfree     = pool->nfree;
+  info->nminfree  = pool->nminfree;
+  info->nfailed   = pool->nfailed;
+  irqrestore(flags);
+}
+
+/****************************************************************************
+ * Name: mempool_foreach
+ *
+ * Description:
+ *   Call 'handler' for every pool that has been created until a handler
+ *   returns a non-zero value.  Pools are never removed from the list so
+ *   the list can be traversed without disabling interrupts.
+ *
+ ****************************************************************************/
+
+int mempool_foreach(mempool_handler_t handler, FAR void *arg)
+{
+  FAR struct mempool_s *pool;
+  int ret = 0;
+
+  for (pool = (FAR struct mempool_s *)g_mempools.head;
+       pool && ret == 0;
+       pool = pool->flink)
+    {
+      ret = handler(pool, arg);
+    }
+
+  return ret;
+}
@@ -87,7 +87,9 @@ FAR void *realloc(FAR void *oldmem, size_t size)
 
   if (!oldmem)
     {
-      return malloc(size);
+      newmem = malloc(size);
+      MM_TRACE(newmem);
+      return newmem;
     }
 
   /* If size is zero, then realloc is equivalent to free */
@@ -98,6 +100,37 @@ FAR void *realloc(FAR void *oldmem, size_t size)
       return NULL;
     }
 
+  /* Map the memory chunk into an allocated node structure */
+
+  oldnode = (FAR struct mm_allocnode_s *)((FAR char*)oldmem - SIZEOF_MM_ALLOCNODE);
+
+#ifdef CONFIG_MM_SLAB
+  /* A slab object cannot grow or shrink.  Keep it if the new size still
+   * fits in the object, otherwise move the data to a new allocation (which
+   * may be another slab object or a heap chunk).
+   */
+
+  if ((oldnode->size & MM_SLAB_BIT) != 0)
+    {
+      oldsize = (oldnode->size & ~MM_SLAB_BIT) - SIZEOF_MM_ALLOCNODE;
+      if (size <= oldsize)
+        {
+          MM_TRACE(oldmem);
+          return oldmem;
+        }
+
+      newmem = malloc(size);
+      if (newmem)
+        {
+          memcpy(newmem, oldmem, oldsize);
+          mm_slabfree(oldmem);
+          MM_TRACE(newmem);
+        }
+
+      return newmem;
+    }
+#endif
+
   /* Adjust the size to account for (1) the size of the allocated
    * node and (2) to make sure that it is an even multiple of
    * our granule size.
@@ -105,10 +138,6 @@ FAR void *realloc(FAR void *oldmem, size_t size)
 
   size = MM_ALIGN_UP(size + SIZEOF_MM_ALLOCNODE);
 
-  /* Map the memory chunk into an allocated node structure */
-
-  oldnode = (FAR struct mm_allocnode_s *)((FAR char*)oldmem - SIZEOF_MM_ALLOCNODE);
-
   /* We need to hold the MM semaphore while we muck with the
    * nodelist.
    */
@@ -131,6 +160,7 @@ FAR void *realloc(FAR void *oldmem, size_t size)
       /* Then return the original address */
 
       mm_givesemaphore();
+      MM_TRACE(oldmem);
       return oldmem;
     }
 
@@ -265,15 +295,16 @@ FAR void *realloc(FAR void *oldmem, size_t size)
                next->preceding     = newnode->size | (next->preceding & MM_ALLOC_BIT);
              }
 
-           oldnode = newnode;
-           oldsize = newnode->size;
-
-          /* Now we have to move the user contents 'down' in memory.  memcpy should
-           * should be save for this.
+          /* Now we have to move the user contents 'down' in memory.  The
+           * old and new regions may overlap so memmove is used, and only
+           * the old contents (not the whole extended chunk) are moved.
            */
 
           newmem = (FAR void*)((FAR char*)newnode + SIZEOF_MM_ALLOCNODE);
-          memcpy(newmem, oldmem, oldsize - SIZEOF_MM_ALLOCNODE);
+          memmove(newmem, oldmem, oldsize - SIZEOF_MM_ALLOCNODE);
+
+          oldnode = newnode;
+          oldsize = newnode->size;
         }
 
       /* Extend into the next free chunk */
@@ -328,6 +359,7 @@ FAR void *realloc(FAR void *oldmem, size_t size)
         }
 
       mm_givesemaphore();
+      MM_TRACE(newmem);
       return newmem;
     }
 
@@ -345,6 +377,7 @@ FAR void *realloc(FAR void *oldmem, size_t size)
          {
            memcpy(newmem, oldmem, oldsize);
            free(oldmem);
+           MM_TRACE(newmem);
          }
 
        return newmem;
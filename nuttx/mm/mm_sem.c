@@ -38,6 +38,7 @@
  ****************************************************************************/
 
 #include "mm_environment.h"
+#include <stdint.h>
 #include <unistd.h>
 #include <semaphore.h>
 #include <errno.h>
@@ -77,6 +78,13 @@ static  sem_t g_mm_semaphore;
 static  pid_t g_holder;
 static  int   g_counts_held;
 
+/* The number of times that the semaphore was taken and the number of
+ * times that a task had to wait for it.
+ */
+
+static  uint32_t g_ntakes;
+static  uint32_t g_nwaits;
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -171,14 +179,19 @@ void mm_takesemaphore(void)
       /* Take the semaphore (perhaps waiting) */
 
       msemdbg("PID=%d taking\n", my_pid);
-      while (sem_wait(&g_mm_semaphore) != 0)
-       {
-         /* The only case that an error should occur here is if
-          * the wait was awakened by a signal.
-          */
-
-         ASSERT(mm_errno == EINTR);
-       }
+      g_ntakes++;
+      if (sem_trywait(&g_mm_semaphore) != 0)
+        {
+          g_nwaits++;
+          while (sem_wait(&g_mm_semaphore) != 0)
+           {
+             /* The only case that an error should occur here is if
+              * the wait was awakened by a signal.
+              */
+
+             ASSERT(mm_errno == EINTR);
+           }
+        }
 
       /* We have it.  Claim the stake and return */
 
@@ -247,3 +260,18 @@ int mm_getsemaphore(void)
 }
 #endif
 
+/****************************************************************************
+ * Name: mm_semstats
+ *
+ * Description:
+ *   Return the number of times that the MM mutex was taken (not counting
+ *   nested takes by the holder) and the number of times that a task had
+ *   to wait for it because another task held it.
+ *
+ ****************************************************************************/
+
+void mm_semstats(FAR uint32_t *ntakes, FAR uint32_t *nwaits)
+{
+  *ntakes = g_ntakes;
+  *nwaits = g_nwaits;
+}
@@ -38,33 +38,55 @@
  ************************************************************************/
 
 #include "mm_environment.h"
+#include <stdint.h>
 #include "mm_internal.h"
 
 /************************************************************************
  * Pre-processor Definitions
  ************************************************************************/
 
+/************************************************************************
+ * Private Data
+ ************************************************************************/
+
+/* Used to find the most significant bit that is set in a word:  After
+ * all of the bits below the most significant bit have been set, the
+ * product of the word and this de Bruijn-like constant has a unique
+ * value in the top five bits for each bit position.
+ */
+
+static const uint8_t g_msbtab[32] =
+{
+   0,  9,  1, 10, 13, 21,  2, 29, 11, 14, 16, 18, 22, 25,  3, 30,
+   8, 12, 20, 28, 15, 17, 24,  7, 19, 27, 23,  6, 26,  5,  4, 31
+};
+
 /************************************************************************
  * Public Functions
  ************************************************************************/
 
-/* Convert the size to a nodelist index */
+/* Convert the size to a nodelist index.  The index is the position of the
+ * most significant bit of size / MM_MIN_CHUNK, limited to MM_NNODES-1.
+ * This is computed without a loop (or data dependent branches) because it
+ * is done for every allocation and for every free.
+ */
 
 int mm_size2ndx(size_t size)
 {
-  int ndx = 0;
+  uint32_t bits;
+
+  /* Sizes of MM_MAX_CHUNK or more all go in the last nodelist entry */
+
+  size = size < MM_MAX_CHUNK ? size : MM_MAX_CHUNK;
+  bits = (uint32_t)(size >> MM_MIN_SHIFT);
 
-  if (size >= MM_MAX_CHUNK)
-    {
-       return MM_NNODES-1;
-    }
+  /* Set all of the bits below the most significant bit */
 
-  size >>= MM_MIN_SHIFT;
-  while (size > 1)
-    {
-      ndx++;
-      size >>= 1;
-    }
+  bits |= bits >> 1;
+  bits |= bits >> 2;
+  bits |= bits >> 4;
+  bits |= bits >> 8;
+  bits |= bits >> 16;
 
-  return ndx;
+  return g_msbtab[(uint32_t)(bits * 0x07c4acddul) >> 27];
 }
@@ -0,0 +1,338 @@
+/************************************************************************
+ * mm/mm_slab.c
+ *
+ *   Copyright (C) 2012 Gregory Nutt. All rights reserved.
+ *   Author: Gregory Nutt <gnutt@nuttx.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name NuttX nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ************************************************************************/
+
+/************************************************************************
+ * Included Files
+ ************************************************************************/
+
+#include <assert.h>
+#include "mm_environment.h"
+#include <stdint.h>
+#include "mm_internal.h"
+
+#ifdef CONFIG_MM_SLAB
+
+/************************************************************************
+ * Pre-processor Definitions
+ ************************************************************************/
+
+/* This is the user size of the heap chunk that holds one slab */
+
+#define MM_SLAB_ALLOCSIZE (CONFIG_MM_SLAB_SIZE - SIZEOF_MM_ALLOCNODE)
+
+/* The size of the heap chunk that holds a slab */
+
+#define MM_SLAB_CHUNKSIZE(s) \
+  (((FAR struct mm_allocnode_s *)((FAR char*)(s) - SIZEOF_MM_ALLOCNODE))->size)
+
+/* The part of a slab that is not used for objects */
+
+#define MM_SLAB_OVERHEAD(s,c) \
+  (MM_SLAB_CHUNKSIZE(s) - (s)->nobjects * (c))
+
+/* Access the link to the next free object */
+
+#define MM_SLAB_NEXT(n) \
+  (*(FAR struct mm_allocnode_s **)((FAR char*)(n) + SIZEOF_MM_ALLOCNODE))
+
+#if CONFIG_MM_SLAB_SIZE < MM_SLAB_MAXCHUNK + 2 * MM_MIN_CHUNK
+#  error "CONFIG_MM_SLAB_SIZE is too small for CONFIG_MM_SLAB_MAXSIZE"
+#endif
+
+/************************************************************************
+ * Public Data
+ ************************************************************************/
+
+/* The number of bytes held in free slab objects.  An empty slab counts
+ * as free in its entirety (including the slab header) so that mallinfo()
+ * reports the same memory usage before and after a sequence of matching
+ * allocations and frees.
+ */
+
+size_t g_slabfree;
+
+/************************************************************************
+ * Private Data
+ ************************************************************************/
+
+/* For each size class, the list of slabs that have free objects */
+
+static FAR struct mm_slab_s *g_slablist[MM_SLAB_NCLASSES];
+
+/************************************************************************
+ * Private Functions
+ ************************************************************************/
+
+/************************************************************************
+ * Name: mm_slabcreate
+ *
+ * Description:
+ *   Allocate a new slab for objects of chunk size 'chunk' from the heap
+ *   and add it to the list of slabs for that size class.
+ *
+ * Assumptions:
+ *   The caller holds the MM semaphore.
+ *
+ ************************************************************************/
+
+static FAR struct mm_slab_s *mm_slabcreate(int ndx, size_t chunk)
+{
+  FAR struct mm_slab_s *slab;
+  FAR struct mm_allocnode_s *node;
+  FAR struct mm_allocnode_s *next;
+  int nobjects;
+  int i;
+
+  slab = (FAR struct mm_slab_s *)mm_heapmalloc(MM_SLAB_ALLOCSIZE);
+  if (!slab)
+    {
+      return NULL;
+    }
+
+  /* Carve the slab into objects and put all of them in the free list.
+   * Each object has a normal chunk header that is marked with
+   * MM_SLAB_BIT and that holds the offset back to the slab.
+   */
+
+  nobjects = (MM_SLAB_ALLOCSIZE - MM_SLAB_HDRSIZE) / chunk;
+  node     = (FAR struct mm_allocnode_s *)((FAR char*)slab + MM_SLAB_HDRSIZE);
+
+  slab->free = node;
+  for (i = 0; i < nobjects; i++)
+    {
+      next            = (FAR struct mm_allocnode_s *)((FAR char*)node + chunk);
+      node->size      = chunk | MM_SLAB_BIT;
+      node->preceding = ((FAR char*)node - (FAR char*)slab) | MM_ALLOC_BIT;
+#ifdef CONFIG_MM_TRACE
+      node->pid       = MM_TRACE_NOPID;
+#endif
+      MM_SLAB_NEXT(node) = next;
+      node            = next;
+    }
+
+  node = (FAR struct mm_allocnode_s *)((FAR char*)node - chunk);
+  MM_SLAB_NEXT(node) = NULL;
+
+  slab->nobjects = nobjects;
+  slab->nfree    = nobjects;
+  g_slabfree    += MM_SLAB_CHUNKSIZE(slab);
+
+#ifdef CONFIG_MM_TRACE
+  /* Mark the heap chunk as a slab so that the objects in it are traced */
+
+  ((FAR struct mm_allocnode_s *)((FAR char*)slab - SIZEOF_MM_ALLOCNODE))->pid =
+    MM_TRACE_SLABPID;
+#endif
+
+  /* The class list must be empty.  Otherwise we would not need a new
+   * slab.
+   */
+
+  slab->flink     = NULL;
+  slab->blink     = NULL;
+  g_slablist[ndx] = slab;
+  return slab;
+}
+
+/************************************************************************
+ * Name: mm_slabunlink
+ *
+ * Description:
+ *   Remove a slab from the list of slabs of its size class.
+ *
+ ************************************************************************/
+
+static inline void mm_slabunlink(FAR struct mm_slab_s *slab, int ndx)
+{
+  if (slab->blink)
+    {
+      slab->blink->flink = slab->flink;
+    }
+  else
+    {
+      g_slablist[ndx] = slab->flink;
+    }
+
+  if (slab->flink)
+    {
+      slab->flink->blink = slab->blink;
+    }
+}
+
+/************************************************************************
+ * Public Functions
+ ************************************************************************/
+
+/************************************************************************
+ * Name: mm_slaballoc
+ *
+ * Description:
+ *   Allocate a small object from the slab of its size class, creating a
+ *   new slab if there is no free object of that class.  Returns NULL if
+ *   a new slab cannot be allocated; then the caller should fall back to
+ *   the heap.
+ *
+ *   The size must be greater than zero and no larger than
+ *   CONFIG_MM_SLAB_MAXSIZE.
+ *
+ ************************************************************************/
+
+FAR void *mm_slaballoc(size_t size)
+{
+  FAR struct mm_slab_s *slab;
+  FAR struct mm_allocnode_s *node;
+  size_t chunk;
+  int ndx;
+
+  DEBUGASSERT(size > 0 && size <= CONFIG_MM_SLAB_MAXSIZE);
+
+  /* Get the size class.  Requests are rounded up exactly as they would
+   * be for a heap chunk.
+   */
+
+  chunk = MM_ALIGN_UP(size + SIZEOF_MM_ALLOCNODE);
+  ndx   = MM_SLAB_NDX(chunk);
+
+  mm_takesemaphore();
+
+  /* Use the first slab with a free object, or get a new slab */
+
+  slab = g_slablist[ndx];
+  if (!slab)
+    {
+      slab = mm_slabcreate(ndx, chunk);
+      if (!slab)
+        {
+          mm_givesemaphore();
+          return NULL;
+        }
+    }
+
+  /* Take the first free object.  If it was the last free object, then
+   * the slab no longer belongs in the list.
+   */
+
+  if (slab->nfree == slab->nobjects)
+    {
+      g_slabfree -= MM_SLAB_OVERHEAD(slab, chunk);
+    }
+
+  node        = slab->free;
+  slab->free  = MM_SLAB_NEXT(node);
+  g_slabfree -= chunk;
+
+  if (--slab->nfree == 0)
+    {
+      mm_slabunlink(slab, ndx);
+    }
+  mm_givesemaphore();
+
+  mvdbg("Allocated %p, size %d\n", (FAR char*)node + SIZEOF_MM_ALLOCNODE, chunk);
+  return (FAR void*)((FAR char*)node + SIZEOF_MM_ALLOCNODE);
+}
+
+/************************************************************************
+ * Name: mm_slabfree
+ *
+ * Description:
+ *   Return an object to its slab.  When every object of a slab is free,
+ *   the slab is returned to the heap -- unless it is the only slab of
+ *   its size class with free objects.  Keeping that one slab avoids
+ *   allocating and freeing a slab for each object when the number of
+ *   objects in use hovers around a multiple of the slab capacity.
+ *
+ ************************************************************************/
+
+void mm_slabfree(FAR void *mem)
+{
+  FAR struct mm_slab_s *slab;
+  FAR struct mm_allocnode_s *node;
+  size_t chunk;
+  int ndx;
+
+  mvdbg("Freeing %p\n", mem);
+
+  node  = (FAR struct mm_allocnode_s *)((FAR char*)mem - SIZEOF_MM_ALLOCNODE);
+  slab  = (FAR struct mm_slab_s *)((FAR char*)node - (node->preceding & ~MM_ALLOC_BIT));
+  chunk = node->size & ~MM_SLAB_BIT;
+  ndx   = MM_SLAB_NDX(chunk);
+
+  DEBUGASSERT((node->size & MM_SLAB_BIT) != 0 && ndx < MM_SLAB_NCLASSES);
+
+  mm_takesemaphore();
+
+  /* Put the object back in the free list of the slab.  If the slab was
+   * full, it goes back in the list of slabs with free objects.
+   */
+
+  MM_SLAB_NEXT(node) = slab->free;
+  slab->free         = node;
+#ifdef CONFIG_MM_TRACE
+  node->pid          = MM_TRACE_NOPID;
+#endif
+  g_slabfree        += chunk;
+
+  if (slab->nfree++ == 0)
+    {
+      slab->blink = NULL;
+      slab->flink = g_slablist[ndx];
+      if (slab->flink)
+        {
+          slab->flink->blink = slab;
+        }
+
+      g_slablist[ndx] = slab;
+    }
+
+  /* Release a completely free slab if there are others in the list */
+
+  if (slab->nfree == slab->nobjects)
+    {
+      if (slab->flink || slab->blink)
+        {
+          mm_slabunlink(slab, ndx);
+          g_slabfree -= slab->nobjects * chunk;
+          mm_heapfree(slab);
+        }
+      else
+        {
+          g_slabfree += MM_SLAB_OVERHEAD(slab, chunk);
+        }
+    }
+
+  mm_givesemaphore();
+}
+
+#endif /* CONFIG_MM_SLAB */
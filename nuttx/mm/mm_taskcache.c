@@ -0,0 +1,300 @@
+/************************************************************************
+ * mm/mm_taskcache.c
+ *
+ *   Copyright (C) 2012 Gregory Nutt. All rights reserved.
+ *   Author: Gregory Nutt <gnutt@nuttx.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name NuttX nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ************************************************************************/
+
+
+/************************************************************************
+ * Included Files
+ ************************************************************************/
+
+#include <assert.h>
+#include "mm_environment.h"
+#include <stdbool.h>
+
+#include <nuttx/arch.h>
+#include <nuttx/sched.h>
+#include <arch/irq.h>
+
+#include "mm_internal.h"
+
+#ifdef CONFIG_MM_TASKCACHE
+
+/************************************************************************
+ * Pre-processor Definitions
+ ************************************************************************/
+
+/* Access the link to the next cached chunk */
+
+#define MM_CACHE_NEXT(m) (*(FAR void **)(m))
+
+/************************************************************************
+ * Public Data
+ ************************************************************************/
+
+/* The number of bytes held in all of the per-task caches.  mallinfo()
+ * reports these bytes as free.
+ */
+
+size_t g_cachebytes;
+
+/************************************************************************
+ * Private Functions
+ ************************************************************************/
+
+/************************************************************************
+ * Name: mm_chunksize
+ *
+ * Description:
+ *   Return the size of the chunk that holds 'mem'.
+ *
+ ************************************************************************/
+
+static inline size_t mm_chunksize(FAR void *mem)
+{
+  FAR struct mm_allocnode_s *node;
+
+  node = (FAR struct mm_allocnode_s *)((FAR char*)mem - SIZEOF_MM_ALLOCNODE);
+#ifdef CONFIG_MM_SLAB
+  return node->size & ~MM_SLAB_BIT;
+#else
+  return node->size;
+#endif
+}
+
+/************************************************************************
+ * Public Functions
+ ************************************************************************/
+
+/************************************************************************
+ * Name: mm_cacheget
+ *
+ * Description:
+ *   Take a chunk for an allocation of 'size' bytes from the cache of the
+ *   calling task.  Returns NULL if the cache has no chunk of that size.
+ *
+ *   The cache belongs to the calling task, so the MM semaphore is not
+ *   needed.  Interrupts are disabled only so that the cache is always
+ *   consistent if the task is deleted by another task.
+ *
+ ************************************************************************/
+
+FAR void *mm_cacheget(size_t size)
+{
+  FAR struct mm_taskcache_s *cache;
+  FAR void *mem;
+  irqstate_t flags;
+  size_t chunk;
+  int ndx;
+
+  if (size == 0 || size > MM_CACHE_MAXCHUNK || up_interrupt_context())
+    {
+      return NULL;
+    }
+
+  chunk = MM_ALIGN_UP(size + SIZEOF_MM_ALLOCNODE);
+  if (chunk > MM_CACHE_MAXCHUNK)
+    {
+      return NULL;
+    }
+
+  ndx   = MM_CACHE_NDX(chunk);
+  cache = &sched_self()->mmcache;
+
+  flags = irqsave();
+  mem   = cache->head[ndx];
+  if (mem)
+    {
+      cache->head[ndx] = MM_CACHE_NEXT(mem);
+      cache->count[ndx]--;
+      g_cachebytes    -= chunk;
+    }
+
+  irqrestore(flags);
+  return mem;
+}
+
+/************************************************************************
+ * Name: mm_cacheput
+ *
+ * Description:
+ *   Put the chunk that holds 'mem' in the cache of the calling task.
+ *   Returns false if the chunk was not cached because it is too large,
+ *   because the cache for its size is full, or because the task is
+ *   exiting.  Then the caller must free the chunk.
+ *
+ ************************************************************************/
+
+bool mm_cacheput(FAR void *mem)
+{
+  FAR struct mm_taskcache_s *cache;
+  irqstate_t flags;
+  size_t chunk;
+  int ndx;
+
+  chunk = mm_chunksize(mem);
+  if (chunk > MM_CACHE_MAXCHUNK || up_interrupt_context())
+    {
+      return false;
+    }
+
+  ndx   = MM_CACHE_NDX(chunk);
+  cache = &sched_self()->mmcache;
+
+  flags = irqsave();
+  if (cache->disabled || cache->count[ndx] >= CONFIG_MM_TASKCACHE_DEPTH)
+    {
+      irqrestore(flags);
+      return false;
+    }
+
+  MM_CACHE_NEXT(mem) = cache->head[ndx];
+  cache->head[ndx]   = mem;
+  cache->count[ndx]++;
+  g_cachebytes      += chunk;
+
+#ifdef CONFIG_MM_TRACE
+  /* A cached chunk is not reported by mm_tracewalk() */
+
+  ((FAR struct mm_allocnode_s *)((FAR char*)mem - SIZEOF_MM_ALLOCNODE))->pid =
+    MM_TRACE_NOPID;
+#endif
+
+  irqrestore(flags);
+  return true;
+}
+
+/************************************************************************
+ * Name: mm_cachepop
+ *
+ * Description:
+ *   Remove any one chunk from a cache.  Returns NULL if the cache is
+ *   empty.  Interrupts must be disabled by the caller.
+ *
+ ************************************************************************/
+
+static FAR void *mm_cachepop(FAR struct mm_taskcache_s *cache)
+{
+  FAR void *mem;
+  int ndx;
+
+  for (ndx = 0; ndx < CONFIG_MM_TASKCACHE_NCLASSES; ndx++)
+    {
+      mem = cache->head[ndx];
+      if (mem)
+        {
+          cache->head[ndx] = MM_CACHE_NEXT(mem);
+          cache->count[ndx]--;
+          g_cachebytes    -= mm_chunksize(mem);
+          return mem;
+        }
+    }
+
+  return NULL;
+}
+
+/************************************************************************
+ * Name: mm_cachedrain
+ *
+ * Description:
+ *   Remove one chunk from the cache of a task that is exiting.  The cache
+ *   is disabled so that no more chunks are added to it.  This is called
+ *   repeatedly by sched_releasetcb() and each chunk is then freed with
+ *   sched_free().
+ *
+ * Input parameters:
+ *   cache - The cache in the TCB of the exiting task
+ *
+ * Returned Value:
+ *   A cached chunk or NULL if the cache is empty.
+ *
+ ************************************************************************/
+
+FAR void *mm_cachedrain(FAR struct mm_taskcache_s *cache)
+{
+  FAR void *mem;
+  irqstate_t flags;
+
+  flags = irqsave();
+  cache->disabled = true;
+  mem = mm_cachepop(cache);
+  irqrestore(flags);
+  return mem;
+}
+
+/************************************************************************
+ * Name: mm_cacheflush
+ *
+ * Description:
+ *   Return every chunk in the cache of the calling task to the heap.  A
+ *   cached chunk keeps its slab (if any) from being released and may
+ *   keep free heap chunks from being coalesced.  This may be called
+ *   before measuring heap usage or when a task is done with a burst of
+ *   allocations.
+ *
+ ************************************************************************/
+
+void mm_cacheflush(void)
+{
+  FAR struct mm_taskcache_s *cache = &sched_self()->mmcache;
+#ifdef CONFIG_MM_SLAB
+  FAR struct mm_allocnode_s *node;
+#endif
+  FAR void *mem;
+  irqstate_t flags;
+
+  for (;;)
+    {
+      flags = irqsave();
+      mem = mm_cachepop(cache);
+      irqrestore(flags);
+
+      if (!mem)
+        {
+          break;
+        }
+
+#ifdef CONFIG_MM_SLAB
+      node = (FAR struct mm_allocnode_s *)((FAR char*)mem - SIZEOF_MM_ALLOCNODE);
+      if ((node->size & MM_SLAB_BIT) != 0)
+        {
+          mm_slabfree(mem);
+          continue;
+        }
+#endif
+
+      mm_heapfree(mem);
+    }
+}
+
+#endif /* CONFIG_MM_TASKCACHE */
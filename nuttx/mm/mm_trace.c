@@ -0,0 +1,263 @@
+/************************************************************************
+ * mm/mm_trace.c
+ *
+ *   Copyright (C) 2012 Gregory Nutt. All rights reserved.
+ *   Author: Gregory Nutt <gnutt@nuttx.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name NuttX nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ************************************************************************/
+
+
+/************************************************************************
+ * Included Files
+ ************************************************************************/
+
+#include <assert.h>
+#include "mm_environment.h"
+#include <unistd.h>
+#include "mm_internal.h"
+
+#ifdef CONFIG_MM_TRACE
+
+/************************************************************************
+ * Private Functions
+ ************************************************************************/
+
+/************************************************************************
+ * Name: mm_traceslab
+ *
+ * Description:
+ *   Report each object that is in use in one slab.
+ *
+ ************************************************************************/
+
+#ifdef CONFIG_MM_SLAB
+static int mm_traceslab(FAR struct mm_allocnode_s *slabnode,
+                        mm_tracehandler_t handler, FAR void *arg)
+{
+  FAR struct mm_slab_s *slab;
+  FAR struct mm_allocnode_s *node;
+  struct mm_traceinfo_s info;
+  size_t chunk;
+  int ret = 0;
+  int i;
+
+  slab  = (FAR struct mm_slab_s *)((FAR char*)slabnode + SIZEOF_MM_ALLOCNODE);
+  node  = (FAR struct mm_allocnode_s *)((FAR char*)slab + MM_SLAB_HDRSIZE);
+  chunk = node->size & ~MM_SLAB_BIT;
+
+  for (i = 0; i < slab->nobjects && ret == 0; i++)
+    {
+      if (node->pid != MM_TRACE_NOPID)
+        {
+          info.mem    = (FAR char*)node + SIZEOF_MM_ALLOCNODE;
+          info.size   = chunk;
+          info.pid    = node->pid;
+          info.caller = node->caller;
+          ret         = handler(&info, arg);
+        }
+
+      node = (FAR struct mm_allocnode_s *)((FAR char*)node + chunk);
+    }
+
+  return ret;
+}
+#endif
+
+/************************************************************************
+ * Public Functions
+ ************************************************************************/
+
+/************************************************************************
+ * Name: mm_settrace
+ *
+ * Description:
+ *   Record the current task and the caller in the header of a chunk
+ *   that was just allocated.  'mem' may be NULL if the allocation
+ *   failed.
+ *
+ ************************************************************************/
+
+void mm_settrace(FAR void *mem, FAR void *caller)
+{
+  FAR struct mm_allocnode_s *node;
+
+  if (mem)
+    {
+      node         = (FAR struct mm_allocnode_s *)((FAR char*)mem - SIZEOF_MM_ALLOCNODE);
+      node->pid    = (int16_t)getpid();
+      node->caller = caller;
+    }
+}
+
+/************************************************************************
+ * Name: mm_tracewalk
+ *
+ * Description:
+ *   Call 'handler' for each allocation in the heap (including each slab
+ *   object that is in use), in address order, until the handler returns
+ *   a non-zero value.
+ *
+ *   The handler is called with the MM semaphore held.  It must not
+ *   allocate or free memory.
+ *
+ * Returned Value:
+ *   The non-zero value returned by the handler or zero if the handler
+ *   was called for every allocation.
+ *
+ ************************************************************************/
+
+int mm_tracewalk(mm_tracehandler_t handler, FAR void *arg)
+{
+  FAR struct mm_allocnode_s *node;
+  struct mm_traceinfo_s info;
+  int ret = 0;
+#if CONFIG_MM_REGIONS > 1
+  int region;
+#else
+# define region 0
+#endif
+
+  mm_takesemaphore();
+
+#if CONFIG_MM_REGIONS > 1
+  for (region = 0; region < g_nregions && ret == 0; region++)
+#endif
+    {
+      /* Visit each node between the guard nodes at the beginning and the
+       * end of the region.
+       */
+
+      for (node = (FAR struct mm_allocnode_s *)((FAR char*)g_heapstart[region] + SIZEOF_MM_ALLOCNODE);
+           node < g_heapend[region] && ret == 0;
+           node = (FAR struct mm_allocnode_s *)((FAR char*)node + node->size))
+        {
+          /* Skip free chunks and chunks in a per-task cache */
+
+          if ((node->preceding & MM_ALLOC_BIT) == 0 ||
+              node->pid == MM_TRACE_NOPID)
+            {
+              continue;
+            }
+
+#ifdef CONFIG_MM_SLAB
+          if (node->pid == MM_TRACE_SLABPID)
+            {
+              ret = mm_traceslab(node, handler, arg);
+              continue;
+            }
+#endif
+
+          info.mem    = (FAR char*)node + SIZEOF_MM_ALLOCNODE;
+          info.size   = node->size;
+          info.pid    = node->pid;
+          info.caller = node->caller;
+          ret         = handler(&info, arg);
+        }
+    }
+#undef region
+
+  mm_givesemaphore();
+  return ret;
+}
+
+/************************************************************************
+ * Name: mm_freebins
+ *
+ * Description:
+ *   Get a histogram of the free chunks in the heap.  Free chunks are
+ *   counted in the same size ranges that are used for the free lists:
+ *   bin 'n' holds the chunks of at least MM_MIN_CHUNK << n bytes.  The
+ *   last bin holds all of the larger chunks.  Free slab objects are not
+ *   included.
+ *
+ * Input parameters:
+ *   bins  - The histogram is returned here
+ *   nbins - The number of entries in 'bins'
+ *
+ * Returned Value:
+ *   The number of bins that were returned.
+ *
+ ************************************************************************/
+
+int mm_freebins(FAR struct mm_freebin_s *bins, int nbins)
+{
+  FAR struct mm_allocnode_s *node;
+  int ndx;
+#if CONFIG_MM_REGIONS > 1
+  int region;
+#else
+# define region 0
+#endif
+
+  if (nbins > MM_NNODES)
+    {
+      nbins = MM_NNODES;
+    }
+
+  for (ndx = 0; ndx < nbins; ndx++)
+    {
+      bins[ndx].minsize = (size_t)MM_MIN_CHUNK << ndx;
+      bins[ndx].nchunks = 0;
+      bins[ndx].nbytes  = 0;
+    }
+
+  mm_takesemaphore();
+
+#if CONFIG_MM_REGIONS > 1
+  for (region = 0; region < g_nregions; region++)
+#endif
+    {
+      for (node = g_heapstart[region];
+           node < g_heapend[region];
+           node = (FAR struct mm_allocnode_s *)((FAR char*)node + node->size))
+        {
+          if ((node->preceding & MM_ALLOC_BIT) == 0)
+            {
+              ndx = mm_size2ndx(node->size);
+              if (ndx >= nbins)
+                {
+                  ndx = nbins - 1;
+                }
+
+              if (ndx >= 0)
+                {
+                  bins[ndx].nchunks++;
+                  bins[ndx].nbytes += node->size;
+                }
+            }
+        }
+    }
+#undef region
+
+  mm_givesemaphore();
+  return nbins;
+}
+
+#endif /* CONFIG_MM_TRACE */
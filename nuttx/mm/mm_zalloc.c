@@ -62,6 +62,7 @@ FAR void *zalloc(size_t size)
   if (alloc)
     {
        memset(alloc, 0, size);
+       MM_TRACE(alloc);
     }
 
   return alloc;
@@ -90,6 +90,9 @@ struct tcp_close_s
 static uint16_t netclose_interrupt(struct uip_driver_s *dev, void *pvconn,
                                    void *pvpriv, uint16_t flags)
 {
+#if CONFIG_NET_TCP_SENDQSIZE > 0
+  struct uip_conn *conn = (struct uip_conn*)pvconn;
+#endif
   struct tcp_close_s *pstate = (struct tcp_close_s *)pvpriv;
 
   nllvdbg("flags: %04x\n", flags);
@@ -98,9 +101,10 @@ static uint16_t netclose_interrupt(struct uip_driver_s *dev, void *pvconn,
     {
       /* UIP_CLOSE: The remote host has closed the connection
        * UIP_ABORT: The remote host has aborted the connection
+       * UIP_TIMEDOUT: The connection was lost
        */
 
-      if ((flags & (UIP_CLOSE|UIP_ABORT)) != 0)
+      if ((flags & (UIP_CLOSE|UIP_ABORT|UIP_TIMEDOUT)) != 0)
         {
           /* The disconnection is complete */
 
@@ -110,6 +114,20 @@ static uint16_t netclose_interrupt(struct uip_driver_s *dev, void *pvconn,
           sem_post(&pstate->cl_sem);
           nllvdbg("Resuming\n");
         }
+      /* Data queued by send() must be sent and acknowledged before the
+       * connection is closed.
+       */
+
+#if CONFIG_NET_TCP_SENDQSIZE > 0
+      else if (conn->unacked > 0 || conn->sndq != NULL)
+        {
+          /* Drop data received in this state */
+
+          dev->d_len = 0;
+          return flags & ~UIP_NEWDATA;
+        }
+#endif
+
       else
         {
           /* Drop data received in this state and make sure that UIP_CLOSE
@@ -170,7 +188,7 @@ static inline void netclose_disconnect(FAR struct socket *psock)
                state.cl_psock       = psock;
                sem_init(&state.cl_sem, 0, 0);
 
-               state.cl_cb->flags   = UIP_NEWDATA|UIP_POLL|UIP_CLOSE|UIP_ABORT;
+               state.cl_cb->flags   = UIP_NEWDATA|UIP_ACKDATA|UIP_POLL|UIP_CLOSE|UIP_ABORT|UIP_TIMEDOUT;
                state.cl_cb->priv    = (void*)&state;
                state.cl_cb->event   = netclose_interrupt;
 
@@ -253,6 +271,9 @@ int net_closesocket(FAR struct socket *psock)
                   netclose_disconnect(psock);  /* Break any current connections */
                   conn->crefs = 0;             /* No more references on the connection */
                   uip_tcpfree(conn);           /* Free uIP resources */
+#if CONFIG_NET_NTCP_READAHEAD_BUFFERS > 0
+                  net_tcpwndupdate();          /* Read-ahead buffers were freed */
+#endif
                 }
               else
                 {
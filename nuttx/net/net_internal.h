@@ -159,6 +159,12 @@ EXTERN FAR struct socket *sockfd_socket(int sockfd);
 
 EXTERN int net_closesocket(FAR struct socket *psock);
 
+/* net_tcpwnd.c **************************************************************/
+
+#if defined(CONFIG_NET_TCP) && CONFIG_NET_NTCP_READAHEAD_BUFFERS > 0
+EXTERN void net_tcpwndupdate(void);
+#endif
+
 /* sockopt support ***********************************************************/
 
 #if defined(CONFIG_NET_SOCKOPTS) && !defined(CONFIG_DISABLE_CLOCK)
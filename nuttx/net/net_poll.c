@@ -51,6 +51,7 @@
 #include <net/uip/uip.h>
 #include <nuttx/net.h>
 #include <nuttx/arch.h>
+#include <nuttx/fs.h>
 
 #include <uip/uip_internal.h>
 
@@ -137,8 +138,7 @@ static uint16_t poll_interrupt(struct uip_driver_s *dev, FAR void *conn,
 
       if (eventset)
         {
-          fds->revents |= eventset;
-          sem_post(fds->sem);
+          poll_notify(&fds, 1, eventset);
         }
     }
   return flags;
@@ -211,13 +211,9 @@ static inline int net_pollsetup(FAR struct socket *psock, struct pollfd *fds)
   if (!sq_empty(&conn->readahead))
 #endif
     {
-      fds->revents = fds->events & POLLIN;
-      if (fds->revents != 0)
-        {
-          /* If data is available now, the signal the poll logic */
+      /* If data is available now, the signal the poll logic */
 
-          sem_post(fds->sem);
-        }
+      poll_notify(&fds, 1, POLLIN);
     }
   uip_unlock(flags);
   return OK;
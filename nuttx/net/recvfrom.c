@@ -50,6 +50,7 @@
 #include <arch/irq.h>
 #include <nuttx/clock.h>
 #include <net/uip/uip-arch.h>
+#include <net/uip/uip-iob.h>
 
 #include "net_internal.h"
 #include "uip/uip_internal.h"
@@ -137,9 +138,12 @@ static void recvfrom_newdata(struct uip_driver_s *dev, struct recvfrom_s *pstate
   pstate->rf_buffer  += recvlen;
   pstate->rf_buflen  -= recvlen;
 
-  /* Indicate no data in the buffer */
+  /* Remove the data from the packet.  Any data that did not fit into the
+   * user buffer remains in dev->d_appdata.
+   */
 
-  dev->d_len = 0;
+  dev->d_appdata += recvlen;
+  dev->d_len    -= recvlen;
 }
 #endif /* CONFIG_NET_UDP || CONFIG_NET_TCP */
 
@@ -157,7 +161,7 @@ static void recvfrom_newdata(struct uip_driver_s *dev, struct recvfrom_s *pstate
  *   None
  *
  * Assumptions:
- *   Running at the interrupt level
+ *   Called from user logic.  The network need not be locked.
  *
  ****************************************************************************/
 
@@ -167,11 +171,14 @@ static inline void recvfrom_readahead(struct recvfrom_s *pstate)
   struct uip_conn        *conn = (struct uip_conn *)pstate->rf_sock->s_conn;
   struct uip_readahead_s *readahead;
   size_t                  recvlen;
+  uip_lock_t              flags;
 
   /* Check there is any TCP data already buffered in a read-ahead
-   * buffer.
+   * buffer.  The read-ahead buffers are protected by the connection lock
+   * so this does not need the network to be locked.
    */
 
+  flags = uip_connlock(conn);
   do
     {
       /* Get the read-ahead buffer at the head of the list (if any) */
@@ -227,9 +234,81 @@ static inline void recvfrom_readahead(struct recvfrom_s *pstate)
         }
     }
   while (readahead && pstate->rf_buflen > 0);
+
+  uip_connunlock(conn, flags);
 }
 #endif /* CONFIG_NET_UDP || CONFIG_NET_TCP */
 
+/****************************************************************************
+ * Function: recvfrom_udpreadahead
+ *
+ * Description:
+ *   Copy the oldest datagram in the UDP read-ahead queue (if any) into the
+ *   user buffer.  As with any datagram, data that does not fit into the
+ *   user buffer is discarded.
+ *
+ * Parameters:
+ *   pstate   recvfrom state structure
+ *
+ * Returned Value:
+ *   true if a datagram was read from the read-ahead queue
+ *
+ * Assumptions:
+ *   The network need not be locked.  The read-ahead queue is protected by
+ *   the connection lock.
+ *
+ ****************************************************************************/
+
+#if defined(CONFIG_NET_UDP) && CONFIG_NET_UDP_NREADAHEAD > 0
+static inline bool recvfrom_udpreadahead(struct recvfrom_s *pstate)
+{
+  struct uip_udp_conn  *conn = (struct uip_udp_conn *)pstate->rf_sock->s_conn;
+  struct uip_iob_s     *iob;
+  struct uip_udprahdr_s hdr;
+  uip_lock_t            flags;
+#ifdef CONFIG_NET_IPv6
+  FAR struct sockaddr_in6 *infrom = pstate->rf_from;
+#else
+  FAR struct sockaddr_in *infrom  = pstate->rf_from;
+#endif
+
+  /* Once the datagram has been removed from the read-ahead queue, it
+   * belongs to us and can be copied without holding the connection lock.
+   */
+
+  flags = uip_connlock(conn);
+  iob   = (struct uip_iob_s *)sq_remfirst(&conn->readahead);
+  if (iob)
+    {
+      conn->nreadahead--;
+    }
+
+  uip_connunlock(conn, flags);
+  if (!iob)
+    {
+      return false;
+    }
+
+  /* Get the sender's address and the datagram data */
+
+  (void)uip_iobcopyout((FAR uint8_t *)&hdr, iob, sizeof(hdr), 0);
+  pstate->rf_recvlen = uip_iobcopyout((FAR uint8_t *)pstate->rf_buffer, iob,
+                                      pstate->rf_buflen, sizeof(hdr));
+  nllvdbg("Received %d bytes (of %d)\n",
+          (int)pstate->rf_recvlen, (int)(iob->io_pktlen - sizeof(hdr)));
+
+  if (infrom)
+    {
+      infrom->sin_family = AF_INET;
+      infrom->sin_port   = hdr.rport;
+      uip_ipaddr_copy(infrom->sin_addr.s_addr, hdr.ripaddr);
+    }
+
+  uip_iobfreechain(iob);
+  return true;
+}
+#endif
+
 /****************************************************************************
  * Function: recvfrom_timeout
  *
@@ -382,10 +461,16 @@ static uint16_t recvfrom_tcpinterrupt(struct uip_driver_s *dev, void *conn,
           recvfrom_tcpsender(dev, pstate);
 
           /* Indicate that the data has been consumed and that an ACK
-           * should be sent.
+           * should be sent.  If the user buffer could not hold all of the
+           * data, the rest is still new data that will be placed in a
+           * read-ahead buffer (if possible).
            */
 
-          flags = (flags & ~UIP_NEWDATA) | UIP_SNDACK;
+          flags |= UIP_SNDACK;
+          if (dev->d_len == 0)
+            {
+              flags &= ~UIP_NEWDATA;
+            }
 
           /* If the user buffer has been filled, then we are finished. */
 
@@ -393,8 +478,8 @@ static uint16_t recvfrom_tcpinterrupt(struct uip_driver_s *dev, void *conn,
             {
               nllvdbg("TCP resume\n");
 
-              /* The TCP receive buffer is full.  Return now, perhaps truncating
-               * the received data (need to fix that).
+              /* The TCP receive buffer is full.  Return now.  Any remaining
+               * data will be buffered in a read-ahead buffer (if possible).
                *
                * Don't allow any further TCP call backs.
                */
@@ -574,8 +659,11 @@ static uint16_t recvfrom_udpinterrupt(struct uip_driver_s *dev, void *pvconn,
 
           recvfrom_udpsender(dev, pstate);
 
-         /* Indicate that the data has been consumed */
+         /* Indicate that the data has been consumed.  Any part of the
+          * datagram that did not fit into the user buffer is discarded.
+          */
 
+          dev->d_len = 0;
           flags &= ~UIP_NEWDATA;
 
            /* Wake up the waiting thread, returning the number of bytes
@@ -773,20 +861,43 @@ static ssize_t udp_recvfrom(FAR struct socket *psock, FAR void *buf, size_t len,
 
   /* Perform the UDP recvfrom() operation */
 
-  /* Initialize the state structure.  This is done with interrupts
-   * disabled because we don't want anything to happen until we
+  recvfrom_init(psock, buf, len, infrom, &state);
+
+#if CONFIG_NET_UDP_NREADAHEAD > 0
+  /* Return a datagram that was received before recvfrom() was called.  The
+   * read-ahead queue has its own lock so the network need not be locked
+   * for this.
+   */
+
+  if (recvfrom_udpreadahead(&state))
+    {
+      recvfrom_uninit(&state);
+      return state.rf_recvlen;
+    }
+#endif
+
+  /* Lock the network because we don't want anything to happen until we
    * are ready.
    */
 
   save = uip_lock();
-  recvfrom_init(psock, buf, len, infrom, &state);
+
+#if CONFIG_NET_UDP_NREADAHEAD > 0
+  /* A datagram may have been buffered before the network was locked */
+
+  if (recvfrom_udpreadahead(&state))
+    {
+      ret = state.rf_recvlen;
+      goto errout_with_lock;
+    }
+#endif
 
   /* Setup the UDP remote connection */
 
   ret = uip_udpconnect(conn, NULL);
   if (ret < 0)
     {
-      goto errout_with_state;
+      goto errout_with_lock;
     }
 
   /* Set up the callback in the connection */
@@ -823,7 +934,7 @@ static ssize_t udp_recvfrom(FAR struct socket *psock, FAR void *buf, size_t len,
       ret = -EBUSY;
     }
 
-errout_with_state:
+errout_with_lock:
   uip_unlock(save);
   recvfrom_uninit(&state);
   return ret;
@@ -859,25 +970,45 @@ static ssize_t tcp_recvfrom(FAR struct socket *psock, FAR void *buf, size_t len,
                             FAR struct sockaddr_in *infrom )
 #endif
 {
+  struct uip_conn        *conn = (struct uip_conn *)psock->s_conn;
   struct recvfrom_s       state;
   uip_lock_t              save;
   int                     ret;
 
-  /* Initialize the state structure.  This is done with interrupts
-   * disabled because we don't want anything to happen until we
-   * are ready.
-   */
-
-  save = uip_lock();
   recvfrom_init(psock, buf, len, infrom, &state);
 
   /* Handle any any TCP data already buffered in a read-ahead buffer.  NOTE
    * that there may be read-ahead data to be retrieved even after the
-   * socket has been disconnected.
+   * socket has been disconnected.  The read-ahead buffers have their own
+   * lock so this copy is done before the network is locked.
    */
 
 #if CONFIG_NET_NTCP_READAHEAD_BUFFERS > 0
   recvfrom_readahead(&state);
+#endif
+
+  /* Now lock the network because we don't want anything to happen until we
+   * are ready.
+   */
+
+  save = uip_lock();
+
+#if CONFIG_NET_NTCP_READAHEAD_BUFFERS > 0
+  /* More data may have been buffered before the network was locked.  It
+   * must be taken now or it would be received out of order.
+   */
+
+  if (state.rf_buflen > 0)
+    {
+      recvfrom_readahead(&state);
+    }
+
+  /* Taking data out of the read-ahead buffers opens the receive window of
+   * this connection and, if buffers were returned to the pool, of the other
+   * connections.  Let the peers know with window updates.
+   */
+
+  net_tcpwndupdate();
 
   /* The default return value is the number of bytes that we just copied into
    * the user buffer.  We will return this if the socket has become disconnected
@@ -947,8 +1078,6 @@ static ssize_t tcp_recvfrom(FAR struct socket *psock, FAR void *buf, size_t len,
 #endif
   if (state.rf_buflen > 0)
     {
-      struct uip_conn *conn = (struct uip_conn *)psock->s_conn;
-
       /* Set up the callback in the connection */
 
       state.rf_cb = uip_tcpcallbackalloc(conn);
@@ -958,6 +1087,18 @@ static ssize_t tcp_recvfrom(FAR struct socket *psock, FAR void *buf, size_t len,
           state.rf_cb->priv    = (void*)&state;
           state.rf_cb->event   = recvfrom_tcpinterrupt;
 
+#if CONFIG_NET_NTCP_READAHEAD_BUFFERS > 0
+          /* The window is not limited by the read-ahead buffers while we
+           * wait.  Open it now if the peer was told that it is closed.
+           */
+
+          conn->ackflags |= UIP_RCVWAIT;
+          if (uip_tcpwndupdate(conn))
+            {
+              netdev_txnotify(&conn->ripaddr);
+            }
+#endif
+
           /* Wait for either the receive to complete or for an error/timeout to occur.
            * NOTES:  (1) uip_lockedwait will also terminate if a signal is received, (2)
            * interrupts may be disabled!  They will be re-enabled while the task sleeps
@@ -969,6 +1110,9 @@ static ssize_t tcp_recvfrom(FAR struct socket *psock, FAR void *buf, size_t len,
           /* Make sure that no further interrupts are processed */
 
           uip_tcpcallbackfree(conn, state.rf_cb);
+#if CONFIG_NET_NTCP_READAHEAD_BUFFERS > 0
+          conn->ackflags &= ~UIP_RCVWAIT;
+#endif
           ret = recvfrom_result(ret, &state);
         }
       else
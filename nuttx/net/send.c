@@ -151,14 +151,24 @@ static inline int send_timeout(struct send_s *pstate)
  *
  ****************************************************************************/
 
+#if CONFIG_NET_TCP_SENDQSIZE == 0
 static uint16_t send_interrupt(struct uip_driver_s *dev, void *pvconn,
                                void *pvpriv, uint16_t flags)
 {
   struct uip_conn *conn = (struct uip_conn*)pvconn;
   struct send_s *pstate = (struct send_s *)pvpriv;
+  uint32_t sndoff;
 
-  nllvdbg("flags: %04x acked: %d sent: %d\n",
-          flags, pstate->snd_acked, pstate->snd_sent);
+  /* Get the offset into the buffer of the next data to send.  uIP sends
+   * data at sequence number sndseq + sent where sndseq is the oldest
+   * unacknowledged sequence number.  After a retransmission, 'sent' goes
+   * back to zero and so we will re-send data from the last that was ACKed.
+   */
+
+  sndoff = uip_tcpaddsequence(conn->sndseq, conn->sent) - pstate->snd_isn;
+
+  nllvdbg("flags: %04x acked: %d sent: %d sndoff: %d\n",
+          flags, pstate->snd_acked, pstate->snd_sent, sndoff);
 
   /* If this packet contains an acknowledgement, then update the count of
    * acknowldged bytes.
@@ -190,19 +200,6 @@ static uint16_t send_interrupt(struct uip_driver_s *dev, void *pvconn,
       /* No.. fall through to send more data if necessary */
     }
 
-  /* Check if we are being asked to retransmit data */
-
-  else if ((flags & UIP_REXMIT) != 0)
-    {
-      /* Yes.. in this case, reset the number of bytes that have been sent
-       * to the number of bytes that have been ACKed.
-       */
-
-      pstate->snd_sent = pstate->snd_acked;
-
-      /* Fall through to re-send data from the last that was ACKed */
-    }
-
  /* Check for a loss of connection */
 
   else if ((flags & (UIP_CLOSE|UIP_ABORT|UIP_TIMEDOUT)) != 0)
@@ -235,55 +232,42 @@ static uint16_t send_interrupt(struct uip_driver_s *dev, void *pvconn,
    * next polling cycle.
    */
 
-  if ((flags & UIP_NEWDATA) == 0 && pstate->snd_sent < pstate->snd_buflen)
+  if ((flags & UIP_NEWDATA) == 0 && sndoff < pstate->snd_buflen)
     {
-      uint32_t seqno;
+      /* Get the amount of data that we can send in the next packet.  This
+       * is limited by the MSS and by the peer's receive window.
+       */
 
-      /* Get the amount of data that we can send in the next packet */
+      uint32_t sndlen = pstate->snd_buflen - sndoff;
+      uint16_t avail  = uip_tcpwndavail(conn);
 
-      uint32_t sndlen = pstate->snd_buflen - pstate->snd_sent;
-      if (sndlen > uip_mss(conn))
+      if (sndlen > avail)
         {
-          sndlen = uip_mss(conn);
+          sndlen = avail;
         }
 
-      /* Set the sequence number for this packet.  NOTE:  uIP updates
-       * sndseq on recept of ACK *before* this function is called.  In that
-       * case sndseq will point to the next unacknowledge byte (which might
-       * have already been sent).  We will overwrite the value of sndseq
-       * here before the packet is sent.
-       */
-
-      seqno = pstate->snd_sent + pstate->snd_isn;
-      nllvdbg("SEND: sndseq %08x->%08x\n", conn->sndseq, seqno);
-      uip_tcpsetsequence(conn->sndseq, seqno);
-
       /* Then set-up to send that amount of data. (this won't actually
-       * happen until the polling cycle completes).
+       * happen until the polling cycle completes).  With scatter/gather
+       * support, the data is sent directly from the caller's buffer.  That
+       * is safe because send() does not return until all of the data has
+       * been acknowledged.
        */
 
-      uip_send(dev, &pstate->snd_buffer[pstate->snd_sent], sndlen);
-
-      /* Check if the destination IP address is in the ARP table.  If not,
-       * then the send won't actually make it out... it will be replaced with
-       * an ARP request.
-       *
-       * NOTE 1: This could an expensive check if there are a lot of entries
-       * in the ARP table.  Hence, we only check on the first packet -- when
-       * snd_sent is zero.
-       *
-       * NOTE 2: If we are actually harvesting IP addresses on incomming IP
-       * packets, then this check should not be necessary; the MAC mapping
-       * should already be in the ARP table.
-       */
-
-#if defined(CONFIG_NET_ETHERNET) && defined (CONFIG_NET_ARP_IPIN)
-      if (pstate->snd_sent != 0 || uip_arp_find(conn->ripaddr) != NULL)
-#endif
+      if (sndlen > 0)
         {
+#ifdef CONFIG_NET_SGSEND
+          uip_sgsend(dev, &pstate->snd_buffer[sndoff], sndlen);
+#else
+          uip_send(dev, &pstate->snd_buffer[sndoff], sndlen);
+#endif
+
           /* Update the amount of data sent (but not necessarily ACKed) */
 
-          pstate->snd_sent += sndlen;
+          if (sndoff + sndlen > pstate->snd_sent)
+            {
+              pstate->snd_sent = sndoff + sndlen;
+            }
+
           nllvdbg("SEND: acked=%d sent=%d buflen=%d\n",
                   pstate->snd_acked, pstate->snd_sent, pstate->snd_buflen);
 
@@ -321,15 +305,206 @@ end_wait:
   pstate->snd_cb->priv    = NULL;
   pstate->snd_cb->event   = NULL;
 
-  /* There are no outstanding, unacknowledged bytes */
+  /* Wake up the waiting thread */
 
-  conn->unacked           = 0;
+  sem_post(&pstate->snd_sem);
+  return flags;
+}
+#endif /* CONFIG_NET_TCP_SENDQSIZE == 0 */
 
-  /* Wake up the waiting thread */
+/****************************************************************************
+ * Function: sendq_interrupt
+ *
+ * Description:
+ *   This function is called from the interrupt level while send() waits for
+ *   space in the send queue of the connection.  Space becomes available when
+ *   queued data is acknowledged.
+ *
+ * Parameters:
+ *   dev      The sructure of the network driver that caused the interrupt
+ *   conn     The connection structure associated with the socket
+ *   flags    Set of events describing why the callback was invoked
+ *
+ * Returned Value:
+ *   None
+ *
+ * Assumptions:
+ *   Running at the interrupt level
+ *
+ ****************************************************************************/
+
+#if CONFIG_NET_TCP_SENDQSIZE > 0
+static uint16_t sendq_interrupt(struct uip_driver_s *dev, void *pvconn,
+                                void *pvpriv, uint16_t flags)
+{
+  struct uip_conn *conn = (struct uip_conn*)pvconn;
+  struct send_s *pstate = (struct send_s *)pvpriv;
+
+  nllvdbg("flags: %04x\n", flags);
+
+  /* Check for a loss of connection */
+
+  if ((flags & (UIP_CLOSE|UIP_ABORT|UIP_TIMEDOUT)) != 0)
+    {
+      nllvdbg("Lost connection\n");
+      pstate->snd_sent = -ENOTCONN;
+    }
+
+  /* Some queued data has been acknowledged.  Or, if nothing at all is
+   * queued for this connection, then the I/O buffers are in use elsewhere;
+   * just try again on each poll.
+   */
+
+  else if ((flags & UIP_ACKDATA) == 0 &&
+           ((flags & UIP_POLL) == 0 || conn->sndq != NULL))
+    {
+#if defined(CONFIG_NET_SOCKOPTS) && !defined(CONFIG_DISABLE_CLOCK)
+      /* Check for a timeout */
+
+      if ((flags & UIP_POLL) == 0 || !send_timeout(pstate))
+        {
+          return flags;
+        }
+
+      nlldbg("SEND timeout\n");
+      pstate->snd_sent = -ETIMEDOUT;
+#else
+      return flags;
+#endif
+    }
+
+  /* Do not allow any further callbacks and wake up the waiting thread */
+
+  pstate->snd_cb->flags   = 0;
+  pstate->snd_cb->priv    = NULL;
+  pstate->snd_cb->event   = NULL;
 
   sem_post(&pstate->snd_sem);
   return flags;
 }
+#endif /* CONFIG_NET_TCP_SENDQSIZE */
+
+/****************************************************************************
+ * Function: send_queued
+ *
+ * Description:
+ *   Copy the data to send into the send queue of the connection and return
+ *   without waiting for it to be sent or acknowledged.  uIP sends the queued
+ *   data as the peer's window allows and retransmits it from the queue as
+ *   necessary.  If the queue is full, wait until some of the queued data
+ *   has been acknowledged.
+ *
+ * Parameters:
+ *   psock    The socket to send on
+ *   buf      Data to send
+ *   len      Length of data to send
+ *
+ * Returned Value:
+ *   The number of bytes queued or a negated errno value if nothing could be
+ *   queued.
+ *
+ * Assumptions:
+ *   Called from normal user-level logic
+ *
+ ****************************************************************************/
+
+#if CONFIG_NET_TCP_SENDQSIZE > 0
+static ssize_t send_queued(FAR struct socket *psock, FAR const uint8_t *buf,
+                           size_t len)
+{
+  struct uip_conn *conn = (struct uip_conn*)psock->s_conn;
+  struct send_s state;
+  uip_lock_t save;
+  size_t nqueued = 0;
+  int ret = OK;
+
+  memset(&state, 0, sizeof(struct send_s));
+  state.snd_sock = psock;
+
+  while (nqueued < len)
+    {
+      /* The connection may have been lost while we waited */
+
+      if ((conn->tcpstateflags & UIP_TS_MASK) != UIP_ESTABLISHED)
+        {
+          ret = -ENOTCONN;
+          break;
+        }
+
+      /* Queue as much of the data as will fit.  Then let the device driver
+       * know that there is TX data available.  The send queue has its own
+       * lock so the network does not need to be locked while the data is
+       * copied.
+       */
+
+      ret = uip_tcpsendqadd(conn, &buf[nqueued], len - nqueued);
+      if (ret > 0)
+        {
+          nqueued += ret;
+          netdev_txnotify(&conn->ripaddr);
+          continue;
+        }
+
+      /* The queue is full.  Lock the network and try again:  Data may have
+       * been acknowledged before the network was locked.
+       */
+
+      save = uip_lock();
+      ret  = uip_tcpsendqadd(conn, &buf[nqueued], len - nqueued);
+      if (ret > 0)
+        {
+          uip_unlock(save);
+          nqueued += ret;
+          netdev_txnotify(&conn->ripaddr);
+          continue;
+        }
+
+      /* Wait for queued data to be acknowledged. */
+
+      state.snd_cb = uip_tcpcallbackalloc(conn);
+      if (!state.snd_cb)
+        {
+          uip_unlock(save);
+          ret = -EBUSY;
+          break;
+        }
+
+      (void)sem_init(&state.snd_sem, 0, 0); /* Doesn't really fail */
+      state.snd_sent      = 0;
+#if defined(CONFIG_NET_SOCKOPTS) && !defined(CONFIG_DISABLE_CLOCK)
+      state.snd_time      = clock_systimer();
+#endif
+      state.snd_cb->flags = UIP_ACKDATA|UIP_POLL|UIP_CLOSE|UIP_ABORT|UIP_TIMEDOUT;
+      state.snd_cb->priv  = (void*)&state;
+      state.snd_cb->event = sendq_interrupt;
+
+      /* NOTE: uip_lockedwait will also terminate if a signal is received */
+
+      ret = uip_lockedwait(&state.snd_sem);
+
+      uip_tcpcallbackfree(conn, state.snd_cb);
+      uip_unlock(save);
+      sem_destroy(&state.snd_sem);
+
+      if (ret < 0)
+        {
+          ret = -errno;
+          break;
+        }
+      else if (state.snd_sent < 0)
+        {
+          ret = state.snd_sent;
+          break;
+        }
+    }
+
+  /* Report the number of bytes queued, if any.  Otherwise, report the
+   * error.
+   */
+
+  return nqueued > 0 ? (ssize_t)nqueued : ret;
+}
+#endif /* CONFIG_NET_TCP_SENDQSIZE */
 
 /****************************************************************************
  * Public Functions
@@ -402,10 +577,14 @@ end_wait:
 ssize_t send(int sockfd, const void *buf, size_t len, int flags)
 {
   FAR struct socket *psock = sockfd_socket(sockfd);
+#if CONFIG_NET_TCP_SENDQSIZE > 0
+  ssize_t nsent;
+#else
   struct send_s state;
   uip_lock_t save;
-  int err;
   int ret = OK;
+#endif
+  int err;
 
   /* Verify that the sockfd corresponds to valid, allocated socket */
 
@@ -429,6 +608,26 @@ ssize_t send(int sockfd, const void *buf, size_t len, int flags)
 
   /* Perform the TCP send operation */
 
+#if CONFIG_NET_TCP_SENDQSIZE > 0
+  /* Queue the data.  It will be sent and, if necessary, retransmitted by
+   * uIP after send() returns.
+   */
+
+  nsent = send_queued(psock, (FAR const uint8_t *)buf, len);
+
+  /* Set the socket state to idle */
+
+  psock->s_flags = _SS_SETSTATE(psock->s_flags, _SF_IDLE);
+
+  if (nsent < 0)
+    {
+      err = -nsent;
+      goto errout;
+    }
+
+  return nsent;
+
+#else
   /* Initialize the state structure.  This is done with interrupts
    * disabled because we don't want anything to happen until we
    * are ready.
@@ -454,12 +653,6 @@ ssize_t send(int sockfd, const void *buf, size_t len, int flags)
 
           state.snd_isn         = uip_tcpgetsequence(conn->sndseq);
 
-          /* There is no outstanding, unacknowledged data after this
-           * initial sequence number.
-           */
-
-          conn->unacked         = 0;
-
           /* Update the initial time for calculating timeouts */
 
 #if defined(CONFIG_NET_SOCKOPTS) && !defined(CONFIG_DISABLE_CLOCK)
@@ -502,7 +695,7 @@ ssize_t send(int sockfd, const void *buf, size_t len, int flags)
 
   if (state.snd_sent < 0)
     {
-      err = state.snd_sent;
+      err = -state.snd_sent;
       goto errout;
     }
 
@@ -519,6 +712,7 @@ ssize_t send(int sockfd, const void *buf, size_t len, int flags)
   /* Return the number of bytes actually sent */
 
   return state.snd_sent;
+#endif /* CONFIG_NET_TCP_SENDQSIZE */
 
 errout:
   *get_errno_ptr() = err;
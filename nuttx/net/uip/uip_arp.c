@@ -60,6 +60,8 @@
 #include <string.h>
 #include <debug.h>
 
+#include <arch/irq.h>
+
 #include <netinet/in.h>
 
 #include <net/ethernet.h>
@@ -67,6 +69,8 @@
 #include <net/uip/uip-arch.h>
 #include <net/uip/uip-arp.h>
 
+#include "uip_internal.h"
+
 #ifdef CONFIG_NET_ARP
 
 /****************************************************************************
@@ -203,7 +207,9 @@ void uip_arp_ipin(struct uip_driver_s *dev)
   srcipaddr = uip_ip4addr_conv(IPBUF->eh_srcipaddr);
   if (!uip_ipaddr_maskcmp(srcipaddr, dev->d_ipaddr, dev->d_netmask))
     {
+      uip_lock_t flags = uip_lock();
       uip_arp_update(IPBUF->eh_srcipaddr, ETHBUF->src);
+      uip_unlock(flags);
     }
 }
 #endif /* CONFIG_NET_ARP_IPIN */
@@ -214,9 +220,10 @@ void uip_arp_ipin(struct uip_driver_s *dev)
  * packet has been received. The function will act differently
  * depending on the ARP packet type: if it is a reply for a request
  * that we previously sent out, the ARP cache will be filled in with
- * the values from the ARP reply. If the incoming ARP packet is an ARP
- * request for our IP address, an ARP reply packet is created and put
- * into the d_buf[] buffer.
+ * the values from the ARP reply and the first packet that was waiting
+ * for the reply is put into the d_buf[] buffer. If the incoming ARP
+ * packet is an ARP request for our IP address, an ARP reply packet is
+ * created and put into the d_buf[] buffer.
  *
  * When the function returns, the value of the field d_len
  * indicates whether the device driver should send out a packet or
@@ -233,6 +240,9 @@ void uip_arp_arpin(struct uip_driver_s *dev)
 {
   struct arp_hdr_s *parp = ARPBUF;
   in_addr_t ipaddr;
+  uip_lock_t flags;
+
+  uip_sndclear(dev);
 
   if (dev->d_len < (sizeof(struct arp_hdr_s) + UIP_LLH_LEN))
     {
@@ -242,6 +252,10 @@ void uip_arp_arpin(struct uip_driver_s *dev)
     }
   dev->d_len = 0;
 
+  /* The ARP table is protected by the network lock */
+
+  flags  = uip_lock();
+
   ipaddr = uip_ip4addr_conv(parp->ah_dipaddr);
   switch(parp->ah_opcode)
     {
@@ -287,9 +301,23 @@ void uip_arp_arpin(struct uip_driver_s *dev)
         if (uip_ipaddr_cmp(ipaddr, dev->d_ipaddr))
           {
             uip_arp_update(parp->ah_sipaddr, parp->ah_shwaddr);
+
+#if CONFIG_NET_ARP_NPENDING > 0
+            /* If packets were waiting for this reply, send the first one
+             * now in place of the ARP reply.  The rest will be sent on
+             * the next poll.
+             */
+
+            if (uip_arp_dequeue(dev))
+              {
+                uip_arp_out(dev);
+              }
+#endif
           }
         break;
     }
+
+  uip_unlock(flags);
 }
 
 /* Prepend Ethernet header to an outbound IP packet and see if we need
@@ -306,9 +334,11 @@ void uip_arp_arpin(struct uip_driver_s *dev)
  * address is found. If so, an Ethernet header is prepended and the
  * function returns. If no ARP cache entry is found for the
  * destination IP address, the packet in the d_buf[] is replaced by
- * an ARP request packet for the IP address. The IP packet is dropped
- * and it is assumed that they higher level protocols (e.g., TCP)
- * eventually will retransmit the dropped packet.
+ * an ARP request packet for the IP address. A copy of the IP packet
+ * is held until the ARP reply is received and then sent (see
+ * CONFIG_NET_ARP_NPENDING); otherwise, the IP packet is dropped and it
+ * is assumed that they higher level protocols (e.g., TCP) eventually
+ * will retransmit the dropped packet.
  *
  * If the destination IP address is not on the local network, the IP
  * address of the default router is used instead.
@@ -325,6 +355,7 @@ void uip_arp_out(struct uip_driver_s *dev)
   struct arp_iphdr_s     *pip    = IPBUF;
   in_addr_t               ipaddr;
   in_addr_t               destipaddr;
+  uip_lock_t              flags;
 
   /* Find the destination IP address in the ARP table and construct
    * the Ethernet header. If the destination IP addres isn't on the
@@ -386,10 +417,17 @@ void uip_arp_out(struct uip_driver_s *dev)
 
       /* Check if we already have this destination address in the ARP table */
 
+      flags  = uip_lock();
       tabptr = uip_arp_find(ipaddr);
       if (!tabptr)
         {
-           nllvdbg("ARP request for IP %04lx\n", (long)ipaddr);    
+#if CONFIG_NET_ARP_NPENDING > 0
+          /* Hold on to the IP packet until the ARP reply is received */
+
+          uip_arp_queue(dev, ipaddr);
+#endif
+          uip_unlock(flags);
+          nllvdbg("ARP request for IP %04lx\n", (long)ipaddr);    
 
           /* The destination address was not in our ARP table, so we
            * overwrite the IP packet with an ARP request.
@@ -412,12 +450,14 @@ void uip_arp_out(struct uip_driver_s *dev)
 
           peth->type        = HTONS(UIP_ETHTYPE_ARP);
           dev->d_len        = sizeof(struct arp_hdr_s) + UIP_LLH_LEN;
+          uip_sndclear(dev);
           return;
         }
 
       /* Build an ethernet header. */
 
       memcpy(peth->dest, tabptr->at_ethaddr.ether_addr_octet, ETHER_ADDR_LEN);
+      uip_unlock(flags);
     }
 
   /* Finish populating the ethernet header */
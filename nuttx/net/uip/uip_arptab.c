@@ -47,15 +47,21 @@
 
 #include <sys/ioctl.h>
 #include <stdint.h>
+#include <stdbool.h>
 #include <string.h>
+#include <queue.h>
 #include <debug.h>
 
 #include <netinet/in.h>
+#include <arch/irq.h>
 
 #include <net/ethernet.h>
 #include <net/uip/uipopt.h>
 #include <net/uip/uip-arch.h>
 #include <net/uip/uip-arp.h>
+#include <net/uip/uip-iob.h>
+
+#include "uip_internal.h"
 
 #ifdef CONFIG_NET_ARP
 
@@ -67,6 +73,17 @@
  * Private Types
  ****************************************************************************/
 
+/* A packet that is waiting for address resolution is held in a chain of I/O
+ * buffers.  The chain begins with this header followed by the IP packet.
+ */
+
+#if CONFIG_NET_ARP_NPENDING > 0
+struct arp_pending_s
+{
+  FAR struct uip_driver_s *ap_dev; /* The device that will send the packet */
+};
+#endif
+
 /****************************************************************************
  * Private Data
  ****************************************************************************/
@@ -74,12 +91,230 @@
 /* The table of known address mappings */
 
 static struct arp_entry g_arptable[CONFIG_NET_ARPTAB_SIZE];
-static uint8_t g_arptime;
+
+/* The entries in use are kept in a hash table keyed on the IP address */
+
+static FAR struct arp_entry *g_arphash[CONFIG_NET_ARP_NHASH];
+
+/* Every entry is in one of these lists.  The entries in use are kept oldest
+ * first so that only the head of a list needs to be checked for expired
+ * entries.
+ */
+
+static dq_queue_t g_arpfree;     /* Entries not in use */
+static dq_queue_t g_arpresolved; /* Entries with a known hardware address */
+static dq_queue_t g_arppending;  /* Entries waiting for an ARP reply */
+
+/* Packets whose destination has been resolved but that have not yet been
+ * sent.
+ */
+
+#if CONFIG_NET_ARP_NPENDING > 0
+static sq_queue_t g_arpready;
+#endif
+
+/* The ARP time.  This is incremented by the ARP timer every 10 seconds.
+ * Entries are only aged when the table is used, so a narrower count could
+ * wrap while an idle entry is still in the table and make it look new.
+ */
+
+static volatile uint32_t g_arptime;
 
 /****************************************************************************
  * Private Functions
  ****************************************************************************/
 
+/****************************************************************************
+ * Name: uip_arp_now
+ *
+ * Description:
+ *   Return the ARP time.  The ARP timer runs from a watchdog and the read
+ *   of g_arptime is not atomic on all architectures.
+ *
+ ****************************************************************************/
+
+static inline uint32_t uip_arp_now(void)
+{
+  irqstate_t flags;
+  uint32_t now;
+
+  flags = irqsave();
+  now   = g_arptime;
+  irqrestore(flags);
+  return now;
+}
+
+/****************************************************************************
+ * Name: uip_arphash
+ *
+ * Description:
+ *   Return the index of the bucket in g_arphash[] for this IP address.
+ *
+ ****************************************************************************/
+
+static inline unsigned int uip_arphash(in_addr_t ipaddr)
+{
+  uint32_t hash = ipaddr;
+
+  hash ^= hash >> 16;
+  hash ^= hash >> 8;
+  return hash & (CONFIG_NET_ARP_NHASH - 1);
+}
+
+/****************************************************************************
+ * Name: uip_arp_lookup
+ *
+ * Description:
+ *   Find the entry for this IP address, resolved or not.
+ *
+ * Assumptions
+ *   Interrupts are disabled
+ *
+ ****************************************************************************/
+
+static FAR struct arp_entry *uip_arp_lookup(in_addr_t ipaddr)
+{
+  FAR struct arp_entry *tabptr;
+
+  for (tabptr = g_arphash[uip_arphash(ipaddr)];
+       tabptr;
+       tabptr = tabptr->at_flink)
+    {
+      if (uip_ipaddr_cmp(ipaddr, tabptr->at_ipaddr))
+        {
+          break;
+        }
+    }
+
+  return tabptr;
+}
+
+/****************************************************************************
+ * Name: uip_arp_release
+ *
+ * Description:
+ *   Remove an entry from the hash table and from its list, discard any
+ *   packets that were waiting for it, and return it to the free list.
+ *
+ * Assumptions
+ *   Interrupts are disabled
+ *
+ ****************************************************************************/
+
+static void uip_arp_release(FAR struct arp_entry *tabptr)
+{
+  FAR struct arp_entry **pprev;
+#if CONFIG_NET_ARP_NPENDING > 0
+  FAR struct uip_iob_s *iob;
+#endif
+
+  for (pprev = &g_arphash[uip_arphash(tabptr->at_ipaddr)];
+       *pprev;
+       pprev = &(*pprev)->at_flink)
+    {
+      if (*pprev == tabptr)
+        {
+          *pprev = tabptr->at_flink;
+          break;
+        }
+    }
+
+  if ((tabptr->at_flags & ARP_FLAG_PENDING) != 0)
+    {
+      dq_rem(&tabptr->at_node, &g_arppending);
+    }
+  else
+    {
+      dq_rem(&tabptr->at_node, &g_arpresolved);
+    }
+
+#if CONFIG_NET_ARP_NPENDING > 0
+  while ((iob = (FAR struct uip_iob_s *)sq_remfirst(&tabptr->at_pending)) != NULL)
+    {
+      uip_iobfreechain(iob);
+    }
+
+  tabptr->at_npending = 0;
+#endif
+
+  tabptr->at_ipaddr = 0;
+  tabptr->at_flags  = 0;
+  dq_addlast(&tabptr->at_node, &g_arpfree);
+}
+
+/****************************************************************************
+ * Name: uip_arp_expire
+ *
+ * Description:
+ *   Release the entries that have expired.  Because the lists are kept
+ *   oldest first, this stops at the first entry that has not expired.
+ *
+ * Assumptions
+ *   Interrupts are disabled
+ *
+ ****************************************************************************/
+
+static void uip_arp_expire(FAR dq_queue_t *list, uint32_t now,
+                           uint32_t maxage)
+{
+  FAR struct arp_entry *tabptr;
+
+  while ((tabptr = (FAR struct arp_entry *)list->head) != NULL &&
+         now - tabptr->at_time >= maxage)
+    {
+      uip_arp_release(tabptr);
+    }
+}
+
+static inline void uip_arp_age(void)
+{
+  uint32_t now = uip_arp_now();
+
+  uip_arp_expire(&g_arpresolved, now, UIP_ARP_MAXAGE);
+  uip_arp_expire(&g_arppending, now, UIP_ARP_MAXPENDING);
+}
+
+/****************************************************************************
+ * Name: uip_arp_alloc
+ *
+ * Description:
+ *   Allocate an entry for this IP address and add it to the hash table.  If
+ *   there are no unused entries, the oldest entry is thrown away.  The new
+ *   entry is not in any list.
+ *
+ * Assumptions
+ *   Interrupts are disabled
+ *
+ ****************************************************************************/
+
+static FAR struct arp_entry *uip_arp_alloc(in_addr_t ipaddr)
+{
+  FAR struct arp_entry *tabptr;
+  unsigned int ndx;
+
+  tabptr = (FAR struct arp_entry *)dq_remfirst(&g_arpfree);
+  if (!tabptr)
+    {
+      /* Throw away the oldest entry, preferring one that is resolved */
+
+      tabptr = (FAR struct arp_entry *)g_arpresolved.head;
+      if (!tabptr)
+        {
+          tabptr = (FAR struct arp_entry *)g_arppending.head;
+        }
+
+      uip_arp_release(tabptr);
+      (void)dq_remfirst(&g_arpfree);
+    }
+
+  ndx               = uip_arphash(ipaddr);
+  tabptr->at_ipaddr = ipaddr;
+  tabptr->at_flags  = 0;
+  tabptr->at_flink  = g_arphash[ndx];
+  g_arphash[ndx]    = tabptr;
+  return tabptr;
+}
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -96,9 +331,23 @@ static uint8_t g_arptime;
 void uip_arp_init(void)
 {
   int i;
+
+  dq_init(&g_arpfree);
+  dq_init(&g_arpresolved);
+  dq_init(&g_arppending);
+#if CONFIG_NET_ARP_NPENDING > 0
+  sq_init(&g_arpready);
+#endif
+
+  for (i = 0; i < CONFIG_NET_ARP_NHASH; i++)
+    {
+      g_arphash[i] = NULL;
+    }
+
   for (i = 0; i < CONFIG_NET_ARPTAB_SIZE; ++i)
     {
-      memset(&g_arptable[i].at_ipaddr, 0, sizeof(in_addr_t));
+      memset(&g_arptable[i], 0, sizeof(struct arp_entry));
+      dq_addlast(&g_arptable[i].at_node, &g_arpfree);
     }
 }
 
@@ -108,25 +357,16 @@ void uip_arp_init(void)
  * Description:
  *   This function performs periodic timer processing in the ARP module
  *   and should be called at regular intervals. The recommended interval
- *   is 10 seconds between the calls.  It is responsible for flushing old
- *   entries in the ARP table.
+ *   is 10 seconds between the calls.  It only advances the ARP time; old
+ *   entries are flushed from the ARP table when the table is next used.
+ *   So this does not touch the table and may be called from a watchdog
+ *   handler even when uIP is protected by a semaphore.
  *
  ****************************************************************************/
 
 void uip_arp_timer(void)
 {
-  struct arp_entry *tabptr;
-  int i;
-
   ++g_arptime;
-  for (i = 0; i < CONFIG_NET_ARPTAB_SIZE; ++i)
-    {
-      tabptr = &g_arptable[i];
-      if (tabptr->at_ipaddr != 0 && g_arptime - tabptr->at_time >= UIP_ARP_MAXAGE)
-        {
-          tabptr->at_ipaddr = 0;
-        }
-    }
 }
 
 /****************************************************************************
@@ -134,7 +374,8 @@ void uip_arp_timer(void)
  *
  * Description:
  *   Add the IP/HW address mapping to the ARP table -OR- change the IP
- *   address of an existing association.
+ *   address of an existing association.  If packets were waiting for
+ *   this address, they become ready to send.
  *
  * Input parameters:
  *   pipaddr - Refers to an IP address uint16_t[2]
@@ -147,86 +388,59 @@ void uip_arp_timer(void)
 
 void uip_arp_update(uint16_t *pipaddr, uint8_t *ethaddr)
 {
-  struct arp_entry *tabptr = NULL;
-  in_addr_t         ipaddr = uip_ip4addr_conv(pipaddr);
-  int               i;
+  FAR struct arp_entry *tabptr;
+  in_addr_t ipaddr = uip_ip4addr_conv(pipaddr);
+#if CONFIG_NET_ARP_NPENDING > 0
+  FAR sq_entry_t *pkt;
+#endif
+
+  uip_arp_age();
 
-  /* Walk through the ARP mapping table and try to find an entry to
-   * update. If none is found, the IP -> MAC address mapping is
-   * inserted in the ARP table.
+  /* Find the entry to update.  If none is found, the IP -> MAC address
+   * mapping is inserted in the ARP table.
    */
 
-  for (i = 0; i < CONFIG_NET_ARPTAB_SIZE; ++i)
+  tabptr = uip_arp_lookup(ipaddr);
+  if (!tabptr)
     {
-      tabptr = &g_arptable[i];
-
-      /* Only check those entries that are actually in use. */
-
-      if (tabptr->at_ipaddr != 0)
-        {
-          /* Check if the source IP address of the incoming packet matches
-           * the IP address in this ARP table entry.
-           */
-
-          if (uip_ipaddr_cmp(ipaddr, tabptr->at_ipaddr))
-            {
-              /* An old entry found, update this and return. */
-
-              memcpy(tabptr->at_ethaddr.ether_addr_octet, ethaddr, ETHER_ADDR_LEN);
-              tabptr->at_time = g_arptime;
-              return;
-            }
-        }
+      tabptr = uip_arp_alloc(ipaddr);
     }
+  else if ((tabptr->at_flags & ARP_FLAG_PENDING) != 0)
+    {
+      /* The address has been resolved */
 
-  /* If we get here, no existing ARP table entry was found, so we create one. */
+      dq_rem(&tabptr->at_node, &g_arppending);
+      tabptr->at_flags &= ~ARP_FLAG_PENDING;
 
-  /* First, we try to find an unused entry in the ARP table. */
+#if CONFIG_NET_ARP_NPENDING > 0
+      /* The packets that were waiting for it can be sent now */
 
-  for (i = 0; i < CONFIG_NET_ARPTAB_SIZE; ++i)
-    {
-      tabptr = &g_arptable[i];
-      if (tabptr->at_ipaddr == 0)
+      while ((pkt = sq_remfirst(&tabptr->at_pending)) != NULL)
         {
-          break;
+          sq_addlast(pkt, &g_arpready);
         }
-    }
-
-  /* If no unused entry is found, we try to find the oldest entry and
-   * throw it away.
-   */
 
-  if (i == CONFIG_NET_ARPTAB_SIZE)
+      tabptr->at_npending = 0;
+#endif
+    }
+  else
     {
-      uint8_t tmpage = 0;
-      int   j      = 0;
-      for (i = 0; i < CONFIG_NET_ARPTAB_SIZE; ++i)
-        {
-          tabptr = &g_arptable[i];
-          if (g_arptime - tabptr->at_time > tmpage)
-            {
-              tmpage = g_arptime - tabptr->at_time;
-              j = i;
-            }
-        }
-      i = j;
-      tabptr = &g_arptable[i];
+      dq_rem(&tabptr->at_node, &g_arpresolved);
     }
 
-  /* Now, i is the ARP table entry which we will fill with the new
-   * information.
-   */
+  /* The updated entry is now the newest */
 
-  tabptr->at_ipaddr = ipaddr;
   memcpy(tabptr->at_ethaddr.ether_addr_octet, ethaddr, ETHER_ADDR_LEN);
-  tabptr->at_time = g_arptime;
+  tabptr->at_time = uip_arp_now();
+  dq_addlast(&tabptr->at_node, &g_arpresolved);
 }
 
 /****************************************************************************
  * Name: uip_arp_find
  *
  * Description:
- *   Find the ARP entry corresponding to this IP address.
+ *   Find the ARP entry corresponding to this IP address.  Entries that are
+ *   still waiting for an ARP reply are not returned.
  *
  * Input parameters:
  *   ipaddr - Refers to an IP addressin network order
@@ -239,19 +453,209 @@ void uip_arp_update(uint16_t *pipaddr, uint8_t *ethaddr)
 
 struct arp_entry *uip_arp_find(in_addr_t ipaddr)
 {
-  struct arp_entry *tabptr;
-  int i;
+  FAR struct arp_entry *tabptr;
 
-  for (i = 0; i < CONFIG_NET_ARPTAB_SIZE; ++i)
+  uip_arp_age();
+
+  tabptr = uip_arp_lookup(ipaddr);
+  if (tabptr && (tabptr->at_flags & ARP_FLAG_PENDING) != 0)
     {
-      tabptr = &g_arptable[i];
-      if (uip_ipaddr_cmp(ipaddr, tabptr->at_ipaddr))
+      tabptr = NULL;
+    }
+
+  return tabptr;
+}
+
+/****************************************************************************
+ * Name: uip_arp_delete
+ *
+ * Description:
+ *   Remove an IP association from the ARP table
+ *
+ * Input parameters:
+ *   ipaddr - Refers to an IP address in network order
+ *
+ * Assumptions
+ *   Interrupts are disabled
+ *
+ ****************************************************************************/
+
+void uip_arp_delete(in_addr_t ipaddr)
+{
+  FAR struct arp_entry *tabptr = uip_arp_lookup(ipaddr);
+  if (tabptr)
+    {
+      uip_arp_release(tabptr);
+    }
+}
+
+/****************************************************************************
+ * Name: uip_arp_queue
+ *
+ * Description:
+ *   The hardware address of ipaddr is not known.  Create an entry that
+ *   waits for the ARP reply (if there is not one already) and hold a copy
+ *   of the outgoing IP packet in dev->d_buf until the reply is received.
+ *   The packet is dropped if CONFIG_NET_ARP_NPENDING packets are already
+ *   waiting or if there are not enough I/O buffers.
+ *
+ * Assumptions
+ *   Interrupts are disabled
+ *
+ ****************************************************************************/
+
+#if CONFIG_NET_ARP_NPENDING > 0
+void uip_arp_queue(FAR struct uip_driver_s *dev, in_addr_t ipaddr)
+{
+  FAR struct arp_entry *tabptr;
+  FAR struct uip_iob_s *iob;
+  struct arp_pending_s hdr;
+  unsigned int hdrlen;
+  int ret;
+
+  tabptr = uip_arp_lookup(ipaddr);
+  if (!tabptr)
+    {
+      tabptr           = uip_arp_alloc(ipaddr);
+      tabptr->at_flags = ARP_FLAG_PENDING;
+      tabptr->at_time  = uip_arp_now();
+      dq_addlast(&tabptr->at_node, &g_arppending);
+    }
+
+  if (tabptr->at_npending >= CONFIG_NET_ARP_NPENDING)
+    {
+      nllvdbg("ARP queue full\n");
+      return;
+    }
+
+  iob = uip_ioballoc();
+  if (!iob)
+    {
+      return;
+    }
+
+  /* Save the device followed by the IP packet.  With CONFIG_NET_SGSEND,
+   * the application data of the packet may not be in d_buf.
+   */
+
+  hdr.ap_dev = dev;
+  hdrlen     = dev->d_len;
+#ifdef CONFIG_NET_SGSEND
+  if (dev->d_sgdata)
+    {
+      hdrlen -= dev->d_sndlen;
+    }
+#endif
+
+  ret = uip_iobcopyin(iob, (FAR const uint8_t *)&hdr, sizeof(hdr), 0);
+  if (ret == OK)
+    {
+      ret = uip_iobcopyin(iob, &dev->d_buf[UIP_LLH_LEN], hdrlen, sizeof(hdr));
+    }
+
+#ifdef CONFIG_NET_SGSEND
+  if (ret == OK && dev->d_sgdata)
+    {
+      ret = uip_iobcopyin(iob, dev->d_sgdata, dev->d_sndlen,
+                          sizeof(hdr) + hdrlen);
+    }
+#endif
+
+  if (ret != OK)
+    {
+      uip_iobfreechain(iob);
+      return;
+    }
+
+  sq_addlast(&iob->io_link, &tabptr->at_pending);
+  tabptr->at_npending++;
+}
+#endif
+
+/****************************************************************************
+ * Name: uip_arp_dequeue
+ *
+ * Description:
+ *   Take the oldest packet for this device whose destination has been
+ *   resolved and copy it into dev->d_buf just as uIP would have built it:
+ *   The IP packet follows the link level header and d_len holds its length.
+ *
+ * Returned Value:
+ *   true if a packet was placed in d_buf.
+ *
+ * Assumptions
+ *   Interrupts are disabled
+ *
+ ****************************************************************************/
+
+#if CONFIG_NET_ARP_NPENDING > 0
+bool uip_arp_dequeue(FAR struct uip_driver_s *dev)
+{
+  FAR struct uip_iob_s *prev = NULL;
+  FAR struct uip_iob_s *iob;
+  struct arp_pending_s hdr;
+
+  for (iob = (FAR struct uip_iob_s *)g_arpready.head;
+       iob;
+       prev = iob, iob = (FAR struct uip_iob_s *)iob->io_link.flink)
+    {
+      (void)uip_iobcopyout((FAR uint8_t *)&hdr, iob, sizeof(hdr), 0);
+      if (hdr.ap_dev == dev)
         {
-          return tabptr;
+          break;
         }
     }
-  return NULL;
+
+  if (!iob)
+    {
+      return false;
+    }
+
+  if (prev)
+    {
+      (void)sq_remafter(&prev->io_link, &g_arpready);
+    }
+  else
+    {
+      (void)sq_remfirst(&g_arpready);
+    }
+
+  uip_sndclear(dev);
+  dev->d_len = uip_iobcopyout(&dev->d_buf[UIP_LLH_LEN], iob,
+                              CONFIG_NET_BUFSIZE - UIP_LLH_LEN, sizeof(hdr));
+  uip_iobfreechain(iob);
+  return true;
+}
+#endif
+
+/****************************************************************************
+ * Name: uip_arp_poll
+ *
+ * Description:
+ *   Pass each packet for this device whose destination has been resolved
+ *   to the device driver poll callback.
+ *
+ * Returned Value:
+ *   Non-zero if the callback asked to stop polling.
+ *
+ * Assumptions
+ *   Interrupts are disabled
+ *
+ ****************************************************************************/
+
+#if CONFIG_NET_ARP_NPENDING > 0
+int uip_arp_poll(FAR struct uip_driver_s *dev, uip_poll_callback_t callback)
+{
+  int bstop = 0;
+
+  while (!bstop && uip_arp_dequeue(dev))
+    {
+      bstop = callback(dev);
+    }
+
+  return bstop;
 }
+#endif
 
 #endif /* CONFIG_NET_ARP */
 #endif /* CONFIG_NET */
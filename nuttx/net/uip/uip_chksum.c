@@ -41,6 +41,8 @@
 #ifdef CONFIG_NET
 
 #include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
 #include <debug.h>
 
 #include <net/uip/uipopt.h>
@@ -65,41 +67,182 @@
  ****************************************************************************/
 
 #if !UIP_ARCH_CHKSUM
-static uint16_t chksum(uint16_t sum, const uint8_t *data, uint16_t len)
+
+/* Add two 16-bit one's complement sums */
+
+static inline uint16_t chksum_add(uint16_t sum1, uint16_t sum2)
 {
-  uint16_t t;
-  const uint8_t *dataptr;
-  const uint8_t *last_byte;
+  uint32_t sum = (uint32_t)sum1 + sum2;
+  return (uint16_t)(sum + (sum >> 16));
+}
 
-  dataptr = data;
-  last_byte = data + len - 1;
+/* Add the 16-bit one's complement sum of 'len' bytes of data to 'sum'.  The
+ * data is treated as a sequence of big endian 16-bit words; an odd last byte
+ * is padded with zero.  Both 'sum' and the returned sum are in host byte
+ * order.
+ *
+ * The architecture may provide an optimized version of this function,
+ * up_chksum(), by selecting CONFIG_ARCH_CHKSUM.
+ */
+
+#ifdef CONFIG_ARCH_CHKSUM
+#  define chksum(s,d,l) up_chksum(s,d,l)
+#else
+static uint16_t chksum(uint16_t sum, FAR const uint8_t *data, uint16_t len)
+{
+  FAR const uint16_t *wptr;
+  uint32_t acc = 0;
+  bool odd = false;
 
-  while(dataptr < last_byte)
+  if (len == 0)
     {
-      /* At least two more bytes */
+      return sum;
+    }
 
-      t = (dataptr[0] << 8) + dataptr[1];
-      sum += t;
-      if (sum < t)
-        {
-          sum++; /* carry */
-        }
-      dataptr += 2;
+  /* The data is summed 16-bits at a time in the native byte order.  That
+   * gives the byte-swapped sum on a little endian machine, but the one's
+   * complement sum does not depend on the byte order (RFC 1071) so it can
+   * simply be swapped back at the end.
+   *
+   * If the data begins at an odd address, then the first byte is summed by
+   * itself and the rest of the data is summed as if its bytes were swapped.
+   * That swap is also undone at the end.
+   */
+
+  if (((uintptr_t)data & 1) != 0)
+    {
+#ifdef CONFIG_ENDIAN_BIG
+      acc = (uint32_t)data[0];
+#else
+      acc = (uint32_t)data[0] << 8;
+#endif
+      data++;
+      len--;
+      odd = true;
+    }
+
+  wptr = (FAR const uint16_t *)data;
+
+  /* A 32-bit accumulator cannot overflow:  At most 32768 words are added
+   * and the carries are folded back in only once at the end.
+   */
+
+  while (len >= 16)
+    {
+      acc += wptr[0];
+      acc += wptr[1];
+      acc += wptr[2];
+      acc += wptr[3];
+      acc += wptr[4];
+      acc += wptr[5];
+      acc += wptr[6];
+      acc += wptr[7];
+      wptr += 8;
+      len  -= 16;
     }
 
-  if (dataptr == last_byte)
+  while (len >= 2)
     {
-      t = (dataptr[0] << 8) + 0;
-      sum += t;
-      if (sum < t)
+      acc += *wptr++;
+      len -= 2;
+    }
+
+  /* An odd last byte is the high order byte of a zero-padded word */
+
+  if (len > 0)
+    {
+#ifdef CONFIG_ENDIAN_BIG
+      acc += (uint32_t)(*(FAR const uint8_t *)wptr) << 8;
+#else
+      acc += *(FAR const uint8_t *)wptr;
+#endif
+    }
+
+  /* Fold the carries back into 16 bits */
+
+  acc = (acc & 0xffff) + (acc >> 16);
+  acc = (acc & 0xffff) + (acc >> 16);
+
+  /* Undo the byte swaps.  On a little endian machine, an odd start address
+   * swaps the bytes back into the big endian order.
+   */
+
+#ifdef CONFIG_ENDIAN_BIG
+  if (odd)
+#else
+  if (!odd)
+#endif
+    {
+      acc = ((acc & 0xff) << 8) | (acc >> 8);
+    }
+
+  return chksum_add(sum, (uint16_t)acc);
+}
+#endif /* CONFIG_ARCH_CHKSUM */
+
+/* Copy 'len' bytes of data from 'src' to 'dest' and add the 16-bit one's
+ * complement sum of the data to 'sum' as chksum() does.  The data is read
+ * only once when both buffers have the same 16-bit alignment.
+ */
+
+static uint16_t chksumcopy(uint16_t sum, FAR uint8_t *dest,
+                           FAR const uint8_t *src, uint16_t len)
+{
+#ifndef CONFIG_ARCH_CHKSUM
+  FAR uint16_t *dptr;
+  FAR const uint16_t *sptr;
+  uint16_t nwords;
+  uint16_t word;
+  uint32_t acc = 0;
+
+  if (((uintptr_t)dest & 1) == 0 && ((uintptr_t)src & 1) == 0)
+    {
+      dptr   = (FAR uint16_t *)dest;
+      sptr   = (FAR const uint16_t *)src;
+      nwords = len >> 1;
+
+      while (nwords >= 4)
+        {
+          word = sptr[0]; dptr[0] = word; acc += word;
+          word = sptr[1]; dptr[1] = word; acc += word;
+          word = sptr[2]; dptr[2] = word; acc += word;
+          word = sptr[3]; dptr[3] = word; acc += word;
+          dptr   += 4;
+          sptr   += 4;
+          nwords -= 4;
+        }
+
+      while (nwords > 0)
         {
-          sum++; /* carry */
+          word = *sptr++;
+          *dptr++ = word;
+          acc += word;
+          nwords--;
         }
+
+      if ((len & 1) != 0)
+        {
+          *(FAR uint8_t *)dptr = *(FAR const uint8_t *)sptr;
+#ifdef CONFIG_ENDIAN_BIG
+          acc += (uint32_t)(*(FAR const uint8_t *)sptr) << 8;
+#else
+          acc += *(FAR const uint8_t *)sptr;
+#endif
+        }
+
+      acc = (acc & 0xffff) + (acc >> 16);
+      acc = (acc & 0xffff) + (acc >> 16);
+#ifndef CONFIG_ENDIAN_BIG
+      acc = ((acc & 0xff) << 8) | (acc >> 8);
+#endif
+      return chksum_add(sum, (uint16_t)acc);
     }
+#endif
 
-  /* Return sum in host byte order. */
+  /* Otherwise, copy the data and then sum it */
 
-  return sum;
+  memcpy(dest, src, len);
+  return chksum(sum, src, len);
 }
 
 static uint16_t upper_layer_chksum(struct uip_driver_s *dev, uint8_t proto)
@@ -126,7 +269,34 @@ static uint16_t upper_layer_chksum(struct uip_driver_s *dev, uint8_t proto)
 
   /* Sum TCP header and data. */
 
-  sum = chksum(sum, &dev->d_buf[UIP_IPH_LEN + UIP_LLH_LEN], upper_layer_len);
+#ifdef CONFIG_NET_SGSEND
+  if (dev->d_sgdata)
+    {
+      /* The data follows the headers in a separate buffer.  The length of
+       * the TCP header is always a multiple of four so no odd byte is
+       * carried over to the data.
+       */
+
+      sum = chksum(sum, &dev->d_buf[UIP_IPH_LEN + UIP_LLH_LEN],
+                   upper_layer_len - dev->d_sndlen);
+      sum = chksum(sum, dev->d_sgdata, dev->d_sndlen);
+    }
+  else
+#endif
+  if (dev->d_sndsumvalid)
+    {
+      /* The sum of the data was computed when the data was copied into
+       * d_buf by uip_send().  Only the headers still need to be summed.
+       */
+
+      sum = chksum(sum, &dev->d_buf[UIP_IPH_LEN + UIP_LLH_LEN],
+                   upper_layer_len - dev->d_sndlen);
+      sum = chksum_add(sum, ntohs(dev->d_sndsum));
+    }
+  else
+    {
+      sum = chksum(sum, &dev->d_buf[UIP_IPH_LEN + UIP_LLH_LEN], upper_layer_len);
+    }
 
   return (sum == 0) ? 0xffff : htons(sum);
 }
@@ -187,6 +357,14 @@ uint16_t uip_chksum(uint16_t *data, uint16_t len)
   return htons(chksum(0, (uint8_t *)data, len));
 }
 
+/* Copy a buffer and calculate the Internet checksum of the data. */
+
+uint16_t uip_chksumcopy(FAR void *dest, FAR const void *src, uint16_t len)
+{
+  return htons(chksumcopy(0, (FAR uint8_t *)dest, (FAR const uint8_t *)src,
+                          len));
+}
+
 /* Calculate the IP header checksum of the packet header in d_buf. */
 
 #ifndef UIP_ARCH_IPCHKSUM
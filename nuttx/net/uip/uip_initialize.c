@@ -46,6 +46,7 @@
 
 #include <stdint.h>
 #include <net/uip/uip.h>
+#include <net/uip/uip-arp.h>
 
 #include "uip_internal.h"
 
@@ -123,6 +124,16 @@ void uip_initialize(void)
 
   uip_callbackinit();
 
+  /* Initialize the pool of I/O buffers */
+
+#if CONFIG_NET_NIOBS > 0
+  uip_iobinit();
+#endif
+
+  /* Initialize the ARP table */
+
+  uip_arp_init();
+
   /* Initialize the listening port structures */
 
 #ifdef CONFIG_NET_TCP
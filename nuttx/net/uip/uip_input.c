@@ -297,8 +297,15 @@ nullreturn:
 void uip_input(struct uip_driver_s *dev)
 {
   struct uip_ip_hdr *pbuf = BUF;
+  uip_lock_t flags;
 
-  /* This is where the input processing starts. */
+  /* This is where the input processing starts.  Any reply will be built
+   * in d_buf.  The network is locked only until the reply is built; the
+   * driver sends it after we return.
+   */
+
+  flags = uip_lock();
+  uip_sndclear(dev);
 
 #ifdef CONFIG_NET_STATISTICS
   uip_stat.ip.recv++;
@@ -401,7 +408,7 @@ void uip_input(struct uip_driver_s *dev)
 #endif
     {
       uip_udpinput(dev);
-      return;
+      goto done;
     }
 
   /* In most other cases, the device must be assigned a non-zero IP
@@ -532,10 +539,13 @@ void uip_input(struct uip_driver_s *dev)
 
   /* Return and let the caller do any actual transmission. */
 
-  return;
+  goto done;
 
 drop:
   dev->d_len = 0;
+
+done:
+  uip_unlock(flags);
 }
 #endif /* CONFIG_NET */
 
@@ -51,11 +51,28 @@
 #include <errno.h>
 #include <arch/irq.h>
 #include <net/uip/uip.h>
+#include <net/uip/uip-arch.h>
 
 /****************************************************************************
  * Public Macro Definitions
  ****************************************************************************/
 
+/* Hash a port number (in network byte order) into a table of 'n' buckets.
+ * 'n' must be a power of two.  Both bytes of the port number contribute to
+ * the hash so that consecutive port numbers land in different buckets
+ * regardless of the host byte order.
+ */
+
+#define uip_porthash(p,n) ((((p) >> 8) ^ (p)) & ((n) - 1))
+
+/* The number of bytes of data in the send queue of a TCP connection */
+
+#if CONFIG_NET_TCP_SENDQSIZE > 0
+#  define uip_tcpsendqlen(conn) ((conn)->sndq ? (conn)->sndq->io_pktlen : 0)
+#else
+#  define uip_tcpsendqlen(conn) (0)
+#endif
+
 /****************************************************************************
  * Public Type Definitions
  ****************************************************************************/
@@ -147,6 +164,9 @@ EXTERN void uip_tcpappsend(struct uip_driver_s *dev, struct uip_conn *conn,
                            uint16_t result);
 EXTERN void uip_tcprexmit(struct uip_driver_s *dev, struct uip_conn *conn,
                           uint16_t result);
+EXTERN void uip_tcpretransmit(struct uip_driver_s *dev, struct uip_conn *conn,
+                              bool fast);
+EXTERN uint16_t uip_tcpwndavail(FAR struct uip_conn *conn);
 
 /* Defined in uip_tcpinput.c ************************************************/
 
@@ -163,10 +183,48 @@ EXTERN uint16_t uip_tcpcallback(struct uip_driver_s *dev,
 EXTERN void uip_tcpreadaheadinit(void);
 EXTERN struct uip_readahead_s *uip_tcpreadaheadalloc(void);
 EXTERN void uip_tcpreadaheadrelease(struct uip_readahead_s *buf);
+EXTERN unsigned int uip_tcpreadaheadnfree(void);
 #endif /* CONFIG_NET_NTCP_READAHEAD_BUFFERS */
 
+/* Defined in uip_tcpsendq.c ************************************************/
+
+#if CONFIG_NET_TCP_SENDQSIZE > 0
+EXTERN int uip_tcpsendqadd(FAR struct uip_conn *conn, FAR const uint8_t *buf,
+                           unsigned int len);
+EXTERN uint16_t uip_tcpsendqcopy(FAR struct uip_driver_s *dev,
+                                 FAR struct uip_conn *conn);
+EXTERN void uip_tcpsendqack(FAR struct uip_conn *conn, uint32_t acked);
+EXTERN void uip_tcpsendqfree(FAR struct uip_conn *conn);
+#endif /* CONFIG_NET_TCP_SENDQSIZE */
+
+/* Defined in uip_tcpwnd.c **************************************************/
+
+EXTERN uip_tcpwnd_t uip_tcprcvwnd(FAR struct uip_conn *conn);
+EXTERN bool uip_tcpwndupdate(FAR struct uip_conn *conn);
+EXTERN bool uip_tcpackdue(FAR struct uip_conn *conn);
+#ifdef CONFIG_NET_TCP_DELAYED_ACK
+EXTERN bool uip_tcpdelayack(FAR struct uip_conn *conn, uint16_t len);
+#endif
+
 #endif /* CONFIG_NET_TCP */
 
+#ifdef CONFIG_NET_ARP
+/* Defined in uip_arptab.c **************************************************/
+
+#if CONFIG_NET_ARP_NPENDING > 0
+EXTERN void uip_arp_queue(FAR struct uip_driver_s *dev, in_addr_t ipaddr);
+EXTERN bool uip_arp_dequeue(FAR struct uip_driver_s *dev);
+EXTERN int uip_arp_poll(FAR struct uip_driver_s *dev,
+                        uip_poll_callback_t callback);
+#endif /* CONFIG_NET_ARP_NPENDING */
+#endif /* CONFIG_NET_ARP */
+
+/* Defined in uip_iob.c *****************************************************/
+
+#if CONFIG_NET_NIOBS > 0
+EXTERN void uip_iobinit(void);
+#endif
+
 #ifdef CONFIG_NET_UDP
 /* Defined in uip_udpconn.c *************************************************/
 
@@ -0,0 +1,345 @@
+/****************************************************************************
+ * net/uip/uip_iob.c
+ *
+ *   Copyright (C) 2012 Gregory Nutt. All rights reserved.
+ *   Author: Gregory Nutt <gnutt@nuttx.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name NuttX nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <net/uip/uipopt.h>
+#if defined(CONFIG_NET) && CONFIG_NET_NIOBS > 0
+
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+#include <errno.h>
+#include <debug.h>
+
+#include <nuttx/mempool.h>
+#include <net/uip/uip-iob.h>
+
+#include "uip_internal.h"
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+/* These are the pre-allocated I/O buffers */
+
+static struct uip_iob_s g_iobuffers[CONFIG_NET_NIOBS];
+
+/* This is the pool of available I/O buffers */
+
+static struct mempool_s g_iobpool;
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Function: uip_iobinit
+ *
+ * Description:
+ *   Initialize the pool of free I/O buffers
+ *
+ * Assumptions:
+ *   Called once early initialization.
+ *
+ ****************************************************************************/
+
+void uip_iobinit(void)
+{
+  (void)mempool_create(&g_iobpool, "iob", g_iobuffers,
+                       sizeof(struct uip_iob_s), CONFIG_NET_NIOBS, 0);
+}
+
+/****************************************************************************
+ * Function: uip_ioballoc
+ *
+ * Description:
+ *   Take one empty I/O buffer from the pool.  This does not wait and may be
+ *   called from interrupt level.
+ *
+ * Returned Value:
+ *   The I/O buffer or NULL if the pool is empty.
+ *
+ ****************************************************************************/
+
+FAR struct uip_iob_s *uip_ioballoc(void)
+{
+  FAR struct uip_iob_s *iob;
+
+  iob = (FAR struct uip_iob_s *)mempool_alloc(&g_iobpool);
+  if (iob)
+    {
+      iob->io_flink  = NULL;
+      iob->io_len    = 0;
+      iob->io_offset = 0;
+      iob->io_pktlen = 0;
+    }
+
+  return iob;
+}
+
+/****************************************************************************
+ * Function: uip_iobfree
+ *
+ * Description:
+ *   Return one I/O buffer to the pool.
+ *
+ * Returned Value:
+ *   The next I/O buffer in the chain (if any).
+ *
+ ****************************************************************************/
+
+FAR struct uip_iob_s *uip_iobfree(FAR struct uip_iob_s *iob)
+{
+  FAR struct uip_iob_s *next = iob->io_flink;
+
+  mempool_free(&g_iobpool, iob);
+  return next;
+}
+
+/****************************************************************************
+ * Function: uip_iobfreechain
+ *
+ * Description:
+ *   Return every I/O buffer of a chain to the pool.
+ *
+ ****************************************************************************/
+
+void uip_iobfreechain(FAR struct uip_iob_s *iob)
+{
+  while (iob)
+    {
+      iob = uip_iobfree(iob);
+    }
+}
+
+/****************************************************************************
+ * Function: uip_iobcopyin
+ *
+ * Description:
+ *   Copy 'len' bytes of data into the chain beginning at 'offset' bytes
+ *   from the start of the chain.  'offset' may not be beyond the end of the
+ *   data already in the chain.  More I/O buffers are added to the end of
+ *   the chain as necessary.
+ *
+ * Returned Value:
+ *   Zero on success; -ENOMEM if the pool ran out of I/O buffers (the data
+ *   that did fit is kept in the chain).
+ *
+ ****************************************************************************/
+
+int uip_iobcopyin(FAR struct uip_iob_s *iob, FAR const uint8_t *src,
+                  unsigned int len, unsigned int offset)
+{
+  FAR struct uip_iob_s *head = iob;
+  FAR struct uip_iob_s *next;
+  unsigned int end;
+  unsigned int avail;
+  unsigned int ncopy;
+  int ret = OK;
+
+  DEBUGASSERT(offset <= head->io_pktlen);
+  end = offset;
+
+  while (len > 0)
+    {
+      /* Data may be written up to the end of the valid data in this buffer
+       * or, if this is the last buffer in the chain, up to the end of the
+       * buffer.
+       */
+
+      if (iob->io_flink)
+        {
+          avail = iob->io_len;
+        }
+      else
+        {
+          avail = CONFIG_NET_IOB_BUFSIZE - iob->io_offset;
+        }
+
+      if (offset < avail)
+        {
+          ncopy = avail - offset;
+          if (ncopy > len)
+            {
+              ncopy = len;
+            }
+
+          memcpy(&iob->io_data[iob->io_offset + offset], src, ncopy);
+
+          src    += ncopy;
+          len    -= ncopy;
+          offset += ncopy;
+          end    += ncopy;
+
+          if (offset > iob->io_len)
+            {
+              iob->io_len = offset;
+            }
+        }
+
+      /* Move on to the next buffer, extending the chain if necessary */
+
+      if (len > 0)
+        {
+          next = iob->io_flink;
+          if (!next)
+            {
+              next = uip_ioballoc();
+              if (!next)
+                {
+                  nlldbg("Out of I/O buffers\n");
+                  ret = -ENOMEM;
+                  break;
+                }
+
+              iob->io_flink = next;
+            }
+
+          offset -= iob->io_len;
+          iob     = next;
+        }
+    }
+
+  if (end > head->io_pktlen)
+    {
+      head->io_pktlen = end;
+    }
+
+  return ret;
+}
+
+/****************************************************************************
+ * Function: uip_iobcopyout
+ *
+ * Description:
+ *   Copy up to 'len' bytes of data from the chain, beginning 'offset' bytes
+ *   from the start of the chain, into a linear buffer.
+ *
+ * Returned Value:
+ *   The number of bytes copied.
+ *
+ ****************************************************************************/
+
+unsigned int uip_iobcopyout(FAR uint8_t *dest, FAR const struct uip_iob_s *iob,
+                            unsigned int len, unsigned int offset)
+{
+  unsigned int ncopied = 0;
+  unsigned int ncopy;
+
+  while (iob && len > 0)
+    {
+      /* Skip over the buffers before 'offset' */
+
+      if (offset >= iob->io_len)
+        {
+          offset -= iob->io_len;
+        }
+      else
+        {
+          ncopy = iob->io_len - offset;
+          if (ncopy > len)
+            {
+              ncopy = len;
+            }
+
+          memcpy(dest, &iob->io_data[iob->io_offset + offset], ncopy);
+
+          dest    += ncopy;
+          len     -= ncopy;
+          ncopied += ncopy;
+          offset   = 0;
+        }
+
+      iob = iob->io_flink;
+    }
+
+  return ncopied;
+}
+
+/****************************************************************************
+ * Function: uip_iobtrimhead
+ *
+ * Description:
+ *   Remove 'trimlen' bytes from the beginning of the chain.  I/O buffers
+ *   that become empty are returned to the pool.
+ *
+ * Returned Value:
+ *   The new head of the chain or NULL if the whole chain was freed.
+ *
+ ****************************************************************************/
+
+FAR struct uip_iob_s *uip_iobtrimhead(FAR struct uip_iob_s *iob,
+                                      unsigned int trimlen)
+{
+  unsigned int pktlen = iob->io_pktlen;
+
+  if (trimlen >= pktlen)
+    {
+      uip_iobfreechain(iob);
+      return NULL;
+    }
+
+  pktlen -= trimlen;
+  while (trimlen > 0)
+    {
+      if (trimlen >= iob->io_len)
+        {
+          /* This whole buffer is trimmed */
+
+          trimlen -= iob->io_len;
+          iob      = uip_iobfree(iob);
+        }
+      else
+        {
+          /* Part of this buffer is trimmed */
+
+          iob->io_offset += trimlen;
+          iob->io_len    -= trimlen;
+          trimlen         = 0;
+        }
+    }
+
+  iob->io_pktlen = pktlen;
+  return iob;
+}
+
+#endif /* CONFIG_NET && CONFIG_NET_NIOBS > 0 */
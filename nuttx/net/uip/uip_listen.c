@@ -56,9 +56,12 @@
  * Private Data
  ****************************************************************************/
 
-/* The uip_listenports list all currently listening ports. */
+/* The listening connections are kept in a hash table keyed on the local
+ * port.  At most CONFIG_NET_MAX_LISTENPORTS connections may listen.
+ */
 
-static struct uip_conn *uip_listenports[CONFIG_NET_MAX_LISTENPORTS];
+static struct uip_conn *g_listenhash[CONFIG_NET_TCP_NHASH];
+static int g_nlisteners;
 
 /****************************************************************************
  * Private Functions
@@ -77,18 +80,16 @@ static struct uip_conn *uip_listenports[CONFIG_NET_MAX_LISTENPORTS];
 
 struct uip_conn *uip_findlistener(uint16_t portno)
 {
-  int ndx;
+  struct uip_conn *conn;
 
-  /* Examine each connection structure in each slot of the listener list */
+  /* Examine each listening connection with the same hash of the port */
 
-  for (ndx = 0; ndx < CONFIG_NET_MAX_LISTENPORTS; ndx++)
+  conn = g_listenhash[uip_porthash(portno, CONFIG_NET_TCP_NHASH)];
+  for (; conn; conn = conn->lflink)
     {
-      /* Is this slot assigned?  If so, does the connection have the same
-       * local port number?
-       */
+      /* Does the connection have the same local port number? */
 
-      struct uip_conn *conn = uip_listenports[ndx];
-      if (conn && conn->lport == portno)
+      if (conn->lport == portno)
         {
           /* Yes.. we found a listener on this port */
 
@@ -120,10 +121,12 @@ struct uip_conn *uip_findlistener(uint16_t portno)
 void uip_listeninit(void)
 {
   int ndx;
-  for (ndx = 0; ndx < CONFIG_NET_MAX_LISTENPORTS; ndx++)
+  for (ndx = 0; ndx < CONFIG_NET_TCP_NHASH; ndx++)
     {
-      uip_listenports[ndx] = NULL;
+      g_listenhash[ndx] = NULL;
     }
+
+  g_nlisteners = 0;
 }
 
 /****************************************************************************
@@ -139,16 +142,18 @@ void uip_listeninit(void)
 
 int uip_unlisten(struct uip_conn *conn)
 {
+  struct uip_conn **pprev;
   uip_lock_t flags;
-  int ndx;
   int ret = -EINVAL;
 
   flags = uip_lock();
-  for (ndx = 0; ndx < CONFIG_NET_MAX_LISTENPORTS; ndx++)
+  pprev = &g_listenhash[uip_porthash(conn->lport, CONFIG_NET_TCP_NHASH)];
+  for (; *pprev; pprev = &(*pprev)->lflink)
     {
-      if (uip_listenports[ndx] == conn)
+      if (*pprev == conn)
         {
-          uip_listenports[ndx] = NULL;
+          *pprev = conn->lflink;
+          g_nlisteners--;
           ret = OK;
           break;
         }
@@ -171,8 +176,8 @@ int uip_unlisten(struct uip_conn *conn)
 
 int uip_listen(struct uip_conn *conn)
 {
+  struct uip_conn **pprev;
   uip_lock_t flags;
-  int ndx;
   int ret;
 
   /* This must be done with interrupts disabled because the listener table
@@ -189,29 +194,23 @@ int uip_listen(struct uip_conn *conn)
 
       ret = -EADDRINUSE;
     }
+  else if (g_nlisteners >= CONFIG_NET_MAX_LISTENPORTS)
+    {
+      /* No, but there are already too many listeners */
+
+      ret = -ENOBUFS;
+    }
   else
     {
       /* Otherwise, save a reference to the connection structure in the
-       * "listener" list.
+       * "listener" hash table.
        */
 
-      ret = -ENOBUFS; /* Assume failure */
-
-      /* Search all slots until an available slot is found */
-
-      for (ndx = 0; ndx < CONFIG_NET_MAX_LISTENPORTS; ndx++)
-        {
-          /* Is the next slot available? */
-
-          if (!uip_listenports[ndx])
-            {
-              /* Yes.. we found it */
-
-              uip_listenports[ndx] = conn;
-              ret = OK;
-              break;
-            }
-        }
+      pprev        = &g_listenhash[uip_porthash(conn->lport, CONFIG_NET_TCP_NHASH)];
+      conn->lflink = *pprev;
+      *pprev       = conn;
+      g_nlisteners++;
+      ret          = OK;
     }
 
   uip_unlock(flags);
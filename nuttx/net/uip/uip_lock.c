@@ -39,6 +39,7 @@
 
 #include <nuttx/config.h>
 
+#include <unistd.h>
 #include <semaphore.h>
 #include <assert.h>
 #include <errno.h>
@@ -59,9 +60,9 @@
  * Private Data
  ****************************************************************************/
 
-static sem_t        g_uipsem;
-static pid_t        g_holder  = NO_HOLDER;
-static unsigned int g_count   = 0;
+/* The global network lock */
+
+static struct uip_mutex_s g_uiplock;
 
 /****************************************************************************
  * Private Functions
@@ -71,13 +72,28 @@ static unsigned int g_count   = 0;
  * Function: uip_takesem
  *
  * Description:
- *   Take the semaphore
+ *   Take the semaphore of a lock, counting the contention if another thread
+ *   holds it.
  *
  ****************************************************************************/
 
-static void uip_takesem(void)
+static void uip_takesem(FAR struct uip_mutex_s *mutex)
 {
-  while (sem_wait(&g_uipsem) != 0)
+  /* Try first without waiting.  This is the normal case. */
+
+  if (sem_trywait(&mutex->um_sem) == 0)
+    {
+      return;
+    }
+
+  /* Another thread holds the lock */
+
+  if (mutex->um_waits)
+    {
+      (*mutex->um_waits)++;
+    }
+
+  while (sem_wait(&mutex->um_sem) != 0)
     {
       /* The only case that an error should occur here is if the wait was
        * awakened by a signal.
@@ -92,81 +108,159 @@ static void uip_takesem(void)
  ****************************************************************************/
 
 /****************************************************************************
- * Function: uip_lockinit
+ * Function: uip_mutexinit
  *
  * Description:
- *   Initialize the locking facility
+ *   Initialize a lock.  'waits' is the contention counter that will be
+ *   incremented each time that a thread has to wait for the lock.  It may
+ *   be NULL.
  *
  ****************************************************************************/
 
-void uip_lockinit(void)
+void uip_mutexinit(FAR struct uip_mutex_s *mutex, FAR uip_stats_t *waits)
 {
-  sem_init(&g_uipsem, 0, 1);
+  sem_init(&mutex->um_sem, 0, 1);
+  mutex->um_holder = NO_HOLDER;
+  mutex->um_count  = 0;
+  mutex->um_waits  = waits;
 }
 
 /****************************************************************************
- * Function: uip_lock
+ * Function: uip_mutexlock
  *
  * Description:
- *   Take the lock
+ *   Take a lock.  The lock is re-entrant:  the thread that holds it may
+ *   take it again.
  *
  ****************************************************************************/
 
-uip_lock_t uip_lock(void)
+uip_lock_t uip_mutexlock(FAR struct uip_mutex_s *mutex)
 {
   pid_t me = getpid();
 
   /* Does this thread already hold the semaphore? */
 
-  if (g_holder == me)
+  if (mutex->um_holder == me)
     {
       /* Yes.. just increment the reference count */
 
-      g_count++;
+      mutex->um_count++;
     }
   else
     {
       /* No.. take the semaphore (perhaps waiting) */
 
-      uip_takesem();
+      uip_takesem(mutex);
 
       /* Now this thread holds the semaphore */
 
-      g_holder = me;
-      g_count  = 1;
+      mutex->um_holder = me;
+      mutex->um_count  = 1;
     }
 
   return 0;
 }
 
 /****************************************************************************
- * Function: uip_unlock
+ * Function: uip_mutexunlock
  *
  * Description:
- *   Release the lock.
+ *   Release a lock.
  *
  ****************************************************************************/
 
-void uip_unlock(uip_lock_t flags)
+void uip_mutexunlock(FAR struct uip_mutex_s *mutex, uip_lock_t flags)
 {
-  DEBUGASSERT(g_holder == getpid() && g_count > 0);
+  DEBUGASSERT(mutex->um_holder == getpid() && mutex->um_count > 0);
 
   /* If the count would go to zero, then release the semaphore */
 
-  if (g_count == 1)
+  if (mutex->um_count == 1)
     {
       /* We no longer hold the semaphore */
 
-      g_holder = NO_HOLDER;
-      g_count  = 0;
-      sem_post(&g_uipsem);
+      mutex->um_holder = NO_HOLDER;
+      mutex->um_count  = 0;
+      sem_post(&mutex->um_sem);
     }
   else
     {
       /* We still hold the semaphore. Just decrement the count */
 
-      g_count--;
+      mutex->um_count--;
+    }
+}
+
+/****************************************************************************
+ * Function: uip_lockinit
+ *
+ * Description:
+ *   Initialize the locking facility
+ *
+ ****************************************************************************/
+
+void uip_lockinit(void)
+{
+  uip_mutexinit(&g_uiplock, UIP_LOCKSTAT(stack));
+}
+
+/****************************************************************************
+ * Function: uip_lock
+ *
+ * Description:
+ *   Take the lock
+ *
+ ****************************************************************************/
+
+uip_lock_t uip_lock(void)
+{
+  return uip_mutexlock(&g_uiplock);
+}
+
+/****************************************************************************
+ * Function: uip_trylock
+ *
+ * Description:
+ *   Take the lock only if that can be done without waiting.  This is for
+ *   logic that must not block, such as a driver polled from the IDLE loop.
+ *
+ * Returned Value:
+ *   OK if the lock was taken; -EBUSY if another thread holds it.
+ *
+ ****************************************************************************/
+
+int uip_trylock(void)
+{
+  pid_t me = getpid();
+
+  if (g_uiplock.um_holder == me)
+    {
+      g_uiplock.um_count++;
     }
+  else if (sem_trywait(&g_uiplock.um_sem) == 0)
+    {
+      g_uiplock.um_holder = me;
+      g_uiplock.um_count  = 1;
+    }
+  else
+    {
+      return -EBUSY;
+    }
+
+  return OK;
+}
+
+/****************************************************************************
+ * Function: uip_unlock
+ *
+ * Description:
+ *   Release the lock.
+ *
+ ****************************************************************************/
+
+void uip_unlock(uip_lock_t flags)
+{
+  uip_mutexunlock(&g_uiplock, flags);
 }
 
 /****************************************************************************
@@ -186,14 +280,14 @@ int uip_lockedwait(sem_t *sem)
 
   flags = irqsave(); /* No interrupts */
   sched_lock();      /* No context switches */
-  if (g_holder == me)
+  if (g_uiplock.um_holder == me)
     {
       /* Release the uIP semaphore, remembering the count */
  
-      count    = g_count;
-      g_holder = NO_HOLDER;
-      g_count  = 0;
-      sem_post(&g_uipsem);
+      count               = g_uiplock.um_count;
+      g_uiplock.um_holder = NO_HOLDER;
+      g_uiplock.um_count  = 0;
+      sem_post(&g_uiplock.um_sem);
 
       /* Now take semaphore */
 
@@ -201,9 +295,9 @@ int uip_lockedwait(sem_t *sem)
 
       /* Recover the uIP semaphore at the proper count */
 
-      uip_takesem();
-      g_holder = me;
-      g_count  = count;
+      uip_takesem(&g_uiplock);
+      g_uiplock.um_holder = me;
+      g_uiplock.um_count  = count;
     }
   else
     {
@@ -40,6 +40,7 @@
 #include <nuttx/config.h>
 #ifdef CONFIG_NET
 
+#include <stdbool.h>
 #include <debug.h>
 
 #include <net/uip/uipopt.h>
@@ -73,6 +74,7 @@ static inline int uip_pollicmp(struct uip_driver_s *dev, uip_poll_callback_t cal
 {
   /* Perform the UDP TX poll */
 
+  uip_sndclear(dev);
   uip_icmppoll(dev);
 
   /* Call back into the driver */
@@ -98,6 +100,7 @@ static inline int uip_polligmp(struct uip_driver_s *dev, uip_poll_callback_t cal
 {
   /* Perform the UDP TX poll */
 
+  uip_sndclear(dev);
   uip_igmppoll(dev);
 
   /* Call back into the driver */
@@ -131,6 +134,7 @@ static int uip_polludpconnections(struct uip_driver_s *dev,
     {
       /* Perform the UDP TX poll */
 
+      uip_sndclear(dev);
       uip_udppoll(dev, udp_conn);
 
       /* Call back into the driver */
@@ -160,18 +164,31 @@ static inline int uip_polltcpconnections(struct uip_driver_s *dev,
 {
   struct uip_conn *conn  = NULL;
   int              bstop = 0;
+  int              nsegs;
+  bool             sent;
 
   /* Traverse all of the active TCP connections and perform the poll action */
 
   while (!bstop && (conn = uip_nexttcpconn(conn)))
     {
-      /* Perform the TCP TX poll */
+      /* Poll the connection again as long as it sends a new data segment,
+       * up to CONFIG_NET_TCP_SNDBURST segments.
+       */
 
-      uip_tcppoll(dev, conn);
+      nsegs = 0;
+      do
+        {
+          /* Perform the TCP TX poll */
 
-      /* Call back into the driver */
+          uip_sndclear(dev);
+          uip_tcppoll(dev, conn);
+          sent = (dev->d_len > 0 && dev->d_sndlen > 0);
 
-      bstop = callback(dev);
+          /* Call back into the driver */
+
+          bstop = callback(dev);
+        }
+      while (!bstop && sent && ++nsegs < CONFIG_NET_TCP_SNDBURST);
     }
 
   return bstop;
@@ -206,6 +223,7 @@ static inline int uip_polltcptimer(struct uip_driver_s *dev,
     {
       /* Perform the TCP timer poll */
 
+      uip_sndclear(dev);
       uip_tcptimer(dev, conn, hsec);
 
       /* Call back into the driver */
@@ -249,8 +267,24 @@ static inline int uip_polltcptimer(struct uip_driver_s *dev,
 
 int uip_poll(struct uip_driver_s *dev, uip_poll_callback_t callback)
 {
+  uip_lock_t flags;
   int bstop;
 
+  /* The callback is called with the network locked */
+
+  flags = uip_lock();
+
+#if CONFIG_NET_ARP_NPENDING > 0
+  /* Send the packets that were waiting for an ARP reply */
+
+  bstop = uip_arp_poll(dev, callback);
+  if (bstop)
+    {
+      uip_unlock(flags);
+      return bstop;
+    }
+#endif
+
   /* Check for pendig IGMP messages */
 
 #ifdef CONFIG_NET_IGMP
@@ -279,6 +313,7 @@ int uip_poll(struct uip_driver_s *dev, uip_poll_callback_t callback)
         }
     }
 
+  uip_unlock(flags);
   return bstop;
 }
 
@@ -308,8 +343,13 @@ int uip_poll(struct uip_driver_s *dev, uip_poll_callback_t callback)
 
 int uip_timer(struct uip_driver_s *dev, uip_poll_callback_t callback, int hsec)
 {
+  uip_lock_t flags;
   int bstop;
 
+  /* The callback is called with the network locked */
+
+  flags = uip_lock();
+
   /* Increment the timer used by the IP reassembly logic */
 
 #if UIP_REASSEMBLY
@@ -319,6 +359,17 @@ int uip_timer(struct uip_driver_s *dev, uip_poll_callback_t callback, int hsec)
     }
 #endif /* UIP_REASSEMBLY */
 
+#if CONFIG_NET_ARP_NPENDING > 0
+  /* Send the packets that were waiting for an ARP reply */
+
+  bstop = uip_arp_poll(dev, callback);
+  if (bstop)
+    {
+      uip_unlock(flags);
+      return bstop;
+    }
+#endif
+
   /* Check for pendig IGMP messages */
 
 #ifdef CONFIG_NET_IGMP
@@ -347,6 +398,7 @@ int uip_timer(struct uip_driver_s *dev, uip_poll_callback_t callback, int hsec)
         }
     }
 
+  uip_unlock(flags);
   return bstop;
 }
 
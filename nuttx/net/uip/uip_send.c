@@ -41,6 +41,8 @@
  * Included Files
  ****************************************************************************/
 
+#include <nuttx/config.h>
+
 #include <string.h>
 #include <debug.h>
 
@@ -84,7 +86,9 @@
  *
  * Description:
  *   Called from socket logic in response to a xmit or poll request from the
- *   the network interface driver.
+ *   the network interface driver.  The checksum of the data is computed
+ *   while the data is copied so that the TCP or UDP checksum does not have
+ *   to read the data again.
  *
  * Assumptions:
  *   Called from the interrupt level or, at a mimimum, with interrupts
@@ -100,7 +104,34 @@ void uip_send(struct uip_driver_s *dev, const void *buf, int len)
 
   if (dev && len > 0 && len < CONFIG_NET_BUFSIZE)
     {
-      memcpy(dev->d_snddata, buf, len);
-      dev->d_sndlen = len;
+      dev->d_sndsum      = uip_chksumcopy(dev->d_snddata, buf, len);
+      dev->d_sndsumvalid = true;
+      dev->d_sndlen      = len;
    }
 }
+
+/****************************************************************************
+ * Name: uip_sgsend
+ *
+ * Description:
+ *   Like uip_send(), but the data is not copied into d_buf.  The driver
+ *   sends the headers from d_buf and then the data from 'buf'.  The data
+ *   must not change until it has been acknowledged.
+ *
+ * Assumptions:
+ *   Called from the interrupt level or, at a mimimum, with interrupts
+ *   disabled.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_NET_SGSEND
+void uip_sgsend(struct uip_driver_s *dev, FAR const void *buf, int len)
+{
+  if (dev && len > 0 && len < CONFIG_NET_BUFSIZE)
+    {
+      dev->d_sgdata      = buf;
+      dev->d_sndsumvalid = false;
+      dev->d_sndlen      = len;
+    }
+}
+#endif
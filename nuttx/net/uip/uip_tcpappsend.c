@@ -52,6 +52,10 @@
 #include <net/uip/uip.h>
 #include <net/uip/uip-arch.h>
 
+#ifdef CONFIG_NET_ARP_IPIN
+#  include <net/uip/uip-arp.h>
+#endif
+
 #include "uip_internal.h"
 
 /****************************************************************************
@@ -108,6 +112,7 @@ void uip_tcpappsend(struct uip_driver_s *dev, struct uip_conn *conn,
   if ((result & UIP_ABORT) != 0)
     {
       dev->d_sndlen = 0;
+      uip_sndclear(dev);
       conn->tcpstateflags = UIP_CLOSED;
       nllvdbg("TCP state: UIP_CLOSED\n");
 
@@ -120,10 +125,13 @@ void uip_tcpappsend(struct uip_driver_s *dev, struct uip_conn *conn,
     {
       conn->tcpstateflags = UIP_FIN_WAIT_1;
       conn->unacked  = 1;
+      conn->sent     = 0;
       conn->nrtx     = 0;
+      conn->timer    = conn->rto;
       nllvdbg("TCP state: UIP_FIN_WAIT_1\n");
 
       dev->d_sndlen  = 0;
+      uip_sndclear(dev);
       uip_tcpsend(dev, conn, TCP_FIN | TCP_ACK, UIP_IPTCPH_LEN);
     }
 
@@ -131,29 +139,14 @@ void uip_tcpappsend(struct uip_driver_s *dev, struct uip_conn *conn,
 
   else
     {
-      /* If d_sndlen > 0, the application has data to be sent. */
-
-      if (dev->d_sndlen > 0)
-        {
-          /* Remember how much data we send out now so that we know
-           * when everything has been acknowledged.  Just increment the amount
-           * of data sent.  This will be needed in sequence number calculations
-           * and we know that this is not a re-tranmission.  Retransmissions
-           * do not go through this path.
-           */
-
-          conn->unacked += dev->d_sndlen;
-
-          /* The application cannot send more than what is allowed by the
-           * MSS (the minumum of the MSS and the available window).
-           */
+      /* The application cannot send more than what is allowed by the
+       * MSS (the minumum of the MSS and the available window).
+       */
 
-          DEBUGASSERT(dev->d_sndlen <= conn->mss);
-        }
+      DEBUGASSERT(dev->d_sndlen <= conn->mss);
 
       /* Then handle the rest of the operation just as for the rexmit case */
 
-      conn->nrtx = 0;
       uip_tcprexmit(dev, conn, result);
     }
 }
@@ -162,7 +155,11 @@ void uip_tcpappsend(struct uip_driver_s *dev, struct uip_conn *conn,
  * Name: uip_tcprexmit
  *
  * Description:
- *   Handle application retransmission
+ *   Send the data provided by the application (or, if the application
+ *   provided none, the next data from the send queue) at sequence number
+ *   sndseq + sent.  This may be new data or data that is being sent again
+ *   after a retransmission.  If there is no data to send, send an ACK if
+ *   one was requested.
  *
  * Parameters:
  *   dev    - The device driver structure to use in the send operation
@@ -180,28 +177,95 @@ void uip_tcpappsend(struct uip_driver_s *dev, struct uip_conn *conn,
 void uip_tcprexmit(struct uip_driver_s *dev, struct uip_conn *conn,
                    uint16_t result)
 {
+  uint32_t seqno;
+
   nllvdbg("result: %04x d_sndlen: %d conn->unacked: %d\n",
           result, dev->d_sndlen, conn->unacked);
 
   dev->d_appdata = dev->d_snddata;
 
+  /* If the application has nothing to send, then take the next data from
+   * the send queue (if any).
+   */
+
+#if CONFIG_NET_TCP_SENDQSIZE > 0
+  if (dev->d_sndlen == 0)
+    {
+      dev->d_sndlen = uip_tcpsendqcopy(dev, conn);
+    }
+#endif
+
   /* If the application has data to be sent, or if the incoming packet had
    * new data in it, we must send out a packet.
    */
 
-  if (dev->d_sndlen > 0 && conn->unacked > 0)
+  if (dev->d_sndlen > 0)
     {
       /* We always set the ACK flag in response packets adding the length of
-       * the IP and TCP headers.
+       * the IP and TCP headers.  The data is sent at sequence number
+       * sndseq + sent.
        */
 
       uip_tcpsend(dev, conn, TCP_ACK | TCP_PSH, dev->d_sndlen + UIP_TCPIP_HLEN);
+
+      /* Check if the destination IP address is in the ARP table.  If not,
+       * then the send won't actually make it out... it will be replaced with
+       * an ARP request.  In that case, the data is not counted as sent and
+       * will be sent again on the next poll.
+       *
+       * NOTE 1: This could an expensive check if there are a lot of entries
+       * in the ARP table.  Hence, we only check when no data is outstanding.
+       *
+       * NOTE 2: If we are actually harvesting IP addresses on incomming IP
+       * packets, then this check should not be necessary; the MAC mapping
+       * should already be in the ARP table.
+       */
+
+#if defined(CONFIG_NET_ETHERNET) && defined (CONFIG_NET_ARP_IPIN)
+      if (conn->unacked == 0 && uip_arp_find(conn->ripaddr) == NULL)
+        {
+          return;
+        }
+#endif
+
+      /* If nothing was outstanding, then start the retransmission timer */
+
+      if (conn->unacked == 0)
+        {
+          conn->timer = conn->rto;
+        }
+
+      /* Is this new data (i.e., not data being sent again after a
+       * retransmission)?
+       */
+
+      conn->sent += dev->d_sndlen;
+      if (conn->sent > conn->unacked)
+        {
+          /* Yes.. Remember how much data is now outstanding so that we
+           * know when everything has been acknowledged.
+           */
+
+          conn->unacked = conn->sent;
+
+          /* Time the round trip of this segment if no other measurement
+           * is in progress.
+           */
+
+          if (conn->rtt == 0)
+            {
+              seqno     = uip_tcpaddsequence(conn->sndseq, conn->sent);
+              uip_tcpsetsequence(conn->rttseq, seqno);
+              conn->rtt = 1;
+            }
+        }
     }
 
   /* If there is no data to send, just send out a pure ACK if one is requested`. */
 
   else if ((result & UIP_SNDACK) != 0)
     {
+      uip_sndclear(dev);
       uip_tcpsend(dev, conn, TCP_ACK, UIP_TCPIP_HLEN);
     }
 
@@ -209,7 +273,116 @@ void uip_tcprexmit(struct uip_driver_s *dev, struct uip_conn *conn,
 
   else
     {
+      uip_sndclear(dev);
       dev->d_len = 0;
     }
 }
+
+/****************************************************************************
+ * Name: uip_tcpretransmit
+ *
+ * Description:
+ *   Retransmit the oldest unacknowledged data.  After a retransmission
+ *   timeout, all of the unacknowledged data will be sent again (go-back-N).
+ *   On a fast retransmission of data from the send queue, only the
+ *   oldest segment is sent again and sending then continues from where it
+ *   left off.
+ *
+ * Parameters:
+ *   dev    - The device driver structure to use in the send operation
+ *   conn   - The TCP connection structure holding connection information
+ *   fast   - True: Fast retransmission on duplicate ACKs
+ *
+ * Return:
+ *   None
+ *
+ * Assumptions:
+ *   Called from the interrupt level or with interrupts disabled.
+ *
+ ****************************************************************************/
+
+void uip_tcpretransmit(struct uip_driver_s *dev, struct uip_conn *conn,
+                       bool fast)
+{
+  uint16_t result;
+#if CONFIG_NET_TCP_SENDQSIZE > 0
+  uint16_t sent = conn->sent;
+#endif
+
+  /* Go back to the oldest unacknowledged byte.  The round trip of a
+   * retransmitted segment is not timed because there is no way to tell
+   * which transmission an ACK is for (Karn's algorithm).
+   */
+
+  conn->sent = 0;
+  conn->rtt  = 0;
+
+#ifdef CONFIG_NET_STATISTICS
+  if (fast)
+    {
+      uip_stat.tcp.rexmit++;
+    }
+#endif
+
+  /* Call upon the application so that it may prepare the data for the
+   * retransmission (unless the data comes from the send queue) and then
+   * send it.
+   */
+
+  dev->d_sndlen = 0;
+  result = uip_tcpcallback(dev, conn, UIP_REXMIT);
+  uip_tcprexmit(dev, conn, result);
+
+#if CONFIG_NET_TCP_SENDQSIZE > 0
+  if (fast && conn->sndq && sent > conn->sent)
+    {
+      conn->sent = sent;
+    }
+#endif
+}
+
+/****************************************************************************
+ * Name: uip_tcpwndavail
+ *
+ * Description:
+ *   Return the number of bytes of new data that may be sent now in one
+ *   segment.  This is limited by the MSS and by the window advertised by
+ *   the peer.  If the peer has closed its window and nothing is
+ *   outstanding, one segment may be sent anyway.  That segment will be
+ *   retransmitted until the peer opens its window again (persist timer).
+ *
+ * Parameters:
+ *   conn   - The TCP connection structure holding connection information
+ *
+ * Return:
+ *   The number of bytes that may be sent (may be zero).
+ *
+ * Assumptions:
+ *   Called from the interrupt level or with interrupts disabled.
+ *
+ ****************************************************************************/
+
+uint16_t uip_tcpwndavail(FAR struct uip_conn *conn)
+{
+  uip_tcpwnd_t avail;
+
+  if (conn->sndwnd > conn->sent)
+    {
+      avail = conn->sndwnd - conn->sent;
+    }
+  else if (conn->unacked == 0)
+    {
+      avail = conn->mss;
+    }
+  else
+    {
+      avail = 0;
+    }
+
+  /* The (possibly scaled) window is clamped to one segment before it is
+   * narrowed to 16 bits.
+   */
+
+  return avail > conn->mss ? conn->mss : (uint16_t)avail;
+}
 #endif /* CONFIG_NET && CONFIG_NET_TCP */
@@ -41,6 +41,7 @@
 #if defined(CONFIG_NET) && defined(CONFIG_NET_TCP)
 
 #include <stdint.h>
+#include <stdbool.h>
 #include <string.h>
 #include <debug.h>
 
@@ -98,6 +99,84 @@ static int uip_readahead(struct uip_readahead_s *readahead, uint8_t *buf,
 }
 #endif
 
+/****************************************************************************
+ * Function: uip_bufferdata
+ *
+ * Description:
+ *   Buffer the new data in the read-ahead buffers of the connection.  We
+ *   will use any remaining space in the last allocated read-ahead buffer
+ *   plus as much one additional buffer.  It is expected that the size of
+ *   read-ahead buffers are tuned so that one full packet will always fit
+ *   into one read-ahead buffer (for example if the buffer size is 420, then
+ *   a read-ahead buffer of 366 will hold a full packet of TCP data).
+ *
+ * Returned Value:
+ *   true if the data was buffered; false if there was no space to buffer
+ *   the data.
+ *
+ * Assumptions:
+ *   This function is called at the interrupt level with interrupts disabled.
+ *   The read-ahead buffers are also accessed by recv() so the connection
+ *   lock is held while they are modified.
+ *
+ ****************************************************************************/
+
+#if CONFIG_NET_NTCP_READAHEAD_BUFFERS > 0
+static bool uip_bufferdata(FAR struct uip_conn *conn, FAR uint8_t *buf,
+                           int buflen)
+{
+  FAR struct uip_readahead_s *readahead1;
+  FAR struct uip_readahead_s *readahead2 = NULL;
+  uip_lock_t flags;
+  uint16_t recvlen;
+
+  /* First, we need to determine if we have space to buffer the data.  This
+   * needs to be verified before we actually begin buffering the data.
+   */
+
+  flags      = uip_connlock(conn);
+  readahead1 = (FAR struct uip_readahead_s*)conn->readahead.tail;
+  if ((!readahead1 ||
+      (CONFIG_NET_TCP_READAHEAD_BUFSIZE - readahead1->rh_nbytes) <= buflen) &&
+      (readahead2 = uip_tcpreadaheadalloc()) == NULL)
+    {
+      uip_connunlock(conn, flags);
+      return false;
+    }
+
+  /* We have buffer space.  Now try to append add as much data as possible
+   * to the last readahead buffer attached to this connection.
+   */
+
+  if (readahead1)
+    {
+      recvlen = uip_readahead(readahead1, buf, buflen);
+      if (recvlen > 0)
+        {
+          buf    += recvlen;
+          buflen -= recvlen;
+        }
+    }
+
+  /* Do we need to buffer into the newly allocated buffer as well? */
+
+  if (readahead2)
+    {
+      readahead2->rh_nbytes = 0;
+      (void)uip_readahead(readahead2, buf, buflen);
+
+      /* Save the readahead buffer in the connection structure where
+       * it can be found with recv() is called.
+       */
+
+      sq_addlast(&readahead2->rh_node, &conn->readahead);
+    }
+
+  uip_connunlock(conn, flags);
+  return true;
+}
+#endif
+
 /****************************************************************************
  * Function: uip_dataevent
  *
@@ -129,59 +208,13 @@ uip_dataevent(struct uip_driver_s *dev, struct uip_conn *conn, uint16_t flags)
 
   if (dev->d_len > 0)
     {
-#if CONFIG_NET_NTCP_READAHEAD_BUFFERS > 0
-      struct uip_readahead_s *readahead1;
-      struct uip_readahead_s *readahead2 = NULL;
-      uint16_t recvlen = 0;
-      uint8_t *buf     = dev->d_appdata;
-      int    buflen    = dev->d_len;
-#endif
-
       nllvdbg("No listener on connection\n");
 
 #if CONFIG_NET_NTCP_READAHEAD_BUFFERS > 0
-      /* First, we need to determine if we have space to buffer the data.  This
-       * needs to be verified before we actually begin buffering the data. We
-       * will use any remaining space in the last allocated readahead buffer
-       * plus as much one additional buffer.  It is expected that the size of
-       * readahead buffers are tuned so that one full packet will always fit
-       * into one readahead buffer (for example if the buffer size is 420, then
-       * a readahead buffer of 366 will hold a full packet of TCP data).
-       */
+      /* Try to buffer the data in the connection's read-ahead buffers */
 
-      readahead1 = (struct uip_readahead_s*)conn->readahead.tail;
-      if ((readahead1 &&
-          (CONFIG_NET_TCP_READAHEAD_BUFSIZE - readahead1->rh_nbytes) > buflen) ||
-          (readahead2 = uip_tcpreadaheadalloc()) != NULL)
+      if (uip_bufferdata(conn, dev->d_appdata, dev->d_len))
         {
-          /* We have buffer space.  Now try to append add as much data as possible
-           * to the last readahead buffer attached to this connection.
-           */
-
-          if (readahead1)
-            {
-              recvlen = uip_readahead(readahead1, buf, buflen);
-              if (recvlen > 0)
-                {
-                  buf    += recvlen;
-                  buflen -= recvlen;
-                }
-            }
-
-          /* Do we need to buffer into the newly allocated buffer as well? */
-
-          if (readahead2)
-            {
-              readahead2->rh_nbytes = 0;
-              (void)uip_readahead(readahead2, buf, buflen);
-
-              /* Save the readahead buffer in the connection structure where
-               * it can be found with recv() is called.
-               */
-
-              sq_addlast(&readahead2->rh_node, &conn->readahead);
-            }
-
           nllvdbg("Buffered %d bytes\n", dev->d_len);
         }
       else
@@ -197,13 +230,17 @@ uip_dataevent(struct uip_driver_s *dev, struct uip_conn *conn, uint16_t flags)
           uip_stat.tcp.syndrop++;
           uip_stat.tcp.drop++;
 #endif
-          /* Clear the UIP_SNDACK bit so that no ACK will be sent */
+          /* Clear the UIP_SNDACK bit so that no ACK will be sent.  The
+           * dropped data is left in dev->d_len so that the TCP input logic
+           * knows that it was not accepted.
+           */
 
           ret &= ~UIP_SNDACK;
+          return ret;
         }
     }
 
-  /* In any event, the new data has now been handled */
+  /* The new data has now been handled */
 
   dev->d_len = 0;
   return ret;
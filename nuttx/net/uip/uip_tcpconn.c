@@ -58,6 +58,7 @@
 #include <net/uip/uipopt.h>
 #include <net/uip/uip.h>
 #include <net/uip/uip-arch.h>
+#include <nuttx/mempool.h>
 
 #include "uip_internal.h"
 
@@ -73,14 +74,28 @@
 
 static struct uip_conn g_tcp_connections[CONFIG_NET_TCP_CONNS];
 
-/* A list of all free TCP connections */
+/* The pool of free TCP connections */
 
-static dq_queue_t g_free_tcp_connections;
+static struct mempool_s g_free_tcp_connections;
 
 /* A list of all connected TCP connections */
 
 static dq_queue_t g_active_tcp_connections;
 
+/* The connected TCP connections are also kept in a hash table keyed on the
+ * local port, the remote port and the remote IP address so that received
+ * segments can be matched without walking the whole active list.
+ */
+
+static struct uip_conn *g_tcp_hash[CONFIG_NET_TCP_NHASH];
+
+/* Every connection that holds a local port number is kept in a hash table
+ * keyed on the local port.  This is used to find out if a port number is in
+ * use.
+ */
+
+static struct uip_conn *g_tcp_porthash[CONFIG_NET_TCP_NHASH];
+
 /* Last port used by a TCP connection connection. */
 
 static uint16_t g_last_tcp_port;
@@ -89,6 +104,106 @@ static uint16_t g_last_tcp_port;
  * Private Functions
  ****************************************************************************/
 
+/****************************************************************************
+ * Name: uip_tcphash()
+ *
+ * Description:
+ *   Return the index of the bucket in g_tcp_hash[] for the connection with
+ *   this local port, remote port and remote address.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_NET_IPv6
+#  define uip_tcphash(lport,rport,addr) \
+     uip_porthash((lport) ^ (rport), CONFIG_NET_TCP_NHASH)
+#else
+static inline unsigned int uip_tcphash(uint16_t lport, uint16_t rport,
+                                       in_addr_t addr)
+{
+  uint32_t hash = addr ^ ((uint32_t)lport << 16) ^ rport;
+
+  hash ^= hash >> 16;
+  hash ^= hash >> 8;
+  return hash & (CONFIG_NET_TCP_NHASH - 1);
+}
+#endif
+
+/****************************************************************************
+ * Name: uip_tcphashadd() and uip_tcphashrem()
+ *
+ * Description:
+ *   Add a connection to or remove a connection from the list of active
+ *   connections and the hash table of active connections.
+ *
+ * Assumptions:
+ *   Interrupts are disabled
+ *
+ ****************************************************************************/
+
+static void uip_tcphashadd(struct uip_conn *conn)
+{
+  unsigned int ndx = uip_tcphash(conn->lport, conn->rport, conn->ripaddr);
+
+  dq_addlast(&conn->node, &g_active_tcp_connections);
+  conn->hflink    = g_tcp_hash[ndx];
+  g_tcp_hash[ndx] = conn;
+}
+
+static void uip_tcphashrem(struct uip_conn *conn)
+{
+  unsigned int ndx = uip_tcphash(conn->lport, conn->rport, conn->ripaddr);
+  struct uip_conn **pprev;
+
+  dq_rem(&conn->node, &g_active_tcp_connections);
+  for (pprev = &g_tcp_hash[ndx]; *pprev; pprev = &(*pprev)->hflink)
+    {
+      if (*pprev == conn)
+        {
+          *pprev = conn->hflink;
+          break;
+        }
+    }
+}
+
+/****************************************************************************
+ * Name: uip_tcpsetport()
+ *
+ * Description:
+ *   Assign a local port number (in network byte order) to a connection and
+ *   keep the local port hash table up to date.  A port number of zero
+ *   removes the connection from the table.
+ *
+ * Assumptions:
+ *   Interrupts are disabled
+ *
+ ****************************************************************************/
+
+static void uip_tcpsetport(struct uip_conn *conn, uint16_t portno)
+{
+  struct uip_conn **pprev;
+
+  if (conn->lport != 0)
+    {
+      pprev = &g_tcp_porthash[uip_porthash(conn->lport, CONFIG_NET_TCP_NHASH)];
+      for (; *pprev; pprev = &(*pprev)->pflink)
+        {
+          if (*pprev == conn)
+            {
+              *pprev = conn->pflink;
+              break;
+            }
+        }
+    }
+
+  conn->lport = portno;
+  if (portno != 0)
+    {
+      pprev        = &g_tcp_porthash[uip_porthash(portno, CONFIG_NET_TCP_NHASH)];
+      conn->pflink = *pprev;
+      *pprev       = conn;
+    }
+}
+
 /****************************************************************************
  * Name: uip_selectport()
  *
@@ -176,21 +291,32 @@ void uip_tcpinit(void)
 {
   int i;
 
-  /* Initialize the queues */
+  /* Initialize the list of active connections */
 
-  dq_init(&g_free_tcp_connections);
   dq_init(&g_active_tcp_connections);
 
-  /* Now initialize each connection structure */
+  for (i = 0; i < CONFIG_NET_TCP_NHASH; i++)
+    {
+      g_tcp_hash[i]     = NULL;
+      g_tcp_porthash[i] = NULL;
+    }
+
+  /* Now mark each connection closed and put all of them in the pool of
+   * free connections.
+   */
 
   for (i = 0; i < CONFIG_NET_TCP_CONNS; i++)
     {
-      /* Mark the connection closed and move it to the free list */
-
       g_tcp_connections[i].tcpstateflags = UIP_CLOSED;
-      dq_addlast(&g_tcp_connections[i].node, &g_free_tcp_connections);
+      g_tcp_connections[i].lport         = 0;
+#ifdef CONFIG_NET_NOINTS
+      uip_mutexinit(&g_tcp_connections[i].lock, UIP_LOCKSTAT(conn));
+#endif
     }
 
+  (void)mempool_create(&g_free_tcp_connections, "tcpconn", g_tcp_connections,
+                       sizeof(struct uip_conn), CONFIG_NET_TCP_CONNS, 0);
+
   g_last_tcp_port = 1024;
 }
 
@@ -217,9 +343,9 @@ struct uip_conn *uip_tcpalloc(void)
 
   flags = uip_lock();
 
-  /* Return the entry from the head of the free list */
+  /* Take a free connection from the pool */
 
-  conn = (struct uip_conn *)dq_remfirst(&g_free_tcp_connections);
+  conn = (struct uip_conn *)mempool_alloc(&g_free_tcp_connections);
 
 #if 0 /* Revisit */
   /* Is the free list empty? */
@@ -302,9 +428,13 @@ void uip_tcpfree(struct uip_conn *conn)
     {
       /* Remove the connection from the active list */
 
-      dq_rem(&conn->node, &g_active_tcp_connections);
+      uip_tcphashrem(conn);
     }
 
+  /* Release the local port number */
+
+  uip_tcpsetport(conn, 0);
+
   /* Release any read-ahead buffers attached to the connection */
 
 #if CONFIG_NET_NTCP_READAHEAD_BUFFERS > 0
@@ -314,6 +444,12 @@ void uip_tcpfree(struct uip_conn *conn)
     }
 #endif
 
+  /* Discard any data that was never sent or acknowledged */
+
+#if CONFIG_NET_TCP_SENDQSIZE > 0
+  uip_tcpsendqfree(conn);
+#endif
+
   /* Remove any backlog attached to this connection */
 
 #ifdef CONFIG_NET_TCPBACKLOG
@@ -332,10 +468,10 @@ void uip_tcpfree(struct uip_conn *conn)
     }
 #endif
 
-  /* Mark the connection available and put it into the free list */
+  /* Mark the connection available and put it back into the pool */
 
   conn->tcpstateflags = UIP_CLOSED;
-  dq_addlast(&conn->node, &g_free_tcp_connections);
+  mempool_free(&g_free_tcp_connections, conn);
   uip_unlock(flags);
 }
 
@@ -353,9 +489,10 @@ void uip_tcpfree(struct uip_conn *conn)
 
 struct uip_conn *uip_tcpactive(struct uip_tcpip_hdr *buf)
 {
-  struct uip_conn *conn      = (struct uip_conn *)g_active_tcp_connections.head;
-  in_addr_t        srcipaddr = uip_ip4addr_conv(buf->srcipaddr);  
+  in_addr_t        srcipaddr = uip_ip4addr_conv(buf->srcipaddr);
+  struct uip_conn *conn;
 
+  conn = g_tcp_hash[uip_tcphash(buf->destport, buf->srcport, srcipaddr)];
   while (conn)
     {
       /* Find an open connection matching the tcp input */
@@ -371,9 +508,9 @@ struct uip_conn *uip_tcpactive(struct uip_tcpip_hdr *buf)
           break;
         }
 
-      /* Look at the next active connection */
+      /* Look at the next active connection with the same hash */
 
-      conn = (struct uip_conn *)conn->node.flink;
+      conn = conn->hflink;
     }
 
   return conn;
@@ -418,13 +555,12 @@ struct uip_conn *uip_nexttcpconn(struct uip_conn *conn)
 struct uip_conn *uip_tcplistener(uint16_t portno)
 {
   struct uip_conn *conn;
-  int i;
 
   /* Check if this port number is in use by any active UIP TCP connection */
- 
-  for (i = 0; i < CONFIG_NET_TCP_CONNS; i++)
+
+  conn = g_tcp_porthash[uip_porthash(portno, CONFIG_NET_TCP_NHASH)];
+  for (; conn; conn = conn->pflink)
     {
-      conn = &g_tcp_connections[i];
       if (conn->tcpstateflags != UIP_CLOSED && conn->lport == portno)
         {
           /* The portnumber is in use, return the connection */
@@ -460,13 +596,30 @@ struct uip_conn *uip_tcpaccept(struct uip_tcpip_hdr *buf)
       conn->sa            = 0;
       conn->sv            = 4;
       conn->nrtx          = 0;
-      conn->lport         = buf->destport;
+      conn->rtt           = 0;
+      conn->dupacks       = 0;
       conn->rport         = buf->srcport;
       uip_ipaddr_copy(conn->ripaddr, uip_ip4addr_conv(buf->srcipaddr));
       conn->tcpstateflags = UIP_SYN_RCVD;
 
+      conn->initialmss    = conn->mss = UIP_TCP_MSS;
+      conn->sndwnd        = ((uint16_t)buf->wnd[0] << 8) + (uint16_t)buf->wnd[1];
+      conn->rcvwnd        = 0;
+      conn->ackflags      = 0;
+#ifdef CONFIG_NET_TCP_WINDOW_SCALE
+      conn->sndscale      = 0;
+      conn->rcvscale      = 0;
+#endif
+#ifdef CONFIG_NET_TCP_DELAYED_ACK
+      conn->rcvunacked    = 0;
+#endif
+
       uip_tcpinitsequence(conn->sndseq);
       conn->unacked       = 1;
+      conn->sent          = 0;
+#if CONFIG_NET_TCP_SENDQSIZE > 0
+      conn->sndq          = NULL;
+#endif
 
       /* rcvseq should be the seqno from the incoming packet + 1. */
 
@@ -482,7 +635,8 @@ struct uip_conn *uip_tcpaccept(struct uip_tcpip_hdr *buf)
        * Interrupts should already be disabled in this context.
        */
 
-      dq_addlast(&conn->node, &g_active_tcp_connections);
+      uip_tcpsetport(conn, buf->destport);
+      uip_tcphashadd(conn);
     }
   return conn;
 }
@@ -511,10 +665,19 @@ int uip_tcpbind(struct uip_conn *conn, const struct sockaddr_in *addr)
   uip_lock_t flags;
   int port;
 
-  /* Verify or select a local port */
+  /* Verify or select a local port and save it in the connection structure.
+   * Note that the requested local IP address is not saved.  At present,
+   * only a single network interface is supported, the IP address is not of
+   * importance.
+   */
 
   flags = uip_lock();
   port = uip_selectport(ntohs(addr->sin_port));
+  if (port >= 0)
+    {
+      uip_tcpsetport(conn, htons((uint16_t)port));
+    }
+
   uip_unlock(flags);
 
   if (port < 0)
@@ -522,13 +685,6 @@ int uip_tcpbind(struct uip_conn *conn, const struct sockaddr_in *addr)
       return port;
     }
 
-  /* Save the local address in the connection structure.  Note that the requested
-   * local IP address is saved but not used.  At present, only a single network
-   * interface is supported, the IP address is not of importance.
-   */
-
-  conn->lport = addr->sin_port;
-
 #if 0 /* Not used */
 #ifdef CONFIG_NET_IPv6
   uip_ipaddr_copy(conn->lipaddr, addr->sin6_addr.in6_u.u6_addr16);
@@ -585,6 +741,11 @@ int uip_tcpconnect(struct uip_conn *conn, const struct sockaddr_in *addr)
 
   flags = uip_lock();
   port = uip_selectport(ntohs(conn->lport));
+  if (port >= 0)
+    {
+      uip_tcpsetport(conn, htons((uint16_t)port));
+    }
+
   uip_unlock(flags);
 
   if (port < 0)
@@ -592,19 +753,34 @@ int uip_tcpconnect(struct uip_conn *conn, const struct sockaddr_in *addr)
       return port;
     }
 
-  /* Initialize and return the connection structure, bind it to the port number */
+  /* Initialize and return the connection structure */
 
   conn->tcpstateflags = UIP_SYN_SENT;
   uip_tcpinitsequence(conn->sndseq);
 
   conn->initialmss = conn->mss = UIP_TCP_MSS;
   conn->unacked    = 1;    /* TCP length of the SYN is one. */
+  conn->sent       = 0;
+  conn->sndwnd     = 0;
+  conn->rcvwnd     = 0;
+  conn->ackflags   = 0;
+#ifdef CONFIG_NET_TCP_WINDOW_SCALE
+  conn->sndscale   = 0;
+  conn->rcvscale   = 0;
+#endif
+#ifdef CONFIG_NET_TCP_DELAYED_ACK
+  conn->rcvunacked = 0;
+#endif
   conn->nrtx       = 0;
   conn->timer      = 1;    /* Send the SYN next time around. */
   conn->rto        = UIP_RTO;
   conn->sa         = 0;
   conn->sv         = 16;   /* Initial value of the RTT variance. */
-  conn->lport      = htons((uint16_t)port);
+  conn->rtt        = 0;
+  conn->dupacks    = 0;
+#if CONFIG_NET_TCP_SENDQSIZE > 0
+  conn->sndq       = NULL;
+#endif
 
   /* The sockaddr port is 16 bits and already in network order */
 
@@ -627,7 +803,7 @@ int uip_tcpconnect(struct uip_conn *conn, const struct sockaddr_in *addr)
    */
 
   flags = uip_lock();
-  dq_addlast(&conn->node, &g_active_tcp_connections);
+  uip_tcphashadd(conn);
   uip_unlock(flags);
 
   return OK;
@@ -52,6 +52,7 @@
 #include <net/uip/uipopt.h>
 #include <net/uip/uip.h>
 #include <net/uip/uip-arch.h>
+#include <net/uip/uip-iob.h>
 
 #include "uip_internal.h"
 
@@ -73,6 +74,89 @@
  * Private Functions
  ****************************************************************************/
 
+/****************************************************************************
+ * Name: uip_tcpoptions
+ *
+ * Description:
+ *   Parse the TCP options of a received SYN or SYNACK.  The MSS option
+ *   sets the maximum segment size of the connection and the window scale
+ *   option is remembered so that window scaling can be enabled.
+ *
+ * Parameters:
+ *   dev  - The device driver structure containing the received TCP packet.
+ *   conn - The TCP connection structure holding connection information
+ *
+ * Return:
+ *   None
+ *
+ * Assumptions:
+ *   Called from the interrupt level or with interrupts disabled.
+ *
+ ****************************************************************************/
+
+static void uip_tcpoptions(struct uip_driver_s *dev, struct uip_conn *conn)
+{
+  struct uip_tcpip_hdr *pbuf = BUF;
+  FAR uint8_t *optdata = &dev->d_buf[UIP_TCPIP_HLEN + UIP_LLH_LEN];
+  uint16_t tmp16;
+  uint8_t  opt;
+  int      optlen;
+  int      i;
+
+  optlen = ((pbuf->tcpoffset >> 4) - 5) << 2;
+  for (i = 0; i < optlen; )
+    {
+      opt = optdata[i];
+      if (opt == TCP_OPT_END)
+        {
+          /* End of options. */
+
+          break;
+        }
+      else if (opt == TCP_OPT_NOOP)
+        {
+          /* NOP option. */
+
+          ++i;
+          continue;
+        }
+      else if (opt == TCP_OPT_MSS && optdata[1 + i] == TCP_OPT_MSS_LEN)
+        {
+          /* An MSS option with the right option length. */
+
+          tmp16 = ((uint16_t)optdata[2 + i] << 8) | (uint16_t)optdata[3 + i];
+          conn->initialmss = conn->mss =
+                  tmp16 > UIP_TCP_MSS? UIP_TCP_MSS: tmp16;
+        }
+#ifdef CONFIG_NET_TCP_WINDOW_SCALE
+      else if (opt == TCP_OPT_WS && optdata[1 + i] == TCP_OPT_WS_LEN)
+        {
+          /* A window scale option with the right option length.  The
+           * largest shift allowed is 14.
+           */
+
+          conn->ackflags |= UIP_WSOPT;
+          conn->sndscale  = optdata[2 + i] > 14 ? 14 : optdata[2 + i];
+        }
+#endif
+
+      /* All other options have a length field, so that we easily can skip
+       * past them.
+       */
+
+      if (optdata[1 + i] == 0)
+        {
+          /* If the length field is zero, the options are malformed and we
+           * don't process them further.
+           */
+
+          break;
+        }
+
+      i += optdata[1 + i];
+    }
+}
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -98,12 +182,11 @@ void uip_tcpinput(struct uip_driver_s *dev)
 {
   struct uip_conn *conn = NULL;
   struct uip_tcpip_hdr *pbuf = BUF;
+  uip_tcpwnd_t wnd;
   uint16_t tmp16;
   uint16_t flags;
-  uint8_t  opt;
   uint8_t  result;
   int      len;
-  int      i;
 
   dev->d_snddata = &dev->d_buf[UIP_IPTCPH_LEN + UIP_LLH_LEN];
   dev->d_appdata = &dev->d_buf[UIP_IPTCPH_LEN + UIP_LLH_LEN];
@@ -210,57 +293,17 @@ void uip_tcpinput(struct uip_driver_s *dev)
 
           uip_incr32(conn->rcvseq, 1);
 
-          /* Parse the TCP MSS option, if present. */
+          /* Parse the TCP MSS and window scale options, if present.  Window
+           * scaling is used only if the peer offered it.
+           */
 
-          if ((pbuf->tcpoffset & 0xf0) > 0x50)
+          uip_tcpoptions(dev, conn);
+#ifdef CONFIG_NET_TCP_WINDOW_SCALE
+          if ((conn->ackflags & UIP_WSOPT) != 0)
             {
-              for (i = 0; i < ((pbuf->tcpoffset >> 4) - 5) << 2 ;)
-                {
-                  opt = dev->d_buf[UIP_TCPIP_HLEN + UIP_LLH_LEN + i];
-                  if (opt == TCP_OPT_END)
-                    {
-                      /* End of options. */
-
-                      break;
-                    }
-                  else if (opt == TCP_OPT_NOOP)
-                    {
-                      /* NOP option. */
-
-                      ++i;
-                    }
-                  else if (opt == TCP_OPT_MSS &&
-                          dev->d_buf[UIP_TCPIP_HLEN + UIP_LLH_LEN + 1 + i] == TCP_OPT_MSS_LEN)
-                    {
-                      /* An MSS option with the right option length. */
-
-                      tmp16 = ((uint16_t)dev->d_buf[UIP_TCPIP_HLEN + UIP_LLH_LEN + 2 + i] << 8) |
-                               (uint16_t)dev->d_buf[UIP_IPTCPH_LEN + UIP_LLH_LEN + 3 + i];
-                      conn->initialmss = conn->mss =
-                              tmp16 > UIP_TCP_MSS? UIP_TCP_MSS: tmp16;
-
-                      /* And we are done processing options. */
-
-                      break;
-                    }
-                  else
-                    {
-                      /* All other options have a length field, so that we easily
-                       * can skip past them.
-                       */
-
-                      if (dev->d_buf[UIP_TCPIP_HLEN + UIP_LLH_LEN + 1 + i] == 0)
-                        {
-                          /* If the length field is zero, the options are malformed
-                           * and we don't process them further.
-                           */
-
-                          break;
-                        }
-                      i += dev->d_buf[UIP_TCPIP_HLEN + UIP_LLH_LEN + 1 + i];
-                    }
-                }
+              conn->rcvscale = UIP_RCVWND_SHIFT;
             }
+#endif
 
           /* Our response will be a SYNACK. */
 
@@ -340,6 +383,18 @@ found:
         }
     }
 
+  /* Get the receive window advertised by the peer.  The window in a SYN
+   * segment is never scaled.
+   */
+
+  wnd = ((uint16_t)pbuf->wnd[0] << 8) + (uint16_t)pbuf->wnd[1];
+#ifdef CONFIG_NET_TCP_WINDOW_SCALE
+  if ((pbuf->flags & TCP_SYN) == 0)
+    {
+      wnd <<= conn->sndscale;
+    }
+#endif
+
   /* Next, check if the incoming segment acknowledges any outstanding
    * data. If so, we update the sequence number, reset the length of
    * the outstanding data, calculate RTT estimations, and reset the
@@ -348,84 +403,97 @@ found:
 
   if ((pbuf->flags & TCP_ACK) != 0 && conn->unacked > 0)
     {
-      uint32_t unackseq;
       uint32_t ackseq;
+      uint32_t acked;
 
-      /* The next sequence number is equal to the current sequence
-       * number (sndseq) plus the size of the oustanding, unacknowledged
-       * data (unacked).
-       */
-
-      unackseq = uip_tcpaddsequence(conn->sndseq, conn->unacked);
-
-      /* Get the sequence number of that has just been acknowledged by this
-       * incoming packet.
+      /* The ACK is cumulative:  Everything before the acknowledged sequence
+       * number has been received by the peer.  Get the number of bytes
+       * newly acknowledged by this incoming packet.
        */
 
       ackseq = uip_tcpgetsequence(pbuf->ackno);
+      acked  = ackseq - uip_tcpgetsequence(conn->sndseq);
 
-      /* Check how many of the outstanding bytes have been acknowledged. For
-       * a most uIP send operation, this should always be true.  However,
-       * the send() API sends data ahead when it can without waiting for
-       * the ACK.  In this case, the 'ackseq' could be less than then the
-       * new sequence number.
-       */
-
-      if (ackseq <= unackseq)
-        {
-          /* Calculate the new number of oustanding, unacknowledged bytes */
-
-          conn->unacked = unackseq - ackseq;
-        }
-      else
+      if (acked > 0 && acked <= conn->unacked)
         {
-          /* What would it mean if ackseq > unackseq?  The peer has ACKed
-           * more bytes than we think we have sent?  Someone has lost it.
-           * Complain and reset the number of outstanding, unackowledged
-           * bytes
+          /* Remove the acknowledged data from the send queue and update
+           * the oldest unacknowledged sequence number.
            */
 
-          nlldbg("ERROR: ackseq[%08x] > unackseq[%08x]\n", ackseq, unackseq);
-          conn->unacked = 0;
-        }
+#if CONFIG_NET_TCP_SENDQSIZE > 0
+          uip_tcpsendqack(conn, acked);
+#endif
+          nllvdbg("sndseq: %08x->%08x unacked: %d acked: %d\n",
+                  uip_tcpgetsequence(conn->sndseq), ackseq, conn->unacked,
+                  acked);
 
-      /* Update sequence number to the unacknowledge sequence number.  If
-       * there is still outstanding, unacknowledged data, then this will
-       * be beyond ackseq.
-       */
+          uip_tcpsetsequence(conn->sndseq, ackseq);
+          conn->unacked -= acked;
+          conn->sent     = conn->sent > acked ? conn->sent - acked : 0;
 
-      nllvdbg("sndseq: %08x->%08x unackseq: %08x new unacked: %d\n",
-              conn->sndseq, ackseq, unackseq, conn->unacked);
-      uip_tcpsetsequence(conn->sndseq, ackseq);
+          /* Do RTT estimation if this ACK completes the segment being
+           * timed.  The timing is cancelled on retransmissions.
+           */
 
-      /* Do RTT estimation, unless we have done retransmissions. */
+          if (conn->rtt > 0 &&
+              (int32_t)(ackseq - uip_tcpgetsequence(conn->rttseq)) >= 0)
+            {
+              signed char m;
+              m = conn->rtt - 1;
 
-      if (conn->nrtx == 0)
-        {
-          signed char m;
-          m = conn->rto - conn->timer;
+              /* This is taken directly from VJs original code in his paper */
 
-          /* This is taken directly from VJs original code in his paper */
+              m = m - (conn->sa >> 3);
+              conn->sa += m;
+              if (m < 0)
+                {
+                  m = -m;
+                }
 
-          m = m - (conn->sa >> 3);
-          conn->sa += m;
-          if (m < 0)
-            {
-              m = -m;
+              m = m - (conn->sv >> 2);
+              conn->sv += m;
+              conn->rto = (conn->sa >> 3) + conn->sv;
+
+              if (conn->rto < UIP_RTO_MIN)
+                {
+                  conn->rto = UIP_RTO_MIN;
+                }
+              else if (conn->rto > UIP_RTO_MAX)
+                {
+                  conn->rto = UIP_RTO_MAX;
+                }
+
+              conn->rtt = 0;
             }
 
-          m = m - (conn->sv >> 2);
-          conn->sv += m;
-          conn->rto = (conn->sa >> 3) + conn->sv;
+          /* Set the acknowledged flag. */
+
+          flags |= UIP_ACKDATA;
+
+          /* Reset the retransmission timer and count. */
+
+          conn->timer   = conn->rto;
+          conn->nrtx    = 0;
+          conn->dupacks = 0;
         }
 
-        /* Set the acknowledged flag. */
+      /* A duplicate ACK (one that acknowledges nothing new, carries no data
+       * and does not change the window) suggests that the peer is receiving
+       * segments after a lost one.
+       */
 
-       flags |= UIP_ACKDATA;
+      else if (acked == 0 && dev->d_len == 0 &&
+               (pbuf->flags & (TCP_SYN | TCP_FIN)) == 0 && wnd == conn->sndwnd)
+        {
+          conn->dupacks++;
+        }
+    }
 
-       /* Reset the retransmission timer. */
+  /* Update the window advertised by the peer */
 
-       conn->timer = conn->rto;
+  if ((pbuf->flags & TCP_ACK) != 0)
+    {
+      conn->sndwnd = wnd;
     }
 
   /* Do different things depending on in what state the connection is. */
@@ -483,59 +551,18 @@ found:
 
         if ((flags & UIP_ACKDATA) != 0 && (pbuf->flags & TCP_CTL) == (TCP_SYN | TCP_ACK))
           {
-            /* Parse the TCP MSS option, if present. */
-
-            if ((pbuf->tcpoffset & 0xf0) > 0x50)
+            /* Parse the TCP MSS and window scale options, if present.  We
+             * offered window scaling in our SYN; it is used only if the
+             * peer included the window scale option in its SYNACK.
+             */
+
+            uip_tcpoptions(dev, conn);
+#ifdef CONFIG_NET_TCP_WINDOW_SCALE
+            if ((conn->ackflags & UIP_WSOPT) != 0)
               {
-                for (i = 0; i < ((pbuf->tcpoffset >> 4) - 5) << 2 ;)
-                  {
-                    opt = dev->d_buf[UIP_IPTCPH_LEN + UIP_LLH_LEN + i];
-                    if (opt == TCP_OPT_END)
-                      {
-                        /* End of options. */
-
-                        break;
-                      }
-                    else if (opt == TCP_OPT_NOOP)
-                      {
-                        /* NOP option. */
-
-                        ++i;
-                      }
-                    else if (opt == TCP_OPT_MSS &&
-                              dev->d_buf[UIP_TCPIP_HLEN + UIP_LLH_LEN + 1 + i] == TCP_OPT_MSS_LEN)
-                      {
-                        /* An MSS option with the right option length. */
-
-                        tmp16 =
-                          (dev->d_buf[UIP_TCPIP_HLEN + UIP_LLH_LEN + 2 + i] << 8) |
-                          dev->d_buf[UIP_TCPIP_HLEN + UIP_LLH_LEN + 3 + i];
-                        conn->initialmss =
-                          conn->mss =
-                          tmp16 > UIP_TCP_MSS? UIP_TCP_MSS: tmp16;
-
-                        /* And we are done processing options. */
-
-                        break;
-                      }
-                    else
-                      {
-                        /* All other options have a length field, so that we
-                         * easily can skip past them.
-                         */
-
-                        if (dev->d_buf[UIP_TCPIP_HLEN + UIP_LLH_LEN + 1 + i] == 0)
-                          {
-                            /* If the length field is zero, the options are
-                             * malformed and we don't process them further.
-                             */
-
-                            break;
-                          }
-                        i += dev->d_buf[UIP_TCPIP_HLEN + UIP_LLH_LEN + 1 + i];
-                      }
-                  }
+                conn->rcvscale = UIP_RCVWND_SHIFT;
               }
+#endif
 
             conn->tcpstateflags = UIP_ESTABLISHED;
             memcpy(conn->rcvseq, pbuf->seqno, 4);
@@ -583,7 +610,7 @@ found:
 
         if ((pbuf->flags & TCP_FIN) != 0 && (conn->tcpstateflags & UIP_STOPPED) == 0)
           {
-            if (conn->unacked > 0)
+            if (conn->unacked > 0 || uip_tcpsendqlen(conn) > 0)
               {
                 goto drop;
               }
@@ -664,12 +691,28 @@ found:
          * "persistent timer" and uses the retransmission mechanim.
          */
 
-        tmp16 = ((uint16_t)pbuf->wnd[0] << 8) + (uint16_t)pbuf->wnd[1];
-        if (tmp16 > conn->initialmss || tmp16 == 0)
+        if (wnd > conn->initialmss || wnd == 0)
+          {
+            conn->mss = conn->initialmss;
+          }
+        else
           {
-            tmp16 = conn->initialmss;
+            conn->mss = wnd;
+          }
+
+        /* After UIP_FASTREXMIT_NDUPACKS duplicate ACKs, retransmit the
+         * oldest unacknowledged segment without waiting for the
+         * retransmission timer (fast retransmit).
+         */
+
+        if (conn->dupacks == UIP_FASTREXMIT_NDUPACKS)
+          {
+            nllvdbg("Fast retransmit: sndseq %08x\n",
+                    uip_tcpgetsequence(conn->sndseq));
+
+            uip_tcpretransmit(dev, conn, true);
+            return;
           }
-        conn->mss = tmp16;
 
         /* If this packet constitutes an ACK for outstanding data (flagged
          * by the UIP_ACKDATA flag, we should call the application since it
@@ -691,8 +734,49 @@ found:
 
         if ((flags & (UIP_NEWDATA | UIP_ACKDATA)) != 0)
           {
+            len           = dev->d_len;
             dev->d_sndlen = 0;
             result        = uip_tcpcallback(dev, conn, flags);
+
+            if ((flags & UIP_NEWDATA) != 0)
+              {
+                /* Any new data that the application did not consume and
+                 * that could not be buffered is still in dev->d_len.
+                 * Forget that it was received; the peer will send it
+                 * again.  Whatever was accepted is ACKed right away.
+                 */
+
+                if (dev->d_len > 0)
+                  {
+                    uip_tcpsetsequence(conn->rcvseq,
+                                       uip_tcpgetsequence(conn->rcvseq) -
+                                       dev->d_len);
+                    len       -= dev->d_len;
+                    dev->d_len = 0;
+
+                    if (len > 0)
+                      {
+                        result |= UIP_SNDACK;
+                      }
+                  }
+
+#ifdef CONFIG_NET_TCP_DELAYED_ACK
+                /* Otherwise, hold back the ACK if it may be delayed */
+
+                else if ((result & UIP_SNDACK) != 0 &&
+                         uip_tcpdelayack(conn, len))
+                  {
+                    result &= ~UIP_SNDACK;
+                  }
+#endif
+
+                /* The accepted data consumes part of the window that was
+                 * advertised to the peer.
+                 */
+
+                conn->rcvwnd = conn->rcvwnd > len ? conn->rcvwnd - len : 0;
+              }
+
             uip_tcpappsend(dev, conn, result);
             return;
           }
@@ -112,6 +112,15 @@ void uip_tcppoll(struct uip_driver_s *dev, struct uip_conn *conn)
 
       result = uip_tcpcallback(dev, conn, UIP_POLL);
 
+      /* Send a pending window update or delayed ACK now if it is due (this
+       * may be included with any data that the application sends).
+       */
+
+      if (uip_tcpackdue(conn))
+        {
+          result |= UIP_SNDACK;
+        }
+
       /* Handle the callback response */
 
       uip_tcpappsend(dev, conn, result);
@@ -44,6 +44,7 @@
 #include <debug.h>
 
 #include <net/uip/uip.h>
+#include <nuttx/mempool.h>
 
 #include "uip_internal.h"
 
@@ -55,9 +56,9 @@
 
 static struct uip_readahead_s g_buffers[CONFIG_NET_NTCP_READAHEAD_BUFFERS];
 
-/* This is the list of available read-ahead buffers */
+/* This is the pool of available read-ahead buffers */
 
-static sq_queue_t g_freebuffers;
+static struct mempool_s g_freebuffers;
 
 /****************************************************************************
  * Private Functions
@@ -71,7 +72,7 @@ static sq_queue_t g_freebuffers;
  * Function: uip_tcpreadaheadinit
  *
  * Description:
- *   Initialize the list of free read-ahead buffers
+ *   Initialize the pool of free read-ahead buffers
  *
  * Assumptions:
  *   Called once early initialization.
@@ -80,13 +81,9 @@ static sq_queue_t g_freebuffers;
 
 void uip_tcpreadaheadinit(void)
 {
-  int i;
-
-  sq_init(&g_freebuffers);
-  for (i = 0; i < CONFIG_NET_NTCP_READAHEAD_BUFFERS; i++)
-    {
-      sq_addfirst(&g_buffers[i].rh_node, &g_freebuffers);
-    }
+  (void)mempool_create(&g_freebuffers, "readahead", g_buffers,
+                       sizeof(struct uip_readahead_s),
+                       CONFIG_NET_NTCP_READAHEAD_BUFFERS, 0);
 }
 
 /****************************************************************************
@@ -94,7 +91,7 @@ void uip_tcpreadaheadinit(void)
  *
  * Description:
  *   Allocate a TCP read-ahead buffer by taking a pre-allocated buffer from
- *   the free list.  This function is called from TCP logic when new,
+ *   the pool.  This function is called from TCP logic when new,
  *   incoming TCP data is received but there is no user logic recving the
  *   the data.  Note: malloc() cannot be used because this function is
  *   called from interrupt level.
@@ -106,14 +103,14 @@ void uip_tcpreadaheadinit(void)
 
 struct uip_readahead_s *uip_tcpreadaheadalloc(void)
 {
-  return (struct uip_readahead_s*)sq_remfirst(&g_freebuffers);
+  return (struct uip_readahead_s*)mempool_alloc(&g_freebuffers);
 }
 
 /****************************************************************************
  * Function: uip_tcpreadaheadrelease
  *
  * Description:
- *   Release a TCP read-ahead buffer by returning the buffer to the free list.
+ *   Release a TCP read-ahead buffer by returning the buffer to the pool.
  *   This function is called from user logic after it is consumed the buffered
  *   data.
  *
@@ -124,7 +121,23 @@ struct uip_readahead_s *uip_tcpreadaheadalloc(void)
 
 void uip_tcpreadaheadrelease(struct uip_readahead_s *buf)
 {
-  sq_addfirst(&buf->rh_node, &g_freebuffers);
+  mempool_free(&g_freebuffers, buf);
+}
+
+/****************************************************************************
+ * Function: uip_tcpreadaheadnfree
+ *
+ * Description:
+ *   Return the number of TCP read-ahead buffers that are not in use.
+ *
+ * Assumptions:
+ *   Called with interrupts disabled.
+ *
+ ****************************************************************************/
+
+unsigned int uip_tcpreadaheadnfree(void)
+{
+  return g_freebuffers.nfree;
 }
 
 #endif /* CONFIG_NET && CONFIG_NET_TCP && CONFIG_NET_NTCP_READAHEAD_BUFFERS*/
@@ -174,9 +174,14 @@ static void uip_tcpsendcomplete(struct uip_driver_s *dev)
 static void uip_tcpsendcommon(struct uip_driver_s *dev, struct uip_conn *conn)
 {
   struct uip_tcpip_hdr *pbuf = BUF;
+  uint32_t wnd;
+
+  /* Any data in this segment begins 'sent' bytes after the oldest
+   * unacknowledged sequence number.
+   */
 
   memcpy(pbuf->ackno, conn->rcvseq, 4);
-  memcpy(pbuf->seqno, conn->sndseq, 4);
+  uip_tcpsetsequence(pbuf->seqno, uip_tcpaddsequence(conn->sndseq, conn->sent));
 
   pbuf->proto    = UIP_PROTO_TCP;
   pbuf->srcport  = conn->lport;
@@ -185,20 +190,46 @@ static void uip_tcpsendcommon(struct uip_driver_s *dev, struct uip_conn *conn)
   uiphdr_ipaddr_copy(pbuf->srcipaddr, &dev->d_ipaddr);
   uiphdr_ipaddr_copy(pbuf->destipaddr, &conn->ripaddr);
 
-  if (conn->tcpstateflags & UIP_STOPPED)
+  /* Advertise the receive window.  The window in a SYN segment is never
+   * scaled.
+   */
+
+  wnd = uip_tcprcvwnd(conn);
+#ifdef CONFIG_NET_TCP_WINDOW_SCALE
+  if ((pbuf->flags & TCP_SYN) == 0)
     {
-      /* If the connection has issued uip_stop(), we advertise a zero
-       * window so that the remote host will stop sending data.
-       */
+      wnd >>= conn->rcvscale;
+      if (wnd > 0xffff)
+        {
+          wnd = 0xffff;
+        }
 
-      pbuf->wnd[0] = 0;
-      pbuf->wnd[1] = 0;
+      conn->rcvwnd = wnd << conn->rcvscale;
     }
   else
     {
-      pbuf->wnd[0] = ((CONFIG_NET_RECEIVE_WINDOW) >> 8);
-      pbuf->wnd[1] = ((CONFIG_NET_RECEIVE_WINDOW) & 0xff);
+      if (wnd > 0xffff)
+        {
+          wnd = 0xffff;
+        }
+
+      conn->rcvwnd = wnd;
     }
+#else
+  conn->rcvwnd = wnd;
+#endif
+
+  pbuf->wnd[0] = wnd >> 8;
+  pbuf->wnd[1] = wnd & 0xff;
+
+  /* Every segment that we send acknowledges all of the data received so
+   * far.  Nothing remains to be ACKed.
+   */
+
+  conn->ackflags  &= ~UIP_ACKNOW;
+#ifdef CONFIG_NET_TCP_DELAYED_ACK
+  conn->rcvunacked = 0;
+#endif
 
   /* Finish the IP portion of the message, calculate checksums and send
    * the message.
@@ -347,19 +378,39 @@ void uip_tcpreset(struct uip_driver_s *dev)
 void uip_tcpack(struct uip_driver_s *dev, struct uip_conn *conn, uint8_t ack)
 {
   struct uip_tcpip_hdr *pbuf = BUF;
+  uint16_t optlen;
 
   /* Save the ACK bits */
 
   pbuf->flags      = ack;
 
-  /* We send out the TCP Maximum Segment Size option with our ack. */
+  /* We send out the TCP Maximum Segment Size option with our ack (and,
+   * optionally, the window scale option).
+   */
 
   pbuf->optdata[0] = TCP_OPT_MSS;
   pbuf->optdata[1] = TCP_OPT_MSS_LEN;
   pbuf->optdata[2] = (UIP_TCP_MSS) / 256;
   pbuf->optdata[3] = (UIP_TCP_MSS) & 255;
-  dev->d_len       = UIP_IPTCPH_LEN + TCP_OPT_MSS_LEN;
-  pbuf->tcpoffset  = ((UIP_TCPH_LEN + TCP_OPT_MSS_LEN) / 4) << 4;
+  optlen           = TCP_OPT_MSS_LEN;
+
+#ifdef CONFIG_NET_TCP_WINDOW_SCALE
+  /* We offer window scaling in our SYN.  In a SYNACK, we may include the
+   * window scale option only if the peer included it in its SYN.
+   */
+
+  if ((ack & TCP_ACK) == 0 || (conn->ackflags & UIP_WSOPT) != 0)
+    {
+      pbuf->optdata[4] = TCP_OPT_NOOP;
+      pbuf->optdata[5] = TCP_OPT_WS;
+      pbuf->optdata[6] = TCP_OPT_WS_LEN;
+      pbuf->optdata[7] = UIP_RCVWND_SHIFT;
+      optlen          += TCP_OPT_WS_LEN + 1;
+    }
+#endif
+
+  dev->d_len       = UIP_IPTCPH_LEN + optlen;
+  pbuf->tcpoffset  = ((UIP_TCPH_LEN + optlen) / 4) << 4;
 
   /* Complete the common portions of the TCP message */
 
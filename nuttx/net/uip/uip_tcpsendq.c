@@ -0,0 +1,209 @@
+/****************************************************************************
+ * net/uip/uip_tcpsendq.c
+ *
+ *   Copyright (C) 2012 Gregory Nutt. All rights reserved.
+ *   Author: Gregory Nutt <gnutt@nuttx.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name NuttX nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <net/uip/uipopt.h>
+#if defined(CONFIG_NET) && defined(CONFIG_NET_TCP) && CONFIG_NET_TCP_SENDQSIZE > 0
+
+#include <stdint.h>
+#include <debug.h>
+
+#include <net/uip/uip.h>
+#include <net/uip/uip-arch.h>
+#include <net/uip/uip-iob.h>
+
+#include "uip_internal.h"
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Function: uip_tcpsendqadd
+ *
+ * Description:
+ *   Append data to the send queue of a TCP connection.  As much of the data
+ *   is queued as fits within CONFIG_NET_TCP_SENDQSIZE and the available
+ *   I/O buffers.
+ *
+ * Returned Value:
+ *   The number of bytes queued.  Zero if the queue is full or if there are
+ *   no free I/O buffers.
+ *
+ * Assumptions:
+ *   Called from user logic.  The network need not be locked; the send
+ *   queue is protected by the connection lock.
+ *
+ ****************************************************************************/
+
+int uip_tcpsendqadd(FAR struct uip_conn *conn, FAR const uint8_t *buf,
+                    unsigned int len)
+{
+  unsigned int qlen;
+  uip_lock_t flags;
+  int ret = 0;
+
+  flags = uip_connlock(conn);
+  qlen  = uip_tcpsendqlen(conn);
+  if (qlen >= CONFIG_NET_TCP_SENDQSIZE)
+    {
+      goto errout_with_lock;
+    }
+
+  if (len > CONFIG_NET_TCP_SENDQSIZE - qlen)
+    {
+      len = CONFIG_NET_TCP_SENDQSIZE - qlen;
+    }
+
+  if (!conn->sndq)
+    {
+      conn->sndq = uip_ioballoc();
+      if (!conn->sndq)
+        {
+          goto errout_with_lock;
+        }
+    }
+
+  /* Copy the data to the end of the queue.  If the I/O buffers run out,
+   * the data that did fit is kept.
+   */
+
+  (void)uip_iobcopyin(conn->sndq, buf, len, qlen);
+  ret = conn->sndq->io_pktlen - qlen;
+
+errout_with_lock:
+  uip_connunlock(conn, flags);
+  return ret;
+}
+
+/****************************************************************************
+ * Function: uip_tcpsendqcopy
+ *
+ * Description:
+ *   Copy the next segment of queued data that has not yet been sent into
+ *   the device buffer at d_snddata.  The data starts conn->sent bytes into
+ *   the queue and is limited by the MSS and by the peer's window.
+ *
+ * Returned Value:
+ *   The number of bytes copied (zero if there is nothing to send).
+ *
+ * Assumptions:
+ *   Called from the interrupt level or with interrupts disabled.
+ *
+ ****************************************************************************/
+
+uint16_t uip_tcpsendqcopy(FAR struct uip_driver_s *dev,
+                          FAR struct uip_conn *conn)
+{
+  unsigned int qlen;
+  unsigned int len;
+  uip_lock_t flags;
+  uint16_t avail;
+  uint16_t ret = 0;
+
+  flags = uip_connlock(conn);
+  qlen  = uip_tcpsendqlen(conn);
+  if (qlen > conn->sent)
+    {
+      len   = qlen - conn->sent;
+      avail = uip_tcpwndavail(conn);
+      if (len > avail)
+        {
+          len = avail;
+        }
+
+      ret = uip_iobcopyout(dev->d_snddata, conn->sndq, len, conn->sent);
+    }
+
+  uip_connunlock(conn, flags);
+  return ret;
+}
+
+/****************************************************************************
+ * Function: uip_tcpsendqack
+ *
+ * Description:
+ *   The peer has acknowledged 'acked' more bytes.  Remove them from the
+ *   front of the send queue.
+ *
+ * Assumptions:
+ *   Called from the interrupt level or with interrupts disabled.
+ *
+ ****************************************************************************/
+
+void uip_tcpsendqack(FAR struct uip_conn *conn, uint32_t acked)
+{
+  uip_lock_t flags = uip_connlock(conn);
+
+  if (conn->sndq)
+    {
+      conn->sndq = uip_iobtrimhead(conn->sndq, acked);
+    }
+
+  uip_connunlock(conn, flags);
+}
+
+/****************************************************************************
+ * Function: uip_tcpsendqfree
+ *
+ * Description:
+ *   Discard all data in the send queue.
+ *
+ * Assumptions:
+ *   Called with the network locked.
+ *
+ ****************************************************************************/
+
+void uip_tcpsendqfree(FAR struct uip_conn *conn)
+{
+  uip_lock_t flags = uip_connlock(conn);
+
+  if (conn->sndq)
+    {
+      uip_iobfreechain(conn->sndq);
+      conn->sndq = NULL;
+    }
+
+  uip_connunlock(conn, flags);
+}
+
+#endif /* CONFIG_NET && CONFIG_NET_TCP && CONFIG_NET_TCP_SENDQSIZE > 0 */
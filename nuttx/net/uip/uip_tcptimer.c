@@ -95,6 +95,7 @@
 
 void uip_tcptimer(struct uip_driver_s *dev, struct uip_conn *conn, int hsec)
 {
+  unsigned int tmo;
   uint8_t result;
 
   dev->d_snddata = &dev->d_buf[UIP_IPTCPH_LEN + UIP_LLH_LEN];
@@ -135,7 +136,14 @@ void uip_tcptimer(struct uip_driver_s *dev, struct uip_conn *conn, int hsec)
 
       if (conn->unacked > 0)
         {
-          /* The connection has outstanding data */
+          /* The connection has outstanding data.  Advance any round-trip
+           * time measurement.
+           */
+
+          if (conn->rtt > 0 && conn->rtt < UIP_RTO_MAX)
+            {
+              conn->rtt += hsec;
+            }
 
           if (conn->timer > hsec)
             {
@@ -172,9 +180,12 @@ void uip_tcptimer(struct uip_driver_s *dev, struct uip_conn *conn, int hsec)
                   goto done;
                 }
 
-             /* Exponential backoff. */
+              /* Exponential backoff from the estimated retransmission
+               * timeout.
+               */
 
-              conn->timer = UIP_RTO << (conn->nrtx > 4 ? 4: conn->nrtx);
+              tmo         = (unsigned int)conn->rto << (conn->nrtx > 4 ? 4: conn->nrtx);
+              conn->timer = tmo > UIP_RTO_MAX ? UIP_RTO_MAX : tmo;
               (conn->nrtx)++;
 
               /* Ok, so we need to retransmit. We do this differently
@@ -205,13 +216,11 @@ void uip_tcptimer(struct uip_driver_s *dev, struct uip_conn *conn, int hsec)
                     goto done;
 
                   case UIP_ESTABLISHED:
-                    /* In the ESTABLISHED state, we call upon the application
-                     * to do the actual retransmit after which we jump into
-                     * the code for sending out the packet.
+                    /* In the ESTABLISHED state, we go back to the oldest
+                     * unacknowledged data and send it again.
                      */
 
-                    result = uip_tcpcallback(dev, conn, UIP_REXMIT);
-                    uip_tcprexmit(dev, conn, result);
+                    uip_tcpretransmit(dev, conn, false);
                     goto done;
 
                   case UIP_FIN_WAIT_1:
@@ -234,9 +243,23 @@ void uip_tcptimer(struct uip_driver_s *dev, struct uip_conn *conn, int hsec)
            */
 
           result = uip_tcpcallback(dev, conn, UIP_POLL);
+          if (uip_tcpackdue(conn))
+            {
+              result |= UIP_SNDACK;
+            }
+
           uip_tcpappsend(dev, conn, result);
           goto done;
         }
+
+      /* Otherwise, send any window update or delayed ACK that is due */
+
+      if ((conn->tcpstateflags & UIP_TS_MASK) == UIP_ESTABLISHED &&
+          uip_tcpackdue(conn))
+        {
+          uip_tcpsend(dev, conn, TCP_ACK, UIP_IPTCPH_LEN);
+          goto done;
+        }
     }
 
   /* Nothing to be done */
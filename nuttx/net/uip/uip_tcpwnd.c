@@ -0,0 +1,271 @@
+/****************************************************************************
+ * net/uip/uip_tcpwnd.c
+ *
+ *   Copyright (C) 2012 Gregory Nutt. All rights reserved.
+ *   Author: Gregory Nutt <gnutt@nuttx.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name NuttX nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <net/uip/uipopt.h>
+#if defined(CONFIG_NET) && defined(CONFIG_NET_TCP)
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <queue.h>
+
+#include <nuttx/clock.h>
+#include <net/uip/uip.h>
+#include <net/uip/uip-arch.h>
+
+#include "uip_internal.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* Receiver silly window syndrome avoidance (RFC 1122, 4.2.3.3):  The
+ * window is not opened by less than one full segment or half of the
+ * receive window, whichever is smaller.
+ */
+
+#if UIP_TCP_MSS < (CONFIG_NET_RECEIVE_WINDOW / 2)
+#  define UIP_RCVWND_MINUPDATE UIP_TCP_MSS
+#else
+#  define UIP_RCVWND_MINUPDATE (CONFIG_NET_RECEIVE_WINDOW / 2)
+#endif
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: uip_tcprcvwnd
+ *
+ * Description:
+ *   Return the receive window to advertise to the peer.  Data that arrives
+ *   while no recv() is waiting is kept in the read-ahead buffers, so the
+ *   window is limited to the read-ahead buffer space that is still free.
+ *   While a recv() is waiting, or without read-ahead buffers,
+ *   CONFIG_NET_RECEIVE_WINDOW is advertised.
+ *
+ * Parameters:
+ *   conn - The TCP connection structure holding connection information
+ *
+ * Return:
+ *   The receive window in bytes (not scaled).
+ *
+ * Assumptions:
+ *   Called from the interrupt level or with interrupts disabled.
+ *
+ ****************************************************************************/
+
+uip_tcpwnd_t uip_tcprcvwnd(FAR struct uip_conn *conn)
+{
+  uint32_t wnd;
+
+  /* If the connection has issued uip_stop(), we advertise a zero window so
+   * that the remote host will stop sending data.
+   */
+
+  if ((conn->tcpstateflags & UIP_STOPPED) != 0)
+    {
+      return 0;
+    }
+
+#if CONFIG_NET_NTCP_READAHEAD_BUFFERS > 0
+  /* Data is received directly into the buffer of a waiting recv().  Other
+   * connections may hold all of the read-ahead buffers, so the pool must
+   * not close the window then or the connection could never receive more.
+   */
+
+  if ((conn->ackflags & UIP_RCVWAIT) != 0)
+    {
+      return CONFIG_NET_RECEIVE_WINDOW;
+    }
+
+  {
+    FAR struct uip_readahead_s *readahead;
+    uip_lock_t flags;
+
+    wnd = uip_tcpreadaheadnfree() * CONFIG_NET_TCP_READAHEAD_BUFSIZE;
+
+    /* recv() may release the last buffer while we look at it */
+
+    flags     = uip_connlock(conn);
+    readahead = (FAR struct uip_readahead_s *)conn->readahead.tail;
+    if (readahead)
+      {
+        wnd += CONFIG_NET_TCP_READAHEAD_BUFSIZE - readahead->rh_nbytes;
+      }
+
+    uip_connunlock(conn, flags);
+
+    if (wnd > CONFIG_NET_RECEIVE_WINDOW)
+      {
+        wnd = CONFIG_NET_RECEIVE_WINDOW;
+      }
+
+    /* Don't advertise a window that is too small to be useful */
+
+    else if (wnd < UIP_RCVWND_MINUPDATE)
+      {
+        wnd = 0;
+      }
+  }
+#else
+  wnd = CONFIG_NET_RECEIVE_WINDOW;
+#endif
+
+  return (uip_tcpwnd_t)wnd;
+}
+
+/****************************************************************************
+ * Name: uip_tcpwndupdate
+ *
+ * Description:
+ *   Called after recv() has taken data from the read-ahead buffers.  If
+ *   the receive window has opened far enough beyond the window last
+ *   advertised to the peer, a window update will be sent at the next poll.
+ *
+ * Parameters:
+ *   conn - The TCP connection structure holding connection information
+ *
+ * Return:
+ *   True if a window update is needed.  The caller should then notify the
+ *   device driver that there is TX data available.
+ *
+ * Assumptions:
+ *   Called with interrupts disabled.
+ *
+ ****************************************************************************/
+
+bool uip_tcpwndupdate(FAR struct uip_conn *conn)
+{
+  uip_tcpwnd_t wnd;
+
+  if ((conn->tcpstateflags & UIP_TS_MASK) != UIP_ESTABLISHED)
+    {
+      return false;
+    }
+
+  wnd = uip_tcprcvwnd(conn);
+  if (wnd > conn->rcvwnd && wnd - conn->rcvwnd >= UIP_RCVWND_MINUPDATE)
+    {
+      conn->ackflags |= UIP_ACKNOW;
+      return true;
+    }
+
+  return false;
+}
+
+/****************************************************************************
+ * Name: uip_tcpackdue
+ *
+ * Description:
+ *   Check if an ACK should be sent now:  Either a window update was
+ *   requested or a delayed ACK has been pending for
+ *   CONFIG_NET_TCP_DELACK_MSEC milliseconds.
+ *
+ * Parameters:
+ *   conn - The TCP connection structure holding connection information
+ *
+ * Return:
+ *   True if an ACK should be sent.
+ *
+ * Assumptions:
+ *   Called from the interrupt level or with interrupts disabled.
+ *
+ ****************************************************************************/
+
+bool uip_tcpackdue(FAR struct uip_conn *conn)
+{
+  if ((conn->ackflags & UIP_ACKNOW) != 0)
+    {
+      return true;
+    }
+
+#ifdef CONFIG_NET_TCP_DELAYED_ACK
+  if (conn->rcvunacked > 0 &&
+      (int32_t)(clock_systimer() - conn->acktime) >= 0)
+    {
+      return true;
+    }
+#endif
+
+  return false;
+}
+
+/****************************************************************************
+ * Name: uip_tcpdelayack
+ *
+ * Description:
+ *   Decide if the ACK for newly received data may be delayed.  At least
+ *   every second full-sized segment is ACKed immediately (RFC 1122,
+ *   4.2.3.2); otherwise the ACK is sent with the next outgoing segment or
+ *   when it becomes due (see uip_tcpackdue()).
+ *
+ * Parameters:
+ *   conn - The TCP connection structure holding connection information
+ *   len  - The number of bytes of data just received
+ *
+ * Return:
+ *   True if the ACK may be delayed.
+ *
+ * Assumptions:
+ *   Called from the interrupt level or with interrupts disabled.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_NET_TCP_DELAYED_ACK
+bool uip_tcpdelayack(FAR struct uip_conn *conn, uint16_t len)
+{
+  if ((conn->ackflags & UIP_ACKNOW) != 0)
+    {
+      return false;
+    }
+
+  /* Start the delayed ACK timer with the first unacknowledged data */
+
+  if (conn->rcvunacked == 0)
+    {
+      conn->acktime = clock_systimer() + MSEC2TICK(CONFIG_NET_TCP_DELACK_MSEC);
+    }
+
+  conn->rcvunacked += len;
+  return conn->rcvunacked < 2 * conn->initialmss;
+}
+#endif
+
+#endif /* CONFIG_NET && CONFIG_NET_TCP */
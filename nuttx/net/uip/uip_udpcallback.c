@@ -46,9 +46,16 @@
 #include <net/uip/uipopt.h>
 #include <net/uip/uip.h>
 #include <net/uip/uip-arch.h>
+#include <net/uip/uip-iob.h>
 
 #include "uip_internal.h"
 
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define UDPBUF ((struct uip_udpip_hdr *)&dev->d_buf[UIP_LLH_LEN])
+
 /****************************************************************************
  * Private Data
  ****************************************************************************/
@@ -57,6 +64,76 @@
  * Private Functions
  ****************************************************************************/
 
+/****************************************************************************
+ * Function: uip_udpreadahead
+ *
+ * Description:
+ *   Save a datagram that was not consumed by a recvfrom() in a chain of I/O
+ *   buffers at the end of the connection's read-ahead queue.  The datagram
+ *   is dropped if the queue is full or if there are not enough I/O buffers.
+ *
+ * Assumptions:
+ *   This function is called at the interrupt level with interrupts disabled.
+ *
+ ****************************************************************************/
+
+#if CONFIG_NET_UDP_NREADAHEAD > 0
+static void uip_udpreadahead(struct uip_driver_s *dev,
+                             struct uip_udp_conn *conn)
+{
+  FAR struct uip_udpip_hdr *pbuf = UDPBUF;
+  FAR struct uip_iob_s *iob;
+  struct uip_udprahdr_s hdr;
+  uip_lock_t flags;
+
+  if (conn->nreadahead >= CONFIG_NET_UDP_NREADAHEAD)
+    {
+      nllvdbg("Read-ahead queue full\n");
+      goto errout;
+    }
+
+  iob = uip_ioballoc();
+  if (!iob)
+    {
+      goto errout;
+    }
+
+  /* Save the sender's address followed by the datagram data */
+
+#ifdef CONFIG_NET_IPv6
+  uip_ipaddr_copy(hdr.ripaddr, pbuf->srcipaddr);
+#else
+  uip_ipaddr_copy(hdr.ripaddr, uip_ip4addr_conv(pbuf->srcipaddr));
+#endif
+  hdr.rport = pbuf->srcport;
+
+  if (uip_iobcopyin(iob, (FAR const uint8_t *)&hdr, sizeof(hdr), 0) < 0 ||
+      uip_iobcopyin(iob, dev->d_appdata, dev->d_len, sizeof(hdr)) < 0)
+    {
+      uip_iobfreechain(iob);
+      goto errout;
+    }
+
+  /* The read-ahead queue is shared with recvfrom() */
+
+  flags = uip_connlock(conn);
+  sq_addlast(&iob->io_link, &conn->readahead);
+  conn->nreadahead++;
+  uip_connunlock(conn, flags);
+
+  nllvdbg("Buffered %d bytes\n", dev->d_len);
+  dev->d_len = 0;
+  return;
+
+errout:
+#ifdef CONFIG_NET_STATISTICS
+  uip_stat.udp.drop++;
+#endif
+  nllvdbg("Dropped %d bytes\n", dev->d_len);
+  dev->d_len = 0;
+}
+#endif
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -84,6 +161,17 @@ void uip_udpcallback(struct uip_driver_s *dev, struct uip_udp_conn *conn,
       /* Perform the callback */
 
       flags = uip_callbackexecute(dev, conn, flags, conn->list);
+
+#if CONFIG_NET_UDP_NREADAHEAD > 0
+      /* If the new data was not consumed by a waiting recvfrom(), then
+       * save it in the read-ahead queue.
+       */
+
+      if ((flags & UIP_NEWDATA) != 0)
+        {
+          uip_udpreadahead(dev, conn);
+        }
+#endif
     }
 }
 
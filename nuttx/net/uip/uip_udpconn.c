@@ -59,6 +59,7 @@
 #include <net/uip/uipopt.h>
 #include <net/uip/uip.h>
 #include <net/uip/uip-arch.h>
+#include <net/uip/uip-iob.h>
 
 #include "uip_internal.h"
 
@@ -79,6 +80,12 @@ static sem_t g_free_sem;
 
 static dq_queue_t g_active_udp_connections;
 
+/* Every connection that holds a local port number is kept in a hash table
+ * keyed on the local port.
+ */
+
+static struct uip_udp_conn *g_udp_hash[CONFIG_NET_UDP_NHASH];
+
 /* Last port used by a UDP connection connection. */
 
 static uint16_t g_last_udp_port;
@@ -122,21 +129,61 @@ static inline void _uip_semtake(sem_t *sem)
 
 static struct uip_udp_conn *uip_find_conn(uint16_t portno)
 {
-  int i;
+  struct uip_udp_conn *conn;
 
-  /* Now search each connection structure.*/
+  /* Now search each connection structure with the same hash of the port */
 
-  for (i = 0; i < CONFIG_NET_UDP_CONNS; i++)
+  conn = g_udp_hash[uip_porthash(portno, CONFIG_NET_UDP_NHASH)];
+  for (; conn; conn = conn->hflink)
     {
-      if (g_udp_connections[ i ].lport == portno)
+      if (conn->lport == portno)
         {
-          return &g_udp_connections[ i ];
+          return conn;
         }
     }
 
   return NULL;
 }
 
+/****************************************************************************
+ * Name: uip_udpsetport()
+ *
+ * Description:
+ *   Assign a local port number (in network byte order) to a connection and
+ *   keep the local port hash table up to date.  A port number of zero
+ *   removes the connection from the table.
+ *
+ * Assumptions:
+ *   Interrupts are disabled
+ *
+ ****************************************************************************/
+
+static void uip_udpsetport(struct uip_udp_conn *conn, uint16_t portno)
+{
+  struct uip_udp_conn **pprev;
+
+  if (conn->lport != 0)
+    {
+      pprev = &g_udp_hash[uip_porthash(conn->lport, CONFIG_NET_UDP_NHASH)];
+      for (; *pprev; pprev = &(*pprev)->hflink)
+        {
+          if (*pprev == conn)
+            {
+              *pprev = conn->hflink;
+              break;
+            }
+        }
+    }
+
+  conn->lport = portno;
+  if (portno != 0)
+    {
+      pprev        = &g_udp_hash[uip_porthash(portno, CONFIG_NET_UDP_NHASH)];
+      conn->hflink = *pprev;
+      *pprev       = conn;
+    }
+}
+
 /****************************************************************************
  * Name: uip_selectport()
  *
@@ -216,11 +263,20 @@ void uip_udpinit(void)
   dq_init(&g_active_udp_connections);
   sem_init(&g_free_sem, 0, 1);
 
+  for (i = 0; i < CONFIG_NET_UDP_NHASH; i++)
+    {
+      g_udp_hash[i] = NULL;
+    }
+
   for (i = 0; i < CONFIG_NET_UDP_CONNS; i++)
     {
       /* Mark the connection closed and move it to the free list */
 
-      g_udp_connections[i].lport = 0;
+      g_udp_connections[i].lport  = 0;
+      g_udp_connections[i].active = false;
+#ifdef CONFIG_NET_NOINTS
+      uip_mutexinit(&g_udp_connections[i].lock, UIP_LOCKSTAT(conn));
+#endif
       dq_addlast(&g_udp_connections[i].node, &g_free_udp_connections);
     }
 
@@ -250,6 +306,13 @@ struct uip_udp_conn *uip_udpalloc(void)
       /* Make sure that the connection is marked as uninitialized */
 
       conn->lport = 0;
+
+#if CONFIG_NET_UDP_NREADAHEAD > 0
+      /* Initialize read-ahead buffering */
+
+      sq_init(&conn->readahead);
+      conn->nreadahead = 0;
+#endif
     }
   _uip_semgive(&g_free_sem);
   return conn;
@@ -267,14 +330,42 @@ struct uip_udp_conn *uip_udpalloc(void)
 
 void uip_udpfree(struct uip_udp_conn *conn)
 {
+#if CONFIG_NET_UDP_NREADAHEAD > 0
+  FAR struct uip_iob_s *iob;
+#endif
+  uip_lock_t flags;
+
+  DEBUGASSERT(conn->crefs == 0);
+
+  /* With read-ahead buffering, the connection is still active.  Remove it
+   * from the active list and release any datagrams that were never read.
+   * Then release the local port number.
+   */
+
+  flags = uip_lock();
+  if (conn->active)
+    {
+      dq_rem(&conn->node, &g_active_udp_connections);
+      conn->active = false;
+    }
+
+#if CONFIG_NET_UDP_NREADAHEAD > 0
+  while ((iob = (FAR struct uip_iob_s *)sq_remfirst(&conn->readahead)) != NULL)
+    {
+      uip_iobfreechain(iob);
+    }
+
+  conn->nreadahead = 0;
+#endif
+
+  uip_udpsetport(conn, 0);
+  uip_unlock(flags);
+
   /* The free list is only accessed from user, non-interrupt level and
    * is protected by a semaphore (that behaves like a mutex).
    */
 
-  DEBUGASSERT(conn->crefs == 0);
-
   _uip_semtake(&g_free_sem);
-  conn->lport = 0;
   dq_addlast(&conn->node, &g_free_udp_connections);
   _uip_semgive(&g_free_sem);
 }
@@ -293,20 +384,20 @@ void uip_udpfree(struct uip_udp_conn *conn)
 
 struct uip_udp_conn *uip_udpactive(struct uip_udpip_hdr *buf)
 {
-  struct uip_udp_conn *conn = (struct uip_udp_conn *)g_active_udp_connections.head;
+  struct uip_udp_conn *conn;
 
+  conn = g_udp_hash[uip_porthash(buf->destport, CONFIG_NET_UDP_NHASH)];
   while (conn)
     {
-      /* If the local UDP port is non-zero, the connection is considered
-       * to be used. If so, the local port number is checked against the
-       * destination port number in the received packet. If the two port
-       * numbers match, the remote port number is checked if the
-       * connection is bound to a remote port. Finally, if the
-       * connection is bound to a remote IP address, the source IP
+      /* Only active connections receive datagrams.  The local port number
+       * is checked against the destination port number in the received
+       * packet. If the two port numbers match, the remote port number is
+       * checked if the connection is bound to a remote port. Finally, if
+       * the connection is bound to a remote IP address, the source IP
        * address of the packet is checked.
        */
 
-      if (conn->lport != 0 && buf->destport == conn->lport &&
+      if (conn->active && buf->destport == conn->lport &&
           (conn->rport == 0 || buf->srcport == conn->rport) &&
             (uip_ipaddr_cmp(conn->ripaddr, g_allzeroaddr) ||
              uip_ipaddr_cmp(conn->ripaddr, g_alloneaddr) ||
@@ -316,9 +407,9 @@ struct uip_udp_conn *uip_udpactive(struct uip_udpip_hdr *buf)
           break;
         }
 
-      /* Look at the next active connection */
+      /* Look at the next connection with the same hash */
 
-      conn = (struct uip_udp_conn *)conn->node.flink;
+      conn = conn->hflink;
     }
 
   return conn;
@@ -369,33 +460,43 @@ int uip_udpbind(struct uip_udp_conn *conn, const struct sockaddr_in *addr)
   int ret = -EADDRINUSE;
   uip_lock_t flags;
 
+  /* Interrupts must be disabled while access the UDP connection list */
+
+  flags = uip_lock();
+
   /* Is the user requesting to bind to any port? */
 
   if (!addr->sin_port)
     {
       /* Yes.. Find an unused local port number */
 
-      conn->lport = htons(uip_selectport());
-      ret         = OK;
+      uip_udpsetport(conn, htons(uip_selectport()));
+      ret = OK;
     }
-  else
-    {
-      /* Interrupts must be disabled while access the UDP connection list */
 
-      flags = uip_lock();
+  /* Is any other UDP connection bound to this port? */
 
-      /* Is any other UDP connection bound to this port? */
+  else if (!uip_find_conn(addr->sin_port))
+    {
+      /* No.. then bind the socket to the port */
 
-      if (!uip_find_conn(addr->sin_port))
-        {
-          /* No.. then bind the socket to the port */
+      uip_udpsetport(conn, addr->sin_port);
+      ret = OK;
+    }
 
-          conn->lport = addr->sin_port;
-          ret         = OK;
-        }
+  uip_unlock(flags);
 
-      uip_unlock(flags);
+#if CONFIG_NET_UDP_NREADAHEAD > 0
+  /* With read-ahead buffering, datagrams sent to the bound port are
+   * queued from now on, even if no recvfrom() is waiting for them.
+   */
+
+  if (ret == OK)
+    {
+      uip_udpenable(conn);
     }
+#endif
+
   return ret;
 }
 
@@ -433,7 +534,9 @@ int uip_udpconnect(struct uip_udp_conn *conn, const struct sockaddr_in *addr)
        * connection structure.
        */
 
-      conn->lport = htons(uip_selectport());
+      uip_lock_t flags = uip_lock();
+      uip_udpsetport(conn, htons(uip_selectport()));
+      uip_unlock(flags);
     }
 
   /* Is there a remote port (rport) */
@@ -457,7 +560,10 @@ int uip_udpconnect(struct uip_udp_conn *conn, const struct sockaddr_in *addr)
  * Name: uip_udpenable() uip_udpdisable.
  *
  * Description:
- *   Enable/disable callbacks for the specified connection
+ *   Enable/disable callbacks for the specified connection.  With UDP
+ *   read-ahead buffering, uip_udpdisable() does nothing:  The connection
+ *   stays active so that received datagrams are queued until the
+ *   connection is freed.
  *
  * Assumptions:
  *   This function is called user code.  Interrupts may be enabled.
@@ -472,20 +578,32 @@ void uip_udpenable(struct uip_udp_conn *conn)
    */
 
   uip_lock_t flags = uip_lock();
-  dq_addlast(&conn->node, &g_active_udp_connections);
+  if (!conn->active)
+    {
+      dq_addlast(&conn->node, &g_active_udp_connections);
+      conn->active = true;
+    }
+
   uip_unlock(flags);
 }
 
 void uip_udpdisable(struct uip_udp_conn *conn)
 {
+#if CONFIG_NET_UDP_NREADAHEAD == 0
   /* Remove the connection structure from the active connectionlist. This list
    * is modifiable from interrupt level, we we must disable interrupts to
    * access it safely.
    */
 
   uip_lock_t flags = uip_lock();
-  dq_rem(&conn->node, &g_active_udp_connections);
+  if (conn->active)
+    {
+      dq_rem(&conn->node, &g_active_udp_connections);
+      conn->active = false;
+    }
+
   uip_unlock(flags);
+#endif
 }
 
 #endif /* CONFIG_NET && CONFIG_NET_UDP */
@@ -45,6 +45,7 @@
 #include <errno.h>
 #include <debug.h>
 
+#include <nuttx/arch.h>
 #include <nuttx/clock.h>
 #include <nuttx/time.h>
 #include <nuttx/rtc.h>
@@ -77,10 +78,14 @@
  ****************************************************************************/
 
 #ifdef CONFIG_SYSTEM_TIME64
+#ifndef CONFIG_SCHED_TICKLESS
 volatile uint64_t g_system_timer;
+#endif
 uint64_t          g_tickbias;
 #else
+#ifndef CONFIG_SCHED_TICKLESS
 volatile uint32_t g_system_timer;
+#endif
 uint32_t          g_tickbias;
 #endif
 
@@ -189,8 +194,18 @@ void clock_initialize(void)
   /* Initialize the time value to match */
 
   clock_inittime(&g_basetime);
+#ifdef CONFIG_SCHED_TICKLESS
+  g_tickbias     = 0;
+
+  /* In the tickless mode, the system time is provided by the platform-
+   * specific interval timer which must be started now.
+   */
+
+  up_timer_initialize();
+#else
   g_system_timer = 0;
   g_tickbias     = 0;
+#endif
 }
 
 /****************************************************************************
@@ -203,9 +218,11 @@ void clock_initialize(void)
  *
  ****************************************************************************/
 
+#ifndef CONFIG_SCHED_TICKLESS
 void clock_timer(void)
 {
   /* Increment the per-tick system counter */
 
   g_system_timer++;
 }
+#endif
@@ -59,6 +59,20 @@
 #  undef CONFIG_SYSTEM_TIME64
 #endif
 
+/* In the tickless mode, the system time is derived from the platform-
+ * specific interval timer.  That requires the clock logic and an integral
+ * number of ticks per second.
+ */
+
+#ifdef CONFIG_SCHED_TICKLESS
+#  ifdef CONFIG_DISABLE_CLOCK
+#    error "CONFIG_SCHED_TICKLESS requires CONFIG_DISABLE_CLOCK=n"
+#  endif
+#  if (MSEC_PER_SEC % MSEC_PER_TICK) != 0
+#    error "CONFIG_SCHED_TICKLESS requires that MSEC_PER_TICK divide one second"
+#  endif
+#endif
+
 /********************************************************************************
  * Public Type Definitions
  ********************************************************************************/
@@ -80,7 +94,9 @@ extern struct timespec g_basetime;
  ********************************************************************************/
 
 extern void weak_function clock_initialize(void);
+#ifndef CONFIG_SCHED_TICKLESS
 extern void weak_function clock_timer(void);
+#endif
 
 extern int    clock_abstime2ticks(clockid_t clockid,
                                   FAR const struct timespec *abstime,
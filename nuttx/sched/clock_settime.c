@@ -122,7 +122,11 @@ int clock_settime(clockid_t clock_id, FAR const struct timespec *tp)
        * as appropriate.
        */
 
-      g_tickbias = g_system_timer;
+#ifdef CONFIG_SYSTEM_TIME64
+      g_tickbias = clock_systimer64();
+#else
+      g_tickbias = clock_systimer();
+#endif
 
       /* Setup the RTC (lo- or high-res) */
 
@@ -40,7 +40,9 @@
 #include <nuttx/config.h>
 
 #include <stdint.h>
+#include <time.h>
 
+#include <nuttx/arch.h>
 #include <nuttx/clock.h>
 
 #include "clock_internal.h"
@@ -53,6 +55,40 @@
  * Private Data
  ****************************************************************************/
 
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Function:  clock_tickless_systimer
+ *
+ * Description:
+ *   In the tickless mode, there is no timer interrupt to maintain
+ *   g_system_timer.  Instead, the system time in ticks is derived from
+ *   the free-running time maintained by the platform-specific interval
+ *   timer.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_SCHED_TICKLESS
+#ifdef CONFIG_SYSTEM_TIME64
+static inline uint64_t clock_tickless_systimer(void)
+#else
+static inline uint32_t clock_tickless_systimer(void)
+#endif
+{
+  struct timespec ts;
+
+  (void)up_timer_gettime(&ts);
+
+#ifdef CONFIG_SYSTEM_TIME64
+  return (uint64_t)ts.tv_sec * TICK_PER_SEC + ts.tv_nsec / NSEC_PER_TICK;
+#else
+  return (uint32_t)ts.tv_sec * TICK_PER_SEC + ts.tv_nsec / NSEC_PER_TICK;
+#endif
+}
+#endif
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -76,7 +112,9 @@
 #if !defined(clock_systimer) /* See nuttx/clock.h */
 uint32_t clock_systimer(void)
 {
-#ifdef CONFIG_SYSTEM_TIME64
+#if defined(CONFIG_SCHED_TICKLESS)
+  return clock_tickless_systimer();
+#elif defined(CONFIG_SYSTEM_TIME64)
   return (uint32_t)(g_system_timer & 0x00000000ffffffff);
 #else
   return g_system_timer;
@@ -100,11 +138,15 @@ uint32_t clock_systimer(void)
  *
  ****************************************************************************/
 
-#if !defined(clock_systimer) /* See nuttx/clock.h */
+#if !defined(clock_systimer64) /* See nuttx/clock.h */
 #ifdef CONFIG_SYSTEM_TIME64
 uint64_t clock_systimer64(void)
 {
+#ifdef CONFIG_SCHED_TICKLESS
+  return clock_tickless_systimer();
+#else
   return g_system_timer;
+#endif
 }
 #endif
 #endif
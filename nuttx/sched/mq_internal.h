@@ -52,6 +52,7 @@
 #include <signal.h>
 
 #include <nuttx/mqueue.h>
+#include <nuttx/mempool.h>
 
 #if CONFIG_MQ_MAXMSGSIZE > 0
 
@@ -81,9 +82,8 @@
 
 enum mqalloc_e
 {
-  MQ_ALLOC_FIXED = 0,  /* pre-allocated; never freed */
-  MQ_ALLOC_DYN,        /* dynamically allocated; free when unused */
-  MQ_ALLOC_IRQ         /* Preallocated, reserved for interrupt handling */
+  MQ_ALLOC_FIXED = 0,  /* pre-allocated in g_msgpool; never freed */
+  MQ_ALLOC_DYN         /* dynamically allocated; free when unused */
 };
 typedef enum mqalloc_e mqalloc_t;
 
@@ -111,18 +111,11 @@ typedef struct mqmsg mqmsg_t;
 
 extern sq_queue_t  g_msgqueues;
 
-/* The g_msgfree is a list of messages that are available
- * for general use.  The number of messages in this list is a
- * system configuration item.
+/* The g_msgpool is the pool of pre-allocated messages.  Some of the
+ * messages are reserved for use by interrupt handlers.
  */
 
-extern sq_queue_t  g_msgfree;
-
-/* The g_msgfreeInt is a list of messages that are reserved
- * for use by interrupt handlers.
- */
-
-extern sq_queue_t  g_msgfreeirq;
+extern struct mempool_s g_msgpool;
 
 /* The g_desfree data structure is a list of message
  * descriptors available to the operating system for general use.
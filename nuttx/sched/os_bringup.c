@@ -111,10 +111,13 @@
  *
  *   - pg_worker:   The page-fault worker thread (only if CONFIG_PAGING is
  *                  defined.
- *   - work_thread: The work thread.  This general thread can be used to
- *                  perform most any kind of queued work.  Its primary
- *                  function is to serve as the "bottom half" of device
- *                  drivers.
+ *   - work_hpthread: The high priority work thread.  This general thread
+ *                  can be used to perform most any kind of queued work.  Its
+ *                  primary function is to serve as the "bottom half" of
+ *                  device drivers.
+ *   - work_lpthread: The low priority work thread (only if
+ *                  CONFIG_SCHED_LPWORK is defined).  This thread performs
+ *                  less critical work such as garbage collection.
  *
  *   And the main application entry point.  This may be one of two different
  *   symbols:
@@ -153,12 +156,25 @@ int os_bringup(void)
    */
 
 #ifdef CONFIG_SCHED_WORKQUEUE
-  svdbg("Starting worker thread\n");
+  svdbg("Starting high-priority worker thread\n");
 
-  g_worker = KERNEL_THREAD("work", CONFIG_SCHED_WORKPRIORITY,
-                           CONFIG_SCHED_WORKSTACKSIZE,
-                           (main_t)work_thread, (const char **)NULL);
-  ASSERT(g_worker != ERROR);
+  g_work[HPWORK].pid = KERNEL_THREAD("work", CONFIG_SCHED_WORKPRIORITY,
+                                     CONFIG_SCHED_WORKSTACKSIZE,
+                                     (main_t)work_hpthread, (const char **)NULL);
+  ASSERT(g_work[HPWORK].pid != ERROR);
+
+  /* Start a lower priority worker thread for other, non-critical continuation
+   * tasks
+   */
+
+#ifdef CONFIG_SCHED_LPWORK
+  svdbg("Starting low-priority worker thread\n");
+
+  g_work[LPWORK].pid = KERNEL_THREAD("lpwork", CONFIG_SCHED_LPWORKPRIORITY,
+                                     CONFIG_SCHED_LPWORKSTACKSIZE,
+                                     (main_t)work_lpthread, (const char **)NULL);
+  ASSERT(g_work[LPWORK].pid != ERROR);
+#endif
 #endif
 
   /* Once the operating system has been initialized, the system must be
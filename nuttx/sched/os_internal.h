@@ -279,6 +279,15 @@ extern bool sched_addreadytorun(FAR _TCB *rtrtcb);
 extern bool sched_removereadytorun(FAR _TCB *rtrtcb);
 extern bool sched_addprioritized(FAR _TCB *newTcb, DSEG dq_queue_t *list);
 extern bool sched_mergepending(void);
+#ifdef CONFIG_SCHED_RTRBITMAP
+extern bool sched_rtrinsert(FAR _TCB *tcb);
+extern void sched_rtrremove(FAR _TCB *tcb);
+#else
+#  define sched_rtrinsert(t) \
+     sched_addprioritized(t, (FAR dq_queue_t*)&g_readytorun)
+#  define sched_rtrremove(t) \
+     dq_rem((FAR dq_entry_t*)(t), (dq_queue_t*)&g_readytorun)
+#endif
 extern void sched_addblocked(FAR _TCB *btcb, tstate_t task_state);
 extern void sched_removeblocked(FAR _TCB *btcb);
 extern int  sched_setpriority(FAR _TCB *tcb, int sched_priority);
@@ -303,5 +312,10 @@ extern int  sched_releasefiles(FAR _TCB *tcb);
 
 extern int  sched_releasetcb(FAR _TCB *tcb);
 extern void sched_garbagecollection(void);
+#ifdef CONFIG_SCHED_TICKLESS
+extern void sched_timer_reassess(void);
+#else
+#  define sched_timer_reassess()
+#endif
 
 #endif /* __OS_INTERNAL_H */
@@ -121,7 +121,7 @@ bool sched_addreadytorun(FAR _TCB *btcb)
 
   /* Otherwise, add the new task to the g_readytorun task list */
 
-  else if (sched_addprioritized(btcb, (FAR dq_queue_t*)&g_readytorun))
+  else if (sched_rtrinsert(btcb))
     {
       /* Information the instrumentation logic that we are switching tasks */
 
@@ -135,6 +135,10 @@ bool sched_addreadytorun(FAR _TCB *btcb)
 
       btcb->task_state = TSTATE_TASK_RUNNING;
       btcb->flink->task_state = TSTATE_TASK_READYTORUN;
+
+      /* The new task may need the interval timer for its timeslice */
+
+      sched_timer_reassess();
       ret = true;
     }
   else
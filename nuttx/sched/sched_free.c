@@ -100,7 +100,7 @@ void sched_free(FAR void *address)
       /* Signal the worker thread that is has some clean up to do */
 
 #ifdef CONFIG_SCHED_WORKQUEUE
-      work_signal();
+      work_signal(LPWORK);
 #endif
       irqrestore(saved_state);
     }
@@ -91,6 +91,52 @@
  *
  ************************************************************************/
 
+#ifdef CONFIG_SCHED_RTRBITMAP
+bool sched_mergepending(void)
+{
+  FAR _TCB *pndtcb;
+  FAR _TCB *pndnext;
+  bool ret = false;
+
+  /* Process every TCB in the g_pendingtasks list.  sched_rtrinsert() finds
+   * the location in the g_readytorun list directly.
+   */
+
+  for (pndtcb = (FAR _TCB*)g_pendingtasks.head; pndtcb; pndtcb = pndnext)
+    {
+      pndnext = pndtcb->flink;
+
+      if (sched_rtrinsert(pndtcb))
+        {
+          /* pndtcb was inserted at the head of the list */
+
+          pndtcb->flink->task_state = TSTATE_TASK_READYTORUN;
+          pndtcb->task_state = TSTATE_TASK_RUNNING;
+          ret = true;
+        }
+      else
+        {
+          pndtcb->task_state = TSTATE_TASK_READYTORUN;
+        }
+    }
+
+  /* Mark the input list empty */
+
+  g_pendingtasks.head = NULL;
+  g_pendingtasks.tail = NULL;
+
+  /* If a pending task is now the running task, the interval timer may need
+   * to be re-started for its timeslice.
+   */
+
+  if (ret)
+    {
+      sched_timer_reassess();
+    }
+
+  return ret;
+}
+#else
 bool sched_mergepending(void)
 {
   FAR _TCB *pndtcb;
@@ -167,5 +213,15 @@ bool sched_mergepending(void)
   g_pendingtasks.head = NULL;
   g_pendingtasks.tail = NULL;
 
+  /* If a pending task is now the running task, the interval timer may need
+   * to be re-started for its timeslice.
+   */
+
+  if (ret)
+    {
+      sched_timer_reassess();
+    }
+
   return ret;
 }
+#endif /* CONFIG_SCHED_RTRBITMAP */
@@ -1,7 +1,7 @@
 /************************************************************************
  * sched/sched_processtimer.c
  *
- *   Copyright (C) 2007, 2009 Gregory Nutt. All rights reserved.
+ *   Copyright (C) 2007, 2009, 2012 Gregory Nutt. All rights reserved.
  *   Author: Gregory Nutt <spudmonkey@racsa.co.cr>
  *
  * Redistribution and use in source and binary forms, with or without
@@ -40,7 +40,11 @@
 #include <nuttx/config.h>
 #include <nuttx/compiler.h>
 
-#if CONFIG_RR_INTERVAL > 0
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+
+#if CONFIG_RR_INTERVAL > 0 || defined(CONFIG_SCHED_TICKLESS)
 # include <sched.h>
 # include <nuttx/arch.h>
 #endif
@@ -65,10 +69,140 @@
  * Private Variables
  ************************************************************************/
 
+#ifdef CONFIG_SCHED_TICKLESS
+/* In the tickless mode, the timeslice of the round-robin task at the head
+ * of the ready-to-run list is not decremented on each tick.  Instead, the
+ * absolute time when the timeslice will expire is retained here.
+ */
+
+#if CONFIG_RR_INTERVAL > 0
+static FAR _TCB *g_rrtcb;         /* The RR task being timed (or NULL) */
+static uint32_t  g_rrdeadline;    /* System time when its timeslice expires */
+#endif
+
+/* True while the interval timer expiration is being processed.  The
+ * interval timer will be re-started when the processing completes.
+ */
+
+static bool      g_timerbusy;
+#endif
+
 /************************************************************************
  * Private Functions
  ************************************************************************/
 
+/************************************************************************
+ * Name:  sched_timer_rrtrack
+ *
+ * Description:
+ *   Track the task at the head of the ready-to-run list (tickless mode
+ *   only).  If a different task is now running, save the unused portion
+ *   of the timeslice of the previous round-robin task and begin timing the
+ *   timeslice of the new one.
+ *
+ * Inputs:
+ *   now - The current system time in ticks
+ *
+ * Return Value:
+ *   None
+ *
+ * Assumptions:
+ *   Interrupts are disabled.
+ *
+ ************************************************************************/
+
+#if defined(CONFIG_SCHED_TICKLESS) && CONFIG_RR_INTERVAL > 0
+static void sched_timer_rrtrack(uint32_t now)
+{
+  FAR _TCB *rtcb = (FAR _TCB*)g_readytorun.head;
+  int32_t   remaining;
+
+  if (rtcb != g_rrtcb)
+    {
+      /* The task that was being timed is no longer running.  Retain the
+       * unused portion of its timeslice.
+       */
+
+      if (g_rrtcb)
+        {
+          remaining = (int32_t)(g_rrdeadline - now);
+          g_rrtcb->timeslice = remaining > 0 ? remaining : 1;
+        }
+
+      /* Start timing the new running task if it uses round robin
+       * scheduling.
+       */
+
+      g_rrtcb = NULL;
+      if ((rtcb->flags & TCB_FLAG_ROUND_ROBIN) != 0)
+        {
+          g_rrtcb      = rtcb;
+          g_rrdeadline = now + rtcb->timeslice;
+        }
+    }
+
+  /* The scheduling policy of the running task may have been changed */
+
+  else if (g_rrtcb && (g_rrtcb->flags & TCB_FLAG_ROUND_ROBIN) == 0)
+    {
+      g_rrtcb = NULL;
+    }
+}
+#else
+#  define sched_timer_rrtrack(now)
+#endif
+
+/************************************************************************
+ * Name:  sched_process_timeslice
+ *
+ * Description:
+ *   Check if the currently executing task has exceeded its timeslice.
+ *
+ ************************************************************************/
+
+#ifdef CONFIG_SCHED_TICKLESS
+static void sched_process_timeslice(uint32_t now)
+{
+#if CONFIG_RR_INTERVAL > 0
+  FAR _TCB *rtcb;
+
+  /* Check if the currently executing task uses round robin scheduling */
+
+  sched_timer_rrtrack(now);
+  rtcb = g_rrtcb;
+
+  if (rtcb && (int32_t)(g_rrdeadline - now) <= 0)
+    {
+      /* The timeslice has expired.  Check if the task has pre-emption
+       * disabled.  If so, then check again on the next tick.
+       */
+
+      if (!rtcb->lockcount)
+        {
+          /* Reset the timeslice in any case. */
+
+          rtcb->timeslice = CONFIG_RR_INTERVAL / MSEC_PER_TICK;
+          g_rrdeadline    = now + rtcb->timeslice;
+
+          /* If the next task in the ready to run list is the same
+           * priority, then we need to relinquish the CPU and give that
+           * task a shot.
+           */
+
+          if (rtcb->flink &&
+              rtcb->flink->sched_priority >= rtcb->sched_priority)
+            {
+              up_reprioritize_rtr(rtcb, rtcb->sched_priority);
+            }
+        }
+      else
+        {
+          g_rrdeadline = now + 1;
+        }
+    }
+#endif
+}
+#else
 static void sched_process_timeslice(void)
 {
 #if CONFIG_RR_INTERVAL > 0
@@ -130,6 +264,68 @@ static void sched_process_timeslice(void)
     }
 #endif
 }
+#endif
+
+/************************************************************************
+ * Name:  sched_timer_start
+ *
+ * Description:
+ *   Start the interval timer so that it expires when the next watchdog
+ *   expires or when the timeslice of the running round-robin task ends,
+ *   whichever comes first (tickless mode only).  If neither is pending,
+ *   the interval timer is not started at all.
+ *
+ * Inputs:
+ *   now - The current system time in ticks
+ *
+ * Return Value:
+ *   None
+ *
+ * Assumptions:
+ *   Interrupts are disabled and the interval timer is not running.
+ *
+ ************************************************************************/
+
+#ifdef CONFIG_SCHED_TICKLESS
+static void sched_timer_start(uint32_t now)
+{
+  struct timespec ts;
+  uint32_t expiry;
+  int32_t  delay;
+  bool     pending;
+
+  /* When will the next watchdog expire? */
+
+  pending = wd_nextexpiry(&expiry);
+
+  /* Will the timeslice of the running task expire before that? */
+
+#if CONFIG_RR_INTERVAL > 0
+  sched_timer_rrtrack(now);
+  if (g_rrtcb && (!pending || (int32_t)(g_rrdeadline - expiry) < 0))
+    {
+      expiry  = g_rrdeadline;
+      pending = true;
+    }
+#endif
+
+  if (pending)
+    {
+      /* An expiration time that has already passed will be handled
+       * immediately.
+       */
+
+      delay = (int32_t)(expiry - now);
+      if (delay < 0)
+        {
+          delay = 0;
+        }
+
+      (void)clock_ticks2time(delay, &ts);
+      (void)up_timer_start(&ts);
+    }
+}
+#endif
 
 /************************************************************************
  * Public Functions
@@ -161,6 +357,7 @@ static void sched_process_timeslice(void)
  *
  ************************************************************************/
 
+#ifndef CONFIG_SCHED_TICKLESS
 void sched_process_timer(void)
 {
   /* Increment the system time (if in the link) */
@@ -189,3 +386,94 @@ void sched_process_timer(void)
 
    sched_process_timeslice();
 }
+#endif
+
+/************************************************************************
+ * Name:  sched_timer_expiration
+ *
+ * Description:
+ *   In the tickless mode, there is no periodic timer interrupt.  Instead,
+ *   the architecture-specific logic must call this function when the
+ *   interval timer started by up_timer_start() expires.  Any expired
+ *   watchdogs are processed, the round-robin timeslice of the running
+ *   task is checked, and the interval timer is started again for the next
+ *   event.
+ *
+ * Inputs:
+ *   None
+ *
+ * Return Value:
+ *   None
+ *
+ * Assumptions:
+ *   Called from the interval timer interrupt handler.
+ *
+ ************************************************************************/
+
+#ifdef CONFIG_SCHED_TICKLESS
+void sched_timer_expiration(void)
+{
+  irqstate_t flags = irqsave();
+
+  /* Suppress re-starting of the interval timer by sched_timer_reassess()
+   * while watchdogs are being processed;  it will be re-started below.
+   */
+
+  g_timerbusy = true;
+
+  /* Process watchdogs (if in the link) */
+
+#ifdef CONFIG_HAVE_WEAKFUNCTIONS
+  if (wd_timer != NULL)
+#endif
+    {
+      wd_timer();
+    }
+
+  /* Check if the currently executing task has exceeded its
+   * timeslice.
+   */
+
+  sched_process_timeslice(clock_systimer());
+
+  /* Then start the interval timer for the next event */
+
+  g_timerbusy = false;
+  sched_timer_start(clock_systimer());
+  irqrestore(flags);
+}
+#endif
+
+/************************************************************************
+ * Name:  sched_timer_reassess
+ *
+ * Description:
+ *   In the tickless mode, the interval timer must be re-started whenever
+ *   the time of the next event changes:  when a watchdog is added to or
+ *   removed from the head of the active list, or when a different task
+ *   becomes the running task.  Expired watchdogs are not processed here;
+ *   that will happen when the re-started interval timer expires.
+ *
+ * Inputs:
+ *   None
+ *
+ * Return Value:
+ *   None
+ *
+ * Assumptions:
+ *   Interrupts are disabled.
+ *
+ ************************************************************************/
+
+#ifdef CONFIG_SCHED_TICKLESS
+void sched_timer_reassess(void)
+{
+  struct timespec ts;
+
+  if (!g_timerbusy)
+    {
+      (void)up_timer_cancel(&ts);
+      sched_timer_start(clock_systimer());
+    }
+}
+#endif
@@ -95,6 +95,9 @@ static void sched_releasepid(pid_t pid)
 
 int sched_releasetcb(FAR _TCB *tcb)
 {
+#ifdef CONFIG_MM_TASKCACHE
+  FAR void *mem;
+#endif
   int ret = OK;
   int i;
 
@@ -171,6 +174,15 @@ int sched_releasetcb(FAR _TCB *tcb)
 
       (void)env_release(tcb);
 
+      /* Return the chunks in the task's allocation cache to the heap */
+
+#ifdef CONFIG_MM_TASKCACHE
+      while ((mem = mm_cachedrain(&tcb->mmcache)) != NULL)
+        {
+          sched_free(mem);
+        }
+#endif
+
       /* And, finally, release the TCB itself */
 
       sched_free(tcb);
@@ -116,7 +116,16 @@ bool sched_removereadytorun(FAR _TCB *rtcb)
 
   /* Remove the TCB from the ready-to-run list */
 
-  dq_rem((FAR dq_entry_t*)rtcb, (dq_queue_t*)&g_readytorun);
+  sched_rtrremove(rtcb);
+
+  /* If the running task changed, the interval timer may need to be
+   * re-started for the timeslice of the new running task.
+   */
+
+  if (ret)
+    {
+      sched_timer_reassess();
+    }
 
   rtcb->task_state = TSTATE_TASK_INVALID;
   return ret;
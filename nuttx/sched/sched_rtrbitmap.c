@@ -0,0 +1,304 @@
+/************************************************************************
+ * sched/sched_rtrbitmap.c
+ *
+ *   Copyright (C) 2012 Gregory Nutt. All rights reserved.
+ *   Author: Gregory Nutt <gnutt@nuttx.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name NuttX nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ************************************************************************/
+
+/************************************************************************
+ * Included Files
+ ************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <queue.h>
+#include <assert.h>
+
+#include "os_internal.h"
+
+#ifdef CONFIG_SCHED_RTRBITMAP
+
+/************************************************************************
+ * Pre-processor Definitions
+ ************************************************************************/
+
+/* One bit for each priority, 32 priorities per word */
+
+#define RTR_NPRIORITIES  (SCHED_PRIORITY_MAX + 1)
+#define RTR_NWORDS       ((RTR_NPRIORITIES + 31) >> 5)
+
+#if RTR_NWORDS > 8
+#  error "The word summary in g_rtrwords is only 8 bits wide"
+#endif
+
+/************************************************************************
+ * Private Type Declarations
+ ************************************************************************/
+
+/************************************************************************
+ * Global Variables
+ ************************************************************************/
+
+/************************************************************************
+ * Private Variables
+ ************************************************************************/
+
+/* The g_readytorun list is still a single list in priority order.  Tasks
+ * of the same priority are kept together in FIFO order so that each
+ * priority has its own FIFO within the list.  g_rtrtail[] holds the last
+ * TCB of each priority FIFO (or NULL if no task of that priority is
+ * ready-to-run).
+ */
+
+static FAR _TCB *g_rtrtail[RTR_NPRIORITIES];
+
+/* g_rtrmap[] holds one bit for each priority with a non-empty FIFO and
+ * g_rtrwords holds one bit for each non-zero word of g_rtrmap[].
+ */
+
+static uint32_t g_rtrmap[RTR_NWORDS];
+static uint8_t  g_rtrwords;
+
+/* Used to find the least significant bit that is set in a word:  The
+ * product of the isolated bit and this de Bruijn sequence has a unique
+ * value in the top five bits for each bit position.
+ */
+
+static const uint8_t g_rtrlsb[32] =
+{
+   0,  1, 28,  2, 29, 14, 24,  3, 30, 22, 20, 15, 25, 17,  4,  8,
+  31, 27, 13, 23, 21, 19, 16,  7, 26, 12, 18,  6, 11,  5, 10,  9
+};
+
+/************************************************************************
+ * Private Functions
+ ************************************************************************/
+
+/************************************************************************
+ * Function: sched_rtrlsb
+ *
+ * Description:
+ *   Return the index of the least significant bit set in a non-zero
+ *   word.
+ *
+ ************************************************************************/
+
+static inline int sched_rtrlsb(uint32_t word)
+{
+  return g_rtrlsb[(uint32_t)((word & (~word + 1)) * 0x077cb531ul) >> 27];
+}
+
+/************************************************************************
+ * Function: sched_rtrhigher
+ *
+ * Description:
+ *   Return the lowest priority above 'priority' that has a ready-to-run
+ *   task, or -1 if there is none.  The new TCB of 'priority' must be
+ *   inserted just after the FIFO of that priority.
+ *
+ ************************************************************************/
+
+static int sched_rtrhigher(int priority)
+{
+  int      ndx = priority >> 5;
+  uint32_t bits;
+
+  /* Check for higher priorities in the same word */
+
+  bits = g_rtrmap[ndx] & ~((2u << (priority & 31)) - 1);
+  if (bits)
+    {
+      return (ndx << 5) + sched_rtrlsb(bits);
+    }
+
+  /* Then find the next non-zero word */
+
+  bits = g_rtrwords & ~((2u << ndx) - 1);
+  if (bits)
+    {
+      ndx = sched_rtrlsb(bits);
+      return (ndx << 5) + sched_rtrlsb(g_rtrmap[ndx]);
+    }
+
+  return -1;
+}
+
+/************************************************************************
+ * Public Functions
+ ************************************************************************/
+
+/************************************************************************
+ * Function: sched_rtrinsert
+ *
+ * Description:
+ *  This function adds a TCB to the g_readytorun list after all other
+ *  TCBs of the same or higher priority.  It is equivalent to
+ *  sched_addprioritized(tcb, &g_readytorun) but takes constant time.
+ *
+ * Inputs:
+ *   tcb - Points to the TCB to add to the g_readytorun list
+ *
+ * Return Value:
+ *   true if the head of the list has changed.
+ *
+ * Assumptions:
+ * - The caller has established a critical section before
+ *   calling this function.
+ * - The caller has already removed the input tcb from
+ *   whatever list it was in.
+ * - The caller must set the task_state field of the TCB.
+ *
+ ************************************************************************/
+
+bool sched_rtrinsert(FAR _TCB *tcb)
+{
+  uint8_t   priority = tcb->sched_priority;
+  FAR _TCB *prev;
+  FAR _TCB *next;
+  int       higher;
+
+  /* The TCB goes at the end of the FIFO for its priority.  If that FIFO
+   * is empty, it goes at the end of the nearest higher priority FIFO.
+   */
+
+  prev = g_rtrtail[priority];
+  if (!prev)
+    {
+      higher = sched_rtrhigher(priority);
+      if (higher >= 0)
+        {
+          prev = g_rtrtail[higher];
+        }
+
+      g_rtrmap[priority >> 5] |= (uint32_t)1 << (priority & 31);
+      g_rtrwords |= (uint8_t)(1 << (priority >> 5));
+    }
+
+  g_rtrtail[priority] = tcb;
+
+  if (prev)
+    {
+      /* Insert after prev */
+
+      next        = prev->flink;
+      tcb->flink  = next;
+      tcb->blink  = prev;
+      prev->flink = tcb;
+
+      if (next)
+        {
+          next->blink = tcb;
+        }
+      else
+        {
+          g_readytorun.tail = (FAR dq_entry_t*)tcb;
+        }
+
+      return false;
+    }
+  else
+    {
+      /* There is no ready-to-run task of the same or higher priority.
+       * Insert at the head of the list.
+       */
+
+      next       = (FAR _TCB*)g_readytorun.head;
+      tcb->flink = next;
+      tcb->blink = NULL;
+
+      if (next)
+        {
+          next->blink = tcb;
+        }
+      else
+        {
+          g_readytorun.tail = (FAR dq_entry_t*)tcb;
+        }
+
+      g_readytorun.head = (FAR dq_entry_t*)tcb;
+      return true;
+    }
+}
+
+/************************************************************************
+ * Function: sched_rtrremove
+ *
+ * Description:
+ *  This function removes a TCB from the g_readytorun list.
+ *
+ * Inputs:
+ *   tcb - Points to the TCB to remove from the g_readytorun list
+ *
+ * Return Value:
+ *   None
+ *
+ * Assumptions:
+ * - The caller has established a critical section before
+ *   calling this function.
+ * - The TCB is in the g_readytorun list and its priority has not been
+ *   changed since it was added.
+ *
+ ************************************************************************/
+
+void sched_rtrremove(FAR _TCB *tcb)
+{
+  uint8_t   priority = tcb->sched_priority;
+  FAR _TCB *prev     = tcb->blink;
+
+  /* If this is the last TCB of its priority, then the previous TCB
+   * becomes the last one -- unless it is of a different priority.  Then
+   * the FIFO for this priority becomes empty.
+   */
+
+  if (g_rtrtail[priority] == tcb)
+    {
+      if (prev && prev->sched_priority == priority)
+        {
+          g_rtrtail[priority] = prev;
+        }
+      else
+        {
+          g_rtrtail[priority] = NULL;
+
+          g_rtrmap[priority >> 5] &= ~((uint32_t)1 << (priority & 31));
+          if (!g_rtrmap[priority >> 5])
+            {
+              g_rtrwords &= ~(uint8_t)(1 << (priority >> 5));
+            }
+        }
+    }
+
+  dq_rem((FAR dq_entry_t*)tcb, (dq_queue_t*)&g_readytorun);
+}
+
+#endif /* CONFIG_SCHED_RTRBITMAP */
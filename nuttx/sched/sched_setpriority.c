@@ -40,6 +40,7 @@
 #include <nuttx/config.h>
 
 #include <stdint.h>
+#include <stdbool.h>
 #include <sched.h>
 #include <errno.h>
 #include <nuttx/arch.h>
@@ -106,6 +107,9 @@ int sched_setpriority(FAR _TCB *tcb, int sched_priority)
   FAR _TCB  *rtcb = (FAR _TCB*)g_readytorun.head;
   tstate_t   task_state;
   irqstate_t saved_state;
+#ifdef CONFIG_SCHED_RTRBITMAP
+  bool       head;
+#endif
 
   /* Verify that the requested priority is in the valid range */
 
@@ -149,9 +153,23 @@ int sched_setpriority(FAR _TCB *tcb, int sched_priority)
 
          else
            {
-             /* Change the task priority */
+             /* Change the task priority.  The task remains at the head
+              * of the g_readytorun list but, if the list is indexed by
+              * priority, it must be moved to the FIFO for its new
+              * priority.
+              */
+
+#ifdef CONFIG_SCHED_RTRBITMAP
+             sched_rtrremove(tcb);
+             tcb->sched_priority = (uint8_t)sched_priority;
+             head = sched_rtrinsert(tcb);
+
+             /* The task must still be at the head of g_readytorun */
 
+             ASSERT(head);
+#else
              tcb->sched_priority = (uint8_t)sched_priority;
+#endif
            }
          break;
 
@@ -143,7 +143,15 @@ int task_delete(pid_t pid)
   /* Remove the task from the OS's tasks lists. */
 
   saved_state = irqsave();
-  dq_rem((FAR dq_entry_t*)dtcb, (dq_queue_t*)g_tasklisttable[dtcb->task_state].list);
+  if (dtcb->task_state == TSTATE_TASK_READYTORUN)
+    {
+      sched_rtrremove(dtcb);
+    }
+  else
+    {
+      dq_rem((FAR dq_entry_t*)dtcb, (dq_queue_t*)g_tasklisttable[dtcb->task_state].list);
+    }
+
   dtcb->task_state = TSTATE_TASK_INVALID;
   irqrestore(saved_state);
 
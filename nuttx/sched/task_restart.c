@@ -138,7 +138,15 @@ int task_restart(pid_t pid)
         */
 
        state = irqsave();
-       dq_rem((FAR dq_entry_t*)tcb, (dq_queue_t*)g_tasklisttable[tcb->task_state].list);
+       if (tcb->task_state == TSTATE_TASK_READYTORUN)
+         {
+           sched_rtrremove(tcb);
+         }
+       else
+         {
+           dq_rem((FAR dq_entry_t*)tcb, (dq_queue_t*)g_tasklisttable[tcb->task_state].list);
+         }
+
        tcb->task_state = TSTATE_TASK_INVALID;
        irqrestore(state);
 
@@ -90,8 +90,10 @@
 
 int wd_cancel (WDOG_ID wdid)
 {
+#ifndef CONFIG_WDOG_TIMERWHEEL
   wdog_t    *curr;
   wdog_t    *prev;
+#endif
   irqstate_t saved_state;
   int        ret = ERROR;
 
@@ -105,6 +107,15 @@ int wd_cancel (WDOG_ID wdid)
 
   if (wdid && wdid->active)
     {
+#ifdef CONFIG_WDOG_TIMERWHEEL
+      /* The watchdog remembers the slot of the timing wheel that holds it
+       * so it can simply be removed from that slot.
+       */
+
+      dq_rem((FAR dq_entry_t*)wdid, &g_wdwheel[wdid->slot]);
+      wdid->next = NULL;
+      ret = OK;
+#else
       /* Search the g_wdactivelist for the target FCB.  We can't use sq_rem
        * to do this because there are additional operations that need to be
        * done.
@@ -129,6 +140,7 @@ int wd_cancel (WDOG_ID wdid)
         }
       else
         {
+#ifndef CONFIG_SCHED_TICKLESS
           /* If there is a watchdog in the timer queue after the one that
            * is being canceled, then it inherits the remaining ticks.
            */
@@ -137,6 +149,7 @@ int wd_cancel (WDOG_ID wdid)
             {
               curr->next->lag += curr->lag;
             }
+#endif
 
           /* Now, remove the watchdog from the timer queue */
 
@@ -147,6 +160,12 @@ int wd_cancel (WDOG_ID wdid)
           else
             {
               (void)sq_remfirst(&g_wdactivelist);
+
+              /* The interval timer was started for the watchdog at the
+               * head of the list and may now be able to expire later.
+               */
+
+              sched_timer_reassess();
             }
           wdid->next = NULL;
 
@@ -154,6 +173,7 @@ int wd_cancel (WDOG_ID wdid)
 
           ret = OK;
         }
+#endif
 
       /* Mark the watchdog inactive */
 
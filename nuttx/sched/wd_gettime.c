@@ -39,8 +39,11 @@
 
 #include <nuttx/config.h>
 
+#include <stdint.h>
 #include <wdog.h>
 
+#include <nuttx/clock.h>
+
 #include "os_internal.h"
 #include "wd_internal.h"
 
@@ -95,6 +98,21 @@ int wd_gettime(WDOG_ID wdog)
   flags = irqsave();
   if (wdog && wdog->active)
     {
+#ifdef CONFIG_SCHED_TICKLESS
+      /* The watchdog holds the absolute time of its expiration */
+
+      int32_t delay = (int32_t)(wdog->expiry - clock_systimer());
+
+      irqrestore(flags);
+      return delay > 0 ? delay : 0;
+#elif defined(CONFIG_WDOG_TIMERWHEEL)
+      /* The watchdog holds the tick count of its expiration */
+
+      int32_t delay = (int32_t)(wdog->expiry - g_wdtime);
+
+      irqrestore(flags);
+      return delay > 0 ? delay : 0;
+#else
       /* Traverse the watchdog list accumulating lag times until we find the wdog
        * that we are looking for
        */
@@ -111,6 +129,7 @@ int wd_gettime(WDOG_ID wdog)
               return delay;
             }
         }
+#endif
     }
 
   irqrestore(flags);
@@ -71,6 +71,14 @@ sq_queue_t g_wdfreelist;
 
 FAR wdog_t *g_wdpool;
 
+#ifdef CONFIG_WDOG_TIMERWHEEL
+/* g_wdwheel holds the active watchdogs in the slots of the timing
+ * wheel.  g_wdtime is the number of timer ticks processed so far.
+ */
+
+dq_queue_t g_wdwheel[WD_WHEEL_NSLOTS];
+uint32_t   g_wdtime;
+#else
 /* The g_wdactivelist data structure is a singly linked list
  * ordered by watchdog expiration time. When watchdog timers
  * expire,the functions on this linked list are removed and
@@ -78,6 +86,7 @@ FAR wdog_t *g_wdpool;
  */
 
 sq_queue_t g_wdactivelist;
+#endif
 
 /************************************************************************
  * Private Variables
@@ -112,6 +121,8 @@ sq_queue_t g_wdactivelist;
 
 void wd_initialize(void)
 {
+  int i;
+
   /* Initialize the free watchdog list */
 
   sq_init(&g_wdfreelist);
@@ -124,7 +135,6 @@ void wd_initialize(void)
   if (g_wdpool)
     {
       FAR wdog_t *wdog = g_wdpool;
-      int i;
 
       for (i = 0; i < CONFIG_PREALLOC_WDOGS; i++)
         {
@@ -132,7 +142,18 @@ void wd_initialize(void)
         }
     }
 
+#ifdef CONFIG_WDOG_TIMERWHEEL
+  /* The timing wheel must be reset at initialization time. */
+
+  for (i = 0; i < WD_WHEEL_NSLOTS; i++)
+    {
+      dq_init(&g_wdwheel[i]);
+    }
+
+  g_wdtime = 0;
+#else
   /* The g_wdactivelist queue must be reset at initialization time. */
 
   sq_init(&g_wdactivelist);
+#endif
 }
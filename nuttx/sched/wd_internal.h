@@ -44,6 +44,7 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <queue.h>
 #include <wdog.h>
 #include <nuttx/compiler.h>
 
@@ -51,6 +52,47 @@
  * Pre-processor Definitions
  ************************************************************************/
 
+/* Configuration ********************************************************/
+/* CONFIG_WDOG_TIMERWHEEL - Replace the sorted list of active watchdogs
+ *   with a hierarchical timing wheel.  Starting and cancelling a watchdog
+ *   then take constant time regardless of the number of active watchdogs.
+ */
+
+#if defined(CONFIG_WDOG_TIMERWHEEL) && defined(CONFIG_SCHED_TICKLESS)
+#  error "CONFIG_WDOG_TIMERWHEEL is not supported with CONFIG_SCHED_TICKLESS"
+#endif
+
+/* The timing wheel has WD_WHEEL_NLEVELS levels.  Level 0 holds one slot
+ * for each of the next WD_WHEEL_L0SIZE ticks.  Each slot of each higher
+ * level holds all of the watchdogs that expire within one complete turn
+ * of the level below it.  When a level wraps around, the watchdogs in the
+ * next slot of the level above are re-distributed into the lower levels.
+ * Watchdogs that expire beyond the range of the wheel are held in the
+ * last slot of the highest level and are re-distributed when they are
+ * reached.
+ */
+
+#ifdef CONFIG_WDOG_TIMERWHEEL
+#  define WD_WHEEL_NLEVELS    4
+#  define WD_WHEEL_L0BITS     6
+#  define WD_WHEEL_LNBITS     4
+#  define WD_WHEEL_L0SIZE     (1 << WD_WHEEL_L0BITS)
+#  define WD_WHEEL_LNSIZE     (1 << WD_WHEEL_LNBITS)
+#  define WD_WHEEL_L0MASK     (WD_WHEEL_L0SIZE - 1)
+#  define WD_WHEEL_LNMASK     (WD_WHEEL_LNSIZE - 1)
+#  define WD_WHEEL_NSLOTS     (WD_WHEEL_L0SIZE + \
+                               (WD_WHEEL_NLEVELS - 1) * WD_WHEEL_LNSIZE)
+
+/* The shift to get the slot index of level n (n > 0), the index of the
+ * first slot of level n in g_wdwheel[], and the number of ticks covered
+ * by levels 0 through n.
+ */
+
+#  define WD_WHEEL_SHIFT(n)   (WD_WHEEL_L0BITS + ((n) - 1) * WD_WHEEL_LNBITS)
+#  define WD_WHEEL_BASE(n)    (WD_WHEEL_L0SIZE + ((n) - 1) * WD_WHEEL_LNSIZE)
+#  define WD_WHEEL_RANGE(n)   (1ul << (WD_WHEEL_L0BITS + (n) * WD_WHEEL_LNBITS))
+#endif
+
 /************************************************************************
  * Public Type Declarations
  ************************************************************************/
@@ -62,13 +104,23 @@
 struct wdog_s
 {
   FAR struct wdog_s *next;       /* Support for singly linked lists. */
+#ifdef CONFIG_WDOG_TIMERWHEEL
+  FAR struct wdog_s *prev;       /* Support for doubly linked lists. */
+#endif
   wdentry_t          func;       /* Function to execute when delay expires */
 #ifdef CONFIG_PIC
   FAR void          *picbase;    /* PIC base address */
 #endif
+#if defined(CONFIG_SCHED_TICKLESS) || defined(CONFIG_WDOG_TIMERWHEEL)
+  uint32_t           expiry;     /* System time (ticks) when the delay expires */
+#else
   int                lag;        /* Timer associated with the delay */
+#endif
   bool               active;     /* true if the watchdog is actively timing */
   uint8_t            argc;       /* The number of parameters to pass */
+#ifdef CONFIG_WDOG_TIMERWHEEL
+  uint8_t            slot;       /* Index of the timing wheel slot */
+#endif
   uint32_t           parm[CONFIG_MAX_WDOGPARMS];
 };
 typedef struct wdog_s wdog_t;
@@ -94,10 +146,22 @@ extern FAR wdog_t *g_wdpool;
 /* The g_wdactivelist data structure is a singly linked list
  * ordered by watchdog expiration time. When watchdog timers
  * expire,the functions on this linked list are removed and
- * the function is called.
+ * the function is called.  Normally, each entry holds its delay
+ * relative to the preceding entry (its "lag");  in the tickless mode,
+ * each entry holds the absolute system time of its expiration.
  */
 
+#ifdef CONFIG_WDOG_TIMERWHEEL
+/* With CONFIG_WDOG_TIMERWHEEL, active watchdogs are instead held in the
+ * doubly linked lists of the timing wheel slots.  g_wdtime is the number
+ * of timer ticks processed by wd_timer().
+ */
+
+extern dq_queue_t g_wdwheel[WD_WHEEL_NSLOTS];
+extern uint32_t   g_wdtime;
+#else
 extern sq_queue_t g_wdactivelist;
+#endif
 
 /************************************************************************
  * Public Function Prototypes
@@ -112,6 +176,9 @@ extern "C" {
 
 EXTERN void weak_function wd_initialize(void);
 EXTERN void weak_function wd_timer(void);
+#ifdef CONFIG_SCHED_TICKLESS
+EXTERN bool wd_nextexpiry(FAR uint32_t *expiry);
+#endif
 
 #undef EXTERN
 #ifdef __cplusplus
@@ -48,6 +48,7 @@
 #include <errno.h>
 
 #include <nuttx/arch.h>
+#include <nuttx/clock.h>
 
 #include "os_internal.h"
 #include "wd_internal.h"
@@ -89,103 +90,238 @@ typedef void (*wdentry4_t)(int argc, uint32_t arg1, uint32_t arg2,
  ****************************************************************************/
 
 /****************************************************************************
- * Public Functions
- ****************************************************************************/
-
-/****************************************************************************
- * Function:  wd_start
+ * Function:  wd_expiration
  *
  * Description:
- *   This function adds a watchdog to the timer queue.  The 
- *   specified watchdog function will be called from the
- *   interrupt level after the specified number of ticks has
- *   elapsed. Watchdog timers may be started from the
- *   interrupt level.
- *
- *   Watchdog timers execute in the address enviroment that
- *   was in effect when wd_start() is called.
- *
- *   Watchdog timers execute only once.
- *
- *   To replace either the timeout delay or the function to
- *   be executed, call wd_start again with the same wdog; only
- *   the most recent wdStart() on a given watchdog ID has
- *   any effect.
+ *   Execute the function associated with a watchdog that has just been
+ *   removed from the head of the active list.
  *
  * Parameters:
- *   wdog     = watchdog ID
- *   delay    = Delay count in clock ticks
- *   wdentry  = function to call on timeout
- *   parm1..4 = parameters to pass to wdentry
+ *   wdog - The expired watchdog
  *
  * Return Value:
- *   OK or ERROR
+ *   None
  *
  * Assumptions:
- *   The watchdog routine runs in the context of the timer interrupt
- *   handler and is subject to all ISR restrictions.
+ *   Called from the timer interrupt handler (or, in the tickless mode, from
+ *   the interval timer expiration handler).
  *
  ****************************************************************************/
 
-int wd_start(WDOG_ID wdog, int delay, wdentry_t wdentry,  int argc, ...)
+static inline void wd_expiration(FAR wdog_t *wdog)
 {
-  va_list    ap;
-  FAR wdog_t *curr;
-  FAR wdog_t *prev;
-  FAR wdog_t *next;
-  int32_t    now;
-  irqstate_t saved_state;
-  int        i;
+  /* Indicate that the watchdog is no longer active. */
 
-  /* Verify the wdog */
+  wdog->active = false;
 
-  if (!wdog || argc > CONFIG_MAX_WDOGPARMS || delay < 0)
+  /* Execute the watchdog function */
+
+  up_setpicbase(wdog->picbase);
+  switch (wdog->argc)
     {
-      *get_errno_ptr() = EINVAL;
-      return ERROR;
+      default:
+#ifdef CONFIG_DEBUG
+        PANIC(OSERR_INTERNAL);
+#endif
+      case 0:
+        (*((wdentry0_t)(wdog->func)))(0);
+        break;
+
+#if CONFIG_MAX_WDOGPARMS > 0
+      case 1:
+        (*((wdentry1_t)(wdog->func)))(1, wdog->parm[0]);
+        break;
+#endif
+#if CONFIG_MAX_WDOGPARMS > 1
+      case 2:
+        (*((wdentry2_t)(wdog->func)))(2,
+                        wdog->parm[0], wdog->parm[1]);
+        break;
+#endif
+#if CONFIG_MAX_WDOGPARMS > 2
+      case 3:
+        (*((wdentry3_t)(wdog->func)))(3,
+                        wdog->parm[0], wdog->parm[1],
+                        wdog->parm[2]);
+        break;
+#endif
+#if CONFIG_MAX_WDOGPARMS > 3
+      case 4:
+        (*((wdentry4_t)(wdog->func)))(4,
+                        wdog->parm[0], wdog->parm[1],
+                        wdog->parm[2] ,wdog->parm[3]);
+        break;
+#endif
     }
+}
 
-  /* Check if the watchdog has been started. If so, stop it.
-   * NOTE:  There is a race condition here... the caller may receive
-   * the watchdog between the time that wd_start is called and
-   * the critical section is established.
-   */
+/****************************************************************************
+ * Function:  wd_wheeladd
+ *
+ * Description:
+ *   Add a watchdog to the slot of the timing wheel that corresponds to its
+ *   expiration time.  Watchdogs that expire within WD_WHEEL_L0SIZE ticks go
+ *   into the level 0 slot of that tick;  otherwise, the watchdog goes into
+ *   the lowest level whose range includes the expiration time.
+ *
+ * Parameters:
+ *   wdog - The watchdog to be added.  wdog->expiry must be valid.
+ *
+ * Return Value:
+ *   None
+ *
+ * Assumptions:
+ *   Interrupts are disabled.
+ *
+ ****************************************************************************/
 
-  saved_state = irqsave();
-  if (wdog->active)
+#ifdef CONFIG_WDOG_TIMERWHEEL
+static void wd_wheeladd(FAR wdog_t *wdog)
+{
+  uint32_t expiry = wdog->expiry;
+  uint32_t delay  = expiry - g_wdtime;
+  int      level;
+  int      ndx;
+
+  if (delay < WD_WHEEL_RANGE(0))
     {
-      wd_cancel(wdog);
+      ndx = expiry & WD_WHEEL_L0MASK;
     }
+  else
+    {
+      /* Find the lowest level that covers the delay */
 
-  /* Save the data in the watchdog structure */
+      for (level = 1;
+           level < WD_WHEEL_NLEVELS - 1 && delay >= WD_WHEEL_RANGE(level);
+           level++);
 
-  wdog->func = wdentry;         /* Function to execute when delay expires */
-  up_getpicbase(&wdog->picbase);
-  wdog->argc = argc;
+      /* If the delay is beyond the range of the wheel, hold the watchdog
+       * in the farthest slot.  It will be re-distributed from there.
+       */
 
-  va_start(ap, argc);
-  for (i = 0; i < argc; i++)
-    {
-      wdog->parm[i] = va_arg(ap, uint32_t);
+      if (delay >= WD_WHEEL_RANGE(WD_WHEEL_NLEVELS - 1))
+        {
+          expiry = g_wdtime + WD_WHEEL_RANGE(WD_WHEEL_NLEVELS - 1) - 1;
+        }
+
+      ndx = WD_WHEEL_BASE(level) +
+            ((expiry >> WD_WHEEL_SHIFT(level)) & WD_WHEEL_LNMASK);
     }
-#ifdef CONFIG_DEBUG
-  for (; i < CONFIG_MAX_WDOGPARMS; i++)
+
+  wdog->slot = (uint8_t)ndx;
+  dq_addlast((FAR dq_entry_t*)wdog, &g_wdwheel[ndx]);
+}
+#endif
+
+/****************************************************************************
+ * Function:  wd_cascade
+ *
+ * Description:
+ *   Re-distribute the watchdogs in one slot of a higher level of the timing
+ *   wheel into the lower levels.
+ *
+ * Parameters:
+ *   ndx - The index of the slot in g_wdwheel[]
+ *
+ * Return Value:
+ *   None
+ *
+ * Assumptions:
+ *   Called from the timer interrupt handler.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_WDOG_TIMERWHEEL
+static void wd_cascade(int ndx)
+{
+  FAR wdog_t *wdog;
+
+  while ((wdog = (FAR wdog_t*)dq_remfirst(&g_wdwheel[ndx])) != NULL)
     {
-      wdog->parm[i] = 0;
+      wd_wheeladd(wdog);
     }
+}
 #endif
-  va_end(ap);
 
-  /* Calculate delay+1, forcing the delay into a range that we can handle */
+/****************************************************************************
+ * Function:  wd_insert
+ *
+ * Description:
+ *   Insert a watchdog into the active list.  In the tickless mode, the list
+ *   is ordered by the absolute time of expiration;  otherwise, each entry
+ *   holds only the delay relative to the entry that precedes it.  With
+ *   CONFIG_WDOG_TIMERWHEEL, the watchdog is added to the timing wheel
+ *   instead.
+ *
+ * Parameters:
+ *   wdog  - The watchdog to be inserted
+ *   delay - Delay count in clock ticks (already adjusted to be > 0)
+ *
+ * Return Value:
+ *   None
+ *
+ * Assumptions:
+ *   Interrupts are disabled.
+ *
+ ****************************************************************************/
 
-  if (delay <= 0)
+#ifdef CONFIG_SCHED_TICKLESS
+static inline void wd_insert(FAR wdog_t *wdog, int delay)
+{
+  FAR wdog_t *curr;
+  FAR wdog_t *prev;
+
+  /* Get the absolute time when the watchdog will expire.  The interval
+   * timer is started relative to the current time so, unlike the periodic
+   * case, the partial tick in progress does not need to be accounted for.
+   */
+
+  wdog->expiry = clock_systimer() + (uint32_t)delay;
+
+  /* Find the first watchdog that expires after this one.  Watchdogs with
+   * the same expiration time will execute in the order they were started.
+   */
+
+  prev = NULL;
+  for (curr = (FAR wdog_t*)g_wdactivelist.head;
+       curr && (int32_t)(curr->expiry - wdog->expiry) <= 0;
+       curr = curr->next)
     {
-      delay = 1;
+      prev = curr;
     }
-  else if (++delay <= 0)
+
+  if (prev)
     {
-      delay--;
+      sq_addafter((FAR sq_entry_t*)prev, (FAR sq_entry_t*)wdog,
+                  &g_wdactivelist);
+    }
+  else
+    {
+      /* The new watchdog is at the head of the list.  The interval timer
+       * may need to be re-started to expire earlier.
+       */
+
+      sq_addfirst((FAR sq_entry_t*)wdog, &g_wdactivelist);
+      sched_timer_reassess();
     }
+}
+#elif defined(CONFIG_WDOG_TIMERWHEEL)
+static inline void wd_insert(FAR wdog_t *wdog, int delay)
+{
+  /* Get the tick count when the watchdog will expire and put it in the
+   * corresponding slot of the timing wheel.
+   */
+
+  wdog->expiry = g_wdtime + (uint32_t)delay;
+  wd_wheeladd(wdog);
+}
+#else
+static inline void wd_insert(FAR wdog_t *wdog, int delay)
+{
+  FAR wdog_t *curr;
+  FAR wdog_t *prev;
+  FAR wdog_t *next;
+  int32_t    now;
 
   /* Do the easy case first -- when the watchdog timer queue is empty. */
 
@@ -265,9 +401,115 @@ int wd_start(WDOG_ID wdog, int delay, wdentry_t wdentry,  int argc, ...)
         }
     }
 
-  /* Put the lag into the watchdog structure and mark it as active. */
+  /* Put the lag into the watchdog structure */
 
   wdog->lag = delay;
+}
+#endif
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Function:  wd_start
+ *
+ * Description:
+ *   This function adds a watchdog to the timer queue.  The 
+ *   specified watchdog function will be called from the
+ *   interrupt level after the specified number of ticks has
+ *   elapsed. Watchdog timers may be started from the
+ *   interrupt level.
+ *
+ *   Watchdog timers execute in the address enviroment that
+ *   was in effect when wd_start() is called.
+ *
+ *   Watchdog timers execute only once.
+ *
+ *   To replace either the timeout delay or the function to
+ *   be executed, call wd_start again with the same wdog; only
+ *   the most recent wdStart() on a given watchdog ID has
+ *   any effect.
+ *
+ * Parameters:
+ *   wdog     = watchdog ID
+ *   delay    = Delay count in clock ticks
+ *   wdentry  = function to call on timeout
+ *   parm1..4 = parameters to pass to wdentry
+ *
+ * Return Value:
+ *   OK or ERROR
+ *
+ * Assumptions:
+ *   The watchdog routine runs in the context of the timer interrupt
+ *   handler and is subject to all ISR restrictions.
+ *
+ ****************************************************************************/
+
+int wd_start(WDOG_ID wdog, int delay, wdentry_t wdentry,  int argc, ...)
+{
+  va_list    ap;
+  irqstate_t saved_state;
+  int        i;
+
+  /* Verify the wdog */
+
+  if (!wdog || argc > CONFIG_MAX_WDOGPARMS || delay < 0)
+    {
+      *get_errno_ptr() = EINVAL;
+      return ERROR;
+    }
+
+  /* Check if the watchdog has been started. If so, stop it.
+   * NOTE:  There is a race condition here... the caller may receive
+   * the watchdog between the time that wd_start is called and
+   * the critical section is established.
+   */
+
+  saved_state = irqsave();
+  if (wdog->active)
+    {
+      wd_cancel(wdog);
+    }
+
+  /* Save the data in the watchdog structure */
+
+  wdog->func = wdentry;         /* Function to execute when delay expires */
+  up_getpicbase(&wdog->picbase);
+  wdog->argc = argc;
+
+  va_start(ap, argc);
+  for (i = 0; i < argc; i++)
+    {
+      wdog->parm[i] = va_arg(ap, uint32_t);
+    }
+#ifdef CONFIG_DEBUG
+  for (; i < CONFIG_MAX_WDOGPARMS; i++)
+    {
+      wdog->parm[i] = 0;
+    }
+#endif
+  va_end(ap);
+
+  /* Calculate delay+1, forcing the delay into a range that we can handle.
+   * In the tickless mode, the delay is measured from the current time rather
+   * than from the last timer tick so the extra tick is not needed.
+   */
+
+  if (delay <= 0)
+    {
+      delay = 1;
+    }
+#ifndef CONFIG_SCHED_TICKLESS
+  else if (++delay <= 0)
+    {
+      delay--;
+    }
+#endif
+
+  /* Insert the watchdog into the timer queue and mark it as active. */
+
+  wd_insert(wdog, delay);
   wdog->active = true;
 
   irqrestore(saved_state);
@@ -282,6 +524,10 @@ int wd_start(WDOG_ID wdog, int delay, wdentry_t wdentry,  int argc, ...)
  *   if it is time to execute a watchdog function.  If so, the watchdog
  *   function will be executed in the context of the timer interrupt handler.
  *
+ *   In the tickless mode, this function is called when the interval timer
+ *   expires and will execute every watchdog whose expiration time has been
+ *   reached.
+ *
  * Parameters:
  *   None
  *
@@ -292,9 +538,65 @@ int wd_start(WDOG_ID wdog, int delay, wdentry_t wdentry,  int argc, ...)
  *
  ****************************************************************************/
 
+#ifdef CONFIG_SCHED_TICKLESS
+void wd_timer(void)
+{
+  FAR wdog_t *wdog;
+  uint32_t    now = clock_systimer();
+
+  /* Process the watchdog at the head of the list as well as any other
+   * watchdogs that became ready to run at this time.
+   */
+
+  while (g_wdactivelist.head &&
+         (int32_t)(((FAR wdog_t*)g_wdactivelist.head)->expiry - now) <= 0)
+    {
+      /* Remove the watchdog from the head of the list and execute it */
+
+      wdog = (FAR wdog_t*)sq_remfirst(&g_wdactivelist);
+      wd_expiration(wdog);
+    }
+}
+#elif defined(CONFIG_WDOG_TIMERWHEEL)
+void wd_timer(void)
+{
+  FAR wdog_t *wdog;
+  uint32_t    now = ++g_wdtime;
+  int         level;
+  int         ndx;
+
+  /* When level 0 wraps around, re-distribute the watchdogs in the next slot
+   * of level 1.  When that level also wraps around, do the same for the
+   * next slot of level 2, and so on.
+   */
+
+  if ((now & WD_WHEEL_L0MASK) == 0)
+    {
+      for (level = 1; level < WD_WHEEL_NLEVELS; level++)
+        {
+          ndx = (now >> WD_WHEEL_SHIFT(level)) & WD_WHEEL_LNMASK;
+          wd_cascade(WD_WHEEL_BASE(level) + ndx);
+          if (ndx != 0)
+            {
+              break;
+            }
+        }
+    }
+
+  /* Every watchdog in the level 0 slot for this tick has expired.  A
+   * watchdog restarted by one of the watchdog functions always expires
+   * on a later tick and so is added to a different slot.
+   */
+
+  ndx = now & WD_WHEEL_L0MASK;
+  while ((wdog = (FAR wdog_t*)dq_remfirst(&g_wdwheel[ndx])) != NULL)
+    {
+      wd_expiration(wdog);
+    }
+}
+#else
 void wd_timer(void)
 {
-  pid_t       pid;
   FAR wdog_t *wdog;
 
   /* Check if there are any active watchdogs to process */
@@ -329,56 +631,46 @@ void wd_timer(void)
                   ((FAR wdog_t*)g_wdactivelist.head)->lag += wdog->lag;
                 }
 
-              /* Indicate that the watchdog is no longer active. */
-
-              wdog->active = false;
-
-              /* Get the current task's process ID.  We'll need this later to
-               * see if the watchdog function caused a context switch.
-               */
-
-              pid = getpid();
-
               /* Execute the watchdog function */
 
-              up_setpicbase(wdog->picbase);
-              switch (wdog->argc)
-                {
-                  default:
-#ifdef CONFIG_DEBUG
-                    PANIC(OSERR_INTERNAL);
-#endif
-                  case 0:
-                    (*((wdentry0_t)(wdog->func)))(0);
-                    break;
-
-#if CONFIG_MAX_WDOGPARMS > 0
-                  case 1:
-                    (*((wdentry1_t)(wdog->func)))(1, wdog->parm[0]);
-                    break;
-#endif
-#if CONFIG_MAX_WDOGPARMS > 1
-                  case 2:
-                    (*((wdentry2_t)(wdog->func)))(2,
-                                    wdog->parm[0], wdog->parm[1]);
-                    break;
-#endif
-#if CONFIG_MAX_WDOGPARMS > 2
-                  case 3:
-                    (*((wdentry3_t)(wdog->func)))(3,
-                                    wdog->parm[0], wdog->parm[1],
-                                    wdog->parm[2]);
-                    break;
-#endif
-#if CONFIG_MAX_WDOGPARMS > 3
-                  case 4:
-                    (*((wdentry4_t)(wdog->func)))(4,
-                                    wdog->parm[0], wdog->parm[1],
-                                    wdog->parm[2] ,wdog->parm[3]);
-                    break;
-#endif
-                }
+              wd_expiration(wdog);
             }
         }
     }
 }
+#endif
+
+/****************************************************************************
+ * Function:  wd_nextexpiry
+ *
+ * Description:
+ *   Return the system time (in ticks) when the watchdog at the head of the
+ *   active list will expire.  This is used in the tickless mode to determine
+ *   when the interval timer must next expire.
+ *
+ * Parameters:
+ *   expiry - Location to return the expiration time
+ *
+ * Return Value:
+ *   true if there is an active watchdog;  false if the active list is empty
+ *   and the returned expiration time is not valid.
+ *
+ * Assumptions:
+ *   Interrupts are disabled.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_SCHED_TICKLESS
+bool wd_nextexpiry(FAR uint32_t *expiry)
+{
+  FAR wdog_t *wdog = (FAR wdog_t*)g_wdactivelist.head;
+
+  if (wdog)
+    {
+      *expiry = wdog->expiry;
+      return true;
+    }
+
+  return false;
+}
+#endif
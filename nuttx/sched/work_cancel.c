@@ -83,6 +83,7 @@
  *   again.
  *
  * Input parameters:
+ *   qid    - The work queue ID (must be the same as passed to work_queue())
  *   work   - The previously queue work structure to cancel
  *
  * Returned Value:
@@ -90,11 +91,12 @@
  *
  ****************************************************************************/
 
-int work_cancel(struct work_s *work)
+int work_cancel(int qid, FAR struct work_s *work)
 {
+  FAR struct wqueue_s *wqueue = &g_work[qid];
   irqstate_t flags;
 
-  DEBUGASSERT(work != NULL);
+  DEBUGASSERT(work != NULL && (unsigned)qid < NWORKERS);
 
   /* Cancelling the work is simply a matter of removing the work structure
    * from the work queue.  This must be done with interrupts disabled because
@@ -104,9 +106,9 @@ int work_cancel(struct work_s *work)
   flags = irqsave();
   if (work->worker != NULL)
     {
-      DEBUGASSERT(work->dq.flink || (FAR dq_entry_t *)work == g_work.head);
-      DEBUGASSERT(work->dq.blink || (FAR dq_entry_t *)work == g_work.tail);
-      dq_rem((FAR dq_entry_t *)work, &g_work);
+      DEBUGASSERT(work->dq.flink || (FAR dq_entry_t *)work == wqueue->q.tail);
+      DEBUGASSERT(work->dq.blink || (FAR dq_entry_t *)work == wqueue->q.head);
+      dq_rem((FAR dq_entry_t *)work, &wqueue->q);
 
       work->worker = NULL;
     }
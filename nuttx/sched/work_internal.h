@@ -43,6 +43,8 @@
 #include <nuttx/config.h>
 #include <queue.h>
 
+#include <nuttx/wqueue.h>
+
 #ifdef CONFIG_SCHED_WORKQUEUE
 
 /****************************************************************************
@@ -63,6 +65,24 @@
 #  define CONFIG_SCHED_WORKSTACKSIZE CONFIG_IDLETHREAD_STACKSIZE
 #endif
 
+#ifdef CONFIG_SCHED_LPWORK
+#  ifndef CONFIG_SCHED_LPWORKPRIORITY
+#    define CONFIG_SCHED_LPWORKPRIORITY 20
+#  endif
+
+#  ifndef CONFIG_SCHED_LPWORKPERIOD
+#    define CONFIG_SCHED_LPWORKPERIOD (50*1000) /* 50 milliseconds */
+#  endif
+
+#  ifndef CONFIG_SCHED_LPWORKSTACKSIZE
+#    define CONFIG_SCHED_LPWORKSTACKSIZE CONFIG_IDLETHREAD_STACKSIZE
+#  endif
+
+#  if CONFIG_SCHED_LPWORKPRIORITY >= CONFIG_SCHED_WORKPRIORITY
+#    warning "The low priority worker should run below CONFIG_SCHED_WORKPRIORITY"
+#  endif
+#endif
+
 #ifdef CONFIG_DISABLE_SIGNALS
 #  warning "Worker thread support requires signals"
 #endif
@@ -77,25 +97,19 @@
  * Public Data
  ****************************************************************************/
 
-/* The queue of pending work */
-
-extern struct dq_queue_s g_work;
-
-/* The task ID of the worker thread */
-
-extern pid_t g_worker;
-
 /****************************************************************************
  * Public Function Prototypes
  ****************************************************************************/
 
 /****************************************************************************
- * Name: work_thread
+ * Name: work_hpthread and work_lpthread
  *
  * Description:
- *   This is the main worker thread that performs actions placed on the work
- *   queue.  It also performs periodic garbage collection (that is performed
- *   by the idle thread if CONFIG_SCHED_WORKQUEUE is not defined).
+ *   These are the worker threads that perform actions placed on the high
+ *   and low priority work queues.  The low priority thread (or the high
+ *   priority thread if CONFIG_SCHED_LPWORK is not selected) also performs
+ *   garbage collection (that is performed by the idle thread if
+ *   CONFIG_SCHED_WORKQUEUE is not defined).
  *
  * Input parameters:
  *   argc, argv (not used)
@@ -105,7 +119,10 @@ extern pid_t g_worker;
  *
  ****************************************************************************/
 
-extern int work_thread(int argc, char *argv[]);
+extern int work_hpthread(int argc, char *argv[]);
+#ifdef CONFIG_SCHED_LPWORK
+extern int work_lpthread(int argc, char *argv[]);
+#endif
 
 #endif /* __ASSEMBLY__ */
 #endif /* CONFIG_SCHED_WORKQUEUE */
@@ -90,7 +90,12 @@
  *   from the queue, or (2) work_cancel() has been called to cancel the work
  *   and remove it from the work queue.
  *
+ *   Work is kept in order of its deadline:  Work with a zero delay will be
+ *   performed as soon as the worker thread runs; the worker thread sleeps
+ *   only until the deadline of the earliest delayed work.
+ *
  * Input parameters:
+ *   qid    - The work queue ID (HPWORK or LPWORK)
  *   work   - The work structure to queue
  *   worker - The worker callback to be invoked.  The callback will invoked
  *            on the worker thread of execution.
@@ -104,11 +109,16 @@
  *
  ****************************************************************************/
 
-int work_queue(struct work_s *work, worker_t worker, FAR void *arg, uint32_t delay)
+int work_queue(int qid, FAR struct work_s *work, worker_t worker,
+               FAR void *arg, uint32_t delay)
 {
+  FAR struct wqueue_s *wqueue = &g_work[qid];
+  FAR struct work_s *next;
   irqstate_t flags;
+  uint32_t now;
+  uint32_t elapsed;
 
-  DEBUGASSERT(work != NULL);
+  DEBUGASSERT(work != NULL && (unsigned)qid < NWORKERS);
 
   /* First, initialize the work structure */
 
@@ -122,9 +132,44 @@ int work_queue(struct work_s *work, worker_t worker, FAR void *arg, uint32_t del
    */
 
   flags        = irqsave();
-  work->qtime  = clock_systimer(); /* Time work queued */
-  dq_addlast((FAR dq_entry_t *)work, &g_work);
-  work_signal();                   /* Wake up the worker thread */
+  now          = clock_systimer();
+  work->qtime  = now;              /* Time work queued */
+
+  /* The work queue is ordered by deadline.  Find the first queued work that
+   * will become ready after this work (work with the same deadline stays in
+   * FIFO order).
+   */
+
+  for (next = (FAR struct work_s *)wqueue->q.head;
+       next;
+       next = (FAR struct work_s *)next->dq.flink)
+    {
+      elapsed = now - next->qtime;
+      if (elapsed < next->delay && next->delay - elapsed > delay)
+        {
+          break;
+        }
+    }
+
+  if (next)
+    {
+      dq_addbefore((FAR dq_entry_t *)next, (FAR dq_entry_t *)work, &wqueue->q);
+    }
+  else
+    {
+      dq_addlast((FAR dq_entry_t *)work, &wqueue->q);
+    }
+
+  /* Wake up the worker thread only if the new work is now at the head of
+   * the queue.  Otherwise, the worker is already scheduled to wake up
+   * before this work becomes ready.
+   */
+
+  if (wqueue->q.head == (FAR dq_entry_t *)work)
+    {
+      work_signal(qid);
+    }
+
   irqrestore(flags);
   return OK;
 }
@@ -67,15 +67,9 @@
  * Public Variables
  ****************************************************************************/
 
-/* The queue of pending work */
+/* The state of each work queue */
 
-struct dq_queue_s g_work;
-
-/* The task ID of the worker thread */
-
-#ifdef CONFIG_SCHED_WORKQUEUE
-pid_t g_worker;
-#endif
+struct wqueue_s g_work[NWORKERS];
 
 /****************************************************************************
  * Private Variables
@@ -86,130 +80,186 @@ pid_t g_worker;
  ****************************************************************************/
 
 /****************************************************************************
- * Public Functions
- ****************************************************************************/
-/****************************************************************************
- * Name: work_thread
+ * Name: work_process
  *
  * Description:
- *   This is the main worker thread that performs actions placed on the work
- *   list.  It also performs periodic garbage collection (that is performed
- *   by the idle thread if CONFIG_SCHED_WORKQUEUE is not defined).
+ *   Perform all of the ready work on one work queue, then wait until either
+ *   the next queued work becomes ready, the work queue is signalled, or the
+ *   poll period elapses.
+ *
+ *   The work queue is kept in order of increasing deadline so only the work
+ *   at the head of the queue needs to be examined.  Interrupts are disabled
+ *   only while the head of the queue is examined and removed, not while
+ *   the work is performed.
  *
  * Input parameters:
- *   argc, argv (not used)
+ *   wqueue - Describes the work queue to be processed
+ *   period - The maximum time to wait (in microseconds)
  *
  * Returned Value:
- *   Does not return
+ *   None
  *
  ****************************************************************************/
 
-int work_thread(int argc, char *argv[])
+static void work_process(FAR struct wqueue_s *wqueue, uint32_t period)
 {
   volatile FAR struct work_s *work;
   worker_t  worker;
   FAR void *arg;
   uint32_t elapsed;
-  uint32_t remaining;
   uint32_t next;
-  int usec;
   irqstate_t flags;
 
-  /* Loop forever */
+  /* Process queued work.  We need to keep interrupts disabled while we
+   * examine and modify the work list.
+   */
 
-  usec = CONFIG_SCHED_WORKPERIOD;
+  next  = period / USEC_PER_TICK;
   flags = irqsave();
-  for (;;)
+  work  = (FAR struct work_s *)wqueue->q.head;
+  while (work)
     {
-      /* Wait awhile to check the work list.  We will wait here until either
-       * the time elapses or until we are awakened by a signal.
+      /* Is this work ready?  It is ready if there is no delay or if
+       * the delay has elapsed. qtime is the time that the work was added
+       * to the work queue.  It will always be greater than or equal to
+       * zero.  Therefore a delay of zero will always execute immediately.
        */
 
-      usleep(usec);
-      irqrestore(flags);
+      elapsed = clock_systimer() - work->qtime;
+      if (elapsed < work->delay)
+        {
+          /* No.. Since the queue is ordered by deadline, nothing else in
+           * the queue is ready either.  Wait until this work is ready (or
+           * until the end of the poll period, whichever is sooner).
+           */
 
-      /* First, perform garbage collection.  This cleans-up memory de-allocations
-       * that were queued because they could not be freed in that execution
-       * context (for example, if the memory was freed from an interrupt handler).
-       * NOTE: If the work thread is disabled, this clean-up is performed by
-       * the IDLE thread (at a very, very lower priority).
+          if (work->delay - elapsed < next)
+            {
+              next = work->delay - elapsed;
+            }
+          break;
+        }
+
+      /* Remove the ready-to-execute work from the list */
+
+      (void)dq_remfirst(&wqueue->q);
+
+#ifdef CONFIG_SCHED_WORKSTATS
+      /* Accumulate the time that the work waited after it became ready */
+
+      elapsed -= work->delay;
+      wqueue->stats.nworks++;
+      wqueue->stats.totlatency += elapsed;
+      if (elapsed > wqueue->stats.maxlatency)
+        {
+          wqueue->stats.maxlatency = elapsed;
+        }
+#endif
+
+      /* Extract the work description from the entry (in case the work
+       * instance by the re-used after it has been de-queued).
        */
 
-      sched_garbagecollection();
+      worker = work->worker;
+      arg    = work->arg;
 
-      /* Then process queued work.  We need to keep interrupts disabled while
-       * we process items in the work list.
+      /* Mark the work as no longer being queued */
+
+      work->worker = NULL;
+
+      /* Do the work.  Re-enable interrupts while the work is being
+       * performed... we don't have any idea how long that will take!
+       */
+
+      irqrestore(flags);
+      worker(arg);
+
+      /* Now, since we re-enabled interrupts we don't know the state of the
+       * work list and we will have to start back at the head of the list.
        */
 
-      next  = CONFIG_SCHED_WORKPERIOD / USEC_PER_TICK;
       flags = irqsave();
-      work  = (FAR struct work_s *)g_work.head;
-      while (work)
-        {
-          /* Is this work ready?  It is ready if there is no delay or if
-           * the delay has elapsed. qtime is the time that the work was added
-           * to the work queue.  It will always be greater than or equal to
-           * zero.  Therefore a delay of zero will always execute immediately.
-           */
+      work  = (FAR struct work_s *)wqueue->q.head;
+    }
 
-          elapsed = clock_systimer() - work->qtime;
-          if (elapsed >= work->delay)
-            {
-              /* Remove the ready-to-execute work from the list */
+  /* Wait awhile to check the work list.  We will wait here until either
+   * the time elapses or until we are awakened by a signal.  Interrupts
+   * remain disabled until we sleep so that the signal sent by work_queue()
+   * cannot be lost.
+   */
 
-              (void)dq_rem((struct dq_entry_s *)work, &g_work);
+  usleep(next * USEC_PER_TICK);
+  irqrestore(flags);
+}
 
-              /* Extract the work description from the entry (in case the work
-               * instance by the re-used after it has been de-queued).
-               */
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
 
-              worker = work->worker;
-              arg    = work->arg;
+/****************************************************************************
+ * Name: work_hpthread and work_lpthread
+ *
+ * Description:
+ *   These are the worker threads that perform actions placed on the high
+ *   and low priority work queues.  The low priority thread (or the high
+ *   priority thread if CONFIG_SCHED_LPWORK is not selected) also performs
+ *   garbage collection (that is performed by the idle thread if
+ *   CONFIG_SCHED_WORKQUEUE is not defined).
+ *
+ * Input parameters:
+ *   argc, argv (not used)
+ *
+ * Returned Value:
+ *   Does not return
+ *
+ ****************************************************************************/
 
-              /* Mark the work as no longer being queued */
+int work_hpthread(int argc, char *argv[])
+{
+  /* Loop forever */
 
-              work->worker = NULL;
+  for (;;)
+    {
+#ifndef CONFIG_SCHED_LPWORK
+      /* First, perform garbage collection.  This cleans-up memory de-allocations
+       * that were queued because they could not be freed in that execution
+       * context (for example, if the memory was freed from an interrupt handler).
+       * NOTE: If the work thread is disabled, this clean-up is performed by
+       * the IDLE thread (at a very, very lower priority).
+       */
 
-              /* Do the work.  Re-enable interrupts while the work is being
-               * performed... we don't have any idea how long that will take!
-               */
+      sched_garbagecollection();
+#endif
 
-              irqrestore(flags);
-              worker(arg);
+      /* Then process queued work */
 
-              /* Now, unfortunately, since we re-enabled interrupts we don't
-               * know the state of the work list and we will have to start
-               * back at the head of the list.
-               */
+      work_process(&g_work[HPWORK], CONFIG_SCHED_WORKPERIOD);
+    }
 
-              flags = irqsave();
-              work  = (FAR struct work_s *)g_work.head;
-            }
-          else
-            {
-              /* This one is not ready.. will it be ready before the next
-               * scheduled wakeup interval?
-               */
+  return OK; /* To keep some compilers happy */
+}
 
-              remaining = elapsed - work->delay;
-              if (remaining < next)
-                {
-                  /* Yes.. Then schedule to wake up when the work is ready */
+#ifdef CONFIG_SCHED_LPWORK
+int work_lpthread(int argc, char *argv[])
+{
+  /* Loop forever */
 
-                  next = remaining;
-                }
-              
-              /* Then try the next in the list. */
+  for (;;)
+    {
+      /* First, perform garbage collection.  This is done here, rather than
+       * on the high priority thread, so that it never delays the device
+       * driver bottom halves.
+       */
 
-              work = (FAR struct work_s *)work->dq.flink;
-            }
-        }
+      sched_garbagecollection();
 
-      /* Now calculate the microsecond delay we should wait */
+      /* Then process queued work */
 
-      usec = next * USEC_PER_TICK;
+      work_process(&g_work[LPWORK], CONFIG_SCHED_LPWORKPERIOD);
     }
 
   return OK; /* To keep some compilers happy */
 }
+#endif /* CONFIG_SCHED_LPWORK */
+
 #endif /* CONFIG_SCHED_WORKQUEUE */
@@ -0,0 +1,271 @@
+/****************************************************************************
+ * tools/heapsum.c
+ *
+ *   Copyright (C) 2012 Gregory Nutt. All rights reserved.
+ *   Author: Gregory Nutt <gnutt@nuttx.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name NuttX nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <getopt.h>
+
+/****************************************************************************
+ * Definitions
+ ****************************************************************************/
+
+#define LINESIZE     256
+#define MAX_TASKS    256
+#define MAX_CALLERS  4096
+#define MAX_BINS     32
+#define DEFAULT_TOP  20
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+/* Totals for one task or one caller */
+
+struct total_s
+{
+  unsigned long key;     /* Task ID or caller address */
+  unsigned long nchunks; /* Number of allocations */
+  unsigned long nbytes;  /* Size of the allocations */
+};
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static struct total_s g_tasks[MAX_TASKS];
+static struct total_s g_callers[MAX_CALLERS];
+static struct total_s g_bins[MAX_BINS];
+static int g_ntasks;
+static int g_ncallers;
+static char g_line[LINESIZE+1];
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+static void show_usage(const char *progname)
+{
+  fprintf(stderr, "USAGE: %s [-n <count>] [<dump file>]\n\n", progname);
+  fprintf(stderr, "Where:\n\n");
+  fprintf(stderr, "\t<dump file>: The output of the NSH 'heap -a' command.\n");
+  fprintf(stderr, "\t\tThe dump is read from stdin if no file is given.\n");
+  fprintf(stderr, "\t-n <count>: Show the <count> callers that allocated\n");
+  fprintf(stderr, "\t\tthe most memory (default %d).\n", DEFAULT_TOP);
+  exit(EXIT_FAILURE);
+}
+
+static void add_total(struct total_s *table, int *nentries, int maxentries,
+                      unsigned long key, unsigned long size)
+{
+  int i;
+
+  for (i = 0; i < *nentries && table[i].key != key; i++);
+
+  if (i == *nentries)
+    {
+      if (i >= maxentries)
+        {
+          fprintf(stderr, "Too many different tasks or callers\n");
+          exit(EXIT_FAILURE);
+        }
+
+      table[i].key = key;
+      (*nentries)++;
+    }
+
+  table[i].nchunks++;
+  table[i].nbytes += size;
+}
+
+static int compare_bytes(const void *a, const void *b)
+{
+  const struct total_s *ta = (const struct total_s *)a;
+  const struct total_s *tb = (const struct total_s *)b;
+
+  if (ta->nbytes != tb->nbytes)
+    {
+      return ta->nbytes < tb->nbytes ? 1 : -1;
+    }
+
+  return ta->key < tb->key ? -1 : ta->key > tb->key;
+}
+
+static int compare_key(const void *a, const void *b)
+{
+  const struct total_s *ta = (const struct total_s *)a;
+  const struct total_s *tb = (const struct total_s *)b;
+
+  return (long)ta->key < (long)tb->key ? -1 : (long)ta->key > (long)tb->key;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+int main(int argc, char **argv)
+{
+  FILE *stream = stdin;
+  unsigned long nchunks = 0;
+  unsigned long nbytes  = 0;
+  unsigned long addr;
+  unsigned long size;
+  unsigned long caller;
+  int top = DEFAULT_TOP;
+  int pid;
+  int bin;
+  int ch;
+  int i;
+
+  while ((ch = getopt(argc, argv, ":n:")) > 0)
+    {
+      switch (ch)
+        {
+          case 'n' :
+            top = atoi(optarg);
+            if (top <= 0)
+              {
+                fprintf(stderr, "Invalid count: %s\n", optarg);
+                show_usage(argv[0]);
+              }
+            break;
+
+          case '?' :
+            fprintf(stderr, "Unrecognized option: %c\n", optopt);
+            show_usage(argv[0]);
+            break;
+
+          case ':' :
+            fprintf(stderr, "Missing option argument, option: %c\n", optopt);
+            show_usage(argv[0]);
+            break;
+        }
+    }
+
+  if (optind < argc - 1)
+    {
+      fprintf(stderr, "Too many arguments\n");
+      show_usage(argv[0]);
+    }
+
+  if (optind == argc - 1)
+    {
+      stream = fopen(argv[optind], "r");
+      if (!stream)
+        {
+          fprintf(stderr, "open %s failed\n", argv[optind]);
+          exit(EXIT_FAILURE);
+        }
+    }
+
+  /* Each allocation in the dump is one line:  "<pid> <addr> <size> <caller>".
+   * Anything else (headers, the NSH prompt, ...) is ignored.
+   */
+
+  while (fgets(g_line, LINESIZE, stream))
+    {
+      if (sscanf(g_line, "%d %lx %lu %lx", &pid, &addr, &size, &caller) != 4)
+        {
+          continue;
+        }
+
+      add_total(g_tasks, &g_ntasks, MAX_TASKS, (unsigned long)pid, size);
+      add_total(g_callers, &g_ncallers, MAX_CALLERS, caller, size);
+
+      for (bin = 0; bin < MAX_BINS - 1 && (size >> (bin + 1)) != 0; bin++);
+      g_bins[bin].nchunks++;
+      g_bins[bin].nbytes += size;
+
+      nchunks++;
+      nbytes += size;
+    }
+
+  if (stream != stdin)
+    {
+      fclose(stream);
+    }
+
+  if (nchunks == 0)
+    {
+      fprintf(stderr, "No allocations found\n");
+      exit(EXIT_FAILURE);
+    }
+
+  /* Totals for each task */
+
+  qsort(g_tasks, g_ntasks, sizeof(struct total_s), compare_key);
+  printf("Allocations by task:\n\n");
+  printf("    PID     Chunks        Bytes      %%\n");
+  for (i = 0; i < g_ntasks; i++)
+    {
+      printf("%7ld %10lu %12lu %6.1f\n",
+             (long)g_tasks[i].key, g_tasks[i].nchunks, g_tasks[i].nbytes,
+             100.0 * g_tasks[i].nbytes / nbytes);
+    }
+
+  printf("  Total %10lu %12lu\n", nchunks, nbytes);
+
+  /* The callers that allocated the most memory */
+
+  qsort(g_callers, g_ncallers, sizeof(struct total_s), compare_bytes);
+  printf("\nTop callers (use addr2line to find the source lines):\n\n");
+  printf("    Caller     Chunks        Bytes      %%\n");
+  for (i = 0; i < g_ncallers && i < top; i++)
+    {
+      printf("0x%08lx %10lu %12lu %6.1f\n",
+             g_callers[i].key, g_callers[i].nchunks, g_callers[i].nbytes,
+             100.0 * g_callers[i].nbytes / nbytes);
+    }
+
+  /* Distribution of the allocation sizes */
+
+  printf("\nAllocation sizes:\n\n");
+  printf("      Size     Chunks        Bytes\n");
+  for (bin = 0; bin < MAX_BINS; bin++)
+    {
+      if (g_bins[bin].nchunks > 0)
+        {
+          printf("%9lu+ %10lu %12lu\n",
+                 1ul << bin, g_bins[bin].nchunks, g_bins[bin].nbytes);
+        }
+    }
+
+  return 0;
+}